@@ -245,6 +245,7 @@ final class AppState: ObservableObject {
 
         do {
             let preferences = preferencesStore.preferences
+            startStreamingTranscription()
             try audioCaptureService.startCapture(deviceUID: preferences.selectedAudioInputDeviceUID)
 
             status = .recording
@@ -257,6 +258,7 @@ final class AppState: ObservableObject {
             Logger.shared.info("Recording started")
         } catch {
             Logger.shared.error("Failed to start recording", error: error)
+            await stopStreamingTranscription()
             status = .error("Failed to start recording")
             soundPlayer.playEvent(.error, preferences: preferencesStore.preferences)
         }
@@ -270,6 +272,9 @@ final class AppState: ObservableObject {
             let audioData = try audioCaptureService.stopCapture()
             isRecording = false
 
+            // Only the audio after the last streaming step is left to decode
+            let streamedResult = await stopStreamingTranscription()
+
             // Play stop sound
             let preferences = preferencesStore.preferences
             soundPlayer.playEvent(.recordingStop, preferences: preferences)
@@ -286,7 +291,12 @@ final class AppState: ObservableObject {
 
             // Transcribe
             status = .transcribing
-            let transcriptionResult = try await transcribe(audioData: audioData)
+            let transcriptionResult: TranscriptionResult
+            if let streamedResult = streamedResult, !streamedResult.text.isEmpty {
+                transcriptionResult = streamedResult
+            } else {
+                transcriptionResult = try await transcribe(audioData: audioData)
+            }
 
             // Check if transcription result is empty or just whitespace
             guard !transcriptionResult.text.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty else {
@@ -297,7 +307,7 @@ final class AppState: ObservableObject {
 
             // Enhance
             status = .enhancing
-            let enhancedText = try await enhance(text: transcriptionResult.text)
+            let enhancedText = try await enhance(text: transcriptionResult.text, confidence: transcriptionResult.confidence)
 
             // Paste
             status = .pasting
@@ -314,6 +324,7 @@ final class AppState: ObservableObject {
 
         } catch {
             Logger.shared.error("Workflow failed", error: error)
+            await stopStreamingTranscription()
             status = .error(error.localizedDescription)
             isRecording = false
 
@@ -328,6 +339,31 @@ final class AppState: ObservableObject {
         }
     }
 
+    /// Decode while recording so only the last step remains after the hotkey is released
+    private func startStreamingTranscription() {
+        guard whisperService.isModelLoaded, !isLoadingModel else { return }
+
+        do {
+            try whisperService.beginStreaming { [weak self] partial in
+                Task { @MainActor in
+                    self?.currentTranscription = partial
+                }
+            }
+            let service = whisperService
+            audioCaptureService.sampleHandler = { samples in
+                service.pushStreaming(samples)
+            }
+        } catch {
+            Logger.shared.warning("Streaming transcription unavailable: \(error.localizedDescription)")
+        }
+    }
+
+    @discardableResult
+    private func stopStreamingTranscription() async -> TranscriptionResult? {
+        audioCaptureService.sampleHandler = nil
+        return await whisperService.endStreaming()
+    }
+
     private func transcribe(audioData: Data) async throws -> TranscriptionResult {
         Logger.shared.info("Starting transcription")
 
@@ -384,7 +420,7 @@ final class AppState: ObservableObject {
         }
     }
 
-    private func enhance(text: String) async throws -> String {
+    private func enhance(text: String, confidence: TranscriptionConfidence?) async throws -> String {
         Logger.shared.info("Starting enhancement")
 
         // Detect document context
@@ -404,7 +440,8 @@ final class AppState: ObservableObject {
         let enhancedResult = try await textEnhancementService.enhance(
             text: text,
             documentType: context.documentType,
-            useCloud: preferences.externalLLMEnabled
+            useCloud: preferences.externalLLMEnabled,
+            confidence: confidence
         )
 
         Logger.shared.info("Enhancement completed, applied \(enhancedResult.appliedRules.count) rules")
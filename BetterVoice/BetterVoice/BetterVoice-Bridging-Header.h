@@ -11,4 +11,7 @@
 // Import C wrapper for whisper.cpp
 #import "WhisperBridge.h"
 
+// Import C wrapper for the llama runtime (local text enhancement)
+#import "LlamaBridge.h"
+
 #endif /* BetterVoice_Bridging_Header_h */
@@ -0,0 +1,326 @@
+//
+//  LlamaBridge.cpp
+//  BetterVoice
+//
+//  C++ implementation of the llama bridge
+//
+
+#include "LlamaBridge.h"
+#include "../whisper.cpp/examples/talk-llama/llama.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct llama_bridge_context {
+    llama_model* model = nullptr;
+    llama_context* ctx = nullptr;
+    llama_sampler* smpl = nullptr;
+
+    llama_bridge_params params;
+    std::string system_prompt;
+    const char* tmpl = nullptr; // chat template of the model, NULL if it has none
+
+    // Tokens in the KV cache of sequence 0: the previous prompt and its output
+    std::vector<llama_token> cached;
+
+    llama_bridge_stats stats = {};
+
+    std::mutex mutex;
+};
+
+namespace {
+
+// Number of performance cores - the E-cores only slow down the matmuls of the prompt
+int performance_core_count() {
+#ifdef __APPLE__
+    int n_cores = 0;
+    size_t size = sizeof(n_cores);
+    if (sysctlbyname("hw.perflevel0.physicalcpu", &n_cores, &size, nullptr, 0) == 0 && n_cores > 0) {
+        return n_cores;
+    }
+#endif
+    return std::max(1, (int) std::thread::hardware_concurrency());
+}
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+char* copy_c_string(const std::string& str) {
+    char* out = (char*)malloc(str.size() + 1);
+    if (out) {
+        memcpy(out, str.c_str(), str.size() + 1);
+    }
+    return out;
+}
+
+// The system prompt and the text in the chat format of the model, ready for the answer
+std::string format_prompt(const llama_bridge_context* bctx, const char* text) {
+    if (bctx->tmpl) {
+        const llama_chat_message chat[2] = {
+            { "system", bctx->system_prompt.c_str() },
+            { "user",   text },
+        };
+
+        std::vector<char> buf(2*(bctx->system_prompt.size() + strlen(text)) + 256);
+        int32_t n = llama_chat_apply_template(bctx->tmpl, chat, 2, true, buf.data(), (int32_t) buf.size());
+        if (n > (int32_t) buf.size()) {
+            buf.resize(n);
+            n = llama_chat_apply_template(bctx->tmpl, chat, 2, true, buf.data(), (int32_t) buf.size());
+        }
+        if (n >= 0) {
+            return std::string(buf.data(), n);
+        }
+    }
+
+    // A base model, or a template llama_chat_apply_template does not know
+    return bctx->system_prompt + "\n\nText: " + text + "\nRewritten text:";
+}
+
+std::vector<llama_token> tokenize(const llama_vocab* vocab, const std::string& text) {
+    std::vector<llama_token> tokens(text.size() + 2);
+    int32_t n = llama_tokenize(vocab, text.c_str(), (int32_t) text.size(), tokens.data(), (int32_t) tokens.size(), true, true);
+    if (n < 0) {
+        tokens.resize(-n);
+        n = llama_tokenize(vocab, text.c_str(), (int32_t) text.size(), tokens.data(), (int32_t) tokens.size(), true, true);
+    }
+    tokens.resize(std::max(0, n));
+    return tokens;
+}
+
+std::string token_to_piece(const llama_vocab* vocab, llama_token token) {
+    char buf[128];
+    const int32_t n = llama_token_to_piece(vocab, token, buf, sizeof(buf), 0, false);
+    return n > 0 ? std::string(buf, n) : std::string();
+}
+
+// Decode tokens[n_past..] at their positions, with the logits of the last one
+bool decode_from(llama_bridge_context* bctx, const std::vector<llama_token>& tokens, size_t n_past) {
+    const size_t n_batch = llama_n_batch(bctx->ctx);
+
+    while (n_past < tokens.size()) {
+        const size_t n_eval = std::min(n_batch, tokens.size() - n_past);
+
+        llama_batch batch = llama_batch_init((int32_t) n_eval, 0, 1);
+        batch.n_tokens = (int32_t) n_eval;
+        for (size_t i = 0; i < n_eval; i++) {
+            batch.token[i]     = tokens[n_past + i];
+            batch.pos[i]       = (llama_pos) (n_past + i);
+            batch.n_seq_id[i]  = 1;
+            batch.seq_id[i][0] = 0;
+            batch.logits[i]    = n_past + i == tokens.size() - 1;
+        }
+
+        const int32_t ret = llama_decode(bctx->ctx, batch);
+        llama_batch_free(batch);
+
+        if (ret != 0) {
+            fprintf(stderr, "llama_bridge: decode failed with result: %d\n", ret);
+            return false;
+        }
+
+        n_past += n_eval;
+    }
+
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+llama_bridge_params llama_bridge_default_params(void) {
+    llama_bridge_params params;
+    params.n_threads  = 0;
+    // A system prompt, a dictation of a few paragraphs and its rewrite
+    params.n_ctx      = 4096;
+    params.use_gpu    = true;
+    params.max_tokens = 0;
+    return params;
+}
+
+llama_bridge_context* llama_bridge_init(const char* model_path, const char* system_prompt, llama_bridge_params params) {
+    if (!model_path) {
+        return nullptr;
+    }
+
+    if (params.n_threads <= 0) {
+        params.n_threads = performance_core_count();
+    }
+    if (params.n_ctx <= 0) {
+        params.n_ctx = llama_bridge_default_params().n_ctx;
+    }
+
+    static std::once_flag backend_once;
+    std::call_once(backend_once, [] { llama_backend_init(); });
+
+    llama_model_params mparams = llama_model_default_params();
+    mparams.n_gpu_layers = params.use_gpu ? 999 : 0;
+    mparams.use_mmap     = true;
+
+    fprintf(stderr, "llama_bridge_init: GPU %s, n_threads=%d, n_ctx=%d\n",
+            params.use_gpu ? "enabled" : "disabled", params.n_threads, params.n_ctx);
+
+    llama_model* model = llama_model_load_from_file(model_path, mparams);
+    if (!model) {
+        fprintf(stderr, "llama_bridge: failed to load model '%s'\n", model_path);
+        return nullptr;
+    }
+
+    llama_context_params cparams = llama_context_default_params();
+    cparams.n_ctx           = params.n_ctx;
+    cparams.n_batch         = params.n_ctx;
+    cparams.n_threads       = params.n_threads;
+    cparams.n_threads_batch = params.n_threads;
+    cparams.no_perf         = true;
+
+    llama_context* ctx = llama_init_from_model(model, cparams);
+    if (!ctx) {
+        fprintf(stderr, "llama_bridge: failed to create context\n");
+        llama_model_free(model);
+        return nullptr;
+    }
+
+    llama_bridge_context* bctx = new llama_bridge_context();
+    bctx->model  = model;
+    bctx->ctx    = ctx;
+    // Punctuation and formatting fixes have one right answer, so no sampling
+    bctx->smpl   = llama_sampler_init_greedy();
+    bctx->params = params;
+    bctx->system_prompt = system_prompt ? system_prompt : "";
+    bctx->tmpl   = llama_model_chat_template(model, nullptr);
+
+    // Process the system prompt now, so the first enhancement only pays for its text. The prompt of an empty
+    // text shares everything with later prompts up to the text itself
+    const std::vector<llama_token> prefix = tokenize(llama_model_get_vocab(model), format_prompt(bctx, ""));
+    if ((int) prefix.size() >= params.n_ctx || !decode_from(bctx, prefix, 0)) {
+        llama_bridge_free(bctx);
+        return nullptr;
+    }
+    bctx->cached = prefix;
+
+    return bctx;
+}
+
+char* llama_bridge_enhance(llama_bridge_context* bctx, const char* text) {
+    if (!bctx || !text) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(bctx->mutex);
+
+    const llama_vocab* vocab = llama_model_get_vocab(bctx->model);
+    const std::vector<llama_token> prompt = tokenize(vocab, format_prompt(bctx, text));
+
+    int max_tokens = bctx->params.max_tokens;
+    if (max_tokens <= 0) {
+        max_tokens = 2*(int) tokenize(vocab, text).size() + 32;
+    }
+    max_tokens = std::min(max_tokens, bctx->params.n_ctx - (int) prompt.size());
+
+    if (prompt.empty() || max_tokens <= 0) {
+        fprintf(stderr, "llama_bridge: text of %zu tokens does not fit the context\n", prompt.size());
+        return nullptr;
+    }
+
+    // Keep the KV cache of the prefix shared with the previous prompt - the last token is decoded again for
+    // its logits
+    size_t n_cached = 0;
+    while (n_cached < bctx->cached.size() && n_cached + 1 < prompt.size() && bctx->cached[n_cached] == prompt[n_cached]) {
+        n_cached++;
+    }
+    llama_memory_seq_rm(llama_get_memory(bctx->ctx), 0, (llama_pos) n_cached, -1);
+    bctx->cached.resize(n_cached);
+
+    bctx->stats = {};
+    bctx->stats.n_prompt = (int32_t) prompt.size();
+    bctx->stats.n_cached = (int32_t) n_cached;
+
+    const int64_t t_start_us = now_us();
+
+    if (!decode_from(bctx, prompt, n_cached)) {
+        // The cache of the failed batch is unknown
+        llama_memory_seq_rm(llama_get_memory(bctx->ctx), 0, -1, -1);
+        bctx->cached.clear();
+        return nullptr;
+    }
+    bctx->cached = prompt;
+
+    const int64_t t_prompt_us = now_us();
+    bctx->stats.t_prompt_us = t_prompt_us - t_start_us;
+
+    std::string output;
+    llama_sampler_reset(bctx->smpl);
+
+    for (int i = 0; i < max_tokens; i++) {
+        const llama_token token = llama_sampler_sample(bctx->smpl, bctx->ctx, -1);
+        if (llama_vocab_is_eog(vocab, token)) {
+            break;
+        }
+
+        output += token_to_piece(vocab, token);
+        bctx->stats.n_output++;
+
+        if (i + 1 == max_tokens) {
+            break;
+        }
+
+        llama_batch batch = llama_batch_get_one(const_cast<llama_token*>(&token), 1);
+        if (llama_decode(bctx->ctx, batch) != 0) {
+            fprintf(stderr, "llama_bridge: decode failed after %d tokens\n", i + 1);
+            llama_memory_seq_rm(llama_get_memory(bctx->ctx), 0, (llama_pos) bctx->cached.size(), -1);
+            break;
+        }
+        bctx->cached.push_back(token);
+    }
+
+    bctx->stats.t_output_us = now_us() - t_prompt_us;
+
+    fprintf(stderr, "llama_bridge: %d prompt tokens (%d cached) in %.1f ms, %d output tokens in %.1f ms\n",
+            bctx->stats.n_prompt, bctx->stats.n_cached, bctx->stats.t_prompt_us/1000.0,
+            bctx->stats.n_output, bctx->stats.t_output_us/1000.0);
+
+    // Models tend to start the answer with a space or a newline
+    const size_t begin = output.find_first_not_of(" \n");
+    return copy_c_string(begin == std::string::npos ? std::string() : output.substr(begin));
+}
+
+bool llama_bridge_get_stats(llama_bridge_context* bctx, llama_bridge_stats* stats) {
+    if (!bctx || !stats) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(bctx->mutex);
+    *stats = bctx->stats;
+    return true;
+}
+
+void llama_bridge_free(llama_bridge_context* bctx) {
+    if (!bctx) {
+        return;
+    }
+
+    if (bctx->smpl) {
+        llama_sampler_free(bctx->smpl);
+    }
+    if (bctx->ctx) {
+        llama_free(bctx->ctx);
+    }
+    if (bctx->model) {
+        llama_model_free(bctx->model);
+    }
+
+    delete bctx;
+}
+
+} // extern "C"
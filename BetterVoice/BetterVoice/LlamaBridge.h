@@ -0,0 +1,63 @@
+//
+//  LlamaBridge.h
+//  BetterVoice
+//
+//  C wrapper for the llama runtime vendored with whisper.cpp (examples/talk-llama),
+//  used for local text enhancement without a cloud round-trip
+//
+
+#ifndef LlamaBridge_h
+#define LlamaBridge_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque enhancement engine: a model, its context and the cached system prompt
+typedef struct llama_bridge_context llama_bridge_context;
+
+// Model load and generation configuration
+typedef struct llama_bridge_params {
+    int n_threads;   // generation threads, 0 = number of performance cores
+    int n_ctx;       // context size in tokens, shared by the system prompt, the text and the output
+    bool use_gpu;
+    int max_tokens;  // output limit, 0 = twice the tokens of the text plus some slack
+} llama_bridge_params;
+
+llama_bridge_params llama_bridge_default_params(void);
+
+// Load a (small, instruction-tuned) GGUF model and process system_prompt once
+// The prompt is formatted with the chat template of the model, when it has a known one
+// Returns NULL on failure
+llama_bridge_context* llama_bridge_init(const char* model_path, const char* system_prompt, llama_bridge_params params);
+
+// Rewrite text following the system prompt, e.g. fix its punctuation and formatting
+// The KV cache of the longest prefix shared with the previous prompt - at least the system prompt - is reused,
+// so only the text itself is processed. Calls on the same context are serialized
+// Returns the output (caller must free), NULL on failure
+char* llama_bridge_enhance(llama_bridge_context* ctx, const char* text);
+
+// Timings of the last llama_bridge_enhance call
+typedef struct llama_bridge_stats {
+    int32_t n_prompt;   // tokens of the prompt
+    int32_t n_cached;   // of those, reused from the KV cache
+    int32_t n_output;   // tokens generated
+    int64_t t_prompt_us;
+    int64_t t_output_us;
+} llama_bridge_stats;
+
+// Returns false if ctx is NULL
+bool llama_bridge_get_stats(llama_bridge_context* ctx, llama_bridge_stats* stats);
+
+// Free the model and the context
+void llama_bridge_free(llama_bridge_context* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LlamaBridge_h */
@@ -43,8 +43,12 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
         audioLevelSubject.eraseToAnyPublisher()
     }
 
+    /// Receives each converted PCM16 chunk as it is captured (tap thread)
+    var sampleHandler: ((UnsafeBufferPointer<Int16>) -> Void)?
+
     private let audioEngine = AVAudioEngine()
-    private var audioBuffer = Data()
+    // Recording sink in the whisper bridge, written from the tap without locking or reallocating
+    private var capture: OpaquePointer?
     private var levelTimer: Timer?
     private var isEngineConfigured = false
 
@@ -56,6 +60,9 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
         interleaved: false
     )!
 
+    /// Longest recording kept, the capture buffer is reserved for it up front (only touched pages cost memory)
+    private static let maxCaptureSeconds = 600
+
     // MARK: - Initialization
 
     init() {
@@ -97,20 +104,33 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
             try configureInputDevice(deviceUID)
         }
 
+        guard let newCapture = whisper_bridge_capture_new(Int32(Self.maxCaptureSeconds * Int(targetFormat.sampleRate))) else {
+            throw AudioCaptureError.configurationFailed("Failed to allocate the capture buffer")
+        }
+        capture = newCapture
+
         // Always configure audio engine to ensure tap is properly installed
         // Even if pre-warmed, we need to reinstall tap when starting capture
-        try configureAudioEngine()
+        do {
+            try configureAudioEngine()
+        } catch {
+            whisper_bridge_capture_free(newCapture)
+            capture = nil
+            throw error
+        }
 
         // Start engine
         do {
             try audioEngine.start()
             Logger.shared.info("Audio capture started with device: \(deviceUID ?? "default")")
         } catch {
+            audioEngine.inputNode.removeTap(onBus: 0)
+            whisper_bridge_capture_free(newCapture)
+            capture = nil
             throw AudioCaptureError.configurationFailed("Failed to start audio engine: \(error.localizedDescription)")
         }
 
         isCapturing = true
-        audioBuffer = Data()
 
         // Start audio level monitoring at 60Hz (PR-001 requirement)
         startLevelMonitoring()
@@ -134,9 +154,21 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
         audioEngine.stop()
         isCapturing = false
 
-        // Return captured audio data
-        let capturedData = audioBuffer
-        audioBuffer = Data()
+        // Hand the captured samples out without copying, the Data frees the sink
+        let finished = capture
+        capture = nil
+        var sampleCount: Int32 = 0
+        let capturedData: Data
+        if let finished = finished, let samples = whisper_bridge_capture_data(finished, &sampleCount), sampleCount > 0 {
+            capturedData = Data(
+                bytesNoCopy: UnsafeMutableRawPointer(mutating: samples),
+                count: Int(sampleCount) * MemoryLayout<Int16>.size,
+                deallocator: .custom { _, _ in whisper_bridge_capture_free(finished) }
+            )
+        } else {
+            whisper_bridge_capture_free(finished)
+            capturedData = Data()
+        }
 
         Logger.shared.info("Audio capture stopped, captured \(capturedData.count) bytes")
 
@@ -208,11 +240,12 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
             return
         }
 
-        // Append converted PCM16 data to buffer
+        // Append converted PCM16 data to the capture sink
         if let channelData = outputBuffer.int16ChannelData {
             let frameLength = Int(outputBuffer.frameLength)
-            let data = Data(bytes: channelData[0], count: frameLength * MemoryLayout<Int16>.size)
-            audioBuffer.append(data)
+            whisper_bridge_capture_push(capture, channelData[0], Int32(frameLength))
+
+            sampleHandler?(UnsafeBufferPointer(start: channelData[0], count: frameLength))
         }
     }
 
@@ -233,30 +266,14 @@ final class AudioCaptureService: AudioCaptureServiceProtocol {
     }
 
     private func calculateAudioLevel() -> Float {
-        guard !audioBuffer.isEmpty else { return 0.0 }
+        guard let capture = capture else { return 0.0 }
 
-        // Calculate RMS from last chunk of audio buffer (last 512 samples)
-        let sampleCount = min(512, audioBuffer.count / MemoryLayout<Int16>.size)
-        guard sampleCount > 0 else { return 0.0 }
-
-        let offset = max(0, audioBuffer.count - sampleCount * MemoryLayout<Int16>.size)
-        let samples = audioBuffer.withUnsafeBytes { bytes -> [Int16] in
-            let pointer = bytes.baseAddress!.advanced(by: offset).assumingMemoryBound(to: Int16.self)
-            return Array(UnsafeBufferPointer(start: pointer, count: sampleCount))
-        }
-
-        // Calculate RMS
-        let sum = samples.reduce(0.0) { sum, sample in
-            let normalized = Double(sample) / Double(Int16.max)
-            return sum + normalized * normalized
-        }
-        let rms = sqrt(sum / Double(sampleCount))
+        // RMS of the last 512 captured samples
+        let rms = whisper_bridge_capture_rms(capture, 512)
 
         // Normalize to 0.0-1.0 range (RMS is typically much lower than 1.0)
         // Apply a multiplier to make levels more visible
-        let normalized = Float(min(1.0, rms * 10.0))
-
-        return normalized
+        return min(1.0, rms * 10.0)
     }
 
     deinit {
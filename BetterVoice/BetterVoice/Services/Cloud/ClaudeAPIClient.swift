@@ -276,4 +276,5 @@ enum LLMError: Error {
     case parseError(String)
     case timeout
     case networkError(Error)
+    case modelNotAvailable
 }
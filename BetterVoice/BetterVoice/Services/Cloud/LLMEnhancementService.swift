@@ -86,6 +86,11 @@ final class LLMEnhancementService {
 
         let providerLower = provider.lowercased()
 
+        // The local model needs no API key
+        if providerLower == "local" {
+            return LocalLLMClient.shared.isModelAvailable ? LocalLLMClient.shared : nil
+        }
+
         // Try to get API key from keychain
         guard let apiKey = try? keychainHelper.retrieveAPIKey(provider: providerLower), !apiKey.isEmpty else {
             return nil
@@ -0,0 +1,103 @@
+//
+//  LocalLLMClient.swift
+//  BetterVoice
+//
+//  On-device text enhancement with a small GGUF model through LlamaBridge
+//  Conforms to LLMProvider, no network round-trip and works offline
+//
+
+import Foundation
+
+// MARK: - Client Implementation
+
+final class LocalLLMClient: LLMProvider {
+
+    // MARK: - Singleton
+
+    /// The model stays loaded between enhancements, with the system prompt already in its KV cache
+    static let shared = LocalLLMClient(modelURL: ModelStorage.shared.getLocalLLMPath())
+
+    // MARK: - Properties
+
+    private let modelURL: URL
+    private var context: OpaquePointer?
+    private let queue = DispatchQueue(label: "com.bettervoice.llama", qos: .userInitiated)
+
+    /// Fixed for the lifetime of the context, so it is only processed once
+    static let systemPrompt = """
+    You fix the punctuation, capitalization and formatting of dictated text. Keep the wording and the language \
+    of the text, do not answer or comment on it, and reply with the corrected text only.
+    """
+
+    // MARK: - Initialization
+
+    init(modelURL: URL) {
+        self.modelURL = modelURL
+    }
+
+    deinit {
+        if let context = context {
+            llama_bridge_free(context)
+        }
+    }
+
+    /// Check if the model file is present
+    var isModelAvailable: Bool {
+        FileManager.default.fileExists(atPath: modelURL.path)
+    }
+
+    // MARK: - LLMProvider Implementation
+
+    func enhance(
+        text: String,
+        documentType: DocumentType,
+        systemPrompt: String? = nil
+    ) async throws -> String {
+        // The system prompt is baked into the cached context, documentType and custom prompts are not used
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async { [self] in
+                do {
+                    let context = try loadContextIfNeeded()
+
+                    guard let resultCString = llama_bridge_enhance(context, text) else {
+                        continuation.resume(throwing: LLMError.invalidResponse)
+                        return
+                    }
+
+                    let enhanced = String(cString: resultCString).trimmingCharacters(in: .whitespacesAndNewlines)
+                    free(resultCString)
+
+                    var stats = llama_bridge_stats()
+                    if llama_bridge_get_stats(context, &stats) {
+                        Logger.shared.info("Local LLM: \(stats.n_prompt) prompt tokens (\(stats.n_cached) cached), \(stats.n_output) output tokens in \((stats.t_prompt_us + stats.t_output_us) / 1000) ms")
+                    }
+
+                    // A model that gave up should not erase the dictation
+                    continuation.resume(returning: enhanced.isEmpty ? text : enhanced)
+                } catch {
+                    continuation.resume(throwing: error)
+                }
+            }
+        }
+    }
+
+    // MARK: - Private Methods
+
+    /// Called on queue only
+    private func loadContextIfNeeded() throws -> OpaquePointer {
+        if let context = context {
+            return context
+        }
+
+        guard isModelAvailable else {
+            throw LLMError.modelNotAvailable
+        }
+
+        guard let context = llama_bridge_init(modelURL.path, Self.systemPrompt, llama_bridge_default_params()) else {
+            throw LLMError.invalidResponse
+        }
+
+        self.context = context
+        return context
+    }
+}
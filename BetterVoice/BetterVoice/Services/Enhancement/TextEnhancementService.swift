@@ -21,7 +21,8 @@ protocol TextEnhancementServiceProtocol {
     func enhance(
         text: String,
         documentType: DocumentType,
-        useCloud: Bool
+        useCloud: Bool,
+        confidence: TranscriptionConfidence?
     ) async throws -> EnhancedText
 }
 
@@ -29,6 +30,9 @@ protocol TextEnhancementServiceProtocol {
 
 final class TextEnhancementService: TextEnhancementServiceProtocol {
 
+    /// Transcripts whose enhance score is below this are confident enough to skip the cloud stage
+    static let cloudEnhanceScoreThreshold: Float = 0.3
+
     // MARK: - Dependencies
 
     private let fillerRemover = FillerWordRemover.shared
@@ -49,7 +53,8 @@ final class TextEnhancementService: TextEnhancementServiceProtocol {
     func enhance(
         text: String,
         documentType: DocumentType,
-        useCloud: Bool = false
+        useCloud: Bool = false,
+        confidence: TranscriptionConfidence? = nil
     ) async throws -> EnhancedText {
 
         var enhanced = text
@@ -145,7 +150,14 @@ final class TextEnhancementService: TextEnhancementServiceProtocol {
         _ = formatResult.changes  // Track but don't store in final model
         appliedRules.append("format_\(detectedType.rawValue)")
 
-        // Stage 5: Cloud Enhancement (if enabled)
+        // Stage 5: Cloud Enhancement (if enabled), skipped for a transcript the model is confident in
+        var useCloud = useCloud
+        if useCloud, let confidence = confidence, confidence.enhanceScore < Self.cloudEnhanceScoreThreshold {
+            Logger.shared.info("Skipping cloud enhancement: confident transcript (enhance score \(String(format: "%.2f", confidence.enhanceScore)))")
+            appliedRules.append("cloud_skipped_confident")
+            useCloud = false
+        }
+
         if useCloud && prefs.externalLLMEnabled {
             do {
                 enhanced = try await applyCloudEnhancement(enhanced, documentType: detectedType)
@@ -54,6 +54,11 @@ final class ModelStorage {
         return modelsDirectory.appendingPathComponent("ggml-\(size.rawValue).bin")
     }
 
+    /// GGUF model of the local text enhancement (LocalLLMClient), e.g. a small instruction-tuned Qwen or Llama
+    func getLocalLLMPath() -> URL {
+        return modelsDirectory.appendingPathComponent("local-llm.gguf")
+    }
+
     func isModelDownloaded(_ size: WhisperModelSize) -> Bool {
         let path = getModelPath(for: size)
         return FileManager.default.fileExists(atPath: path.path)
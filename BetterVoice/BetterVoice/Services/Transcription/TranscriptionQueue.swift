@@ -2,7 +2,7 @@
 //  TranscriptionQueue.swift
 //  BetterVoice
 //
-//  Queue management for transcription jobs with serial processing and priority support
+//  Queue management for transcription jobs, scheduled by priority on the bridge's transcription engine
 //
 
 import Foundation
@@ -21,10 +21,13 @@ final class TranscriptionQueue {
         queueSubject.eraseToAnyPublisher()
     }
 
+    // Jobs not finished yet, high priority first - the engine schedules them, this only tracks them
     private var queue: [QueuedTranscription] = []
-    private var isProcessing = false
+    // Engine job of each submitted job
+    private var engineJobs: [UUID: Int64] = [:]
+    // Submissions run one after the other, so a model switch never races another one
+    private var lastSubmission: Task<Void, Never>?
     private let queueLock = NSLock()
-    private let processingQueue = DispatchQueue(label: "com.bettervoice.transcription-queue", qos: .userInitiated)
 
     private let whisperService: WhisperService
 
@@ -38,7 +41,6 @@ final class TranscriptionQueue {
 
     func enqueue(_ job: TranscriptionJob, audioData: Data, priority: TranscriptionPriority = .normal) {
         queueLock.lock()
-        defer { queueLock.unlock() }
 
         let queuedItem = QueuedTranscription(
             job: job,
@@ -60,53 +62,48 @@ final class TranscriptionQueue {
             queue.append(queuedItem)
         }
 
-        Logger.shared.info("Enqueued transcription job: \(job.id) with priority: \(priority)")
-
-        // Notify queue update
-        queueSubject.send(QueueUpdate(
-            queueLength: queue.count,
-            currentJob: isProcessing ? queue.first?.job : nil
-        ))
-
-        // Start processing if not already running
-        if !isProcessing {
-            processNext()
+        let previous = lastSubmission
+        lastSubmission = Task { [weak self] in
+            await previous?.value
+            await self?.submit(queuedItem)
         }
+        queueLock.unlock()
+
+        Logger.shared.info("Enqueued transcription job: \(job.id) with priority: \(priority)")
+        publishUpdate()
     }
 
     func cancel(_ jobID: UUID) {
         queueLock.lock()
-        defer { queueLock.unlock() }
 
-        // Remove from queue if not yet processing
+        if let engineJobID = engineJobs[jobID] {
+            // The engine stops it and its completion fails the job
+            queueLock.unlock()
+            whisperService.cancelJob(engineJobID)
+            Logger.shared.info("Cancelled transcription: \(jobID)")
+            return
+        }
+
+        // Not submitted yet, submit(_:) skips it
         if let index = queue.firstIndex(where: { $0.job.id == jobID }) {
             _ = queue.remove(at: index)
             Logger.shared.info("Cancelled queued transcription: \(jobID)")
-
-            queueSubject.send(QueueUpdate(
-                queueLength: queue.count,
-                currentJob: isProcessing ? queue.first?.job : nil
-            ))
-        } else {
-            // If currently processing, cancel the whisper service
-            if queue.first?.job.id == jobID {
-                whisperService.cancel()
-                Logger.shared.info("Cancelled active transcription: \(jobID)")
-            }
         }
+        queueLock.unlock()
+
+        publishUpdate()
     }
 
     func clearQueue() {
         queueLock.lock()
-        defer { queueLock.unlock() }
-
+        let submitted = Array(engineJobs.values)
         queue.removeAll()
+        queueLock.unlock()
+
+        submitted.forEach { whisperService.cancelJob($0) }
         Logger.shared.info("Cleared transcription queue")
 
-        queueSubject.send(QueueUpdate(
-            queueLength: 0,
-            currentJob: nil
-        ))
+        publishUpdate()
     }
 
     func getQueueLength() -> Int {
@@ -118,93 +115,63 @@ final class TranscriptionQueue {
     func getCurrentJob() -> TranscriptionJob? {
         queueLock.lock()
         defer { queueLock.unlock() }
-        return isProcessing ? queue.first?.job : nil
+        return queue.first?.job
     }
 
     // MARK: - Private Methods
 
-    private func processNext() {
-        processingQueue.async { [weak self] in
-            guard let self = self else { return }
-
-            self.queueLock.lock()
+    private func submit(_ queuedItem: QueuedTranscription) async {
+        let job = queuedItem.job
 
-            guard !self.queue.isEmpty else {
-                self.isProcessing = false
-                self.queueLock.unlock()
-                Logger.shared.debug("Transcription queue empty")
-                return
+        queueLock.lock()
+        let isQueued = queue.contains(where: { $0.job.id == job.id })
+        queueLock.unlock()
+        guard isQueued else { return }
+
+        do {
+            // Ensure model is loaded
+            if !whisperService.isModelLoaded || whisperService.currentModel?.size != job.modelSize {
+                let model = ModelStorage.shared.getModelInfo(job.modelSize)
+                try await whisperService.loadModel(model)
             }
 
-            self.isProcessing = true
-            let queuedItem = self.queue.first!
-            self.queueLock.unlock()
-
-            Logger.shared.info("Processing transcription job: \(queuedItem.job.id)")
-
-            // Process the transcription
-            Task {
-                let result: TranscriptionResult?
-                let error: Error?
-
-                do {
-                    result = try await self.processTranscription(queuedItem)
-                    error = nil
-                } catch let e {
-                    result = nil
-                    error = e
-                }
-
-                // Remove from queue and process next (on main queue to avoid lock issues)
-                await MainActor.run {
-                    // Log errors
-                    if let error = error {
-                        Logger.shared.error("Transcription failed for job: \(queuedItem.job.id)", error: error)
-                    }
-
-                    // Update job status
-                    if let result = result {
-                        self.completeJob(queuedItem.job, result: result)
-                    } else if let error = error {
-                        self.failJob(queuedItem.job, error: error)
-                    }
-
-                    self.queueLock.lock()
-                    if !self.queue.isEmpty && self.queue.first?.job.id == queuedItem.job.id {
-                        self.queue.removeFirst()
-                    }
-                    let remainingCount = self.queue.count
-                    self.queueLock.unlock()
-
-                    self.queueSubject.send(QueueUpdate(
-                        queueLength: remainingCount,
-                        currentJob: remainingCount > 0 ? self.queue.first?.job : nil
-                    ))
-
-                    // Process next job
-                    if remainingCount > 0 {
-                        self.processNext()
-                    } else {
-                        self.isProcessing = false
-                    }
-                }
+            // Lock held across the submit so the completion can't run before the job is recorded
+            queueLock.lock()
+            defer { queueLock.unlock() }
+            engineJobs[job.id] = try whisperService.submit(audioData: queuedItem.audioData, priority: queuedItem.priority) { [weak self] result in
+                self?.finish(queuedItem, result: result)
             }
+            Logger.shared.info("Processing transcription job: \(job.id)")
+        } catch {
+            finish(queuedItem, result: .failure(error))
         }
     }
 
-    private func processTranscription(_ queuedItem: QueuedTranscription) async throws -> TranscriptionResult {
-        let job = queuedItem.job
-
-        // Ensure model is loaded
-        if !whisperService.isModelLoaded || whisperService.currentModel?.size != job.modelSize {
-            let model = ModelStorage.shared.getModelInfo(job.modelSize)
-            try await whisperService.loadModel(model)
+    private func finish(_ queuedItem: QueuedTranscription, result: Result<TranscriptionResult, Error>) {
+        queueLock.lock()
+        engineJobs[queuedItem.job.id] = nil
+        if let index = queue.firstIndex(where: { $0.job.id == queuedItem.job.id }) {
+            queue.remove(at: index)
+        }
+        queueLock.unlock()
+
+        switch result {
+        case .success(let transcription):
+            completeJob(queuedItem.job, result: transcription)
+        case .failure(let error):
+            Logger.shared.error("Transcription failed for job: \(queuedItem.job.id)", error: error)
+            failJob(queuedItem.job, error: error)
         }
 
-        // Perform transcription
-        let result = try await whisperService.transcribe(audioData: queuedItem.audioData)
+        publishUpdate()
+    }
+
+    private func publishUpdate() {
+        queueLock.lock()
+        let update = QueueUpdate(queueLength: queue.count, currentJob: queue.first?.job)
+        queueLock.unlock()
 
-        return result
+        queueSubject.send(update)
     }
 
     private func completeJob(_ job: TranscriptionJob, result: TranscriptionResult) {
@@ -8,6 +8,7 @@
 
 import Foundation
 import Combine
+import IOKit.ps
 
 // MARK: - Protocol
 
@@ -29,6 +30,17 @@ struct TranscriptionResult {
     let languageConfidence: Float
     let segments: [TranscriptionSegment]
     let processingTime: TimeInterval
+    var confidence: TranscriptionConfidence? = nil
+}
+
+/// Token confidence of a transcript, from whisper_bridge_result_confidence
+struct TranscriptionConfidence {
+    let wordCount: Int
+    let lowConfidenceWordCount: Int
+    let averageLogProbability: Float
+    let noSpeechProbability: Float
+    /// 0...1, how likely a cloud LLM pass is to improve on the local rules
+    let enhanceScore: Float
 }
 
 struct TranscriptionSegment {
@@ -45,6 +57,7 @@ enum WhisperServiceError: Error {
     case invalidAudioData
     case transcriptionFailed(String)
     case cancelled
+    case queueFull
 }
 
 // MARK: - Service Implementation
@@ -62,8 +75,54 @@ final class WhisperService: WhisperServiceProtocol {
     }
 
     private var whisperContext: OpaquePointer?
-    private var isCancelled = false
+    // Schedules the transcriptions on the states of whisperContext, dictations first
+    private var engine: OpaquePointer?
+
+    // Smaller model the bridge transcribes with while the Mac is critically hot, loaded on first need
+    private var fallbackContext: OpaquePointer?
+    private var fallbackAttempted = false
+    private var powerObservers: [NSObjectProtocol] = []
+
+    // Cancellation flags and engine jobs of the transcriptions in flight, cancel() stops all of them
+    private var inFlight: [ObjectIdentifier: TranscriptionCancellation] = [:]
+    private var inFlightJobs: Set<Int64> = []
+    private let inFlightLock = NSLock()
     private let processingQueue = DispatchQueue(label: "com.bettervoice.whisper", qos: .userInitiated)
+    // Transcriptions run on pooled whisper states, so they don't need to be serialized
+    private let transcriptionQueue = DispatchQueue(label: "com.bettervoice.whisper.transcribe", qos: .userInitiated, attributes: .concurrent)
+
+    /// Peak level the bridge normalizes recordings to before transcription
+    private static let normalizationTargetPeak: Float = 0.3
+
+    /// Layout of the recordings from AudioCaptureService, the bridge converts them itself
+    private static let captureFormat = whisper_bridge_audio_format(
+        encoding: WHISPER_BRIDGE_AUDIO_PCM16,
+        sample_rate: 16000,
+        n_channels: 1
+    )
+
+    /// Engine workers, each on its own pre-allocated decoding state: one is always left to dictations,
+    /// so a file job never delays them
+    private static let engineWorkerCount: Int32 = 2
+
+    /// Jobs waiting for an engine worker before submit(audioData:priority:completion:) refuses more
+    private static let engineMaxQueued: Int32 = 16
+
+    // Streaming session (decodes while the hotkey is held)
+    private var stream: OpaquePointer?
+    private var streamCallbackBox: Unmanaged<StreamCallbackBox>?
+    private var streamStartTime: Date?
+    private let streamLock = NSLock()
+
+    // Always-listening session (VAD on the efficiency cores, whisper only for speech)
+    private var listener: OpaquePointer?
+    private var listenerCallbackBox: Unmanaged<StreamCallbackBox>?
+    private let listenerLock = NSLock()
+
+    /// Rolling window parameters, same trade-off as examples/stream (step / length / keep)
+    private static let streamStepMs: Int32 = 3000
+    private static let streamLengthMs: Int32 = 10000
+    private static let streamKeepMs: Int32 = 200
 
     // MARK: - Public Methods
 
@@ -95,6 +154,7 @@ final class WhisperService: WhisperServiceProtocol {
 
                     self.currentModel = model
                     self.isModelLoaded = true
+                    self.startPowerMonitoring()
 
                     Logger.shared.info("Loaded Whisper model: \(model.size.rawValue) from \(model.storageURL.lastPathComponent)")
                     continuation.resume()
@@ -106,7 +166,119 @@ final class WhisperService: WhisperServiceProtocol {
         }
     }
 
+    /// Transcribe as a dictation: the engine runs it ahead of any queued file job
     func transcribe(audioData: Data) async throws -> TranscriptionResult {
+        try await withCheckedThrowingContinuation { continuation in
+            do {
+                _ = try submit(audioData: audioData, priority: .high) { result in
+                    continuation.resume(with: result)
+                }
+            } catch {
+                continuation.resume(throwing: error)
+            }
+        }
+    }
+
+    /// Queue a transcription on the engine, which runs .high jobs before .normal ones and preempts
+    /// a .normal job when no worker is left for a .high one (it then runs again from the start)
+    /// - Parameter completion: called once on an engine thread, with `WhisperServiceError.cancelled` after cancelJob(_:)
+    /// - Returns: the engine job id, for cancelJob(_:)
+    /// - Throws: `WhisperServiceError.queueFull` when too many jobs are waiting already
+    @discardableResult
+    func submit(
+        audioData: Data,
+        priority: TranscriptionPriority,
+        completion: @escaping (Result<TranscriptionResult, Error>) -> Void
+    ) throws -> Int64 {
+        guard isModelLoaded, let engine = engine else {
+            throw WhisperServiceError.modelNotLoaded
+        }
+
+        // At least 0.5s of PCM16 @ 16kHz, in whole samples
+        guard audioData.count >= 16000 * 2, audioData.count % MemoryLayout<Int16>.size == 0 else {
+            throw WhisperServiceError.invalidAudioData
+        }
+
+        // The power source has no notification here, re-read it for every job
+        reportPowerState()
+
+        let startTime = Date()
+        let sampleCount = audioData.count / MemoryLayout<Int16>.size
+        let box = Unmanaged.passRetained(EngineJobBox { [weak self] jobID, status, bridgeResult in
+            defer { whisper_bridge_result_free(bridgeResult) } // Returns the state to the pool
+            guard let self = self else {
+                completion(.failure(WhisperServiceError.transcriptionFailed("Service deallocated")))
+                return
+            }
+
+            self.inFlightLock.lock()
+            self.inFlightJobs.remove(jobID)
+            self.inFlightLock.unlock()
+
+            do {
+                let transcription = try self.bridgeTranscription(status: status, result: bridgeResult)
+                let processingTime = Date().timeIntervalSince(startTime)
+
+                Logger.shared.info("Transcription complete in \(String(format: "%.2f", processingTime))s: \(transcription.text.prefix(50))...")
+
+                completion(.success(TranscriptionResult(
+                    text: transcription.text,
+                    detectedLanguage: transcription.detectedLanguage ?? "en",
+                    languageConfidence: self.getLanguageConfidence(),
+                    segments: transcription.segments,
+                    processingTime: processingTime,
+                    confidence: transcription.confidence
+                )))
+            } catch {
+                Logger.shared.error("Transcription failed", error: error)
+                completion(.failure(error))
+            }
+        })
+
+        // Hold the lock across the submit so the callback can't remove the job before it is recorded
+        inFlightLock.lock()
+        defer { inFlightLock.unlock() }
+
+        let jobID = audioData.withUnsafeBytes { bytes in
+            whisper_bridge_engine_submit(
+                engine,
+                bytes.baseAddress,
+                bytes.count,
+                Self.captureFormat,
+                Self.normalizationTargetPeak,
+                "en",  // English
+                false, // No translation
+                buildInitialPrompt(),  // Custom vocabulary hint
+                priority == .high ? WHISPER_BRIDGE_PRIORITY_INTERACTIVE : WHISPER_BRIDGE_PRIORITY_BACKGROUND,
+                { jobID, status, result, userData in
+                    guard let userData = userData else { return }
+                    let box = Unmanaged<EngineJobBox>.fromOpaque(userData).takeRetainedValue()
+                    box.handler(jobID, status, result)
+                },
+                box.toOpaque()
+            )
+        }
+
+        guard jobID > 0 else {
+            box.release()
+            Logger.shared.warning("Transcription engine queue full, rejecting \(sampleCount) samples")
+            throw WhisperServiceError.queueFull
+        }
+
+        inFlightJobs.insert(jobID)
+        Logger.shared.info("Submitted transcription job \(jobID) (\(sampleCount) samples, priority \(priority))")
+        return jobID
+    }
+
+    /// Cancel an engine job, queued or running; its completion gets `WhisperServiceError.cancelled`
+    func cancelJob(_ jobID: Int64) {
+        guard let engine = engine else { return }
+        whisper_bridge_engine_cancel(engine, jobID)
+    }
+
+    /// Transcribe with a cancellation flag of the caller, which stops the encoder and decoder mid-run
+    /// and makes the call throw `WhisperServiceError.cancelled`
+    func transcribe(audioData: Data, cancellation: TranscriptionCancellation) async throws -> TranscriptionResult {
         guard isModelLoaded else {
             throw WhisperServiceError.modelNotLoaded
         }
@@ -115,11 +287,21 @@ final class WhisperService: WhisperServiceProtocol {
             throw WhisperServiceError.invalidAudioData
         }
 
-        isCancelled = false
+        let key = ObjectIdentifier(cancellation)
+        inFlightLock.lock()
+        inFlight[key] = cancellation
+        inFlightLock.unlock()
+        defer {
+            inFlightLock.lock()
+            inFlight[key] = nil
+            inFlightLock.unlock()
+        }
+
+        reportPowerState()
 
         // Perform transcription on background queue
         return try await withCheckedThrowingContinuation { continuation in
-            processingQueue.async { [weak self] in
+            transcriptionQueue.async { [weak self] in
                 guard let self = self else {
                     continuation.resume(throwing: WhisperServiceError.transcriptionFailed("Service deallocated"))
                     return
@@ -128,28 +310,19 @@ final class WhisperService: WhisperServiceProtocol {
                 let startTime = Date()
 
                 do {
-                    // Convert Data to float array for whisper.cpp
-                    let audioSamples = self.convertPCM16ToFloat(audioData)
-
                     // Check for cancellation
-                    if self.isCancelled {
+                    if cancellation.isCancelled {
                         continuation.resume(throwing: WhisperServiceError.cancelled)
                         return
                     }
 
-                    // Perform transcription
-                    // NOTE: This is a placeholder - actual whisper.cpp integration requires C++ bridging
-                    let transcriptionText = try self.performWhisperTranscription(samples: audioSamples)
-
-                    // Check for cancellation
-                    if self.isCancelled {
-                        continuation.resume(throwing: WhisperServiceError.cancelled)
-                        return
-                    }
+                    // Perform transcription - the bridge converts and normalizes the PCM16 itself
+                    let transcription = try self.performWhisperTranscription(pcm16: audioData, cancellation: cancellation)
+                    let transcriptionText = transcription.text
 
                     // Extract segments and metadata
-                    let segments = self.extractSegments()
-                    let language = self.getDetectedLanguage()
+                    let segments = transcription.segments
+                    let language = transcription.detectedLanguage ?? "en"
                     let confidence = self.getLanguageConfidence()
 
                     let processingTime = Date().timeIntervalSince(startTime)
@@ -159,7 +332,8 @@ final class WhisperService: WhisperServiceProtocol {
                         detectedLanguage: language,
                         languageConfidence: confidence,
                         segments: segments,
-                        processingTime: processingTime
+                        processingTime: processingTime,
+                        confidence: transcription.confidence
                     )
 
                     Logger.shared.info("Transcription complete in \(String(format: "%.2f", processingTime))s: \(transcriptionText.prefix(50))...")
@@ -174,8 +348,243 @@ final class WhisperService: WhisperServiceProtocol {
     }
 
     func cancel() {
-        isCancelled = true
-        Logger.shared.info("Transcription cancellation requested")
+        inFlightLock.lock()
+        let cancellations = Array(inFlight.values)
+        let jobs = Array(inFlightJobs)
+        inFlightLock.unlock()
+
+        cancellations.forEach { $0.cancel() }
+        jobs.forEach { cancelJob($0) }
+        Logger.shared.info("Transcription cancellation requested (\(cancellations.count + jobs.count) in flight)")
+    }
+
+    // MARK: - Streaming
+
+    /// Start decoding audio incrementally while it is being captured
+    /// - Parameter onPartial: receives the running transcript on a background thread
+    func beginStreaming(onPartial: @escaping (String) -> Void) throws {
+        guard isModelLoaded, let context = whisperContext else {
+            throw WhisperServiceError.modelNotLoaded
+        }
+
+        streamLock.lock()
+        defer { streamLock.unlock() }
+
+        guard stream == nil else {
+            Logger.shared.warning("Streaming session already active")
+            return
+        }
+
+        let box = Unmanaged.passRetained(StreamCallbackBox(handler: onPartial))
+        let session = whisper_bridge_stream_begin(
+            context,
+            "en",
+            false,
+            buildInitialPrompt(),
+            Self.streamStepMs,
+            Self.streamLengthMs,
+            Self.streamKeepMs,
+            { text, userData in
+                guard let text = text, let userData = userData else { return }
+                let box = Unmanaged<StreamCallbackBox>.fromOpaque(userData).takeUnretainedValue()
+                box.handler(String(cString: text))
+            },
+            box.toOpaque()
+        )
+
+        guard session != nil else {
+            box.release()
+            throw WhisperServiceError.transcriptionFailed("Failed to start streaming session")
+        }
+
+        stream = session
+        streamCallbackBox = box
+        streamStartTime = Date()
+        Logger.shared.info("Streaming transcription started")
+    }
+
+    /// Feed captured PCM16 samples into the active streaming session (no-op without one)
+    func pushStreaming(_ samples: UnsafeBufferPointer<Int16>) {
+        streamLock.lock()
+        defer { streamLock.unlock() }
+
+        guard let session = stream, !samples.isEmpty else { return }
+
+        whisper_bridge_stream_push_pcm16(session, samples.baseAddress, Int32(samples.count))
+    }
+
+    /// Decode the audio since the last step and close the session
+    /// - Returns: the final transcript, or nil if no session was active
+    func endStreaming() async -> TranscriptionResult? {
+        streamLock.lock()
+        let session = stream
+        let box = streamCallbackBox
+        let startTime = streamStartTime ?? Date()
+        stream = nil
+        streamCallbackBox = nil
+        streamStartTime = nil
+        streamLock.unlock()
+
+        guard let session = session else { return nil }
+
+        return await withCheckedContinuation { continuation in
+            transcriptionQueue.async {
+                let resultCString = whisper_bridge_stream_end(session)
+                box?.release()
+
+                guard let resultCString = resultCString else {
+                    continuation.resume(returning: nil)
+                    return
+                }
+
+                let text = String(cString: resultCString).trimmingCharacters(in: .whitespacesAndNewlines)
+                free(resultCString)
+
+                let processingTime = Date().timeIntervalSince(startTime)
+                Logger.shared.info("Streaming transcription finished: \(text.prefix(50))...")
+
+                continuation.resume(returning: TranscriptionResult(
+                    text: text,
+                    detectedLanguage: "en",
+                    languageConfidence: self.getLanguageConfidence(),
+                    segments: [],
+                    processingTime: processingTime
+                ))
+            }
+        }
+    }
+
+    // MARK: - Always Listening
+
+    /// Start transcribing every speech window of the pushed audio, detected by the Silero VAD model at vadModelPath
+    /// - Parameter onSpeech: receives the transcript of each window on a background thread
+    func beginListening(vadModelPath: String, onSpeech: @escaping (String) -> Void) throws {
+        guard isModelLoaded, let context = whisperContext else {
+            throw WhisperServiceError.modelNotLoaded
+        }
+
+        listenerLock.lock()
+        defer { listenerLock.unlock() }
+
+        guard listener == nil else {
+            Logger.shared.warning("Listening session already active")
+            return
+        }
+
+        let box = Unmanaged.passRetained(StreamCallbackBox(handler: onSpeech))
+        let session = whisper_bridge_listen_begin(
+            context,
+            vadModelPath,
+            "en",
+            false,
+            buildInitialPrompt(),
+            { text, userData in
+                guard let text = text, let userData = userData else { return }
+                let box = Unmanaged<StreamCallbackBox>.fromOpaque(userData).takeUnretainedValue()
+                box.handler(String(cString: text))
+            },
+            box.toOpaque()
+        )
+
+        guard session != nil else {
+            box.release()
+            throw WhisperServiceError.transcriptionFailed("Failed to start listening session")
+        }
+
+        listener = session
+        listenerCallbackBox = box
+        Logger.shared.info("Always-on listening started")
+    }
+
+    /// Feed captured PCM16 samples into the active listening session (no-op without one)
+    func pushListening(_ samples: UnsafeBufferPointer<Int16>) {
+        listenerLock.lock()
+        defer { listenerLock.unlock() }
+
+        guard let session = listener, !samples.isEmpty else { return }
+
+        whisper_bridge_listen_push_pcm16(session, samples.baseAddress, Int32(samples.count))
+    }
+
+    /// Time spent transcribing vs only listening, to check the battery impact
+    func listeningStats() -> whisper_bridge_listen_stats? {
+        listenerLock.lock()
+        defer { listenerLock.unlock() }
+
+        guard let session = listener else { return nil }
+
+        var stats = whisper_bridge_listen_stats()
+        return whisper_bridge_listen_get_stats(session, &stats) ? stats : nil
+    }
+
+    /// Stop listening; speech not yet closed into a window is dropped
+    func endListening() {
+        listenerLock.lock()
+        let session = listener
+        let box = listenerCallbackBox
+        listener = nil
+        listenerCallbackBox = nil
+        listenerLock.unlock()
+
+        guard let session = session else { return }
+
+        whisper_bridge_listen_end(session)
+        box?.release()
+        Logger.shared.info("Always-on listening stopped")
+    }
+
+    // MARK: - Private Methods - Power Policy
+
+    /// Report thermal state changes to the bridge, which scales the transcriptions back (threads, efficiency
+    /// cores, encode size, candidates, then the fallback model) so latency degrades gradually when throttled
+    private func startPowerMonitoring() {
+        guard powerObservers.isEmpty else { return }
+        let center = NotificationCenter.default
+        for name in [ProcessInfo.thermalStateDidChangeNotification, Notification.Name.NSProcessInfoPowerStateDidChange] {
+            powerObservers.append(center.addObserver(forName: name, object: nil, queue: nil) { [weak self] _ in
+                self?.reportPowerState()
+            })
+        }
+        reportPowerState()
+    }
+
+    private func reportPowerState() {
+        let info = ProcessInfo.processInfo
+        whisper_bridge_set_power_state(Int32(info.thermalState.rawValue), Self.isOnBattery() || info.isLowPowerModeEnabled)
+
+        if whisper_bridge_get_policy().use_fallback_model && !fallbackAttempted {
+            fallbackAttempted = true
+            processingQueue.async { [weak self] in
+                self?.loadFallbackModel()
+            }
+        }
+    }
+
+    private static func isOnBattery() -> Bool {
+        guard let info = IOPSCopyPowerSourcesInfo()?.takeRetainedValue(),
+              let source = IOPSGetProvidingPowerSourceType(info)?.takeUnretainedValue() else {
+            return false
+        }
+        return (source as String) == kIOPMBatteryPowerKey
+    }
+
+    /// Load the next smaller downloaded model as the bridge's fallback, placed for the current policy
+    private func loadFallbackModel() {
+        guard fallbackContext == nil, let context = whisperContext, let current = currentModel,
+              let index = WhisperModelSize.allCases.firstIndex(of: current.size),
+              let size = WhisperModelSize.allCases[..<index].last(where: { ModelStorage.shared.isModelDownloaded($0) }) else {
+            return
+        }
+
+        let params = whisper_bridge_policy_params(whisper_bridge_default_params())
+        guard let fallback = whisper_bridge_init_with_params(ModelStorage.shared.getModelPath(for: size).path, params) else {
+            Logger.shared.warning("Failed to load the \(size.rawValue) fallback model")
+            return
+        }
+
+        fallbackContext = fallback
+        whisper_bridge_set_fallback_model(context, fallback)
+        Logger.shared.info("Loaded the \(size.rawValue) model as thermal fallback")
     }
 
     // MARK: - Private Methods - Whisper.cpp Integration
@@ -183,7 +592,13 @@ final class WhisperService: WhisperServiceProtocol {
     private func loadWhisperContext(modelPath: String) throws {
         // Use whisper.cpp C bridge
         Logger.shared.info("Initializing whisper context from: \(modelPath)")
-        whisperContext = whisper_bridge_init(modelPath)
+        // Thread count defaults to the performance cores; autotune below refines it per model
+        var params = whisper_bridge_default_params()
+        params.use_gpu = true
+        // Loads on the bridge's thread and runs a warm-up pass on silence, so the first
+        // hotkey press finds compiled pipelines and allocated buffers like later ones do
+        let preload = whisper_bridge_preload(modelPath, params)
+        whisperContext = whisper_bridge_preload_wait(preload)
 
         guard whisperContext != nil else {
             Logger.shared.error("❌ whisper_bridge_init returned NULL for model: \(modelPath)")
@@ -197,100 +612,127 @@ final class WhisperService: WhisperServiceProtocol {
             throw WhisperServiceError.transcriptionFailed("Whisper context validation failed")
         }
 
+        if whisper_bridge_has_coreml() {
+            Logger.shared.info("Whisper encoder runs on Core ML (compute units \(params.coreml_units))")
+        }
+
+        // Pick the fastest encoder thread count for this model (cached after the first load)
+        let tunedThreads = whisper_bridge_autotune(whisperContext, modelPath)
+        if tunedThreads > 0 {
+            Logger.shared.info("Whisper decoding with \(tunedThreads) threads")
+        } else {
+            Logger.shared.warning("Whisper autotune failed, using \(whisper_bridge_get_params(whisperContext).n_threads) threads")
+        }
+
+        // Pre-warms a decoding state per worker, so concurrent transcriptions skip KV cache allocation
+        engine = whisper_bridge_engine_new(whisperContext, Self.engineWorkerCount, Self.engineMaxQueued)
+        guard engine != nil else {
+            Logger.shared.error("❌ Failed to start the transcription engine")
+            whisper_bridge_free(whisperContext)
+            whisperContext = nil
+            throw WhisperServiceError.transcriptionFailed("Failed to start the transcription engine")
+        }
+
         Logger.shared.info("✅ Whisper context initialized successfully")
     }
 
-    private func performWhisperTranscription(samples: [Float]) throws -> String {
+    private func performWhisperTranscription(pcm16 audioData: Data, cancellation: TranscriptionCancellation) throws -> BridgeTranscription {
         guard let context = whisperContext else {
             throw WhisperServiceError.modelNotLoaded
         }
 
-        // Normalize audio - Whisper expects audio in [-1, 1] range
-        // Find the maximum absolute amplitude
-        let maxAmplitude = samples.map { abs($0) }.max() ?? 0.0
-        Logger.shared.info("Audio amplitude - max: \(maxAmplitude)")
-
-        // Normalize to target peak of 0.3 (conservative to avoid clipping)
-        let normalizedSamples: [Float]
-        if maxAmplitude > 0.001 {  // Only normalize if there's actual audio
-            let targetPeak: Float = 0.3
-            let gainFactor = targetPeak / maxAmplitude
-            normalizedSamples = samples.map { $0 * gainFactor }
-            let newMax = normalizedSamples.map { abs($0) }.max() ?? 0.0
-            Logger.shared.info("Audio normalized with gain factor \(gainFactor) - new max: \(newMax)")
-        } else {
-            normalizedSamples = samples
-            Logger.shared.warning("Audio too quiet to normalize (max: \(maxAmplitude))")
+        let initialPrompt = buildInitialPrompt()
+        let sampleCount = audioData.count / MemoryLayout<Int16>.size
+
+        Logger.shared.info("Calling whisper_bridge_transcribe_audio with \(sampleCount) samples")
+
+        // Use whisper bridge for transcription - runs on its own pooled decoding state and
+        // normalizes to a 0.3 peak (conservative to avoid clipping) while converting the bytes to float
+        let bridgeResult = audioData.withUnsafeBytes { bytes -> UnsafeMutablePointer<whisper_bridge_result>? in
+            whisper_bridge_transcribe_audio(
+                context,
+                bytes.baseAddress,
+                bytes.count,
+                Self.captureFormat,
+                Self.normalizationTargetPeak,
+                "en",  // English
+                false, // No translation
+                initialPrompt,  // Custom vocabulary hint
+                cancellation.handle
+            )
         }
 
-        // Build initial_prompt from custom vocabulary
-        let prefs = UserPreferences.load()
-        Logger.shared.info("Custom vocabulary count: \(prefs.customVocabulary.count)")
-        Logger.shared.info("Custom vocabulary words: \(prefs.customVocabulary)")
+        defer { whisper_bridge_result_free(bridgeResult) } // Returns the state to the pool
 
-        let initialPrompt = prefs.customVocabulary.isEmpty ? nil : prefs.customVocabulary.joined(separator: ", ")
+        return try bridgeTranscription(status: bridgeResult?.pointee.status ?? -1, result: bridgeResult)
+    }
 
-        if let prompt = initialPrompt {
-            Logger.shared.info("Using initial_prompt for Whisper: \(prompt)")
-        } else {
-            Logger.shared.info("No custom vocabulary - initial_prompt is nil")
+    /// Copy the transcript out of a bridge result, throwing for a failed or cancelled transcription
+    private func bridgeTranscription(status: Int32, result bridgeResult: UnsafeMutablePointer<whisper_bridge_result>?) throws -> BridgeTranscription {
+        if status == WHISPER_BRIDGE_STATUS_CANCELLED {
+            throw WhisperServiceError.cancelled
         }
 
-        Logger.shared.info("Calling whisper_bridge_transcribe with \(normalizedSamples.count) samples")
-
-        // Use whisper bridge for transcription
-        guard let resultCString = whisper_bridge_transcribe(
-            context,
-            normalizedSamples,
-            Int32(normalizedSamples.count),
-            "en",  // English
-            false, // No translation
-            initialPrompt  // Custom vocabulary hint
-        ) else {
+        guard let result = bridgeResult else {
             throw WhisperServiceError.transcriptionFailed("Whisper transcription returned nil")
         }
 
-        let result = String(cString: resultCString)
-        free(resultCString) // Free the C string allocated by the bridge
-
-        let trimmed = result.trimmingCharacters(in: CharacterSet.whitespacesAndNewlines)
-        Logger.shared.info("Whisper raw result: '\(result)' (trimmed: '\(trimmed)', length: \(trimmed.count))")
-
-        return trimmed
-    }
+        guard status == 0 else {
+            throw WhisperServiceError.transcriptionFailed("whisper_full failed with result: \(status)")
+        }
 
-    private func extractSegments() -> [TranscriptionSegment] {
-        // NOTE: Placeholder for actual segment extraction from whisper.cpp
-        // Actual implementation would extract from whisper_context
-        /*
+        // Segment texts point into the decoding state; copy each once while building the transcript
+        var text = ""
         var segments: [TranscriptionSegment] = []
-        let segmentCount = whisper_full_n_segments(whisperContext)
-
-        for i in 0..<segmentCount {
-            let startTime = TimeInterval(whisper_full_get_segment_t0(whisperContext, i)) / 100.0
-            let endTime = TimeInterval(whisper_full_get_segment_t1(whisperContext, i)) / 100.0
-
-            if let text = whisper_full_get_segment_text(whisperContext, i) {
-                let segment = TranscriptionSegment(
-                    startTime: startTime,
-                    endTime: endTime,
-                    text: String(cString: text)
-                )
-                segments.append(segment)
-            }
+        segments.reserveCapacity(Int(result.pointee.n_segments))
+
+        for i in 0..<Int(result.pointee.n_segments) {
+            let segment = result.pointee.segments[i]
+            let segmentText = segment.text.map { String(cString: $0) } ?? ""
+            text += segmentText
+            segments.append(TranscriptionSegment(
+                startTime: TimeInterval(segment.t0) / 100.0,
+                endTime: TimeInterval(segment.t1) / 100.0,
+                text: segmentText
+            ))
         }
 
-        return segments
-        */
+        let trimmed = text.trimmingCharacters(in: CharacterSet.whitespacesAndNewlines)
+        Logger.shared.info("Whisper raw result: \(segments.count) segments (trimmed length: \(trimmed.count))")
+
+        let language = whisper_bridge_lang_str(result.pointee.lang_id).map { String(cString: $0) }
+
+        var confidence: TranscriptionConfidence?
+        var aggregates = whisper_bridge_confidence()
+        if whisper_bridge_result_confidence(result, &aggregates) {
+            confidence = TranscriptionConfidence(
+                wordCount: Int(aggregates.n_words),
+                lowConfidenceWordCount: Int(aggregates.n_low_words),
+                averageLogProbability: aggregates.avg_logprob,
+                noSpeechProbability: aggregates.no_speech_prob,
+                enhanceScore: aggregates.enhance_score
+            )
+            Logger.shared.debug("Transcript confidence: \(aggregates.n_low_words)/\(aggregates.n_words) low words, enhance score \(String(format: "%.2f", aggregates.enhance_score))")
+        }
 
-        // Placeholder segments
-        return []
+        return BridgeTranscription(text: trimmed, segments: segments, detectedLanguage: language, confidence: confidence)
     }
 
-    private func getDetectedLanguage() -> String? {
-        // NOTE: Placeholder for language detection from whisper.cpp
-        // Actual: whisper_lang_str(whisper_full_lang_id(whisperContext))
-        return "en"
+    /// Build initial_prompt from custom vocabulary
+    private func buildInitialPrompt() -> String? {
+        let prefs = UserPreferences.load()
+        Logger.shared.info("Custom vocabulary count: \(prefs.customVocabulary.count)")
+        Logger.shared.info("Custom vocabulary words: \(prefs.customVocabulary)")
+
+        let initialPrompt = prefs.customVocabulary.isEmpty ? nil : prefs.customVocabulary.joined(separator: ", ")
+
+        if let prompt = initialPrompt {
+            Logger.shared.info("Using initial_prompt for Whisper: \(prompt)")
+        } else {
+            Logger.shared.info("No custom vocabulary - initial_prompt is nil")
+        }
+
+        return initialPrompt
     }
 
     private func getLanguageConfidence() -> Float {
@@ -300,6 +742,16 @@ final class WhisperService: WhisperServiceProtocol {
     }
 
     private func unloadModel() {
+        // Cancels the engine's jobs and waits for their completions
+        if let engine = engine {
+            whisper_bridge_engine_free(engine)
+        }
+        engine = nil
+        if let fallback = fallbackContext {
+            whisper_bridge_free(fallback)
+        }
+        fallbackContext = nil
+        fallbackAttempted = false
         if let context = whisperContext {
             whisper_bridge_free(context)
         }
@@ -309,29 +761,68 @@ final class WhisperService: WhisperServiceProtocol {
         Logger.shared.info("Unloaded Whisper model")
     }
 
-    // MARK: - Audio Conversion
+    // MARK: - Cleanup
 
-    private func convertPCM16ToFloat(_ data: Data) -> [Float] {
-        let sampleCount = data.count / MemoryLayout<Int16>.size
-        var floatSamples = [Float](repeating: 0, count: sampleCount)
+    deinit {
+        powerObservers.forEach { NotificationCenter.default.removeObserver($0) }
+        if isModelLoaded {
+            unloadModel()
+        }
+    }
+}
 
-        data.withUnsafeBytes { bytes in
-            guard let baseAddress = bytes.baseAddress?.assumingMemoryBound(to: Int16.self) else { return }
+// MARK: - Cancellation
 
-            for i in 0..<sampleCount {
-                // Convert Int16 (-32768 to 32767) to Float (-1.0 to 1.0)
-                floatSamples[i] = Float(baseAddress[i]) / Float(Int16.max)
-            }
-        }
+/// Cancellation flag of one transcription: the bridge checks it between the graph ops of the encoder
+/// and between decoding steps, so a cancelled transcription stops within milliseconds
+final class TranscriptionCancellation {
+    fileprivate let handle: OpaquePointer?
 
-        return floatSamples
+    init() {
+        handle = whisper_bridge_cancel_new()
     }
 
-    // MARK: - Cleanup
-
     deinit {
-        if isModelLoaded {
-            unloadModel()
-        }
+        whisper_bridge_cancel_free(handle)
+    }
+
+    func cancel() {
+        whisper_bridge_cancel_request(handle)
+    }
+
+    var isCancelled: Bool {
+        whisper_bridge_cancel_requested(handle)
+    }
+}
+
+// MARK: - Bridge Result
+
+/// Transcript and segments copied out of a whisper_bridge_result
+private struct BridgeTranscription {
+    let text: String
+    let segments: [TranscriptionSegment]
+    let detectedLanguage: String?
+    let confidence: TranscriptionConfidence?
+}
+
+// MARK: - Engine Job Box
+
+/// Carries the completion of an engine job through the bridge's C callback
+private final class EngineJobBox {
+    let handler: (Int64, Int32, UnsafeMutablePointer<whisper_bridge_result>?) -> Void
+
+    init(handler: @escaping (Int64, Int32, UnsafeMutablePointer<whisper_bridge_result>?) -> Void) {
+        self.handler = handler
+    }
+}
+
+// MARK: - Streaming Callback Box
+
+/// Carries the partial-result closure through the bridge's C callback
+private final class StreamCallbackBox {
+    let handler: (String) -> Void
+
+    init(handler: @escaping (String) -> Void) {
+        self.handler = handler
     }
 }
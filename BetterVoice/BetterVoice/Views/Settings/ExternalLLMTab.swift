@@ -27,15 +27,24 @@ struct ExternalLLMTab: View {
                     )) {
                         Text("Claude").tag("claude")
                         Text("OpenAI").tag("openai")
+                        Text("Local").tag("local")
                     }
 
-                    SecureField("API Key:", text: $apiKey)
-                        .textFieldStyle(.roundedBorder)
+                    if preferencesStore.preferences.externalLLMProvider == "local" {
+                        Text(LocalLLMClient.shared.isModelAvailable
+                             ? "Using the local model"
+                             : "Place a GGUF model at \(ModelStorage.shared.getLocalLLMPath().path)")
+                            .font(.caption)
+                            .foregroundColor(.secondary)
+                    } else {
+                        SecureField("API Key:", text: $apiKey)
+                            .textFieldStyle(.roundedBorder)
 
-                    Button("Save API Key") {
-                        saveAPIKey()
+                        Button("Save API Key") {
+                            saveAPIKey()
+                        }
+                        .disabled(apiKey.isEmpty)
                     }
-                    .disabled(apiKey.isEmpty)
                 }
             }
 
@@ -7,57 +7,240 @@
 
 #include "WhisperBridge.h"
 #include "../whisper.cpp/include/whisper.h"
+#include "../whisper.cpp/examples/audio-ring.h"
+#include "../whisper.cpp/examples/always-listen.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
-extern "C" {
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-whisper_context* whisper_bridge_init(const char* model_path) {
-    struct whisper_context_params cparams = whisper_context_default_params();
-    // Enable GPU but disable flash attention to avoid Metal decoder bug
-    cparams.use_gpu = true;
-    cparams.flash_attn = false;
-    fprintf(stderr, "whisper_bridge_init: GPU enabled, flash attention disabled\n");
-    return whisper_init_from_file_with_params(model_path, cparams);
+// Per-call diagnostics (audio scans, per-segment dumps) are only compiled into
+// debug builds or when WHISPER_BRIDGE_DIAGNOSTICS is defined; release builds
+// keep just the cheap timing summary, selectable at runtime.
+#if defined(DEBUG) || defined(WHISPER_BRIDGE_DIAGNOSTICS)
+#define WHISPER_BRIDGE_DIAG 1
+#endif
+
+static std::atomic<int> g_verbosity{1};
+
+#define BRIDGE_LOG(level, ...) \
+    do { if (g_verbosity.load(std::memory_order_relaxed) >= (level)) fprintf(stderr, __VA_ARGS__); } while (0)
+
+#ifdef WHISPER_BRIDGE_DIAG
+#define BRIDGE_DIAG(...) BRIDGE_LOG(2, __VA_ARGS__)
+#else
+#define BRIDGE_DIAG(...) ((void) 0)
+#endif
+
+namespace {
+
+// Contextual biasing phrases of a context, see whisper_full_params.bias_phrases
+struct bias_list {
+    std::vector<std::string> phrases;
+    std::vector<const char*> ptrs;
+    std::vector<float> weights;
+};
+
+// Per-context bridge bookkeeping. Each idle state owns its own KV caches and
+// scheduler buffers, so handing out a pre-built one skips that allocation on
+// the transcription path and lets several transcriptions run side by side.
+struct bridge_context {
+    std::vector<whisper_state*> idle;
+    whisper_bridge_params params = whisper_bridge_default_params();
+    std::string rpc_encoder; // owns params.rpc_encoder
+    std::string denoise_model; // owns params.denoise_model
+
+    // Model of params.denoise_model, attached to the context for whisper_full and copied by each stream
+    whisper_denoise_context* denoise = nullptr;
+
+    // Replaced, never modified, so a transcription keeps the list it started with
+    std::shared_ptr<const bias_list> bias;
+
+    // Float staging buffer per state for PCM16 input, reused across calls
+    std::unordered_map<whisper_state*, std::vector<float>> pcm_buffers;
+
+    // Smaller model of whisper_bridge_set_fallback_model, not owned
+    whisper_context* fallback = nullptr;
+};
+
+std::mutex g_pool_mutex;
+std::unordered_map<whisper_context*, bridge_context> g_contexts;
+
+// Number of performance cores - E-cores only slow down the encoder's parallel matmuls
+int performance_core_count() {
+#ifdef __APPLE__
+    int n_cores = 0;
+    size_t size = sizeof(n_cores);
+    if (sysctlbyname("hw.perflevel0.physicalcpu", &n_cores, &size, nullptr, 0) == 0 && n_cores > 0) {
+        return n_cores;
+    }
+#endif
+    return std::max(1, (int) std::thread::hardware_concurrency());
 }
 
-void whisper_bridge_free(whisper_context* ctx) {
-    if (ctx) {
-        whisper_free(ctx);
+int physical_memory_mb() {
+#ifdef __APPLE__
+    uint64_t memsize = 0;
+    size_t size = sizeof(memsize);
+    if (sysctlbyname("hw.memsize", &memsize, &size, nullptr, 0) == 0) {
+        return (int) (memsize / (1000 * 1000));
     }
+#endif
+    return 0;
 }
 
-char* whisper_bridge_transcribe(
+std::mutex g_policy_mutex;
+whisper_bridge_policy g_policy = {};
+
+// Policy of a thermal state and power source. Each level roughly halves the compute of the one
+// before: fewer threads first, then the efficiency cores and smaller encodes, then the small model
+whisper_bridge_policy policy_for(int thermal_state, bool on_battery) {
+    whisper_bridge_policy policy = {};
+    policy.thermal_state = thermal_state;
+    policy.on_battery    = on_battery;
+    policy.level         = std::max(std::min(thermal_state, 3), on_battery ? 1 : 0);
+
+    const int n_cores = performance_core_count();
+    switch (policy.level) {
+        case 3:
+            policy.no_fallback        = true;
+            policy.use_fallback_model = true;
+            policy.max_threads        = std::max(1, n_cores/4);
+            [[fallthrough]];
+        case 2:
+            policy.efficiency_cores = true;
+            policy.small_audio_ctx  = true;
+            policy.max_candidates   = 1;
+            if (!policy.max_threads) {
+                policy.max_threads = std::max(1, n_cores/2);
+            }
+            break;
+        case 1:
+            policy.max_candidates = 2;
+            policy.max_threads    = std::max(1, n_cores*3/4);
+            break;
+        default:
+            break;
+    }
+    return policy;
+}
+
+whisper_bridge_policy current_policy() {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    return g_policy;
+}
+
+// Limit the decoding params of a transcription to policy
+void apply_policy(whisper_full_params& params, const whisper_bridge_policy& policy) {
+    if (policy.max_threads > 0) {
+        params.n_threads = std::min(params.n_threads, policy.max_threads);
+    }
+    if (policy.small_audio_ctx && params.audio_ctx == 0) {
+        params.audio_ctx = -1;
+    }
+    if (policy.max_candidates > 0) {
+        params.greedy.best_of         = std::min(params.greedy.best_of, policy.max_candidates);
+        params.beam_search.beam_size  = std::min(params.beam_search.beam_size, policy.max_candidates);
+    }
+    if (policy.no_fallback) {
+        params.temperature_inc = 0.0f;
+    }
+}
+
+// QoS class of a worker thread about to transcribe
+void set_job_qos(bool interactive) {
+    if (interactive && !current_policy().efficiency_cores) {
+        always_listen_set_interactive_qos();
+    } else {
+        always_listen_set_efficiency_qos();
+    }
+}
+
+whisper_bridge_params context_params(whisper_context* ctx) {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    return g_contexts[ctx].params;
+}
+
+std::shared_ptr<const bias_list> context_bias(whisper_context* ctx) {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    return g_contexts[ctx].bias;
+}
+
+void set_bias(whisper_full_params& params, const bias_list* bias) {
+    if (bias) {
+        params.bias_phrases = bias->ptrs.data();
+        params.bias_weights = bias->weights.data();
+        params.n_bias_phrases = (int) bias->ptrs.size();
+    }
+}
+
+bool cancel_abort(void* user_data) {
+    return whisper_bridge_cancel_requested(static_cast<whisper_bridge_cancel*>(user_data));
+}
+
+bool cancel_encoder_begin(whisper_context* /*ctx*/, whisper_state* /*state*/, void* user_data) {
+    return !cancel_abort(user_data);
+}
+
+// Run whisper_full on state with the bridge's decoding parameters
+// Returns WHISPER_BRIDGE_STATUS_CANCELLED if cancel stopped it
+// n_threads overrides the context's thread count when > 0
+int run_full(
     whisper_context* ctx,
+    whisper_state* state,
     const float* audio_data,
     int audio_length,
     const char* language,
     bool translate,
-    const char* initial_prompt
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel = nullptr,
+    int n_threads = 0
 ) {
-    if (!ctx || !audio_data || audio_length <= 0) {
-        fprintf(stderr, "whisper_bridge: Invalid input - ctx=%p, audio_data=%p, audio_length=%d\n",
-                ctx, audio_data, audio_length);
-        return nullptr;
+#ifdef WHISPER_BRIDGE_DIAG
+    if (g_verbosity.load(std::memory_order_relaxed) >= 2) {
+        float max_val = 0.0f;
+        float sum = 0.0f;
+        for (int i = 0; i < audio_length; i++) {
+            float abs_val = audio_data[i] < 0 ? -audio_data[i] : audio_data[i];
+            if (abs_val > max_val) max_val = abs_val;
+            sum += abs_val;
+        }
+        fprintf(stderr, "whisper_bridge: audio stats - length=%d, max=%.6f, avg=%.6f\n",
+                audio_length, max_val, sum / audio_length);
     }
+#endif
 
-    // Debug: Check audio data statistics
-    float max_val = 0.0f;
-    float sum = 0.0f;
-    for (int i = 0; i < audio_length; i++) {
-        float abs_val = audio_data[i] < 0 ? -audio_data[i] : audio_data[i];
-        if (abs_val > max_val) max_val = abs_val;
-        sum += abs_val;
-    }
-    float avg_val = sum / audio_length;
-    fprintf(stderr, "whisper_bridge: audio stats - length=%d, max=%.6f, avg=%.6f\n",
-            audio_length, max_val, avg_val);
+    const whisper_bridge_params bparams = context_params(ctx);
 
-    // Use default parameters with critical settings
-    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    // Use default parameters with critical settings, or the dictation preset for a clip of one window
+    const bool dictation = bparams.dictation && audio_length <= 30*WHISPER_SAMPLE_RATE;
+
+    struct whisper_full_params params = dictation ? whisper_full_dictation_params(audio_length) : whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
 
     // Set n_threads - CRITICAL! (from cli.cpp example)
-    params.n_threads = 4;
+    params.n_threads = n_threads > 0 ? n_threads : bparams.n_threads;
+    params.audio_ctx = bparams.audio_ctx;
 
     // Set language and basic params
     params.language = "en";
@@ -65,103 +248,2457 @@ char* whisper_bridge_transcribe(
     params.print_progress = false;
     params.print_special = false;
 
-    fprintf(stderr, "whisper_bridge: Using default parameters with n_threads=%d\n", params.n_threads);
-
     if (language) {
         params.language = language;
     }
+    // with language "auto", detect it on the first 3 s of speech instead of a full 30 s encode
+    params.lang_detect_ms = 3000;
     if (initial_prompt) {
         params.initial_prompt = initial_prompt;
     }
 
-    // Run transcription
-    fprintf(stderr, "whisper_bridge: calling whisper_full()...\n");
-    int result = whisper_full(ctx, params, audio_data, audio_length);
-    fprintf(stderr, "whisper_bridge: whisper_full() returned: %d\n", result);
+    const auto bias = context_bias(ctx);
+    set_bias(params, bias.get());
 
-    // Debug: Check mel spectrogram length
-    int n_len = whisper_n_len(ctx);
-    fprintf(stderr, "whisper_bridge: mel spectrogram length (n_len) = %d\n", n_len);
+    // The context has the denoise model attached, each state runs its own copy
+    params.denoise = bparams.denoise_model != nullptr;
 
-    // Debug: Try language detection to verify encoder worked
-    if (n_len > 0) {
-        float lang_probs[100];
-        int lang_id = whisper_lang_auto_detect(ctx, 0, 1, lang_probs);
-        if (lang_id >= 0) {
-            const char* lang_str = whisper_lang_str(lang_id);
-            fprintf(stderr, "whisper_bridge: detected language: %s (id=%d, prob=%.3f)\n",
-                    lang_str ? lang_str : "unknown", lang_id, lang_probs[lang_id]);
-        } else {
-            fprintf(stderr, "whisper_bridge: language detection failed: %d\n", lang_id);
+    apply_policy(params, current_policy());
+
+    if (cancel) {
+        params.encoder_begin_callback           = cancel_encoder_begin;
+        params.encoder_begin_callback_user_data = cancel;
+        params.abort_callback                   = cancel_abort;
+        params.abort_callback_user_data         = cancel;
+    }
+
+    // Counters are per state; reset them so the summary covers this call only
+    whisper_reset_timings_from_state(state);
+
+    const auto t_start = std::chrono::steady_clock::now();
+    int result = whisper_full_with_state(ctx, state, params, audio_data, audio_length);
+    // whisper_full stops with the partial result when encoder_begin_callback refuses the next window
+    if (whisper_bridge_cancel_requested(cancel)) {
+        result = WHISPER_BRIDGE_STATUS_CANCELLED;
+    }
+    const double t_total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+
+    if (g_verbosity.load(std::memory_order_relaxed) >= 1) {
+        whisper_timings* timings = whisper_get_timings_from_state(state);
+        fprintf(stderr, "whisper_bridge: %d samples in %.1f ms (encode %.1f ms, decode %.2f ms/run, sample %.2f ms/run), result=%d\n",
+                audio_length, t_total_ms, timings->encode_ms, timings->decode_ms, timings->sample_ms, result);
+        delete timings;
+    }
+
+    BRIDGE_DIAG("whisper_bridge: n_threads=%d, mel length=%d, lang=%s\n",
+                params.n_threads, whisper_n_len_from_state(state),
+                whisper_lang_str(whisper_full_lang_id_from_state(state)));
+
+    return result;
+}
+
+// Largest |sample| of a PCM16 buffer (-32768 saturates to 32767)
+int16_t pcm16_peak(const int16_t* pcm, int n_samples) {
+    int i = 0;
+    int16_t peak = 0;
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    int16x8_t vpeak = vdupq_n_s16(0);
+    for (; i + 8 <= n_samples; i += 8) {
+        vpeak = vmaxq_s16(vpeak, vqabsq_s16(vld1q_s16(pcm + i)));
+    }
+    peak = vmaxvq_s16(vpeak);
+#endif
+
+    for (; i < n_samples; i++) {
+        const int v = pcm[i] < 0 ? -(int) pcm[i] : (int) pcm[i];
+        peak = (int16_t) std::max((int) peak, std::min(v, 32767));
+    }
+
+    return peak;
+}
+
+// out[i] = pcm[i]*scale - int16 -> float conversion and gain fused in one pass
+void pcm16_to_f32_scaled(const int16_t* pcm, int n_samples, float scale, float* out) {
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; i + 8 <= n_samples; i += 8) {
+        const int16x8_t v = vld1q_s16(pcm + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(out + i,     vmulq_f32(lo, vscale));
+        vst1q_f32(out + i + 4, vmulq_f32(hi, vscale));
+    }
+#endif
+
+    for (; i < n_samples; i++) {
+        out[i] = pcm[i]*scale;
+    }
+}
+
+// Number of frames in n_bytes of audio in format, -1 if the bridge can't take it as is
+int audio_n_frames(const whisper_bridge_audio_format& format, size_t n_bytes, const char* tag) {
+    const size_t sample_size = format.encoding == WHISPER_BRIDGE_AUDIO_PCM16 ? sizeof(int16_t) :
+                               format.encoding == WHISPER_BRIDGE_AUDIO_F32   ? sizeof(float)   : 0;
+    if (sample_size == 0 || format.n_channels < 1) {
+        fprintf(stderr, "%s: unsupported audio format - encoding=%d, n_channels=%d\n", tag, format.encoding, format.n_channels);
+        return -1;
+    }
+    if (format.sample_rate <= 0) {
+        fprintf(stderr, "%s: invalid sample rate %d Hz\n", tag, format.sample_rate);
+        return -1;
+    }
+
+    const size_t frame_size = sample_size*format.n_channels;
+    if (n_bytes == 0 || n_bytes % frame_size != 0 || n_bytes/frame_size > (size_t) INT32_MAX) {
+        fprintf(stderr, "%s: %zu bytes are not a whole number of %zu-byte frames\n", tag, n_bytes, frame_size);
+        return -1;
+    }
+
+    return (int) (n_bytes/frame_size);
+}
+
+// Mono float samples of n_frames of audio in format, peak normalized to target_peak (0 = none)
+void audio_to_f32(const void* data, int n_frames, const whisper_bridge_audio_format& format, float target_peak, float* out) {
+    const bool pcm16 = format.encoding == WHISPER_BRIDGE_AUDIO_PCM16;
+
+    if (pcm16 && format.n_channels == 1) {
+        // Peak normalization needs the peak up front: one scan of the int16 data, then a
+        // fused convert + gain pass straight into out
+        const int16_t* pcm = (const int16_t*) data;
+        float scale = 1.0f/32767.0f;
+        if (target_peak > 0.0f) {
+            const float peak = pcm16_peak(pcm, n_frames)/32767.0f;
+            if (peak > 0.001f) { // Only normalize if there's actual audio
+                scale *= target_peak/peak;
+            }
         }
+        pcm16_to_f32_scaled(pcm, n_frames, scale, out);
+        return;
     }
 
-    if (result != 0) {
-        fprintf(stderr, "whisper_full failed with result: %d\n", result);
-        char error_msg[100];
-        snprintf(error_msg, sizeof(error_msg), "[DEBUG:whisper_full_failed:%d]", result);
-        char* result_str = (char*)malloc(strlen(error_msg) + 1);
-        if (result_str) strcpy(result_str, error_msg);
-        return result_str;
+    // Float or multi-channel audio: downmix first, the peak is the one of the mix
+    const int n_channels = format.n_channels;
+    const float scale = (pcm16 ? 1.0f/32767.0f : 1.0f)/n_channels;
+    float peak = 0.0f;
+    for (int i = 0; i < n_frames; i++) {
+        float sum = 0.0f;
+        for (int c = 0; c < n_channels; c++) {
+            sum += pcm16 ? (float) ((const int16_t*) data)[i*n_channels + c] : ((const float*) data)[i*n_channels + c];
+        }
+        out[i] = sum*scale;
+        peak = std::max(peak, std::fabs(out[i]));
+    }
+
+    if (target_peak > 0.0f && peak > 0.001f) {
+        const float gain = target_peak/peak;
+        for (int i = 0; i < n_frames; i++) {
+            out[i] *= gain;
+        }
     }
+}
+
+// audio_to_f32 for a rate other than 16 kHz: the frames go through the whisper resampler into out, resized to the
+// number of 16 kHz samples. Returns false for a rate the resampler does not support
+bool audio_resample_f32(const void* data, int n_frames, const whisper_bridge_audio_format& format, float target_peak, std::vector<float>& out) {
+    whisper_resampler* rs = whisper_resampler_init(format.sample_rate, format.n_channels,
+        format.encoding == WHISPER_BRIDGE_AUDIO_PCM16 ? WHISPER_SAMPLE_FORMAT_S16 : WHISPER_SAMPLE_FORMAT_F32);
+    if (!rs) {
+        return false;
+    }
+
+    out.resize(whisper_resampler_n_out(rs, n_frames));
 
-    // Collect all segments into single string
-    const int n_segments = whisper_full_n_segments(ctx);
-    fprintf(stderr, "whisper_bridge: n_segments = %d\n", n_segments);
+    const int n = whisper_resample_to_16k(rs, data, n_frames, out.data(), (int) out.size());
+    const int n_tail = n < 0 ? -1 : whisper_resampler_flush(rs, out.data() + n, (int) out.size() - n);
+    whisper_resampler_free(rs);
+    if (n_tail < 0) {
+        return false;
+    }
+
+    out.resize(n + n_tail);
 
-    // Check if context has state
-    if (ctx == nullptr) {
-        fprintf(stderr, "whisper_bridge: ERROR - ctx is null after whisper_full\n");
+    float peak = 0.0f;
+    for (const float v : out) {
+        peak = std::max(peak, std::fabs(v));
     }
 
-    // If no segments, return diagnostic string
-    if (n_segments == 0) {
-        const char* debug_msg = "[DEBUG:n_segments=0]";
-        char* result = (char*)malloc(strlen(debug_msg) + 1);
-        if (result) {
-            strcpy(result, debug_msg);
+    if (target_peak > 0.0f && peak > 0.001f) {
+        const float gain = target_peak/peak;
+        for (float& v : out) {
+            v *= gain;
         }
+    }
+
+    return true;
+}
+
+char* copy_c_string(const std::string& str) {
+    char* out = (char*)malloc(str.size() + 1);
+    if (out) {
+        memcpy(out, str.c_str(), str.size() + 1);
+    }
+    return out;
+}
+
+// Wrap the outcome of run_full on state into a result that keeps the state checked out
+whisper_bridge_result* collect_result(whisper_context* ctx, whisper_state* state, int status) {
+    whisper_bridge_result* result = (whisper_bridge_result*)calloc(1, sizeof(whisper_bridge_result));
+    if (!result) {
+        whisper_bridge_release_state(ctx, state);
+        return nullptr;
+    }
+
+    // The segment texts point into the state, so it stays checked out until the result is freed
+    result->ctx = ctx;
+    result->state = state;
+    result->status = status;
+
+    if (result->status == WHISPER_BRIDGE_STATUS_CANCELLED) {
+        BRIDGE_LOG(1, "whisper_bridge: transcription cancelled\n");
+        return result;
+    }
+    if (result->status != 0) {
+        fprintf(stderr, "whisper_full failed with result: %d\n", result->status);
         return result;
     }
 
-    // Debug: Check no_speech probability for each segment
+    result->lang_id = whisper_full_lang_id_from_state(state);
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+
+    int n_tokens = 0;
     for (int i = 0; i < n_segments; i++) {
-        float no_speech_prob = whisper_full_get_segment_no_speech_prob(ctx, i);
-        fprintf(stderr, "whisper_bridge: segment %d no_speech_prob = %.3f\n", i, no_speech_prob);
+        n_tokens += whisper_full_n_tokens_from_state(state, i);
     }
 
-    size_t total_length = 0;
+    whisper_bridge_segment* segments = n_segments > 0 ? (whisper_bridge_segment*)malloc(n_segments*sizeof(whisper_bridge_segment)) : nullptr;
+    whisper_bridge_token*   tokens   = n_tokens   > 0 ? (whisper_bridge_token*)  malloc(n_tokens  *sizeof(whisper_bridge_token))   : nullptr;
+    if ((n_segments > 0 && !segments) || (n_tokens > 0 && !tokens)) {
+        free(segments);
+        free(tokens);
+        whisper_bridge_result_free(result);
+        return nullptr;
+    }
 
-    // Calculate total length
+    int i_token = 0;
     for (int i = 0; i < n_segments; i++) {
-        const char* text = whisper_full_get_segment_text(ctx, i);
-        if (text) {
-            total_length += strlen(text);
+        whisper_bridge_segment& segment = segments[i];
+        segment.text           = whisper_full_get_segment_text_from_state(state, i);
+        segment.t0             = whisper_full_get_segment_t0_from_state(state, i);
+        segment.t1             = whisper_full_get_segment_t1_from_state(state, i);
+        segment.no_speech_prob = whisper_full_get_segment_no_speech_prob_from_state(state, i);
+        segment.token_offset   = i_token;
+        segment.n_tokens       = whisper_full_n_tokens_from_state(state, i);
+
+        for (int j = 0; j < segment.n_tokens; j++) {
+            const whisper_token_data data = whisper_full_get_token_data_from_state(state, i, j);
+            whisper_bridge_token& token = tokens[i_token++];
+            token.id   = data.id;
+            token.p    = data.p;
+            token.plog = data.plog;
+            token.t0   = data.t0;
+            token.t1   = data.t1;
+        }
+    }
+
+    result->n_segments = n_segments;
+    result->segments   = segments;
+    result->n_tokens   = n_tokens;
+    result->tokens     = tokens;
+
+    return result;
+}
+
+// whisper_bridge_transcribe_audio on n_frames > 0 frames, with the thread count of run_full
+whisper_bridge_result* transcribe_audio(
+    whisper_context* ctx,
+    const void* data,
+    int n_frames,
+    const whisper_bridge_audio_format& format,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel,
+    int n_threads = 0
+) {
+    if (current_policy().use_fallback_model) {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        if (whisper_context* fallback = g_contexts[ctx].fallback) {
+            ctx = fallback;
         }
     }
 
-    // Allocate result buffer
-    char* result_text = (char*)malloc(total_length + 1);
-    if (!result_text) {
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        fprintf(stderr, "whisper_bridge: no decoding state available\n");
         return nullptr;
     }
 
-    // Concatenate segments
-    result_text[0] = '\0';
-    for (int i = 0; i < n_segments; i++) {
-        const char* text = whisper_full_get_segment_text(ctx, i);
-        if (text) {
-            fprintf(stderr, "whisper_bridge: segment %d: '%s'\n", i, text);
-            strcat(result_text, text);
+    // Only this caller uses the state's buffer until the state goes back to the pool
+    std::vector<float>* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        buffer = &g_contexts[ctx].pcm_buffers[state];
+    }
+    if (format.sample_rate == WHISPER_SAMPLE_RATE) {
+        buffer->resize(n_frames);
+        audio_to_f32(data, n_frames, format, target_peak, buffer->data());
+    } else if (!audio_resample_f32(data, n_frames, format, target_peak, *buffer)) {
+        fprintf(stderr, "whisper_bridge: cannot resample audio at %d Hz\n", format.sample_rate);
+        whisper_bridge_release_state(ctx, state);
+        return nullptr;
+    }
+
+    const int status = run_full(ctx, state, buffer->data(), (int) buffer->size(), language, translate, initial_prompt, cancel, n_threads);
+    return collect_result(ctx, state, status);
+}
+
+} // namespace
+
+// Rolling-window streaming session, modeled on examples/stream/stream.cpp:
+// every step_ms of new audio the last length_ms (plus keep_ms of overlap) is
+// re-decoded, and every length_ms/step_ms steps the window text is committed.
+// The window lives in the state's incremental mel cache, so each step only
+// computes log-mel frames for the newly pushed audio.
+struct whisper_bridge_stream {
+    whisper_context* ctx = nullptr;
+    whisper_state* state = nullptr;
+
+    std::string language;
+    std::string initial_prompt;
+    bool translate = false;
+    whisper_bridge_params params = whisper_bridge_default_params();
+
+    int n_samples_step = 0;
+    int n_samples_len = 0;
+    int n_samples_keep = 0;
+    int n_new_line = 1;
+
+    whisper_bridge_partial_callback callback = nullptr;
+    void* user_data = nullptr;
+
+    // Pushed audio, written by whisper_bridge_stream_push without locking so the
+    // capture thread never waits for the worker
+    audio_ring ring;
+
+    // Copy of the context's denoise model with its own GRU state, NULL without noise suppression.
+    // Owned by the worker thread like pos_read
+    whisper_denoise_context* denoise = nullptr;
+    std::vector<float> denoised;
+
+    // Guarded by mutex
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string committed;       // text of finished windows
+    std::string partial;         // text of the window currently being refined
+    bool stopping = false;
+
+    // Owned by the worker thread (and by stream_end after the join)
+    uint64_t pos_read = 0;       // ring position of the first sample not yet decoded
+    uint64_t n_mel_pcm = 0;      // samples appended to the mel cache
+    std::string window_text;
+    int n_iter = 0;
+    std::thread worker;
+
+    // Two-pass session: the committed windows are decoded again by a larger model from a copy of the mel cache
+    whisper_context* ctx_final = nullptr;
+    whisper_state* state_final = nullptr;
+    std::condition_variable final_cv;
+    std::thread final_worker;
+
+    // Guarded by mutex
+    std::string final_text;      // text of the audio before final_pos
+    uint64_t final_pos = 0;
+    uint64_t final_end = 0;      // end of the window copied to state_final, decoded while final_busy
+    bool final_busy = false;
+};
+
+// Always-on listening session: the pushed audio runs through the streaming VAD on a
+// worker thread at the utility QoS, and whisper only wakes for closed speech windows.
+// The pooled state is checked out just for the transcription of a window, so its
+// threadpool stays parked while the session only listens.
+struct whisper_bridge_listener {
+    whisper_context* ctx = nullptr;
+    whisper_vad_context* vctx = nullptr;
+
+    std::string language;
+    std::string initial_prompt;
+    bool translate = false;
+
+    whisper_bridge_speech_callback callback = nullptr;
+    void* user_data = nullptr;
+
+    // Pushed audio, written without locking like whisper_bridge_stream::ring
+    audio_ring ring;
+
+    // Guarded by mutex
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unique_ptr<always_listen> listen;
+    bool stopping = false;
+
+    // Owned by the worker thread
+    uint64_t pos_read = 0;
+    std::thread worker;
+};
+
+struct whisper_bridge_cancel {
+    std::atomic<bool> requested{false};
+};
+
+struct whisper_bridge_preload_task {
+    std::string model_path;
+    whisper_bridge_params params;
+    std::string rpc_encoder; // owns params.rpc_encoder, the caller's string may be gone when the worker runs
+    std::string denoise_model; // owns params.denoise_model
+
+    // Written by the worker before done is set
+    whisper_context* ctx = nullptr;
+    std::atomic<bool> done{false};
+    std::thread worker;
+};
+
+// A model of whisper_bridge_models, resident once its load is joined
+struct bridge_model_entry {
+    whisper_context* ctx = nullptr;
+    // Background load, joined by the first acquire that needs the context
+    whisper_bridge_preload_task* loading = nullptr;
+    bool joining = false;
+    // Acquires not released yet, also held while waiting for the load so that the entry is not evicted
+    int refs = 0;
+    uint64_t last_used = 0;
+    // whisper_memory_estimate of the model and one state
+    size_t mem = 0;
+};
+
+struct whisper_bridge_models {
+    size_t budget = 0;
+
+    std::mutex mutex;
+    // Signaled when a load is joined
+    std::condition_variable loaded;
+    uint64_t tick = 0;
+    std::unordered_map<std::string, bridge_model_entry> entries;
+};
+
+struct whisper_bridge_capture {
+    std::unique_ptr<int16_t[]> samples; // not value-initialized, so untouched pages are never committed
+    int max_samples = 0;
+
+    // Samples before n_samples are written; stored with release after them
+    std::atomic<int> n_samples{0};
+    std::atomic<int64_t> n_dropped{0};
+};
+
+// A transcription queued on an engine, see whisper_bridge_engine_submit
+struct bridge_job {
+    int64_t id = 0;
+    int priority = WHISPER_BRIDGE_PRIORITY_BACKGROUND;
+    std::vector<uint8_t> data;
+    whisper_bridge_audio_format format = {};
+    int n_frames = 0;
+    float target_peak = 0.0f;
+    std::string language;
+    bool has_language = false;
+    bool translate = false;
+    std::string initial_prompt;
+    bool has_prompt = false;
+    whisper_bridge_job_callback callback = nullptr;
+    void* user_data = nullptr;
+
+    // Stops the run on preemption as well as on whisper_bridge_engine_cancel,
+    // cancelled tells them apart (guarded by the engine mutex)
+    whisper_bridge_cancel run_cancel;
+    bool cancelled = false;
+};
+
+struct whisper_bridge_engine {
+    whisper_context* ctx = nullptr;
+    int n_workers = 1;
+    int max_queued = 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<bridge_job>> queued[2]; // by priority, FIFO within one
+    std::vector<std::shared_ptr<bridge_job>> running;
+    int n_running_background = 0;
+    int64_t next_id = 1;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+};
+
+namespace {
+
+void stream_on_new_segment(whisper_context* /*ctx*/, whisper_state* state, int n_new, void* user_data) {
+    whisper_bridge_stream* stream = (whisper_bridge_stream*)user_data;
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = n_segments - n_new; i < n_segments; i++) {
+        stream->window_text += whisper_full_get_segment_text_from_state(state, i);
+    }
+
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->partial = stream->window_text;
+        text = stream->committed + stream->partial;
+    }
+
+    if (stream->callback) {
+        stream->callback(text.c_str(), stream->user_data);
+    }
+}
+
+// Hand the audio since final_pos to the final worker as a copy of the mel cache; skipped while it is still decoding,
+// the next commit then covers both windows
+void stream_final_submit(whisper_bridge_stream* stream) {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (stream->final_busy || stream->n_mel_pcm <= stream->final_pos) {
+        return;
+    }
+
+    // the same overlap with the previous window as the partial pass
+    const uint64_t n_keep = stream->n_mel_pcm - stream->final_pos + (stream->final_pos > 0 ? stream->n_samples_keep : 0);
+    if (whisper_mel_cache_copy_with_state(stream->state, stream->state_final, (int) std::min<uint64_t>(n_keep, 30*WHISPER_SAMPLE_RATE)) != 0) {
+        return;
+    }
+
+    stream->final_end  = stream->n_mel_pcm;
+    stream->final_busy = true;
+    stream->final_cv.notify_one();
+}
+
+// Decode the window copied to state_final with the final model
+void stream_final_decode(whisper_bridge_stream* stream) {
+    std::string prompt;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        // the end of the final text conditions the next window like the past text of a long transcription
+        prompt = stream->initial_prompt + stream->final_text.substr(stream->final_text.size() - std::min<size_t>(stream->final_text.size(), 512));
+    }
+
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads        = stream->params.n_threads;
+    params.language         = stream->language.c_str();
+    params.translate        = stream->translate;
+    params.print_progress   = false;
+    params.print_special    = false;
+    params.print_realtime   = false;
+    params.print_timestamps = false;
+    params.no_timestamps    = true;
+    params.no_context       = true;
+    params.initial_prompt   = prompt.empty() ? nullptr : prompt.c_str();
+
+    const auto bias = context_bias(stream->ctx_final);
+    set_bias(params, bias.get());
+
+    std::string text;
+    if (whisper_set_mel_with_state(stream->ctx_final, stream->state_final, nullptr, 0, whisper_model_n_mels(stream->ctx_final)) == 0 &&
+        whisper_full_with_state(stream->ctx_final, stream->state_final, params, nullptr, 0) == 0) {
+        const int n_segments = whisper_full_n_segments_from_state(stream->state_final);
+        for (int i = 0; i < n_segments; i++) {
+            text += whisper_full_get_segment_text_from_state(stream->state_final, i);
         }
+    } else {
+        fprintf(stderr, "whisper_bridge_stream: final pass failed on a window of %d samples\n",
+                whisper_mel_cache_n_samples_with_state(stream->state_final));
     }
 
-    fprintf(stderr, "whisper_bridge: final result (length %zu): '%s'\n", strlen(result_text), result_text);
-    return result_text;
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->final_text += text;
+    stream->final_pos   = stream->final_end;
+    stream->final_busy  = false;
 }
 
-bool whisper_bridge_is_valid(whisper_context* ctx) {
-    return ctx != nullptr;
+void stream_final_worker(whisper_bridge_stream* stream) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            stream->final_cv.wait(lock, [stream] { return stream->stopping || stream->final_busy; });
+            // a submitted window is decoded before stopping, stream_end continues after it
+            if (!stream->final_busy) {
+                break;
+            }
+        }
+
+        stream_final_decode(stream);
+    }
+}
+
+// Decode the current window extended with pcm_new; commits the window text every n_new_line steps or when final
+void stream_decode_step(whisper_bridge_stream* stream, const std::vector<float>& pcm_new, bool final) {
+    const int n_samples_new = (int) pcm_new.size();
+
+    // take up to length_ms audio from the previous iteration; keeping nothing restarts the cache
+    whisper_mel_cache_keep_with_state(stream->state,
+                                      std::max(0, stream->n_samples_keep + stream->n_samples_len - n_samples_new));
+
+    if (whisper_pcm_to_mel_append_with_state(stream->ctx, stream->state, pcm_new.data(), n_samples_new,
+                                             stream->params.n_threads) != 0 ||
+        whisper_set_mel_with_state(stream->ctx, stream->state, nullptr, 0, whisper_model_n_mels(stream->ctx)) != 0) {
+        fprintf(stderr, "whisper_bridge_stream: failed to compute mel for %d new samples\n", n_samples_new);
+        return;
+    }
+    stream->n_mel_pcm += n_samples_new;
+
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads        = stream->params.n_threads;
+    params.audio_ctx        = stream->params.audio_ctx;
+    params.language         = stream->language.c_str();
+    params.lang_detect_ms   = 3000;
+    params.translate        = stream->translate;
+    params.print_progress   = false;
+    params.print_special    = false;
+    params.print_realtime   = false;
+    params.print_timestamps = false;
+    params.no_timestamps    = true;
+    params.single_segment   = true;
+    params.no_context       = true;
+    params.max_tokens       = 0;
+    params.initial_prompt   = stream->initial_prompt.empty() ? nullptr : stream->initial_prompt.c_str();
+
+    const auto bias = context_bias(stream->ctx);
+    set_bias(params, bias.get());
+
+    params.new_segment_callback           = stream_on_new_segment;
+    params.new_segment_callback_user_data = stream;
+
+    stream->window_text.clear();
+
+    // samples == NULL: decode the spectrogram prepared from the mel cache above
+    if (whisper_full_with_state(stream->ctx, stream->state, params, nullptr, 0) != 0) {
+        fprintf(stderr, "whisper_bridge_stream: failed to process window of %d samples\n",
+                whisper_mel_cache_n_samples_with_state(stream->state));
+        return;
+    }
+
+    stream->n_iter++;
+
+    if (final || stream->n_iter % stream->n_new_line == 0) {
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->committed += stream->window_text;
+            stream->partial.clear();
+        }
+
+        if (stream->ctx_final) {
+            stream_final_submit(stream);
+        }
+
+        // keep part of the audio for the next iteration to try to mitigate word boundary issues
+        whisper_mel_cache_keep_with_state(stream->state, stream->n_samples_keep);
+    }
+}
+
+// Copy the audio pushed to ring since pos_read to pcm; the oldest is dropped if the reader fell a whole ring behind
+void ring_take(const audio_ring& ring, uint64_t& pos_read, std::vector<float>& pcm, const char* tag) {
+    while (true) {
+        const uint64_t end = ring.end();
+        if (end - pos_read > ring.capacity()) {
+            fprintf(stderr, "%s: decoding fell behind, dropping %llu samples\n", tag,
+                    (unsigned long long) (end - ring.capacity() - pos_read));
+            pos_read = end - ring.capacity();
+        }
+
+        pcm.resize(end - pos_read);
+        if (ring.read(pos_read, pcm.size(), pcm.data())) {
+            pos_read = end;
+            return;
+        }
+    }
+}
+
+// Take the audio pushed since the last call, denoised when the context has a denoise model.
+// The denoiser holds back the last hop until the next push, flush also returns it
+void stream_take(whisper_bridge_stream* stream, std::vector<float>& pcm, bool flush = false) {
+    ring_take(stream->ring, stream->pos_read, pcm, "whisper_bridge_stream");
+    if (!stream->denoise) {
+        return;
+    }
+
+    std::vector<float>& out = stream->denoised;
+    out.resize(pcm.size() + 320);
+
+    int n_out = whisper_denoise_stream_push(stream->denoise, pcm.data(), (int) pcm.size(), out.data());
+    if (n_out >= 0 && flush) {
+        const int n_flush = whisper_denoise_stream_flush(stream->denoise, out.data() + n_out);
+        n_out = n_flush < 0 ? -1 : n_out + n_flush;
+    }
+    if (n_out < 0) {
+        // The noisy audio still transcribes, only the suppression is lost for this step
+        fprintf(stderr, "whisper_bridge_stream: failed to denoise %zu samples\n", pcm.size());
+        whisper_denoise_stream_reset(stream->denoise);
+        return;
+    }
+
+    pcm.assign(out.begin(), out.begin() + n_out);
+}
+
+void stream_worker(whisper_bridge_stream* stream) {
+    std::vector<float> pcm_new;
+
+    while (true) {
+        {
+            // push does not take the mutex, so a wakeup can be missed - the timeout bounds the delay
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            stream->cv.wait_for(lock, std::chrono::milliseconds(20), [stream] {
+                return stream->stopping || stream->ring.end() - stream->pos_read >= (uint64_t) stream->n_samples_step;
+            });
+            if (stream->stopping) {
+                break;
+            }
+        }
+
+        if (stream->ring.end() - stream->pos_read < (uint64_t) stream->n_samples_step) {
+            continue;
+        }
+
+        stream_take(stream, pcm_new);
+        stream_decode_step(stream, pcm_new, false);
+    }
+}
+
+// VAD pass every 100 ms of pushed audio
+const int k_listen_step = WHISPER_SAMPLE_RATE/10;
+
+void listener_worker(whisper_bridge_listener* listener) {
+    always_listen_set_efficiency_qos();
+
+    std::vector<float> pcm_new;
+    std::vector<float> speech;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(listener->mutex);
+            listener->cv.wait_for(lock, std::chrono::milliseconds(100), [listener] {
+                return listener->stopping || listener->ring.end() - listener->pos_read >= (uint64_t) k_listen_step;
+            });
+            if (listener->stopping) {
+                break;
+            }
+        }
+
+        ring_take(listener->ring, listener->pos_read, pcm_new, "whisper_bridge_listen");
+        if (pcm_new.empty()) {
+            continue;
+        }
+
+        bool ready = false;
+        {
+            std::lock_guard<std::mutex> lock(listener->mutex);
+            if (!listener->listen->push(pcm_new.data(), (int) pcm_new.size())) {
+                fprintf(stderr, "whisper_bridge_listen: VAD failed on %zu samples\n", pcm_new.size());
+                continue;
+            }
+            ready = listener->listen->pop(speech);
+            if (ready) {
+                listener->listen->active_begin();
+            }
+        }
+
+        if (!ready) {
+            continue;
+        }
+
+        // The transcription is what the user waits for
+        set_job_qos(true);
+
+        whisper_state* state = whisper_bridge_acquire_state(listener->ctx);
+        if (state) {
+            char* text = whisper_bridge_transcribe_with_state(
+                listener->ctx, state, speech.data(), (int) speech.size(),
+                listener->language.c_str(), listener->translate,
+                listener->initial_prompt.empty() ? nullptr : listener->initial_prompt.c_str());
+
+            // Parks the threads of the state
+            whisper_bridge_release_state(listener->ctx, state);
+
+            if (text && text[0] && listener->callback) {
+                listener->callback(text, listener->user_data);
+            }
+            free(text);
+        }
+
+        always_listen_set_efficiency_qos();
+
+        std::lock_guard<std::mutex> lock(listener->mutex);
+        listener->listen->active_end();
+    }
+}
+
+// Background jobs only take a worker while another one stays free for interactive jobs
+int engine_max_background(const whisper_bridge_engine* engine) {
+    return std::max(1, engine->n_workers - 1);
+}
+
+// Next job for an idle worker, nullptr if none may start. Called with the engine mutex held
+std::shared_ptr<bridge_job> engine_pop(whisper_bridge_engine* engine) {
+    auto& interactive = engine->queued[WHISPER_BRIDGE_PRIORITY_INTERACTIVE];
+    auto& background  = engine->queued[WHISPER_BRIDGE_PRIORITY_BACKGROUND];
+
+    std::shared_ptr<bridge_job> job;
+    if (!interactive.empty()) {
+        job = interactive.front();
+        interactive.pop_front();
+    } else if (!background.empty() && engine->n_running_background < engine_max_background(engine)) {
+        job = background.front();
+        background.pop_front();
+        engine->n_running_background++;
+    }
+    return job;
+}
+
+void engine_worker(whisper_bridge_engine* engine) {
+    const int n_threads = context_params(engine->ctx).n_threads;
+
+    while (true) {
+        std::shared_ptr<bridge_job> job;
+        int n_threads_job = 0;
+        {
+            std::unique_lock<std::mutex> lock(engine->mutex);
+            engine->cv.wait(lock, [&] {
+                return engine->stopping || (job = engine_pop(engine)) != nullptr;
+            });
+            if (!job) {
+                break;
+            }
+            // A file job sharing the machine with a dictation gets half the cores
+            if (job->priority == WHISPER_BRIDGE_PRIORITY_BACKGROUND && !engine->running.empty()) {
+                n_threads_job = std::max(1, n_threads/2);
+            }
+            engine->running.push_back(job);
+        }
+
+        set_job_qos(job->priority == WHISPER_BRIDGE_PRIORITY_INTERACTIVE);
+
+        whisper_bridge_result* result = transcribe_audio(
+            engine->ctx, job->data.data(), job->n_frames, job->format, job->target_peak,
+            job->has_language ? job->language.c_str() : nullptr, job->translate,
+            job->has_prompt ? job->initial_prompt.c_str() : nullptr,
+            &job->run_cancel, n_threads_job);
+        const int status = result ? result->status : -1;
+
+        {
+            std::lock_guard<std::mutex> lock(engine->mutex);
+            engine->running.erase(std::find(engine->running.begin(), engine->running.end(), job));
+            if (job->priority == WHISPER_BRIDGE_PRIORITY_BACKGROUND) {
+                engine->n_running_background--;
+            }
+
+            // Preempted by a dictation: start over once it is done
+            if (status == WHISPER_BRIDGE_STATUS_CANCELLED && !job->cancelled && !engine->stopping) {
+                BRIDGE_LOG(1, "whisper_bridge_engine: job %lld preempted, requeued\n", (long long) job->id);
+                job->run_cancel.requested.store(false, std::memory_order_relaxed);
+                engine->queued[job->priority].push_front(job);
+                whisper_bridge_result_free(result);
+                engine->cv.notify_all();
+                continue;
+            }
+        }
+        // A worker may start a background job now
+        engine->cv.notify_all();
+
+        if (job->callback) {
+            job->callback(job->id, status, result, job->user_data);
+        } else {
+            whisper_bridge_result_free(result);
+        }
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+whisper_bridge_params whisper_bridge_default_params(void) {
+    whisper_bridge_params params;
+    params.n_threads  = 0;
+    params.use_gpu    = true;
+    params.gpu_device = 0;
+    // The padded keys of the short audio_ctx windows are masked, so flash attention matches the regular attention
+    params.flash_attn = true;
+    // Dictations are mostly a few seconds long, so only encode what the audio needs
+    params.audio_ctx  = -1;
+    // The Neural Engine leaves the GPU to the decoder and draws the least power
+    params.coreml_units = WHISPER_COREML_UNITS_CPU_AND_NE;
+    // Dictations rarely span more than one window
+    params.coreml_async = false;
+    // The stateful decoder is still experimental, Metal decodes by default
+    params.coreml_decoder = false;
+    // Worth it where the Metal dispatch of the small decoder batches costs more than the CPU compute (base M1)
+    params.decoder_cpu = false;
+    // Set on machines whose own GPU is much slower than a shared encoder box on the LAN
+    params.rpc_encoder = NULL;
+    // Large models with beam search ran out of memory on 8 GB Macs, the rest is left to the app and the system
+    params.max_memory_mb = physical_memory_mb() / 2;
+    // The app only uses the text, the timestamp tokens are half of what a short dictation decodes
+    params.dictation = true;
+    // Only set when the user picked a denoise model, clean close-talk audio gains nothing from it
+    params.denoise_model = NULL;
+    return params;
+}
+
+// Context params of the bridge params, path_sched_cache must outlive the load
+static whisper_context_params context_params_for(const whisper_bridge_params& params, const char* path_sched_cache) {
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu    = params.use_gpu;
+    cparams.gpu_device = params.gpu_device;
+    cparams.flash_attn = params.flash_attn;
+    cparams.coreml_units = (enum whisper_coreml_units) params.coreml_units;
+    cparams.coreml_async = params.coreml_async;
+    cparams.coreml_decoder = params.coreml_decoder;
+    cparams.decoder_placement = params.decoder_cpu ? WHISPER_DECODER_PLACEMENT_CPU : WHISPER_DECODER_PLACEMENT_GPU;
+    cparams.rpc_encoder = params.rpc_encoder;
+    cparams.max_memory = (size_t) std::max(0, params.max_memory_mb) * 1000 * 1000;
+    // Map the model so a cold start does not read it all, the pages are shared with other instances
+    cparams.use_mmap   = true;
+    cparams.path_sched_cache = path_sched_cache;
+    // Each pooled state keeps its CPU threads between graphs, they are parked while the state is idle
+    cparams.cpu_threadpool = true;
+    // Without the GPU the encoder runs on Accelerate, which would convert the F16 weights again for every window
+    cparams.blas_weight_cache = params.use_gpu ? 0 : (size_t) physical_memory_mb() / 8 * 1000 * 1000;
+
+    return cparams;
+}
+
+whisper_context* whisper_bridge_init(const char* model_path) {
+    return whisper_bridge_init_with_params(model_path, whisper_bridge_default_params());
+}
+
+whisper_context* whisper_bridge_init_with_params(const char* model_path, whisper_bridge_params params) {
+    if (params.n_threads <= 0) {
+        params.n_threads = performance_core_count();
+    }
+
+    // Compute buffer sizes measured by the first state, next to the model like the autotune result
+    const std::string sched_cache_path = std::string(model_path) + ".sched";
+    struct whisper_context_params cparams = context_params_for(params, sched_cache_path.c_str());
+
+    if (params.use_gpu) {
+        // The compiled Metal pipelines, shared by all models next to them. Read once when the first GPU context
+        // starts the device, so the first dictation after launch does not compile its kernels again
+        const std::string model_dir = std::string(model_path).substr(0, std::string(model_path).find_last_of('/') + 1);
+        setenv("GGML_METAL_PIPELINE_CACHE", (model_dir + "ggml-metal.pipelines").c_str(), 0);
+    }
+    fprintf(stderr, "whisper_bridge_init: GPU %s (device %d), flash attention %s, n_threads=%d, audio_ctx=%d\n",
+            params.use_gpu ? "enabled" : "disabled", params.gpu_device,
+            params.flash_attn ? "enabled" : "disabled", params.n_threads, params.audio_ctx);
+
+    // The context's default state is never used - every transcription runs on a pooled state
+    whisper_context* ctx = whisper_init_from_file_with_params_no_state(model_path, cparams);
+    if (!ctx) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        bridge_context& bctx = g_contexts[ctx];
+        if (params.rpc_encoder) {
+            bctx.rpc_encoder = params.rpc_encoder;
+            params.rpc_encoder = bctx.rpc_encoder.c_str();
+        }
+        if (params.denoise_model) {
+            bctx.denoise_model = params.denoise_model;
+            params.denoise_model = bctx.denoise_model.c_str();
+        }
+        bctx.params = params;
+    }
+
+    if (params.denoise_model) {
+        whisper_denoise_context_params dparams = whisper_denoise_default_context_params();
+        dparams.n_threads = 1;
+
+        whisper_denoise_context* denoise = whisper_denoise_init_from_file_with_params(params.denoise_model, dparams);
+        if (!denoise || whisper_ctx_set_denoise(ctx, denoise) != 0) {
+            fprintf(stderr, "whisper_bridge_init: failed to load denoise model %s\n", params.denoise_model);
+            whisper_denoise_free(denoise);
+            whisper_bridge_free(ctx);
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        g_contexts[ctx].denoise = denoise;
+    }
+
+    // Pre-warm one state so the first dictation doesn't pay for it
+    if (whisper_bridge_state_pool_init(ctx, 1) < 1) {
+        whisper_bridge_free(ctx);
+        return nullptr;
+    }
+
+    return ctx;
+}
+
+whisper_bridge_params whisper_bridge_get_params(whisper_context* ctx) {
+    return ctx ? context_params(ctx) : whisper_bridge_default_params();
+}
+
+void whisper_bridge_set_bias_phrases(whisper_context* ctx, const char* const* phrases, const float* weights, int n_phrases) {
+    if (!ctx) {
+        return;
+    }
+
+    std::shared_ptr<bias_list> bias;
+    if (phrases && n_phrases > 0) {
+        bias = std::make_shared<bias_list>();
+        for (int i = 0; i < n_phrases; i++) {
+            if (!phrases[i] || !phrases[i][0]) {
+                continue;
+            }
+            bias->phrases.emplace_back(phrases[i]);
+            bias->weights.push_back(weights ? weights[i] : 2.0f);
+        }
+        for (const auto& phrase : bias->phrases) {
+            bias->ptrs.push_back(phrase.c_str());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    g_contexts[ctx].bias = std::move(bias);
+}
+
+int whisper_bridge_autotune(whisper_context* ctx, const char* model_path) {
+    if (!ctx || !model_path) {
+        return -1;
+    }
+
+    struct stat st;
+    if (stat(model_path, &st) != 0) {
+        return -1;
+    }
+    const long long model_size = (long long) st.st_size;
+
+    // Cached result from a previous load of the same model file
+    const std::string cache_path = std::string(model_path) + ".tune";
+    if (FILE* f = fopen(cache_path.c_str(), "r")) {
+        long long cached_size = 0;
+        int cached_threads = 0;
+        const bool ok = fscanf(f, "%lld %d", &cached_size, &cached_threads) == 2;
+        fclose(f);
+
+        if (ok && cached_size == model_size && cached_threads > 0) {
+            std::lock_guard<std::mutex> lock(g_pool_mutex);
+            g_contexts[ctx].params.n_threads = cached_threads;
+            return cached_threads;
+        }
+    }
+
+    const int n_perf = performance_core_count();
+    const int n_all  = std::max(n_perf, (int) std::thread::hardware_concurrency());
+
+    std::vector<int> candidates = { n_perf, n_all, std::max(1, n_perf/2) };
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        return -1;
+    }
+
+    // One second of silence is enough - the encoder always runs on the full window
+    std::vector<float> warmup(WHISPER_SAMPLE_RATE, 0.0f);
+    if (whisper_pcm_to_mel_with_state(ctx, state, warmup.data(), (int) warmup.size(), n_perf) != 0 ||
+        whisper_encode_with_state(ctx, state, 0, n_perf) != 0) { // first run allocates buffers and pipelines
+        whisper_bridge_release_state(ctx, state);
+        return -1;
+    }
+
+    int best_threads = n_perf;
+    double best_ms = 1e30;
+    for (int n_threads : candidates) {
+        const auto t_start = std::chrono::steady_clock::now();
+        if (whisper_encode_with_state(ctx, state, 0, n_threads) != 0) {
+            continue;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+        BRIDGE_LOG(1, "whisper_bridge_autotune: n_threads=%d encode=%.1f ms\n", n_threads, ms);
+
+        if (ms < best_ms) {
+            best_ms = ms;
+            best_threads = n_threads;
+        }
+    }
+
+    whisper_bridge_release_state(ctx, state);
+
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        g_contexts[ctx].params.n_threads = best_threads;
+    }
+
+    if (FILE* f = fopen(cache_path.c_str(), "w")) {
+        fprintf(f, "%lld %d\n", model_size, best_threads);
+        fclose(f);
+    }
+
+    return best_threads;
+}
+
+void whisper_bridge_free(whisper_context* ctx) {
+    if (ctx) {
+        {
+            std::lock_guard<std::mutex> lock(g_pool_mutex);
+            auto it = g_contexts.find(ctx);
+            if (it != g_contexts.end()) {
+                for (whisper_state* state : it->second.idle) {
+                    whisper_free_state(state);
+                }
+                whisper_denoise_free(it->second.denoise);
+                g_contexts.erase(it);
+            }
+            // Not a fallback model any more
+            for (auto& entry : g_contexts) {
+                if (entry.second.fallback == ctx) {
+                    entry.second.fallback = nullptr;
+                }
+            }
+        }
+        whisper_free(ctx);
+    }
+}
+
+int whisper_bridge_state_pool_init(whisper_context* ctx, int n_states) {
+    if (!ctx || n_states < 0) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    std::vector<whisper_state*>& idle = g_contexts[ctx].idle;
+
+    while ((int) idle.size() < n_states) {
+        whisper_state* state = whisper_init_state(ctx);
+        if (!state) {
+            fprintf(stderr, "whisper_bridge: failed to allocate pooled state %zu\n", idle.size());
+            return -1;
+        }
+        idle.push_back(state);
+    }
+
+    return (int) idle.size();
+}
+
+whisper_state* whisper_bridge_acquire_state(whisper_context* ctx) {
+    if (!ctx) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        std::vector<whisper_state*>& idle = g_contexts[ctx].idle;
+        if (!idle.empty()) {
+            whisper_state* state = idle.back();
+            idle.pop_back();
+            // Wake the threads now, so they are polling by the time the recording is encoded
+            whisper_threadpool_resume_from_state(state);
+            return state;
+        }
+    }
+
+    // Pool exhausted - grow it. Allocation happens outside the lock so other
+    // callers can still take and return states meanwhile.
+    return whisper_init_state(ctx);
+}
+
+void whisper_bridge_release_state(whisper_context* ctx, whisper_state* state) {
+    if (!ctx || !state) {
+        return;
+    }
+
+    whisper_threadpool_pause_from_state(state);
+
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    g_contexts[ctx].idle.push_back(state);
+}
+
+bool whisper_bridge_state_metrics(whisper_state* state, whisper_bridge_metrics* metrics) {
+    if (!state || !metrics) {
+        return false;
+    }
+
+    whisper_metrics m;
+    whisper_get_metrics_with_state(state, &m);
+
+    metrics->t_mel_us    = m.t_mel_us;
+    metrics->t_vad_us    = m.t_vad_us;
+    metrics->t_denoise_us = m.t_denoise_us;
+    metrics->t_sample_us = m.t_sample_us;
+    metrics->t_encode_us = m.t_encode_us;
+    metrics->t_decode_us = m.t_decode_us + m.t_batchd_us + m.t_prompt_us;
+    metrics->n_sample    = m.n_sample;
+    metrics->n_encode    = m.n_encode;
+    metrics->n_decode    = m.n_decode + m.n_batchd + m.n_prompt;
+    metrics->n_fallback  = m.n_fail_p + m.n_fail_h;
+    metrics->n_bytes_h2d = m.n_bytes_h2d;
+    metrics->n_bytes_d2h = m.n_bytes_d2h;
+    metrics->mem_compute = m.mem_compute;
+    metrics->mem_kv      = m.mem_kv_self + m.mem_kv_cross + m.mem_kv_pad;
+    metrics->rss_peak    = m.rss_peak;
+    metrics->policy      = current_policy();
+
+    return true;
+}
+
+void whisper_bridge_set_power_state(int thermal_state, bool on_battery) {
+    const whisper_bridge_policy policy = policy_for(thermal_state, on_battery);
+
+    int level_prev = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_policy_mutex);
+        level_prev = g_policy.level;
+        g_policy = policy;
+    }
+
+    if (policy.level != level_prev) {
+        BRIDGE_LOG(1, "whisper_bridge: power policy level %d -> %d (thermal state %d, %s), max_threads=%d\n",
+                   level_prev, policy.level, thermal_state, on_battery ? "battery" : "AC", policy.max_threads);
+    }
+}
+
+whisper_bridge_policy whisper_bridge_get_policy(void) {
+    return current_policy();
+}
+
+whisper_bridge_params whisper_bridge_policy_params(whisper_bridge_params params) {
+    const whisper_bridge_policy policy = current_policy();
+    if (policy.level >= 2) {
+        params.coreml_units = WHISPER_COREML_UNITS_CPU_AND_NE;
+        params.coreml_async = false;
+    }
+    if (policy.level >= 3) {
+        params.decoder_cpu = true;
+    }
+    if (policy.max_threads > 0 && params.n_threads > 0) {
+        params.n_threads = std::min(params.n_threads, policy.max_threads);
+    }
+    return params;
+}
+
+void whisper_bridge_set_fallback_model(whisper_context* ctx, whisper_context* fallback) {
+    if (!ctx || fallback == ctx) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    g_contexts[ctx].fallback = fallback;
+}
+
+int whisper_bridge_warmup(whisper_context* ctx) {
+    if (!ctx) {
+        return -1;
+    }
+
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        return -1;
+    }
+
+    const int n_threads = context_params(ctx).n_threads;
+    const auto t_start = std::chrono::steady_clock::now();
+
+    // The state goes back to the pool with its compute buffers allocated and the backend
+    // kernels compiled; the decoder pass covers the decoder graph the encoder run does not
+    std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+    const whisper_token sot = whisper_token_sot(ctx);
+    int result = 0;
+    if (whisper_pcm_to_mel_with_state(ctx, state, silence.data(), (int) silence.size(), n_threads) != 0 ||
+        whisper_encode_with_state(ctx, state, 0, n_threads) != 0 ||
+        whisper_decode_with_state(ctx, state, &sot, 1, 0, n_threads) != 0) {
+        fprintf(stderr, "whisper_bridge_warmup: warm-up pass failed\n");
+        result = -1;
+    }
+
+    whisper_bridge_release_state(ctx, state);
+
+    BRIDGE_LOG(1, "whisper_bridge_warmup: %.1f ms\n",
+               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count());
+
+    return result;
+}
+
+whisper_bridge_preload_task* whisper_bridge_preload(const char* model_path, whisper_bridge_params params) {
+    if (!model_path) {
+        return nullptr;
+    }
+
+    whisper_bridge_preload_task* task = new whisper_bridge_preload_task;
+    task->model_path = model_path;
+    task->params     = params;
+    if (params.rpc_encoder) {
+        task->rpc_encoder = params.rpc_encoder;
+        task->params.rpc_encoder = task->rpc_encoder.c_str();
+    }
+    if (params.denoise_model) {
+        task->denoise_model = params.denoise_model;
+        task->params.denoise_model = task->denoise_model.c_str();
+    }
+
+    try {
+        task->worker = std::thread([task] {
+            whisper_context* ctx = whisper_bridge_init_with_params(task->model_path.c_str(), task->params);
+            // A failed warm-up leaves a usable context, the first transcription just runs cold
+            if (ctx) {
+                whisper_bridge_warmup(ctx);
+            }
+            task->ctx = ctx;
+            task->done.store(true, std::memory_order_release);
+        });
+    } catch (const std::system_error&) {
+        delete task;
+        return nullptr;
+    }
+
+    return task;
+}
+
+bool whisper_bridge_preload_ready(whisper_bridge_preload_task* task) {
+    return task && task->done.load(std::memory_order_acquire);
+}
+
+whisper_context* whisper_bridge_preload_wait(whisper_bridge_preload_task* task) {
+    if (!task) {
+        return nullptr;
+    }
+
+    task->worker.join();
+    whisper_context* ctx = task->ctx;
+    delete task;
+
+    return ctx;
+}
+
+static size_t model_mem_estimate(const char* model_path, const whisper_bridge_params& params) {
+    // The compute buffers are the same with or without the measured sizes
+    struct whisper_memory_budget budget;
+    if (whisper_memory_estimate(model_path, context_params_for(params, nullptr), 1, &budget)) {
+        return budget.total;
+    }
+
+    struct stat st;
+    return stat(model_path, &st) == 0 ? (size_t) st.st_size : 0;
+}
+
+// Take the least recently used idle contexts out of models until mem_new more fits the budget, the caller frees
+// them once the lock is released
+static std::vector<whisper_context*> models_evict(whisper_bridge_models* models, size_t mem_new) {
+    std::vector<whisper_context*> victims;
+
+    size_t mem_total = mem_new;
+    for (const auto& it : models->entries) {
+        mem_total += it.second.mem;
+    }
+
+    while (mem_total > models->budget) {
+        auto lru = models->entries.end();
+        for (auto it = models->entries.begin(); it != models->entries.end(); ++it) {
+            const bridge_model_entry& entry = it->second;
+            if (entry.ctx && entry.refs == 0 && (lru == models->entries.end() || entry.last_used < lru->second.last_used)) {
+                lru = it;
+            }
+        }
+        if (lru == models->entries.end()) {
+            // Everything else is in use or loading, the budget is exceeded until a release
+            BRIDGE_LOG(1, "whisper_bridge_models: %zu MB resident over a budget of %zu MB\n",
+                       mem_total / 1000 / 1000, models->budget / 1000 / 1000);
+            break;
+        }
+
+        BRIDGE_LOG(1, "whisper_bridge_models: evicting %s\n", lru->first.c_str());
+        mem_total -= lru->second.mem;
+        victims.push_back(lru->second.ctx);
+        models->entries.erase(lru);
+    }
+
+    return victims;
+}
+
+static void models_free_victims(const std::vector<whisper_context*>& victims) {
+    for (whisper_context* ctx : victims) {
+        whisper_bridge_free(ctx);
+    }
+}
+
+// Start the load of a model that is not in models, called with the lock held
+static bridge_model_entry* models_start_load(whisper_bridge_models* models, const std::string& path, const whisper_bridge_params& params,
+                                             size_t mem, std::vector<whisper_context*>& victims) {
+    whisper_bridge_preload_task* task = whisper_bridge_preload(path.c_str(), params);
+    if (!task) {
+        return nullptr;
+    }
+
+    victims = models_evict(models, mem);
+
+    bridge_model_entry& entry = models->entries[path];
+    entry.loading   = task;
+    entry.mem       = mem;
+    entry.last_used = ++models->tick;
+
+    return &entry;
+}
+
+whisper_bridge_models* whisper_bridge_models_new(int budget_mb) {
+    whisper_bridge_models* models = new (std::nothrow) whisper_bridge_models;
+    if (!models) {
+        return nullptr;
+    }
+
+    models->budget = (size_t) (budget_mb > 0 ? budget_mb : physical_memory_mb() / 2) * 1000 * 1000;
+    if (models->budget == 0) {
+        // Unknown physical memory, nothing is evicted
+        models->budget = SIZE_MAX;
+    }
+
+    return models;
+}
+
+whisper_context* whisper_bridge_models_acquire(whisper_bridge_models* models, const char* model_path, whisper_bridge_params params) {
+    if (!models || !model_path) {
+        return nullptr;
+    }
+
+    const std::string path = model_path;
+
+    std::vector<whisper_context*> victims;
+    std::unique_lock<std::mutex> lock(models->mutex);
+
+    size_t mem = 0;
+    auto it = models->entries.find(path);
+    if (it == models->entries.end()) {
+        // The estimate reads the model header, not under the lock
+        lock.unlock();
+        mem = model_mem_estimate(model_path, params);
+        lock.lock();
+        it = models->entries.find(path);
+    }
+
+    bridge_model_entry* entry = it != models->entries.end() ? &it->second : nullptr;
+    if (!entry) {
+        entry = models_start_load(models, path, params, mem, victims);
+        if (!entry) {
+            return nullptr;
+        }
+    }
+
+    // Entries keep their address in the map, and a referenced one is not evicted
+    entry->refs++;
+
+    if (!victims.empty()) {
+        lock.unlock();
+        models_free_victims(victims);
+        victims.clear();
+        lock.lock();
+    }
+
+    while (entry->loading) {
+        if (entry->joining) {
+            models->loaded.wait(lock);
+            continue;
+        }
+
+        whisper_bridge_preload_task* task = entry->loading;
+        entry->joining = true;
+        lock.unlock();
+        whisper_context* ctx = whisper_bridge_preload_wait(task);
+        lock.lock();
+        entry->loading = nullptr;
+        entry->joining = false;
+        entry->ctx     = ctx;
+        models->loaded.notify_all();
+    }
+
+    whisper_context* ctx = entry->ctx;
+    if (!ctx) {
+        // Failed load, the entry goes with its last waiter so that the next acquire tries again
+        if (--entry->refs == 0) {
+            models->entries.erase(path);
+        }
+        return nullptr;
+    }
+
+    entry->last_used = ++models->tick;
+
+    return ctx;
+}
+
+void whisper_bridge_models_release(whisper_bridge_models* models, whisper_context* ctx) {
+    if (!models || !ctx) {
+        return;
+    }
+
+    std::vector<whisper_context*> victims;
+    {
+        std::lock_guard<std::mutex> lock(models->mutex);
+        for (auto& it : models->entries) {
+            bridge_model_entry& entry = it.second;
+            if (entry.ctx == ctx && entry.refs > 0) {
+                entry.refs--;
+                entry.last_used = ++models->tick;
+                break;
+            }
+        }
+        // An acquire over the budget evicts what it can once the other models are released
+        victims = models_evict(models, 0);
+    }
+
+    models_free_victims(victims);
+}
+
+bool whisper_bridge_models_prefetch(whisper_bridge_models* models, const char* model_path, whisper_bridge_params params) {
+    if (!models || !model_path) {
+        return false;
+    }
+
+    const std::string path = model_path;
+    const size_t mem = model_mem_estimate(model_path, params);
+
+    std::vector<whisper_context*> victims;
+    {
+        std::lock_guard<std::mutex> lock(models->mutex);
+        if (models->entries.count(path)) {
+            return true;
+        }
+        if (!models_start_load(models, path, params, mem, victims)) {
+            return false;
+        }
+    }
+
+    models_free_victims(victims);
+
+    return true;
+}
+
+int whisper_bridge_models_mem_mb(whisper_bridge_models* models) {
+    if (!models) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(models->mutex);
+    size_t mem = 0;
+    for (const auto& it : models->entries) {
+        mem += it.second.mem;
+    }
+
+    return (int) (mem / 1000 / 1000);
+}
+
+void whisper_bridge_models_free(whisper_bridge_models* models) {
+    if (!models) {
+        return;
+    }
+
+    for (auto& it : models->entries) {
+        bridge_model_entry& entry = it.second;
+        if (entry.loading) {
+            entry.ctx = whisper_bridge_preload_wait(entry.loading);
+        }
+        whisper_bridge_free(entry.ctx);
+    }
+
+    delete models;
+}
+
+char* whisper_bridge_transcribe(
+    whisper_context* ctx,
+    const float* audio_data,
+    int audio_length,
+    const char* language,
+    bool translate,
+    const char* initial_prompt
+) {
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        fprintf(stderr, "whisper_bridge: no decoding state available\n");
+        return nullptr;
+    }
+
+    char* result = whisper_bridge_transcribe_with_state(
+        ctx, state, audio_data, audio_length, language, translate, initial_prompt);
+
+    whisper_bridge_release_state(ctx, state);
+    return result;
+}
+
+char* whisper_bridge_transcribe_with_state(
+    whisper_context* ctx,
+    whisper_state* state,
+    const float* audio_data,
+    int audio_length,
+    const char* language,
+    bool translate,
+    const char* initial_prompt
+) {
+    if (!ctx || !state || !audio_data || audio_length <= 0) {
+        fprintf(stderr, "whisper_bridge: Invalid input - ctx=%p, state=%p, audio_data=%p, audio_length=%d\n",
+                ctx, state, audio_data, audio_length);
+        return nullptr;
+    }
+
+    int result = run_full(ctx, state, audio_data, audio_length, language, translate, initial_prompt);
+
+    if (result != 0) {
+        fprintf(stderr, "whisper_full failed with result: %d\n", result);
+        return nullptr;
+    }
+
+    // Concatenate segments in one pass
+    const int n_segments = whisper_full_n_segments_from_state(state);
+
+    std::string text;
+    for (int i = 0; i < n_segments; i++) {
+        const char* segment_text = whisper_full_get_segment_text_from_state(state, i);
+        if (segment_text) {
+            BRIDGE_DIAG("whisper_bridge: segment %d (no_speech_prob %.3f): '%s'\n",
+                        i, whisper_full_get_segment_no_speech_prob_from_state(state, i), segment_text);
+            text += segment_text;
+        }
+    }
+
+    return copy_c_string(text);
+}
+
+void whisper_bridge_set_verbosity(int level) {
+    g_verbosity.store(level, std::memory_order_relaxed);
+
+    // whisper.cpp drops the filtered messages before formatting them
+    whisper_log_set_level(level <= 0 ? GGML_LOG_LEVEL_ERROR : level == 1 ? GGML_LOG_LEVEL_WARN : GGML_LOG_LEVEL_NONE);
+}
+
+whisper_bridge_result* whisper_bridge_transcribe_result(
+    whisper_context* ctx,
+    const float* audio_data,
+    int audio_length,
+    const char* language,
+    bool translate,
+    const char* initial_prompt
+) {
+    if (!ctx || !audio_data || audio_length <= 0) {
+        fprintf(stderr, "whisper_bridge: Invalid input - ctx=%p, audio_data=%p, audio_length=%d\n",
+                ctx, audio_data, audio_length);
+        return nullptr;
+    }
+
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        fprintf(stderr, "whisper_bridge: no decoding state available\n");
+        return nullptr;
+    }
+
+    const int status = run_full(ctx, state, audio_data, audio_length, language, translate, initial_prompt);
+    return collect_result(ctx, state, status);
+}
+
+whisper_bridge_result* whisper_bridge_transcribe_pcm16(
+    whisper_context* ctx,
+    const int16_t* pcm,
+    int n_samples,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel
+) {
+    if (!ctx || !pcm || n_samples <= 0) {
+        fprintf(stderr, "whisper_bridge: Invalid input - ctx=%p, pcm=%p, n_samples=%d\n",
+                ctx, pcm, n_samples);
+        return nullptr;
+    }
+
+    const whisper_bridge_audio_format format = { WHISPER_BRIDGE_AUDIO_PCM16, WHISPER_SAMPLE_RATE, 1 };
+    return transcribe_audio(ctx, pcm, n_samples, format, target_peak, language, translate, initial_prompt, cancel);
+}
+
+whisper_bridge_result* whisper_bridge_transcribe_audio(
+    whisper_context* ctx,
+    const void* data,
+    size_t n_bytes,
+    whisper_bridge_audio_format format,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel
+) {
+    if (!ctx || !data) {
+        fprintf(stderr, "whisper_bridge: Invalid input - ctx=%p, data=%p\n", ctx, data);
+        return nullptr;
+    }
+
+    const int n_frames = audio_n_frames(format, n_bytes, "whisper_bridge_transcribe_audio");
+    if (n_frames <= 0) {
+        return nullptr;
+    }
+
+    return transcribe_audio(ctx, data, n_frames, format, target_peak, language, translate, initial_prompt, cancel);
+}
+
+whisper_bridge_cancel* whisper_bridge_cancel_new(void) {
+    return new (std::nothrow) whisper_bridge_cancel();
+}
+
+void whisper_bridge_cancel_request(whisper_bridge_cancel* cancel) {
+    if (cancel) {
+        cancel->requested.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool whisper_bridge_cancel_requested(whisper_bridge_cancel* cancel) {
+    return cancel && cancel->requested.load(std::memory_order_relaxed);
+}
+
+void whisper_bridge_cancel_free(whisper_bridge_cancel* cancel) {
+    delete cancel;
+}
+
+whisper_bridge_engine* whisper_bridge_engine_new(whisper_context* ctx, int n_workers, int max_queued) {
+    if (!ctx || n_workers < 1 || max_queued < 0) {
+        return nullptr;
+    }
+
+    // The workers must not wait for a state to be allocated
+    if (whisper_bridge_state_pool_init(ctx, n_workers) < n_workers) {
+        return nullptr;
+    }
+
+    whisper_bridge_engine* engine = new (std::nothrow) whisper_bridge_engine();
+    if (!engine) {
+        return nullptr;
+    }
+    engine->ctx = ctx;
+    engine->n_workers = n_workers;
+    engine->max_queued = max_queued;
+
+    try {
+        for (int i = 0; i < n_workers; i++) {
+            engine->workers.emplace_back(engine_worker, engine);
+        }
+    } catch (const std::system_error& e) {
+        fprintf(stderr, "whisper_bridge_engine_new: failed to start worker %zu: %s\n", engine->workers.size(), e.what());
+        whisper_bridge_engine_free(engine);
+        return nullptr;
+    }
+
+    return engine;
+}
+
+int64_t whisper_bridge_engine_submit(
+    whisper_bridge_engine* engine,
+    const void* data,
+    size_t n_bytes,
+    whisper_bridge_audio_format format,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int priority,
+    whisper_bridge_job_callback callback,
+    void* user_data
+) {
+    if (!engine || !data ||
+        (priority != WHISPER_BRIDGE_PRIORITY_BACKGROUND && priority != WHISPER_BRIDGE_PRIORITY_INTERACTIVE)) {
+        fprintf(stderr, "whisper_bridge_engine_submit: Invalid input - engine=%p, data=%p, priority=%d\n",
+                (void*) engine, data, priority);
+        return 0;
+    }
+
+    const int n_frames = audio_n_frames(format, n_bytes, "whisper_bridge_engine_submit");
+    if (n_frames <= 0) {
+        return 0;
+    }
+
+    auto job = std::make_shared<bridge_job>();
+    job->priority = priority;
+    job->data.assign((const uint8_t*) data, (const uint8_t*) data + n_bytes);
+    job->format = format;
+    job->n_frames = n_frames;
+    job->target_peak = target_peak;
+    job->has_language = language != nullptr;
+    job->language = language ? language : "";
+    job->translate = translate;
+    job->has_prompt = initial_prompt != nullptr;
+    job->initial_prompt = initial_prompt ? initial_prompt : "";
+    job->callback = callback;
+    job->user_data = user_data;
+
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        if (engine->stopping) {
+            return 0;
+        }
+
+        const size_t n_queued = engine->queued[0].size() + engine->queued[1].size();
+        if (engine->max_queued > 0 && n_queued >= (size_t) engine->max_queued) {
+            BRIDGE_LOG(1, "whisper_bridge_engine_submit: %zu jobs queued, rejecting\n", n_queued);
+            return 0;
+        }
+
+        job->id = engine->next_id++;
+        engine->queued[priority].push_back(job);
+
+        // No worker left for the dictation: stop the background job started last, it is requeued
+        if (priority == WHISPER_BRIDGE_PRIORITY_INTERACTIVE && (int) engine->running.size() >= engine->n_workers) {
+            for (auto it = engine->running.rbegin(); it != engine->running.rend(); ++it) {
+                bridge_job& running = **it;
+                if (running.priority == WHISPER_BRIDGE_PRIORITY_BACKGROUND && !whisper_bridge_cancel_requested(&running.run_cancel)) {
+                    whisper_bridge_cancel_request(&running.run_cancel);
+                    break;
+                }
+            }
+        }
+    }
+    engine->cv.notify_all();
+
+    return job->id;
+}
+
+bool whisper_bridge_engine_cancel(whisper_bridge_engine* engine, int64_t job_id) {
+    if (!engine) {
+        return false;
+    }
+
+    std::shared_ptr<bridge_job> job;
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        for (auto& running : engine->running) {
+            if (running->id == job_id) {
+                running->cancelled = true;
+                whisper_bridge_cancel_request(&running->run_cancel);
+                return true;
+            }
+        }
+        for (auto& queued : engine->queued) {
+            auto it = std::find_if(queued.begin(), queued.end(), [&](const auto& j) { return j->id == job_id; });
+            if (it != queued.end()) {
+                job = *it;
+                queued.erase(it);
+                break;
+            }
+        }
+    }
+    if (!job) {
+        return false;
+    }
+
+    if (job->callback) {
+        job->callback(job->id, WHISPER_BRIDGE_STATUS_CANCELLED, nullptr, job->user_data);
+    }
+    return true;
+}
+
+int whisper_bridge_engine_n_queued(whisper_bridge_engine* engine) {
+    if (!engine) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    return (int) (engine->queued[0].size() + engine->queued[1].size());
+}
+
+void whisper_bridge_engine_free(whisper_bridge_engine* engine) {
+    if (!engine) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<bridge_job>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        engine->stopping = true;
+        for (auto& running : engine->running) {
+            running->cancelled = true;
+            whisper_bridge_cancel_request(&running->run_cancel);
+        }
+        for (auto& queued : engine->queued) {
+            dropped.insert(dropped.end(), queued.begin(), queued.end());
+            queued.clear();
+        }
+    }
+    engine->cv.notify_all();
+
+    for (auto& job : dropped) {
+        if (job->callback) {
+            job->callback(job->id, WHISPER_BRIDGE_STATUS_CANCELLED, nullptr, job->user_data);
+        }
+    }
+
+    for (auto& worker : engine->workers) {
+        worker.join();
+    }
+    delete engine;
+}
+
+void whisper_bridge_result_free(whisper_bridge_result* result) {
+    if (!result) {
+        return;
+    }
+
+    free((void*)result->segments);
+    free((void*)result->tokens);
+    whisper_bridge_release_state(result->ctx, result->state);
+    free(result);
+}
+
+const char* whisper_bridge_lang_str(int lang_id) {
+    return lang_id >= 0 ? whisper_lang_str(lang_id) : nullptr;
+}
+
+// The words of the text tokens of result, see whisper_bridge_word
+static void result_words(const whisper_bridge_result* result, std::vector<whisper_bridge_word>& words) {
+    words.clear();
+
+    const whisper_token token_eot = whisper_token_eot(result->ctx);
+
+    for (int i = 0; i < result->n_segments; i++) {
+        const whisper_bridge_segment& segment = result->segments[i];
+
+        bool segment_start = true;
+
+        for (int j = segment.token_offset; j < segment.token_offset + segment.n_tokens; j++) {
+            const whisper_bridge_token& token = result->tokens[j];
+            if (token.id >= token_eot) {
+                continue;
+            }
+
+            const char* text = whisper_token_to_str(result->ctx, token.id);
+            if (segment_start || (text && text[0] == ' ')) {
+                words.push_back({ j, 0, 1.0f, 0.0f });
+                segment_start = false;
+            }
+
+            // p_mean holds the sum of the log probabilities until the end
+            whisper_bridge_word& word = words.back();
+            word.n_tokens = j + 1 - word.token_offset;
+            word.p_min    = std::min(word.p_min, token.p);
+            word.p_mean  += token.plog;
+        }
+    }
+
+    for (whisper_bridge_word& word : words) {
+        // the tokens in between, if any, are timestamps
+        int n_text = 0;
+        for (int j = word.token_offset; j < word.token_offset + word.n_tokens; j++) {
+            n_text += result->tokens[j].id < token_eot;
+        }
+        word.p_mean = expf(word.p_mean/std::max(1, n_text));
+    }
+}
+
+int whisper_bridge_result_words(const whisper_bridge_result* result, whisper_bridge_word* words, int n_max) {
+    if (!result || result->status != 0) {
+        return -1;
+    }
+
+    std::vector<whisper_bridge_word> all;
+    result_words(result, all);
+
+    if (words) {
+        std::copy_n(all.begin(), std::min((int) all.size(), std::max(0, n_max)), words);
+    }
+
+    return (int) all.size();
+}
+
+bool whisper_bridge_result_confidence(const whisper_bridge_result* result, whisper_bridge_confidence* confidence) {
+    if (!result || !confidence || result->status != 0) {
+        return false;
+    }
+
+    const float low_p = 0.5f;
+
+    std::vector<whisper_bridge_word> words;
+    result_words(result, words);
+
+    whisper_bridge_confidence c = {};
+    c.n_words    = (int) words.size();
+    c.word_p_min = 1.0f;
+
+    for (const whisper_bridge_word& word : words) {
+        c.n_low_words += word.p_min < low_p;
+        c.word_p_mean += word.p_mean;
+        c.word_p_min   = std::min(c.word_p_min, word.p_min);
+    }
+    c.word_p_mean = words.empty() ? 1.0f : c.word_p_mean/words.size();
+
+    // avg_logprob and the entropy of the token histogram, as whisper_full scores its sequences
+    const whisper_token token_eot = whisper_token_eot(result->ctx);
+
+    std::unordered_map<whisper_token, int> counts;
+    int n_text = 0;
+    double sum_logprob = 0.0;
+    for (int j = 0; j < result->n_tokens; j++) {
+        const whisper_bridge_token& token = result->tokens[j];
+        if (token.id < token_eot) {
+            counts[token.id]++;
+            sum_logprob += token.plog;
+            n_text++;
+        }
+    }
+
+    c.avg_logprob = n_text > 0 ? (float) (sum_logprob/n_text) : 0.0f;
+
+    for (const auto& kv : counts) {
+        const double p = (double) kv.second/n_text;
+        c.entropy -= (float) (p*log(p));
+    }
+
+    for (int i = 0; i < result->n_segments; i++) {
+        c.no_speech_prob = std::max(c.no_speech_prob, result->segments[i].no_speech_prob);
+    }
+
+    auto ramp = [](float x, float x0, float x1) {
+        return std::min(1.0f, std::max(0.0f, (x - x0)/(x1 - x0)));
+    };
+
+    float score = 0.0f;
+    if (c.n_words > 0) {
+        score = std::max(score, std::min(1.0f, 5.0f*c.n_low_words/c.n_words));
+    }
+    score = std::max(score, ramp(-c.avg_logprob, 0.2f, 0.8f));
+    score = std::max(score, ramp((float) c.n_words, 30.0f, 100.0f));
+    if (n_text >= 32 && c.entropy < 2.4f) {
+        score = 1.0f;
+    }
+    if (c.no_speech_prob > 0.6f) {
+        score = 1.0f;
+    }
+    c.enhance_score = score;
+
+    *confidence = c;
+
+    return true;
+}
+
+static whisper_bridge_stream* stream_begin(
+    whisper_context* ctx,
+    whisper_context* ctx_final,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int step_ms,
+    int length_ms,
+    int keep_ms,
+    whisper_bridge_partial_callback callback,
+    void* user_data
+) {
+    if (!ctx || step_ms <= 0) {
+        fprintf(stderr, "whisper_bridge_stream: invalid parameters - ctx=%p, step_ms=%d\n", ctx, step_ms);
+        return nullptr;
+    }
+
+    // The final pass decodes the frames computed with the filters of ctx
+    if (ctx_final && whisper_model_n_mels(ctx_final) != whisper_model_n_mels(ctx)) {
+        fprintf(stderr, "whisper_bridge_stream: the final model has %d mel bands, the streaming model %d\n",
+                whisper_model_n_mels(ctx_final), whisper_model_n_mels(ctx));
+        return nullptr;
+    }
+
+    whisper_state* state_final = nullptr;
+    if (ctx_final) {
+        state_final = whisper_bridge_acquire_state(ctx_final);
+        if (!state_final) {
+            fprintf(stderr, "whisper_bridge_stream: no decoding state available for the final pass\n");
+            return nullptr;
+        }
+    }
+
+    whisper_state* state = whisper_bridge_acquire_state(ctx);
+    if (!state) {
+        fprintf(stderr, "whisper_bridge_stream: no decoding state available\n");
+        if (state_final) {
+            whisper_bridge_release_state(ctx_final, state_final);
+        }
+        return nullptr;
+    }
+
+    // pooled states may still hold the mel cache of a previous stream
+    whisper_mel_cache_keep_with_state(state, 0);
+
+    keep_ms   = std::min(keep_ms,   step_ms);
+    length_ms = std::max(length_ms, step_ms);
+
+    whisper_bridge_stream* stream = new whisper_bridge_stream();
+    stream->ctx            = ctx;
+    stream->state          = state;
+    stream->language       = language ? language : "en";
+    stream->initial_prompt = initial_prompt ? initial_prompt : "";
+    stream->translate      = translate;
+    stream->params         = context_params(ctx);
+    stream->n_samples_step = (int) (1e-3*step_ms  *WHISPER_SAMPLE_RATE);
+    stream->n_samples_len  = (int) (1e-3*length_ms*WHISPER_SAMPLE_RATE);
+    stream->n_samples_keep = (int) (1e-3*std::max(0, keep_ms)*WHISPER_SAMPLE_RATE);
+    stream->n_new_line     = std::max(1, length_ms / step_ms - 1);
+    stream->callback       = callback;
+    stream->user_data      = user_data;
+    stream->ctx_final      = ctx_final;
+    stream->state_final    = state_final;
+
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        if (whisper_denoise_context* denoise = g_contexts[ctx].denoise) {
+            stream->denoise = whisper_denoise_init_from_context(denoise);
+        }
+    }
+
+    // 30 s of audio before a stalled worker starts to lose the oldest
+    stream->ring.reset(std::max(2*stream->n_samples_step, 30*WHISPER_SAMPLE_RATE));
+    stream->worker = std::thread(stream_worker, stream);
+    if (ctx_final) {
+        stream->final_worker = std::thread(stream_final_worker, stream);
+    }
+
+    return stream;
+}
+
+whisper_bridge_stream* whisper_bridge_stream_begin(
+    whisper_context* ctx,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int step_ms,
+    int length_ms,
+    int keep_ms,
+    whisper_bridge_partial_callback callback,
+    void* user_data
+) {
+    return stream_begin(ctx, nullptr, language, translate, initial_prompt, step_ms, length_ms, keep_ms, callback, user_data);
+}
+
+whisper_bridge_stream* whisper_bridge_stream_begin_two_pass(
+    whisper_context* ctx,
+    whisper_context* ctx_final,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int step_ms,
+    int length_ms,
+    int keep_ms,
+    whisper_bridge_partial_callback callback,
+    void* user_data
+) {
+    if (!ctx_final) {
+        fprintf(stderr, "whisper_bridge_stream: no final model\n");
+        return nullptr;
+    }
+
+    return stream_begin(ctx, ctx_final, language, translate, initial_prompt, step_ms, length_ms, keep_ms, callback, user_data);
+}
+
+void whisper_bridge_stream_push(whisper_bridge_stream* stream, const float* samples, int n_samples) {
+    if (!stream || !samples || n_samples <= 0) {
+        return;
+    }
+
+    stream->ring.write(samples, n_samples);
+
+    // wake the worker when this block completes another step
+    const uint64_t end  = stream->ring.end();
+    const uint64_t step = stream->n_samples_step;
+    if (end/step != (end - n_samples)/step) {
+        stream->cv.notify_one();
+    }
+}
+
+void whisper_bridge_stream_push_pcm16(whisper_bridge_stream* stream, const int16_t* samples, int n_samples) {
+    if (!stream || !samples || n_samples <= 0) {
+        return;
+    }
+
+    float chunk[1024];
+    for (int i = 0; i < n_samples; i += 1024) {
+        const int n = std::min(1024, n_samples - i);
+        pcm16_to_f32_scaled(samples + i, n, 1.0f/32767.0f, chunk);
+        whisper_bridge_stream_push(stream, chunk, n);
+    }
+}
+
+char* whisper_bridge_stream_poll(whisper_bridge_stream* stream) {
+    if (!stream) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    return copy_c_string(stream->committed + stream->partial);
+}
+
+char* whisper_bridge_stream_end(whisper_bridge_stream* stream) {
+    if (!stream) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->stopping = true;
+    }
+    stream->cv.notify_one();
+    stream->worker.join();
+
+    // Only the audio after the last step is left to decode
+    std::vector<float> pcm_tail;
+    stream_take(stream, pcm_tail, true);
+
+    if (stream->ctx_final) {
+        // The final model decodes the tail since the last window it took, the partial model is done
+        stream->final_cv.notify_one();
+        stream->final_worker.join();
+
+        if (!pcm_tail.empty() &&
+            whisper_pcm_to_mel_append_with_state(stream->ctx, stream->state, pcm_tail.data(), (int) pcm_tail.size(),
+                                                 stream->params.n_threads) == 0) {
+            stream->n_mel_pcm += pcm_tail.size();
+        }
+
+        stream_final_submit(stream);
+        if (stream->final_busy) {
+            stream_final_decode(stream);
+        }
+
+        char* result = copy_c_string(stream->final_text);
+
+        whisper_bridge_release_state(stream->ctx, stream->state);
+        whisper_bridge_release_state(stream->ctx_final, stream->state_final);
+        whisper_denoise_free(stream->denoise);
+        delete stream;
+
+        return result;
+    }
+
+    if (!pcm_tail.empty()) {
+        stream_decode_step(stream, pcm_tail, true);
+    } else {
+        stream->committed += stream->partial;
+        stream->partial.clear();
+    }
+
+    char* result = copy_c_string(stream->committed);
+
+    whisper_bridge_release_state(stream->ctx, stream->state);
+    whisper_denoise_free(stream->denoise);
+    delete stream;
+
+    return result;
+}
+
+whisper_bridge_listener* whisper_bridge_listen_begin(
+    whisper_context* ctx,
+    const char* vad_model_path,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_speech_callback callback,
+    void* user_data
+) {
+    if (!ctx || !vad_model_path) {
+        fprintf(stderr, "whisper_bridge_listen: invalid parameters - ctx=%p, vad_model_path=%p\n", ctx, vad_model_path);
+        return nullptr;
+    }
+
+    // The VAD runs all the time: a single CPU thread with the dedicated kernels, the GPU stays idle
+    whisper_vad_context_params vparams = whisper_vad_default_context_params();
+    vparams.n_threads     = 1;
+    vparams.use_gpu       = false;
+    vparams.cpu_fast_path = true;
+
+    whisper_vad_context* vctx = whisper_vad_init_from_file_with_params(vad_model_path, vparams);
+    if (!vctx) {
+        fprintf(stderr, "whisper_bridge_listen: failed to load VAD model '%s'\n", vad_model_path);
+        return nullptr;
+    }
+
+    whisper_bridge_listener* listener = new whisper_bridge_listener();
+    listener->ctx            = ctx;
+    listener->vctx           = vctx;
+    listener->language       = language ? language : "en";
+    listener->initial_prompt = initial_prompt ? initial_prompt : "";
+    listener->translate      = translate;
+    listener->callback       = callback;
+    listener->user_data      = user_data;
+    // The pooled states park their own threads, see whisper_bridge_release_state
+    listener->listen.reset(new always_listen(vctx, nullptr, WHISPER_SAMPLE_RATE, always_listen_params()));
+
+    // 30 s of audio before a stalled worker starts to lose the oldest
+    listener->ring.reset(30*WHISPER_SAMPLE_RATE);
+    listener->worker = std::thread(listener_worker, listener);
+
+    return listener;
+}
+
+void whisper_bridge_listen_push(whisper_bridge_listener* listener, const float* samples, int n_samples) {
+    if (!listener || !samples || n_samples <= 0) {
+        return;
+    }
+
+    listener->ring.write(samples, n_samples);
+
+    const uint64_t end = listener->ring.end();
+    if (end/k_listen_step != (end - n_samples)/k_listen_step) {
+        listener->cv.notify_one();
+    }
+}
+
+void whisper_bridge_listen_push_pcm16(whisper_bridge_listener* listener, const int16_t* samples, int n_samples) {
+    if (!listener || !samples || n_samples <= 0) {
+        return;
+    }
+
+    float chunk[1024];
+    for (int i = 0; i < n_samples; i += 1024) {
+        const int n = std::min(1024, n_samples - i);
+        pcm16_to_f32_scaled(samples + i, n, 1.0f/32767.0f, chunk);
+        whisper_bridge_listen_push(listener, chunk, n);
+    }
+}
+
+bool whisper_bridge_listen_get_stats(whisper_bridge_listener* listener, whisper_bridge_listen_stats* stats) {
+    if (!listener || !stats) {
+        return false;
+    }
+
+    always_listen_stats s;
+    {
+        std::lock_guard<std::mutex> lock(listener->mutex);
+        s = listener->listen->stats();
+    }
+
+    stats->t_active_us = s.t_active_us;
+    stats->t_idle_us   = s.t_idle_us;
+    stats->t_vad_us    = s.t_vad_us;
+    stats->n_samples   = s.n_samples;
+    stats->n_windows   = s.n_windows;
+    stats->n_dropped   = s.n_dropped;
+    stats->n_wake      = s.n_wake;
+
+    return true;
+}
+
+void whisper_bridge_listen_end(whisper_bridge_listener* listener) {
+    if (!listener) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(listener->mutex);
+        listener->stopping = true;
+    }
+    listener->cv.notify_one();
+    listener->worker.join();
+
+    if (g_verbosity.load(std::memory_order_relaxed) >= 1) {
+        always_listen::print_stats(listener->listen->stats());
+    }
+
+    listener->listen.reset();
+    whisper_vad_free(listener->vctx);
+    delete listener;
+}
+
+whisper_bridge_capture* whisper_bridge_capture_new(int max_samples) {
+    if (max_samples <= 0) {
+        return nullptr;
+    }
+
+    whisper_bridge_capture* capture = new (std::nothrow) whisper_bridge_capture();
+    if (!capture) {
+        return nullptr;
+    }
+    capture->samples.reset(new (std::nothrow) int16_t[max_samples]);
+    if (!capture->samples) {
+        delete capture;
+        return nullptr;
+    }
+    capture->max_samples = max_samples;
+
+    return capture;
+}
+
+int whisper_bridge_capture_push(whisper_bridge_capture* capture, const int16_t* samples, int n_samples) {
+    if (!capture || !samples || n_samples <= 0) {
+        return 0;
+    }
+
+    // Only the capture thread writes n_samples
+    const int n_cur = capture->n_samples.load(std::memory_order_relaxed);
+    const int n = std::min(n_samples, capture->max_samples - n_cur);
+    if (n > 0) {
+        memcpy(capture->samples.get() + n_cur, samples, n*sizeof(int16_t));
+        capture->n_samples.store(n_cur + n, std::memory_order_release);
+    }
+    if (n < n_samples) {
+        if (capture->n_dropped.fetch_add(n_samples - n, std::memory_order_relaxed) == 0) {
+            fprintf(stderr, "whisper_bridge_capture_push: capture full at %d samples, dropping the rest\n", capture->max_samples);
+        }
+    }
+
+    return std::max(n, 0);
+}
+
+const int16_t* whisper_bridge_capture_data(whisper_bridge_capture* capture, int* n_samples) {
+    if (!capture) {
+        if (n_samples) {
+            *n_samples = 0;
+        }
+        return nullptr;
+    }
+
+    if (n_samples) {
+        *n_samples = capture->n_samples.load(std::memory_order_acquire);
+    }
+    return capture->samples.get();
+}
+
+float whisper_bridge_capture_rms(whisper_bridge_capture* capture, int n_last) {
+    if (!capture || n_last <= 0) {
+        return 0.0f;
+    }
+
+    const int n_samples = capture->n_samples.load(std::memory_order_acquire);
+    const int n = std::min(n_last, n_samples);
+    if (n == 0) {
+        return 0.0f;
+    }
+
+    const int16_t* samples = capture->samples.get() + n_samples - n;
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        const double v = samples[i]/32767.0;
+        sum += v*v;
+    }
+
+    return (float) std::sqrt(sum/n);
+}
+
+void whisper_bridge_capture_free(whisper_bridge_capture* capture) {
+    delete capture;
+}
+
+int whisper_bridge_quantize_model(
+    const char* in_path,
+    const char* out_path,
+    const char* type,
+    whisper_bridge_progress_callback progress,
+    void* user_data
+) {
+    if (!in_path || !out_path || !type) {
+        return -1;
+    }
+
+    // a single type is the recipe of one rule for every weight matrix
+    const std::string recipe = strchr(type, ' ') ? std::string(type) : std::string(".* ") + type;
+
+    whisper_model_quantize_params params = whisper_model_quantize_default_params();
+    params.recipe = recipe.c_str();
+    params.progress_callback = progress;
+    params.progress_callback_user_data = user_data;
+
+    return whisper_model_quantize(in_path, out_path, &params);
+}
+
+bool whisper_bridge_is_valid(whisper_context* ctx) {
+    return ctx != nullptr;
+}
+
+bool whisper_bridge_has_coreml(void) {
+    return strstr(whisper_print_system_info(), "COREML = 1") != nullptr;
 }
 
 } // extern "C"
@@ -19,13 +19,176 @@ extern "C" {
 // Opaque pointer to whisper context
 typedef struct whisper_context whisper_context;
 
-// Initialize whisper from model file
+// Opaque pointer to a whisper decoding state (KV caches, compute buffers, results)
+typedef struct whisper_state whisper_state;
+
+// Model load and decoding configuration
+typedef struct whisper_bridge_params {
+    int n_threads;     // decoding threads, 0 = number of performance cores
+    bool use_gpu;
+    int gpu_device;
+    bool flash_attn;   // flash attention in the encoder and decoder
+    int audio_ctx;     // encoder context size, 0 = full 30 s window, -1 = sized from the audio length
+    int coreml_units;  // Core ML encoder compute units (enum whisper_coreml_units), Core ML builds only
+    bool coreml_async; // encode the next 30 s window on Core ML while the current one is decoded
+    bool coreml_decoder; // greedy decoding with <model>-decoder.mlmodelc on Core ML (macOS 15), Core ML builds only
+    bool decoder_cpu;  // run the decoder on the CPU and only the encoder on the GPU
+    const char* rpc_encoder; // "host:port" of a ggml-rpc server running the encoder (GGML_RPC builds), NULL to encode locally
+    int max_memory_mb; // budget of the model and each pooled state, 0 = no limit: flash attention, a quantized KV cache and fewer beams to fit
+    bool dictation;    // clips up to 30 s are decoded with whisper_full_dictation_params: one segment without timestamps
+    const char* denoise_model; // ggml denoise model run on the audio before the VAD and the mel, NULL = no noise suppression
+} whisper_bridge_params;
+
+whisper_bridge_params whisper_bridge_default_params(void);
+
+// Initialize whisper from model file with default params
 whisper_context* whisper_bridge_init(const char* model_path);
 
-// Free whisper context
+// Initialize whisper from model file
+whisper_context* whisper_bridge_init_with_params(const char* model_path, whisper_bridge_params params);
+
+// Params the context was created with (n_threads resolved, updated by autotune)
+whisper_bridge_params whisper_bridge_get_params(whisper_context* ctx);
+
+// Favor the tokens of these phrases (custom vocabulary) in later transcriptions on ctx, each raised by
+// weights[i] logits, or 2.0 when weights is NULL. Replaces the previous list, n_phrases = 0 clears it
+void whisper_bridge_set_bias_phrases(whisper_context* ctx, const char* const* phrases, const float* weights, int n_phrases);
+
+// Time whisper_encode on a warm-up buffer for a few thread counts and keep the fastest
+// The result is cached next to the model file (<model_path>.tune) for later loads
+// Returns the chosen n_threads, or -1 on failure
+int whisper_bridge_autotune(whisper_context* ctx, const char* model_path);
+
+// Free whisper context and every pooled state created for it
 void whisper_bridge_free(whisper_context* ctx);
 
-// Transcribe audio data
+// Pre-allocate decoding states so at least n_states are idle in the pool
+// Returns the number of idle states, or -1 on failure
+int whisper_bridge_state_pool_init(whisper_context* ctx, int n_states);
+
+// Take an idle state from the pool, allocating a new one if none is idle
+// Returns NULL on failure; hand the state back with whisper_bridge_release_state
+whisper_state* whisper_bridge_acquire_state(whisper_context* ctx);
+
+// Return a state to the pool of its context
+void whisper_bridge_release_state(whisper_context* ctx, whisper_state* state);
+
+// MARK: - Power policy
+
+// Thermal states, the raw values of ProcessInfo.ThermalState
+#define WHISPER_BRIDGE_THERMAL_NOMINAL  0
+#define WHISPER_BRIDGE_THERMAL_FAIR     1
+#define WHISPER_BRIDGE_THERMAL_SERIOUS  2
+#define WHISPER_BRIDGE_THERMAL_CRITICAL 3
+
+// How the bridge scales the transcriptions back under thermal pressure and on battery, so that a throttled
+// laptop degrades gradually instead of running every job at full width into the throttle
+typedef struct whisper_bridge_policy {
+    int thermal_state;       // WHISPER_BRIDGE_THERMAL_*, as last reported
+    bool on_battery;         // on battery power or in Low Power Mode, as last reported
+    int level;               // 0 = full speed .. 3 = minimal, from the two above
+    int max_threads;         // cap of the decoding threads of every transcription, 0 = none
+    bool efficiency_cores;   // dictations also run at utility QoS, like the file jobs
+    bool small_audio_ctx;    // encode only what the audio needs (audio_ctx -1) even on contexts set to full windows
+    int max_candidates;      // cap of best_of and beam_size, 0 = none
+    bool no_fallback;        // no temperature fallback on a failed window
+    bool use_fallback_model; // transcriptions run on the context of whisper_bridge_set_fallback_model, if set
+} whisper_bridge_policy;
+
+// Report the thermal state (WHISPER_BRIDGE_THERMAL_*) and power source, e.g. on
+// ProcessInfo.thermalStateDidChangeNotification; later transcriptions follow the resulting policy
+void whisper_bridge_set_power_state(int thermal_state, bool on_battery);
+
+// The policy in effect
+whisper_bridge_policy whisper_bridge_get_policy(void);
+
+// params adjusted for a load under the current policy: at level 2 and up the Core ML encoder runs on the
+// Neural Engine, at level 3 the decoder on the CPU, leaving the GPU idle. Placement is fixed at load time,
+// so this applies to the models loaded next (e.g. the fallback model), not to loaded contexts
+whisper_bridge_params whisper_bridge_policy_params(whisper_bridge_params params);
+
+// Smaller resident model transcribing in place of ctx while the policy sets use_fallback_model (NULL = none).
+// fallback is a context of whisper_bridge_init_with_params, freeing it clears it. Only
+// whisper_bridge_transcribe_pcm16/_audio and engine jobs switch, streams stay on their model
+void whisper_bridge_set_fallback_model(whisper_context* ctx, whisper_context* fallback);
+
+// Counters of a state since it was created, see whisper_metrics in whisper.h
+typedef struct whisper_bridge_metrics {
+    int64_t t_mel_us;
+    int64_t t_vad_us;
+    int64_t t_denoise_us;
+    int64_t t_sample_us;
+    int64_t t_encode_us;
+    int64_t t_decode_us; // single-token, batched and prompt decodes
+    int32_t n_sample;
+    int32_t n_encode;
+    int32_t n_decode;    // single-token, batched and prompt decodes
+    int32_t n_fallback;  // temperature fallbacks
+    int64_t n_bytes_h2d; // graph inputs copied to the GPU
+    int64_t n_bytes_d2h; // graph outputs copied back
+    size_t mem_compute;  // compute buffers
+    size_t mem_kv;       // KV caches
+    size_t rss_peak;     // peak resident memory of the process
+    whisper_bridge_policy policy; // power policy in effect at the snapshot
+} whisper_bridge_metrics;
+
+// Snapshot of the counters of state, safe to call while another thread transcribes with it
+// Returns false if state is NULL
+bool whisper_bridge_state_metrics(whisper_state* state, whisper_bridge_metrics* metrics);
+
+// MARK: - Preload
+
+// Opaque background model load
+typedef struct whisper_bridge_preload_task whisper_bridge_preload_task;
+
+// Run one encoder and decoder pass on silence with a pooled state, so the first
+// transcription does not pay for the lazy buffer allocations and GPU pipeline compilation
+// Returns 0 on success
+int whisper_bridge_warmup(whisper_context* ctx);
+
+// Load a model on a background thread (whisper_bridge_init_with_params followed by
+// whisper_bridge_warmup) and return immediately. The strings of params are copied, the caller's may be freed
+// Returns NULL if the thread could not be started
+whisper_bridge_preload_task* whisper_bridge_preload(const char* model_path, whisper_bridge_params params);
+
+// True once the background load has finished (successfully or not), never blocks
+bool whisper_bridge_preload_ready(whisper_bridge_preload_task* task);
+
+// Wait for the background load, free the task and return the context (NULL on failure)
+whisper_context* whisper_bridge_preload_wait(whisper_bridge_preload_task* task);
+
+// MARK: - Model residency
+
+// Opaque set of resident models, e.g. tiny for commands, base for dictation and large for files
+typedef struct whisper_bridge_models whisper_bridge_models;
+
+// Keep the contexts of the models loaded through it while their memory (the whisper_memory_estimate of the
+// model and one state) fits budget_mb, 0 = half the physical memory. Loading a model that does not fit first
+// frees the least recently used ones that are not acquired. The Metal device and its compiled kernels are
+// shared by all contexts of the process, so only the first load compiles them
+// Returns NULL on allocation failure
+whisper_bridge_models* whisper_bridge_models_new(int budget_mb);
+
+// The context of model_path, loaded with params and warmed up unless it is resident, or waiting for its
+// background load. params only apply to a model that is not resident yet. The context stays resident at least
+// until whisper_bridge_models_release; it must not be freed with whisper_bridge_free
+// Returns NULL if the model failed to load
+whisper_context* whisper_bridge_models_acquire(whisper_bridge_models* models, const char* model_path, whisper_bridge_params params);
+
+// Done with a context of whisper_bridge_models_acquire; it stays resident until evicted
+void whisper_bridge_models_release(whisper_bridge_models* models, whisper_context* ctx);
+
+// Start loading model_path in the background when a switch to it is predicted, so that the next acquire does
+// not wait. No-op if it is resident or loading. Returns false if the load could not be started
+bool whisper_bridge_models_prefetch(whisper_bridge_models* models, const char* model_path, whisper_bridge_params params);
+
+// Memory of the resident and loading models in MB, by the estimate
+int whisper_bridge_models_mem_mb(whisper_bridge_models* models);
+
+// Wait for the background loads and free every context, none may be acquired
+void whisper_bridge_models_free(whisper_bridge_models* models);
+
+// Transcribe audio data on a pooled state
 // Returns transcribed text (caller must free)
 char* whisper_bridge_transcribe(
     whisper_context* ctx,
@@ -36,9 +199,363 @@ char* whisper_bridge_transcribe(
     const char* initial_prompt  // Custom vocabulary/context hint
 );
 
+// Transcribe audio data on a caller-owned state (see whisper_bridge_acquire_state)
+// Calls on different states may run concurrently on the same context
+// Returns transcribed text, empty when nothing was recognized, NULL on failure (caller must free)
+char* whisper_bridge_transcribe_with_state(
+    whisper_context* ctx,
+    whisper_state* state,
+    const float* audio_data,
+    int audio_length,
+    const char* language,
+    bool translate,
+    const char* initial_prompt
+);
+
+// MARK: - Cancellation
+
+// Cancellation flag of one transcription, see whisper_bridge_transcribe_pcm16
+typedef struct whisper_bridge_cancel whisper_bridge_cancel;
+
+// whisper_bridge_result.status of a transcription stopped by whisper_bridge_cancel_request
+#define WHISPER_BRIDGE_STATUS_CANCELLED -100
+
+// Returns NULL on allocation failure
+whisper_bridge_cancel* whisper_bridge_cancel_new(void);
+
+// Stop the transcription using cancel: the CPU stops at the next graph op, the GPU after its current graph,
+// and no further window is encoded or token decoded. Safe to call from any thread, before or during the call
+void whisper_bridge_cancel_request(whisper_bridge_cancel* cancel);
+
+bool whisper_bridge_cancel_requested(whisper_bridge_cancel* cancel);
+
+// Free cancel, once the transcription using it has returned
+void whisper_bridge_cancel_free(whisper_bridge_cancel* cancel);
+
+// MARK: - Structured Results
+
+typedef struct whisper_bridge_token {
+    int32_t id;
+    float p;       // probability of the token
+    float plog;    // log probability of the token
+    int64_t t0;    // token-level timestamps (centiseconds), -1 when not computed
+    int64_t t1;
+} whisper_bridge_token;
+
+typedef struct whisper_bridge_segment {
+    const char* text;      // owned by the decoding state, valid until the result is freed
+    int64_t t0;            // start time (centiseconds)
+    int64_t t1;            // end time (centiseconds)
+    float no_speech_prob;
+    int token_offset;      // index of the first token of this segment in whisper_bridge_result.tokens
+    int n_tokens;
+} whisper_bridge_segment;
+
+typedef struct whisper_bridge_result {
+    int status;            // whisper_full return code, 0 on success
+    int lang_id;
+    int n_segments;
+    const whisper_bridge_segment* segments;
+    int n_tokens;
+    const whisper_bridge_token* tokens;
+
+    // internal - the decoding state backing the segment texts
+    whisper_context* ctx;
+    whisper_state* state;
+} whisper_bridge_result;
+
+// Transcribe audio data on a pooled state and return its segments without copying text
+// The state stays checked out until whisper_bridge_result_free
+// Returns NULL on invalid input or allocation failure
+whisper_bridge_result* whisper_bridge_transcribe_result(
+    whisper_context* ctx,
+    const float* audio_data,
+    int audio_length,
+    const char* language,
+    bool translate,
+    const char* initial_prompt
+);
+
+// Same as whisper_bridge_transcribe_result for 16 kHz mono PCM16 as captured
+// Conversion to float and peak normalization to target_peak (0 = none) happen in
+// the bridge, into a staging buffer reused by the state across calls
+// A cancelled transcription returns a result with status WHISPER_BRIDGE_STATUS_CANCELLED
+whisper_bridge_result* whisper_bridge_transcribe_pcm16(
+    whisper_context* ctx,
+    const int16_t* pcm,
+    int n_samples,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel  // optional, NULL = not cancellable
+);
+
+// Sample encodings of whisper_bridge_audio_format
+#define WHISPER_BRIDGE_AUDIO_PCM16 0 // int16, full scale 32767
+#define WHISPER_BRIDGE_AUDIO_F32   1 // float, full scale 1.0
+
+// Layout of raw audio as captured
+typedef struct whisper_bridge_audio_format {
+    int encoding;     // WHISPER_BRIDGE_AUDIO_*
+    int sample_rate;  // resampled to 16 kHz by the whisper resampler unless 16000 (44.1 and 48 kHz among others)
+    int n_channels;   // interleaved, averaged to mono
+} whisper_bridge_audio_format;
+
+// Same as whisper_bridge_transcribe_pcm16 for n_bytes of raw audio in format, e.g. the bytes of a
+// Swift Data. Conversion, downmix and normalization write straight into the state's staging buffer
+// Returns NULL on invalid input, including a sample rate the resampler does not support or a partial frame
+whisper_bridge_result* whisper_bridge_transcribe_audio(
+    whisper_context* ctx,
+    const void* data,
+    size_t n_bytes,
+    whisper_bridge_audio_format format,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_cancel* cancel  // optional, NULL = not cancellable
+);
+
+// Free a result and return its state to the pool
+void whisper_bridge_result_free(whisper_bridge_result* result);
+
+// Short language code ("en", "de", ...) for a result's lang_id, NULL if unknown
+const char* whisper_bridge_lang_str(int lang_id);
+
+// MARK: - Confidence
+
+// A word of a result: its text tokens, the first one starting with a space or a segment
+typedef struct whisper_bridge_word {
+    int token_offset;      // index of the first token in whisper_bridge_result.tokens
+    int n_tokens;
+    float p_min;           // lowest probability of its tokens
+    float p_mean;          // geometric mean of the probabilities of its tokens
+} whisper_bridge_word;
+
+// Confidence aggregates of a result, over its text tokens (no timestamps or special tokens)
+typedef struct whisper_bridge_confidence {
+    int n_words;
+    int n_low_words;       // words with a token below probability 0.5
+    float word_p_mean;     // mean of the p_mean of the words
+    float word_p_min;      // lowest p_min of the words, 1 without words
+    float avg_logprob;     // mean log probability of the tokens, as whisper_full_params.logprob_thold
+    float entropy;         // of the token ids in nats, low when the transcript repeats itself
+    float no_speech_prob;  // highest of the segments
+    float enhance_score;   // 0..1, how likely an LLM pass is to change more than the local rules would
+} whisper_bridge_confidence;
+
+// The words of result, written to words (up to n_max of them) unless it is NULL
+// Returns the number of words, -1 for a failed or cancelled result
+int whisper_bridge_result_words(const whisper_bridge_result* result, whisper_bridge_word* words, int n_max);
+
+// Confidence aggregates of result. enhance_score is the largest of: the share of low words (20% or more = 1),
+// avg_logprob from -0.2 (0) to -0.8 (1), a repetition (entropy under 2.4 over 32 tokens or more = 1), the length
+// from 30 (0) to 100 words (1) and a no_speech_prob over 0.6 (1). A clean short dictation scores close to 0, so
+// the app can paste it without a cloud round-trip below a threshold of its own (e.g. 0.3)
+// Returns false for a NULL, failed or cancelled result
+bool whisper_bridge_result_confidence(const whisper_bridge_result* result, whisper_bridge_confidence* confidence);
+
+// MARK: - Scheduling
+
+// Opaque job scheduler over the state pool of a context
+typedef struct whisper_bridge_engine whisper_bridge_engine;
+
+// Job priorities, higher runs first
+#define WHISPER_BRIDGE_PRIORITY_BACKGROUND  0 // file transcriptions and other long jobs
+#define WHISPER_BRIDGE_PRIORITY_INTERACTIVE 1 // dictations the user is waiting for
+
+// Receives the outcome of a job: status is 0, WHISPER_BRIDGE_STATUS_CANCELLED or a whisper_full error.
+// result is NULL if the job never ran (cancelled while queued, no state) and must be freed
+// with whisper_bridge_result_free otherwise. Called on a worker thread of the engine
+typedef void (*whisper_bridge_job_callback)(int64_t job_id, int status, whisper_bridge_result* result, void* user_data);
+
+// Start n_workers worker threads, each running one job at a time on a pooled state (the pool is
+// grown to n_workers up front). Interactive jobs run before background ones and at most
+// n_workers - 1 background jobs run at once, so a dictation never waits behind file jobs; with a
+// single worker a dictation preempts the running background job, which is requeued and restarted
+// afterwards. At most max_queued jobs wait (0 = unbounded)
+// Returns NULL on failure
+whisper_bridge_engine* whisper_bridge_engine_new(whisper_context* ctx, int n_workers, int max_queued);
+
+// Queue a transcription of n_bytes of raw audio in format, see whisper_bridge_transcribe_audio. The
+// bytes and strings are copied, the conversion runs on the worker. Returns the job id (> 0), or 0 if
+// the queue is full or the input invalid
+int64_t whisper_bridge_engine_submit(
+    whisper_bridge_engine* engine,
+    const void* data,
+    size_t n_bytes,
+    whisper_bridge_audio_format format,
+    float target_peak,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int priority,
+    whisper_bridge_job_callback callback,
+    void* user_data
+);
+
+// Cancel a queued or running job; its callback still runs, with WHISPER_BRIDGE_STATUS_CANCELLED
+// Returns false if the job is unknown or already finished
+bool whisper_bridge_engine_cancel(whisper_bridge_engine* engine, int64_t job_id);
+
+// Number of jobs waiting for a worker
+int whisper_bridge_engine_n_queued(whisper_bridge_engine* engine);
+
+// Cancel all jobs, wait for their callbacks and free the engine, before whisper_bridge_free of its context
+void whisper_bridge_engine_free(whisper_bridge_engine* engine);
+
+// MARK: - Capture
+
+// Opaque recording sink, filled from the audio capture thread
+typedef struct whisper_bridge_capture whisper_bridge_capture;
+
+// Sink for up to max_samples of 16 kHz mono PCM16. The buffer is allocated up front but its
+// pages are only committed as the recording reaches them. Returns NULL on failure
+whisper_bridge_capture* whisper_bridge_capture_new(int max_samples);
+
+// Append samples; lock-free, for a single capture thread. Samples past max_samples are dropped
+// Returns the number of samples appended
+int whisper_bridge_capture_push(whisper_bridge_capture* capture, const int16_t* samples, int n_samples);
+
+// The samples captured so far, stored in *n_samples. They stay valid and unchanged
+// while pushing continues, until whisper_bridge_capture_free
+const int16_t* whisper_bridge_capture_data(whisper_bridge_capture* capture, int* n_samples);
+
+// RMS (full scale 1.0) of the last n_last captured samples, for level meters; safe from any thread
+float whisper_bridge_capture_rms(whisper_bridge_capture* capture, int n_last);
+
+void whisper_bridge_capture_free(whisper_bridge_capture* capture);
+
+// MARK: - Streaming
+
+// Opaque incremental transcription session
+typedef struct whisper_bridge_stream whisper_bridge_stream;
+
+// Receives the running transcript (committed windows + current partial window)
+// Called on the session's worker thread; text is only valid during the call
+typedef void (*whisper_bridge_partial_callback)(const char* text, void* user_data);
+
+// Start a session on a pooled state. Every step_ms of pushed audio the last
+// length_ms (+ keep_ms overlap) is decoded on a worker thread.
+// Returns NULL on failure
+whisper_bridge_stream* whisper_bridge_stream_begin(
+    whisper_context* ctx,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int step_ms,
+    int length_ms,
+    int keep_ms,
+    whisper_bridge_partial_callback callback,  // optional
+    void* user_data
+);
+
+// Two-pass session: ctx streams the partial results as with whisper_bridge_stream_begin, and every window it
+// commits is decoded again by ctx_final on a second worker from a copy of the same log-mel frames, so that at
+// the end only the audio since the last window is left for the final model. ctx_final must have the same number
+// of mel bands as ctx (e.g. base.en with large-v2, not with large-v3). The callback and poll report the partial
+// transcript of ctx, end returns the transcript of ctx_final
+// Returns NULL on failure
+whisper_bridge_stream* whisper_bridge_stream_begin_two_pass(
+    whisper_context* ctx,
+    whisper_context* ctx_final,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    int step_ms,
+    int length_ms,
+    int keep_ms,
+    whisper_bridge_partial_callback callback,  // optional
+    void* user_data
+);
+
+// Append 16 kHz mono float samples; never blocks on inference
+void whisper_bridge_stream_push(whisper_bridge_stream* stream, const float* samples, int n_samples);
+
+// Same for 16 kHz mono PCM16 as captured, converted in the bridge without an intermediate buffer
+void whisper_bridge_stream_push_pcm16(whisper_bridge_stream* stream, const int16_t* samples, int n_samples);
+
+// Current running transcript (caller must free)
+char* whisper_bridge_stream_poll(whisper_bridge_stream* stream);
+
+// Decode the remaining audio, free the session and return the final transcript (caller must free)
+char* whisper_bridge_stream_end(whisper_bridge_stream* stream);
+
+// MARK: - Always listening
+
+// Opaque always-on listening session
+typedef struct whisper_bridge_listener whisper_bridge_listener;
+
+// Receives the transcript of each speech window
+// Called on the session's worker thread; text is only valid during the call
+typedef void (*whisper_bridge_speech_callback)(const char* text, void* user_data);
+
+// Energy-related counters of a listening session
+typedef struct whisper_bridge_listen_stats {
+    int64_t t_active_us; // transcribing speech windows
+    int64_t t_idle_us;   // the rest of the session, only the VAD runs
+    int64_t t_vad_us;    // spent in the VAD
+    int64_t n_samples;   // audio pushed
+    int32_t n_windows;   // speech windows closed
+    int32_t n_dropped;   // speech windows too short to transcribe
+    int32_t n_wake;      // transcriptions started
+} whisper_bridge_listen_stats;
+
+// Start listening. The pushed audio runs through the Silero VAD model at vad_model_path
+// on a worker thread at the utility QoS (efficiency cores). Each closed speech window is
+// transcribed on a pooled state, which is only checked out meanwhile, so the model stays
+// loaded but its threads are parked while nobody speaks.
+// Returns NULL on failure
+whisper_bridge_listener* whisper_bridge_listen_begin(
+    whisper_context* ctx,
+    const char* vad_model_path,
+    const char* language,
+    bool translate,
+    const char* initial_prompt,
+    whisper_bridge_speech_callback callback,
+    void* user_data
+);
+
+// Append 16 kHz mono float samples; never blocks on the VAD or on inference
+void whisper_bridge_listen_push(whisper_bridge_listener* listener, const float* samples, int n_samples);
+
+// Same for 16 kHz mono PCM16 as captured, see whisper_bridge_stream_push_pcm16
+void whisper_bridge_listen_push_pcm16(whisper_bridge_listener* listener, const int16_t* samples, int n_samples);
+
+// Snapshot of the counters of listener, returns false if listener is NULL
+bool whisper_bridge_listen_get_stats(whisper_bridge_listener* listener, whisper_bridge_listen_stats* stats);
+
+// Stop listening and free the session; the speech not closed into a window yet is dropped
+void whisper_bridge_listen_end(whisper_bridge_listener* listener);
+
+// Progress of whisper_bridge_quantize_model, the fraction of the input converted; return false to cancel
+typedef bool (*whisper_bridge_progress_callback)(float progress, void* user_data);
+
+// Write the F16/F32 model at in_path (e.g. a downloaded master) to out_path with its weight matrices converted to
+// type ("q8_0", "q5_0", "q5_k", ...), or by the "<regex> <type>; ..." rules of a recipe when type has a space, see
+// whisper_model_quantize. Uses every core; call it off the main thread. progress may be NULL.
+// Returns 0 on success, 1 if cancelled and -1 on failure
+int whisper_bridge_quantize_model(
+    const char* in_path,
+    const char* out_path,
+    const char* type,
+    whisper_bridge_progress_callback progress,
+    void* user_data
+);
+
+// Bridge logging: 0 = errors only, 1 = one timing summary per transcription (default),
+// 2 = per-call audio/segment dumps (only compiled in with DEBUG or WHISPER_BRIDGE_DIAGNOSTICS)
+// Also sets the whisper.cpp log level: errors at 0, warnings at 1, everything at 2
+void whisper_bridge_set_verbosity(int level);
+
 // Check if context is valid
 bool whisper_bridge_is_valid(whisper_context* ctx);
 
+// True if libwhisper was built with WHISPER_COREML, the encoder then runs the
+// <model>-encoder.mlmodelc next to the model file
+bool whisper_bridge_has_coreml(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@ var (
 	ErrProcessingFailed     = errors.New("processing failed")
 	ErrUnsupportedLanguage  = errors.New("unsupported language")
 	ErrModelNotMultilingual = errors.New("model is not multilingual")
+	ErrUnableToCreateState  = errors.New("unable to create state")
 )
 
 ///////////////////////////////////////////////////////////////////////////////
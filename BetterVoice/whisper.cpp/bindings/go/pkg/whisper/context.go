@@ -18,6 +18,20 @@ type context struct {
 	n      int
 	model  *model
 	params whisper.Params
+	state  *whisper.State // from a StatePool, nil to use the default state of the model
+}
+
+// The results of a transcription, of the default state of the model or of the state of a context
+type results interface {
+	Whisper_full_lang_id() int
+	Whisper_full_n_segments() int
+	Whisper_full_get_segment_t0(segment int) int64
+	Whisper_full_get_segment_t1(segment int) int64
+	Whisper_full_get_segment_text(segment int) string
+	Whisper_full_n_tokens(segment int) int
+	Whisper_full_get_token_id(segment int, token int) whisper.Token
+	Whisper_full_get_token_data(segment int, token int) whisper.TokenData
+	Whisper_full_get_token_p(segment int, token int) float32
 }
 
 // Make sure context adheres to the interface
@@ -72,7 +86,7 @@ func (context *context) Language() string {
 }
 
 func (context *context) DetectedLanguage() string {
-	return whisper.Whisper_lang_str(context.model.ctx.Whisper_full_lang_id())
+	return whisper.Whisper_lang_str(context.results().Whisper_full_lang_id())
 }
 
 // Set translate flag
@@ -205,35 +219,34 @@ func (context *context) Process(
 		context.params.SetSingleSegment(true)
 	}
 
+	results := context.results()
+	newSegment := func(new int) {
+		if callNewSegment != nil {
+			num_segments := results.Whisper_full_n_segments()
+			s0 := num_segments - new
+			for i := s0; i < num_segments; i++ {
+				callNewSegment(toSegment(context.model.ctx, results, i))
+			}
+		}
+	}
+	progress := func(progress int) {
+		if callProgress != nil {
+			callProgress(progress)
+		}
+	}
+
 	// We don't do parallel processing at the moment
 	processors := 0
-	if processors > 1 {
-		if err := context.model.ctx.Whisper_full_parallel(context.params, data, processors, callEncoderBegin,
-			func(new int) {
-				if callNewSegment != nil {
-					num_segments := context.model.ctx.Whisper_full_n_segments()
-					s0 := num_segments - new
-					for i := s0; i < num_segments; i++ {
-						callNewSegment(toSegment(context.model.ctx, i))
-					}
-				}
-			}); err != nil {
+	if context.state != nil {
+		// Contexts of a StatePool run on their own state, concurrently with the others
+		if err := context.model.ctx.Whisper_full_with_state(context.state, context.params, data, callEncoderBegin, newSegment, progress); err != nil {
 			return err
 		}
-	} else if err := context.model.ctx.Whisper_full(context.params, data, callEncoderBegin,
-		func(new int) {
-			if callNewSegment != nil {
-				num_segments := context.model.ctx.Whisper_full_n_segments()
-				s0 := num_segments - new
-				for i := s0; i < num_segments; i++ {
-					callNewSegment(toSegment(context.model.ctx, i))
-				}
-			}
-		}, func(progress int) {
-			if callProgress != nil {
-				callProgress(progress)
-			}
-		}); err != nil {
+	} else if processors > 1 {
+		if err := context.model.ctx.Whisper_full_parallel(context.params, data, processors, callEncoderBegin, newSegment); err != nil {
+			return err
+		}
+	} else if err := context.model.ctx.Whisper_full(context.params, data, callEncoderBegin, newSegment, progress); err != nil {
 		return err
 	}
 
@@ -246,12 +259,12 @@ func (context *context) NextSegment() (Segment, error) {
 	if context.model.ctx == nil {
 		return Segment{}, ErrInternalAppError
 	}
-	if context.n >= context.model.ctx.Whisper_full_n_segments() {
+	if context.n >= context.results().Whisper_full_n_segments() {
 		return Segment{}, io.EOF
 	}
 
 	// Populate result
-	result := toSegment(context.model.ctx, context.n)
+	result := toSegment(context.model.ctx, context.results(), context.n)
 
 	// Increment the cursor
 	context.n++
@@ -322,25 +335,33 @@ func (context *context) IsLANG(t Token, lang string) bool {
 ///////////////////////////////////////////////////////////////////////////////
 // PRIVATE METHODS
 
-func toSegment(ctx *whisper.Context, n int) Segment {
+func (context *context) results() results {
+	if context.state != nil {
+		return context.state
+	}
+	return context.model.ctx
+}
+
+func toSegment(ctx *whisper.Context, r results, n int) Segment {
 	return Segment{
 		Num:    n,
-		Text:   strings.TrimSpace(ctx.Whisper_full_get_segment_text(n)),
-		Start:  time.Duration(ctx.Whisper_full_get_segment_t0(n)) * time.Millisecond * 10,
-		End:    time.Duration(ctx.Whisper_full_get_segment_t1(n)) * time.Millisecond * 10,
-		Tokens: toTokens(ctx, n),
+		Text:   strings.TrimSpace(r.Whisper_full_get_segment_text(n)),
+		Start:  time.Duration(r.Whisper_full_get_segment_t0(n)) * time.Millisecond * 10,
+		End:    time.Duration(r.Whisper_full_get_segment_t1(n)) * time.Millisecond * 10,
+		Tokens: toTokens(ctx, r, n),
 	}
 }
 
-func toTokens(ctx *whisper.Context, n int) []Token {
-	result := make([]Token, ctx.Whisper_full_n_tokens(n))
+func toTokens(ctx *whisper.Context, r results, n int) []Token {
+	result := make([]Token, r.Whisper_full_n_tokens(n))
 	for i := 0; i < len(result); i++ {
-		data := ctx.Whisper_full_get_token_data(n, i)
+		data := r.Whisper_full_get_token_data(n, i)
+		id := r.Whisper_full_get_token_id(n, i)
 
 		result[i] = Token{
-			Id:    int(ctx.Whisper_full_get_token_id(n, i)),
-			Text:  ctx.Whisper_full_get_token_text(n, i),
-			P:     ctx.Whisper_full_get_token_p(n, i),
+			Id:    int(id),
+			Text:  ctx.Whisper_token_to_str(id),
+			P:     r.Whisper_full_get_token_p(n, i),
 			Start: time.Duration(data.T0()) * time.Millisecond * 10,
 			End:   time.Duration(data.T1()) * time.Millisecond * 10,
 		}
@@ -86,7 +86,15 @@ func (model *model) NewContext() (Context, error) {
 		return nil, ErrInternalAppError
 	}
 
-	// Create new context
+	// Return new context
+	return newContext(model, model.defaultParams())
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE METHODS
+
+// The parameters of a new context
+func (model *model) defaultParams() whisper.Params {
 	params := model.ctx.Whisper_full_default_params(whisper.SAMPLING_GREEDY)
 	params.SetTranslate(false)
 	params.SetPrintSpecial(false)
@@ -95,7 +103,5 @@ func (model *model) NewContext() (Context, error) {
 	params.SetPrintTimestamps(false)
 	params.SetThreads(runtime.NumCPU())
 	params.SetNoContext(true)
-
-	// Return new context
-	return newContext(model, params)
+	return params
 }
@@ -0,0 +1,84 @@
+package whisper
+
+import (
+	// Bindings
+	whisper "github.com/ggerganov/whisper.cpp/bindings/go"
+)
+
+///////////////////////////////////////////////////////////////////////////////
+// TYPES
+
+// StatePool hands out contexts that each run on their own whisper state, so
+// that many goroutines can call Process at the same time on one loaded model
+// instead of taking turns on its default state
+type StatePool struct {
+	model    *model
+	states   []*whisper.State
+	contexts chan *context
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LIFECYCLE
+
+// NewStatePool allocates size states on the model. Each state holds the
+// buffers of one transcription, the model weights are shared
+func NewStatePool(m Model, size int) (*StatePool, error) {
+	model, ok := m.(*model)
+	if !ok || model.ctx == nil || size < 1 {
+		return nil, ErrInternalAppError
+	}
+
+	pool := &StatePool{
+		model:    model,
+		contexts: make(chan *context, size),
+	}
+	for i := 0; i < size; i++ {
+		state := model.ctx.Whisper_init_state()
+		if state == nil {
+			pool.Close()
+			return nil, ErrUnableToCreateState
+		}
+		pool.states = append(pool.states, state)
+		pool.contexts <- &context{model: model, params: model.defaultParams(), state: state}
+	}
+
+	// Return success
+	return pool, nil
+}
+
+// Close frees the states. All contexts must have been returned with Put, and
+// the model must be closed after the pool
+func (pool *StatePool) Close() error {
+	for _, state := range pool.states {
+		state.Whisper_free_state()
+	}
+	pool.states = nil
+
+	// Return success
+	return nil
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC METHODS
+
+// Get returns a free context, waiting for one if all are in use. The context
+// must not be used after it is returned with Put
+func (pool *StatePool) Get() Context {
+	return <-pool.contexts
+}
+
+// Put returns a context of the pool, with its parameters reset for the next
+// user
+func (pool *StatePool) Put(ctx Context) error {
+	context, ok := ctx.(*context)
+	if !ok || context.model != pool.model || context.state == nil {
+		return ErrInternalAppError
+	}
+
+	context.n = 0
+	context.params = pool.model.defaultParams()
+	pool.contexts <- context
+
+	// Return success
+	return nil
+}
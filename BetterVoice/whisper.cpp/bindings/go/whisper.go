@@ -2,6 +2,7 @@ package whisper
 
 import (
 	"errors"
+	"sync"
 	"unsafe"
 )
 
@@ -67,6 +68,7 @@ import "C"
 
 type (
 	Context          C.struct_whisper_context
+	State            C.struct_whisper_state
 	Token            C.whisper_token
 	TokenData        C.struct_whisper_token_data
 	SamplingStrategy C.enum_whisper_sampling_strategy
@@ -310,13 +312,13 @@ func (ctx *Context) Whisper_full(
 	newSegmentCallback func(int),
 	progressCallback func(int),
 ) error {
-	registerEncoderBeginCallback(ctx, encoderBeginCallback)
-	registerNewSegmentCallback(ctx, newSegmentCallback)
-	registerProgressCallback(ctx, progressCallback)
-	defer registerEncoderBeginCallback(ctx, nil)
-	defer registerNewSegmentCallback(ctx, nil)
-	defer registerProgressCallback(ctx, nil)
-	if C.whisper_full((*C.struct_whisper_context)(ctx), (C.struct_whisper_full_params)(params), (*C.float)(&samples[0]), C.int(len(samples))) == 0 {
+	registerEncoderBeginCallback(unsafe.Pointer(ctx), encoderBeginCallback)
+	registerNewSegmentCallback(unsafe.Pointer(ctx), newSegmentCallback)
+	registerProgressCallback(unsafe.Pointer(ctx), progressCallback)
+	defer registerEncoderBeginCallback(unsafe.Pointer(ctx), nil)
+	defer registerNewSegmentCallback(unsafe.Pointer(ctx), nil)
+	defer registerProgressCallback(unsafe.Pointer(ctx), nil)
+	if C.whisper_full((*C.struct_whisper_context)(ctx), (C.struct_whisper_full_params)(params), samplesPtr(samples), C.int(len(samples))) == 0 {
 		return nil
 	} else {
 		return ErrConversionFailed
@@ -327,12 +329,56 @@ func (ctx *Context) Whisper_full(
 // It seems this approach can offer some speedup in some cases.
 // However, the transcription accuracy can be worse at the beginning and end of each chunk.
 func (ctx *Context) Whisper_full_parallel(params Params, samples []float32, processors int, encoderBeginCallback func() bool, newSegmentCallback func(int)) error {
-	registerEncoderBeginCallback(ctx, encoderBeginCallback)
-	registerNewSegmentCallback(ctx, newSegmentCallback)
-	defer registerEncoderBeginCallback(ctx, nil)
-	defer registerNewSegmentCallback(ctx, nil)
+	registerEncoderBeginCallback(unsafe.Pointer(ctx), encoderBeginCallback)
+	registerNewSegmentCallback(unsafe.Pointer(ctx), newSegmentCallback)
+	defer registerEncoderBeginCallback(unsafe.Pointer(ctx), nil)
+	defer registerNewSegmentCallback(unsafe.Pointer(ctx), nil)
 
-	if C.whisper_full_parallel((*C.struct_whisper_context)(ctx), (C.struct_whisper_full_params)(params), (*C.float)(&samples[0]), C.int(len(samples)), C.int(processors)) == 0 {
+	if C.whisper_full_parallel((*C.struct_whisper_context)(ctx), (C.struct_whisper_full_params)(params), samplesPtr(samples), C.int(len(samples)), C.int(processors)) == 0 {
+		return nil
+	} else {
+		return ErrConversionFailed
+	}
+}
+
+// Allocates a state for the model of the context: the buffers and results of one transcription. Each state can
+// run whisper_full_with_state() concurrently with the others on the shared model.
+// Returns nil on failure.
+func (ctx *Context) Whisper_init_state() *State {
+	if state := C.whisper_init_state((*C.struct_whisper_context)(ctx)); state != nil {
+		return (*State)(state)
+	} else {
+		return nil
+	}
+}
+
+// Frees all memory allocated by the state.
+func (state *State) Whisper_free_state() {
+	C.whisper_free_state((*C.struct_whisper_state)(state))
+}
+
+// Run the entire model on the given state, as whisper_full() does on the default state of the context.
+// The callbacks are registered for the state, so that calls on different states do not interfere.
+func (ctx *Context) Whisper_full_with_state(
+	state *State,
+	params Params,
+	samples []float32,
+	encoderBeginCallback func() bool,
+	newSegmentCallback func(int),
+	progressCallback func(int),
+) error {
+	registerEncoderBeginCallback(unsafe.Pointer(state), encoderBeginCallback)
+	registerNewSegmentCallback(unsafe.Pointer(state), newSegmentCallback)
+	registerProgressCallback(unsafe.Pointer(state), progressCallback)
+	defer registerEncoderBeginCallback(unsafe.Pointer(state), nil)
+	defer registerNewSegmentCallback(unsafe.Pointer(state), nil)
+	defer registerProgressCallback(unsafe.Pointer(state), nil)
+
+	params.new_segment_callback_user_data = unsafe.Pointer(state)
+	params.encoder_begin_callback_user_data = unsafe.Pointer(state)
+	params.progress_callback_user_data = unsafe.Pointer(state)
+
+	if C.whisper_full_with_state((*C.struct_whisper_context)(ctx), (*C.struct_whisper_state)(state), (C.struct_whisper_full_params)(params), samplesPtr(samples), C.int(len(samples))) == 0 {
 		return nil
 	} else {
 		return ErrConversionFailed
@@ -398,56 +444,121 @@ func (ctx *Context) Whisper_full_get_token_p(segment int, token int) float32 {
 	return float32(C.whisper_full_get_token_p((*C.struct_whisper_context)(ctx), C.int(segment), C.int(token)))
 }
 
+// Results of a state, see the context variants above.
+func (state *State) Whisper_full_lang_id() int {
+	return int(C.whisper_full_lang_id_from_state((*C.struct_whisper_state)(state)))
+}
+
+func (state *State) Whisper_full_n_segments() int {
+	return int(C.whisper_full_n_segments_from_state((*C.struct_whisper_state)(state)))
+}
+
+func (state *State) Whisper_full_get_segment_t0(segment int) int64 {
+	return int64(C.whisper_full_get_segment_t0_from_state((*C.struct_whisper_state)(state), C.int(segment)))
+}
+
+func (state *State) Whisper_full_get_segment_t1(segment int) int64 {
+	return int64(C.whisper_full_get_segment_t1_from_state((*C.struct_whisper_state)(state), C.int(segment)))
+}
+
+func (state *State) Whisper_full_get_segment_text(segment int) string {
+	return C.GoString(C.whisper_full_get_segment_text_from_state((*C.struct_whisper_state)(state), C.int(segment)))
+}
+
+func (state *State) Whisper_full_n_tokens(segment int) int {
+	return int(C.whisper_full_n_tokens_from_state((*C.struct_whisper_state)(state), C.int(segment)))
+}
+
+func (state *State) Whisper_full_get_token_id(segment int, token int) Token {
+	return Token(C.whisper_full_get_token_id_from_state((*C.struct_whisper_state)(state), C.int(segment), C.int(token)))
+}
+
+func (state *State) Whisper_full_get_token_data(segment int, token int) TokenData {
+	return TokenData(C.whisper_full_get_token_data_from_state((*C.struct_whisper_state)(state), C.int(segment), C.int(token)))
+}
+
+func (state *State) Whisper_full_get_token_p(segment int, token int) float32 {
+	return float32(C.whisper_full_get_token_p_from_state((*C.struct_whisper_state)(state), C.int(segment), C.int(token)))
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE METHODS
+
+// The samples are passed to C in place, without a copy - also for an empty slice, where &samples[0] would panic
+func samplesPtr(samples []float32) *C.float {
+	return (*C.float)(unsafe.Pointer(unsafe.SliceData(samples)))
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CALLBACKS
 
+// The callbacks of each call, keyed by its context - or its state with Whisper_full_with_state(), so that calls on
+// different states can run at the same time
 var (
 	cbNewSegment   = make(map[unsafe.Pointer]func(int))
 	cbProgress     = make(map[unsafe.Pointer]func(int))
 	cbEncoderBegin = make(map[unsafe.Pointer]func() bool)
 )
 
-func registerNewSegmentCallback(ctx *Context, fn func(int)) {
+// Guards the callback maps
+var cbMutex sync.RWMutex
+
+func registerNewSegmentCallback(key unsafe.Pointer, fn func(int)) {
+	cbMutex.Lock()
+	defer cbMutex.Unlock()
 	if fn == nil {
-		delete(cbNewSegment, unsafe.Pointer(ctx))
+		delete(cbNewSegment, key)
 	} else {
-		cbNewSegment[unsafe.Pointer(ctx)] = fn
+		cbNewSegment[key] = fn
 	}
 }
 
-func registerProgressCallback(ctx *Context, fn func(int)) {
+func registerProgressCallback(key unsafe.Pointer, fn func(int)) {
+	cbMutex.Lock()
+	defer cbMutex.Unlock()
 	if fn == nil {
-		delete(cbProgress, unsafe.Pointer(ctx))
+		delete(cbProgress, key)
 	} else {
-		cbProgress[unsafe.Pointer(ctx)] = fn
+		cbProgress[key] = fn
 	}
 }
 
-func registerEncoderBeginCallback(ctx *Context, fn func() bool) {
+func registerEncoderBeginCallback(key unsafe.Pointer, fn func() bool) {
+	cbMutex.Lock()
+	defer cbMutex.Unlock()
 	if fn == nil {
-		delete(cbEncoderBegin, unsafe.Pointer(ctx))
+		delete(cbEncoderBegin, key)
 	} else {
-		cbEncoderBegin[unsafe.Pointer(ctx)] = fn
+		cbEncoderBegin[key] = fn
 	}
 }
 
 //export callNewSegment
 func callNewSegment(user_data unsafe.Pointer, new C.int) {
-	if fn, ok := cbNewSegment[user_data]; ok {
+	cbMutex.RLock()
+	fn, ok := cbNewSegment[user_data]
+	cbMutex.RUnlock()
+	if ok {
 		fn(int(new))
 	}
 }
 
 //export callProgress
 func callProgress(user_data unsafe.Pointer, progress C.int) {
-	if fn, ok := cbProgress[user_data]; ok {
+	cbMutex.RLock()
+	fn, ok := cbProgress[user_data]
+	cbMutex.RUnlock()
+	if ok {
 		fn(int(progress))
 	}
 }
 
 //export callEncoderBegin
 func callEncoderBegin(user_data unsafe.Pointer) C.bool {
-	if fn, ok := cbEncoderBegin[user_data]; ok {
+	cbMutex.RLock()
+	fn, ok := cbEncoderBegin[user_data]
+	cbMutex.RUnlock()
+	if ok {
 		if fn() {
 			return C.bool(true)
 		} else {
@@ -1,7 +1,9 @@
 package io.github.ggerganov.whispercpp;
 
 import com.sun.jna.Native;
+import com.sun.jna.NativeLong;
 import com.sun.jna.Pointer;
+import com.sun.jna.Structure;
 import io.github.ggerganov.whispercpp.bean.WhisperSegment;
 import io.github.ggerganov.whispercpp.params.WhisperContextParams;
 import io.github.ggerganov.whispercpp.params.WhisperFullParams;
@@ -10,6 +12,7 @@ import io.github.ggerganov.whispercpp.params.WhisperSamplingStrategy;
 import java.io.File;
 import java.io.FileNotFoundException;
 import java.io.IOException;
+import java.nio.FloatBuffer;
 import java.util.ArrayList;
 import java.util.List;
 
@@ -60,6 +63,8 @@ public class WhisperCpp implements AutoCloseable {
             modelPath = new File(modelDir(), modelPath).getAbsolutePath();
         }
 
+        checkParamsLayout();
+
         ctx = lib.whisper_init_from_file_with_params(modelPath, params);
 
         if (ctx == null) {
@@ -107,6 +112,22 @@ public class WhisperCpp implements AutoCloseable {
         return params;
     }
 
+    /**
+     * The params structs are passed by value, so a Java mirror that does not match the layout of the native
+     * library (e.g. built from a newer whisper.h) would hand whisper.cpp garbage - fail instead.
+     */
+    private void checkParamsLayout() {
+        checkSize(new WhisperContextParams(), lib.whisper_context_params_sizeof(), "whisper_context_params");
+        checkSize(new WhisperFullParams(), lib.whisper_full_params_sizeof(), "whisper_full_params");
+    }
+
+    private static void checkSize(Structure params, NativeLong nativeSize, String name) {
+        if (params.size() != nativeSize.longValue()) {
+            throw new IllegalStateException(name + " is " + nativeSize.longValue() + " bytes in the native library but "
+                + params.size() + " bytes in " + params.getClass().getSimpleName() + ", the bindings do not match whisper.h");
+        }
+    }
+
     @Override
     public void close() {
         freeContext();
@@ -197,6 +218,80 @@ public class WhisperCpp implements AutoCloseable {
 
         return segments;
     }
+    /**
+     * Allocates a state with its own decoding buffers, for transcribing concurrently with the context.
+     */
+    public WhisperCppState createState() {
+        if (ctx == null) {
+            throw new IllegalStateException("Model not initialised");
+        }
+
+        Pointer state = lib.whisper_init_state(ctx);
+        if (state == null) {
+            throw new IllegalStateException("Failed to allocate state");
+        }
+        return new WhisperCppState(lib, state);
+    }
+
+    /**
+     * Same as `fullTranscribeWithTime(whisperParams, audioData)` with the audio in a buffer, from its position
+     * to its limit. A direct buffer is passed to native code without copying it.
+     */
+    public List<WhisperSegment> fullTranscribeWithTime(WhisperFullParams.ByValue whisperParams, FloatBuffer audioData) throws IOException {
+        if (ctx == null) {
+            throw new IllegalStateException("Model not initialised");
+        }
+
+        return fullTranscribeWithState(lib.whisper_get_state(ctx), whisperParams, audioData);
+    }
+
+    /**
+     * Transcribes with the given state instead of the default state of the context.
+     * Not thread safe for the same state.
+     */
+    public List<WhisperSegment> fullTranscribeWithTime(WhisperCppState state, WhisperFullParams.ByValue whisperParams, float[] audioData) throws IOException {
+        if (ctx == null) {
+            throw new IllegalStateException("Model not initialised");
+        }
+
+        if (lib.whisper_full_with_state(ctx, state.pointer(), whisperParams, audioData, audioData.length) != 0) {
+            throw new IOException("Failed to process audio");
+        }
+
+        return getSegments(state.pointer());
+    }
+
+    public List<WhisperSegment> fullTranscribeWithTime(WhisperCppState state, WhisperFullParams.ByValue whisperParams, FloatBuffer audioData) throws IOException {
+        if (ctx == null) {
+            throw new IllegalStateException("Model not initialised");
+        }
+
+        return fullTranscribeWithState(state.pointer(), whisperParams, audioData);
+    }
+
+    private List<WhisperSegment> fullTranscribeWithState(Pointer state, WhisperFullParams.ByValue whisperParams, FloatBuffer audioData) throws IOException {
+        // slice() starts the buffer at its position, which is where native code reads from
+        FloatBuffer samples = audioData.slice();
+        if (lib.whisper_full_with_state(ctx, state, whisperParams, samples, samples.remaining()) != 0) {
+            throw new IOException("Failed to process audio");
+        }
+
+        return getSegments(state);
+    }
+
+    private List<WhisperSegment> getSegments(Pointer state) {
+        int nSegments = lib.whisper_full_n_segments_from_state(state);
+        List<WhisperSegment> segments = new ArrayList<>(nSegments);
+
+        for (int i = 0; i < nSegments; i++) {
+            long t0 = lib.whisper_full_get_segment_t0_from_state(state, i);
+            String text = lib.whisper_full_get_segment_text_from_state(state, i);
+            long t1 = lib.whisper_full_get_segment_t1_from_state(state, i);
+            segments.add(new WhisperSegment(t0, t1, text));
+        }
+
+        return segments;
+    }
 
 //    public int getTextSegmentCount(Pointer ctx) {
 //        return lib.whisper_full_n_segments(ctx);
@@ -2,12 +2,15 @@ package io.github.ggerganov.whispercpp;
 
 import com.sun.jna.Library;
 import com.sun.jna.Native;
+import com.sun.jna.NativeLong;
 import com.sun.jna.Pointer;
 import io.github.ggerganov.whispercpp.model.WhisperModelLoader;
 import io.github.ggerganov.whispercpp.model.WhisperTokenData;
 import io.github.ggerganov.whispercpp.params.WhisperContextParams;
 import io.github.ggerganov.whispercpp.params.WhisperFullParams;
 
+import java.nio.FloatBuffer;
+
 public interface WhisperCppJnaLibrary extends Library {
 
     WhisperCppJnaLibrary instance = Native.load("whisper", WhisperCppJnaLibrary.class);
@@ -93,6 +96,14 @@ public interface WhisperCppJnaLibrary extends Library {
      */
     Pointer whisper_init_state(Pointer ctx);
 
+    /**
+     * The default state of the Whisper context, owned by the context.
+     *
+     * @param ctx Whisper context
+     * @return Whisper state of the context, null for contexts initialised without a state
+     */
+    Pointer whisper_get_state(Pointer ctx);
+
     /**
      * Free all allocated memory associated with the Whisper context.
      *
@@ -268,6 +279,12 @@ public interface WhisperCppJnaLibrary extends Library {
 
     void whisper_free_params(Pointer params);
 
+    /** sizeof(whisper_context_params) of the native library, to check the layout of WhisperContextParams */
+    NativeLong whisper_context_params_sizeof();
+
+    /** sizeof(whisper_full_params) of the native library, to check the layout of WhisperFullParams */
+    NativeLong whisper_full_params_sizeof();
+
     /**
      * Run the entire model: PCM -&gt; log mel spectrogram -&gt; encoder -&gt; decoder -&gt; text
      * Not thread safe for same context
@@ -276,6 +293,9 @@ public interface WhisperCppJnaLibrary extends Library {
     int whisper_full(Pointer ctx, WhisperFullParams.ByValue params, final float[] samples, int n_samples);
 
     public int whisper_full_with_state(Pointer ctx, Pointer state, WhisperFullParams.ByValue params, float[] samples, int n_samples);
+
+    /** Same as above with the samples in a buffer. A direct buffer is passed to native code without copying it. */
+    int whisper_full_with_state(Pointer ctx, Pointer state, WhisperFullParams.ByValue params, FloatBuffer samples, int n_samples);
     //int whisper_full_with_state(Pointer ctx, Pointer state, WhisperFullParams params, final float[] samples, int n_samples);
 
     // Split the input audio in chunks and process each chunk separately using whisper_full_with_state()
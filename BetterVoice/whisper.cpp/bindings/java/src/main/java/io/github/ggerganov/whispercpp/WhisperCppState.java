@@ -0,0 +1,33 @@
+package io.github.ggerganov.whispercpp;
+
+import com.sun.jna.Pointer;
+
+/**
+ * Decoding buffers and results of one transcription, created by `WhisperCpp.createState()`.
+ * Each state can transcribe on its own thread, concurrently with the other states of the same context.
+ * Close the states before the `WhisperCpp` that created them.
+ */
+public class WhisperCppState implements AutoCloseable {
+    private final WhisperCppJnaLibrary lib;
+    private Pointer state;
+
+    WhisperCppState(WhisperCppJnaLibrary lib, Pointer state) {
+        this.lib = lib;
+        this.state = state;
+    }
+
+    Pointer pointer() {
+        if (state == null) {
+            throw new IllegalStateException("State closed");
+        }
+        return state;
+    }
+
+    @Override
+    public void close() {
+        if (state != null) {
+            lib.whisper_free_state(state);
+            state = null;
+        }
+    }
+}
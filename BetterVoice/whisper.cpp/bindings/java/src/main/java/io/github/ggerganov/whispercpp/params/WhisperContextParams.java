@@ -40,6 +40,96 @@ public class WhisperContextParams extends Structure {
     /** DTW memory size (internal use) */
     public NativeLong dtw_mem_size;
 
+    /** [EXPERIMENTAL] Type of the KV caches, a GGML_TYPE_* value (default = GGML_TYPE_F16) */
+    public int type_kv;
+
+    /** [EXPERIMENTAL] Map the model file instead of reading it (default = false) */
+    public CBool use_mmap;
+
+    /** Repack the CPU weights for the extra CPU buffer types (default = true) */
+    public CBool use_extra_bufts;
+
+    /** [EXPERIMENTAL] (Linux) Allocate the CPU buffers in huge pages (default = false) */
+    public CBool use_hugepages;
+
+    /** GELU of the MLPs on the CPU, a whisper_gelu_type value */
+    public int gelu_type;
+
+    /** [EXPERIMENTAL] Device of the text decoder, a whisper_decoder_placement value */
+    public int decoder_placement;
+
+    /** [EXPERIMENTAL] GPU of the text decoder, -1 for gpu_device (default = -1) */
+    public int decoder_gpu_device;
+
+    /** [EXPERIMENTAL] Keep the shape of the decoder graphs fixed on a GPU (default = false) */
+    public CBool decoder_graph_fixed;
+
+    /** [EXPERIMENTAL] "host:port" of a ggml-rpc server running the encoder, null to encode locally */
+    public String rpc_encoder;
+
+    /** Core ML compute units, a whisper_coreml_units value */
+    public int coreml_units;
+
+    /** [EXPERIMENTAL] Encode the next window with Core ML while decoding (default = false) */
+    public CBool coreml_async;
+
+    /** [EXPERIMENTAL] Use the stateful Core ML decoder (default = false) */
+    public CBool coreml_decoder;
+
+    /** [EXPERIMENTAL] Encode the next window with OpenVINO while decoding (default = false) */
+    public CBool openvino_async;
+
+    /** [EXPERIMENTAL] File caching the compute buffer sizes, null to always measure */
+    public String path_sched_cache;
+
+    /** [EXPERIMENTAL] Persistent CPU threadpool of each state (default = false) */
+    public CBool cpu_threadpool;
+
+    /** Polling level of the threadpool, 0 - no polling, 100 - aggressive polling (default = 50) */
+    public int cpu_poll;
+
+    /** Priority of the threadpool, a ggml_sched_priority value */
+    public int cpu_prio;
+
+    /** CPUs the threads may run on, bit i - CPU i, 0 for any */
+    public long cpu_mask;
+
+    /** [EXPERIMENTAL] Caller-owned ggml_threadpool used by every state, null for none */
+    public Pointer cpu_threadpool_shared;
+
+    /** [EXPERIMENTAL] Memory budget in bytes of the model and each state, 0 for no limit */
+    public NativeLong max_memory;
+
+    /** [EXPERIMENTAL] Reuse the conv stem output of overlapping windows (default = false) */
+    public CBool encoder_conv_cache;
+
+    /** [EXPERIMENTAL] Encoder self-attention block size in frames, 0 for full attention */
+    public int encoder_attn_chunk;
+
+    /** [EXPERIMENTAL] Bytes of F32 weight copies for the BLAS backend, 0 for none */
+    public NativeLong blas_weight_cache;
+
+    /** [EXPERIMENTAL] Replicate the CPU weights on each NUMA node (default = false) */
+    public CBool numa_replicate;
+
+    /** [EXPERIMENTAL] Keep only two encoder layers of weights in memory (default = false) */
+    public CBool encoder_stream_weights;
+
+    /** [EXPERIMENTAL] Compute the mel spectrogram in the encoder graph (default = false) */
+    public CBool encoder_mel_gpu;
+
+    /** Align the DTW timestamps while decoding (default = false) */
+    public CBool dtw_incremental;
+
+    /** [EXPERIMENTAL] Callback observing the computation, a whisper_eval_callback */
+    public Pointer cb_eval;
+
+    /** User data for the cb_eval */
+    public Pointer cb_eval_user_data;
+
+    /** [EXPERIMENTAL] Time every node of the graphs, see whisper_print_profile() (default = false) */
+    public CBool profile;
+
     /** Use GPU for inference */
     public void useGpu(boolean enable) {
         use_gpu = enable ? CBool.TRUE : CBool.FALSE;
@@ -70,7 +160,37 @@ public class WhisperContextParams extends Structure {
             "dtw_aheads_preset",
             "dtw_n_top",
             "dtw_aheads",
-            "dtw_mem_size"
+            "dtw_mem_size",
+            "type_kv",
+            "use_mmap",
+            "use_extra_bufts",
+            "use_hugepages",
+            "gelu_type",
+            "decoder_placement",
+            "decoder_gpu_device",
+            "decoder_graph_fixed",
+            "rpc_encoder",
+            "coreml_units",
+            "coreml_async",
+            "coreml_decoder",
+            "openvino_async",
+            "path_sched_cache",
+            "cpu_threadpool",
+            "cpu_poll",
+            "cpu_prio",
+            "cpu_mask",
+            "cpu_threadpool_shared",
+            "max_memory",
+            "encoder_conv_cache",
+            "encoder_attn_chunk",
+            "blas_weight_cache",
+            "numa_replicate",
+            "encoder_stream_weights",
+            "encoder_mel_gpu",
+            "dtw_incremental",
+            "cb_eval",
+            "cb_eval_user_data",
+            "profile"
         );
     }
 
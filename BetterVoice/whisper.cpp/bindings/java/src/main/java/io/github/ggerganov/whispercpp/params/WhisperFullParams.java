@@ -329,6 +329,102 @@ public class WhisperFullParams extends Structure {
     public long i_start_rule;
     public float grammar_penalty;
 
+    /** Enable Voice Activity Detection (default = false) */
+    public CBool vad;
+
+    /** Path to the VAD model */
+    public String vad_model_path;
+
+    /** VAD parameters */
+    public WhisperVadParams vad_params;
+
+    /** [EXPERIMENTAL] Encode the next window in a helper state while the current one is decoded. (default = false) */
+    public CBool pipeline_encode;
+
+    /** [EXPERIMENTAL] Greedy decoding: sample the next token in the decoder graph. (default = false) */
+    public CBool sample_on_device;
+
+    /** [EXPERIMENTAL] Draft model of speculative decoding (whisper_context*), null to disable. */
+    public Pointer draft_ctx;
+
+    /** [EXPERIMENTAL] Max tokens proposed by the draft model per decode. (default = 4) */
+    public int n_draft;
+
+    /** [EXPERIMENTAL] Decoder early exit layer, 0 to disable. */
+    public int decoder_exit_layer;
+
+    /** [EXPERIMENTAL] Min logprob margin of the best token to keep an early exit. (default = 2.0) */
+    public float decoder_exit_thold;
+
+    /** [EXPERIMENTAL] Speaker labels without a diarization model. (default = false) */
+    public CBool speaker_labels;
+
+    /** [EXPERIMENTAL] Max number of speakers. (default = 8) */
+    public int speaker_max;
+
+    /** [EXPERIMENTAL] Max spectrum distance in dB RMS of the same speaker. (default = 3.0) */
+    public float speaker_thold;
+
+    /** [EXPERIMENTAL] Tokens the transcription of the first window continues from. (int*) */
+    public Pointer prefix_tokens;
+
+    /** Number of prefix tokens. */
+    public int prefix_n_tokens;
+
+    /** Audio in ms of the fast language detection, 0 = a single full window. */
+    public int lang_detect_ms;
+
+    /** Probability of the top language that ends the fast language detection. (default = 0.8) */
+    public float lang_detect_thold;
+
+    /** [EXPERIMENTAL] Online fallback check: repeated n-grams, 0 = off. (default = 4) */
+    public int repeat_thold;
+
+    /** [EXPERIMENTAL] Online fallback check: average logprob floor, 0 = off. (default = -2.0) */
+    public float logprob_floor;
+
+    /** [EXPERIMENTAL] Skip a window when its no_speech_prob is above this, 0 = off. */
+    public float no_speech_exit_thold;
+
+    /** [EXPERIMENTAL] Decode the fallback temperatures in one batch. (default = false) */
+    public CBool parallel_fallback;
+
+    /** [EXPERIMENTAL] Onset-aware seek level in dB, 0 = off. */
+    public float onset_thold;
+
+    /** [EXPERIMENTAL] Chunked long-form: chunks decoded at the same time, 0 = off. */
+    public int chunk_batch;
+
+    /** [EXPERIMENTAL] Vocabulary shortlist (int*), null = off. */
+    public Pointer vocab_shortlist;
+
+    /** Number of tokens of the vocabulary shortlist. */
+    public int vocab_shortlist_n;
+
+    /** [EXPERIMENTAL] Continue the transcription of the state. (default = false) */
+    public CBool resume;
+
+    /** [EXPERIMENTAL] Adaptive beam width logprob margin, 0 = off. */
+    public float beam_adaptive_margin;
+
+    /** Contextual biasing phrases (const char**). */
+    public Pointer bias_phrases;
+
+    /** Weights of the biasing phrases (float*), null for bias_weight. */
+    public Pointer bias_weights;
+
+    /** Number of biasing phrases. */
+    public int n_bias_phrases;
+
+    /** Weight of the biasing phrases. (default = 2.0) */
+    public float bias_weight;
+
+    /** [EXPERIMENTAL] Noise suppression of the audio. (default = false) */
+    public CBool denoise;
+
+    /** Path to the denoise model. */
+    public String denoise_model_path;
+
     @Override
     protected List<String> getFieldOrder() {
         return Arrays.asList("strategy", "n_threads", "n_max_text_ctx",
@@ -347,7 +443,16 @@ public class WhisperFullParams extends Structure {
                 "encoder_begin_callback", "encoder_begin_callback_user_data",
                 "abort_callback", "abort_callback_user_data",
                 "logits_filter_callback", "logits_filter_callback_user_data",
-                "grammar_rules", "n_grammar_rules", "i_start_rule", "grammar_penalty");
+                "grammar_rules", "n_grammar_rules", "i_start_rule", "grammar_penalty",
+                "vad", "vad_model_path", "vad_params",
+                "pipeline_encode", "sample_on_device", "draft_ctx", "n_draft",
+                "decoder_exit_layer", "decoder_exit_thold",
+                "speaker_labels", "speaker_max", "speaker_thold",
+                "prefix_tokens", "prefix_n_tokens", "lang_detect_ms", "lang_detect_thold",
+                "repeat_thold", "logprob_floor", "no_speech_exit_thold", "parallel_fallback",
+                "onset_thold", "chunk_batch", "vocab_shortlist", "vocab_shortlist_n", "resume",
+                "beam_adaptive_margin", "bias_phrases", "bias_weights", "n_bias_phrases", "bias_weight",
+                "denoise", "denoise_model_path");
     }
 
     public static class ByValue extends WhisperFullParams implements Structure.ByValue {
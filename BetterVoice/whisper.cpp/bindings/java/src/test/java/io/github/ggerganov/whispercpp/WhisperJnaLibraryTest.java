@@ -2,6 +2,8 @@ package io.github.ggerganov.whispercpp;
 
 import static org.junit.jupiter.api.Assertions.*;
 
+import io.github.ggerganov.whispercpp.params.WhisperContextParams;
+import io.github.ggerganov.whispercpp.params.WhisperFullParams;
 import org.junit.jupiter.api.Test;
 
 class WhisperJnaLibraryTest {
@@ -14,4 +16,11 @@ class WhisperJnaLibraryTest {
         System.out.println("System info: " + systemInfo);
         assertTrue(systemInfo.length() > 10);
     }
+
+    @Test
+    void testParamsLayout() {
+        // the params are passed by value: the Java mirrors must have the size of the native structs
+        assertEquals(WhisperCppJnaLibrary.instance.whisper_context_params_sizeof().longValue(), new WhisperContextParams().size());
+        assertEquals(WhisperCppJnaLibrary.instance.whisper_full_params_sizeof().longValue(), new WhisperFullParams().size());
+    }
 }
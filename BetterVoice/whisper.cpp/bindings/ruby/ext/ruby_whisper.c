@@ -1,10 +1,12 @@
 #include <ruby.h>
 #include <ruby/memory_view.h>
+#include <ruby/thread.h>
 #include "ruby_whisper.h"
 
 VALUE mWhisper;
 VALUE mVAD;
 VALUE cContext;
+VALUE cState;
 VALUE cParams;
 VALUE cVADParams;
 VALUE eError;
@@ -28,6 +30,13 @@ ID id_n_processors;
 
 static bool is_log_callback_finalized = false;
 
+// Whether the current thread released the GVL to run whisper
+static _Thread_local bool is_without_gvl = false;
+
+// rb_protect state of a callback that raised while whisper ran without the GVL, rethrown when whisper returns.
+// The later callbacks are skipped so that nothing replaces the error info
+static _Thread_local int deferred_state = 0;
+
 // High level API
 extern VALUE ruby_whisper_segment_allocate(VALUE klass);
 
@@ -37,7 +46,57 @@ extern void init_ruby_whisper_error(VALUE *mWhisper);
 extern void init_ruby_whisper_segment(VALUE *mWhisper, VALUE *cSegment);
 extern void init_ruby_whisper_model(VALUE *mWhisper);
 extern void init_ruby_whisper_vad_params(VALUE *mVAD);
-extern void register_callbacks(ruby_whisper_params *rwp, VALUE *context);
+extern void init_ruby_whisper_state(VALUE *mWhisper);
+
+void *
+ruby_whisper_call_without_gvl(void *(*func)(void *), void *data, rb_unblock_function_t *ubf, void *data2)
+{
+  is_without_gvl = true;
+  deferred_state = 0;
+  void *result = rb_thread_call_without_gvl(func, data, ubf, data2);
+  is_without_gvl = false;
+  const int state = deferred_state;
+  deferred_state = 0;
+  if (state) {
+    rb_jump_tag(state);
+  }
+  return result;
+}
+
+typedef struct {
+  VALUE (*func)(VALUE);
+  VALUE arg;
+  int state;
+} ruby_whisper_protect_args;
+
+static void *
+ruby_whisper_protect(void *data)
+{
+  ruby_whisper_protect_args *args = (ruby_whisper_protect_args *)data;
+  rb_protect(args->func, args->arg, &args->state);
+  return NULL;
+}
+
+int
+ruby_whisper_call_with_gvl(VALUE (*func)(VALUE), VALUE arg)
+{
+  if (!is_without_gvl) {
+    // Other threads than the Ruby one are whisper's, which cannot take the GVL
+    if (ruby_native_thread_p()) {
+      func(arg);
+    }
+    return 0;
+  }
+  if (deferred_state) {
+    return deferred_state;
+  }
+  ruby_whisper_protect_args args = {func, arg, 0};
+  is_without_gvl = false;
+  rb_thread_call_with_gvl(ruby_whisper_protect, &args);
+  is_without_gvl = true;
+  deferred_state = args.state;
+  return args.state;
+}
 
 /*
  * call-seq:
@@ -99,14 +158,27 @@ static VALUE ruby_whisper_s_finalize_log_callback(VALUE self, VALUE id) {
   return Qnil;
 }
 
+typedef struct {
+  enum ggml_log_level level;
+  const char * buffer;
+} ruby_whisper_log_args;
+
+static VALUE
+ruby_whisper_call_log_callback(VALUE data) {
+  const ruby_whisper_log_args *args = (const ruby_whisper_log_args *)data;
+  VALUE log_callback = rb_iv_get(mWhisper, "log_callback");
+  VALUE udata = rb_iv_get(mWhisper, "user_data");
+  return rb_funcall(log_callback, id_call, 3, INT2NUM(args->level), rb_str_new2(args->buffer), udata);
+}
+
+// Messages of whisper's worker threads are dropped, they cannot run Ruby code
 static void
 ruby_whisper_log_callback(enum ggml_log_level level, const char * buffer, void * user_data) {
   if (is_log_callback_finalized) {
     return;
   }
-  VALUE log_callback = rb_iv_get(mWhisper, "log_callback");
-  VALUE udata = rb_iv_get(mWhisper, "user_data");
-  rb_funcall(log_callback, id_call, 3, INT2NUM(level), rb_str_new2(buffer), udata);
+  ruby_whisper_log_args args = {level, buffer};
+  ruby_whisper_call_with_gvl(ruby_whisper_call_log_callback, (VALUE)&args);
 }
 
 /*
@@ -165,6 +237,7 @@ void Init_whisper() {
   rb_define_private_method(rb_singleton_class(mWhisper), "finalize_log_callback", ruby_whisper_s_finalize_log_callback, 1);
 
   init_ruby_whisper_context(&mWhisper);
+  init_ruby_whisper_state(&mWhisper);
   init_ruby_whisper_params(&mWhisper);
   init_ruby_whisper_error(&mWhisper);
   init_ruby_whisper_segment(&mWhisper, &cContext);
@@ -4,7 +4,6 @@
 #include "whisper.h"
 
 typedef struct {
-  VALUE *context;
   VALUE user_data;
   VALUE callback;
   VALUE callbacks;
@@ -12,8 +11,15 @@ typedef struct {
 
 typedef struct {
   struct whisper_context *context;
+  VALUE mutex; // serializes the transcriptions on the default state
 } ruby_whisper;
 
+typedef struct {
+  VALUE context;
+  struct whisper_state *state;
+  VALUE mutex;
+} ruby_whisper_state;
+
 typedef struct {
   struct whisper_full_params params;
   bool diarize;
@@ -29,7 +35,7 @@ typedef struct {
 } ruby_whisper_vad_params;
 
 typedef struct {
-  VALUE context;
+  VALUE context; // Whisper::Context or Whisper::State holding the result
   int index;
 } ruby_whisper_segment;
 
@@ -37,4 +43,25 @@ typedef struct {
   VALUE context;
 } ruby_whisper_model;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// rb_thread_call_without_gvl() for the calls into whisper: raises the exception of a callback of whisper
+// (see ruby_whisper_call_with_gvl()) once func returned
+void *ruby_whisper_call_without_gvl(void *(*func)(void *), void *data, rb_unblock_function_t *ubf, void *data2);
+
+// Calls func(arg) with the GVL from a callback of whisper. On a thread that released the GVL with
+// ruby_whisper_call_without_gvl(), an exception of func is raised after whisper returns and the later calls are
+// skipped; on whisper's own worker threads func is not called. Returns non-zero if func raised
+int ruby_whisper_call_with_gvl(VALUE (*func)(VALUE), VALUE arg);
+
+// whisper_full_with_state() on state, or whisper_full_parallel() on the default state of context when state is nil,
+// with the GVL released. Raises the exceptions of the callbacks and Ruby interrupts, which abort the transcription
+int ruby_whisper_full_without_gvl(ruby_whisper_params *rwp, VALUE context, VALUE state, const float *samples, int n_samples, int n_processors);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
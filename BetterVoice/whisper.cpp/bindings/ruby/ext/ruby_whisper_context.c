@@ -23,7 +23,7 @@ extern const rb_data_type_t ruby_whisper_params_type;
 extern VALUE ruby_whisper_transcribe(int argc, VALUE *argv, VALUE self);
 extern VALUE rb_whisper_model_s_new(VALUE context);
 extern VALUE rb_whisper_segment_s_new(VALUE context, int index);
-extern void prepare_transcription(ruby_whisper_params *rwp, VALUE *context);
+void ruby_whisper_full_with_state(int argc, VALUE *argv, VALUE context, VALUE state);
 
 ID transcribe_option_names[1];
 
@@ -37,9 +37,10 @@ ruby_whisper_free(ruby_whisper *rw)
 }
 
 void
-rb_whisper_mark(ruby_whisper *rw)
+rb_whisper_mark(void *p)
 {
-  // call rb_gc_mark on any ruby references in rw
+  ruby_whisper *rw = (ruby_whisper *)p;
+  rb_gc_mark(rw->mutex);
 }
 
 void
@@ -66,7 +67,7 @@ ruby_whisper_memsize(const void *p)
 
 const rb_data_type_t ruby_whisper_type = {
   "ruby_whisper",
-  {0, rb_whisper_free, ruby_whisper_memsize,},
+  {rb_whisper_mark, rb_whisper_free, ruby_whisper_memsize,},
   0, 0,
   0
 };
@@ -77,6 +78,8 @@ ruby_whisper_allocate(VALUE klass)
   ruby_whisper *rw;
   VALUE obj = TypedData_Make_Struct(klass, ruby_whisper, &ruby_whisper_type, rw);
   rw->context = NULL;
+  rw->mutex = Qnil;
+  rw->mutex = rb_mutex_new();
   return obj;
 }
 
@@ -274,7 +277,8 @@ VALUE ruby_whisper_model_type(VALUE self)
 
 /*
  * Run the entire model: PCM -> log mel spectrogram -> encoder -> decoder -> text
- * Not thread safe for same context
+ * Runs without the GVL. Calls on the same context wait for each other, use a Whisper::State per thread to
+ * transcribe in parallel
  * Uses the specified decoding strategy to obtain the text.
  *
  * call-seq:
@@ -284,20 +288,34 @@ VALUE ruby_whisper_model_type(VALUE self)
  * The second argument +samples+ must be an array of samples, respond to :length, or be a MemoryView of an array of float. It must be 32 bit float PCM audio data.
  */
 VALUE ruby_whisper_full(int argc, VALUE *argv, VALUE self)
+{
+  ruby_whisper_full_with_state(argc, argv, self, Qnil);
+  return self;
+}
+
+/*
+ * Context#full and State#full: whisper_full on state, or on the default state of context when state is nil
+ */
+void
+ruby_whisper_full_with_state(int argc, VALUE *argv, VALUE context, VALUE state)
 {
   if (argc < 2 || argc > 3) {
     rb_raise(rb_eArgError, "wrong number of arguments (given %d, expected 2..3)", argc);
   }
 
-  ruby_whisper *rw;
   ruby_whisper_params *rwp;
-  TypedData_Get_Struct(self, ruby_whisper, &ruby_whisper_type, rw);
   VALUE params = argv[0];
   TypedData_Get_Struct(params, ruby_whisper_params, &ruby_whisper_params_type, rwp);
   VALUE samples = argv[1];
   int n_samples;
   rb_memory_view_t view;
   const bool memory_view_available_p = rb_memory_view_available_p(samples);
+  if (memory_view_available_p) {
+    if (!rb_memory_view_get(samples, &view, RUBY_MEMORY_VIEW_SIMPLE)) {
+      view.obj = Qnil;
+      rb_raise(rb_eArgError, "unable to get a memory view");
+    }
+  }
   if (argc == 3) {
     n_samples = NUM2INT(argv[2]);
     if (TYPE(samples) == T_ARRAY) {
@@ -313,10 +331,6 @@ VALUE ruby_whisper_full(int argc, VALUE *argv, VALUE self)
       }
       n_samples = (int)RARRAY_LEN(samples);
     } else if (memory_view_available_p) {
-      if (!rb_memory_view_get(samples, &view, RUBY_MEMORY_VIEW_SIMPLE)) {
-        view.obj = Qnil;
-        rb_raise(rb_eArgError, "unable to get a memory view");
-      }
       ssize_t n_samples_size = view.byte_size / view.item_size;
       if (n_samples_size > INT_MAX) {
         rb_raise(rb_eArgError, "samples are too long");
@@ -328,10 +342,13 @@ VALUE ruby_whisper_full(int argc, VALUE *argv, VALUE self)
       rb_raise(rb_eArgError, "samples must respond to :length or be a MemoryView of an array of flaot when n_samples is not given");
     }
   }
-  float * c_samples = (float *)malloc(n_samples * sizeof(float));
+  // Freed by the GC if a callback raises
+  VALUE samples_buffer = 0;
+  float * c_samples;
   if (memory_view_available_p)  {
     c_samples = (float *)view.data;
   } else {
+    c_samples = ALLOCV_N(float, samples_buffer, n_samples);
     if (TYPE(samples) == T_ARRAY) {
       for (int i = 0; i < n_samples; i++) {
         c_samples[i] = RFLOAT_VALUE(rb_ary_entry(samples, i));
@@ -346,19 +363,22 @@ VALUE ruby_whisper_full(int argc, VALUE *argv, VALUE self)
       }
     }
   }
-  prepare_transcription(rwp, &self);
-  const int result = whisper_full(rw->context, rwp->params, c_samples, n_samples);
-  if (0 == result) {
-    return self;
+  const int result = ruby_whisper_full_without_gvl(rwp, context, state, c_samples, n_samples, 1);
+  if (memory_view_available_p) {
+    rb_memory_view_release(&view);
   } else {
-    rb_exc_raise(rb_funcall(eError, id_new, 1, result));
+    ALLOCV_END(samples_buffer);
+  }
+  RB_GC_GUARD(samples);
+  if (0 != result) {
+    rb_exc_raise(rb_funcall(eError, id_new, 1, INT2NUM(result)));
   }
 }
 
 /*
  * Split the input audio in chunks and process each chunk separately using whisper_full_with_state()
  * Result is stored in the default state of the context
- * Not thread safe if executed in parallel on the same context.
+ * Runs without the GVL, calls on the same context wait for each other.
  * It seems this approach can offer some speedup in some cases.
  * However, the transcription accuracy can be worse at the beginning and end of each chunk.
  *
@@ -375,9 +395,7 @@ ruby_whisper_full_parallel(int argc, VALUE *argv,VALUE self)
     rb_raise(rb_eArgError, "wrong number of arguments (given %d, expected 2..3)", argc);
   }
 
-  ruby_whisper *rw;
   ruby_whisper_params *rwp;
-  TypedData_Get_Struct(self, ruby_whisper, &ruby_whisper_type, rw);
   VALUE params = argv[0];
   TypedData_Get_Struct(params, ruby_whisper_params, &ruby_whisper_params_type, rwp);
   VALUE samples = argv[1];
@@ -396,6 +414,12 @@ ruby_whisper_full_parallel(int argc, VALUE *argv,VALUE self)
     n_processors = NUM2INT(argv[3]);
     break;
   }
+  if (memory_view_available_p) {
+    if (!rb_memory_view_get(samples, &view, RUBY_MEMORY_VIEW_SIMPLE)) {
+      view.obj = Qnil;
+      rb_raise(rb_eArgError, "unable to get a memory view");
+    }
+  }
   if (argc >= 3 && !NIL_P(argv[2])) {
     n_samples = NUM2INT(argv[2]);
     if (TYPE(samples) == T_ARRAY) {
@@ -405,10 +429,6 @@ ruby_whisper_full_parallel(int argc, VALUE *argv,VALUE self)
     }
     // Should check when samples.respond_to?(:length)?
   } else if (memory_view_available_p) {
-    if (!rb_memory_view_get(samples, &view, RUBY_MEMORY_VIEW_SIMPLE)) {
-      view.obj = Qnil;
-      rb_raise(rb_eArgError, "unable to get a memory view");
-    }
     ssize_t n_samples_size = view.byte_size / view.item_size;
     if (n_samples_size > INT_MAX) {
       rb_raise(rb_eArgError, "samples are too long");
@@ -426,10 +446,12 @@ ruby_whisper_full_parallel(int argc, VALUE *argv,VALUE self)
       rb_raise(rb_eArgError, "samples must respond to :length or be a MemoryView of an array of flaot when n_samples is not given");
     }
   }
-  float * c_samples = (float *)malloc(n_samples * sizeof(float));
+  VALUE samples_buffer = 0;
+  float * c_samples;
   if (memory_view_available_p) {
     c_samples = (float *)view.data;
   } else {
+    c_samples = ALLOCV_N(float, samples_buffer, n_samples);
     if (TYPE(samples) == T_ARRAY) {
       for (int i = 0; i < n_samples; i++) {
         c_samples[i] = RFLOAT_VALUE(rb_ary_entry(samples, i));
@@ -444,12 +466,17 @@ ruby_whisper_full_parallel(int argc, VALUE *argv,VALUE self)
       }
     }
   }
-  prepare_transcription(rwp, &self);
-  const int result = whisper_full_parallel(rw->context, rwp->params, c_samples, n_samples, n_processors);
+  const int result = ruby_whisper_full_without_gvl(rwp, self, Qnil, c_samples, n_samples, n_processors);
+  if (memory_view_available_p) {
+    rb_memory_view_release(&view);
+  } else {
+    ALLOCV_END(samples_buffer);
+  }
+  RB_GC_GUARD(samples);
   if (0 == result) {
     return self;
   } else {
-    rb_exc_raise(rb_funcall(eError, id_new, 1, result));
+    rb_exc_raise(rb_funcall(eError, id_new, 1, INT2NUM(result)));
   }
 }
 
@@ -1,4 +1,5 @@
 #include <ruby.h>
+#include <stdatomic.h>
 #include "ruby_whisper.h"
 
 #define BOOL_PARAMS_SETTER(self, prop, value) \
@@ -36,6 +37,8 @@ extern ID id_call;
 extern VALUE ruby_whisper_normalize_model_path(VALUE model_path);
 extern VALUE rb_whisper_segment_s_new(VALUE context, int index);
 extern const rb_data_type_t ruby_whisper_vad_params_type;
+extern const rb_data_type_t ruby_whisper_type;
+extern const rb_data_type_t ruby_whisper_state_type;
 
 static ID param_names[RUBY_WHISPER_PARAMS_PARAM_NAMES_COUNT];
 static ID id_language;
@@ -89,141 +92,263 @@ static ruby_whisper_callback_container*
 rb_whisper_callback_container_allocate() {
   ruby_whisper_callback_container *container;
   container = ALLOC(ruby_whisper_callback_container);
-  container->context = NULL;
   container->user_data = Qnil;
   container->callback = Qnil;
   container->callbacks = rb_ary_new();
   return container;
 }
 
-static void new_segment_callback(struct whisper_context *ctx, struct whisper_state *state, int n_new, void *user_data) {
-  const ruby_whisper_callback_container *container = (ruby_whisper_callback_container *)user_data;
+static bool
+rb_whisper_callback_container_empty_p(const ruby_whisper_callback_container *container) {
+  return NIL_P(container->callback) && 0 == RARRAY_LEN(container->callbacks);
+}
+
+// A transcription in progress, the user data of the callbacks of whisper
+typedef struct {
+  ruby_whisper_params *rwp;
+  struct whisper_full_params params;
+  VALUE context;
+  VALUE state; // Whisper::State, nil on the default state of context
+  struct whisper_context *whisper_context;
+  struct whisper_state *whisper_state;
+  const float *samples;
+  int n_samples;
+  int n_processors;
+  int result;
+  atomic_bool aborted; // by a Ruby interrupt or a callback that raised, read by all threads of whisper
+} ruby_whisper_full_call;
+
+typedef struct {
+  ruby_whisper_full_call *call;
+  VALUE (*func)(VALUE);
+  struct whisper_state *state;
+  int value;
+  bool result;
+} ruby_whisper_callback_args;
+
+static VALUE
+call_new_segment_callbacks(VALUE data) {
+  const ruby_whisper_callback_args *args = (const ruby_whisper_callback_args *)data;
+  const ruby_whisper_full_call *call = args->call;
+  const ruby_whisper_callback_container *container = call->rwp->new_segment_callback_container;
 
-  // Currently, doesn't support state because
-  // those require to resolve GC-related problems.
   if (!NIL_P(container->callback)) {
-    rb_funcall(container->callback, id_call, 4, *container->context, Qnil, INT2NUM(n_new), container->user_data);
+    rb_funcall(container->callback, id_call, 4, call->context, call->state, INT2NUM(args->value), container->user_data);
   }
   const long callbacks_len = RARRAY_LEN(container->callbacks);
   if (0 == callbacks_len) {
-    return;
+    return Qnil;
   }
-  const int n_segments = whisper_full_n_segments_from_state(state);
-  for (int i = n_new; i > 0; i--) {
+  const VALUE owner = NIL_P(call->state) ? call->context : call->state;
+  const int n_segments = whisper_full_n_segments_from_state(args->state);
+  for (int i = args->value; i > 0; i--) {
     int i_segment = n_segments - i;
-    VALUE segment = rb_whisper_segment_s_new(*container->context, i_segment);
+    VALUE segment = rb_whisper_segment_s_new(owner, i_segment);
     for (int j = 0; j < callbacks_len; j++) {
       VALUE cb = rb_ary_entry(container->callbacks, j);
       rb_funcall(cb, id_call, 1, segment);
     }
   }
+  return Qnil;
 }
 
-static void progress_callback(struct whisper_context *ctx, struct whisper_state *state, int progress_cur, void *user_data) {
-  const ruby_whisper_callback_container *container = (ruby_whisper_callback_container *)user_data;
-  const VALUE progress = INT2NUM(progress_cur);
-  // Currently, doesn't support state because
-  // those require to resolve GC-related problems.
+static VALUE
+call_progress_callbacks(VALUE data) {
+  const ruby_whisper_callback_args *args = (const ruby_whisper_callback_args *)data;
+  const ruby_whisper_full_call *call = args->call;
+  const ruby_whisper_callback_container *container = call->rwp->progress_callback_container;
+  const VALUE progress = INT2NUM(args->value);
+
   if (!NIL_P(container->callback)) {
-    rb_funcall(container->callback, id_call, 4, *container->context, Qnil, progress, container->user_data);
+    rb_funcall(container->callback, id_call, 4, call->context, call->state, progress, container->user_data);
   }
   const long callbacks_len = RARRAY_LEN(container->callbacks);
-  if (0 == callbacks_len) {
-    return;
-  }
   for (int j = 0; j < callbacks_len; j++) {
     VALUE cb = rb_ary_entry(container->callbacks, j);
     rb_funcall(cb, id_call, 1, progress);
   }
+  return Qnil;
 }
 
-static bool encoder_begin_callback(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
-  const ruby_whisper_callback_container *container = (ruby_whisper_callback_container *)user_data;
-  bool is_aborted = false;
+static VALUE
+call_encoder_begin_callbacks(VALUE data) {
+  ruby_whisper_callback_args *args = (ruby_whisper_callback_args *)data;
+  const ruby_whisper_full_call *call = args->call;
+  const ruby_whisper_callback_container *container = call->rwp->encoder_begin_callback_container;
   VALUE result;
 
-  // Currently, doesn't support state because
-  // those require to resolve GC-related problems.
   if (!NIL_P(container->callback)) {
-    result = rb_funcall(container->callback, id_call, 3, *container->context, Qnil, container->user_data);
+    result = rb_funcall(container->callback, id_call, 3, call->context, call->state, container->user_data);
     if (result == Qfalse) {
-      is_aborted = true;
+      args->result = false;
     }
   }
   const long callbacks_len = RARRAY_LEN(container->callbacks);
-  if (0 == callbacks_len) {
-    return !is_aborted;
-  }
   for (int j = 0; j < callbacks_len; j++) {
     VALUE cb = rb_ary_entry(container->callbacks, j);
     result = rb_funcall(cb, id_call, 0);
     if (result == Qfalse) {
-      is_aborted = true;
+      args->result = false;
     }
   }
-  return !is_aborted;
+  return Qnil;
 }
 
-static bool abort_callback(void * user_data) {
-  const ruby_whisper_callback_container *container = (ruby_whisper_callback_container *)user_data;
+static VALUE
+call_abort_callbacks(VALUE data) {
+  ruby_whisper_callback_args *args = (ruby_whisper_callback_args *)data;
+  const ruby_whisper_callback_container *container = args->call->rwp->abort_callback_container;
+
   if (!NIL_P(container->callback)) {
     VALUE result = rb_funcall(container->callback, id_call, 1, container->user_data);
     if (!NIL_P(result) && Qfalse != result) {
-      return true;
+      args->result = true;
+      return Qnil;
     }
   }
   const long callbacks_len = RARRAY_LEN(container->callbacks);
-  if (0 == callbacks_len) {
-    return false;
-  }
   for (int j = 0; j < callbacks_len; j++) {
     VALUE cb = rb_ary_entry(container->callbacks, j);
     VALUE result = rb_funcall(cb, id_call, 1, container->user_data);
     if (!NIL_P(result) && Qfalse != result) {
-      return true;
+      args->result = true;
+      return Qnil;
     }
   }
-  return false;
+  return Qnil;
+}
+
+// An exception cannot unwind through whisper: it aborts the transcription and is raised after it
+static void
+run_callbacks(ruby_whisper_callback_args *args) {
+  if (!atomic_load(&args->call->aborted) && ruby_whisper_call_with_gvl(args->func, (VALUE)args)) {
+    atomic_store(&args->call->aborted, true);
+  }
+}
+
+static void new_segment_callback(struct whisper_context *ctx, struct whisper_state *state, int n_new, void *user_data) {
+  ruby_whisper_callback_args args = {(ruby_whisper_full_call *)user_data, call_new_segment_callbacks, state, n_new, false};
+  run_callbacks(&args);
 }
 
-static void register_callbacks(ruby_whisper_params * rwp, VALUE * context) {
-  if (!NIL_P(rwp->new_segment_callback_container->callback) || 0 != RARRAY_LEN(rwp->new_segment_callback_container->callbacks)) {
-    rwp->new_segment_callback_container->context = context;
-    rwp->params.new_segment_callback = new_segment_callback;
-    rwp->params.new_segment_callback_user_data = rwp->new_segment_callback_container;
+static void progress_callback(struct whisper_context *ctx, struct whisper_state *state, int progress_cur, void *user_data) {
+  ruby_whisper_callback_args args = {(ruby_whisper_full_call *)user_data, call_progress_callbacks, state, progress_cur, false};
+  run_callbacks(&args);
+}
+
+static bool encoder_begin_callback(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+  ruby_whisper_callback_args args = {(ruby_whisper_full_call *)user_data, call_encoder_begin_callbacks, state, 0, true};
+  run_callbacks(&args);
+  return args.result && !atomic_load(&args.call->aborted);
+}
+
+// Polled by every thread of whisper, the Ruby callbacks only run on the thread of the transcription
+static bool abort_callback(void * user_data) {
+  ruby_whisper_full_call *call = (ruby_whisper_full_call *)user_data;
+  if (!rb_whisper_callback_container_empty_p(call->rwp->abort_callback_container)) {
+    ruby_whisper_callback_args args = {call, call_abort_callbacks, NULL, 0, false};
+    run_callbacks(&args);
+    if (args.result) {
+      atomic_store(&call->aborted, true);
+    }
   }
+  return atomic_load(&call->aborted);
+}
+
+static void register_callbacks(ruby_whisper_full_call *call) {
+  const ruby_whisper_params *rwp = call->rwp;
 
-  if (!NIL_P(rwp->progress_callback_container->callback) || 0 != RARRAY_LEN(rwp->progress_callback_container->callbacks)) {
-    rwp->progress_callback_container->context = context;
-    rwp->params.progress_callback = progress_callback;
-    rwp->params.progress_callback_user_data = rwp->progress_callback_container;
+  if (!rb_whisper_callback_container_empty_p(rwp->new_segment_callback_container)) {
+    call->params.new_segment_callback = new_segment_callback;
+    call->params.new_segment_callback_user_data = call;
   }
 
-  if (!NIL_P(rwp->encoder_begin_callback_container->callback) || 0 != RARRAY_LEN(rwp->encoder_begin_callback_container->callbacks)) {
-    rwp->encoder_begin_callback_container->context = context;
-    rwp->params.encoder_begin_callback = encoder_begin_callback;
-    rwp->params.encoder_begin_callback_user_data = rwp->encoder_begin_callback_container;
+  if (!rb_whisper_callback_container_empty_p(rwp->progress_callback_container)) {
+    call->params.progress_callback = progress_callback;
+    call->params.progress_callback_user_data = call;
   }
 
-  if (!NIL_P(rwp->abort_callback_container->callback) || 0 != RARRAY_LEN(rwp->abort_callback_container->callbacks)) {
-    rwp->abort_callback_container->context = context;
-    rwp->params.abort_callback = abort_callback;
-    rwp->params.abort_callback_user_data = rwp->abort_callback_container;
+  if (!rb_whisper_callback_container_empty_p(rwp->encoder_begin_callback_container)) {
+    call->params.encoder_begin_callback = encoder_begin_callback;
+    call->params.encoder_begin_callback_user_data = call;
   }
+
+  // Also how Ruby interrupts stop whisper
+  call->params.abort_callback = abort_callback;
+  call->params.abort_callback_user_data = call;
 }
 
-static void set_vad_params(ruby_whisper_params *rwp)
+static void set_vad_params(ruby_whisper_full_call *call)
 {
   ruby_whisper_vad_params * rwvp;
-  TypedData_Get_Struct(rwp->vad_params, ruby_whisper_vad_params, &ruby_whisper_vad_params_type, rwvp);
-  rwp->params.vad_params = rwvp->params;
+  TypedData_Get_Struct(call->rwp->vad_params, ruby_whisper_vad_params, &ruby_whisper_vad_params_type, rwvp);
+  call->params.vad_params = rwvp->params;
 }
 
-void
-prepare_transcription(ruby_whisper_params *rwp, VALUE *context)
+// Without the GVL
+static void *
+full_without_gvl(void *data)
+{
+  ruby_whisper_full_call *call = (ruby_whisper_full_call *)data;
+  if (call->whisper_state) {
+    call->result = whisper_full_with_state(call->whisper_context, call->whisper_state, call->params, call->samples, call->n_samples);
+  } else {
+    call->result = whisper_full_parallel(call->whisper_context, call->params, call->samples, call->n_samples, call->n_processors);
+  }
+  return NULL;
+}
+
+// Thread#raise, Thread#kill, signals: whisper stops at its next abort_callback poll
+static void
+full_unblock(void *data)
+{
+  ruby_whisper_full_call *call = (ruby_whisper_full_call *)data;
+  atomic_store(&call->aborted, true);
+}
+
+static VALUE
+full_synchronized(VALUE data)
+{
+  ruby_whisper_call_without_gvl(full_without_gvl, (void *)data, full_unblock, (void *)data);
+  return Qnil;
+}
+
+int
+ruby_whisper_full_without_gvl(ruby_whisper_params *rwp, VALUE context, VALUE state, const float *samples, int n_samples, int n_processors)
 {
-  register_callbacks(rwp, context);
-  set_vad_params(rwp);
+  ruby_whisper *rw;
+  TypedData_Get_Struct(context, ruby_whisper, &ruby_whisper_type, rw);
+
+  ruby_whisper_full_call call;
+  call.rwp = rwp;
+  call.params = rwp->params;
+  call.context = context;
+  call.state = state;
+  call.whisper_context = rw->context;
+  call.whisper_state = NULL;
+  call.samples = samples;
+  call.n_samples = n_samples;
+  call.n_processors = n_processors;
+  call.result = 0;
+  atomic_init(&call.aborted, false);
+
+  // One transcription at a time on a state, the others wait for it with the GVL released
+  VALUE mutex = rw->mutex;
+  if (!NIL_P(state)) {
+    ruby_whisper_state *rwst;
+    TypedData_Get_Struct(state, ruby_whisper_state, &ruby_whisper_state_type, rwst);
+    call.whisper_state = rwst->state;
+    mutex = rwst->mutex;
+  }
+
+  register_callbacks(&call);
+  set_vad_params(&call);
+
+  rb_mutex_synchronize(mutex, full_synchronized, (VALUE)&call);
+  RB_GC_GUARD(context);
+  RB_GC_GUARD(state);
+
+  return call.result;
 }
 
 void
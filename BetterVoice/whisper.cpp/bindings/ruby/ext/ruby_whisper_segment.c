@@ -11,6 +11,7 @@ static VALUE sym_speaker_turn_next;
 static VALUE key_names;
 
 extern const rb_data_type_t ruby_whisper_type;
+extern const rb_data_type_t ruby_whisper_state_type;
 
 extern VALUE cSegment;
 
@@ -57,6 +58,22 @@ rb_whisper_segment_s_new(VALUE context, int index)
   return segment;
 };
 
+// The state holding the result of the segment, NULL when it is the default state of *context
+static struct whisper_state *
+ruby_whisper_segment_state(const ruby_whisper_segment *rws, struct whisper_context **context)
+{
+  if (rb_typeddata_is_kind_of(rws->context, &ruby_whisper_state_type)) {
+    ruby_whisper_state *rwst;
+    TypedData_Get_Struct(rws->context, ruby_whisper_state, &ruby_whisper_state_type, rwst);
+    *context = NULL;
+    return rwst->state;
+  }
+  ruby_whisper *rw;
+  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
+  *context = rw->context;
+  return NULL;
+}
+
 /*
  * Start time in milliseconds.
  *
@@ -68,9 +85,9 @@ ruby_whisper_segment_get_start_time(VALUE self)
 {
   ruby_whisper_segment *rws;
   TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-  const int64_t t0 = whisper_full_get_segment_t0(rw->context, rws->index);
+  struct whisper_context *context;
+  struct whisper_state *state = ruby_whisper_segment_state(rws, &context);
+  const int64_t t0 = state ? whisper_full_get_segment_t0_from_state(state, rws->index) : whisper_full_get_segment_t0(context, rws->index);
   // able to multiply 10 without overflow because to_timestamp() in whisper.cpp does it
   return LONG2NUM(t0 * 10);
 }
@@ -86,9 +103,9 @@ ruby_whisper_segment_get_end_time(VALUE self)
 {
   ruby_whisper_segment *rws;
   TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-  const int64_t t1 = whisper_full_get_segment_t1(rw->context, rws->index);
+  struct whisper_context *context;
+  struct whisper_state *state = ruby_whisper_segment_state(rws, &context);
+  const int64_t t1 = state ? whisper_full_get_segment_t1_from_state(state, rws->index) : whisper_full_get_segment_t1(context, rws->index);
   // able to multiply 10 without overflow because to_timestamp() in whisper.cpp does it
   return LONG2NUM(t1 * 10);
 }
@@ -104,9 +121,10 @@ ruby_whisper_segment_get_speaker_turn_next(VALUE self)
 {
   ruby_whisper_segment *rws;
   TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-  return whisper_full_get_segment_speaker_turn_next(rw->context, rws->index) ? Qtrue : Qfalse;
+  struct whisper_context *context;
+  struct whisper_state *state = ruby_whisper_segment_state(rws, &context);
+  const bool speaker_turn_next = state ? whisper_full_get_segment_speaker_turn_next_from_state(state, rws->index) : whisper_full_get_segment_speaker_turn_next(context, rws->index);
+  return speaker_turn_next ? Qtrue : Qfalse;
 }
 
 /*
@@ -118,9 +136,9 @@ ruby_whisper_segment_get_text(VALUE self)
 {
   ruby_whisper_segment *rws;
   TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-  const char * text = whisper_full_get_segment_text(rw->context, rws->index);
+  struct whisper_context *context;
+  struct whisper_state *state = ruby_whisper_segment_state(rws, &context);
+  const char * text = state ? whisper_full_get_segment_text_from_state(state, rws->index) : whisper_full_get_segment_text(context, rws->index);
   return rb_str_new2(text);
 }
 
@@ -133,9 +151,10 @@ ruby_whisper_segment_get_no_speech_prob(VALUE self)
 {
   ruby_whisper_segment *rws;
   TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-  return DBL2NUM(whisper_full_get_segment_no_speech_prob(rw->context, rws->index));
+  struct whisper_context *context;
+  struct whisper_state *state = ruby_whisper_segment_state(rws, &context);
+  const float no_speech_prob = state ? whisper_full_get_segment_no_speech_prob_from_state(state, rws->index) : whisper_full_get_segment_no_speech_prob(context, rws->index);
+  return DBL2NUM(no_speech_prob);
 }
 
 /*
@@ -153,11 +172,6 @@ ruby_whisper_segment_get_no_speech_prob(VALUE self)
 static VALUE
 ruby_whisper_segment_deconstruct_keys(VALUE self, VALUE keys)
 {
-  ruby_whisper_segment *rws;
-  TypedData_Get_Struct(self, ruby_whisper_segment, &ruby_whisper_segment_type, rws);
-  ruby_whisper *rw;
-  TypedData_Get_Struct(rws->context, ruby_whisper, &ruby_whisper_type, rw);
-
   VALUE hash = rb_hash_new();
   long n_keys;
   if (NIL_P(keys)) {
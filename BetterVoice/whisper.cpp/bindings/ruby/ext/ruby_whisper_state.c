@@ -0,0 +1,218 @@
+#include <ruby.h>
+#include "ruby_whisper.h"
+
+extern ID id___method__;
+extern ID id_to_enum;
+
+extern VALUE cContext;
+extern VALUE cState;
+
+extern const rb_data_type_t ruby_whisper_type;
+
+extern VALUE rb_whisper_segment_s_new(VALUE context, int index);
+extern void ruby_whisper_full_with_state(int argc, VALUE *argv, VALUE context, VALUE state);
+
+static void
+rb_whisper_state_mark(void *p)
+{
+  ruby_whisper_state *rwst = (ruby_whisper_state *)p;
+  rb_gc_mark(rwst->context);
+  rb_gc_mark(rwst->mutex);
+}
+
+static void
+rb_whisper_state_free(void *p)
+{
+  ruby_whisper_state *rwst = (ruby_whisper_state *)p;
+  if (rwst->state) {
+    whisper_free_state(rwst->state);
+    rwst->state = NULL;
+  }
+  free(rwst);
+}
+
+static size_t
+ruby_whisper_state_memsize(const void *p)
+{
+  const ruby_whisper_state *rwst = (const ruby_whisper_state *)p;
+  if (!rwst) {
+    return 0;
+  }
+  return sizeof(*rwst);
+}
+
+const rb_data_type_t ruby_whisper_state_type = {
+  "ruby_whisper_state",
+  {rb_whisper_state_mark, rb_whisper_state_free, ruby_whisper_state_memsize,},
+  0, 0,
+  0
+};
+
+static VALUE
+ruby_whisper_state_allocate(VALUE klass)
+{
+  ruby_whisper_state *rwst;
+  VALUE obj = TypedData_Make_Struct(klass, ruby_whisper_state, &ruby_whisper_state_type, rwst);
+  rwst->context = Qnil;
+  rwst->state = NULL;
+  rwst->mutex = Qnil;
+  rwst->mutex = rb_mutex_new();
+  return obj;
+}
+
+static ruby_whisper_state *
+ruby_whisper_state_get(VALUE self)
+{
+  ruby_whisper_state *rwst;
+  TypedData_Get_Struct(self, ruby_whisper_state, &ruby_whisper_state_type, rwst);
+  if (rwst->state == NULL) {
+    rb_raise(rb_eRuntimeError, "Whisper::State is not initialized");
+  }
+  return rwst;
+}
+
+/*
+ * Decoding state of its own for a transcription on the model of +context+: its KV caches, compute buffers and
+ * results. Threads, each with a state, transcribe in parallel on one loaded model:
+ *
+ *   whisper = Whisper::Context.new("base.en")
+ *   threads = paths.map {|path|
+ *     Thread.new {
+ *       state = Whisper::State.new(whisper)
+ *       state.full(params, read_samples(path))
+ *       state.each_segment.map(&:text).join
+ *     }
+ *   }
+ *
+ * call-seq:
+ *   new(context) -> Whisper::State
+ */
+static VALUE
+ruby_whisper_state_initialize(VALUE self, VALUE context)
+{
+  ruby_whisper_state *rwst;
+  ruby_whisper *rw;
+  TypedData_Get_Struct(self, ruby_whisper_state, &ruby_whisper_state_type, rwst);
+  TypedData_Get_Struct(context, ruby_whisper, &ruby_whisper_type, rw);
+  if (rw->context == NULL) {
+    rb_raise(rb_eArgError, "Whisper::Context is not initialized");
+  }
+  if (rwst->state) {
+    rb_raise(rb_eRuntimeError, "Whisper::State is already initialized");
+  }
+
+  rwst->state = whisper_init_state(rw->context);
+  if (rwst->state == NULL) {
+    rb_raise(rb_eRuntimeError, "error: failed to initialize whisper state");
+  }
+  rwst->context = context;
+  return self;
+}
+
+/*
+ * call-seq:
+ *   context -> Whisper::Context
+ */
+static VALUE
+ruby_whisper_state_get_context(VALUE self)
+{
+  return ruby_whisper_state_get(self)->context;
+}
+
+/*
+ * Run the entire model on this state: PCM -> log mel spectrogram -> encoder -> decoder -> text
+ * Runs without the GVL, in parallel with the transcriptions on other states of the same context.
+ * Calls on the same state wait for each other.
+ *
+ * call-seq:
+ *   full(params, samples, n_samples) -> self
+ *   full(params, samples) -> self
+ *
+ * +samples+ as in Whisper::Context#full
+ */
+static VALUE
+ruby_whisper_state_full(int argc, VALUE *argv, VALUE self)
+{
+  ruby_whisper_state *rwst = ruby_whisper_state_get(self);
+  ruby_whisper_full_with_state(argc, argv, rwst->context, self);
+  return self;
+}
+
+/*
+ * Number of segments.
+ *
+ * call-seq:
+ *   full_n_segments -> Integer
+ */
+static VALUE
+ruby_whisper_state_full_n_segments(VALUE self)
+{
+  return INT2NUM(whisper_full_n_segments_from_state(ruby_whisper_state_get(self)->state));
+}
+
+/*
+ * Language ID of the last transcription on this state.
+ *
+ * call-seq:
+ *   full_lang_id -> Integer
+ */
+static VALUE
+ruby_whisper_state_full_lang_id(VALUE self)
+{
+  return INT2NUM(whisper_full_lang_id_from_state(ruby_whisper_state_get(self)->state));
+}
+
+/*
+ * call-seq:
+ *   full_get_segment(segment_index) -> Whisper::Segment
+ */
+static VALUE
+ruby_whisper_state_full_get_segment(VALUE self, VALUE i_segment)
+{
+  ruby_whisper_state *rwst = ruby_whisper_state_get(self);
+  const int c_i_segment = NUM2INT(i_segment);
+  if (c_i_segment < 0 || c_i_segment >= whisper_full_n_segments_from_state(rwst->state)) {
+    rb_raise(rb_eIndexError, "segment index %d out of range", c_i_segment);
+  }
+  return rb_whisper_segment_s_new(self, c_i_segment);
+}
+
+/*
+ * Yields each Whisper::Segment of the last transcription on this state, or returns an Enumerator if no block given.
+ *
+ * call-seq:
+ *   each_segment {|segment| ... }
+ *   each_segment -> Enumerator
+ */
+static VALUE
+ruby_whisper_state_each_segment(VALUE self)
+{
+  if (!rb_block_given_p()) {
+    const VALUE method_name = rb_funcall(self, id___method__, 0);
+    return rb_funcall(self, id_to_enum, 1, method_name);
+  }
+
+  ruby_whisper_state *rwst = ruby_whisper_state_get(self);
+
+  const int n_segments = whisper_full_n_segments_from_state(rwst->state);
+  for (int i = 0; i < n_segments; ++i) {
+    rb_yield(rb_whisper_segment_s_new(self, i));
+  }
+
+  return self;
+}
+
+void
+init_ruby_whisper_state(VALUE *mWhisper)
+{
+  cState = rb_define_class_under(*mWhisper, "State", rb_cObject);
+
+  rb_define_alloc_func(cState, ruby_whisper_state_allocate);
+  rb_define_method(cState, "initialize", ruby_whisper_state_initialize, 1);
+  rb_define_method(cState, "context", ruby_whisper_state_get_context, 0);
+  rb_define_method(cState, "full", ruby_whisper_state_full, -1);
+  rb_define_method(cState, "full_n_segments", ruby_whisper_state_full_n_segments, 0);
+  rb_define_method(cState, "full_lang_id", ruby_whisper_state_full_lang_id, 0);
+  rb_define_method(cState, "full_get_segment", ruby_whisper_state_full_get_segment, 1);
+  rb_define_method(cState, "each_segment", ruby_whisper_state_each_segment, 0);
+}
@@ -1,6 +1,7 @@
 require_relative "helper"
 require "stringio"
 require "etc"
+require "timeout"
 
 # Exists to detect memory-related bug
 Whisper.log_set ->(level, buffer, user_data) {}, nil
@@ -248,6 +249,88 @@ class TestWhisper < TestBase
       assert_match(/ask what you can do/i, text)
       assert_match(/for your country/i, text)
     end
+
+    def test_full_releases_gvl
+      ticks = 0
+      thread = Thread.new { @whisper.full(@params, @samples) }
+      ticks += 1 while thread.alive?
+      thread.join
+
+      assert ticks > 0
+      assert_equal 1, @whisper.full_n_segments
+    end
+
+    def test_full_interrupt
+      assert_raise Timeout::Error do
+        Timeout.timeout(0.1) do
+          @whisper.full(@params, @samples * 20)
+        end
+      end
+    end
+
+    def test_full_callback_exception
+      @params.on_new_segment do |segment|
+        raise ArgumentError, "from callback"
+      end
+      assert_raise ArgumentError do
+        @whisper.full(@params, @samples)
+      end
+    end
+  end
+
+  sub_test_case "State" do
+    def setup
+      super
+      @whisper = Whisper::Context.new("base.en")
+      @samples = File.read(AUDIO, nil, 78).unpack("s<*").collect {|i| i.to_f / 2**15}
+    end
+
+    def test_full
+      state = Whisper::State.new(@whisper)
+      state.full(@params, @samples)
+
+      assert_same @whisper, state.context
+      assert_equal 1, state.full_n_segments
+      assert_equal 0, state.full_lang_id
+      assert_match(/ask not what your country can do for you, ask what you can do for your country/, state.full_get_segment(0).text)
+      assert_raise IndexError do
+        state.full_get_segment(1)
+      end
+    end
+
+    def test_full_keeps_context_results
+      @whisper.full(@params, @samples.take(16000))
+      n_segments = @whisper.full_n_segments
+      Whisper::State.new(@whisper).full(@params, @samples)
+
+      assert_equal n_segments, @whisper.full_n_segments
+    end
+
+    def test_full_in_threads
+      texts = 3.times.collect {
+        Thread.new {
+          state = Whisper::State.new(@whisper)
+          state.full(@params, @samples)
+          state.each_segment.collect(&:text).join
+        }
+      }.collect(&:value)
+
+      texts.each do |text|
+        assert_match(/ask not what your country can do for you, ask what you can do for your country/, text)
+      end
+    end
+
+    def test_new_segment_callback_state
+      state = Whisper::State.new(@whisper)
+      yielded = nil
+      @params.new_segment_callback = ->(context, s, n_new, user_data) {
+        yielded = [context, s]
+      }
+      state.full(@params, @samples)
+
+      assert_same @whisper, yielded[0]
+      assert_same state, yielded[1]
+    end
   end
 
   def test_to_srt
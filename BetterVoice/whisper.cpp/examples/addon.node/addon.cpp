@@ -10,6 +10,9 @@
 #include <cmath>
 #include <cstdint>
 #include <cfloat>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 struct whisper_params {
     int32_t n_threads    = std::min(4, (int32_t) std::thread::hardware_concurrency());
@@ -70,11 +73,11 @@ struct whisper_print_user_data {
     const std::vector<std::vector<float>> * pcmf32s;
 };
 
-void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
+void whisper_print_segment_callback(struct whisper_context * /*ctx*/, struct whisper_state * state, int n_new, void * user_data) {
     const auto & params  = *((whisper_print_user_data *) user_data)->params;
     const auto & pcmf32s = *((whisper_print_user_data *) user_data)->pcmf32s;
 
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
 
     std::string speaker = "";
 
@@ -90,8 +93,8 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
 
     for (int i = s0; i < n_segments; i++) {
         if (!params.no_timestamps || params.diarize) {
-            t0 = whisper_full_get_segment_t0(ctx, i);
-            t1 = whisper_full_get_segment_t1(ctx, i);
+            t0 = whisper_full_get_segment_t0_from_state(state, i);
+            t1 = whisper_full_get_segment_t1_from_state(state, i);
         }
 
         if (!params.no_timestamps && !params.no_prints) {
@@ -126,7 +129,7 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
         // colorful print bug
         //
         if (!params.no_prints) {
-            const char * text = whisper_full_get_segment_text(ctx, i);
+            const char * text = whisper_full_get_segment_text_from_state(state, i);
             printf("%s%s", speaker.c_str(), text);
         }
 
@@ -147,6 +150,87 @@ struct whisper_result {
     std::string language;
 };
 
+// the inference parameters of params, without the callbacks
+static whisper_full_params make_full_params(const whisper_params & params) {
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+
+    wparams.print_realtime   = false;
+    wparams.print_progress   = params.print_progress;
+    wparams.print_timestamps = !params.no_timestamps;
+    wparams.print_special    = params.print_special;
+    wparams.translate        = params.translate;
+    wparams.language         = params.detect_language ? "auto" : params.language.c_str();
+    wparams.detect_language  = params.detect_language;
+    wparams.n_threads        = params.n_threads;
+    wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
+    wparams.offset_ms        = params.offset_t_ms;
+    wparams.duration_ms      = params.duration_ms;
+
+    wparams.token_timestamps = params.output_wts || params.max_len > 0;
+    wparams.thold_pt         = params.word_thold;
+    wparams.entropy_thold    = params.entropy_thold;
+    wparams.logprob_thold    = params.logprob_thold;
+    wparams.max_len          = params.output_wts && params.max_len == 0 ? 60 : params.max_len;
+    wparams.audio_ctx        = params.audio_ctx;
+
+    wparams.greedy.best_of        = params.best_of;
+    wparams.beam_search.beam_size = params.beam_size;
+
+    wparams.initial_prompt   = params.prompt.c_str();
+
+    wparams.no_timestamps    = params.no_timestamps;
+
+    // Set VAD parameters
+    wparams.vad            = params.vad;
+    wparams.vad_model_path = params.vad_model.c_str();
+
+    wparams.vad_params.threshold               = params.vad_threshold;
+    wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
+    wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
+    wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
+    wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
+    wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
+
+    return wparams;
+}
+
+static void read_result(struct whisper_state * state, const whisper_params & params, whisper_result & result) {
+    if (params.detect_language || params.language == "auto") {
+        result.language = whisper_lang_str(whisper_full_lang_id_from_state(state));
+    }
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    result.segments.resize(n_segments);
+
+    for (int i = 0; i < n_segments; ++i) {
+        const char * text = whisper_full_get_segment_text_from_state(state, i);
+        const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+        const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+
+        result.segments[i].emplace_back(to_timestamp(t0, params.comma_in_time));
+        result.segments[i].emplace_back(to_timestamp(t1, params.comma_in_time));
+        result.segments[i].emplace_back(text);
+    }
+}
+
+static Napi::Object result_to_object(Napi::Env env, const whisper_result & result) {
+    Napi::Object returnObj = Napi::Object::New(env);
+    if (!result.language.empty()) {
+        returnObj.Set("language", Napi::String::New(env, result.language));
+    }
+    Napi::Array transcriptionArray = Napi::Array::New(env, result.segments.size());
+    for (uint64_t i = 0; i < result.segments.size(); ++i) {
+        Napi::Object tmp = Napi::Array::New(env, 3);
+        for (uint64_t j = 0; j < 3; ++j) {
+            tmp[j] = Napi::String::New(env, result.segments[i][j]);
+        }
+        transcriptionArray[i] = tmp;
+    }
+    returnObj.Set("transcription", transcriptionArray);
+    return returnObj;
+}
+
 class ProgressWorker : public Napi::AsyncWorker {
  public:
     ProgressWorker(Napi::Function& callback, whisper_params params, Napi::Function progress_callback, Napi::Env env)
@@ -184,20 +268,7 @@ class ProgressWorker : public Napi::AsyncWorker {
             Callback().Call({Env().Null(), resultObj});
         }
 
-        Napi::Object returnObj = Napi::Object::New(Env());
-        if (!result.language.empty()) {
-            returnObj.Set("language", Napi::String::New(Env(), result.language));
-        }
-        Napi::Array transcriptionArray = Napi::Array::New(Env(), result.segments.size());
-        for (uint64_t i = 0; i < result.segments.size(); ++i) {
-            Napi::Object tmp = Napi::Array::New(Env(), 3);
-            for (uint64_t j = 0; j < 3; ++j) {
-                tmp[j] = Napi::String::New(Env(), result.segments[i][j]);
-            }
-            transcriptionArray[i] = tmp;
-         }
-         returnObj.Set("transcription", transcriptionArray);
-         Callback().Call({Env().Null(), returnObj});
+        Callback().Call({Env().Null(), result_to_object(Env(), result)});
     }
 
     // Progress callback function - using thread-safe function
@@ -299,35 +370,7 @@ class ProgressWorker : public Napi::AsyncWorker {
 
             // Run inference
             {
-                whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-
-                wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
-
-                wparams.print_realtime   = false;
-                wparams.print_progress   = params.print_progress;
-                wparams.print_timestamps = !params.no_timestamps;
-                wparams.print_special    = params.print_special;
-                wparams.translate        = params.translate;
-                wparams.language         = params.detect_language ? "auto" : params.language.c_str();
-                wparams.detect_language  = params.detect_language;
-                wparams.n_threads        = params.n_threads;
-                wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
-                wparams.offset_ms        = params.offset_t_ms;
-                wparams.duration_ms      = params.duration_ms;
-
-                wparams.token_timestamps = params.output_wts || params.max_len > 0;
-                wparams.thold_pt         = params.word_thold;
-                wparams.entropy_thold    = params.entropy_thold;
-                wparams.logprob_thold    = params.logprob_thold;
-                wparams.max_len          = params.output_wts && params.max_len == 0 ? 60 : params.max_len;
-                wparams.audio_ctx        = params.audio_ctx;
-
-                wparams.greedy.best_of        = params.best_of;
-                wparams.beam_search.beam_size = params.beam_size;
-
-                wparams.initial_prompt   = params.prompt.c_str();
-
-                wparams.no_timestamps    = params.no_timestamps;
+                whisper_full_params wparams = make_full_params(params);
 
                 whisper_print_user_data user_data = { &params, &pcmf32s };
 
@@ -344,17 +387,6 @@ class ProgressWorker : public Napi::AsyncWorker {
                 };
                 wparams.progress_callback_user_data = this;
 
-                // Set VAD parameters
-                wparams.vad            = params.vad;
-                wparams.vad_model_path = params.vad_model.c_str();
-
-                wparams.vad_params.threshold               = params.vad_threshold;
-                wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
-                wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
-                wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
-                wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
-                wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
-
                 if (whisper_full_parallel(ctx, wparams, pcmf32.data(), pcmf32.size(), params.n_processors) != 0) {
                     fprintf(stderr, "failed to process audio\n");
                     return 10;
@@ -362,21 +394,7 @@ class ProgressWorker : public Napi::AsyncWorker {
             }
         }
 
-        if (params.detect_language || params.language == "auto") {
-            result.language = whisper_lang_str(whisper_full_lang_id(ctx));
-        }
-        const int n_segments = whisper_full_n_segments(ctx);
-        result.segments.resize(n_segments);
-
-        for (int i = 0; i < n_segments; ++i) {
-            const char * text = whisper_full_get_segment_text(ctx, i);
-            const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-            const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-
-            result.segments[i].emplace_back(to_timestamp(t0, params.comma_in_time));
-            result.segments[i].emplace_back(to_timestamp(t1, params.comma_in_time));
-            result.segments[i].emplace_back(text);
-        }
+        read_result(whisper_get_state(ctx), params, result);
 
         whisper_print_timings(ctx);
         whisper_free(ctx);
@@ -385,17 +403,24 @@ class ProgressWorker : public Napi::AsyncWorker {
     }
 };
 
-Napi::Value whisper(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  if (info.Length() <= 0 || !info[0].IsObject()) {
-    Napi::TypeError::New(env, "object expected").ThrowAsJavaScriptException();
+// the parameters of a call, from its options object
+static whisper_params parse_params(Napi::Object whisper_params) {
+  struct whisper_params params;
+
+  std::string language = "en";
+  if (whisper_params.Has("language") && whisper_params.Get("language").IsString()) {
+    language = whisper_params.Get("language").As<Napi::String>();
   }
-  whisper_params params;
 
-  Napi::Object whisper_params = info[0].As<Napi::Object>();
-  std::string language = whisper_params.Get("language").As<Napi::String>();
-  std::string model = whisper_params.Get("model").As<Napi::String>();
-  std::string input = whisper_params.Get("fname_inp").As<Napi::String>();
+  std::string model = "";
+  if (whisper_params.Has("model") && whisper_params.Get("model").IsString()) {
+    model = whisper_params.Get("model").As<Napi::String>();
+  }
+
+  std::string input = "";
+  if (whisper_params.Has("fname_inp") && whisper_params.Get("fname_inp").IsString()) {
+    input = whisper_params.Get("fname_inp").As<Napi::String>();
+  }
 
   bool use_gpu = true;
   if (whisper_params.Has("use_gpu") && whisper_params.Get("use_gpu").IsBoolean()) {
@@ -454,11 +479,6 @@ Napi::Value whisper(const Napi::CallbackInfo& info) {
   if (whisper_params.Has("print_progress") && whisper_params.Get("print_progress").IsBoolean()) {
     print_progress = whisper_params.Get("print_progress").As<Napi::Boolean>();
   }
-  // Add support for progress_callback
-  Napi::Function progress_callback;
-  if (whisper_params.Has("progress_callback") && whisper_params.Get("progress_callback").IsFunction()) {
-    progress_callback = whisper_params.Get("progress_callback").As<Napi::Function>();
-  }
 
   // Add support for VAD parameters
   bool vad = false;
@@ -514,7 +534,9 @@ Napi::Value whisper(const Napi::CallbackInfo& info) {
 
   params.language = language;
   params.model = model;
-  params.fname_inp.emplace_back(input);
+  if (!input.empty()) {
+    params.fname_inp.emplace_back(input);
+  }
   params.use_gpu = use_gpu;
   params.flash_attn = flash_attn;
   params.no_prints = no_prints;
@@ -538,6 +560,537 @@ Napi::Value whisper(const Napi::CallbackInfo& info) {
   params.vad_speech_pad_ms = vad_speech_pad_ms;
   params.vad_samples_overlap = vad_samples_overlap;
 
+  return params;
+}
+
+class PoolWorker;
+
+// A model loaded once, for many transcriptions. Each runs on a state of a pool of n_states, so that up to n_states
+// of them run at the same time on the shared weights - the others wait in the order of the calls. Streams get a
+// state of their own
+class WhisperModel : public Napi::ObjectWrap<WhisperModel> {
+ public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    WhisperModel(const Napi::CallbackInfo & info);
+    ~WhisperModel();
+
+    whisper_context * ctx = nullptr;
+    int n_streams = 0;
+
+    // called on the main thread when a transcription is done with its state
+    void release(whisper_state * state);
+
+ private:
+    Napi::Value Transcribe  (const Napi::CallbackInfo & info);
+    Napi::Value CreateStream(const Napi::CallbackInfo & info);
+    Napi::Value Free        (const Napi::CallbackInfo & info);
+
+    void free_all();
+
+    std::vector<whisper_state *> states;
+    std::vector<whisper_state *> states_free;
+
+    // transcriptions waiting for a state, queued once they get one
+    std::deque<PoolWorker *> pending;
+    int n_running = 0;
+};
+
+// One transcription of a WhisperModel on a state of its pool
+class PoolWorker : public Napi::AsyncWorker {
+ public:
+    PoolWorker(Napi::Function & callback, WhisperModel * model, Napi::Object model_obj, whisper_params params, Napi::Function progress_callback, Napi::Env env)
+        : Napi::AsyncWorker(callback), model(model), model_ref(Napi::Persistent(model_obj)), params(std::move(params)) {
+        if (!progress_callback.IsEmpty()) {
+            tsfn = Napi::ThreadSafeFunction::New(env, progress_callback, "Progress Callback", 0, 1);
+        }
+    }
+
+    ~PoolWorker() {
+        if (tsfn) {
+            tsfn.Release();
+        }
+    }
+
+    whisper_state * state = nullptr;
+
+    void Execute() override {
+        std::vector<float> pcmf32 = params.pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+
+        if (pcmf32.empty()) {
+            if (params.fname_inp.empty()) {
+                SetError("no input file or audio buffer specified");
+                return;
+            }
+            if (!::read_audio_data(params.fname_inp[0], pcmf32, pcmf32s, params.diarize)) {
+                SetError("failed to read audio file '" + params.fname_inp[0] + "'");
+                return;
+            }
+        }
+
+        whisper_full_params wparams = make_full_params(params);
+
+        whisper_print_user_data user_data = { &params, &pcmf32s };
+        wparams.new_segment_callback           = whisper_print_segment_callback;
+        wparams.new_segment_callback_user_data = &user_data;
+
+        if (tsfn) {
+            wparams.progress_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, int progress, void * user_data) {
+                static_cast<PoolWorker *>(user_data)->tsfn.BlockingCall([progress](Napi::Env env, Napi::Function jsCallback) {
+                    jsCallback.Call({Napi::Number::New(env, progress)});
+                });
+            };
+            wparams.progress_callback_user_data = this;
+        }
+
+        if (whisper_full_with_state(model->ctx, state, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+            SetError("failed to process audio");
+            return;
+        }
+
+        read_result(state, params, result);
+    }
+
+    void OnOK() override {
+        Napi::HandleScope scope(Env());
+        model->release(state);
+        Callback().Call({Env().Null(), result_to_object(Env(), result)});
+    }
+
+    void OnError(const Napi::Error & e) override {
+        Napi::HandleScope scope(Env());
+        model->release(state);
+        Callback().Call({e.Value()});
+    }
+
+ private:
+    WhisperModel * model;
+    Napi::ObjectReference model_ref; // keeps the model alive until the transcription is done
+    whisper_params params;
+    whisper_result result;
+    Napi::ThreadSafeFunction tsfn;
+};
+
+// A streaming transcription on a state of its own: the pushed audio is decoded on a worker thread every step_ms
+// over the last length_ms (as examples/stream does), and each decode emits a segment event with the text of the
+// current window. The window is final, and the next one starts, every length_ms
+class WhisperStream : public Napi::ObjectWrap<WhisperStream> {
+ public:
+    static Napi::FunctionReference constructor;
+
+    static void Init(Napi::Env env);
+
+    WhisperStream(const Napi::CallbackInfo & info);
+    ~WhisperStream();
+
+ private:
+    Napi::Value Push(const Napi::CallbackInfo & info);
+    Napi::Value End (const Napi::CallbackInfo & info);
+
+    void run();
+    void emit(const std::string & text, int64_t t0_ms, int64_t t1_ms, bool final);
+
+    WhisperModel * model = nullptr;
+    Napi::ObjectReference model_ref;
+    whisper_state * state = nullptr;
+    whisper_params params;
+
+    int n_samples_step = 0;
+    int n_samples_len  = 0;
+    int n_samples_keep = 0;
+
+    Napi::ThreadSafeFunction tsfn_segment;
+    Napi::ThreadSafeFunction tsfn_end;
+
+    // guarded by mutex
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<float> pcm_pushed;
+    bool ending = false;
+
+    std::thread worker;
+};
+
+Napi::FunctionReference WhisperStream::constructor;
+
+struct stream_segment {
+    std::string text;
+    int64_t t0_ms;
+    int64_t t1_ms;
+    bool final;
+};
+
+void WhisperStream::Init(Napi::Env env) {
+    Napi::Function func = DefineClass(env, "WhisperStream", {
+        InstanceMethod("push", &WhisperStream::Push),
+        InstanceMethod("end",  &WhisperStream::End),
+    });
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+}
+
+// new WhisperStream(model, params, on_segment), from WhisperModel.createStream()
+WhisperStream::WhisperStream(const Napi::CallbackInfo & info) : Napi::ObjectWrap<WhisperStream>(info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object model_obj = info[0].As<Napi::Object>();
+    Napi::Object options   = info[1].As<Napi::Object>();
+
+    model     = WhisperModel::Unwrap(model_obj);
+    model_ref = Napi::Persistent(model_obj);
+    params    = parse_params(options);
+
+    int step_ms   = 3000;
+    int length_ms = 10000;
+    int keep_ms   = 200;
+    if (options.Has("step_ms") && options.Get("step_ms").IsNumber()) {
+        step_ms = options.Get("step_ms").As<Napi::Number>();
+    }
+    if (options.Has("length_ms") && options.Get("length_ms").IsNumber()) {
+        length_ms = options.Get("length_ms").As<Napi::Number>();
+    }
+    if (options.Has("keep_ms") && options.Get("keep_ms").IsNumber()) {
+        keep_ms = options.Get("keep_ms").As<Napi::Number>();
+    }
+
+    step_ms   = std::max(step_ms, 100);
+    length_ms = std::max(length_ms, step_ms);
+    keep_ms   = std::min(std::max(keep_ms, 0), step_ms);
+
+    n_samples_step = (int64_t) step_ms  *WHISPER_SAMPLE_RATE/1000;
+    n_samples_len  = (int64_t) length_ms*WHISPER_SAMPLE_RATE/1000;
+    n_samples_keep = (int64_t) keep_ms  *WHISPER_SAMPLE_RATE/1000;
+
+    state = whisper_init_state(model->ctx);
+    if (state == nullptr) {
+        Napi::Error::New(env, "failed to initialize whisper state").ThrowAsJavaScriptException();
+        return;
+    }
+
+    tsfn_segment = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "Stream Segment", 0, 1);
+
+    // kept alive by the worker until the end callback
+    Ref();
+    model->n_streams++;
+
+    worker = std::thread(&WhisperStream::run, this);
+}
+
+WhisperStream::~WhisperStream() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (state) {
+        whisper_free_state(state);
+    }
+}
+
+// push(Float32Array | ArrayBuffer of float samples): 16 kHz mono PCM, copied - never waits for the decoding
+Napi::Value WhisperStream::Push(const Napi::CallbackInfo & info) {
+    Napi::Env env = info.Env();
+
+    const float * data = nullptr;
+    size_t n = 0;
+    if (info.Length() > 0 && info[0].IsTypedArray() && info[0].As<Napi::TypedArray>().TypedArrayType() == napi_float32_array) {
+        Napi::Float32Array arr = info[0].As<Napi::Float32Array>();
+        data = arr.Data();
+        n    = arr.ElementLength();
+    } else if (info.Length() > 0 && info[0].IsArrayBuffer()) {
+        Napi::ArrayBuffer buf = info[0].As<Napi::ArrayBuffer>();
+        data = static_cast<const float *>(buf.Data());
+        n    = buf.ByteLength()/sizeof(float);
+    } else {
+        Napi::TypeError::New(env, "Float32Array or ArrayBuffer expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ending) {
+            Napi::Error::New(env, "push after end").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        pcm_pushed.insert(pcm_pushed.end(), data, data + n);
+    }
+    cv.notify_one();
+
+    return env.Undefined();
+}
+
+// end(callback): decodes the rest of the audio, emits its final segment, then calls callback()
+Napi::Value WhisperStream::End(const Napi::CallbackInfo & info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() <= 0 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "callback expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ending) {
+        Napi::Error::New(env, "stream already ended").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    tsfn_end = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "Stream End", 0, 1);
+    ending = true;
+    cv.notify_one();
+
+    return env.Undefined();
+}
+
+void WhisperStream::emit(const std::string & text, int64_t t0_ms, int64_t t1_ms, bool final) {
+    tsfn_segment.BlockingCall(new stream_segment{ text, t0_ms, t1_ms, final }, [](Napi::Env env, Napi::Function jsCallback, stream_segment * seg) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("text",  Napi::String::New(env, seg->text));
+        obj.Set("t0",    Napi::Number::New(env, (double) seg->t0_ms));
+        obj.Set("t1",    Napi::Number::New(env, (double) seg->t1_ms));
+        obj.Set("final", Napi::Boolean::New(env, seg->final));
+        delete seg;
+        jsCallback.Call({obj});
+    });
+}
+
+void WhisperStream::run() {
+    const int n_new_line = std::max(1, n_samples_len/n_samples_step - 1);
+
+    whisper_full_params wparams = make_full_params(params);
+    wparams.print_progress   = false;
+    wparams.print_timestamps = false;
+    wparams.no_timestamps    = true;
+    wparams.single_segment   = true;
+    wparams.no_context       = true;
+    wparams.max_tokens       = 0;
+
+    std::vector<float> pcm_old;
+    std::vector<float> pcm_new;
+    std::vector<float> pcm;
+
+    int64_t n_samples_done = 0; // of the stream, before pcm_new
+    int n_iter = 0;
+
+    while (true) {
+        bool last = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return ending || (int) pcm_pushed.size() >= n_samples_step; });
+
+            last = ending;
+            pcm_new.swap(pcm_pushed);
+            pcm_pushed.clear();
+        }
+
+        if (!pcm_new.empty()) {
+            // the end of the previous window as context, as examples/stream does
+            const int n_samples_new  = pcm_new.size();
+            const int n_samples_take = std::min((int) pcm_old.size(), std::max(0, n_samples_keep + n_samples_len - n_samples_new));
+
+            pcm.assign(pcm_old.end() - n_samples_take, pcm_old.end());
+            pcm.insert(pcm.end(), pcm_new.begin(), pcm_new.end());
+
+            std::string text;
+            if (whisper_full_with_state(model->ctx, state, wparams, pcm.data(), pcm.size()) == 0) {
+                const int n_segments = whisper_full_n_segments_from_state(state);
+                for (int i = 0; i < n_segments; ++i) {
+                    text += whisper_full_get_segment_text_from_state(state, i);
+                }
+            } else {
+                fprintf(stderr, "%s: failed to process audio\n", __func__);
+            }
+
+            n_samples_done += n_samples_new;
+            n_iter++;
+
+            const bool final = last || n_iter % n_new_line == 0;
+            emit(text, (n_samples_done - (int64_t) pcm.size())*1000/WHISPER_SAMPLE_RATE, n_samples_done*1000/WHISPER_SAMPLE_RATE, final);
+
+            if (final) {
+                pcm_old.assign(pcm.end() - std::min((int) pcm.size(), n_samples_keep), pcm.end());
+            } else {
+                pcm_old.swap(pcm);
+            }
+        }
+
+        if (last) {
+            break;
+        }
+    }
+
+    tsfn_segment.Release();
+
+    tsfn_end.BlockingCall(this, [](Napi::Env /*env*/, Napi::Function jsCallback, WhisperStream * stream) {
+        stream->model->n_streams--;
+        stream->model_ref.Reset();
+        jsCallback.Call(std::initializer_list<napi_value>{});
+        stream->Unref();
+    });
+    tsfn_end.Release();
+}
+
+Napi::Object WhisperModel::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "WhisperModel", {
+        InstanceMethod("transcribe",   &WhisperModel::Transcribe),
+        InstanceMethod("createStream", &WhisperModel::CreateStream),
+        InstanceMethod("free",         &WhisperModel::Free),
+    });
+
+    exports.Set("WhisperModel", func);
+    return exports;
+}
+
+// new WhisperModel({ model, use_gpu, flash_attn, n_states }): loads the model, synchronously
+WhisperModel::WhisperModel(const Napi::CallbackInfo & info) : Napi::ObjectWrap<WhisperModel>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() <= 0 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "object expected").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    const whisper_params params = parse_params(options);
+
+    int n_states = 1;
+    if (options.Has("n_states") && options.Get("n_states").IsNumber()) {
+        n_states = std::max(1, (int) options.Get("n_states").As<Napi::Number>().Int32Value());
+    }
+
+    if (params.no_prints) {
+        whisper_log_set(cb_log_disable, NULL);
+    }
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu    = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+
+    ctx = whisper_init_from_file_with_params_no_state(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        Napi::Error::New(env, "failed to initialize whisper context").ThrowAsJavaScriptException();
+        return;
+    }
+
+    for (int i = 0; i < n_states; ++i) {
+        whisper_state * state = whisper_init_state(ctx);
+        if (state == nullptr) {
+            free_all();
+            Napi::Error::New(env, "failed to initialize whisper state").ThrowAsJavaScriptException();
+            return;
+        }
+        states.push_back(state);
+    }
+    states_free = states;
+}
+
+WhisperModel::~WhisperModel() {
+    free_all();
+}
+
+void WhisperModel::free_all() {
+    for (whisper_state * state : states) {
+        whisper_free_state(state);
+    }
+    states.clear();
+    states_free.clear();
+
+    if (ctx) {
+        whisper_free(ctx);
+        ctx = nullptr;
+    }
+}
+
+void WhisperModel::release(whisper_state * state) {
+    n_running--;
+
+    if (pending.empty()) {
+        states_free.push_back(state);
+        return;
+    }
+
+    PoolWorker * worker = pending.front();
+    pending.pop_front();
+
+    worker->state = state;
+    n_running++;
+    worker->Queue();
+}
+
+// transcribe(params, callback): same params and result as whisper(), without the model options
+Napi::Value WhisperModel::Transcribe(const Napi::CallbackInfo & info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "object and callback expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (ctx == nullptr) {
+        Napi::Error::New(env, "model is freed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+
+    Napi::Function progress_callback;
+    if (options.Has("progress_callback") && options.Get("progress_callback").IsFunction()) {
+        progress_callback = options.Get("progress_callback").As<Napi::Function>();
+    }
+
+    Napi::Function callback = info[1].As<Napi::Function>();
+    PoolWorker * worker = new PoolWorker(callback, this, Value(), parse_params(options), progress_callback, env);
+
+    if (states_free.empty()) {
+        pending.push_back(worker);
+    } else {
+        worker->state = states_free.back();
+        states_free.pop_back();
+        n_running++;
+        worker->Queue();
+    }
+
+    return env.Undefined();
+}
+
+// createStream(params, on_segment): params as transcribe() plus step_ms, length_ms and keep_ms
+Napi::Value WhisperModel::CreateStream(const Napi::CallbackInfo & info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "object and callback expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (ctx == nullptr) {
+        Napi::Error::New(env, "model is freed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    return WhisperStream::constructor.New({ Value(), info[0], info[1] });
+}
+
+// free(): releases the model now instead of when it is garbage collected
+Napi::Value WhisperModel::Free(const Napi::CallbackInfo & info) {
+    Napi::Env env = info.Env();
+    if (n_running > 0 || !pending.empty() || n_streams > 0) {
+        Napi::Error::New(env, "model is in use").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    free_all();
+
+    return env.Undefined();
+}
+
+Napi::Value whisper(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() <= 0 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "object expected").ThrowAsJavaScriptException();
+  }
+  Napi::Object whisper_params = info[0].As<Napi::Object>();
+  struct whisper_params params = parse_params(whisper_params);
+
+  // Add support for progress_callback
+  Napi::Function progress_callback;
+  if (whisper_params.Has("progress_callback") && whisper_params.Get("progress_callback").IsFunction()) {
+    progress_callback = whisper_params.Get("progress_callback").As<Napi::Function>();
+  }
+
   Napi::Function callback = info[1].As<Napi::Function>();
   // Create a new Worker class with progress callback support
   ProgressWorker* worker = new ProgressWorker(callback, params, progress_callback, env);
@@ -551,7 +1104,8 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
       Napi::String::New(env, "whisper"),
       Napi::Function::New(env, whisper)
   );
-  return exports;
+  WhisperStream::Init(env);
+  return WhisperModel::Init(env, exports);
 }
 
 NODE_API_MODULE(whisper, Init);
@@ -0,0 +1,251 @@
+// Always-on listening: streaming Silero VAD that wakes the whisper encoder only for speech windows
+
+#pragma once
+
+#include "whisper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+
+//
+// The captured audio is pushed into the streaming VAD as it arrives (whisper_vad_stream_push), which costs a few
+// percent of one core. The audio of a speech run - with speech_pad_ms before and after it - is closed into a
+// window after min_silence_ms of silence, or at max_speech_ms. Only then does the consumer run whisper, between
+// active_begin() and active_end(). The latter parks the CPU threadpool of the whisper context (see
+// whisper_context_params.cpu_threadpool), so the model stays resident but no thread spins while idle.
+//
+// The counters tell the time spent active (running whisper) and idle (only the VAD running), to check the
+// battery impact of a listening session.
+//
+
+struct always_listen_params {
+    float threshold       = 0.5f;  // speech probability of a VAD window
+    int   min_speech_ms   = 250;   // shorter speech windows are dropped
+    int   min_silence_ms  = 500;   // silence that closes a speech window
+    int   max_speech_ms   = 8000;  // longer speech is closed into several windows
+    int   speech_pad_ms   = 200;   // audio kept before and after the speech
+};
+
+struct always_listen_stats {
+    int64_t t_active_us = 0; // between active_begin() and active_end()
+    int64_t t_idle_us   = 0; // the rest of the session, only the VAD runs
+    int64_t t_vad_us    = 0; // spent in the VAD
+    int64_t n_samples   = 0; // audio pushed
+    int32_t n_windows   = 0; // speech windows closed
+    int32_t n_dropped   = 0; // speech windows shorter than min_speech_ms
+    int32_t n_wake      = 0; // active_begin() calls
+};
+
+// Run the calling thread with the utility QoS class, which macOS schedules on the efficiency cores.
+// No-op elsewhere
+static inline void always_listen_set_efficiency_qos() {
+#ifdef __APPLE__
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+}
+
+// Back to the default QoS class for the latency-sensitive part, e.g. before running whisper on a speech window
+static inline void always_listen_set_interactive_qos() {
+#ifdef __APPLE__
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INITIATED, 0);
+#endif
+}
+
+class always_listen {
+public:
+    // vctx is not owned, ctx (may be NULL) gets its threadpool parked by active_end()
+    always_listen(struct whisper_vad_context * vctx, struct whisper_context * ctx, int sample_rate, const always_listen_params & params)
+        : m_vctx(vctx), m_ctx(ctx), m_params(params) {
+        m_n_pad     = (int64_t) params.speech_pad_ms  * sample_rate / 1000;
+        m_n_silence = (int64_t) params.min_silence_ms * sample_rate / 1000;
+        m_n_min     = (int64_t) params.min_speech_ms  * sample_rate / 1000;
+        m_n_max     = (int64_t) params.max_speech_ms  * sample_rate / 1000;
+
+        m_t_start = now_us();
+
+        whisper_vad_stream_reset(m_vctx);
+    }
+
+    // feed captured audio, returns false if the VAD failed
+    // the closed speech windows are then available with pop()
+    bool push(const float * samples, int n_samples) {
+        const int64_t t0 = now_us();
+
+        const int n_new = whisper_vad_stream_push(m_vctx, samples, n_samples);
+        if (n_new < 0) {
+            return false;
+        }
+
+        m_stats.n_samples += n_samples;
+        m_pending.insert(m_pending.end(), samples, samples + n_samples);
+
+        const float * probs = whisper_vad_probs(m_vctx) + whisper_vad_n_probs(m_vctx) - n_new;
+
+        // each probability covers the next n_window samples of the stream
+        size_t i0 = 0;
+        for (int i = 0; i < n_new; ++i) {
+            add_window(m_pending.data() + i0, probs[i]);
+            i0 += n_window;
+        }
+
+        m_pending.erase(m_pending.begin(), m_pending.begin() + std::min(i0, m_pending.size()));
+
+        // the probabilities of the stream accumulate in the VAD context - drop them, and the LSTM state, during
+        // a long enough silence
+        if (!m_in_speech && whisper_vad_n_probs(m_vctx) > n_reset_probs) {
+            whisper_vad_stream_reset(m_vctx);
+            m_pending.clear();
+        }
+
+        m_stats.t_vad_us += now_us() - t0;
+
+        return true;
+    }
+
+    // take the oldest closed speech window
+    bool pop(std::vector<float> & pcmf32) {
+        if (m_ready.empty()) {
+            return false;
+        }
+
+        pcmf32 = std::move(m_ready.front());
+        m_ready.pop_front();
+
+        return true;
+    }
+
+    // closed speech windows not taken yet
+    int n_ready() const { return (int) m_ready.size(); }
+
+    bool in_speech() const { return m_in_speech; }
+
+    // around the whisper processing of a speech window
+    void active_begin() {
+        m_t_active = now_us();
+        m_stats.n_wake++;
+    }
+
+    void active_end() {
+        if (m_t_active > 0) {
+            m_stats.t_active_us += now_us() - m_t_active;
+            m_t_active = 0;
+        }
+
+        if (m_ctx) {
+            whisper_threadpool_pause(m_ctx);
+        }
+    }
+
+    always_listen_stats stats() const {
+        always_listen_stats res = m_stats;
+
+        const int64_t t_now = now_us();
+        if (m_t_active > 0) {
+            res.t_active_us += t_now - m_t_active;
+        }
+        res.t_idle_us = std::max<int64_t>(0, t_now - m_t_start - res.t_active_us);
+
+        return res;
+    }
+
+    static void print_stats(const always_listen_stats & stats) {
+        const double t_total = std::max<int64_t>(1, stats.t_active_us + stats.t_idle_us);
+
+        fprintf(stderr, "\n");
+        fprintf(stderr, "always_listen: active = %8.1f s (%5.1f%%), %d wakes for %d windows (%d dropped)\n",
+                stats.t_active_us/1e6, 100.0*stats.t_active_us/t_total, stats.n_wake, stats.n_windows, stats.n_dropped);
+        fprintf(stderr, "always_listen: idle   = %8.1f s (%5.1f%%)\n",
+                stats.t_idle_us/1e6, 100.0*stats.t_idle_us/t_total);
+        fprintf(stderr, "always_listen: vad    = %8.1f s for %.1f s of audio (%.2f%% of the session)\n",
+                stats.t_vad_us/1e6, stats.n_samples/(double) WHISPER_SAMPLE_RATE, 100.0*stats.t_vad_us/t_total);
+    }
+
+private:
+    // samples per probability of the Silero model at 16 kHz
+    static constexpr size_t n_window = 512;
+
+    // about a minute of probabilities
+    static constexpr int n_reset_probs = 2000;
+
+    static int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void add_window(const float * data, float prob) {
+        const bool speech = prob >= m_params.threshold;
+
+        if (!m_in_speech) {
+            // keep speech_pad_ms of audio before the speech
+            m_speech.insert(m_speech.end(), data, data + n_window);
+            if ((int64_t) m_speech.size() > m_n_pad + (int64_t) n_window) {
+                m_speech.erase(m_speech.begin(), m_speech.end() - m_n_pad - n_window);
+            }
+
+            if (speech) {
+                m_in_speech = true;
+                m_n_speech  = n_window;
+                m_n_quiet   = 0;
+            }
+
+            return;
+        }
+
+        m_speech.insert(m_speech.end(), data, data + n_window);
+        m_n_quiet = speech ? 0 : m_n_quiet + n_window;
+
+        if (m_n_quiet >= m_n_silence) {
+            // keep speech_pad_ms of the silence
+            m_speech.resize(m_speech.size() - std::max<int64_t>(0, m_n_quiet - m_n_pad));
+            close();
+        } else if ((int64_t) m_speech.size() >= m_n_max) {
+            close();
+        } else if (speech) {
+            m_n_speech += n_window;
+        }
+    }
+
+    void close() {
+        if (m_n_speech >= m_n_min) {
+            m_ready.push_back(std::move(m_speech));
+            m_stats.n_windows++;
+        } else {
+            m_stats.n_dropped++;
+        }
+
+        m_speech.clear();
+        m_in_speech = false;
+        m_n_speech  = 0;
+        m_n_quiet   = 0;
+    }
+
+    struct whisper_vad_context * m_vctx;
+    struct whisper_context     * m_ctx;
+
+    always_listen_params m_params;
+    always_listen_stats  m_stats;
+
+    int64_t m_n_pad     = 0;
+    int64_t m_n_silence = 0;
+    int64_t m_n_min     = 0;
+    int64_t m_n_max     = 0;
+
+    std::vector<float> m_pending; // samples pushed to the VAD without a probability yet
+    std::vector<float> m_speech;  // the current speech window, or the audio before the next one
+
+    bool    m_in_speech = false;
+    int64_t m_n_speech  = 0; // samples of the current window classified as speech
+    int64_t m_n_quiet   = 0; // samples of silence at its end
+
+    std::deque<std::vector<float>> m_ready;
+
+    int64_t m_t_start  = 0;
+    int64_t m_t_active = 0;
+};
@@ -0,0 +1,110 @@
+// Lock-free single-producer / single-consumer ring buffer of audio samples
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//
+// The producer (an audio device callback) never blocks and never waits for the consumer: once the ring is full it
+// overwrites the oldest samples. Samples are addressed by their position in the stream, the number of samples
+// written before them. The consumer reads them in place as at most two spans (split where the ring wraps) and
+// checks with valid() afterwards that the producer did not overwrite them meanwhile, as with a seqlock.
+//
+
+struct audio_ring_span {
+    const float * data;
+    size_t        n;
+};
+
+class audio_ring {
+public:
+    explicit audio_ring(size_t capacity = 0) {
+        reset(capacity);
+    }
+
+    // drop all samples and resize, not thread-safe
+    void reset(size_t capacity) {
+        m_data.assign(capacity, 0.0f);
+        m_begin.store(0, std::memory_order_relaxed);
+        m_end  .store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return m_data.size(); }
+
+    // producer: append n samples, overwriting the oldest ones when the ring is full
+    void write(const float * src, size_t n) {
+        const size_t   cap = m_data.size();
+        const uint64_t end = m_end.load(std::memory_order_relaxed);
+
+        if (cap == 0) {
+            return;
+        }
+
+        // only the last cap samples of a larger block are kept
+        const size_t n_skip = n > cap ? n - cap : 0;
+
+        // announce the samples about to be overwritten before touching them
+        m_begin.store(end + n, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const size_t i0 = (end + n_skip) % cap;
+        const size_t n0 = std::min(n - n_skip, cap - i0);
+
+        memcpy(m_data.data() + i0, src + n_skip,      n0*sizeof(float));
+        memcpy(m_data.data(),      src + n_skip + n0, (n - n_skip - n0)*sizeof(float));
+
+        m_end.store(end + n, std::memory_order_release);
+    }
+
+    // position after the newest sample, i.e. the number of samples written so far
+    uint64_t end() const { return m_end.load(std::memory_order_acquire); }
+
+    // consumer: the samples [pos, pos + n) in place, pos + n <= end() and end() - pos <= capacity()
+    // returns the number of spans
+    int spans(uint64_t pos, size_t n, audio_ring_span out[2]) const {
+        const size_t cap = m_data.size();
+        if (n == 0 || cap == 0) {
+            return 0;
+        }
+
+        const size_t i0 = pos % cap;
+        const size_t n0 = std::min(n, cap - i0);
+
+        out[0] = { m_data.data() + i0, n0 };
+        if (n0 == n) {
+            return 1;
+        }
+
+        out[1] = { m_data.data(), n - n0 };
+        return 2;
+    }
+
+    // consumer: true if the samples from pos on have not been overwritten since they were read
+    bool valid(uint64_t pos) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_begin.load(std::memory_order_relaxed) - pos <= m_data.size();
+    }
+
+    // consumer: copy the samples [pos, pos + n) to dst, false if they were overwritten while copying
+    bool read(uint64_t pos, size_t n, float * dst) const {
+        audio_ring_span sp[2];
+        const int n_spans = spans(pos, n, sp);
+        for (int i = 0; i < n_spans; ++i) {
+            memcpy(dst, sp[i].data, sp[i].n*sizeof(float));
+            dst += sp[i].n;
+        }
+
+        return valid(pos);
+    }
+
+private:
+    std::vector<float> m_data;
+
+    std::atomic<uint64_t> m_begin { 0 }; // end of the samples being written, m_end while the producer is idle
+    std::atomic<uint64_t> m_end   { 0 }; // end of the samples written
+};
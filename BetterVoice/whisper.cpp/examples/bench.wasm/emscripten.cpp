@@ -8,7 +8,7 @@
 #include <thread>
 #include <vector>
 
-constexpr int N_THREAD = 8;
+constexpr int N_THREAD = WHISPER_WASM_THREADS;
 
 // TODO: get rid of this vector of contexts - bad idea in the first place
 std::vector<struct whisper_context *> g_contexts(4, nullptr);
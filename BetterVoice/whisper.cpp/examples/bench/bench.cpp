@@ -1,19 +1,46 @@
+#include "common-whisper.h"
 #include "whisper.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <random>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
 
 // command-line parameters
 struct whisper_params {
     int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
-    int32_t what = 0; // what to benchmark: 0 - whisper encoder, 1 - memcpy, 2 - ggml_mul_mat
+    int32_t what = 0; // what to benchmark: 0 - whisper encoder, 1 - memcpy, 2 - ggml_mul_mat, 3 - decoder early exit
+    int32_t n_runs    = 3;  // passes over the clips (-w 5)
+    int32_t beam_size = -1; // -1 for greedy (-w 5)
+
+    float exit_thold = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).decoder_exit_thold;
 
     std::string model = "models/ggml-base.en.bin";
 
+    // end-to-end benchmark (-w 5)
+    std::string fname_inp;            // WAV file or directory of WAV files
+    std::string preset   = "default"; // default, bridge
+    std::string language = "en";
+    std::string vad_model;            // enables VAD
+    std::string fname_json;           // also write the JSON report to this file
+    std::string fname_trace;          // profile the graphs and write a Chrome trace to this file
+
     bool use_gpu    = true;
     bool flash_attn = true;
+    bool repack     = true;
+    bool hugepages  = false;
 };
 
 void whisper_print_usage(int argc, char ** argv, const whisper_params & params);
@@ -32,6 +59,17 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-ng"    || arg == "--no-gpu")        { params.use_gpu    = false; }
         else if (arg == "-fa"    || arg == "--flash-attn")    { params.flash_attn = true; }
         else if (arg == "-nfa"   || arg == "--no-flash-attn") { params.flash_attn = false; }
+        else if (arg == "-nr"    || arg == "--no-repack")     { params.repack     = false; }
+        else if (arg == "-hp"    || arg == "--hugepages")     { params.hugepages  = true; }
+        else if (arg == "-xt"    || arg == "--exit-thold")    { params.exit_thold = std::stof(argv[++i]); }
+        else if (arg == "-f"     || arg == "--file")          { params.fname_inp  = argv[++i]; }
+        else if (arg == "-p"     || arg == "--preset")        { params.preset     = argv[++i]; }
+        else if (arg == "-r"     || arg == "--runs")          { params.n_runs     = std::stoi(argv[++i]); }
+        else if (arg == "-l"     || arg == "--language")      { params.language   = argv[++i]; }
+        else if (arg == "-bs"    || arg == "--beam-size")     { params.beam_size  = std::stoi(argv[++i]); }
+        else if (arg == "-vm"    || arg == "--vad-model")     { params.vad_model  = argv[++i]; }
+        else if (arg == "-oj"    || arg == "--output-json")   { params.fname_json = argv[++i]; }
+        else if (arg == "-pt"    || arg == "--profile-trace") { params.fname_trace = argv[++i]; }
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
             whisper_print_usage(argc, argv, params);
@@ -54,9 +92,23 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "                             %-7s  0 - whisper\n",                                 "");
     fprintf(stderr, "                             %-7s  1 - memcpy\n",                                  "");
     fprintf(stderr, "                             %-7s  2 - ggml_mul_mat\n",                            "");
+    fprintf(stderr, "                             %-7s  3 - decoder early exit\n",                     "");
+    fprintf(stderr, "                             %-7s  4 - ggml_gelu\n",                               "");
+    fprintf(stderr, "                             %-7s  5 - end-to-end whisper_full on WAV files\n",     "");
     fprintf(stderr, "  -ng,      --no-gpu        [%-7s] disable GPU\n",                                 params.use_gpu ? "false" : "true");
     fprintf(stderr, "  -fa,      --flash-attn    [%-7s] enable flash attention\n",                      params.flash_attn ? "true" : "false");
     fprintf(stderr, "  -nfa,     --no-flash-attn [%-7s] disable flash attention\n",                     params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -nr,      --no-repack     [%-7s] keep the CPU weights in their file layout\n",     params.repack ? "false" : "true");
+    fprintf(stderr, "  -hp,      --hugepages     [%-7s] CPU weights and buffers in huge pages (Linux)\n", params.hugepages ? "true" : "false");
+    fprintf(stderr, "  -xt N,    --exit-thold N  [%-7.2f] early exit logprob margin (-w 3)\n",           params.exit_thold);
+    fprintf(stderr, "  -f PATH,  --file PATH     [%-7s] WAV file or directory of WAV files (-w 5)\n",     params.fname_inp.c_str());
+    fprintf(stderr, "  -p NAME,  --preset NAME   [%-7s] params: default, bridge (the BetterVoice bridge) (-w 5)\n", params.preset.c_str());
+    fprintf(stderr, "  -r N,     --runs N        [%-7d] passes over the files (-w 5)\n",                 params.n_runs);
+    fprintf(stderr, "  -l LANG,  --language LANG [%-7s] spoken language, auto to detect it (-w 5)\n",    params.language.c_str());
+    fprintf(stderr, "  -bs N,    --beam-size N   [%-7d] beam size, -1 for greedy (-w 5)\n",              params.beam_size);
+    fprintf(stderr, "  -vm FNAME,--vad-model FNAME [%-5s] VAD model, enables VAD (-w 5)\n",              params.vad_model.c_str());
+    fprintf(stderr, "  -oj FNAME,--output-json FNAME [%-3s] also write the JSON report to a file (-w 5)\n", params.fname_json.c_str());
+    fprintf(stderr, "  -pt FNAME,--profile-trace FNAME [%s] profile every graph node, write a Chrome trace (-w 5)\n", params.fname_trace.c_str());
     fprintf(stderr, "\n");
 }
 
@@ -65,8 +117,10 @@ static int whisper_bench_full(const whisper_params & params) {
 
     struct whisper_context_params cparams = whisper_context_default_params();
 
-    cparams.use_gpu    = params.use_gpu;
-    cparams.flash_attn = params.flash_attn;
+    cparams.use_gpu         = params.use_gpu;
+    cparams.flash_attn      = params.flash_attn;
+    cparams.use_extra_bufts = params.repack;
+    cparams.use_hugepages   = params.hugepages;
 
     {
         fprintf(stderr, "\n");
@@ -81,7 +135,12 @@ static int whisper_bench_full(const whisper_params & params) {
 
     const int n_mels = whisper_model_n_mels(ctx);
 
-    if (int ret = whisper_set_mel(ctx, nullptr, 0, n_mels)) {
+    // a silent 30 s window - a NULL spectrogram reads the incremental mel cache, which is empty here
+    const int n_len = 2*whisper_model_n_audio_ctx(ctx);
+
+    std::vector<float> mel(n_len*n_mels, 0.0f);
+
+    if (int ret = whisper_set_mel(ctx, mel.data(), n_len, n_mels)) {
         fprintf(stderr, "error: failed to set mel: %d\n", ret);
         return 3;
     }
@@ -116,6 +175,13 @@ static int whisper_bench_full(const whisper_params & params) {
 
     whisper_reset_timings(ctx);
 
+    // a different window, the encoder would otherwise reuse the result of the heat run
+    mel[0] = 1.0f;
+    if (int ret = whisper_set_mel(ctx, mel.data(), n_len, n_mels)) {
+        fprintf(stderr, "error: failed to set mel: %d\n", ret);
+        return 3;
+    }
+
     // actual run
     if (int ret = whisper_encode(ctx, 0, params.n_threads) != 0) {
         fprintf(stderr, "error: failed to encode: %d\n", ret);
@@ -164,6 +230,363 @@ static int whisper_bench_full(const whisper_params & params) {
     return 0;
 }
 
+// transcribe the same audio with the decoder early exit after each text layer and compare the time and the
+// text with the full decoder - there is no audio input, so a synthetic signal is used
+static int whisper_bench_exit(const whisper_params & params) {
+    struct whisper_context_params cparams = whisper_context_default_params();
+
+    cparams.use_gpu         = params.use_gpu;
+    cparams.flash_attn      = params.flash_attn;
+    cparams.use_extra_bufts = params.repack;
+    cparams.use_hugepages   = params.hugepages;
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: failed to initialize whisper context\n");
+        return 2;
+    }
+
+    // 30 seconds of amplitude modulated tones with noise
+    std::vector<float> pcmf32(30*WHISPER_SAMPLE_RATE);
+    {
+        std::mt19937 rng(0);
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+
+        for (size_t i = 0; i < pcmf32.size(); ++i) {
+            const float t = float(i)/WHISPER_SAMPLE_RATE;
+            pcmf32[i] = 0.3f*sinf(2.0f*M_PI*220.0f*t)*sinf(2.0f*M_PI*0.7f*t) + 0.1f*sinf(2.0f*M_PI*1250.0f*t) + noise(rng);
+        }
+    }
+
+    const int n_text_layer = whisper_model_n_text_layer(ctx);
+
+    std::string text_ref;
+
+    fprintf(stderr, "\n");
+
+    // exit layer 0 runs all layers and gives the reference text
+    for (int n_layer_exit = 0; n_layer_exit < n_text_layer; ++n_layer_exit) {
+        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+        wparams.n_threads          = params.n_threads;
+        wparams.print_progress     = false;
+        wparams.temperature_inc    = 0.0f;
+        wparams.decoder_exit_layer = n_layer_exit;
+        wparams.decoder_exit_thold = params.exit_thold;
+
+        // warm up the graphs of this exit layer
+        if (int ret = whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size())) {
+            fprintf(stderr, "error: failed to process audio: %d\n", ret);
+            whisper_free(ctx);
+            return 4;
+        }
+
+        whisper_reset_timings(ctx);
+
+        const int64_t t_start_us = ggml_time_us();
+
+        if (int ret = whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size())) {
+            fprintf(stderr, "error: failed to process audio: %d\n", ret);
+            whisper_free(ctx);
+            return 4;
+        }
+
+        const int64_t t_end_us = ggml_time_us();
+
+        std::string text;
+        int n_tokens = 0;
+        for (int i = 0; i < whisper_full_n_segments(ctx); ++i) {
+            text     += whisper_full_get_segment_text(ctx, i);
+            n_tokens += whisper_full_n_tokens(ctx, i);
+        }
+
+        if (n_layer_exit == 0) {
+            text_ref = text;
+        }
+
+        fprintf(stderr, "exit layer %2d / %2d: %8.2f ms, %4d tokens, %s\n", n_layer_exit, n_text_layer,
+                (t_end_us - t_start_us)/1000.0f, n_tokens, text == text_ref ? "same text" : "different text");
+
+        whisper_print_timings(ctx);
+    }
+
+    whisper_free(ctx);
+
+    return 0;
+}
+
+// the WAV files of a directory in name order, or the path itself if it is a file
+static std::vector<std::string> whisper_bench_list_wav(const std::string & path) {
+    std::vector<std::string> result;
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return result;
+    }
+
+    if (!(st.st_mode & S_IFDIR)) {
+        result.push_back(path);
+        return result;
+    }
+
+    auto is_wav = [](const std::string & name) {
+        if (name.size() < 4) {
+            return false;
+        }
+        std::string ext = name.substr(name.size() - 4);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".wav";
+    };
+
+#ifdef _WIN32
+    struct _finddata_t fd;
+    intptr_t h = _findfirst((path + "\\*").c_str(), &fd);
+    if (h != -1) {
+        do {
+            if (!(fd.attrib & _A_SUBDIR) && is_wav(fd.name)) {
+                result.push_back(path + "\\" + fd.name);
+            }
+        } while (_findnext(h, &fd) == 0);
+        _findclose(h);
+    }
+#else
+    if (DIR * dir = opendir(path.c_str())) {
+        while (struct dirent * ent = readdir(dir)) {
+            if (is_wav(ent->d_name)) {
+                result.push_back(path + "/" + ent->d_name);
+            }
+        }
+        closedir(dir);
+    }
+#endif
+
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+// nearest-rank percentile of an unsorted sample
+static double whisper_bench_percentile(std::vector<double> v, double p) {
+    if (v.empty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    const int idx = std::max(0, (int) std::ceil(p/100.0*v.size()) - 1);
+    return v[std::min(idx, (int) v.size() - 1)];
+}
+
+// transcribe real audio with whisper_full and report the latency of each stage per clip, the real-time factor and
+// the token rate as JSON on stdout, for regression tracking
+static int whisper_bench_e2e(const whisper_params & params) {
+    const std::vector<std::string> fnames = whisper_bench_list_wav(params.fname_inp);
+    if (fnames.empty()) {
+        fprintf(stderr, "error: no WAV files in '%s' (-f)\n", params.fname_inp.c_str());
+        return 1;
+    }
+
+    const bool bridge = params.preset == "bridge";
+    if (!bridge && params.preset != "default") {
+        fprintf(stderr, "error: unknown preset '%s'\n", params.preset.c_str());
+        return 1;
+    }
+
+    std::vector<std::vector<float>> clips;
+    std::vector<std::string>        clip_names;
+    for (const auto & fname : fnames) {
+        std::vector<float> pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_audio_data(fname, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "warning: skipping '%s', failed to read it\n", fname.c_str());
+            continue;
+        }
+        clips.push_back(std::move(pcmf32));
+        clip_names.push_back(fname);
+    }
+    if (clips.empty()) {
+        return 1;
+    }
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+
+    cparams.use_gpu         = params.use_gpu;
+    cparams.flash_attn      = params.flash_attn;
+    cparams.use_extra_bufts = params.repack;
+    cparams.use_hugepages   = params.hugepages;
+
+    // whisper_bridge_init_with_params() with the default whisper_bridge_params
+    if (bridge) {
+        cparams.flash_attn     = true;
+        cparams.use_mmap       = true;
+        cparams.cpu_threadpool = true;
+    }
+
+    // node-by-node computation, the latencies are not representative
+    cparams.profile = !params.fname_trace.empty();
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: failed to initialize whisper context\n");
+        return 2;
+    }
+
+    whisper_full_params wparams = whisper_full_default_params(params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+
+    wparams.n_threads      = params.n_threads;
+    wparams.language       = params.language.c_str();
+    wparams.print_progress = false;
+    if (params.beam_size > 1) {
+        wparams.beam_search.beam_size = params.beam_size;
+    }
+    if (!params.vad_model.empty()) {
+        wparams.vad            = true;
+        wparams.vad_model_path = params.vad_model.c_str();
+    }
+
+    // whisper_bridge_transcribe()
+    if (bridge) {
+        wparams.audio_ctx     = -1;
+        wparams.print_special = false;
+    }
+
+    // the first pass allocates the compute buffers and compiles the GPU pipelines
+    if (int ret = whisper_full(ctx, wparams, clips[0].data(), clips[0].size())) {
+        fprintf(stderr, "error: failed to process audio: %d\n", ret);
+        whisper_free(ctx);
+        return 4;
+    }
+
+    // the state keeps the cross-attention KV of its last encode and skips encoding the same window again;
+    // encoding a second of silence between the timed runs makes every run pay for its encodes
+    const std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+
+    std::vector<double> t_total, t_mel, t_vad, t_encode, t_decode, t_sample, rtf;
+
+    whisper_reset_profile(ctx);
+
+    double  audio_ms   = 0.0;
+    double  total_ms   = 0.0;
+    double  decode_ms  = 0.0; // decode and sample
+    int64_t n_tokens   = 0;
+    int     n_fallback = 0;
+
+    for (int r = 0; r < params.n_runs; ++r) {
+        for (size_t c = 0; c < clips.size(); ++c) {
+            if (whisper_pcm_to_mel(ctx, silence.data(), silence.size(), params.n_threads) != 0 ||
+                whisper_encode(ctx, 0, params.n_threads) != 0) {
+                fprintf(stderr, "error: failed to encode\n");
+                whisper_free(ctx);
+                return 4;
+            }
+
+            whisper_reset_timings(ctx);
+
+            const int64_t t_start_us = ggml_time_us();
+
+            if (int ret = whisper_full(ctx, wparams, clips[c].data(), clips[c].size())) {
+                fprintf(stderr, "error: failed to process '%s': %d\n", clip_names[c].c_str(), ret);
+                whisper_free(ctx);
+                return 4;
+            }
+
+            const double t_ms = (ggml_time_us() - t_start_us)/1000.0;
+            const double a_ms = 1000.0*clips[c].size()/WHISPER_SAMPLE_RATE;
+
+            whisper_timings * timings = whisper_get_timings(ctx);
+
+            t_total .push_back(t_ms);
+            t_mel   .push_back(timings->mel_total_ms);
+            t_vad   .push_back(timings->vad_total_ms);
+            t_encode.push_back(timings->encode_total_ms);
+            t_decode.push_back(timings->decode_total_ms);
+            t_sample.push_back(timings->sample_total_ms);
+            rtf     .push_back(t_ms/a_ms);
+
+            audio_ms   += a_ms;
+            total_ms   += t_ms;
+            decode_ms  += timings->decode_total_ms + timings->sample_total_ms;
+            n_fallback += timings->n_fallback;
+
+            delete timings;
+
+            for (int i = 0; i < whisper_full_n_segments(ctx); ++i) {
+                n_tokens += whisper_full_n_tokens(ctx, i);
+            }
+        }
+    }
+
+    if (cparams.profile) {
+        whisper_print_profile(ctx);
+
+        if (!whisper_save_profile_trace(ctx, params.fname_trace.c_str())) {
+            whisper_free(ctx);
+            return 5;
+        }
+    }
+
+    whisper_free(ctx);
+
+    std::string json;
+    char buf[512];
+
+    auto add_stage = [&](const char * name, const std::vector<double> & v, bool last) {
+        double mean = 0.0;
+        for (double x : v) {
+            mean += x;
+        }
+        mean /= v.size();
+
+        snprintf(buf, sizeof(buf), "    \"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f }%s\n", name, mean,
+                whisper_bench_percentile(v, 50), whisper_bench_percentile(v, 95), whisper_bench_percentile(v, 99), last ? "" : ",");
+        json += buf;
+    };
+
+    snprintf(buf, sizeof(buf),
+            "{\n"
+            "  \"model\": \"%s\",\n"
+            "  \"preset\": \"%s\",\n"
+            "  \"system_info\": \"%s\",\n"
+            "  \"n_threads\": %d,\n"
+            "  \"n_clips\": %d,\n"
+            "  \"n_runs\": %d,\n"
+            "  \"audio_s\": %.3f,\n"
+            "  \"rtf\": %.5f,\n"
+            "  \"tokens_per_s\": %.2f,\n"
+            "  \"decode_tokens_per_s\": %.2f,\n"
+            "  \"n_tokens\": %lld,\n"
+            "  \"n_fallback\": %d,\n",
+            params.model.c_str(), params.preset.c_str(), whisper_print_system_info(), params.n_threads, (int) clips.size(), params.n_runs,
+            audio_ms/1000.0, total_ms/audio_ms, n_tokens/(total_ms/1000.0), decode_ms > 0.0 ? n_tokens/(decode_ms/1000.0) : 0.0,
+            (long long) n_tokens, n_fallback);
+    json += buf;
+
+    json += "  \"latency_ms\": {\n";
+    add_stage("total",  t_total,  false);
+    add_stage("mel",    t_mel,    false);
+    add_stage("vad",    t_vad,    false);
+    add_stage("encode", t_encode, false);
+    add_stage("decode", t_decode, false);
+    add_stage("sample", t_sample, true);
+    json += "  },\n";
+    json += "  \"rtf_per_clip\": {\n";
+    add_stage("rtf", rtf, true);
+    json += "  }\n";
+    json += "}\n";
+
+    printf("%s", json.c_str());
+
+    if (!params.fname_json.empty()) {
+        FILE * f = fopen(params.fname_json.c_str(), "w");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", params.fname_json.c_str());
+            return 5;
+        }
+        fputs(json.c_str(), f);
+        fclose(f);
+    }
+
+    return 0;
+}
+
 int main(int argc, char ** argv) {
     ggml_backend_load_all();
 
@@ -179,6 +602,9 @@ int main(int argc, char ** argv) {
         case 0: ret = whisper_bench_full(params);                break;
         case 1: ret = whisper_bench_memcpy(params.n_threads);       break;
         case 2: ret = whisper_bench_ggml_mul_mat(params.n_threads); break;
+        case 3: ret = whisper_bench_exit(params);                break;
+        case 4: ret = whisper_bench_ggml_gelu(params.n_threads);   break;
+        case 5: ret = whisper_bench_e2e(params);                 break;
         default: fprintf(stderr, "error: unknown benchmark: %d\n", params.what); break;
     }
 
@@ -4,14 +4,20 @@
 #include "whisper.h"
 #include "grammar-parser.h"
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <cstdio>
+#include <mutex>
+#include <numeric>
 #include <string>
 #include <thread>
 #include <vector>
 #include <cstring>
 #include <cfloat>
+#include <memory>
 
 #if defined(_WIN32)
 #ifndef NOMINMAX
@@ -34,6 +40,7 @@ static void replace_all(std::string & s, const std::string & search, const std::
 struct whisper_params {
     int32_t n_threads     = std::min(4, (int32_t) std::thread::hardware_concurrency());
     int32_t n_processors  = 1;
+    int32_t n_batch       = 0;
     int32_t offset_t_ms   = 0;
     int32_t offset_n      = 0;
     int32_t duration_ms   = 0;
@@ -42,13 +49,24 @@ struct whisper_params {
     int32_t max_len       = 0;
     int32_t best_of       = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).greedy.best_of;
     int32_t beam_size     = whisper_full_default_params(WHISPER_SAMPLING_BEAM_SEARCH).beam_search.beam_size;
+    float   patience      = whisper_full_default_params(WHISPER_SAMPLING_BEAM_SEARCH).beam_search.patience;
+    float   beam_margin   = whisper_full_default_params(WHISPER_SAMPLING_BEAM_SEARCH).beam_adaptive_margin;
     int32_t audio_ctx     = 0;
+    int32_t lang_detect_ms = 0;
+    int32_t n_draft       = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).n_draft;
+    int32_t exit_layer    = 0;
+    float   exit_thold    = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).decoder_exit_thold;
 
     float word_thold      =  0.01f;
     float entropy_thold   =  2.40f;
     float logprob_thold   = -1.00f;
     float no_speech_thold =  0.6f;
+    int32_t repeat_thold  = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).repeat_thold;
+    float logprob_floor   = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).logprob_floor;
+    float no_speech_exit_thold = 0.0f;
     float grammar_penalty = 100.0f;
+    float bias_weight     = 2.0f;
+    float lora_scale      = 1.0f;
     float temperature     = 0.0f;
     float temperature_inc = 0.2f;
 
@@ -56,9 +74,16 @@ struct whisper_params {
     bool translate       = false;
     bool detect_language = false;
     bool diarize         = false;
+    bool split_channels  = false;
     bool tinydiarize     = false;
     bool split_on_word   = false;
     bool no_fallback     = false;
+    bool parallel_fallback = false;
+    float onset_thold = 0.0f;
+    int32_t chunk_batch = 0;
+    bool vocab_ascii = false;
+    bool pipeline_encode = false;
+    bool sample_on_device = false;
     bool output_txt      = false;
     bool output_vtt      = false;
     bool output_srt      = false;
@@ -67,6 +92,9 @@ struct whisper_params {
     bool output_jsn      = false;
     bool output_jsn_full = false;
     bool output_lrc      = false;
+    bool output_jsl      = false;
+    bool output_wtr      = false;
+    bool output_stream   = false;
     bool no_prints       = false;
     bool print_special   = false;
     bool print_colors    = false;
@@ -77,13 +105,22 @@ struct whisper_params {
     bool use_gpu         = true;
     bool flash_attn      = true;
     bool suppress_nst    = false;
+    bool long_form       = false;
+    bool use_mmap        = false;
+    bool use_hugepages   = false;
+    bool stream_encoder_weights = false;
+    bool mel_gpu                = false;
 
     std::string language  = "en";
     std::string prompt;
     std::string font_path = "/System/Library/Fonts/Supplemental/Courier New Bold.ttf";
     std::string model     = "models/ggml-base.en.bin";
+    std::string model_draft;
+    std::string lora;
+    std::string sched_cache;
     std::string grammar;
     std::string grammar_rule;
+    std::string bias_file;
 
     // [TDRZ] speaker turn string
     std::string tdrz_speaker_turn = " [SPEAKER_TURN]"; // TODO: set from command line
@@ -94,12 +131,21 @@ struct whisper_params {
     std::string openvino_encode_device = "CPU";
 
     std::string dtw = "";
+    bool dtw_incremental = false;
+
+    std::string kv_type = "f16";
+
+    int32_t max_memory_mb = 0;
 
     std::vector<std::string> fname_inp = {};
     std::vector<std::string> fname_out = {};
 
     grammar_parser::parse_state grammar_parsed;
 
+    // contextual biasing phrases read from bias_file
+    std::vector<std::string> bias_phrases;
+    std::vector<float>       bias_weights;
+
     // Voice Activity Detection (VAD) parameters
     bool        vad           = false;
     std::string vad_model     = "";
@@ -109,6 +155,10 @@ struct whisper_params {
     float       vad_max_speech_duration_s = FLT_MAX;
     int         vad_speech_pad_ms = 30;
     float       vad_samples_overlap = 0.1f;
+    float       vad_energy_thold = 0.0f;
+
+    // Noise suppression
+    std::string denoise_model = "";
 };
 
 static void whisper_print_usage(int argc, char ** argv, const whisper_params & params);
@@ -147,6 +197,7 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         #define ARGV_NEXT (((i + 1) < argc) ? argv[++i] : requires_value_error(arg))
         else if (arg == "-t"    || arg == "--threads")         { params.n_threads       = std::stoi(ARGV_NEXT); }
         else if (arg == "-p"    || arg == "--processors")      { params.n_processors    = std::stoi(ARGV_NEXT); }
+        else if (arg == "-bw"   || arg == "--batch-workers")   { params.n_batch         = std::stoi(ARGV_NEXT); }
         else if (arg == "-ot"   || arg == "--offset-t")        { params.offset_t_ms     = std::stoi(ARGV_NEXT); }
         else if (arg == "-on"   || arg == "--offset-n")        { params.offset_n        = std::stoi(ARGV_NEXT); }
         else if (arg == "-d"    || arg == "--duration")        { params.duration_ms     = std::stoi(ARGV_NEXT); }
@@ -154,19 +205,31 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-ml"   || arg == "--max-len")         { params.max_len         = std::stoi(ARGV_NEXT); }
         else if (arg == "-bo"   || arg == "--best-of")         { params.best_of         = std::stoi(ARGV_NEXT); }
         else if (arg == "-bs"   || arg == "--beam-size")       { params.beam_size       = std::stoi(ARGV_NEXT); }
+        else if (arg == "-bp"   || arg == "--patience")        { params.patience        = std::stof(ARGV_NEXT); }
+        else if (arg == "-bm"   || arg == "--beam-margin")     { params.beam_margin     = std::stof(ARGV_NEXT); }
         else if (arg == "-ac"   || arg == "--audio-ctx")       { params.audio_ctx       = std::stoi(ARGV_NEXT); }
         else if (arg == "-wt"   || arg == "--word-thold")      { params.word_thold      = std::stof(ARGV_NEXT); }
         else if (arg == "-et"   || arg == "--entropy-thold")   { params.entropy_thold   = std::stof(ARGV_NEXT); }
         else if (arg == "-lpt"  || arg == "--logprob-thold")   { params.logprob_thold   = std::stof(ARGV_NEXT); }
         else if (arg == "-nth"  || arg == "--no-speech-thold") { params.no_speech_thold = std::stof(ARGV_NEXT); }
+        else if (arg == "-rpt"  || arg == "--repeat-thold")    { params.repeat_thold    = std::stoi(ARGV_NEXT); }
+        else if (arg == "-lpf"  || arg == "--logprob-floor")   { params.logprob_floor   = std::stof(ARGV_NEXT); }
+        else if (arg == "-nse"  || arg == "--no-speech-exit")  { params.no_speech_exit_thold = std::stof(ARGV_NEXT); }
         else if (arg == "-tp"   || arg == "--temperature")     { params.temperature     = std::stof(ARGV_NEXT); }
         else if (arg == "-tpi"  || arg == "--temperature-inc") { params.temperature_inc = std::stof(ARGV_NEXT); }
         else if (arg == "-debug"|| arg == "--debug-mode")      { params.debug_mode      = true; }
         else if (arg == "-tr"   || arg == "--translate")       { params.translate       = true; }
         else if (arg == "-di"   || arg == "--diarize")         { params.diarize         = true; }
+        else if (arg == "-sc"   || arg == "--split-channels")  { params.split_channels  = true; }
         else if (arg == "-tdrz" || arg == "--tinydiarize")     { params.tinydiarize     = true; }
         else if (arg == "-sow"  || arg == "--split-on-word")   { params.split_on_word   = true; }
         else if (arg == "-nf"   || arg == "--no-fallback")     { params.no_fallback     = true; }
+        else if (arg == "-pf"   || arg == "--parallel-fallback") { params.parallel_fallback = true; }
+        else if (                  arg == "--onset-thold")       { params.onset_thold       = std::stof(ARGV_NEXT); }
+        else if (arg == "-cb"   || arg == "--chunk-batch")       { params.chunk_batch       = std::stoi(ARGV_NEXT); }
+        else if (                  arg == "--vocab-ascii")       { params.vocab_ascii       = true; }
+        else if (arg == "-pe"   || arg == "--pipeline-encode") { params.pipeline_encode = true; }
+        else if (arg == "-sod"  || arg == "--sample-on-device") { params.sample_on_device = true; }
         else if (arg == "-otxt" || arg == "--output-txt")      { params.output_txt      = true; }
         else if (arg == "-ovtt" || arg == "--output-vtt")      { params.output_vtt      = true; }
         else if (arg == "-osrt" || arg == "--output-srt")      { params.output_srt      = true; }
@@ -176,6 +239,9 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-ocsv" || arg == "--output-csv")      { params.output_csv      = true; }
         else if (arg == "-oj"   || arg == "--output-json")     { params.output_jsn      = true; }
         else if (arg == "-ojf"  || arg == "--output-json-full"){ params.output_jsn_full = params.output_jsn = true; }
+        else if (arg == "-ojl"  || arg == "--output-jsonl")    { params.output_jsl      = true; }
+        else if (arg == "-otr"  || arg == "--output-transcript"){ params.output_wtr     = true; }
+        else if (arg == "-ostr" || arg == "--output-stream")   { params.output_stream   = true; }
         else if (arg == "-of"   || arg == "--output-file")     { params.fname_out.emplace_back(ARGV_NEXT); }
         else if (arg == "-np"   || arg == "--no-prints")       { params.no_prints       = true; }
         else if (arg == "-ps"   || arg == "--print-special")   { params.print_special   = true; }
@@ -185,20 +251,38 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-nt"   || arg == "--no-timestamps")   { params.no_timestamps   = true; }
         else if (arg == "-l"    || arg == "--language")        { params.language        = whisper_param_turn_lowercase(ARGV_NEXT); }
         else if (arg == "-dl"   || arg == "--detect-language") { params.detect_language = true; }
+        else if (                  arg == "--lang-detect-ms")  { params.lang_detect_ms  = std::stoi(ARGV_NEXT); }
         else if (                  arg == "--prompt")          { params.prompt          = ARGV_NEXT; }
         else if (arg == "-m"    || arg == "--model")           { params.model           = ARGV_NEXT; }
+        else if (arg == "-md"   || arg == "--model-draft")     { params.model_draft     = ARGV_NEXT; }
+        else if (                  arg == "--lora")            { params.lora            = ARGV_NEXT; }
+        else if (                  arg == "--lora-scale")      { params.lora_scale      = std::stof(ARGV_NEXT); }
+        else if (                  arg == "--draft-max")       { params.n_draft         = std::stoi(ARGV_NEXT); }
+        else if (arg == "-xl"   || arg == "--exit-layer")      { params.exit_layer      = std::stoi(ARGV_NEXT); }
+        else if (arg == "-xt"   || arg == "--exit-thold")      { params.exit_thold      = std::stof(ARGV_NEXT); }
         else if (arg == "-f"    || arg == "--file")            { params.fname_inp.emplace_back(ARGV_NEXT); }
         else if (arg == "-oved" || arg == "--ov-e-device")     { params.openvino_encode_device = ARGV_NEXT; }
         else if (arg == "-dtw"  || arg == "--dtw")             { params.dtw             = ARGV_NEXT; }
+        else if (                  arg == "--dtw-incremental") { params.dtw_incremental = true; }
         else if (arg == "-ls"   || arg == "--log-score")       { params.log_score       = true; }
         else if (arg == "-ng"   || arg == "--no-gpu")          { params.use_gpu         = false; }
+        else if (                  arg == "--mmap")            { params.use_mmap        = true; }
+        else if (                  arg == "--hugepages")       { params.use_hugepages   = true; }
+        else if (                  arg == "--stream-encoder-weights") { params.stream_encoder_weights = true; }
+        else if (                  arg == "--mel-gpu")                { params.mel_gpu                = true; }
+        else if (                  arg == "--sched-cache")     { params.sched_cache     = ARGV_NEXT; }
         else if (arg == "-fa"   || arg == "--flash-attn")      { params.flash_attn      = true; }
         else if (arg == "-nfa"  || arg == "--no-flash-attn")   { params.flash_attn      = false; }
+        else if (arg == "-kvt"  || arg == "--kv-type")         { params.kv_type         = ARGV_NEXT; }
+        else if (arg == "-mm"   || arg == "--max-memory")      { params.max_memory_mb   = std::stoi(ARGV_NEXT); }
         else if (arg == "-sns"  || arg == "--suppress-nst")    { params.suppress_nst    = true; }
+        else if (arg == "-lf"   || arg == "--long-form")       { params.long_form       = true; }
         else if (                  arg == "--suppress-regex")  { params.suppress_regex  = ARGV_NEXT; }
         else if (                  arg == "--grammar")         { params.grammar         = ARGV_NEXT; }
         else if (                  arg == "--grammar-rule")    { params.grammar_rule    = ARGV_NEXT; }
         else if (                  arg == "--grammar-penalty") { params.grammar_penalty = std::stof(ARGV_NEXT); }
+        else if (                  arg == "--bias-file")       { params.bias_file       = ARGV_NEXT; }
+        else if (                  arg == "--bias-weight")     { params.bias_weight     = std::stof(ARGV_NEXT); }
         // Voice Activity Detection (VAD)
         else if (                  arg == "--vad")                         { params.vad                         = true; }
         else if (arg == "-vm"   || arg == "--vad-model")                   { params.vad_model                   = ARGV_NEXT; }
@@ -208,6 +292,8 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-vmsd" || arg == "--vad-max-speech-duration-s")   { params.vad_max_speech_duration_s   = std::stof(ARGV_NEXT); }
         else if (arg == "-vp"   || arg == "--vad-speech-pad-ms")           { params.vad_speech_pad_ms           = std::stoi(ARGV_NEXT); }
         else if (arg == "-vo"   || arg == "--vad-samples-overlap")         { params.vad_samples_overlap         = std::stof(ARGV_NEXT); }
+        else if (arg == "-ve"   || arg == "--vad-energy-thold")            { params.vad_energy_thold            = std::stof(ARGV_NEXT); }
+        else if (arg == "-dnm"  || arg == "--denoise-model")               { params.denoise_model               = ARGV_NEXT; }
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
             whisper_print_usage(argc, argv, params);
@@ -227,6 +313,7 @@ static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params
     fprintf(stderr, "  -h,        --help              [default] show this help message and exit\n");
     fprintf(stderr, "  -t N,      --threads N         [%-7d] number of threads to use during computation\n",    params.n_threads);
     fprintf(stderr, "  -p N,      --processors N      [%-7d] number of processors to use during computation\n", params.n_processors);
+    fprintf(stderr, "  -bw N,     --batch-workers N   [%-7d] transcribe the files on N states of one model, largest first\n", params.n_batch);
     fprintf(stderr, "  -ot N,     --offset-t N        [%-7d] time offset in milliseconds\n",                    params.offset_t_ms);
     fprintf(stderr, "  -on N,     --offset-n N        [%-7d] segment index offset\n",                           params.offset_n);
     fprintf(stderr, "  -d  N,     --duration N        [%-7d] duration of audio to process in milliseconds\n",   params.duration_ms);
@@ -235,18 +322,30 @@ static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params
     fprintf(stderr, "  -sow,      --split-on-word     [%-7s] split on word rather than on token\n",             params.split_on_word ? "true" : "false");
     fprintf(stderr, "  -bo N,     --best-of N         [%-7d] number of best candidates to keep\n",              params.best_of);
     fprintf(stderr, "  -bs N,     --beam-size N       [%-7d] beam size for beam search\n",                      params.beam_size);
-    fprintf(stderr, "  -ac N,     --audio-ctx N       [%-7d] audio context size (0 - all)\n",                   params.audio_ctx);
+    fprintf(stderr, "  -bp N,     --patience N        [%-7.2f] beam search patience, stop once N*beam-size beams finish (< 1)\n", params.patience);
+    fprintf(stderr, "  -bm N,     --beam-margin N     [%-7.2f] [EXPERIMENTAL] decode a single beam while it leads by this logprob (0 - off)\n", params.beam_margin);
+    fprintf(stderr, "  -ac N,     --audio-ctx N       [%-7d] audio context size (0 - all, -1 - auto)\n",                   params.audio_ctx);
     fprintf(stderr, "  -wt N,     --word-thold N      [%-7.2f] word timestamp probability threshold\n",         params.word_thold);
     fprintf(stderr, "  -et N,     --entropy-thold N   [%-7.2f] entropy threshold for decoder fail\n",           params.entropy_thold);
     fprintf(stderr, "  -lpt N,    --logprob-thold N   [%-7.2f] log probability threshold for decoder fail\n",   params.logprob_thold);
     fprintf(stderr, "  -nth N,    --no-speech-thold N [%-7.2f] no speech threshold\n",                          params.no_speech_thold);
+    fprintf(stderr, "  -rpt N,    --repeat-thold N    [%-7d] repeats of an n-gram that end a decoder early (0 - off)\n", params.repeat_thold);
+    fprintf(stderr, "  -lpf N,    --logprob-floor N   [%-7.2f] running log probability that ends a decoder early (0 - off)\n", params.logprob_floor);
+    fprintf(stderr, "  -nse N,    --no-speech-exit N  [%-7.2f] no speech probability that skips a window undecoded (0 - off)\n", params.no_speech_exit_thold);
     fprintf(stderr, "  -tp,       --temperature N     [%-7.2f] The sampling temperature, between 0 and 1\n",    params.temperature);
     fprintf(stderr, "  -tpi,      --temperature-inc N [%-7.2f] The increment of temperature, between 0 and 1\n",params.temperature_inc);
     fprintf(stderr, "  -debug,    --debug-mode        [%-7s] enable debug mode (eg. dump log_mel)\n",           params.debug_mode ? "true" : "false");
     fprintf(stderr, "  -tr,       --translate         [%-7s] translate from source language to english\n",      params.translate ? "true" : "false");
-    fprintf(stderr, "  -di,       --diarize           [%-7s] stereo audio diarization\n",                       params.diarize ? "true" : "false");
+    fprintf(stderr, "  -di,       --diarize           [%-7s] stereo audio diarization ([EXPERIMENTAL] speaker clustering on mono audio)\n",                       params.diarize ? "true" : "false");
+    fprintf(stderr, "  -sc,       --split-channels    [%-7s] [EXPERIMENTAL] transcribe each channel of stereo audio, speaker = channel\n", params.split_channels ? "true" : "false");
     fprintf(stderr, "  -tdrz,     --tinydiarize       [%-7s] enable tinydiarize (requires a tdrz model)\n",     params.tinydiarize ? "true" : "false");
     fprintf(stderr, "  -nf,       --no-fallback       [%-7s] do not use temperature fallback while decoding\n", params.no_fallback ? "true" : "false");
+    fprintf(stderr, "  -pf,       --parallel-fallback [%-7s] decode the fallback temperatures together in one batch\n", params.parallel_fallback ? "true" : "false");
+    fprintf(stderr, "             --onset-thold N     [%-7.2f] start windows at the speech after 1 s of silence, dB below the loudest frame (0 - off)\n", params.onset_thold);
+    fprintf(stderr, "  -cb N,     --chunk-batch N     [%-7d] chunked long-form: 30 s chunks, N encoded and decoded together (0 - off)\n", params.chunk_batch);
+    fprintf(stderr, "             --vocab-ascii       [%-7s] compute the logits only of the ASCII text tokens (English)\n", params.vocab_ascii ? "true" : "false");
+    fprintf(stderr, "  -pe,       --pipeline-encode   [%-7s] encode the next window while decoding the current one\n", params.pipeline_encode ? "true" : "false");
+    fprintf(stderr, "  -sod,      --sample-on-device  [%-7s] greedy sampling in the decoder graph, only the token is read back\n", params.sample_on_device ? "true" : "false");
     fprintf(stderr, "  -otxt,     --output-txt        [%-7s] output result in a text file\n",                   params.output_txt ? "true" : "false");
     fprintf(stderr, "  -ovtt,     --output-vtt        [%-7s] output result in a vtt file\n",                    params.output_vtt ? "true" : "false");
     fprintf(stderr, "  -osrt,     --output-srt        [%-7s] output result in a srt file\n",                    params.output_srt ? "true" : "false");
@@ -256,6 +355,9 @@ static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params
     fprintf(stderr, "  -ocsv,     --output-csv        [%-7s] output result in a CSV file\n",                    params.output_csv ? "true" : "false");
     fprintf(stderr, "  -oj,       --output-json       [%-7s] output result in a JSON file\n",                   params.output_jsn ? "true" : "false");
     fprintf(stderr, "  -ojf,      --output-json-full  [%-7s] include more information in the JSON file\n",      params.output_jsn_full ? "true" : "false");
+    fprintf(stderr, "  -ojl,      --output-jsonl      [%-7s] output result in a JSON Lines file, one segment per line\n", params.output_jsl ? "true" : "false");
+    fprintf(stderr, "  -otr,      --output-transcript [%-7s] output result in a binary transcript file (tokens, timestamps, probabilities)\n", params.output_wtr ? "true" : "false");
+    fprintf(stderr, "  -ostr,     --output-stream     [%-7s] write the txt/vtt/srt/csv/lrc/jsonl outputs as the segments are decoded\n", params.output_stream ? "true" : "false");
     fprintf(stderr, "  -of FNAME, --output-file FNAME [%-7s] output file path (without file extension)\n",      "");
     fprintf(stderr, "  -np,       --no-prints         [%-7s] do not print anything other than the results\n",   params.no_prints ? "true" : "false");
     fprintf(stderr, "  -ps,       --print-special     [%-7s] print special tokens\n",                           params.print_special ? "true" : "false");
@@ -265,20 +367,38 @@ static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params
     fprintf(stderr, "  -nt,       --no-timestamps     [%-7s] do not print timestamps\n",                        params.no_timestamps ? "true" : "false");
     fprintf(stderr, "  -l LANG,   --language LANG     [%-7s] spoken language ('auto' for auto-detect)\n",       params.language.c_str());
     fprintf(stderr, "  -dl,       --detect-language   [%-7s] exit after automatically detecting language\n",    params.detect_language ? "true" : "false");
+    fprintf(stderr, "             --lang-detect-ms N  [%-7d] detect the language on the first N ms of speech (0 - full window)\n", params.lang_detect_ms);
     fprintf(stderr, "             --prompt PROMPT     [%-7s] initial prompt (max n_text_ctx/2 tokens)\n",       params.prompt.c_str());
     fprintf(stderr, "  -m FNAME,  --model FNAME       [%-7s] model path\n",                                     params.model.c_str());
+    fprintf(stderr, "  -md FNAME, --model-draft FNAME [%-7s] draft model for speculative decoding (greedy only)\n", params.model_draft.c_str());
+    fprintf(stderr, "             --lora FNAME        [%-7s] LoRA adapter of the decoder\n",                   params.lora.c_str());
+    fprintf(stderr, "             --lora-scale N      [%-7.2f] scale of the LoRA adapter updates\n",           params.lora_scale);
+    fprintf(stderr, "             --draft-max N       [%-7d] max tokens proposed by the draft model per step\n", params.n_draft);
+    fprintf(stderr, "  -xl N,     --exit-layer N      [%-7d] decoder early exit after N text layers (0 - disabled, greedy only)\n", params.exit_layer);
+    fprintf(stderr, "  -xt N,     --exit-thold N      [%-7.2f] min logprob margin of the best token to keep an early exit\n", params.exit_thold);
     fprintf(stderr, "  -f FNAME,  --file FNAME        [%-7s] input audio file path\n",                            "");
     fprintf(stderr, "  -oved D,   --ov-e-device DNAME [%-7s] the OpenVINO device used for encode inference\n",  params.openvino_encode_device.c_str());
     fprintf(stderr, "  -dtw MODEL --dtw MODEL         [%-7s] compute token-level timestamps\n",                 params.dtw.c_str());
+    fprintf(stderr, "  --dtw-incremental              [%-7s] DTW timestamps from the decoding steps, no extra decoder pass\n", params.dtw_incremental ? "true" : "false");
     fprintf(stderr, "  -ls,       --log-score         [%-7s] log best decoder scores of tokens\n",              params.log_score?"true":"false");
     fprintf(stderr, "  -ng,       --no-gpu            [%-7s] disable GPU\n",                                    params.use_gpu ? "false" : "true");
+    fprintf(stderr, "  --mmap                         [%-7s] [EXPERIMENTAL] map the model file instead of reading it\n", params.use_mmap ? "true" : "false");
+    fprintf(stderr, "  --hugepages                    [%-7s] [EXPERIMENTAL] CPU weights and buffers in huge pages (Linux)\n", params.use_hugepages ? "true" : "false");
+    fprintf(stderr, "  --stream-encoder-weights       [%-7s] [EXPERIMENTAL] read the encoder layer weights from the model file as the encoder runs\n", params.stream_encoder_weights ? "true" : "false");
+    fprintf(stderr, "  --mel-gpu                      [%-7s] [EXPERIMENTAL] compute the log-mel spectrogram of each window on the encoder backend\n", params.mel_gpu ? "true" : "false");
+    fprintf(stderr, "  --sched-cache FNAME            [%-7s] [EXPERIMENTAL] file caching the compute buffer sizes between runs\n", params.sched_cache.c_str());
     fprintf(stderr, "  -fa,       --flash-attn        [%-7s] enable flash attention\n",                         params.flash_attn ? "true" : "false");
     fprintf(stderr, "  -nfa,      --no-flash-attn     [%-7s] disable flash attention\n",                        params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -kvt TYPE, --kv-type TYPE      [%-7s] KV cache type (f16, q8_0, q4_0), quantized needs flash attention\n", params.kv_type.c_str());
+    fprintf(stderr, "  -mm N,     --max-memory N      [%-7d] [EXPERIMENTAL] memory budget of the model and a state in MB, 0 - no limit\n", params.max_memory_mb);
     fprintf(stderr, "  -sns,      --suppress-nst      [%-7s] suppress non-speech tokens\n",                     params.suppress_nst ? "true" : "false");
+    fprintf(stderr, "  -lf,       --long-form         [%-7s] [EXPERIMENTAL] decode the audio file while transcribing, with bounded memory\n", params.long_form ? "true" : "false");
     fprintf(stderr, "  --suppress-regex REGEX         [%-7s] regular expression matching tokens to suppress\n", params.suppress_regex.c_str());
     fprintf(stderr, "  --grammar GRAMMAR              [%-7s] GBNF grammar to guide decoding\n",                 params.grammar.c_str());
     fprintf(stderr, "  --grammar-rule RULE            [%-7s] top-level GBNF grammar rule name\n",               params.grammar_rule.c_str());
     fprintf(stderr, "  --grammar-penalty N            [%-7.1f] scales down logits of nongrammar tokens\n",      params.grammar_penalty);
+    fprintf(stderr, "  --bias-file FNAME              [%-7s] phrases to favor, one per line, optionally followed by a tab and a weight\n", params.bias_file.c_str());
+    fprintf(stderr, "  --bias-weight N                [%-7.1f] logit boost of the bias phrases without a weight\n", params.bias_weight);
     // Voice Activity Detection (VAD) parameters
     fprintf(stderr, "\nVoice Activity Detection (VAD) options:\n");
     fprintf(stderr, "             --vad                           [%-7s] enable Voice Activity Detection (VAD)\n",            params.vad ? "true" : "false");
@@ -291,14 +411,21 @@ static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params
                                                                                                                                   std::to_string(params.vad_max_speech_duration_s).c_str());
     fprintf(stderr, "  -vp N,     --vad-speech-pad-ms           N [%-7d] VAD speech padding (extend segments)\n",             params.vad_speech_pad_ms);
     fprintf(stderr, "  -vo N,     --vad-samples-overlap         N [%-7.2f] VAD samples overlap (seconds between segments)\n", params.vad_samples_overlap);
+    fprintf(stderr, "  -ve N,     --vad-energy-thold            N [%-7.4f] [EXPERIMENTAL] skip audio with no speech above this RMS (0 = off)\n", params.vad_energy_thold);
+    fprintf(stderr, "  -dnm FNAME, --denoise-model FNAME          [%-7s] [EXPERIMENTAL] denoise the audio with this model first\n", params.denoise_model.c_str());
     fprintf(stderr, "\n");
 }
 
+struct segment_streams;
+
 struct whisper_print_user_data {
     const whisper_params * params;
 
     const std::vector<std::vector<float>> * pcmf32s;
     int progress_prev;
+
+    bool print;                // print the segments to stdout
+    segment_streams * streams; // --output-stream, NULL otherwise
 };
 
 static std::string estimate_diarization_speaker(std::vector<std::vector<float>> pcmf32s, int64_t t0, int64_t t1, bool id_only = false) {
@@ -343,11 +470,11 @@ static void whisper_print_progress_callback(struct whisper_context * /*ctx*/, st
     }
 }
 
-static void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * /*state*/, int n_new, void * user_data) {
+static void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
     const auto & params  = *((whisper_print_user_data *) user_data)->params;
     const auto & pcmf32s = *((whisper_print_user_data *) user_data)->pcmf32s;
 
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
 
     std::string speaker = "";
 
@@ -363,8 +490,8 @@ static void whisper_print_segment_callback(struct whisper_context * ctx, struct
 
     for (int i = s0; i < n_segments; i++) {
         if (!params.no_timestamps || params.diarize) {
-            t0 = whisper_full_get_segment_t0(ctx, i);
-            t1 = whisper_full_get_segment_t1(ctx, i);
+            t0 = whisper_full_get_segment_t0_from_state(state, i);
+            t1 = whisper_full_get_segment_t1_from_state(state, i);
         }
 
         if (!params.no_timestamps) {
@@ -373,35 +500,38 @@ static void whisper_print_segment_callback(struct whisper_context * ctx, struct
 
         if (params.diarize && pcmf32s.size() == 2) {
             speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+        } else if ((params.diarize || params.split_channels) && whisper_full_get_segment_speaker_from_state(state, i) >= 0) {
+            // mono audio: speaker clusters from the spectral profile of the segments, or the channel with --split-channels
+            speaker = "(speaker " + std::to_string(whisper_full_get_segment_speaker_from_state(state, i)) + ")";
         }
 
         if (params.print_colors) {
-            for (int j = 0; j < whisper_full_n_tokens(ctx, i); ++j) {
+            for (int j = 0; j < whisper_full_n_tokens_from_state(state, i); ++j) {
                 if (params.print_special == false) {
-                    const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+                    const whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
                     if (id >= whisper_token_eot(ctx)) {
                         continue;
                     }
                 }
 
-                const char * text = whisper_full_get_token_text(ctx, i, j);
-                const float  p    = whisper_full_get_token_p   (ctx, i, j);
+                const char * text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+                const float  p    = whisper_full_get_token_p_from_state   (state, i, j);
 
                 const int col = std::max(0, std::min((int) k_colors.size() - 1, (int) (std::pow(p, 3)*float(k_colors.size()))));
 
                 printf("%s%s%s%s", speaker.c_str(), k_colors[col].c_str(), text, "\033[0m");
             }
         } else if (params.print_confidence) {
-            for (int j = 0; j < whisper_full_n_tokens(ctx, i); ++j) {
+            for (int j = 0; j < whisper_full_n_tokens_from_state(state, i); ++j) {
                 if (params.print_special == false) {
-                    const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+                    const whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
                     if (id >= whisper_token_eot(ctx)) {
                         continue;
                     }
                 }
 
-                const char * text = whisper_full_get_token_text(ctx, i, j);
-                const float  p    = whisper_full_get_token_p   (ctx, i, j);
+                const char * text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+                const float  p    = whisper_full_get_token_p_from_state   (state, i, j);
 
                 int style_idx = 2;     // High confidence - dim
                 if (p < 0.33) {
@@ -412,13 +542,13 @@ static void whisper_print_segment_callback(struct whisper_context * ctx, struct
                 printf("%s%s%s%s", speaker.c_str(), k_styles[style_idx].c_str(), text, "\033[0m");
             }
         } else {
-            const char * text = whisper_full_get_segment_text(ctx, i);
+            const char * text = whisper_full_get_segment_text_from_state(state, i);
 
             printf("%s%s", speaker.c_str(), text);
         }
 
         if (params.tinydiarize) {
-            if (whisper_full_get_segment_speaker_turn_next(ctx, i)) {
+            if (whisper_full_get_segment_speaker_turn_next_from_state(state, i)) {
                 printf("%s", params.tdrz_speaker_turn.c_str());
             }
         }
@@ -432,62 +562,58 @@ static void whisper_print_segment_callback(struct whisper_context * ctx, struct
     }
 }
 
-static void output_txt(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
-    const int n_segments = whisper_full_n_segments(ctx);
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        std::string speaker = "";
+// the writers of the formats with one record per segment: an optional header, then each segment as it is decoded
+// (--output-stream) or all of them once whisper_full() returns
 
-        if (params.diarize && pcmf32s.size() == 2)
-        {
-            const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-            const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
-        }
+static void output_txt_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    std::string speaker = "";
 
-        fout << speaker << text << "\n";
+    if (params.diarize && pcmf32s.size() == 2)
+    {
+        const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+        const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+        speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
     }
+
+    fout << speaker << text << "\n";
 }
 
-static void output_vtt(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
+static void output_vtt_begin(std::ofstream & fout, const whisper_params & /*params*/, const std::vector<std::vector<float>> & /*pcmf32s*/) {
     fout << "WEBVTT\n\n";
+}
 
-    const int n_segments = whisper_full_n_segments(ctx);
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-        std::string speaker = "";
-
-        if (params.diarize && pcmf32s.size() == 2)
-        {
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1, true);
-            speaker.insert(0, "<v Speaker");
-            speaker.append(">");
-        }
+static void output_vtt_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+    std::string speaker = "";
 
-        fout << to_timestamp(t0) << " --> " << to_timestamp(t1) << "\n";
-        fout << speaker << text << "\n\n";
+    if (params.diarize && pcmf32s.size() == 2)
+    {
+        speaker = estimate_diarization_speaker(pcmf32s, t0, t1, true);
+        speaker.insert(0, "<v Speaker");
+        speaker.append(">");
     }
-}
 
-static void output_srt(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
-    const int n_segments = whisper_full_n_segments(ctx);
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-        std::string speaker = "";
+    fout << to_timestamp(t0) << " --> " << to_timestamp(t1) << "\n";
+    fout << speaker << text << "\n\n";
+}
 
-        if (params.diarize && pcmf32s.size() == 2)
-        {
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
-        }
+static void output_srt_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+    std::string speaker = "";
 
-        fout << i + 1 + params.offset_n << "\n";
-        fout << to_timestamp(t0, true) << " --> " << to_timestamp(t1, true) << "\n";
-        fout << speaker << text << "\n\n";
+    if (params.diarize && pcmf32s.size() == 2)
+    {
+        speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
     }
+
+    fout << i + 1 + params.offset_n << "\n";
+    fout << to_timestamp(t0, true) << " --> " << to_timestamp(t1, true) << "\n";
+    fout << speaker << text << "\n\n";
 }
 
 static char * escape_double_quotes_and_backslashes(const char * str) {
@@ -553,40 +679,59 @@ static char * escape_double_quotes_in_csv(const char * str) {
     return escaped;
 }
 
-static void output_csv(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
-    const int n_segments = whisper_full_n_segments(ctx);
+static void output_csv_begin(std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
     fout << "start,end,";
     if (params.diarize && pcmf32s.size() == 2)
     {
         fout << "speaker,";
     }
     fout << "text\n";
+}
 
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-        char * text_escaped = escape_double_quotes_in_csv(text);
-
-        //need to multiply times returned from whisper_full_get_segment_t{0,1}() by 10 to get milliseconds.
-        fout << 10 * t0 << "," << 10 * t1 << ",";
-        if (params.diarize && pcmf32s.size() == 2)
-        {
-            fout << estimate_diarization_speaker(pcmf32s, t0, t1, true) << ",";
-        }
-        fout << "\"" << text_escaped << "\"\n";
+static void output_csv_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+    char * text_escaped = escape_double_quotes_in_csv(text);
+
+    //need to multiply times returned from whisper_full_get_segment_t{0,1}() by 10 to get milliseconds.
+    fout << 10 * t0 << "," << 10 * t1 << ",";
+    if (params.diarize && pcmf32s.size() == 2)
+    {
+        fout << estimate_diarization_speaker(pcmf32s, t0, t1, true) << ",";
+    }
+    fout << "\"" << text_escaped << "\"\n";
+    free(text_escaped);
+}
+
+// JSON Lines: one self-contained object per segment, so the file is valid after every line
+static void output_jsl_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+    char * text_escaped = escape_double_quotes_and_backslashes(whisper_full_get_segment_text_from_state(state, i));
+
+    fout << "{\"timestamps\": {\"from\": \"" << to_timestamp(t0, true) << "\", \"to\": \"" << to_timestamp(t1, true) << "\"}, ";
+    fout << "\"offsets\": {\"from\": " << t0 * 10 << ", \"to\": " << t1 * 10 << "}, ";
+    fout << "\"text\": \"" << text_escaped << "\"";
+    if (params.diarize && pcmf32s.size() == 2) {
+        fout << ", \"speaker\": \"" << estimate_diarization_speaker(pcmf32s, t0, t1, true) << "\"";
     }
+    if (params.tinydiarize) {
+        fout << ", \"speaker_turn_next\": " << (whisper_full_get_segment_speaker_turn_next_from_state(state, i) ? "true" : "false");
+    }
+    fout << "}\n";
+    free(text_escaped);
 }
 
-static void output_score(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & /*params*/, std::vector<std::vector<float>> /*pcmf32s*/) {
-    const int n_segments = whisper_full_n_segments(ctx);
+static void output_score(struct whisper_context * ctx, struct whisper_state * state, std::ofstream & fout, const whisper_params & /*params*/, std::vector<std::vector<float>> /*pcmf32s*/) {
+    const int n_segments = whisper_full_n_segments_from_state(state);
     // fprintf(stderr,"segments: %d\n",n_segments);
     for (int i = 0; i < n_segments; ++i) {
-        const int n_tokens = whisper_full_n_tokens(ctx, i);
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
         // fprintf(stderr,"tokens: %d\n",n_tokens);
         for (int j = 0; j < n_tokens; j++) {
-            auto token = whisper_full_get_token_text(ctx, i, j);
-            auto probability = whisper_full_get_token_p(ctx, i, j);
+            auto token = whisper_full_get_token_text_from_state(ctx, state, i, j);
+            auto probability = whisper_full_get_token_p_from_state(state, i, j);
             fout << token << '\t' << probability << std::endl;
             // fprintf(stderr,"token: %s %f\n",token,probability);
 	    }
@@ -595,6 +740,7 @@ static void output_score(struct whisper_context * ctx, std::ofstream & fout, con
 
 static void output_json(
              struct whisper_context * ctx,
+               struct whisper_state * state,
                       std::ofstream & fout,
                const whisper_params & params,
     std::vector<std::vector<float>>   pcmf32s) {
@@ -705,16 +851,16 @@ static void output_json(
             value_b("translate", params.translate, true);
         end_obj(false);
         start_obj("result");
-            value_s("language", whisper_lang_str(whisper_full_lang_id(ctx)), true);
+            value_s("language", whisper_lang_str(whisper_full_lang_id_from_state(state)), true);
         end_obj(false);
         start_arr("transcription");
 
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(state);
             for (int i = 0; i < n_segments; ++i) {
-                const char * text = whisper_full_get_segment_text(ctx, i);
+                const char * text = whisper_full_get_segment_text_from_state(state, i);
 
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+                const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+                const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
 
                 start_obj(nullptr);
                     times_o(t0, t1, false);
@@ -722,9 +868,9 @@ static void output_json(
 
                     if (full) {
                         start_arr("tokens");
-                        const int n = whisper_full_n_tokens(ctx, i);
+                        const int n = whisper_full_n_tokens_from_state(state, i);
                         for (int j = 0; j < n; ++j) {
-                            auto token = whisper_full_get_token_data(ctx, i, j);
+                            auto token = whisper_full_get_token_data_from_state(state, i, j);
                             start_obj(nullptr);
                                 value_s("text", whisper_token_to_str(ctx, token.id), false);
                                 if(token.t0 > -1 && token.t1 > -1) {
@@ -744,7 +890,7 @@ static void output_json(
                     }
 
                     if (params.tinydiarize) {
-                        value_b("speaker_turn_next", whisper_full_get_segment_speaker_turn_next(ctx, i), true);
+                        value_b("speaker_turn_next", whisper_full_get_segment_speaker_turn_next_from_state(state, i), true);
                     }
                 end_obj(i == (n_segments - 1));
             }
@@ -756,7 +902,7 @@ static void output_json(
 // karaoke video generation
 // outputs a bash script that uses ffmpeg to generate a video with the subtitles
 // TODO: font parameter adjustments
-static bool output_wts(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s, const char * fname_inp, float t_sec, const char * fname_out) {
+static bool output_wts(struct whisper_context * ctx, struct whisper_state * state, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s, const char * fname_inp, float t_sec, const char * fname_out) {
     static const char * font = params.font_path.c_str();
 
     std::ifstream fin(font);
@@ -770,15 +916,15 @@ static bool output_wts(struct whisper_context * ctx, std::ofstream & fout, const
 
     fout << "ffmpeg -i " << fname_inp << " -f lavfi -i color=size=1200x120:duration=" << t_sec << ":rate=25:color=black -vf \"";
 
-    for (int i = 0; i < whisper_full_n_segments(ctx); i++) {
-        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+    for (int i = 0; i < whisper_full_n_segments_from_state(state); i++) {
+        const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+        const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
 
-        const int n = whisper_full_n_tokens(ctx, i);
+        const int n = whisper_full_n_tokens_from_state(state, i);
 
         std::vector<whisper_token_data> tokens(n);
         for (int j = 0; j < n; ++j) {
-            tokens[j] = whisper_full_get_token_data(ctx, i, j);
+            tokens[j] = whisper_full_get_token_data_from_state(state, i, j);
         }
 
         if (i > 0) {
@@ -877,38 +1023,593 @@ static bool output_wts(struct whisper_context * ctx, std::ofstream & fout, const
     return true;
 }
 
-static void output_lrc(struct whisper_context * ctx, std::ofstream & fout, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
+static void output_lrc_begin(std::ofstream & fout, const whisper_params & /*params*/, const std::vector<std::vector<float>> & /*pcmf32s*/) {
     fout << "[by:whisper.cpp]\n";
+}
 
-    const int n_segments = whisper_full_n_segments(ctx);
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        const int64_t t = whisper_full_get_segment_t0(ctx, i);
-
-        int64_t msec = t * 10;
-        int64_t min = msec / (1000 * 60);
-        msec = msec - min * (1000 * 60);
-        int64_t sec = msec / 1000;
-        msec = msec - sec * 1000;
-
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%02d:%02d.%02d", (int) min, (int) sec, (int) ( msec / 10));
-        std::string timestamp_lrc = std::string(buf);
-        std::string speaker = "";
+static void output_lrc_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    const int64_t t = whisper_full_get_segment_t0_from_state(state, i);
+
+    int64_t msec = t * 10;
+    int64_t min = msec / (1000 * 60);
+    msec = msec - min * (1000 * 60);
+    int64_t sec = msec / 1000;
+    msec = msec - sec * 1000;
 
-        if (params.diarize && pcmf32s.size() == 2)
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02d:%02d.%02d", (int) min, (int) sec, (int) ( msec / 10));
+    std::string timestamp_lrc = std::string(buf);
+    std::string speaker = "";
+
+    if (params.diarize && pcmf32s.size() == 2)
+    {
+        const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+        const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+        speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+    }
+
+    fout <<  '[' << timestamp_lrc << ']' << speaker << text << "\n";
+}
+
+struct segment_writer {
+    const char * ext;
+    const char * name;
+    bool whisper_params::* enabled;
+
+    void (*begin)  (std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s);
+    void (*segment)(struct whisper_context * ctx, struct whisper_state * state, int i, std::ofstream & fout, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s);
+};
+
+static const segment_writer k_segment_writers[] = {
+    { ".txt",   "output_txt", &whisper_params::output_txt, nullptr,          output_txt_segment },
+    { ".vtt",   "output_vtt", &whisper_params::output_vtt, output_vtt_begin, output_vtt_segment },
+    { ".srt",   "output_srt", &whisper_params::output_srt, nullptr,          output_srt_segment },
+    { ".csv",   "output_csv", &whisper_params::output_csv, output_csv_begin, output_csv_segment },
+    { ".lrc",   "output_lrc", &whisper_params::output_lrc, output_lrc_begin, output_lrc_segment },
+    { ".jsonl", "output_jsl", &whisper_params::output_jsl, nullptr,          output_jsl_segment },
+};
+
+// the outputs of k_segment_writers opened before the inference with --output-stream
+struct segment_streams {
+    std::vector<const segment_writer *> writers;
+    std::vector<std::ofstream>          fouts;
+};
+
+// writes the segments [i0, i1) to the outputs and flushes them
+static void segment_streams_write(struct whisper_context * ctx, struct whisper_state * state, int i0, int i1, segment_streams & streams, const whisper_params & params, const std::vector<std::vector<float>> & pcmf32s) {
+    for (size_t k = 0; k < streams.writers.size(); k++) {
+        for (int i = i0; i < i1; i++) {
+            streams.writers[k]->segment(ctx, state, i, streams.fouts[k], params, pcmf32s);
+        }
+        streams.fouts[k].flush();
+    }
+}
+
+// --output-stream: writes the new segments to the opened outputs, then prints them
+static void whisper_output_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
+    const auto & data = *((whisper_print_user_data *) user_data);
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+
+    segment_streams_write(ctx, state, n_segments - n_new, n_segments, *data.streams, *data.params, *data.pcmf32s);
+
+    if (data.print) {
+        whisper_print_segment_callback(ctx, state, n_new, user_data);
+    }
+}
+
+static void cb_log_disable(enum ggml_log_level , const char * , void * ) { }
+
+// opens the output files of one input: its basename with the extension of each format, or stdout for "-"
+struct fout_factory {
+    std::string fname_out;
+    const size_t basename_length;
+    const bool is_stdout;
+    bool used_stdout;
+    decltype(whisper_print_segment_callback) * const print_segment_callback;
+    std::ofstream fout;
+
+    fout_factory (const std::string & fname_out_, const std::string & fname_inp, whisper_params & params) :
+            fname_out{!fname_out_.empty() ? fname_out_ : fname_inp},
+            basename_length{fname_out.size()},
+            is_stdout{fname_out == "-"},
+            used_stdout{},
+            print_segment_callback{is_stdout ? nullptr : whisper_print_segment_callback} {
+        if (!print_segment_callback) {
+            params.print_progress = false;
+        }
+    }
+
+    bool open(const char * ext, const char * function) {
+        return open(ext, function, fout);
+    }
+
+    bool open(const char * ext, const char * function, std::ofstream & out) {
+        if (is_stdout) {
+            if (used_stdout) {
+                fprintf(stderr, "warning: Not appending multiple file formats to stdout\n");
+                return false;
+            }
+
+            used_stdout = true;
+#ifdef _WIN32
+            out = std::ofstream{"CON"};
+#else
+            out = std::ofstream{"/dev/stdout"};
+#endif
+            // Not using fprintf stderr here because it might equal stdout
+            // Also assuming /dev is mounted
+            return true;
+        }
+
+        fname_out.resize(basename_length);
+        fname_out += ext;
+        out = std::ofstream{fname_out};
+        if (!out.is_open()) {
+            fprintf(stderr, "%s: failed to open '%s' for writing\n", __func__, fname_out.c_str());
+            return false;
+        }
+        fprintf(stderr, "%s: saving output to '%s'\n", function, fname_out.c_str());
+        return true;
+    }
+};
+
+// run the inference on one input file and write its outputs
+// state: the state to transcribe on, NULL for the default state and whisper_full_parallel()
+// reader: the audio with --long-form, NULL to transcribe pcmf32
+// mutex_out: serializes the outputs of the batch workers, NULL when the files are processed one after another
+static int process_file(
+        struct whisper_context * ctx,
+          struct whisper_state * state,
+        struct whisper_context * ctx_draft,
+                whisper_params & params,
+             const std::string & fname_inp,
+             const std::string & fname_out,
+      const std::vector<float> & pcmf32,
+    const std::vector<std::vector<float>> & pcmf32s_in,
+             audio_file_reader * reader,
+                    std::mutex * mutex_out) {
+    fout_factory fout_factory{fname_out, fname_inp, params};
+
+    // with --split-channels the channels are transcribed on their own and the segments have their channel as the
+    // speaker, the outputs do not compare the energy of the channels. Not with --batch, whose workers would share the
+    // helper states of the context
+    const bool split_channels = params.split_channels && pcmf32s_in.size() > 1 && !reader && !state;
+
+    const std::vector<std::vector<float>> no_channels;
+    const auto & pcmf32s = split_channels ? no_channels : pcmf32s_in;
+
+    whisper_print_user_data user_data = { &params, &pcmf32s, 0, fout_factory.print_segment_callback != nullptr, nullptr };
+
+    // with --output-stream the outputs are opened now and written as the segments are decoded
+    segment_streams streams;
+    if (params.output_stream) {
+        for (const auto & writer : k_segment_writers) {
+            std::ofstream fout;
+            if (params.*writer.enabled && fout_factory.open(writer.ext, writer.name, fout)) {
+                if (writer.begin) {
+                    writer.begin(fout, params, pcmf32s);
+                }
+                fout.flush();
+
+                streams.writers.push_back(&writer);
+                streams.fouts.push_back(std::move(fout));
+            }
+        }
+        user_data.streams = &streams;
+    }
+
+    // run the inference
+    {
+        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+        const bool use_grammar = (!params.grammar_parsed.rules.empty() && !params.grammar_rule.empty());
+        wparams.strategy = (params.beam_size > 1 || use_grammar) ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+
+        wparams.print_realtime   = false;
+        wparams.print_progress   = params.print_progress;
+        wparams.print_timestamps = !params.no_timestamps;
+        wparams.print_special    = params.print_special;
+        wparams.translate        = params.translate;
+        wparams.language         = params.language.c_str();
+        wparams.detect_language  = params.detect_language;
+        wparams.lang_detect_ms   = params.lang_detect_ms;
+        wparams.n_threads        = params.n_threads;
+        wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
+        wparams.offset_ms        = params.offset_t_ms;
+        wparams.duration_ms      = params.duration_ms;
+
+        wparams.token_timestamps = params.output_wts || params.output_jsn_full || params.max_len > 0;
+        wparams.thold_pt         = params.word_thold;
+        wparams.max_len          = params.output_wts && params.max_len == 0 ? 60 : params.max_len;
+        wparams.split_on_word    = params.split_on_word;
+        wparams.audio_ctx        = params.audio_ctx;
+        wparams.pipeline_encode  = params.pipeline_encode;
+        wparams.sample_on_device = params.sample_on_device;
+        wparams.draft_ctx        = ctx_draft;
+        wparams.n_draft          = params.n_draft;
+
+        wparams.decoder_exit_layer = params.exit_layer;
+        wparams.decoder_exit_thold = params.exit_thold;
+
+        wparams.debug_mode       = params.debug_mode;
+
+        wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
+        wparams.speaker_labels   = params.diarize && pcmf32s.size() != 2;
+
+        wparams.suppress_regex   = params.suppress_regex.empty() ? nullptr : params.suppress_regex.c_str();
+
+        wparams.initial_prompt   = params.prompt.c_str();
+
+        wparams.greedy.best_of        = params.best_of;
+        wparams.beam_search.beam_size = params.beam_size;
+        wparams.beam_search.patience  = params.patience;
+        wparams.beam_adaptive_margin    = params.beam_margin;
+
+        wparams.temperature_inc  = params.no_fallback ? 0.0f : params.temperature_inc;
+        wparams.parallel_fallback = params.parallel_fallback;
+        wparams.onset_thold       = params.onset_thold;
+        wparams.chunk_batch       = params.chunk_batch;
+
+        // the text tokens made of printable ASCII, the special and timestamp tokens are added by whisper_full()
+        std::vector<whisper_token> vocab_shortlist;
+        if (params.vocab_ascii) {
+            for (whisper_token id = 0; id < whisper_token_eot(ctx); ++id) {
+                const char * str = whisper_token_to_str(ctx, id);
+                bool ascii = true;
+                for (const char * c = str; *c; ++c) {
+                    if (*c < 0x20 || *c > 0x7e) {
+                        ascii = false;
+                        break;
+                    }
+                }
+                if (ascii) {
+                    vocab_shortlist.push_back(id);
+                }
+            }
+        }
+
+        wparams.vocab_shortlist   = vocab_shortlist.empty() ? nullptr : vocab_shortlist.data();
+        wparams.vocab_shortlist_n = vocab_shortlist.size();
+        wparams.temperature      = params.temperature;
+
+        wparams.entropy_thold    = params.entropy_thold;
+        wparams.logprob_thold    = params.logprob_thold;
+        wparams.no_speech_thold  = params.no_speech_thold;
+        wparams.repeat_thold     = params.repeat_thold;
+        wparams.logprob_floor    = params.logprob_floor;
+        wparams.no_speech_exit_thold = params.no_speech_exit_thold;
+
+        wparams.no_timestamps    = params.no_timestamps;
+
+        wparams.suppress_nst     = params.suppress_nst;
+
+        wparams.vad            = params.vad;
+        wparams.vad_model_path = params.vad_model.c_str();
+
+        wparams.vad_params.threshold               = params.vad_threshold;
+        wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
+        wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
+        wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
+        wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
+        wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
+        wparams.vad_params.energy_thold            = params.vad_energy_thold;
+
+        wparams.denoise            = !params.denoise_model.empty();
+        wparams.denoise_model_path = params.denoise_model.c_str();
+
+        const auto & grammar_parsed = params.grammar_parsed;
+        auto grammar_rules = grammar_parsed.c_rules();
+
+        if (use_grammar) {
+            if (grammar_parsed.symbol_ids.find(params.grammar_rule) == grammar_parsed.symbol_ids.end()) {
+                fprintf(stderr, "%s: warning: grammar rule '%s' not found - skipping grammar sampling\n", __func__, params.grammar_rule.c_str());
+            } else {
+                wparams.grammar_rules = grammar_rules.data();
+                wparams.n_grammar_rules = grammar_rules.size();
+                wparams.i_start_rule = grammar_parsed.symbol_ids.at(params.grammar_rule);
+                wparams.grammar_penalty = params.grammar_penalty;
+            }
+        }
+
+        std::vector<const char *> bias_phrases;
+        for (const auto & phrase : params.bias_phrases) {
+            bias_phrases.push_back(phrase.c_str());
+        }
+
+        wparams.bias_phrases   = bias_phrases.data();
+        wparams.bias_weights   = params.bias_weights.data();
+        wparams.n_bias_phrases = bias_phrases.size();
+
+        // this callback is called on each new segment - the batch workers print the segments once the file is done,
+        // not interleaved with the other files
+        if (user_data.streams) {
+            user_data.print = user_data.print && !mutex_out;
+
+            wparams.new_segment_callback           = whisper_output_segment_callback;
+            wparams.new_segment_callback_user_data = &user_data;
+        } else if (!wparams.print_realtime && !mutex_out) {
+            wparams.new_segment_callback           = fout_factory.print_segment_callback;
+            wparams.new_segment_callback_user_data = &user_data;
+        }
+
+        if (wparams.print_progress) {
+            wparams.progress_callback           = whisper_print_progress_callback;
+            wparams.progress_callback_user_data = &user_data;
+        }
+
+        // examples for abort mechanism
+        // in examples below, we do not abort the processing, but we could if the flag is set to true
+
+        // the callback is called before every encoder run - if it returns false, the processing is aborted
         {
-            const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-            const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+            static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
+
+            wparams.encoder_begin_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * user_data) {
+                bool is_aborted = *(bool*)user_data;
+                return !is_aborted;
+            };
+            wparams.encoder_begin_callback_user_data = &is_aborted;
+        }
+
+        // the callback is called before every computation - if it returns true, the computation is aborted
+        {
+            static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
+
+            wparams.abort_callback = [](void * user_data) {
+                bool is_aborted = *(bool*)user_data;
+                return is_aborted;
+            };
+            wparams.abort_callback_user_data = &is_aborted;
+        }
+
+        int ret = 0;
+        if (reader) {
+            ret = whisper_full_from_source(ctx, wparams, { audio_file_reader_read, reader });
+        } else if (split_channels) {
+            std::vector<const float *> channels;
+            for (const auto & pcm : pcmf32s_in) {
+                channels.push_back(pcm.data());
+            }
+
+            ret = whisper_full_channels(ctx, whisper_get_state(ctx), wparams, channels.data(), channels.size(), pcmf32s_in[0].size());
+        } else if (state) {
+            ret = whisper_full_with_state(ctx, state, wparams, pcmf32.data(), pcmf32.size());
+        } else {
+            ret = whisper_full_parallel(ctx, wparams, pcmf32.data(), pcmf32.size(), params.n_processors);
         }
 
-        fout <<  '[' << timestamp_lrc << ']' << speaker << text << "\n";
+        if (ret != 0) {
+            fprintf(stderr, "%s: failed to process audio '%s'\n", __func__, fname_inp.c_str());
+            return 10;
+        }
+    }
+
+    if (state == nullptr) {
+        state = whisper_get_state(ctx);
+    }
+
+    const int64_t n_samples = reader ? audio_file_reader_n_read(reader) : (int64_t) pcmf32.size();
+
+    std::unique_lock<std::mutex> lock;
+    if (mutex_out) {
+        lock = std::unique_lock<std::mutex>(*mutex_out);
+
+        if (fout_factory.print_segment_callback) {
+            fprintf(stderr, "\n%s: '%s' (%.1f sec):\n", __func__, fname_inp.c_str(), float(n_samples)/WHISPER_SAMPLE_RATE);
+            fout_factory.print_segment_callback(ctx, state, whisper_full_n_segments_from_state(state), &user_data);
+        }
     }
+
+    // output stuff
+    {
+        // macros to stringify function name
+#define output_func(func, ext, param, ...) if (param && fout_factory.open(ext, #func)) {\
+    func(ctx, state, fout_factory.fout, params, __VA_ARGS__); \
 }
+#define output_ext(ext, ...) output_func(output_##ext, "." #ext, params.output_##ext, __VA_ARGS__)
 
+        // the per-segment formats, unless they were streamed
+        for (const auto & writer : k_segment_writers) {
+            if (params.output_stream || !(params.*writer.enabled) || !fout_factory.open(writer.ext, writer.name)) {
+                continue;
+            }
+            if (writer.begin) {
+                writer.begin(fout_factory.fout, params, pcmf32s);
+            }
+            const int n_segments = whisper_full_n_segments_from_state(state);
+            for (int i = 0; i < n_segments; ++i) {
+                writer.segment(ctx, state, i, fout_factory.fout, params, pcmf32s);
+            }
+        }
 
-static void cb_log_disable(enum ggml_log_level , const char * , void * ) { }
+        output_ext(wts, pcmf32s, fname_inp.c_str(), float(n_samples + 1000)/WHISPER_SAMPLE_RATE, fout_factory.fname_out.c_str());
+        output_func(output_json, ".json", params.output_jsn, pcmf32s);
+
+        // written by the library, to a file only
+        if (params.output_wtr) {
+            if (fout_factory.is_stdout) {
+                fprintf(stderr, "warning: not writing the binary transcript to stdout\n");
+            } else {
+                const std::string fname_wtr = fout_factory.fname_out.substr(0, fout_factory.basename_length) + ".wtr";
+                if (whisper_full_save_transcript_from_state(ctx, state, fname_wtr.c_str())) {
+                    fprintf(stderr, "%s: saving output to '%s'\n", "output_wtr", fname_wtr.c_str());
+                }
+            }
+        }
+        output_func(output_score, ".score.txt", params.log_score, pcmf32s);
+
+#undef output_ext
+#undef output_func
+
+        if (fout_factory.is_stdout && !fout_factory.used_stdout) {
+            fprintf(stderr, "warning: '--output-file -' used without any other '--output-*'");
+        }
+    }
+
+    return 0;
+}
+
+// --batch-workers: the files are transcribed on params.n_batch states of one context, which take them from a shared
+// queue, largest first, while a loader thread decodes the audio of the next files
+static int process_batch(struct whisper_context * ctx, struct whisper_context * ctx_draft, struct whisper_lora_adapter * lora, const whisper_params & params) {
+    struct batch_job {
+        int f; // index in params.fname_inp
+
+        std::vector<float> pcmf32;               // mono-channel F32 PCM
+        std::vector<std::vector<float>> pcmf32s; // stereo-channel F32 PCM
+    };
+
+    const int n_files   = params.fname_inp.size();
+    const int n_workers = std::min<int>(params.n_batch, n_files);
+
+    // the size of a file stands in for its duration - the longest files go first, so no worker is left with a long
+    // one at the end
+    std::vector<int64_t> file_size(n_files, 0);
+    for (int f = 0; f < n_files; ++f) {
+        std::ifstream fin(params.fname_inp[f], std::ios::binary | std::ios::ate);
+        if (fin) {
+            file_size[f] = std::max<int64_t>(0, fin.tellg());
+        }
+    }
+
+    std::vector<int> order(n_files);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return file_size[a] > file_size[b];
+    });
+
+    std::vector<whisper_state *> states;
+    for (int i = 0; i < n_workers; ++i) {
+        whisper_state * state = whisper_init_state(ctx);
+        if (state == nullptr) {
+            fprintf(stderr, "error: failed to initialize whisper state %d\n", i);
+            for (auto * s : states) {
+                whisper_free_state(s);
+            }
+            return 3;
+        }
+
+        // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
+        whisper_ctx_init_openvino_encoder_with_state(ctx, state, nullptr, params.openvino_encode_device.c_str(), nullptr);
+
+        whisper_set_lora_adapter_with_state(ctx, state, lora, params.lora_scale);
+
+        states.push_back(state);
+    }
+
+    if (!params.no_prints) {
+        fprintf(stderr, "\n");
+        fprintf(stderr, "system_info: n_threads = %d / %d | %s\n",
+                params.n_threads*n_workers, std::thread::hardware_concurrency(), whisper_print_system_info());
+
+        fprintf(stderr, "\n");
+        fprintf(stderr, "%s: processing %d files on %d states, %d threads each, %d beams + best of %d, lang = %s, task = %s, %stimestamps = %d ...\n",
+                __func__, n_files, n_workers, params.n_threads, params.beam_size, params.best_of,
+                params.language.c_str(),
+                params.translate ? "translate" : "transcribe",
+                params.tinydiarize ? "tdrz = 1, " : "",
+                params.no_timestamps ? 0 : 1);
+    }
+
+    const int64_t t_start_us = ggml_time_us();
+
+    // the decoded files - at most one waiting per worker, to bound the memory
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::unique_ptr<batch_job>> ready;
+    bool loaded = false;
+
+    std::thread loader([&]() {
+        for (int k = 0; k < n_files; ++k) {
+            std::unique_ptr<batch_job> job(new batch_job());
+            job->f = order[k];
+
+            if (!::read_audio_data(params.fname_inp[job->f], job->pcmf32, job->pcmf32s, params.diarize || params.split_channels)) {
+                fprintf(stderr, "error: failed to read audio file '%s'\n", params.fname_inp[job->f].c_str());
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return (int) ready.size() < n_workers; });
+
+            ready.push_back(std::move(job));
+            cv.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded = true;
+        cv.notify_all();
+    });
+
+    std::mutex mutex_out;
+    std::vector<int> rets(n_workers, 0);
+    std::vector<int64_t> n_samples(n_workers, 0);
+
+    auto worker = [&](int iw) {
+        while (true) {
+            std::unique_ptr<batch_job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !ready.empty() || loaded; });
+
+                if (ready.empty()) {
+                    break;
+                }
+
+                job = std::move(ready.front());
+                ready.pop_front();
+                cv.notify_all();
+            }
+
+            // the outputs of a file may change its params, e.g. "-of -" turns the progress off
+            whisper_params params_file = params;
+
+            const std::string fname_out = job->f < (int) params.fname_out.size() ? params.fname_out[job->f] : "";
+
+            const int ret = process_file(ctx, states[iw], ctx_draft, params_file, params.fname_inp[job->f], fname_out,
+                    job->pcmf32, job->pcmf32s, nullptr, &mutex_out);
+            if (ret != 0) {
+                rets[iw] = ret;
+            }
+
+            n_samples[iw] += job->pcmf32.size();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < n_workers; ++i) {
+        workers.emplace_back(worker, i);
+    }
+
+    worker(0);
+
+    for (auto & w : workers) {
+        w.join();
+    }
+    loader.join();
+
+    if (!params.no_prints) {
+        const float t_audio = (float) std::accumulate(n_samples.begin(), n_samples.end(), (int64_t) 0)/WHISPER_SAMPLE_RATE;
+        const float t_total = (ggml_time_us() - t_start_us)/1e6f;
+
+        fprintf(stderr, "\n%s: %.1f sec of audio transcribed in %.1f sec on %d states, %.1fx real time\n",
+                __func__, t_audio, t_total, n_workers, t_audio/std::max(t_total, 1e-3f));
+    }
+
+    for (auto * state : states) {
+        whisper_free_state(state);
+    }
+
+    for (int ret : rets) {
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
 
 int main(int argc, char ** argv) {
     ggml_backend_load_all();
@@ -987,6 +1688,12 @@ int main(int argc, char ** argv) {
         exit(0);
     }
 
+    if (params.n_batch > 0 && (params.long_form || params.n_processors > 1)) {
+        fprintf(stderr, "error: --batch-workers does not support --long-form and --processors\n");
+        whisper_print_usage(argc, argv, params);
+        exit(0);
+    }
+
     if (params.no_prints) {
         whisper_log_set(cb_log_disable, NULL);
     }
@@ -996,10 +1703,21 @@ int main(int argc, char ** argv) {
 
     cparams.use_gpu    = params.use_gpu;
     cparams.flash_attn = params.flash_attn;
+    cparams.use_mmap   = params.use_mmap;
+    cparams.use_hugepages = params.use_hugepages;
+    cparams.encoder_stream_weights = params.stream_encoder_weights;
+    cparams.encoder_mel_gpu = params.mel_gpu;
+    cparams.path_sched_cache = params.sched_cache.empty() ? nullptr : params.sched_cache.c_str();
+
+    if (params.kv_type == "q8_0") cparams.type_kv = GGML_TYPE_Q8_0;
+    if (params.kv_type == "q4_0") cparams.type_kv = GGML_TYPE_Q4_0;
+
+    cparams.max_memory = (size_t) std::max(0, params.max_memory_mb)*1000*1000;
 
     if (!params.dtw.empty()) {
         cparams.dtw_token_timestamps = true;
         cparams.dtw_aheads_preset = WHISPER_AHEADS_NONE;
+        cparams.dtw_incremental = params.dtw_incremental;
 
         if (params.dtw == "tiny")      cparams.dtw_aheads_preset = WHISPER_AHEADS_TINY;
         if (params.dtw == "tiny.en")   cparams.dtw_aheads_preset = WHISPER_AHEADS_TINY_EN;
@@ -1020,15 +1738,52 @@ int main(int argc, char ** argv) {
         }
     }
 
-    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    // the batch workers transcribe on states of their own
+    struct whisper_context * ctx = params.n_batch > 0 ?
+        whisper_init_from_file_with_params_no_state(params.model.c_str(), cparams) :
+        whisper_init_from_file_with_params         (params.model.c_str(), cparams);
 
     if (ctx == nullptr) {
         fprintf(stderr, "error: failed to initialize whisper context\n");
         return 3;
     }
 
+    struct whisper_context * ctx_draft = nullptr;
+
+    if (!params.model_draft.empty()) {
+        // the draft model is only used to propose tokens
+        whisper_context_params cparams_draft = cparams;
+        cparams_draft.dtw_token_timestamps = false;
+
+        ctx_draft = whisper_init_from_file_with_params(params.model_draft.c_str(), cparams_draft);
+
+        if (ctx_draft == nullptr) {
+            fprintf(stderr, "error: failed to initialize the draft whisper context\n");
+            whisper_free(ctx);
+            return 3;
+        }
+    }
+
     // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
-    whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+    if (params.n_batch == 0) {
+        whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+    }
+
+    struct whisper_lora_adapter * lora = nullptr;
+
+    if (!params.lora.empty()) {
+        lora = whisper_lora_adapter_init(ctx, params.lora.c_str());
+        if (lora == nullptr) {
+            fprintf(stderr, "error: failed to load the LoRA adapter '%s'\n", params.lora.c_str());
+            whisper_free(ctx);
+            whisper_free(ctx_draft);
+            return 3;
+        }
+
+        if (params.n_batch == 0) {
+            whisper_set_lora_adapter(ctx, lora, params.lora_scale);
+        }
+    }
 
     if (!params.grammar.empty()) {
         auto & grammar = params.grammar_parsed;
@@ -1053,237 +1808,104 @@ int main(int argc, char ** argv) {
         }
     }
 
-    for (int f = 0; f < (int) params.fname_inp.size(); ++f) {
-        const auto & fname_inp = params.fname_inp[f];
-        struct fout_factory {
-            std::string fname_out;
-            const size_t basename_length;
-            const bool is_stdout;
-            bool used_stdout;
-            decltype(whisper_print_segment_callback) * const print_segment_callback;
-            std::ofstream fout;
+    if (!params.bias_file.empty()) {
+        std::ifstream ifs(params.bias_file);
+        if (!ifs) {
+            fprintf(stderr, "error: failed to open bias file '%s'\n", params.bias_file.c_str());
+            return 4;
+        }
 
-            fout_factory (const std::string & fname_out_, const std::string & fname_inp, whisper_params & params) :
-                    fname_out{!fname_out_.empty() ? fname_out_ : fname_inp},
-                    basename_length{fname_out.size()},
-                    is_stdout{fname_out == "-"},
-                    used_stdout{},
-                    print_segment_callback{is_stdout ? nullptr : whisper_print_segment_callback} {
-                if (!print_segment_callback) {
-                    params.print_progress = false;
-                }
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
             }
 
-            bool open(const char * ext, const char * function) {
-                if (is_stdout) {
-                    if (used_stdout) {
-                        fprintf(stderr, "warning: Not appending multiple file formats to stdout\n");
-                        return false;
-                    }
-
-                    used_stdout = true;
-#ifdef _WIN32
-                    fout = std::ofstream{"CON"};
-#else
-                    fout = std::ofstream{"/dev/stdout"};
-#endif
-                    // Not using fprintf stderr here because it might equal stdout
-                    // Also assuming /dev is mounted
-                    return true;
-                }
+            float weight = params.bias_weight;
 
-                fname_out.resize(basename_length);
-                fname_out += ext;
-                fout = std::ofstream{fname_out};
-                if (!fout.is_open()) {
-                    fprintf(stderr, "%s: failed to open '%s' for writing\n", __func__, fname_out.c_str());
-                    return false;
-                }
-                fprintf(stderr, "%s: saving output to '%s'\n", function, fname_out.c_str());
-                return true;
+            const auto tab = line.find('\t');
+            if (tab != std::string::npos) {
+                weight = std::stof(line.substr(tab + 1));
+                line.resize(tab);
             }
-        } fout_factory{f < (int) params.fname_out.size() ? params.fname_out[f] : "", fname_inp, params};
-
-        std::vector<float> pcmf32;               // mono-channel F32 PCM
-        std::vector<std::vector<float>> pcmf32s; // stereo-channel F32 PCM
-
-        if (!::read_audio_data(fname_inp, pcmf32, pcmf32s, params.diarize)) {
-            fprintf(stderr, "error: failed to read audio file '%s'\n", fname_inp.c_str());
-            continue;
-        }
 
-        if (!whisper_is_multilingual(ctx)) {
-            if (params.language != "en" || params.translate) {
-                params.language = "en";
-                params.translate = false;
-                fprintf(stderr, "%s: WARNING: model is not multilingual, ignoring language and translation options\n", __func__);
-            }
-        }
-        if (params.detect_language) {
-            params.language = "auto";
+            params.bias_phrases.push_back(line);
+            params.bias_weights.push_back(weight);
         }
 
-        if (!params.no_prints) {
-            // print system information
-            fprintf(stderr, "\n");
-            fprintf(stderr, "system_info: n_threads = %d / %d | %s\n",
-                    params.n_threads*params.n_processors, std::thread::hardware_concurrency(), whisper_print_system_info());
+        fprintf(stderr, "%s: %d bias phrases\n", __func__, (int) params.bias_phrases.size());
+    }
 
-            // print some info about the processing
-            fprintf(stderr, "\n");
-            fprintf(stderr, "%s: processing '%s' (%d samples, %.1f sec), %d threads, %d processors, %d beams + best of %d, lang = %s, task = %s, %stimestamps = %d ...\n",
-                    __func__, fname_inp.c_str(), int(pcmf32.size()), float(pcmf32.size())/WHISPER_SAMPLE_RATE,
-                    params.n_threads, params.n_processors, params.beam_size, params.best_of,
-                    params.language.c_str(),
-                    params.translate ? "translate" : "transcribe",
-                    params.tinydiarize ? "tdrz = 1, " : "",
-                    params.no_timestamps ? 0 : 1);
-
-            if (params.print_colors) {
-                fprintf(stderr, "%s: color scheme: red (low confidence), yellow (medium), green (high confidence)\n", __func__);
-            } else if (params.print_confidence) {
-                fprintf(stderr, "%s: confidence: highlighted (low confidence), underlined (medium), dim (high confidence)\n", __func__);
-            }
-            fprintf(stderr, "\n");
+    if (!whisper_is_multilingual(ctx)) {
+        if (params.language != "en" || params.translate) {
+            params.language = "en";
+            params.translate = false;
+            fprintf(stderr, "%s: WARNING: model is not multilingual, ignoring language and translation options\n", __func__);
         }
+    }
+    if (params.detect_language) {
+        params.language = "auto";
+    }
 
-        // run the inference
-        {
-            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-
-            const bool use_grammar = (!params.grammar_parsed.rules.empty() && !params.grammar_rule.empty());
-            wparams.strategy = (params.beam_size > 1 || use_grammar) ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
-
-            wparams.print_realtime   = false;
-            wparams.print_progress   = params.print_progress;
-            wparams.print_timestamps = !params.no_timestamps;
-            wparams.print_special    = params.print_special;
-            wparams.translate        = params.translate;
-            wparams.language         = params.language.c_str();
-            wparams.detect_language  = params.detect_language;
-            wparams.n_threads        = params.n_threads;
-            wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
-            wparams.offset_ms        = params.offset_t_ms;
-            wparams.duration_ms      = params.duration_ms;
-
-            wparams.token_timestamps = params.output_wts || params.output_jsn_full || params.max_len > 0;
-            wparams.thold_pt         = params.word_thold;
-            wparams.max_len          = params.output_wts && params.max_len == 0 ? 60 : params.max_len;
-            wparams.split_on_word    = params.split_on_word;
-            wparams.audio_ctx        = params.audio_ctx;
-
-            wparams.debug_mode       = params.debug_mode;
-
-            wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
-
-            wparams.suppress_regex   = params.suppress_regex.empty() ? nullptr : params.suppress_regex.c_str();
-
-            wparams.initial_prompt   = params.prompt.c_str();
-
-            wparams.greedy.best_of        = params.best_of;
-            wparams.beam_search.beam_size = params.beam_size;
-
-            wparams.temperature_inc  = params.no_fallback ? 0.0f : params.temperature_inc;
-            wparams.temperature      = params.temperature;
-
-            wparams.entropy_thold    = params.entropy_thold;
-            wparams.logprob_thold    = params.logprob_thold;
-            wparams.no_speech_thold  = params.no_speech_thold;
-
-            wparams.no_timestamps    = params.no_timestamps;
-
-            wparams.suppress_nst     = params.suppress_nst;
-
-            wparams.vad            = params.vad;
-            wparams.vad_model_path = params.vad_model.c_str();
-
-            wparams.vad_params.threshold               = params.vad_threshold;
-            wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
-            wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
-            wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
-            wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
-            wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
+    if (params.n_batch > 0) {
+        const int ret = process_batch(ctx, ctx_draft, lora, params);
+        if (ret != 0) {
+            return ret;
+        }
+    } else {
+        for (int f = 0; f < (int) params.fname_inp.size(); ++f) {
+            const auto & fname_inp = params.fname_inp[f];
+            const std::string fname_out = f < (int) params.fname_out.size() ? params.fname_out[f] : "";
 
-            whisper_print_user_data user_data = { &params, &pcmf32s, 0 };
+            std::vector<float> pcmf32;               // mono-channel F32 PCM
+            std::vector<std::vector<float>> pcmf32s; // stereo-channel F32 PCM
 
-            const auto & grammar_parsed = params.grammar_parsed;
-            auto grammar_rules = grammar_parsed.c_rules();
+            // with --long-form the audio is decoded by the reader during the inference, pcmf32 stays empty
+            std::unique_ptr<audio_file_reader, decltype(&audio_file_reader_close)> reader(nullptr, &audio_file_reader_close);
 
-            if (use_grammar) {
-                if (grammar_parsed.symbol_ids.find(params.grammar_rule) == grammar_parsed.symbol_ids.end()) {
-                    fprintf(stderr, "%s: warning: grammar rule '%s' not found - skipping grammar sampling\n", __func__, params.grammar_rule.c_str());
-                } else {
-                    wparams.grammar_rules = grammar_rules.data();
-                    wparams.n_grammar_rules = grammar_rules.size();
-                    wparams.i_start_rule = grammar_parsed.symbol_ids.at(params.grammar_rule);
-                    wparams.grammar_penalty = params.grammar_penalty;
+            if (params.long_form) {
+                if (params.n_processors > 1 || params.vad) {
+                    fprintf(stderr, "error: --long-form does not support --processors and --vad\n");
+                    continue;
                 }
-            }
-
-            // this callback is called on each new segment
-            if (!wparams.print_realtime) {
-                wparams.new_segment_callback           = fout_factory.print_segment_callback;
-                wparams.new_segment_callback_user_data = &user_data;
-            }
-
-            if (wparams.print_progress) {
-                wparams.progress_callback           = whisper_print_progress_callback;
-                wparams.progress_callback_user_data = &user_data;
-            }
-
-            // examples for abort mechanism
-            // in examples below, we do not abort the processing, but we could if the flag is set to true
 
-            // the callback is called before every encoder run - if it returns false, the processing is aborted
-            {
-                static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
-
-                wparams.encoder_begin_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * user_data) {
-                    bool is_aborted = *(bool*)user_data;
-                    return !is_aborted;
-                };
-                wparams.encoder_begin_callback_user_data = &is_aborted;
-            }
-
-            // the callback is called before every computation - if it returns true, the computation is aborted
-            {
-                static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
-
-                wparams.abort_callback = [](void * user_data) {
-                    bool is_aborted = *(bool*)user_data;
-                    return is_aborted;
-                };
-                wparams.abort_callback_user_data = &is_aborted;
+                reader.reset(audio_file_reader_open(fname_inp));
+                if (!reader) {
+                    fprintf(stderr, "error: failed to read audio file '%s'\n", fname_inp.c_str());
+                    continue;
+                }
+            } else if (!::read_audio_data(fname_inp, pcmf32, pcmf32s, params.diarize || params.split_channels)) {
+                fprintf(stderr, "error: failed to read audio file '%s'\n", fname_inp.c_str());
+                continue;
             }
 
-            if (whisper_full_parallel(ctx, wparams, pcmf32.data(), pcmf32.size(), params.n_processors) != 0) {
-                fprintf(stderr, "%s: failed to process audio\n", argv[0]);
-                return 10;
+            if (!params.no_prints) {
+                // print system information
+                fprintf(stderr, "\n");
+                fprintf(stderr, "system_info: n_threads = %d / %d | %s\n",
+                        params.n_threads*params.n_processors, std::thread::hardware_concurrency(), whisper_print_system_info());
+
+                // print some info about the processing
+                fprintf(stderr, "\n");
+                fprintf(stderr, "%s: processing '%s' (%d samples, %.1f sec), %d threads, %d processors, %d beams + best of %d, lang = %s, task = %s, %stimestamps = %d ...\n",
+                        __func__, fname_inp.c_str(), int(pcmf32.size()), float(pcmf32.size())/WHISPER_SAMPLE_RATE,
+                        params.n_threads, params.n_processors, params.beam_size, params.best_of,
+                        params.language.c_str(),
+                        params.translate ? "translate" : "transcribe",
+                        params.tinydiarize ? "tdrz = 1, " : "",
+                        params.no_timestamps ? 0 : 1);
+
+                if (params.print_colors) {
+                    fprintf(stderr, "%s: color scheme: red (low confidence), yellow (medium), green (high confidence)\n", __func__);
+                } else if (params.print_confidence) {
+                    fprintf(stderr, "%s: confidence: highlighted (low confidence), underlined (medium), dim (high confidence)\n", __func__);
+                }
+                fprintf(stderr, "\n");
             }
-        }
-
-        // output stuff
-        {
-            // macros to stringify function name
-#define output_func(func, ext, param, ...) if (param && fout_factory.open(ext, #func)) {\
-    func(ctx, fout_factory.fout, params, __VA_ARGS__); \
-}
-#define output_ext(ext, ...) output_func(output_##ext, "." #ext, params.output_##ext, __VA_ARGS__)
-
-            output_ext(txt, pcmf32s);
-            output_ext(vtt, pcmf32s);
-            output_ext(srt, pcmf32s);
-            output_ext(wts, pcmf32s, fname_inp.c_str(), float(pcmf32.size() + 1000)/WHISPER_SAMPLE_RATE, fout_factory.fname_out.c_str());
-            output_ext(csv, pcmf32s);
-            output_func(output_json, ".json", params.output_jsn, pcmf32s);
-            output_ext(lrc, pcmf32s);
-            output_func(output_score, ".score.txt", params.log_score, pcmf32s);
-
-#undef output_ext
-#undef output_func
 
-            if (fout_factory.is_stdout && !fout_factory.used_stdout) {
-                fprintf(stderr, "warning: '--output-file -' used without any other '--output-*'");
+            const int ret = process_file(ctx, nullptr, ctx_draft, params, fname_inp, fname_out, pcmf32, pcmf32s, reader.get(), nullptr);
+            if (ret != 0) {
+                return ret;
             }
         }
     }
@@ -1292,6 +1914,8 @@ int main(int argc, char ** argv) {
         whisper_print_timings(ctx);
     }
     whisper_free(ctx);
+    whisper_free(ctx_draft);
+    whisper_lora_adapter_free(lora);
 
     return 0;
 }
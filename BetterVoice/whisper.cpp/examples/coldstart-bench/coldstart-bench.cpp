@@ -0,0 +1,530 @@
+// measures what a user waits for on the first transcription of a fresh process, phase by phase:
+//
+//   exec    - process start to main(), the dynamic loading of the whisper and ggml libraries
+//   backend - ggml_backend_load_all(), the backend libraries of a GGML_BACKEND_DL build
+//   load    - whisper_init_from_file_with_params_no_state(), the model file read or mapped into the backend buffers
+//   state   - whisper_init_state(), the KV caches and the schedulers with their graph allocations
+//   mel     - the log-mel spectrogram of the first 30 s window
+//   encode  - the first encode, including the compilation of the GPU pipelines it is the first to use
+//   token   - the first decoder pass over the prompt, to the first token
+//
+// followed by a second encode, of the window 1 s later, to tell the one-time cost of the first one
+//
+// every trial runs in a new process (this binary, re-executed with --child), optionally after dropping the model
+// files from the page cache, for each model (-m, e.g. a GGUF file and its legacy ggml .bin) and each loading mode
+// (-mm, read and/or mmap). the metal library (embedded source, embedded precompiled metallib or default.metallib)
+// is a build option, it is reported per trial from the log of the backend - build both variants to compare them
+
+#include "common-whisper.h"
+#include "whisper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#endif
+
+// command-line parameters
+struct coldstart_bench_params {
+    int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
+    int32_t n_trials  = 3;
+
+    std::vector<std::string> models; // empty for models/ggml-base.en.bin
+    std::vector<int>         mmaps = { 0, 1 };
+
+    std::string fname_inp;  // WAV file for the first window, 31 s of noise if empty
+    std::string language = "en";
+    std::string pipeline_cache; // GGML_METAL_PIPELINE_CACHE of the trials
+    std::string fname_json;     // also write the results to this file
+
+    bool use_gpu     = true;
+    bool flash_attn  = true;
+    bool drop_caches = false;
+
+    // set in the child processes
+    bool    child       = false;
+    int64_t t_spawn_us  = 0;
+};
+
+// the phases of one trial, in ms
+struct coldstart_bench_trial {
+    double exec_ms    = 0.0;
+    double backend_ms = 0.0;
+    double load_ms    = 0.0;
+    double state_ms   = 0.0;
+    double mel_ms     = 0.0;
+    double encode_ms  = 0.0;
+    double token_ms   = 0.0;
+    double encode2_ms = 0.0;
+
+    // the time to the first token, exec included
+    double total_ms() const {
+        return exec_ms + backend_ms + load_ms + state_ms + mel_ms + encode_ms + token_ms;
+    }
+};
+
+// the same steady clock in the parent and in the children, it is system-wide
+static int64_t coldstart_time_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::vector<std::string> split(const std::string & s, char sep) {
+    std::vector<std::string> res;
+    size_t pos = 0;
+    while (true) {
+        const size_t next = s.find(sep, pos);
+        res.push_back(s.substr(pos, next - pos));
+        if (next == std::string::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    return res;
+}
+
+static void coldstart_bench_print_usage(char ** argv, const coldstart_bench_params & params);
+
+static bool coldstart_bench_params_parse(int argc, char ** argv, coldstart_bench_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            coldstart_bench_print_usage(argv, params);
+            exit(0);
+        }
+        else if (arg == "-m"  || arg == "--model")          { params.models.push_back(argv[++i]); }
+        else if (arg == "-f"  || arg == "--file")           { params.fname_inp      = argv[++i]; }
+        else if (arg == "-mm" || arg == "--mmap")           {
+            params.mmaps.clear();
+            for (const auto & v : split(argv[++i], ',')) {
+                params.mmaps.push_back(std::stoi(v) != 0);
+            }
+        }
+        else if (arg == "-t"  || arg == "--threads")        { params.n_threads      = std::stoi(argv[++i]); }
+        else if (arg == "-r"  || arg == "--trials")         { params.n_trials       = std::max(1, std::stoi(argv[++i])); }
+        else if (arg == "-l"  || arg == "--language")       { params.language       = argv[++i]; }
+        else if (arg == "-pc" || arg == "--pipeline-cache") { params.pipeline_cache = argv[++i]; }
+        else if (arg == "-oj" || arg == "--output-json")    { params.fname_json     = argv[++i]; }
+        else if (arg == "-dc" || arg == "--drop-caches")    { params.drop_caches    = true; }
+        else if (arg == "-fa" || arg == "--flash-attn")     { params.flash_attn     = true; }
+        else if (arg == "-nfa" || arg == "--no-flash-attn") { params.flash_attn     = false; }
+        else if (arg == "-ng" || arg == "--no-gpu")         { params.use_gpu        = false; }
+        else if (arg == "--child")                          { params.child = true; params.t_spawn_us = std::stoll(argv[++i]); }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            coldstart_bench_print_usage(argv, params);
+            return false;
+        }
+    }
+
+    if (params.models.empty()) {
+        params.models.push_back("models/ggml-base.en.bin");
+    }
+
+    if (params.mmaps.empty()) {
+        fprintf(stderr, "error: no loading mode (-mm)\n");
+        return false;
+    }
+
+    return true;
+}
+
+static void coldstart_bench_print_usage(char ** argv, const coldstart_bench_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,        --help           show this help message and exit\n");
+    fprintf(stderr, "  -m FNAME,  --model FNAME    [%-7s] model path, repeat to compare models\n", "models/ggml-base.en.bin");
+    fprintf(stderr, "  -mm LIST,  --mmap LIST      [0,1    ] loading modes to run, 0 to read the file, 1 to mmap it\n");
+    fprintf(stderr, "  -f FNAME,  --file FNAME     [%-7s] WAV file for the first window, 31 s of noise if empty\n", params.fname_inp.c_str());
+    fprintf(stderr, "  -t N,      --threads N      [%-7d] number of threads\n", params.n_threads);
+    fprintf(stderr, "  -r N,      --trials N       [%-7d] new processes per model and loading mode\n", params.n_trials);
+    fprintf(stderr, "  -l LANG,   --language LANG  [%-7s] language of the prompt of multilingual models\n", params.language.c_str());
+    fprintf(stderr, "  -dc,       --drop-caches    [%-7s] drop the model files from the page cache before each trial\n", params.drop_caches ? "true" : "false");
+    fprintf(stderr, "  -pc FNAME, --pipeline-cache FNAME  GGML_METAL_PIPELINE_CACHE of the trials\n");
+    fprintf(stderr, "  -fa,       --flash-attn     [%-7s] enable flash attention\n", params.flash_attn ? "true" : "false");
+    fprintf(stderr, "  -nfa,      --no-flash-attn  [%-7s] disable flash attention\n", params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -ng,       --no-gpu         [%-7s] disable GPU\n", params.use_gpu ? "false" : "true");
+    fprintf(stderr, "  -oj FNAME, --output-json FNAME also write the results to a JSON file\n");
+    fprintf(stderr, "\n");
+}
+
+// the metal library the backend used, from its log
+static std::string g_metal_library = "-";
+
+static void coldstart_bench_log(enum ggml_log_level level, const char * text, void *) {
+    if (strstr(text, "using embedded precompiled metal library")) {
+        g_metal_library = "embedded-metallib";
+    } else if (strstr(text, "using embedded metal library")) {
+        g_metal_library = "embedded-source";
+    } else if (strstr(text, "default.metallib not found, loading from source")) {
+        g_metal_library = "source";
+    } else if (strstr(text, "loading '") && strstr(text, ".metallib'")) {
+        g_metal_library = "metallib";
+    }
+
+    if (level >= GGML_LOG_LEVEL_WARN) {
+        fputs(text, stderr);
+    }
+}
+
+// one trial, in a fresh process: prints the phases on stdout for the parent
+static int coldstart_bench_child(const coldstart_bench_params & params) {
+    coldstart_bench_trial res;
+
+    int64_t t_last_us = coldstart_time_us();
+    res.exec_ms = (t_last_us - params.t_spawn_us)/1000.0;
+
+    auto lap = [&t_last_us]() {
+        const int64_t t_now_us = coldstart_time_us();
+        const double ms = (t_now_us - t_last_us)/1000.0;
+        t_last_us = t_now_us;
+        return ms;
+    };
+
+    whisper_log_set(coldstart_bench_log, nullptr);
+
+    ggml_backend_load_all();
+    res.backend_ms = lap();
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+
+    cparams.use_gpu    = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+    cparams.use_mmap   = params.mmaps[0] != 0;
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params_no_state(params.models[0].c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: failed to load '%s'\n", params.models[0].c_str());
+        return 2;
+    }
+    res.load_ms = lap();
+
+    struct whisper_state * state = whisper_init_state(ctx);
+    if (state == nullptr) {
+        fprintf(stderr, "error: failed to create the state\n");
+        whisper_free(ctx);
+        return 3;
+    }
+    res.state_ms = lap();
+
+    // the audio is not part of the cold start
+    std::vector<float> pcmf32(WHISPER_SAMPLE_RATE*31);
+    {
+        // low noise rather than silence, the windows of silence have the same mel frames
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> dist(-0.01f, 0.01f);
+        for (auto & v : pcmf32) {
+            v = dist(rng);
+        }
+    }
+    if (!params.fname_inp.empty()) {
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_audio_data(params.fname_inp, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "error: failed to read '%s'\n", params.fname_inp.c_str());
+            whisper_free_state(state);
+            whisper_free(ctx);
+            return 4;
+        }
+    }
+    lap();
+
+    int ret = 0;
+
+    if (whisper_pcm_to_mel_with_state(ctx, state, pcmf32.data(), pcmf32.size(), params.n_threads) != 0) {
+        ret = 5;
+    }
+    res.mel_ms = lap();
+
+    if (ret == 0 && whisper_encode_with_state(ctx, state, 0, params.n_threads) != 0) {
+        ret = 6;
+    }
+    res.encode_ms = lap();
+
+    std::vector<whisper_token> prompt = { whisper_token_sot(ctx) };
+    if (whisper_is_multilingual(ctx)) {
+        prompt.push_back(whisper_token_lang(ctx, std::max(0, whisper_lang_id(params.language.c_str()))));
+        prompt.push_back(whisper_token_transcribe(ctx));
+    }
+    prompt.push_back(whisper_token_not(ctx));
+
+    whisper_token token = -1;
+    if (ret == 0 && whisper_decode_with_state(ctx, state, prompt.data(), prompt.size(), 0, params.n_threads) != 0) {
+        ret = 7;
+    }
+    if (ret == 0) {
+        const float * logits = whisper_get_logits_from_state(state) + (prompt.size() - 1)*whisper_n_vocab(ctx);
+        token = (whisper_token) (std::max_element(logits, logits + whisper_n_vocab(ctx)) - logits);
+    }
+    res.token_ms = lap();
+
+    // another window, the state reuses the encoder output of the same mel frames
+    if (ret == 0 && whisper_encode_with_state(ctx, state, 100, params.n_threads) != 0) {
+        ret = 6;
+    }
+    res.encode2_ms = lap();
+
+    whisper_free_state(state);
+    whisper_free(ctx);
+
+    if (ret != 0) {
+        fprintf(stderr, "error: the first transcription step failed (%d)\n", ret);
+        return ret;
+    }
+
+    printf("coldstart: %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %d %s\n",
+            res.exec_ms, res.backend_ms, res.load_ms, res.state_ms, res.mel_ms, res.encode_ms, res.token_ms,
+            res.encode2_ms, token, g_metal_library.c_str());
+
+    return 0;
+}
+
+// the argument quoted for the shell of popen()
+static std::string coldstart_bench_quote(const std::string & s) {
+#ifdef _WIN32
+    return "\"" + s + "\"";
+#else
+    std::string res = "'";
+    for (char c : s) {
+        if (c == '\'') {
+            res += "'\\''";
+        } else {
+            res += c;
+        }
+    }
+    return res + "'";
+#endif
+}
+
+// evicts the file from the page cache, so that the next load reads it from the disk
+static bool coldstart_bench_drop_cache(const std::string & fname) {
+#if defined(__linux__)
+    const int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#elif defined(__APPLE__)
+    // purges the whole unified buffer cache, requires root
+    (void) fname;
+    return system("purge") == 0;
+#else
+    (void) fname;
+    return false;
+#endif
+}
+
+static std::string coldstart_bench_format(const std::string & fname) {
+    char magic[4] = { 0 };
+    FILE * f = fopen(fname.c_str(), "rb");
+    if (f == nullptr) {
+        return "?";
+    }
+    const size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    return n == sizeof(magic) && memcmp(magic, "GGUF", 4) == 0 ? "gguf" : "ggml";
+}
+
+struct coldstart_bench_result {
+    std::string model;
+    std::string format;
+    std::string library;
+    bool use_mmap = false;
+
+    std::vector<coldstart_bench_trial> trials;
+
+    // the median of each phase over the trials
+    coldstart_bench_trial median() const {
+        auto med = [this](double coldstart_bench_trial::* field) {
+            std::vector<double> v;
+            for (const auto & t : trials) {
+                v.push_back(t.*field);
+            }
+            std::sort(v.begin(), v.end());
+            return v.empty() ? 0.0 : v[v.size()/2];
+        };
+
+        coldstart_bench_trial res;
+        res.exec_ms    = med(&coldstart_bench_trial::exec_ms);
+        res.backend_ms = med(&coldstart_bench_trial::backend_ms);
+        res.load_ms    = med(&coldstart_bench_trial::load_ms);
+        res.state_ms   = med(&coldstart_bench_trial::state_ms);
+        res.mel_ms     = med(&coldstart_bench_trial::mel_ms);
+        res.encode_ms  = med(&coldstart_bench_trial::encode_ms);
+        res.token_ms   = med(&coldstart_bench_trial::token_ms);
+        res.encode2_ms = med(&coldstart_bench_trial::encode2_ms);
+        return res;
+    }
+};
+
+static bool coldstart_bench_run(const char * argv0, const coldstart_bench_params & params, const std::string & model, bool use_mmap,
+        coldstart_bench_trial & trial, std::string & library) {
+    if (params.drop_caches && !coldstart_bench_drop_cache(model)) {
+        fprintf(stderr, "warning: failed to drop '%s' from the page cache\n", model.c_str());
+    }
+
+    std::string cmd;
+    if (!params.pipeline_cache.empty()) {
+#ifdef _WIN32
+        _putenv_s("GGML_METAL_PIPELINE_CACHE", params.pipeline_cache.c_str());
+#else
+        setenv("GGML_METAL_PIPELINE_CACHE", params.pipeline_cache.c_str(), 1);
+#endif
+    }
+
+    cmd += coldstart_bench_quote(argv0);
+    cmd += " -m "  + coldstart_bench_quote(model);
+    cmd += " -mm " + std::to_string(use_mmap ? 1 : 0);
+    cmd += " -t "  + std::to_string(params.n_threads);
+    cmd += " -l "  + coldstart_bench_quote(params.language);
+    if (!params.fname_inp.empty()) {
+        cmd += " -f " + coldstart_bench_quote(params.fname_inp);
+    }
+    if (!params.use_gpu) {
+        cmd += " -ng";
+    }
+    if (!params.flash_attn) {
+        cmd += " -nfa";
+    }
+
+    // the spawn time is taken last, the exec phase includes the shell of popen()
+    cmd += " --child " + std::to_string(coldstart_time_us());
+
+    FILE * pipe = popen(cmd.c_str(), "r");
+    if (pipe == nullptr) {
+        fprintf(stderr, "error: failed to run '%s'\n", cmd.c_str());
+        return false;
+    }
+
+    bool ok = false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), pipe)) {
+        int  token = -1;
+        char lib[64] = { 0 };
+        if (sscanf(line, "coldstart: %lf %lf %lf %lf %lf %lf %lf %lf %d %63s",
+                    &trial.exec_ms, &trial.backend_ms, &trial.load_ms, &trial.state_ms, &trial.mel_ms,
+                    &trial.encode_ms, &trial.token_ms, &trial.encode2_ms, &token, lib) == 10) {
+            library = lib;
+            ok = true;
+        }
+    }
+
+    const int status = pclose(pipe);
+
+    return ok && status == 0;
+}
+
+int main(int argc, char ** argv) {
+    ggml_time_init();
+
+    coldstart_bench_params params;
+
+    if (!coldstart_bench_params_parse(argc, argv, params)) {
+        return 1;
+    }
+
+    if (params.child) {
+        return coldstart_bench_child(params);
+    }
+
+    std::vector<coldstart_bench_result> results;
+
+    for (const auto & model : params.models) {
+        for (int use_mmap : params.mmaps) {
+            coldstart_bench_result res;
+            res.model    = model;
+            res.format   = coldstart_bench_format(model);
+            res.use_mmap = use_mmap != 0;
+
+            fprintf(stderr, "%s: '%s' (%s), %s, %d trials\n", __func__, model.c_str(), res.format.c_str(),
+                    use_mmap ? "mmap" : "read", params.n_trials);
+
+            for (int i = 0; i < params.n_trials; ++i) {
+                coldstart_bench_trial trial;
+                if (!coldstart_bench_run(argv[0], params, model, use_mmap != 0, trial, res.library)) {
+                    fprintf(stderr, "error: trial %d of '%s' failed\n", i + 1, model.c_str());
+                    return 2;
+                }
+                res.trials.push_back(trial);
+            }
+
+            results.push_back(res);
+        }
+    }
+
+    printf("\n");
+    printf("| %-32s | %6s | %4s | %17s | %7s | %7s | %8s | %8s | %7s | %9s | %8s | %9s | %9s |\n",
+            "model", "format", "mmap", "metal library", "exec", "backend", "load", "state", "mel", "encode",
+            "token", "total", "encode 2");
+    printf("|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|\n", "----------------------------------", "--------", "------",
+            "-------------------", "---------", "---------", "----------", "----------", "---------", "-----------",
+            "----------", "-----------", "-----------");
+    for (const auto & r : results) {
+        const coldstart_bench_trial m = r.median();
+
+        std::string name = r.model;
+        if (name.size() > 32) {
+            name = "..." + name.substr(name.size() - 29);
+        }
+
+        printf("| %-32s | %6s | %4s | %17s | %7.1f | %7.1f | %8.1f | %8.1f | %7.1f | %9.1f | %8.1f | %9.1f | %9.1f |\n",
+                name.c_str(), r.format.c_str(), r.use_mmap ? "yes" : "no", r.library.c_str(), m.exec_ms, m.backend_ms,
+                m.load_ms, m.state_ms, m.mel_ms, m.encode_ms, m.token_ms, m.total_ms(), m.encode2_ms);
+    }
+    printf("\n");
+    printf("median ms over %d trials%s\n", params.n_trials, params.drop_caches ? ", page cache dropped before each trial" : "");
+    printf("\n");
+
+    if (!params.fname_json.empty()) {
+        FILE * f = fopen(params.fname_json.c_str(), "w");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", params.fname_json.c_str());
+            return 5;
+        }
+
+        fprintf(f, "{\n");
+        fprintf(f, "  \"system_info\": \"%s\",\n", whisper_print_system_info());
+        fprintf(f, "  \"use_gpu\": %d,\n", params.use_gpu);
+        fprintf(f, "  \"flash_attn\": %d,\n", params.flash_attn);
+        fprintf(f, "  \"n_threads\": %d,\n", params.n_threads);
+        fprintf(f, "  \"drop_caches\": %d,\n", params.drop_caches);
+        fprintf(f, "  \"pipeline_cache\": \"%s\",\n", params.pipeline_cache.c_str());
+        fprintf(f, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto & r = results[i];
+            fprintf(f, "    { \"model\": \"%s\", \"format\": \"%s\", \"use_mmap\": %d, \"metal_library\": \"%s\", \"trials\": [\n",
+                    r.model.c_str(), r.format.c_str(), r.use_mmap, r.library.c_str());
+            for (size_t j = 0; j < r.trials.size(); ++j) {
+                const auto & t = r.trials[j];
+                fprintf(f, "      { \"exec_ms\": %.3f, \"backend_ms\": %.3f, \"load_ms\": %.3f, \"state_ms\": %.3f, "
+                        "\"mel_ms\": %.3f, \"encode_ms\": %.3f, \"token_ms\": %.3f, \"total_ms\": %.3f, \"encode2_ms\": %.3f }%s\n",
+                        t.exec_ms, t.backend_ms, t.load_ms, t.state_ms, t.mel_ms, t.encode_ms, t.token_ms, t.total_ms(),
+                        t.encode2_ms, j + 1 < r.trials.size() ? "," : "");
+            }
+            fprintf(f, "    ] }%s\n", i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n");
+        fprintf(f, "}\n");
+        fclose(f);
+    }
+
+    return 0;
+}
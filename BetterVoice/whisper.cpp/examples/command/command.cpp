@@ -6,16 +6,21 @@
 // ref: https://github.com/ggml-org/whisper.cpp/issues/171
 //
 
+#include "always-listen.h"
 #include "common-sdl.h"
 #include "common.h"
 #include "whisper.h"
 #include "grammar-parser.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -35,6 +40,8 @@ struct whisper_params {
 
     float grammar_penalty = 100.0f;
 
+    float kws_thold = -1.0f;
+
     grammar_parser::parse_state grammar_parsed;
 
     bool translate     = false;
@@ -43,6 +50,7 @@ struct whisper_params {
     bool no_timestamps = true;
     bool use_gpu       = true;
     bool flash_attn    = true;
+    bool kws           = false;
 
     std::string language  = "en";
     std::string model     = "models/ggml-base.en.bin";
@@ -51,6 +59,7 @@ struct whisper_params {
     std::string prompt;
     std::string context;
     std::string grammar;
+    std::string vad_model;
 
     // A regular expression that matches tokens to suppress
     std::string suppress_regex;
@@ -80,6 +89,8 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-ng"    || arg == "--no-gpu")        { params.use_gpu       = false; }
         else if (arg == "-fa"    || arg == "--flash-attn")    { params.flash_attn    = true; }
         else if (arg == "-nfa"   || arg == "--no-flash-attn") { params.flash_attn    = false; }
+        else if (arg == "-kws"   || arg == "--kws")           { params.kws           = true; }
+        else if (arg == "-kth"   || arg == "--kws-thold")     { params.kws_thold     = std::stof(argv[++i]); }
         else if (arg == "-l"     || arg == "--language")      { params.language      = argv[++i]; }
         else if (arg == "-m"     || arg == "--model")         { params.model         = argv[++i]; }
         else if (arg == "-f"     || arg == "--file")          { params.fname_out     = argv[++i]; }
@@ -89,6 +100,7 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (                   arg == "--grammar")       { params.grammar       = argv[++i]; }
         else if (                   arg == "--grammar-penalty") { params.grammar_penalty = std::stof(argv[++i]); }
         else if (                   arg == "--suppress-regex") { params.suppress_regex = argv[++i]; }
+        else if (arg == "-vm"    || arg == "--vad-model")     { params.vad_model     = argv[++i]; }
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
             whisper_print_usage(argc, argv, params);
@@ -119,6 +131,8 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  -ng,        --no-gpu         [%-7s] disable GPU\n",                                 params.use_gpu ? "false" : "true");
     fprintf(stderr, "  -fa,        --flash-attn     [%-7s] enbale flash attention\n",                      params.flash_attn ? "true" : "false");
     fprintf(stderr, "  -nfa,       --no-flash-attn  [%-7s] disable flash attention\n",                     params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -kws,       --kws            [%-7s] keyword spotting: score all commands in one batched pass\n", params.kws ? "true" : "false");
+    fprintf(stderr, "  -kth N,     --kws-thold N    [%-7.2f] keyword spotting: min mean token log-prob of a command\n", params.kws_thold);
     fprintf(stderr, "  -l LANG,    --language LANG  [%-7s] spoken language\n",                             params.language.c_str());
     fprintf(stderr, "  -m FNAME,   --model FNAME    [%-7s] model path\n",                                  params.model.c_str());
     fprintf(stderr, "  -f FNAME,   --file FNAME     [%-7s] text output file name\n",                       params.fname_out.c_str());
@@ -128,6 +142,7 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  --grammar GRAMMAR            [%-7s] GBNF grammar to guide decoding\n",              params.grammar.c_str());
     fprintf(stderr, "  --grammar-penalty N          [%-7.1f] scales down logits of nongrammar tokens\n",   params.grammar_penalty);
     fprintf(stderr, "  --suppress-regex REGEX       [%-7s] regular expression matching tokens to suppress\n", params.suppress_regex.c_str());
+    fprintf(stderr, "  -vm FNAME,  --vad-model FNAME [%-7s] always listen: Silero VAD model, whisper only runs on speech\n", params.vad_model.c_str());
     fprintf(stderr, "\n");
 }
 
@@ -251,6 +266,19 @@ static std::vector<std::string> get_words(const std::string &txt) {
     return words;
 }
 
+static std::string get_command_list_prompt(const std::vector<std::string> & allowed_commands) {
+    std::string prompt = "select one from the available words: ";
+    for (int i = 0; i < (int) allowed_commands.size(); ++i) {
+        if (i > 0) {
+            prompt += ", ";
+        }
+        prompt += allowed_commands[i];
+    }
+    prompt += ". selected word: ";
+
+    return prompt;
+}
+
 // command-list mode
 // guide the transcription to match the most likely command from a provided list
 static int process_command_list(struct whisper_context * ctx, audio_async &audio, const whisper_params &params, std::ofstream &fout) {
@@ -301,14 +329,7 @@ static int process_command_list(struct whisper_context * ctx, audio_async &audio
         fprintf(stderr, " ]\n");
     }
 
-    std::string k_prompt = "select one from the available words: ";
-    for (int i = 0; i < (int) allowed_commands.size(); ++i) {
-        if (i > 0) {
-            k_prompt += ", ";
-        }
-        k_prompt += allowed_commands[i];
-    }
-    k_prompt += ". selected word: ";
+    const std::string k_prompt = get_command_list_prompt(allowed_commands);
 
     // tokenize prompt
     std::vector<whisper_token> k_tokens;
@@ -466,9 +487,297 @@ static int process_command_list(struct whisper_context * ctx, audio_async &audio
     return 0;
 }
 
+// keyword-spotting mode
+// score the full token sequence of every command in a single batched decoder pass and reject the speech
+// that matches none of them - cheap enough to keep listening for a wake word or a fixed command set
+static int process_kws(struct whisper_context * ctx, audio_async & audio, const whisper_params & params, std::ofstream & fout) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "%s: keyword-spotting mode\n", __func__);
+
+    std::vector<std::string> allowed_commands = read_allowed_commands(params.commands);
+
+    if (allowed_commands.empty()) {
+        fprintf(stderr, "%s: error: failed to read allowed commands from '%s'\n", __func__, params.commands.c_str());
+        return 2;
+    }
+
+    int max_len = 0;
+
+    std::vector<std::vector<whisper_token>> allowed_tokens;
+
+    for (const auto & cmd : allowed_commands) {
+        // NOTE: the whitespace again, the command is the start of the transcription
+        const std::string ss = std::string(" ") + cmd;
+
+        allowed_tokens.emplace_back(1024);
+
+        const int n = whisper_tokenize(ctx, ss.c_str(), allowed_tokens.back().data(), 1024);
+        if (n <= 0) {
+            fprintf(stderr, "%s: error: failed to tokenize command '%s'\n", __func__, cmd.c_str());
+            return 3;
+        }
+
+        allowed_tokens.back().resize(n);
+
+        max_len = std::max(max_len, (int) cmd.size());
+    }
+
+    fprintf(stderr, "%s: allowed commands [ tokens ]:\n", __func__);
+    fprintf(stderr, "\n");
+    for (int i = 0; i < (int) allowed_commands.size(); ++i) {
+        fprintf(stderr, "  - \033[1m%-*s\033[0m = [", max_len, allowed_commands[i].c_str());
+        for (const auto & token : allowed_tokens[i]) {
+            fprintf(stderr, " %5d", token);
+        }
+        fprintf(stderr, " ]\n");
+    }
+
+    const std::string k_prompt = get_command_list_prompt(allowed_commands);
+
+    std::vector<whisper_token> k_tokens(1024);
+    {
+        const int n = whisper_tokenize(ctx, k_prompt.c_str(), k_tokens.data(), 1024);
+        if (n < 0) {
+            fprintf(stderr, "%s: error: failed to tokenize prompt '%s'\n", __func__, k_prompt.c_str());
+            return 4;
+        }
+        k_tokens.resize(n);
+    }
+
+    std::vector<const whisper_token *> seqs;
+    std::vector<int> seq_n_tokens;
+
+    for (const auto & tokens : allowed_tokens) {
+        seqs.push_back(tokens.data());
+        seq_n_tokens.push_back(tokens.size());
+    }
+
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.translate       = params.translate;
+    wparams.language        = params.language.c_str();
+    wparams.n_threads       = params.n_threads;
+    wparams.audio_ctx       = params.audio_ctx;
+    wparams.prompt_tokens   = k_tokens.data();
+    wparams.prompt_n_tokens = k_tokens.size();
+
+    fprintf(stderr, "\n");
+    fprintf(stderr, "%s: listening for a command ...\n", __func__);
+    fprintf(stderr, "\n");
+
+    bool is_running = true;
+
+    std::vector<float> pcmf32_cur;
+    std::vector<float> logprobs(allowed_commands.size());
+
+    // main loop
+    while (is_running) {
+        // handle Ctrl + C
+        is_running = sdl_poll_events();
+
+        // delay
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        audio.get(2000, pcmf32_cur);
+
+        if (!::vad_simple(pcmf32_cur, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, params.print_energy)) {
+            continue;
+        }
+
+        const auto t_start = std::chrono::high_resolution_clock::now();
+
+        if (whisper_full_score(ctx, wparams, pcmf32_cur.data(), pcmf32_cur.size(), seqs.data(), seq_n_tokens.data(), seqs.size(), logprobs.data()) != 0) {
+            fprintf(stderr, "%s: ERROR: whisper_full_score() failed\n", __func__);
+            break;
+        }
+
+        const auto t_end = std::chrono::high_resolution_clock::now();
+
+        audio.clear();
+
+        // the mean token log-prob rejects the speech that is none of the commands, and the softmax over the
+        // commands of their total log-probs is the confidence of the best one
+        std::vector<std::pair<float, int>> probs_id;
+
+        float lp_max = -INFINITY;
+        for (int i = 0; i < (int) allowed_commands.size(); ++i) {
+            lp_max = std::max(lp_max, logprobs[i]);
+        }
+
+        double psum = 0.0;
+        for (int i = 0; i < (int) allowed_commands.size(); ++i) {
+            probs_id.emplace_back(expf(logprobs[i] - lp_max), i);
+            psum += probs_id.back().first;
+        }
+
+        for (auto & p : probs_id) {
+            p.first /= psum;
+        }
+
+        {
+            using pair_type = decltype(probs_id)::value_type;
+            std::sort(probs_id.begin(), probs_id.end(), [](const pair_type & a, const pair_type & b) {
+                return a.first > b.first;
+            });
+        }
+
+        // print the commands, their probabilities and mean token log-probs
+        fprintf(stdout, "\n");
+        for (const auto & cmd : probs_id) {
+            fprintf(stdout, "%s: %s%-*s%s = %f | logprob = %f\n", __func__, "\033[1m", max_len, allowed_commands[cmd.second].c_str(), "\033[0m",
+                    cmd.first, logprobs[cmd.second]/seq_n_tokens[cmd.second]);
+        }
+
+        const int   index = probs_id[0].second;
+        const float prob  = probs_id[0].first;
+        const float lp    = logprobs[index]/seq_n_tokens[index];
+        const int   t_ms  = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
+
+        if (lp < params.kws_thold) {
+            fprintf(stdout, "%s: no command (best '%s', logprob = %f) | t = %d ms\n", __func__, allowed_commands[index].c_str(), lp, t_ms);
+            continue;
+        }
+
+        fprintf(stdout, "%s: detected command: %s%s%s | p = %f | logprob = %f | t = %d ms\n", __func__,
+                "\033[1m", allowed_commands[index].c_str(), "\033[0m", prob, lp, t_ms);
+
+        if (fout.is_open()) {
+            fout << allowed_commands[index] << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+// always-on listening (-vm): the streaming VAD runs on its own thread at the efficiency QoS over the audio captured
+// since its last pass, and the main thread sleeps until it closes a speech window
+class speech_listener {
+public:
+    speech_listener(audio_async & audio, struct whisper_vad_context * vctx, struct whisper_context * ctx)
+        : m_audio(audio), m_listen(vctx, ctx, WHISPER_SAMPLE_RATE, always_listen_params()) {
+        m_worker = std::thread([this]() { run(); });
+    }
+
+    ~speech_listener() {
+        m_running = false;
+        m_worker.join();
+    }
+
+    // hand over the next speech window, waiting at most 100 ms for it
+    // the previous window is done with at that point, which parks the whisper threads
+    bool wait(std::vector<float> & pcmf32) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_active) {
+            m_listen.active_end();
+            m_active = false;
+        }
+
+        m_cv.wait_for(lock, std::chrono::milliseconds(100), [this]() { return m_listen.n_ready() > 0; });
+
+        if (!m_listen.pop(pcmf32)) {
+            return false;
+        }
+
+        m_listen.active_begin();
+        m_active = true;
+
+        return true;
+    }
+
+    always_listen_stats stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_listen.stats();
+    }
+
+private:
+    void run() {
+        always_listen_set_efficiency_qos();
+
+        std::vector<float> pcmf32;
+
+        // stream position of the first sample not pushed to the VAD yet
+        uint64_t pos_done = UINT64_MAX;
+
+        while (m_running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            audio_ring_span spans[2];
+            int n_spans = 0;
+
+            const uint64_t pos = m_audio.get_spans(2000, spans, n_spans);
+
+            // the audio captured since the last pass
+            pcmf32.clear();
+
+            uint64_t p0 = pos;
+            for (int i = 0; i < n_spans; ++i) {
+                if (pos_done != UINT64_MAX && p0 + spans[i].n > pos_done) {
+                    const size_t i0 = pos_done > p0 ? pos_done - p0 : 0;
+                    pcmf32.insert(pcmf32.end(), spans[i].data + i0, spans[i].data + spans[i].n);
+                }
+                p0 += spans[i].n;
+            }
+
+            if (!m_audio.valid(pos)) {
+                continue;
+            }
+
+            pos_done = p0;
+
+            if (pcmf32.empty()) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (!m_listen.push(pcmf32.data(), pcmf32.size())) {
+                fprintf(stderr, "%s: VAD failed\n", __func__);
+                continue;
+            }
+
+            if (m_listen.n_ready() > 0) {
+                m_cv.notify_one();
+            }
+        }
+    }
+
+    audio_async & m_audio;
+
+    always_listen m_listen;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    bool                    m_active = false;
+
+    std::atomic<bool> m_running { true };
+    std::thread       m_worker;
+};
+
+// wait for the next speech, in up to len_ms of audio: a speech window of the listener, or without it the last
+// len_ms of audio once vad_simple() detects speech followed by silence at the end of the last 2 s
+static bool get_speech(audio_async & audio, speech_listener * listener, const whisper_params & params, int len_ms, std::vector<float> & pcmf32) {
+    if (listener) {
+        return listener->wait(pcmf32);
+    }
+
+    // delay
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    audio.get(2000, pcmf32);
+
+    if (!::vad_simple(pcmf32, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, params.print_energy)) {
+        return false;
+    }
+
+    audio.get(len_ms, pcmf32);
+
+    return true;
+}
+
 // always-prompt mode
 // transcribe the voice into text after valid prompt
-static int always_prompt_transcription(struct whisper_context * ctx, audio_async & audio, const whisper_params & params, std::ofstream & fout) {
+static int always_prompt_transcription(struct whisper_context * ctx, audio_async & audio, speech_listener * listener, const whisper_params & params, std::ofstream & fout) {
     bool is_running = true;
     bool ask_prompt = true;
 
@@ -490,9 +799,6 @@ static int always_prompt_transcription(struct whisper_context * ctx, audio_async
         // handle Ctrl + C
         is_running = sdl_poll_events();
 
-        // delay
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
         if (ask_prompt) {
             fprintf(stdout, "\n");
             fprintf(stdout, "%s: The prompt is: '%s%s%s'\n", __func__, "\033[1m", k_prompt.c_str(), "\033[0m");
@@ -502,16 +808,12 @@ static int always_prompt_transcription(struct whisper_context * ctx, audio_async
         }
 
         {
-            audio.get(2000, pcmf32_cur);
-
-            if (::vad_simple(pcmf32_cur, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, params.print_energy)) {
+            if (get_speech(audio, listener, params, params.command_ms, pcmf32_cur)) {
                 fprintf(stdout, "%s: Speech detected! Processing ...\n", __func__);
 
                 int64_t t_ms = 0;
 
                 // detect the commands
-                audio.get(params.command_ms, pcmf32_cur);
-
                 const auto txt = ::trim(::transcribe(ctx, params, pcmf32_cur, "", logprob_min, logprob_sum, n_tokens, t_ms));
 
                 const auto words = get_words(txt);
@@ -541,7 +843,10 @@ static int always_prompt_transcription(struct whisper_context * ctx, audio_async
 
                 fprintf(stdout, "\n");
 
-                audio.clear();
+                // the listener keeps reading the audio that follows
+                if (!listener) {
+                    audio.clear();
+                }
             }
         }
     }
@@ -551,7 +856,7 @@ static int always_prompt_transcription(struct whisper_context * ctx, audio_async
 
 // general-purpose mode
 // freely transcribe the voice into text
-static int process_general_transcription(struct whisper_context * ctx, audio_async & audio, const whisper_params & params, std::ofstream & fout) {
+static int process_general_transcription(struct whisper_context * ctx, audio_async & audio, speech_listener * listener, const whisper_params & params, std::ofstream & fout) {
     bool is_running  = true;
     bool have_prompt = false;
     bool ask_prompt  = true;
@@ -581,9 +886,6 @@ static int process_general_transcription(struct whisper_context * ctx, audio_asy
         // handle Ctrl + C
         is_running = sdl_poll_events();
 
-        // delay
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
         if (ask_prompt) {
             fprintf(stdout, "\n");
             fprintf(stdout, "%s: Say the following phrase: '%s%s%s'\n", __func__, "\033[1m", k_prompt.c_str(), "\033[0m");
@@ -593,17 +895,13 @@ static int process_general_transcription(struct whisper_context * ctx, audio_asy
         }
 
         {
-            audio.get(2000, pcmf32_cur);
-
-            if (::vad_simple(pcmf32_cur, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, params.print_energy)) {
+            if (get_speech(audio, listener, params, have_prompt ? params.command_ms : params.prompt_ms, pcmf32_cur)) {
                 fprintf(stdout, "%s: Speech detected! Processing ...\n", __func__);
 
                 int64_t t_ms = 0;
 
                 if (!have_prompt) {
                     // wait for activation phrase
-                    audio.get(params.prompt_ms, pcmf32_cur);
-
                     const auto txt = ::trim(::transcribe(ctx, params, pcmf32_cur, "prompt", logprob_min0, logprob_sum0, n_tokens0, t_ms));
 
                     const float p = 100.0f * std::exp(logprob_min0);
@@ -627,8 +925,6 @@ static int process_general_transcription(struct whisper_context * ctx, audio_asy
                     }
                 } else {
                     // we have heard the activation phrase, now detect the commands
-                    audio.get(params.command_ms, pcmf32_cur);
-
                     //printf("len prompt:  %.4f\n", pcmf32_prompt.size() / (float) WHISPER_SAMPLE_RATE);
                     //printf("len command: %.4f\n", pcmf32_cur.size() / (float) WHISPER_SAMPLE_RATE);
 
@@ -680,7 +976,10 @@ static int process_general_transcription(struct whisper_context * ctx, audio_asy
                     fprintf(stdout, "\n");
                 }
 
-                audio.clear();
+                // the listener keeps reading the audio that follows
+                if (!listener) {
+                    audio.clear();
+                }
             }
         }
     }
@@ -710,6 +1009,9 @@ int main(int argc, char ** argv) {
     cparams.use_gpu    = params.use_gpu;
     cparams.flash_attn = params.flash_attn;
 
+    // while always listening, the whisper threads are parked between speech windows
+    cparams.cpu_threadpool = !params.vad_model.empty();
+
     struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
     if (ctx == nullptr) {
         fprintf(stderr, "error: failed to initialize whisper context\n");
@@ -783,18 +1085,50 @@ int main(int argc, char ** argv) {
         }
     }
 
+    // always-on listening
+    struct whisper_vad_context * vctx = nullptr;
+    std::unique_ptr<speech_listener> listener;
+
+    if (ret_val == 0 && !params.vad_model.empty()) {
+        whisper_vad_context_params vparams = whisper_vad_default_context_params();
+
+        // the VAD runs all the time, on the CPU
+        vparams.n_threads     = 1;
+        vparams.use_gpu       = false;
+        vparams.cpu_fast_path = true;
+
+        vctx = whisper_vad_init_from_file_with_params(params.vad_model.c_str(), vparams);
+        if (vctx == nullptr) {
+            fprintf(stderr, "%s: failed to load VAD model '%s'\n", __func__, params.vad_model.c_str());
+            ret_val = 1;
+        } else {
+            listener.reset(new speech_listener(audio, vctx, ctx));
+        }
+    }
+
     if (ret_val == 0) {
-        if (!params.commands.empty()) {
+        if (!params.commands.empty() && params.kws) {
+            ret_val = process_kws(ctx, audio, params, fout);
+        } else if (!params.commands.empty()) {
             ret_val = process_command_list(ctx, audio, params, fout);
         } else if (!params.prompt.empty() && params.grammar_parsed.rules.empty()) {
-            ret_val = always_prompt_transcription(ctx, audio, params, fout);
+            ret_val = always_prompt_transcription(ctx, audio, listener.get(), params, fout);
         } else {
-            ret_val = process_general_transcription(ctx, audio, params, fout);
+            ret_val = process_general_transcription(ctx, audio, listener.get(), params, fout);
         }
     }
 
+    if (listener) {
+        always_listen::print_stats(listener->stats());
+        listener.reset();
+    }
+
     audio.pause();
 
+    if (vctx) {
+        whisper_vad_free(vctx);
+    }
+
     whisper_print_timings(ctx);
     whisper_free(ctx);
 
@@ -1,5 +1,7 @@
 #include "common-ggml.h"
 
+#include <cstring>
+#include <fstream>
 #include <regex>
 #include <map>
 
@@ -14,6 +16,7 @@ static const std::map<std::string, enum ggml_ftype> GGML_FTYPE_MAP = {
     {"q4_k", GGML_FTYPE_MOSTLY_Q4_K},
     {"q5_k", GGML_FTYPE_MOSTLY_Q5_K},
     {"q6_k", GGML_FTYPE_MOSTLY_Q6_K},
+    {"bf16", GGML_FTYPE_MOSTLY_BF16},
 };
 
 void ggml_print_ftypes(FILE * fp) {
@@ -24,7 +27,7 @@ void ggml_print_ftypes(FILE * fp) {
 
 enum ggml_ftype ggml_parse_ftype(const char * str) {
     enum ggml_ftype ftype;
-    if (str[0] == 'q') {
+    if (str[0] == 'q' || str[0] == 'b') {
         const auto it = GGML_FTYPE_MAP.find(str);
         if (it == GGML_FTYPE_MAP.end()) {
             fprintf(stderr, "%s: unknown ftype '%s'\n", __func__, str);
@@ -38,9 +41,40 @@ enum ggml_ftype ggml_parse_ftype(const char * str) {
     return ftype;
 }
 
+enum ggml_ftype ggml_ftype_from_type(ggml_type type) {
+    switch (type) {
+        case GGML_TYPE_F32:  return GGML_FTYPE_ALL_F32;
+        case GGML_TYPE_F16:  return GGML_FTYPE_MOSTLY_F16;
+        case GGML_TYPE_Q4_0: return GGML_FTYPE_MOSTLY_Q4_0;
+        case GGML_TYPE_Q4_1: return GGML_FTYPE_MOSTLY_Q4_1;
+        case GGML_TYPE_Q5_0: return GGML_FTYPE_MOSTLY_Q5_0;
+        case GGML_TYPE_Q5_1: return GGML_FTYPE_MOSTLY_Q5_1;
+        case GGML_TYPE_Q8_0: return GGML_FTYPE_MOSTLY_Q8_0;
+        case GGML_TYPE_Q2_K: return GGML_FTYPE_MOSTLY_Q2_K;
+        case GGML_TYPE_Q3_K: return GGML_FTYPE_MOSTLY_Q3_K;
+        case GGML_TYPE_Q4_K: return GGML_FTYPE_MOSTLY_Q4_K;
+        case GGML_TYPE_Q5_K: return GGML_FTYPE_MOSTLY_Q5_K;
+        case GGML_TYPE_Q6_K: return GGML_FTYPE_MOSTLY_Q6_K;
+        case GGML_TYPE_BF16: return GGML_FTYPE_MOSTLY_BF16;
+        default:             return GGML_FTYPE_UNKNOWN;
+    }
+}
+
+// type with smaller blocks, for rows that are not a multiple of the block size of type
+static ggml_type ggml_quantize_fallback_type(ggml_type type) {
+    switch (type) {
+        case GGML_TYPE_Q2_K:
+        case GGML_TYPE_Q3_K:
+        case GGML_TYPE_Q4_K: return GGML_TYPE_Q4_0;
+        case GGML_TYPE_Q5_K: return GGML_TYPE_Q5_0;
+        case GGML_TYPE_Q6_K: return GGML_TYPE_Q8_0;
+        default:             return GGML_TYPE_F16;
+    }
+}
+
 bool ggml_common_quantize_0(
-        std::ifstream & finp,
-        std::ofstream & fout,
+        std::istream & finp,
+        std::ostream & fout,
         const ggml_ftype ftype,
         const std::vector<std::string> & to_quant,
         const std::vector<std::string> & to_skip) {
@@ -84,13 +118,56 @@ bool ggml_common_quantize_0(
         return false;
     }
 
+    std::vector<ggml_quantize_rule> rules;
+    for (const auto & s : to_quant) {
+        rules.push_back({ s, qtype });
+    }
+
+    if (!ggml_common_quantize_rules(finp, fout, rules, to_skip)) {
+        return false;
+    }
+
+    printf("%s: ftype = %d (%s)\n", __func__, ftype, ggml_type_name(qtype));
+
+    return true;
+}
+
+bool ggml_common_quantize_rules(
+        std::istream & finp,
+        std::ostream & fout,
+        const std::vector<ggml_quantize_rule> & rules,
+        const std::vector<std::string> & to_skip,
+        ggml_type * type_main,
+        const std::map<std::string, std::vector<float>> * imatrix) {
+
+    for (const auto & rule : rules) {
+        if (!ggml_is_quantized(rule.type) && rule.type != GGML_TYPE_F16 && rule.type != GGML_TYPE_BF16 && rule.type != GGML_TYPE_F32) {
+            fprintf(stderr, "%s: invalid type %s for '%s'\n", __func__, ggml_type_name(rule.type), rule.pattern.c_str());
+            return false;
+        }
+    }
+
+    std::vector<std::regex> rules_re;
+    for (const auto & rule : rules) {
+        rules_re.emplace_back(rule.pattern);
+    }
+
+    std::vector<std::regex> to_skip_re;
+    for (const auto & s : to_skip) {
+        to_skip_re.emplace_back(s);
+    }
+
     size_t total_size_org = 0;
     size_t total_size_new = 0;
 
+    // converted elements per type
+    std::map<ggml_type, int64_t> n_elements_type;
+
     std::vector<float> work;
 
     std::vector<uint8_t>     data_u8;
     std::vector<ggml_fp16_t> data_f16;
+    std::vector<ggml_bf16_t> data_bf16;
     std::vector<float>       data_f32;
 
     while (true) {
@@ -118,19 +195,20 @@ bool ggml_common_quantize_0(
 
         printf("%64s - [%5d, %5d, %5d], type = %6s ", name.data(), ne[0], ne[1], ne[2], ggml_type_name((ggml_type) ttype));
 
-        bool quantize = false;
-
-        // check if we should quantize this tensor
-        for (const auto & s : to_quant) {
-            if (std::regex_match(name, std::regex(s))) {
-                quantize = true;
+        // the type of the first matching rule, if any
+        int i_rule = -1;
+        for (size_t i = 0; i < rules_re.size(); ++i) {
+            if (std::regex_match(name, rules_re[i])) {
+                i_rule = i;
                 break;
             }
         }
 
+        bool quantize = i_rule >= 0;
+
         // check if we should skip this tensor
-        for (const auto & s : to_skip) {
-            if (std::regex_match(name, std::regex(s))) {
+        for (const auto & re : to_skip_re) {
+            if (std::regex_match(name, re)) {
                 quantize = false;
                 break;
             }
@@ -139,8 +217,17 @@ bool ggml_common_quantize_0(
         // quantize only 2D tensors
         quantize &= (n_dims == 2);
 
+        ggml_type qtype = quantize ? rules[i_rule].type : (ggml_type) ttype;
+
+        while (quantize && ne[0] % ggml_blck_size(qtype) != 0) {
+            qtype = ggml_quantize_fallback_type(qtype);
+        }
+
+        // already of the type
+        quantize &= qtype != (ggml_type) ttype;
+
         if (quantize) {
-            if (ttype != GGML_TYPE_F32 && ttype != GGML_TYPE_F16) {
+            if (ttype != GGML_TYPE_F32 && ttype != GGML_TYPE_F16 && ttype != GGML_TYPE_BF16) {
                 fprintf(stderr, "%s: unsupported ttype %d (%s) for integer quantization\n", __func__, ttype, ggml_type_name((ggml_type) ttype));
                 return false;
             }
@@ -152,6 +239,11 @@ bool ggml_common_quantize_0(
                 for (int i = 0; i < nelements; ++i) {
                     data_f32[i] = ggml_fp16_to_fp32(data_f16[i]);
                 }
+            } else if (ttype == GGML_TYPE_BF16) {
+                data_bf16.resize(nelements);
+                finp.read(reinterpret_cast<char *>(data_bf16.data()), nelements * sizeof(ggml_bf16_t));
+                data_f32.resize(nelements);
+                ggml_bf16_to_fp32_row(data_bf16.data(), data_f32.data(), nelements);
             } else {
                 data_f32.resize(nelements);
                 finp.read(reinterpret_cast<char *>(data_f32.data()), nelements * sizeof(float));
@@ -159,10 +251,12 @@ bool ggml_common_quantize_0(
 
             ttype = qtype;
         } else {
-            const int bpe = (ttype == 0) ? sizeof(float) : sizeof(uint16_t);
+            data_u8.resize(ggml_row_size((ggml_type) ttype, nelements));
+            finp.read(reinterpret_cast<char *>(data_u8.data()), data_u8.size());
+        }
 
-            data_u8.resize(nelements*bpe);
-            finp.read(reinterpret_cast<char *>(data_u8.data()), nelements * bpe);
+        if (n_dims == 2) {
+            n_elements_type[(ggml_type) ttype] += nelements;
         }
 
         fout.write(reinterpret_cast<char *>(&n_dims), sizeof(n_dims));
@@ -189,10 +283,31 @@ bool ggml_common_quantize_0(
                 case GGML_TYPE_Q5_K:
                 case GGML_TYPE_Q6_K:
                     {
-                        cur_size = ggml_quantize_chunk((ggml_type) ttype, data_f32.data(), work.data(), 0, nelements/ne[0], ne[0], nullptr);
+                        const float * imat = nullptr;
+                        if (imatrix) {
+                            const auto it = imatrix->find(name);
+                            if (it != imatrix->end() && (int64_t) it->second.size() == ne[0]) {
+                                imat = it->second.data();
+                            }
+                        }
+
+                        cur_size = ggml_quantize_chunk((ggml_type) ttype, data_f32.data(), work.data(), 0, nelements/ne[0], ne[0], imat);
                     } break;
                 case GGML_TYPE_F32:
+                    {
+                        cur_size = nelements*sizeof(float);
+                        memcpy(work.data(), data_f32.data(), cur_size);
+                    } break;
                 case GGML_TYPE_F16:
+                    {
+                        cur_size = nelements*sizeof(ggml_fp16_t);
+                        ggml_fp32_to_fp16_row(data_f32.data(), reinterpret_cast<ggml_fp16_t *>(work.data()), nelements);
+                    } break;
+                case GGML_TYPE_BF16:
+                    {
+                        cur_size = nelements*sizeof(ggml_bf16_t);
+                        ggml_fp32_to_bf16_row(data_f32.data(), reinterpret_cast<ggml_bf16_t *>(work.data()), nelements);
+                    } break;
                 case GGML_TYPE_I8:
                 case GGML_TYPE_I16:
                 case GGML_TYPE_I32:
@@ -209,7 +324,6 @@ bool ggml_common_quantize_0(
                 case GGML_TYPE_IQ4_NL:
                 case GGML_TYPE_IQ4_XS:
                 case GGML_TYPE_IQ1_M:
-                case GGML_TYPE_BF16:
                 case GGML_TYPE_TQ1_0:
                 case GGML_TYPE_TQ2_0:
                 case GGML_TYPE_MXFP4:
@@ -223,7 +337,7 @@ bool ggml_common_quantize_0(
             fout.write(reinterpret_cast<char *>(work.data()), cur_size);
             total_size_new += cur_size;
 
-            printf("size = %8.2f MB -> %8.2f MB\n", nelements * sizeof(float)/1024.0/1024.0, cur_size/1024.0/1024.0);
+            printf("size = %8.2f MB -> %8.2f MB (%s)\n", nelements * sizeof(float)/1024.0/1024.0, cur_size/1024.0/1024.0, ggml_type_name(qtype));
         } else {
             printf("size = %8.3f MB\n", data_u8.size()/1024.0/1024.0);
             fout.write(reinterpret_cast<char *>(data_u8.data()), data_u8.size());
@@ -233,8 +347,66 @@ bool ggml_common_quantize_0(
         total_size_org += nelements * sizeof(float);
     }
 
+    if (type_main) {
+        int64_t n_max = -1;
+        for (const auto & it : n_elements_type) {
+            if (it.second > n_max) {
+                n_max = it.second;
+                *type_main = it.first;
+            }
+        }
+    }
+
     printf("%s: model size  = %8.2f MB\n", __func__, total_size_org/1024.0/1024.0);
-    printf("%s: quant size  = %8.2f MB | ftype = %d (%s)\n", __func__, total_size_new/1024.0/1024.0, ftype, ggml_type_name(qtype));
+    printf("%s: quant size  = %8.2f MB\n", __func__, total_size_new/1024.0/1024.0);
+
+    return true;
+}
+
+bool ggml_common_load_imatrix(const std::string & fname, std::map<std::string, std::vector<float>> & imatrix) {
+    std::ifstream fin(fname, std::ios::binary);
+    if (!fin) {
+        fprintf(stderr, "%s: failed to open '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+
+    int32_t n_entries = 0;
+    fin.read(reinterpret_cast<char *>(&n_entries), sizeof(n_entries));
+    if (!fin || n_entries < 0) {
+        fprintf(stderr, "%s: invalid importance matrix '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+
+    imatrix.clear();
+
+    for (int32_t i = 0; i < n_entries; ++i) {
+        int32_t len = 0;
+        fin.read(reinterpret_cast<char *>(&len), sizeof(len));
+        if (!fin || len <= 0 || len > 4096) {
+            fprintf(stderr, "%s: invalid entry %d in '%s'\n", __func__, i, fname.c_str());
+            return false;
+        }
+
+        std::string name(len, 0);
+        fin.read(&name[0], len);
+
+        int32_t n_call = 0;
+        int32_t n_val  = 0;
+        fin.read(reinterpret_cast<char *>(&n_call), sizeof(n_call));
+        fin.read(reinterpret_cast<char *>(&n_val),  sizeof(n_val));
+        if (!fin || n_val <= 0) {
+            fprintf(stderr, "%s: invalid entry '%s' in '%s'\n", __func__, name.c_str(), fname.c_str());
+            return false;
+        }
+
+        auto & values = imatrix[name];
+        values.resize(n_val);
+        fin.read(reinterpret_cast<char *>(values.data()), n_val*sizeof(float));
+        if (!fin) {
+            fprintf(stderr, "%s: truncated entry '%s' in '%s'\n", __func__, name.c_str(), fname.c_str());
+            return false;
+        }
+    }
 
     return true;
 }
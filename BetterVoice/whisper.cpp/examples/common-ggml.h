@@ -2,7 +2,9 @@
 
 #include "ggml.h"
 
-#include <fstream>
+#include <istream>
+#include <map>
+#include <ostream>
 #include <vector>
 #include <string>
 
@@ -11,8 +13,33 @@ enum ggml_ftype ggml_parse_ftype(const char * str);
 void ggml_print_ftypes(FILE * fp = stderr);
 
 bool ggml_common_quantize_0(
-        std::ifstream & finp,
-        std::ofstream & fout,
+        std::istream & finp,
+        std::ostream & fout,
         const ggml_ftype ftype,
         const std::vector<std::string> & to_quant,
         const std::vector<std::string> & to_skip);
+
+// type of the 2D tensors whose name matches the regex pattern
+struct ggml_quantize_rule {
+    std::string pattern;
+    ggml_type   type; // quantized, or GGML_TYPE_F16 / GGML_TYPE_F32 to convert
+};
+
+// quantize each 2D tensor to the type of the first rule matching its name, unless it matches to_skip
+// types that need a multiple of their block size in the rows fall back to a type with smaller blocks
+// type_main, if not null, is set to the type most of the converted tensor elements ended up with
+// imatrix, if not null, holds the importance of each column of the tensors it has an entry for
+bool ggml_common_quantize_rules(
+        std::istream & finp,
+        std::ostream & fout,
+        const std::vector<ggml_quantize_rule> & rules,
+        const std::vector<std::string> & to_skip,
+        ggml_type * type_main = nullptr,
+        const std::map<std::string, std::vector<float>> * imatrix = nullptr);
+
+// read an importance matrix written by whisper-imatrix: the mean squared input activation of each
+// column of the weight matrices, by tensor name
+bool ggml_common_load_imatrix(const std::string & fname, std::map<std::string, std::vector<float>> & imatrix);
+
+// ggml_ftype whose main type is type, GGML_FTYPE_UNKNOWN if there is none
+enum ggml_ftype ggml_ftype_from_type(ggml_type type);
@@ -1,5 +1,6 @@
 #include "common-sdl.h"
 
+#include <algorithm>
 #include <cstdio>
 
 audio_async::audio_async(int len_ms) {
@@ -9,6 +10,11 @@ audio_async::audio_async(int len_ms) {
 }
 
 audio_async::~audio_async() {
+    m_running = false;
+    if (m_playback_thread.joinable()) {
+        m_playback_thread.join();
+    }
+
     if (m_dev_id_in) {
         SDL_CloseAudioDevice(m_dev_id_in);
     }
@@ -73,13 +79,35 @@ bool audio_async::init(int capture_id, int sample_rate) {
 
     m_sample_rate = capture_spec_obtained.freq;
 
-    m_audio.resize((m_sample_rate*m_len_ms)/1000);
+    m_ring.reset(2*((m_sample_rate*m_len_ms)/1000));
+    m_audio_start = 0;
+
+    return true;
+}
+
+bool audio_async::init_playback(const std::vector<float> & samples, int sample_rate) {
+    // for the Ctrl + C handling of sdl_poll_events()
+    if (SDL_Init(SDL_INIT_EVENTS) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return false;
+    }
+
+    m_playback_on  = true;
+    m_playback     = samples;
+    m_playback_pos = 0;
+
+    m_sample_rate = sample_rate;
+
+    m_ring.reset(2*((m_sample_rate*m_len_ms)/1000));
+    m_audio_start = 0;
+
+    fprintf(stderr, "%s: playing back %.1f s of audio in real time\n", __func__, float(samples.size())/sample_rate);
 
     return true;
 }
 
 bool audio_async::resume() {
-    if (!m_dev_id_in) {
+    if (!is_open()) {
         fprintf(stderr, "%s: no audio device to resume!\n", __func__);
         return false;
     }
@@ -89,15 +117,44 @@ bool audio_async::resume() {
         return false;
     }
 
-    SDL_PauseAudioDevice(m_dev_id_in, 0);
-
     m_running = true;
 
+    if (m_playback_on) {
+        if (m_playback_thread.joinable()) {
+            m_playback_thread.join();
+        }
+
+        const auto t0 = std::chrono::steady_clock::now() - std::chrono::microseconds((int64_t) (1e6*m_playback_pos/m_sample_rate));
+        if (m_playback_pos == 0) {
+            m_playback_t0 = t0;
+        }
+
+        // blocks of the size SDL delivers, each one at the time its last sample is due
+        m_playback_thread = std::thread([this, t0]() {
+            const size_t n_block = 1024;
+
+            while (m_running && m_playback_pos < m_playback.size()) {
+                const size_t pos = m_playback_pos;
+                const size_t n   = std::min(n_block, m_playback.size() - pos);
+
+                std::this_thread::sleep_until(t0 + std::chrono::microseconds((int64_t) (1e6*(pos + n)/m_sample_rate)));
+
+                callback((uint8_t *) &m_playback[pos], n*sizeof(float));
+
+                m_playback_pos = pos + n;
+            }
+
+            notify();
+        });
+    } else {
+        SDL_PauseAudioDevice(m_dev_id_in, 0);
+    }
+
     return true;
 }
 
 bool audio_async::pause() {
-    if (!m_dev_id_in) {
+    if (!is_open()) {
         fprintf(stderr, "%s: no audio device to pause!\n", __func__);
         return false;
     }
@@ -107,15 +164,25 @@ bool audio_async::pause() {
         return false;
     }
 
-    SDL_PauseAudioDevice(m_dev_id_in, 1);
+    if (m_playback_on) {
+        m_running = false;
+
+        if (m_playback_thread.joinable()) {
+            m_playback_thread.join();
+        }
+    } else {
+        SDL_PauseAudioDevice(m_dev_id_in, 1);
+    }
 
     m_running = false;
 
+    notify();
+
     return true;
 }
 
 bool audio_async::clear() {
-    if (!m_dev_id_in) {
+    if (!is_open()) {
         fprintf(stderr, "%s: no audio device to clear!\n", __func__);
         return false;
     }
@@ -125,12 +192,7 @@ bool audio_async::clear() {
         return false;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        m_audio_pos = 0;
-        m_audio_len = 0;
-    }
+    m_audio_start = m_ring.end();
 
     return true;
 }
@@ -141,34 +203,57 @@ void audio_async::callback(uint8_t * stream, int len) {
         return;
     }
 
-    size_t n_samples = len / sizeof(float);
+    m_ring.write((const float *) stream, len / sizeof(float));
 
-    if (n_samples > m_audio.size()) {
-        n_samples = m_audio.size();
+    // pairs with the fence in wait_until(): either the reader sees the new samples or this sees its position
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-        stream += (len - (n_samples * sizeof(float)));
+    if (m_ring.end() >= m_wait_pos.load(std::memory_order_relaxed)) {
+        notify();
     }
+}
+
+void audio_async::notify() {
+    // the reader checks its condition under the lock, so the notification cannot fall between its check and its wait
+    { std::lock_guard<std::mutex> lock(m_wait_mutex); }
+    m_wait_cv.notify_all();
+}
 
-    //fprintf(stderr, "%s: %zu samples, pos %zu, len %zu\n", __func__, n_samples, m_audio_pos, m_audio_len);
+bool audio_async::wait_until(uint64_t pos, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(m_wait_mutex);
 
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    m_wait_pos.store(pos, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-        if (m_audio_pos + n_samples > m_audio.size()) {
-            const size_t n0 = m_audio.size() - m_audio_pos;
+    const bool reached = m_wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]() {
+        return m_ring.end() >= pos || !m_running || (m_playback_on && playback_done());
+    });
 
-            memcpy(&m_audio[m_audio_pos], stream, n0 * sizeof(float));
-            memcpy(&m_audio[0], stream + n0 * sizeof(float), (n_samples - n0) * sizeof(float));
-        } else {
-            memcpy(&m_audio[m_audio_pos], stream, n_samples * sizeof(float));
-        }
-        m_audio_pos = (m_audio_pos + n_samples) % m_audio.size();
-        m_audio_len = std::min(m_audio_len + n_samples, m_audio.size());
+    m_wait_pos.store(UINT64_MAX, std::memory_order_relaxed);
+
+    return reached && m_ring.end() >= pos;
+}
+
+uint64_t audio_async::get_spans(int ms, audio_ring_span spans[2], int & n_spans) {
+    n_spans = 0;
+
+    if (ms <= 0 || ms > m_len_ms) {
+        ms = m_len_ms;
     }
+
+    const uint64_t end = m_ring.end();
+
+    // the last ms of audio, not before clear() and within the last len_ms
+    const uint64_t n_kept  = std::min<uint64_t>(end - std::min(m_audio_start, end), (m_sample_rate*m_len_ms)/1000);
+    const size_t n_samples = std::min<uint64_t>((m_sample_rate*(uint64_t) ms)/1000, n_kept);
+
+    n_spans = m_ring.spans(end - n_samples, n_samples, spans);
+
+    return end - n_samples;
 }
 
 void audio_async::get(int ms, std::vector<float> & result) {
-    if (!m_dev_id_in) {
+    if (!is_open()) {
         fprintf(stderr, "%s: no audio device to get audio from!\n", __func__);
         return;
     }
@@ -178,35 +263,20 @@ void audio_async::get(int ms, std::vector<float> & result) {
         return;
     }
 
-    result.clear();
-
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if (ms <= 0) {
-            ms = m_len_ms;
-        }
-
-        size_t n_samples = (m_sample_rate * ms) / 1000;
-        if (n_samples > m_audio_len) {
-            n_samples = m_audio_len;
-        }
-
-        result.resize(n_samples);
+    audio_ring_span spans[2];
+    int n_spans = 0;
 
-        int s0 = m_audio_pos - n_samples;
-        if (s0 < 0) {
-            s0 += m_audio.size();
-        }
+    const uint64_t pos = get_spans(ms, spans, n_spans);
 
-        if (s0 + n_samples > m_audio.size()) {
-            const size_t n0 = m_audio.size() - s0;
+    result.clear();
+    for (int i = 0; i < n_spans; ++i) {
+        result.insert(result.end(), spans[i].data, spans[i].data + spans[i].n);
+    }
 
-            memcpy(result.data(), &m_audio[s0], n0 * sizeof(float));
-            memcpy(&result[n0], &m_audio[0], (n_samples - n0) * sizeof(float));
-        } else {
-            memcpy(result.data(), &m_audio[s0], n_samples * sizeof(float));
-        }
+    // the spans hold len_ms more of capture, so this only fires if this thread was stalled that long
+    if (!m_ring.valid(pos)) {
+        fprintf(stderr, "%s: audio overwritten while reading it, dropping %zu samples\n", __func__, result.size());
+        result.clear();
     }
 }
 
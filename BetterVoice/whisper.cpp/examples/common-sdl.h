@@ -1,12 +1,17 @@
 #pragma once
 
+#include "audio-ring.h"
+
 #include <SDL.h>
 #include <SDL_audio.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
-#include <vector>
 #include <mutex>
+#include <vector>
+#include <thread>
 
 //
 // SDL Audio capture
@@ -19,8 +24,17 @@ public:
 
     bool init(int capture_id, int sample_rate);
 
+    // instead of capturing, play back the given samples into the buffer at wall-clock speed once resumed, for
+    // reproducible benchmarks of the real-time examples
+    bool init_playback(const std::vector<float> & samples, int sample_rate);
+
+    // the wall-clock time of the first played back sample and the number of samples played back so far
+    std::chrono::steady_clock::time_point playback_start() const { return m_playback_t0; }
+    size_t playback_pos() const { return m_playback_pos; }
+    bool   playback_done() const { return m_playback_pos >= m_playback.size(); }
+
     // start capturing audio via the provided SDL callback
-    // keep last len_ms seconds of audio in a circular buffer
+    // keep last len_ms seconds of audio in a lock-free circular buffer, the callback never waits for get()
     bool resume();
     bool pause();
     bool clear();
@@ -31,18 +45,49 @@ public:
     // get audio data from the circular buffer
     void get(int ms, std::vector<float> & audio);
 
+    // same as get() without the copy: the last ms of audio in place, as up to two spans of the circular buffer
+    // returns the position of the first sample; pass it to valid() when done with the spans, false means that the
+    // capture overwrote them meanwhile - they stay intact for at least len_ms of further capture
+    uint64_t get_spans(int ms, audio_ring_span spans[2], int & n_spans);
+    bool     valid(uint64_t pos) const { return m_ring.valid(pos); }
+
+    // stream positions (samples captured since init) of the newest sample and of the last clear()
+    uint64_t pos_end()   const { return m_ring.end(); }
+    uint64_t pos_clear() const { return m_audio_start; }
+
+    // block until the capture reaches pos, woken by the callback instead of polling
+    // returns false after timeout_ms, or early once paused or the played back audio is consumed, so that the caller
+    // can still handle events
+    bool wait_until(uint64_t pos, int timeout_ms);
+
 private:
+    bool is_open() const { return m_dev_id_in || m_playback_on; }
+
     SDL_AudioDeviceID m_dev_id_in = 0;
 
+    bool                m_playback_on = false;
+    std::vector<float>  m_playback;
+    std::atomic<size_t> m_playback_pos { 0 };
+    std::thread         m_playback_thread;
+
+    std::chrono::steady_clock::time_point m_playback_t0;
+
     int m_len_ms = 0;
     int m_sample_rate = 0;
 
     std::atomic_bool m_running;
-    std::mutex       m_mutex;
 
-    std::vector<float> m_audio;
-    size_t             m_audio_pos = 0;
-    size_t             m_audio_len = 0;
+    // twice the kept audio, so that the spans of get_spans() outlive another len_ms of capture
+    audio_ring m_ring;
+    uint64_t   m_audio_start = 0; // position of the oldest sample since clear(), reader side only
+
+    // wait_until(): the position the reader waits for, UINT64_MAX when none, so that the callback only takes the
+    // mutex - held by the reader just to check the position - when there is someone to wake up
+    std::atomic<uint64_t>   m_wait_pos { UINT64_MAX };
+    std::mutex              m_wait_mutex;
+    std::condition_variable m_wait_cv;
+
+    void notify();
 };
 
 // Return false if need to quit
@@ -37,8 +37,53 @@
 #ifdef WHISPER_FFMPEG
 // as implemented in ffmpeg_trancode.cpp only embedded in common lib if whisper built with ffmpeg support
 extern bool ffmpeg_decode_audio(const std::string & ifname, std::vector<uint8_t> & wav_data);
+extern int  ffmpeg_decode_audio_memory(const uint8_t * idata, size_t isize, std::vector<uint8_t> & wav_data);
 #endif
 
+// read all frames of an initialized decoder into pcmf32 (and pcmf32s for stereo), uninitializes the decoder
+static bool read_audio_frames(ma_decoder & decoder, std::vector<float> & pcmf32, std::vector<std::vector<float>> & pcmf32s, bool stereo) {
+    ma_result result;
+    ma_uint64 frame_count;
+    ma_uint64 frames_read;
+
+    if ((result = ma_decoder_get_length_in_pcm_frames(&decoder, &frame_count)) != MA_SUCCESS) {
+		fprintf(stderr, "error: failed to retrieve the length of the audio data (%s)\n", ma_result_description(result));
+		ma_decoder_uninit(&decoder);
+
+		return false;
+    }
+
+    pcmf32.resize(stereo ? frame_count*2 : frame_count);
+
+    if ((result = ma_decoder_read_pcm_frames(&decoder, pcmf32.data(), frame_count, &frames_read)) != MA_SUCCESS) {
+		fprintf(stderr, "error: failed to read the frames of the audio data (%s)\n", ma_result_description(result));
+		ma_decoder_uninit(&decoder);
+
+		return false;
+    }
+
+    if (stereo) {
+        std::vector<float> stereo_data = pcmf32;
+        pcmf32.resize(frame_count);
+
+        for (uint64_t i = 0; i < frame_count; i++) {
+            pcmf32[i] = (stereo_data[2*i] + stereo_data[2*i + 1]);
+        }
+
+        pcmf32s.resize(2);
+        pcmf32s[0].resize(frame_count);
+        pcmf32s[1].resize(frame_count);
+        for (uint64_t i = 0; i < frame_count; i++) {
+            pcmf32s[0][i] = stereo_data[2*i];
+            pcmf32s[1][i] = stereo_data[2*i + 1];
+        }
+    }
+
+    ma_decoder_uninit(&decoder);
+
+    return true;
+}
+
 bool read_audio_data(const std::string & fname, std::vector<float>& pcmf32, std::vector<std::vector<float>>& pcmf32s, bool stereo) {
     std::vector<uint8_t> audio_data; // used for pipe input from stdin or ffmpeg decoding output
 
@@ -94,43 +139,88 @@ bool read_audio_data(const std::string & fname, std::vector<float>& pcmf32, std:
 #endif
     }
 
-    ma_uint64 frame_count;
-    ma_uint64 frames_read;
+    return read_audio_frames(decoder, pcmf32, pcmf32s, stereo);
+}
 
-    if ((result = ma_decoder_get_length_in_pcm_frames(&decoder, &frame_count)) != MA_SUCCESS) {
-		fprintf(stderr, "error: failed to retrieve the length of the audio data (%s)\n", ma_result_description(result));
+bool read_audio_data_from_memory(const std::string & data, std::vector<float> & pcmf32, std::vector<std::vector<float>> & pcmf32s, bool stereo) {
+    ma_result result;
+    ma_decoder_config decoder_config = ma_decoder_config_init(ma_format_f32, stereo ? 2 : 1, WHISPER_SAMPLE_RATE);
+    ma_decoder decoder;
+
+    if ((result = ma_decoder_init_memory(data.data(), data.size(), &decoder_config, &decoder)) != MA_SUCCESS) {
+#if defined(WHISPER_FFMPEG)
+		std::vector<uint8_t> wav_data;
+		if (ffmpeg_decode_audio_memory((const uint8_t *) data.data(), data.size(), wav_data) != 0) {
+			fprintf(stderr, "error: failed to ffmpeg decode audio data\n");
+
+			return false;
+		}
+
+		if ((result = ma_decoder_init_memory(wav_data.data(), wav_data.size(), &decoder_config, &decoder)) != MA_SUCCESS) {
+			fprintf(stderr, "error: failed to read audio data as wav (%s)\n", ma_result_description(result));
+
+			return false;
+		}
+
+		return read_audio_frames(decoder, pcmf32, pcmf32s, stereo);
+#else
+		fprintf(stderr, "error: failed to decode audio data (%s)\n", ma_result_description(result));
 
 		return false;
+#endif
     }
 
-    pcmf32.resize(stereo ? frame_count*2 : frame_count);
+    return read_audio_frames(decoder, pcmf32, pcmf32s, stereo);
+}
 
-    if ((result = ma_decoder_read_pcm_frames(&decoder, pcmf32.data(), frame_count, &frames_read)) != MA_SUCCESS) {
-		fprintf(stderr, "error: failed to read the frames of the audio data (%s)\n", ma_result_description(result));
+struct audio_file_reader {
+    ma_decoder decoder;
 
-		return false;
+    int64_t n_read = 0;
+};
+
+audio_file_reader * audio_file_reader_open(const std::string & fname) {
+    ma_decoder_config decoder_config = ma_decoder_config_init(ma_format_f32, 1, WHISPER_SAMPLE_RATE);
+
+    auto * reader = new audio_file_reader;
+
+    ma_result result;
+    if ((result = ma_decoder_init_file(fname.c_str(), &decoder_config, &reader->decoder)) != MA_SUCCESS) {
+        fprintf(stderr, "error: failed to open audio file '%s' (%s)\n", fname.c_str(), ma_result_description(result));
+        delete reader;
+
+        return nullptr;
     }
 
-    if (stereo) {
-        std::vector<float> stereo_data = pcmf32;
-        pcmf32.resize(frame_count);
+    return reader;
+}
 
-        for (uint64_t i = 0; i < frame_count; i++) {
-            pcmf32[i] = (stereo_data[2*i] + stereo_data[2*i + 1]);
-        }
+int audio_file_reader_read(void * user_data, float * dst, int n_samples) {
+    auto * reader = (audio_file_reader *) user_data;
 
-        pcmf32s.resize(2);
-        pcmf32s[0].resize(frame_count);
-        pcmf32s[1].resize(frame_count);
-        for (uint64_t i = 0; i < frame_count; i++) {
-            pcmf32s[0][i] = stereo_data[2*i];
-            pcmf32s[1][i] = stereo_data[2*i + 1];
-        }
+    ma_uint64 frames_read = 0;
+
+    ma_result result = ma_decoder_read_pcm_frames(&reader->decoder, dst, n_samples, &frames_read);
+    if (result != MA_SUCCESS && result != MA_AT_END) {
+        fprintf(stderr, "error: failed to read the frames of the audio file (%s)\n", ma_result_description(result));
+
+        return -1;
     }
 
-    ma_decoder_uninit(&decoder);
+    reader->n_read += frames_read;
 
-    return true;
+    return (int) frames_read;
+}
+
+int64_t audio_file_reader_n_read(const audio_file_reader * reader) {
+    return reader->n_read;
+}
+
+void audio_file_reader_close(audio_file_reader * reader) {
+    if (reader) {
+        ma_decoder_uninit(&reader->decoder);
+        delete reader;
+    }
 }
 
 //  500 -> 00:05.000
@@ -14,6 +14,30 @@ bool read_audio_data(
         std::vector<std::vector<float>> & pcmf32s,
         bool stereo);
 
+// Decode an audio file held in memory (WAV, MP3, FLAC or Ogg Vorbis, or any format ffmpeg
+// supports when built with WHISPER_FFMPEG) and resample it to WHISPER_SAMPLE_RATE mono F32 PCM.
+// Nothing is written to or read from the filesystem.
+bool read_audio_data_from_memory(
+        const std::string & data,
+        std::vector<float> & pcmf32,
+        std::vector<std::vector<float>> & pcmf32s,
+        bool stereo);
+
+// Incremental decoder of an audio file (WAV, MP3, FLAC or Ogg Vorbis) to WHISPER_SAMPLE_RATE mono F32 PCM,
+// for whisper_full_from_source() - only the requested samples are decoded, never the whole file
+struct audio_file_reader;
+
+audio_file_reader * audio_file_reader_open(const std::string & fname);
+
+// decode up to n_samples into dst, returns the number decoded (0 at the end of the file) or -1 on error
+// the signature matches whisper_audio_source::read, with the reader as the user data
+int audio_file_reader_read(void * reader, float * dst, int n_samples);
+
+// total number of samples decoded so far
+int64_t audio_file_reader_n_read(const audio_file_reader * reader);
+
+void audio_file_reader_close(audio_file_reader * reader);
+
 // convert timestamp to string, 6000 -> 01:00.000
 std::string to_timestamp(int64_t t, bool comma = false);
 
@@ -322,32 +322,18 @@ static int decode_audio(struct audio_buffer *audio_buf, s16 **data, int *size)
 }
 
 // in mem decoding/conversion/resampling:
-// ifname: input file path
+// idata, isize: input audio file contents, in any format ffmpeg can decode
 // owav_data: in mem wav file. Can be forwarded as it to whisper/drwav
 // return 0 on success
-int ffmpeg_decode_audio(const std::string &ifname, std::vector<uint8_t>& owav_data) {
-    LOG("ffmpeg_decode_audio: %s\n", ifname.c_str());
-    int ifd = open(ifname.c_str(), O_RDONLY);
-    if (ifd == -1) {
-        fprintf(stderr, "Couldn't open input file %s\n", ifname.c_str());
-        return -1;
-    }
-    u8 *ibuf = NULL;
-    size_t ibuf_size;
-    int err = map_file(ifd, &ibuf, &ibuf_size);
-    if (err) {
-        LOG("Couldn't map input file %s\n", ifname.c_str());
-        return err;
-    }
-    LOG("Mapped input file: %s size: %d\n", ibuf, (int) ibuf_size);
+int ffmpeg_decode_audio_memory(const uint8_t * idata, size_t isize, std::vector<uint8_t>& owav_data) {
     struct audio_buffer inaudio_buf;
-    inaudio_buf.ptr = ibuf;
-    inaudio_buf.size = ibuf_size;
+    inaudio_buf.ptr = const_cast<u8 *>(idata); // only read by read_packet()
+    inaudio_buf.size = isize;
 
     s16 *odata=NULL;
     int osize=0;
 
-    err = decode_audio(&inaudio_buf, &odata, &osize);
+    int err = decode_audio(&inaudio_buf, &odata, &osize);
     LOG("decode_audio returned %d \n", err);
     if (err != 0) {
         LOG("decode_audio failed\n");
@@ -366,3 +352,25 @@ int ffmpeg_decode_audio(const std::string &ifname, std::vector<uint8_t>& owav_da
 
     return 0;
 }
+
+// ifname: input file path
+// owav_data: in mem wav file. Can be forwarded as it to whisper/drwav
+// return 0 on success
+int ffmpeg_decode_audio(const std::string &ifname, std::vector<uint8_t>& owav_data) {
+    LOG("ffmpeg_decode_audio: %s\n", ifname.c_str());
+    int ifd = open(ifname.c_str(), O_RDONLY);
+    if (ifd == -1) {
+        fprintf(stderr, "Couldn't open input file %s\n", ifname.c_str());
+        return -1;
+    }
+    u8 *ibuf = NULL;
+    size_t ibuf_size;
+    int err = map_file(ifd, &ibuf, &ibuf_size);
+    if (err) {
+        LOG("Couldn't map input file %s\n", ifname.c_str());
+        return err;
+    }
+    LOG("Mapped input file: %s size: %d\n", ibuf, (int) ibuf_size);
+
+    return ffmpeg_decode_audio_memory(ibuf, ibuf_size, owav_data);
+}
@@ -26,28 +26,96 @@ async function clearCache() {
     }
 }
 
-// fetch a remote file from remote URL using the Fetch API
-async function fetchRemote(url, cbProgress, cbPrint) {
+// the models are cached in the IndexedDB in chunks of this size, each one stored as soon as it is downloaded:
+// an interrupted download resumes from the first missing chunk, and no single huge record has to be written
+const chunkSizeDB = 16*1024*1024;
+
+// promise wrappers of the IndexedDB requests
+function openDB() {
+    return new Promise(function (resolve, reject) {
+        var rq = indexedDB.open(dbName, dbVersion);
+
+        rq.onupgradeneeded = function (event) {
+            var db = event.target.result;
+            if (db.version == 1) {
+                db.createObjectStore('models', { autoIncrement: false });
+                console.log('openDB: created IndexedDB ' + db.name + ' version ' + db.version);
+            } else {
+                // clear the database
+                event.currentTarget.transaction.objectStore('models').clear();
+                console.log('openDB: cleared IndexedDB ' + db.name + ' version ' + db.version);
+            }
+        };
+
+        rq.onsuccess = function (event) { resolve(event.target.result); };
+        rq.onerror   = function (event) { reject('failed to open IndexedDB'); };
+        rq.onblocked = function (event) { reject('failed to open IndexedDB: blocked'); };
+        rq.onabort   = function (event) { reject('failed to open IndexedDB: abort'); };
+    });
+}
+
+function getDB(db, key) {
+    return new Promise(function (resolve, reject) {
+        var rq = db.transaction(['models'], 'readonly').objectStore('models').get(key);
+        rq.onsuccess = function (event) { resolve(rq.result); };
+        rq.onerror   = function (event) { reject('failed to get "' + key + '" from the IndexedDB'); };
+    });
+}
+
+function putDB(db, key, value) {
+    return new Promise(function (resolve, reject) {
+        var rq = db.transaction(['models'], 'readwrite').objectStore('models').put(value, key);
+        rq.onsuccess = function (event) { resolve(); };
+        rq.onerror   = function (event) { reject('failed to store "' + key + '" in the IndexedDB'); };
+    });
+}
+
+function concatChunks(chunks, size) {
+    var data = new Uint8Array(size);
+    var position = 0;
+
+    for (var chunk of chunks) {
+        data.set(chunk, position);
+        position += chunk.length;
+    }
+
+    return data;
+}
+
+// fetch a remote file from remote URL using the Fetch API, starting at byte offset (0 for the whole file)
+// cbChunk, if given, receives the data as it arrives and nothing is kept - otherwise the file is returned
+async function fetchRemote(url, cbProgress, cbPrint, offset = 0, cbChunk = null) {
     cbPrint('fetchRemote: downloading with fetch()...');
 
     const response = await fetch(
         url,
         {
             method: 'GET',
+            headers: offset > 0 ? { 'Range': 'bytes=' + offset + '-' } : {},
         }
     );
 
+    if (offset > 0 && response.status == 416) {
+        // nothing left after offset
+        return cbChunk ? offset : new Uint8Array(0);
+    }
+
     if (!response.ok) {
         cbPrint('fetchRemote: failed to fetch ' + url);
         return;
     }
 
+    if (offset > 0 && response.status != 206) {
+        cbPrint('fetchRemote: the server ignored the range request, downloading everything');
+        offset = 0;
+    }
+
     const contentLength = response.headers.get('content-length');
-    const total = parseInt(contentLength, 10);
+    const total = offset + parseInt(contentLength, 10);
     const reader = response.body.getReader();
 
     var chunks = [];
-    var receivedLength = 0;
+    var receivedLength = offset;
     var progressLast = -1;
 
     while (true) {
@@ -57,7 +125,11 @@ async function fetchRemote(url, cbProgress, cbPrint) {
             break;
         }
 
-        chunks.push(value);
+        if (cbChunk) {
+            await cbChunk(value, receivedLength);
+        } else {
+            chunks.push(value);
+        }
         receivedLength += value.length;
 
         if (contentLength) {
@@ -71,21 +143,76 @@ async function fetchRemote(url, cbProgress, cbPrint) {
         }
     }
 
-    var position = 0;
-    var chunksAll = new Uint8Array(receivedLength);
+    if (cbChunk) {
+        return receivedLength;
+    }
 
-    for (var chunk of chunks) {
-        chunksAll.set(chunk, position);
-        position += chunk.length;
+    return concatChunks(chunks, receivedLength);
+}
+
+// download url into the IndexedDB as the chunks url#0, url#1, ..., then the manifest url -> { size, n_chunks }
+// the chunks already stored by an interrupted download are kept
+async function downloadToDB(db, url, cbProgress, cbPrint) {
+    var n_chunks = 0;
+    var size = 0;
+
+    for (var chunk; (chunk = await getDB(db, url + '#' + n_chunks)) && chunk.length == chunkSizeDB; ) {
+        size += chunk.length;
+        n_chunks++;
+    }
+
+    if (n_chunks > 0) {
+        cbPrint('loadRemote: resuming the download after ' + n_chunks + ' cached chunks');
     }
 
-    return chunksAll;
+    var pending = [];
+    var pendingLength = 0;
+
+    async function flush() {
+        await putDB(db, url + '#' + n_chunks, concatChunks(pending, pendingLength));
+        size += pendingLength;
+        n_chunks++;
+        pending = [];
+        pendingLength = 0;
+    }
+
+    const received = await fetchRemote(url, cbProgress, cbPrint, n_chunks*chunkSizeDB, async function (value, offset) {
+        if (offset == 0 && n_chunks > 0) {
+            // the server sent the whole file again
+            n_chunks = 0;
+            size = 0;
+        }
+
+        var position = 0;
+        while (position < value.length) {
+            const n = Math.min(chunkSizeDB - pendingLength, value.length - position);
+            pending.push(value.subarray(position, position + n));
+            pendingLength += n;
+            position += n;
+
+            if (pendingLength == chunkSizeDB) {
+                await flush();
+            }
+        }
+    });
+
+    if (!received) {
+        return false;
+    }
+
+    if (pendingLength > 0) {
+        await flush();
+    }
+
+    await putDB(db, url, { size: size, n_chunks: n_chunks });
+
+    return true;
 }
 
 // load remote data
 // - check if the data is already in the IndexedDB
-// - if not, fetch it from the remote URL and store it in the IndexedDB
-function loadRemote(url, dst, size_mb, cbProgress, cbReady, cbCancel, cbPrint) {
+// - if not, fetch it from the remote URL and store it in the IndexedDB, chunk by chunk
+async function loadRemote(url, dst, size_mb, cbProgress, cbReady, cbCancel, cbPrint) {
     if (!navigator.storage || !navigator.storage.estimate) {
         cbPrint('loadRemote: navigator.storage.estimate() is not supported');
     } else {
@@ -96,96 +223,59 @@ function loadRemote(url, dst, size_mb, cbProgress, cbReady, cbCancel, cbPrint) {
         });
     }
 
-    // check if the data is already in the IndexedDB
-    var rq = indexedDB.open(dbName, dbVersion);
+    try {
+        const db = await openDB();
 
-    rq.onupgradeneeded = function (event) {
-        var db = event.target.result;
-        if (db.version == 1) {
-            var os = db.createObjectStore('models', { autoIncrement: false });
-            cbPrint('loadRemote: created IndexedDB ' + db.name + ' version ' + db.version);
-        } else {
-            // clear the database
-            var os = event.currentTarget.transaction.objectStore('models');
-            os.clear();
-            cbPrint('loadRemote: cleared IndexedDB ' + db.name + ' version ' + db.version);
+        var manifest = await getDB(db, url);
+
+        if (manifest instanceof Uint8Array) {
+            // stored whole by an earlier version of this page
+            cbPrint('loadRemote: "' + url + '" is already in the IndexedDB');
+            cbReady(dst, manifest);
+            return;
         }
-    };
 
-    rq.onsuccess = function (event) {
-        var db = event.target.result;
-        var tx = db.transaction(['models'], 'readonly');
-        var os = tx.objectStore('models');
-        var rq = os.get(url);
+        if (!manifest) {
+            // data is not in the IndexedDB
+            cbPrint('loadRemote: "' + url + '" is not in the IndexedDB');
 
-        rq.onsuccess = function (event) {
-            if (rq.result) {
-                cbPrint('loadRemote: "' + url + '" is already in the IndexedDB');
-                cbReady(dst, rq.result);
-            } else {
-                // data is not in the IndexedDB
-                cbPrint('loadRemote: "' + url + '" is not in the IndexedDB');
-
-                // alert and ask the user to confirm
-                if (!confirm(
-                    'You are about to download ' + size_mb + ' MB of data.\n' +
-                    'The model data will be cached in the browser for future use.\n\n' +
-                    'Press OK to continue.')) {
-                    cbCancel();
-                    return;
-                }
-
-                fetchRemote(url, cbProgress, cbPrint).then(function (data) {
-                    if (data) {
-                        // store the data in the IndexedDB
-                        var rq = indexedDB.open(dbName, dbVersion);
-                        rq.onsuccess = function (event) {
-                            var db = event.target.result;
-                            var tx = db.transaction(['models'], 'readwrite');
-                            var os = tx.objectStore('models');
-
-                            var rq = null;
-                            try {
-                                var rq = os.put(data, url);
-                            } catch (e) {
-                                cbPrint('loadRemote: failed to store "' + url + '" in the IndexedDB: \n' + e);
-                                cbCancel();
-                                return;
-                            }
-
-                            rq.onsuccess = function (event) {
-                                cbPrint('loadRemote: "' + url + '" stored in the IndexedDB');
-                                cbReady(dst, data);
-                            };
-
-                            rq.onerror = function (event) {
-                                cbPrint('loadRemote: failed to store "' + url + '" in the IndexedDB');
-                                cbCancel();
-                            };
-                        };
-                    }
-                });
+            // alert and ask the user to confirm
+            if (!confirm(
+                'You are about to download ' + size_mb + ' MB of data.\n' +
+                'The model data will be cached in the browser for future use.\n\n' +
+                'Press OK to continue.')) {
+                cbCancel();
+                return;
             }
-        };
 
-        rq.onerror = function (event) {
-            cbPrint('loadRemote: failed to get data from the IndexedDB');
-            cbCancel();
-        };
-    };
+            if (!await downloadToDB(db, url, cbProgress, cbPrint)) {
+                cbCancel();
+                return;
+            }
 
-    rq.onerror = function (event) {
-        cbPrint('loadRemote: failed to open IndexedDB');
-        cbCancel();
-    };
+            cbPrint('loadRemote: "' + url + '" stored in the IndexedDB');
 
-    rq.onblocked = function (event) {
-        cbPrint('loadRemote: failed to open IndexedDB: blocked');
-        cbCancel();
-    };
+            manifest = await getDB(db, url);
+        } else {
+            cbPrint('loadRemote: "' + url + '" is already in the IndexedDB');
+        }
+
+        // read the chunks in parallel
+        var reads = [];
+        for (var i = 0; i < manifest.n_chunks; i++) {
+            reads.push(getDB(db, url + '#' + i));
+        }
+
+        const chunks = await Promise.all(reads);
+        if (chunks.some(function (chunk) { return !chunk; })) {
+            cbPrint('loadRemote: chunks of "' + url + '" are missing from the IndexedDB, press "Clear Cache" and retry');
+            cbCancel();
+            return;
+        }
 
-    rq.onabort = function (event) {
-        cbPrint('loadRemote: failed to open IndexedDB: abort');
+        cbReady(dst, concatChunks(chunks, manifest.size));
+    } catch (e) {
+        cbPrint('loadRemote: ' + e);
         cbCancel();
-    };
+    }
 }
@@ -0,0 +1,241 @@
+// collect the importance matrix of a whisper model: the mean squared input activation of each column of the
+// weight matrices, over a set of calibration audio files - quantize uses it to weigh the quantization error
+#include "common.h"
+#include "common-ggml.h"
+#include "common-whisper.h"
+
+#include "whisper.h"
+#include "ggml-backend.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// command-line parameters
+struct imatrix_params {
+    int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
+
+    bool use_gpu = false;
+
+    std::string language = "en";
+    std::string model    = "models/ggml-base.en.bin";
+    std::string fname_out = "imatrix.dat";
+
+    std::vector<std::string> fname_inp = {};
+};
+
+static void imatrix_print_usage(int /*argc*/, char ** argv, const imatrix_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s [options] file0 file1 ...\n", argv[0]);
+    fprintf(stderr, "supported audio formats: flac, mp3, ogg, wav\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,        --help           [default] show this help message and exit\n");
+    fprintf(stderr, "  -t N,      --threads N      [%-7d] number of threads to use during computation\n", params.n_threads);
+    fprintf(stderr, "  -ug,       --use-gpu        [%-7s] use GPU\n",                                     params.use_gpu ? "true" : "false");
+    fprintf(stderr, "  -l LANG,   --language LANG  [%-7s] spoken language of the calibration audio\n",    params.language.c_str());
+    fprintf(stderr, "  -m FNAME,  --model FNAME    [%-7s] model path\n",                                  params.model.c_str());
+    fprintf(stderr, "  -o FNAME,  --output FNAME   [%-7s] output importance matrix path\n",               params.fname_out.c_str());
+    fprintf(stderr, "  -f FNAME,  --file FNAME     [%-7s] calibration audio file path\n",                 "");
+    fprintf(stderr, "\n");
+}
+
+static char * requires_value_error(const std::string & arg) {
+    fprintf(stderr, "error: argument %s requires value\n", arg.c_str());
+    exit(0);
+}
+
+static bool imatrix_params_parse(int argc, char ** argv, imatrix_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            imatrix_print_usage(argc, argv, params);
+            exit(0);
+        }
+        #define ARGV_NEXT (((i + 1) < argc) ? argv[++i] : requires_value_error(arg))
+        else if (arg[0] != '-')                            { params.fname_inp.push_back(arg); }
+        else if (arg == "-t"  || arg == "--threads")       { params.n_threads = std::stoi(ARGV_NEXT); }
+        else if (arg == "-ug" || arg == "--use-gpu")       { params.use_gpu   = true; }
+        else if (arg == "-l"  || arg == "--language")      { params.language  = ARGV_NEXT; }
+        else if (arg == "-m"  || arg == "--model")         { params.model     = ARGV_NEXT; }
+        else if (arg == "-o"  || arg == "--output")        { params.fname_out = ARGV_NEXT; }
+        else if (arg == "-f"  || arg == "--file")          { params.fname_inp.emplace_back(ARGV_NEXT); }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            imatrix_print_usage(argc, argv, params);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct imatrix_entry {
+    std::vector<double> sum; // of the squared activations, per column
+    int64_t n_rows = 0;
+    int     n_call = 0;
+};
+
+struct imatrix_collector {
+    std::map<std::string, imatrix_entry> entries;
+
+    std::vector<float> data; // activations copied from device memory
+};
+
+// the matrix multiplications of the model weights, src[0] is the weight and src[1] the activations
+static bool imatrix_is_weight_mul_mat(const ggml_tensor * t) {
+    if (t->op != GGML_OP_MUL_MAT) {
+        return false;
+    }
+
+    const ggml_tensor * w = t->src[0];
+    const ggml_tensor * x = t->src[1];
+
+    return w->view_src == nullptr && w->buffer && ggml_backend_buffer_get_usage(w->buffer) == GGML_BACKEND_BUFFER_USAGE_WEIGHTS &&
+           w->name[0] != '\0' && x->type == GGML_TYPE_F32 && x->nb[0] == sizeof(float);
+}
+
+static bool imatrix_collect(ggml_tensor * t, bool ask, void * user_data) {
+    if (ask) {
+        return imatrix_is_weight_mul_mat(t);
+    }
+
+    auto * collector = (imatrix_collector *) user_data;
+
+    const ggml_tensor * w = t->src[0];
+    const ggml_tensor * x = t->src[1];
+
+    const char * base = (const char *) x->data;
+    if (!ggml_backend_buffer_is_host(x->buffer)) {
+        collector->data.resize(ggml_nbytes(x)/sizeof(float));
+        ggml_backend_tensor_get(x, collector->data.data(), 0, ggml_nbytes(x));
+        base = (const char *) collector->data.data();
+    }
+
+    auto & e = collector->entries[w->name];
+    if (e.sum.empty()) {
+        e.sum.resize(x->ne[0], 0.0);
+    }
+
+    for (int64_t i3 = 0; i3 < x->ne[3]; ++i3) {
+        for (int64_t i2 = 0; i2 < x->ne[2]; ++i2) {
+            for (int64_t i1 = 0; i1 < x->ne[1]; ++i1) {
+                const float * row = (const float *) (base + i1*x->nb[1] + i2*x->nb[2] + i3*x->nb[3]);
+                for (int64_t i0 = 0; i0 < x->ne[0]; ++i0) {
+                    e.sum[i0] += (double) row[i0]*row[i0];
+                }
+            }
+        }
+    }
+
+    e.n_rows += ggml_nrows(x);
+    e.n_call++;
+
+    return true;
+}
+
+// format read by ggml_common_load_imatrix()
+static bool imatrix_save(const std::string & fname, const imatrix_collector & collector) {
+    std::ofstream fout(fname, std::ios::binary);
+    if (!fout) {
+        fprintf(stderr, "%s: failed to open '%s' for writing\n", __func__, fname.c_str());
+        return false;
+    }
+
+    const int32_t n_entries = collector.entries.size();
+    fout.write((const char *) &n_entries, sizeof(n_entries));
+
+    std::vector<float> values;
+
+    for (const auto & it : collector.entries) {
+        const auto & e = it.second;
+
+        const int32_t len    = it.first.size();
+        const int32_t n_call = e.n_call;
+        const int32_t n_val  = e.sum.size();
+
+        values.resize(n_val);
+        for (int32_t i = 0; i < n_val; ++i) {
+            values[i] = e.n_rows > 0 ? e.sum[i]/e.n_rows : 0.0f;
+        }
+
+        fout.write((const char *) &len, sizeof(len));
+        fout.write(it.first.data(), len);
+        fout.write((const char *) &n_call, sizeof(n_call));
+        fout.write((const char *) &n_val,  sizeof(n_val));
+        fout.write((const char *) values.data(), n_val*sizeof(float));
+    }
+
+    return fout.good();
+}
+
+int main(int argc, char ** argv) {
+    ggml_backend_load_all();
+
+    imatrix_params params;
+    if (!imatrix_params_parse(argc, argv, params)) {
+        return 1;
+    }
+
+    if (params.fname_inp.empty()) {
+        fprintf(stderr, "error: no calibration audio files specified\n");
+        imatrix_print_usage(argc, argv, params);
+        return 1;
+    }
+
+    imatrix_collector collector;
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu           = params.use_gpu;
+    cparams.cb_eval           = imatrix_collect;
+    cparams.cb_eval_user_data = &collector;
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: failed to initialize whisper context\n");
+        return 2;
+    }
+
+    for (const auto & fname : params.fname_inp) {
+        std::vector<float> pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_audio_data(fname, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "error: failed to read audio file '%s'\n", fname.c_str());
+            continue;
+        }
+
+        // transcribing runs the encoder on the audio and the decoder on the text it produces
+        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+        wparams.n_threads      = params.n_threads;
+        wparams.language       = params.language.c_str();
+        wparams.print_progress = false;
+
+        if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+            fprintf(stderr, "error: failed to process audio file '%s'\n", fname.c_str());
+            continue;
+        }
+
+        fprintf(stderr, "%s: processed '%s' (%.1f s), %zu weight matrices seen\n",
+                __func__, fname.c_str(), pcmf32.size()/(float) WHISPER_SAMPLE_RATE, collector.entries.size());
+    }
+
+    whisper_free(ctx);
+
+    if (collector.entries.empty()) {
+        fprintf(stderr, "error: no activations collected\n");
+        return 3;
+    }
+
+    if (!imatrix_save(params.fname_out, collector)) {
+        return 4;
+    }
+
+    fprintf(stderr, "%s: saved the importance matrix of %zu weight matrices to '%s'\n",
+            __func__, collector.entries.size(), params.fname_out.c_str());
+
+    return 0;
+}
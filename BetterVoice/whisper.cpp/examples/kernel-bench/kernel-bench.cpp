@@ -0,0 +1,565 @@
+// times the ggml kernels of the whisper graphs at the shapes of the whisper models, on every backend device
+//
+//   mul_mat        - the attention projections, MLP and logits of n_tokens = 1..5 (decoder) and 1500 (encoder)
+//   flash_attn_ext - the attention of n_tokens queries against the 1500 (padded to 1536) keys of an audio window
+//   soft_max       - the masked soft_max_ext of the same attention without flash attention
+//   conv_1d        - the two convolutions of the encoder stem, fused with the bias and the GELU (ggml_conv_1d_direct)
+//                    and as im2col + mul_mat + add + gelu (conv_1d_im2col)
+
+#include "ggml.h"
+#include "ggml-alloc.h"
+#include "ggml-backend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// command-line parameters
+struct kernel_bench_params {
+    int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
+
+    float t_min = 0.25f; // seconds to time each case for, at least 3 runs
+
+    std::vector<int> n_states = { 384, 512, 768, 1024, 1280 }; // tiny, base, small, medium, large
+    std::vector<int> n_tokens = { 1, 2, 3, 4, 5, 1500 };
+
+    std::vector<ggml_type> types = { GGML_TYPE_F16, GGML_TYPE_Q8_0, GGML_TYPE_Q5_K, GGML_TYPE_Q4_0 };
+
+    std::string device;     // only the devices whose name contains this
+    std::string ops = "mul_mat,flash_attn_ext,soft_max,conv_1d,conv_1d_im2col";
+    std::string fname_json; // also write the results to this file
+
+    bool repack = true;
+};
+
+static std::vector<std::string> split(const std::string & s, char sep) {
+    std::vector<std::string> res;
+    size_t pos = 0;
+    while (true) {
+        const size_t next = s.find(sep, pos);
+        res.push_back(s.substr(pos, next - pos));
+        if (next == std::string::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    return res;
+}
+
+static std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+static bool parse_type(const std::string & name, ggml_type & type) {
+    for (int i = 0; i < GGML_TYPE_COUNT; ++i) {
+        const char * tn = ggml_type_name((ggml_type) i);
+        if (tn && to_lower(tn) == to_lower(name)) {
+            type = (ggml_type) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void kernel_bench_print_usage(char ** argv, const kernel_bench_params & params);
+
+static bool kernel_bench_params_parse(int argc, char ** argv, kernel_bench_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            kernel_bench_print_usage(argv, params);
+            exit(0);
+        }
+        else if (arg == "-t"  || arg == "--threads")     { params.n_threads  = std::stoi(argv[++i]); }
+        else if (arg == "-d"  || arg == "--device")      { params.device     = argv[++i]; }
+        else if (arg == "-op" || arg == "--ops")         { params.ops        = argv[++i]; }
+        else if (arg == "-tm" || arg == "--time")        { params.t_min      = std::stof(argv[++i]); }
+        else if (arg == "-nr" || arg == "--no-repack")   { params.repack     = false; }
+        else if (arg == "-oj" || arg == "--output-json") { params.fname_json = argv[++i]; }
+        else if (arg == "-s"  || arg == "--n-state") {
+            params.n_states.clear();
+            for (const auto & s : split(argv[++i], ',')) {
+                params.n_states.push_back(std::stoi(s));
+            }
+        }
+        else if (arg == "-n"  || arg == "--n-tokens") {
+            params.n_tokens.clear();
+            for (const auto & s : split(argv[++i], ',')) {
+                params.n_tokens.push_back(std::stoi(s));
+            }
+        }
+        else if (arg == "-ty" || arg == "--types") {
+            params.types.clear();
+            for (const auto & s : split(argv[++i], ',')) {
+                ggml_type type;
+                if (!parse_type(s, type)) {
+                    fprintf(stderr, "error: unknown type: %s\n", s.c_str());
+                    return false;
+                }
+                params.types.push_back(type);
+            }
+        }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            kernel_bench_print_usage(argv, params);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void kernel_bench_print_usage(char ** argv, const kernel_bench_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,        --help           show this help message and exit\n");
+    fprintf(stderr, "  -t N,      --threads N      [%-7d] number of threads of the CPU backend\n", params.n_threads);
+    fprintf(stderr, "  -d NAME,   --device NAME    [%-7s] only the devices whose name contains NAME (CPU, Metal, BLAS, ...)\n", params.device.c_str());
+    fprintf(stderr, "  -op LIST,  --ops LIST       [%s] ops to time\n", params.ops.c_str());
+    fprintf(stderr, "  -s LIST,   --n-state LIST   [384,...] model widths\n");
+    fprintf(stderr, "  -n LIST,   --n-tokens LIST  [1,...  ] tokens per decoder call, 1500 for the encoder\n");
+    fprintf(stderr, "  -ty LIST,  --types LIST     [f16,...] weight and KV cache types\n");
+    fprintf(stderr, "  -tm S,     --time S         [%-7.2f] seconds to time each case for\n", params.t_min);
+    fprintf(stderr, "  -nr,       --no-repack      [%-7s] keep the CPU weights in their file layout\n", params.repack ? "false" : "true");
+    fprintf(stderr, "  -oj FNAME, --output-json FNAME also write the results to a JSON file\n");
+    fprintf(stderr, "\n");
+}
+
+struct kernel_bench_result {
+    std::string device;
+    std::string op;
+    std::string type;
+    std::string shape;
+
+    int     n_state;
+    int     n_tokens;
+    int     n_runs;
+    double  t_us;    // per run
+    double  gflops;
+    double  gbs;
+};
+
+// uniform [-1, 1) data of t's type
+static void fill_tensor(ggml_tensor * t, std::mt19937 & rng) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    const int64_t n_per_row = t->ne[0];
+    const int64_t n_rows    = ggml_nrows(t);
+
+    std::vector<float> data(n_per_row*n_rows);
+    for (auto & v : data) {
+        v = dist(rng);
+    }
+
+    if (t->type == GGML_TYPE_F32) {
+        ggml_backend_tensor_set(t, data.data(), 0, ggml_nbytes(t));
+        return;
+    }
+
+    std::vector<uint8_t> q(ggml_nbytes(t));
+    ggml_quantize_chunk(t->type, data.data(), q.data(), 0, n_rows, n_per_row, nullptr);
+    ggml_backend_tensor_set(t, q.data(), 0, q.size());
+}
+
+struct kernel_bench_device {
+    ggml_backend_dev_t dev;
+    ggml_backend_t     backend;
+
+    // CPU extra buffer types (repacked weights, AMX), tried for the weights first as whisper.cpp does
+    std::vector<ggml_backend_buffer_type_t> extra_bufts;
+};
+
+// allocates the tensors of ctx_w in the first extra buffer type that computes op with them, otherwise in the default
+// buffer type of the device
+static ggml_backend_buffer_t alloc_weights(const kernel_bench_device & kd, ggml_context * ctx_w, ggml_tensor * op) {
+    for (auto * buft : kd.extra_bufts) {
+        ggml_backend_buffer_t buf = ggml_backend_alloc_ctx_tensors_from_buft(ctx_w, buft);
+        if (buf && ggml_backend_dev_supports_op(kd.dev, op)) {
+            return buf;
+        }
+
+        ggml_backend_buffer_free(buf);
+        for (ggml_tensor * t = ggml_get_first_tensor(ctx_w); t; t = ggml_get_next_tensor(ctx_w, t)) {
+            t->buffer = nullptr;
+            t->data   = nullptr;
+            t->extra  = nullptr;
+        }
+    }
+
+    return ggml_backend_alloc_ctx_tensors(ctx_w, kd.backend);
+}
+
+// times out = f(weights, inputs); ctx_w holds the weights, ctx the inputs and out
+static bool time_graph(const kernel_bench_params & params, const kernel_bench_device & kd,
+        ggml_context * ctx_w, ggml_context * ctx, ggml_tensor * out, double flops, kernel_bench_result & res) {
+    ggml_backend_buffer_t buf_w = alloc_weights(kd, ctx_w, out);
+    ggml_backend_buffer_t buf   = ggml_backend_alloc_ctx_tensors(ctx, kd.backend);
+
+    bool ok = buf_w && buf && ggml_backend_supports_op(kd.backend, out);
+
+    if (ok) {
+        std::mt19937 rng(1234);
+
+        size_t n_bytes = ggml_nbytes(out);
+        for (ggml_context * c : { ctx_w, ctx }) {
+            for (ggml_tensor * t = ggml_get_first_tensor(c); t; t = ggml_get_next_tensor(c, t)) {
+                if (t != out) {
+                    if (strcmp(t->name, "mask") != 0) {
+                        fill_tensor(t, rng);
+                    }
+                    n_bytes += ggml_nbytes(t);
+                }
+            }
+        }
+
+        if (ggml_tensor * mask = ggml_get_tensor(ctx, "mask")) {
+            // the 1500 keys of the window, the padding to 1536 masked out
+            std::vector<ggml_fp16_t> m(ggml_nelements(mask));
+            for (int64_t i = 0; i < ggml_nelements(mask); ++i) {
+                m[i] = ggml_fp32_to_fp16(i % mask->ne[0] < 1500 ? 0.0f : -INFINITY);
+            }
+            ggml_backend_tensor_set(mask, m.data(), 0, ggml_nbytes(mask));
+        }
+
+        ggml_cgraph * gf = ggml_new_graph(ctx);
+        ggml_build_forward_expand(gf, out);
+
+        // warm-up, also compiles the GPU pipelines
+        ok = ggml_backend_graph_compute(kd.backend, gf) == GGML_STATUS_SUCCESS;
+
+        int n_runs = 0;
+
+        const int64_t t_start_us = ggml_time_us();
+        int64_t t_end_us = t_start_us;
+
+        while (ok && (n_runs < 3 || t_end_us - t_start_us < params.t_min*1e6) && n_runs < 10000) {
+            ok = ggml_backend_graph_compute(kd.backend, gf) == GGML_STATUS_SUCCESS;
+            ggml_backend_synchronize(kd.backend);
+
+            n_runs++;
+            t_end_us = ggml_time_us();
+        }
+
+        if (ok) {
+            res.n_runs = n_runs;
+            res.t_us   = (double) (t_end_us - t_start_us)/n_runs;
+            res.gflops = flops/res.t_us*1e-3;
+            res.gbs    = n_bytes/res.t_us*1e-3;
+        }
+    }
+
+    ggml_backend_buffer_free(buf);
+    ggml_backend_buffer_free(buf_w);
+
+    return ok;
+}
+
+static ggml_context * new_ctx() {
+    ggml_init_params ip = {
+        /*.mem_size   =*/ 8*ggml_tensor_overhead() + ggml_graph_overhead(),
+        /*.mem_buffer =*/ nullptr,
+        /*.no_alloc   =*/ true,
+    };
+    return ggml_init(ip);
+}
+
+// [M, K] weight of type times [K, N] F32 activations
+static bool bench_mul_mat(const kernel_bench_params & params, const kernel_bench_device & kd,
+        ggml_type type, int m, int k, int n, kernel_bench_result & res) {
+    res.shape = std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n);
+
+    // rows that are not a multiple of the block size (the K-quants need 256) are quantized to another type
+    if (k % ggml_blck_size(type) != 0) {
+        return false;
+    }
+
+    ggml_context * ctx_w = new_ctx();
+    ggml_context * ctx   = new_ctx();
+
+    ggml_tensor * a = ggml_new_tensor_2d(ctx_w, type, k, m);
+    ggml_tensor * b = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, k, n);
+
+    ggml_tensor * out = ggml_mul_mat(ctx, a, b);
+
+    const bool ok = time_graph(params, kd, ctx_w, ctx, out, 2.0*m*k*n, res);
+
+    ggml_free(ctx);
+    ggml_free(ctx_w);
+
+    return ok;
+}
+
+// n_tokens queries against the padded keys and values of an audio window, in the KV cache type, as in the
+// encoder (n_tokens = 1500) and the cross-attention of the decoder
+static bool bench_flash_attn(const kernel_bench_params & params, const kernel_bench_device & kd,
+        ggml_type type_kv, int n_state, int n_tokens, kernel_bench_result & res) {
+    const int d      = 64;
+    const int n_head = n_state/d;
+    const int n_kv   = GGML_PAD(1500, 256);
+
+    ggml_context * ctx_w = new_ctx();
+    ggml_context * ctx   = new_ctx();
+
+    ggml_tensor * k = ggml_new_tensor_3d(ctx_w, type_kv, d, n_kv, n_head);
+    ggml_tensor * v = ggml_new_tensor_3d(ctx_w, type_kv, d, n_kv, n_head);
+
+    ggml_tensor * q    = ggml_new_tensor_3d(ctx, GGML_TYPE_F32, d, n_tokens, n_head);
+    ggml_tensor * mask = ggml_new_tensor_2d(ctx, GGML_TYPE_F16, n_kv, GGML_PAD(n_tokens, GGML_KQ_MASK_PAD));
+    ggml_set_name(mask, "mask");
+
+    ggml_tensor * out = ggml_flash_attn_ext(ctx, q, k, v, mask, 1.0f/sqrtf(d), 0.0f, 0.0f);
+
+    res.shape = "d" + std::to_string(d) + " h" + std::to_string(n_head) + " q" + std::to_string(n_tokens) + " kv" + std::to_string(n_kv);
+
+    const bool ok = time_graph(params, kd, ctx_w, ctx, out, 4.0*d*n_tokens*n_kv*n_head, res);
+
+    ggml_free(ctx);
+    ggml_free(ctx_w);
+
+    return ok;
+}
+
+// the scaled and masked soft_max of the attention scores of n_tokens queries against the padded keys of an audio
+// window, as in the graphs without flash attention
+static bool bench_soft_max(const kernel_bench_params & params, const kernel_bench_device & kd,
+        int n_state, int n_tokens, kernel_bench_result & res) {
+    const int d      = 64;
+    const int n_head = n_state/d;
+    const int n_kv   = GGML_PAD(1500, 256);
+
+    ggml_context * ctx_w = new_ctx();
+    ggml_context * ctx   = new_ctx();
+
+    // the scores take the place of the weights, the graph has none
+    ggml_tensor * kq   = ggml_new_tensor_3d(ctx_w, GGML_TYPE_F32, n_kv, n_tokens, n_head);
+    ggml_tensor * mask = ggml_new_tensor_2d(ctx, GGML_TYPE_F16, n_kv, GGML_PAD(n_tokens, GGML_KQ_MASK_PAD));
+    ggml_set_name(mask, "mask");
+
+    ggml_tensor * out = ggml_soft_max_ext(ctx, kq, mask, 1.0f/sqrtf(d), 0.0f);
+
+    res.shape = "h" + std::to_string(n_head) + " q" + std::to_string(n_tokens) + " kv" + std::to_string(n_kv);
+
+    // exp, sum, scale and mask of each score
+    const bool ok = time_graph(params, kd, ctx_w, ctx, out, 5.0*n_kv*n_tokens*n_head, res);
+
+    ggml_free(ctx);
+    ggml_free(ctx_w);
+
+    return ok;
+}
+
+// one convolution of the encoder stem: kernel size 3, n_in channels of 3000 mel frames to n_state channels, with
+// stride 1 (conv1, n_in = n_mels) or 2 (conv2, n_in = n_state), followed by the bias and the GELU
+static bool bench_conv_1d(const kernel_bench_params & params, const kernel_bench_device & kd,
+        ggml_type type, int n_in, int n_state, int s0, bool direct, kernel_bench_result & res) {
+    const int k  = 3;
+    const int il = 3000;
+
+    ggml_context * ctx_w = new_ctx();
+    ggml_context * ctx   = new_ctx();
+
+    ggml_tensor * w = ggml_new_tensor_3d(ctx_w, type, k, n_in, n_state);
+    ggml_tensor * b = ggml_new_tensor_2d(ctx_w, GGML_TYPE_F32, 1, n_state);
+
+    ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, il, n_in);
+
+    ggml_tensor * out;
+    if (direct) {
+        out = ggml_conv_1d_direct(ctx, w, x, b, s0, 1, 1, true);
+    } else {
+        out = ggml_conv_1d_ph(ctx, w, x, s0, 1);
+        out = ggml_add(ctx, out, b);
+        out = ggml_gelu(ctx, out);
+    }
+
+    const int ol = (il + 2 - k)/s0 + 1;
+
+    res.shape = "k" + std::to_string(k) + " ic" + std::to_string(n_in) + " il" + std::to_string(il) + " s" + std::to_string(s0);
+
+    const bool ok = time_graph(params, kd, ctx_w, ctx, out, 2.0*k*n_in*n_state*ol, res);
+
+    ggml_free(ctx);
+    ggml_free(ctx_w);
+
+    return ok;
+}
+
+int main(int argc, char ** argv) {
+    ggml_backend_load_all();
+    ggml_time_init();
+
+    kernel_bench_params params;
+
+    if (!kernel_bench_params_parse(argc, argv, params)) {
+        return 1;
+    }
+
+    const std::vector<std::string> ops = split(params.ops, ',');
+    const auto has_op = [&](const char * op) { return std::find(ops.begin(), ops.end(), op) != ops.end(); };
+
+    std::vector<kernel_bench_device> devices;
+
+    for (size_t i = 0; i < ggml_backend_dev_count(); ++i) {
+        ggml_backend_dev_t dev = ggml_backend_dev_get(i);
+
+        if (!params.device.empty() && strstr(ggml_backend_dev_name(dev), params.device.c_str()) == nullptr) {
+            continue;
+        }
+
+        kernel_bench_device kd;
+        kd.dev     = dev;
+        kd.backend = ggml_backend_dev_init(dev, nullptr);
+        if (kd.backend == nullptr) {
+            fprintf(stderr, "warning: failed to initialize %s\n", ggml_backend_dev_name(dev));
+            continue;
+        }
+
+        ggml_backend_reg_t reg = ggml_backend_dev_backend_reg(dev);
+
+        auto * set_n_threads = (ggml_backend_set_n_threads_t) ggml_backend_reg_get_proc_address(reg, "ggml_backend_set_n_threads");
+        if (set_n_threads) {
+            set_n_threads(kd.backend, params.n_threads);
+        }
+
+        if (params.repack && ggml_backend_dev_type(dev) == GGML_BACKEND_DEVICE_TYPE_CPU) {
+            auto * get_extra_bufts = (ggml_backend_dev_get_extra_bufts_t) ggml_backend_reg_get_proc_address(reg, "ggml_backend_dev_get_extra_bufts");
+            if (get_extra_bufts) {
+                for (ggml_backend_buffer_type_t * p = get_extra_bufts(dev); p && *p; ++p) {
+                    kd.extra_bufts.push_back(*p);
+                }
+            }
+        }
+
+        devices.push_back(kd);
+    }
+
+    if (devices.empty()) {
+        fprintf(stderr, "error: no device matches '%s'\n", params.device.c_str());
+        return 1;
+    }
+
+    std::vector<kernel_bench_result> results;
+
+    printf("| %-10s | %-14s | %-6s | %7s | %-22s | %6s | %12s | %9s | %8s |\n",
+            "device", "op", "type", "n_state", "shape", "runs", "us/run", "GFLOPS", "GB/s");
+    printf("|%s|%s|%s|%s|%s|%s|%s|%s|%s|\n", "------------", "----------------", "--------", "---------",
+            "------------------------", "--------", "--------------", "-----------", "----------");
+
+    auto report = [&](const kernel_bench_device & kd, const char * op, ggml_type type, int n_state, int n_tokens, bool ok, kernel_bench_result & res) {
+        res.device   = ggml_backend_dev_name(kd.dev);
+        res.op       = op;
+        res.type     = ggml_type_name(type);
+        res.n_state  = n_state;
+        res.n_tokens = n_tokens;
+
+        if (!ok) {
+            printf("| %-10s | %-14s | %-6s | %7d | %-22s | %6s | %12s | %9s | %8s |\n",
+                    res.device.c_str(), op, res.type.c_str(), n_state, res.shape.c_str(), "-", "unsupported", "-", "-");
+        } else {
+            printf("| %-10s | %-14s | %-6s | %7d | %-22s | %6d | %12.2f | %9.2f | %8.2f |\n",
+                    res.device.c_str(), op, res.type.c_str(), n_state, res.shape.c_str(), res.n_runs, res.t_us, res.gflops, res.gbs);
+            results.push_back(res);
+        }
+        fflush(stdout);
+    };
+
+    for (const auto & kd : devices) {
+        for (int n_state : params.n_states) {
+            for (ggml_type type : params.types) {
+                if (has_op("mul_mat")) {
+                    // attention projections, MLP up and down
+                    const int shapes[3][2] = { { n_state, n_state }, { 4*n_state, n_state }, { n_state, 4*n_state } };
+
+                    for (int n : params.n_tokens) {
+                        for (const auto & s : shapes) {
+                            kernel_bench_result res;
+                            const bool ok = bench_mul_mat(params, kd, type, s[0], s[1], n, res);
+                            report(kd, "mul_mat", type, n_state, n, ok, res);
+                        }
+
+                        // the logits of the decoder
+                        if (n <= 5) {
+                            kernel_bench_result res;
+                            const bool ok = bench_mul_mat(params, kd, type, 51866, n_state, n, res);
+                            report(kd, "mul_mat", type, n_state, n, ok, res);
+                        }
+                    }
+                }
+
+                // the conv weights are F16 or F32 in the model files
+                if (type == GGML_TYPE_F16 || type == GGML_TYPE_F32) {
+                    for (const char * op : { "conv_1d", "conv_1d_im2col" }) {
+                        if (!has_op(op)) {
+                            continue;
+                        }
+
+                        const bool direct = strcmp(op, "conv_1d") == 0;
+
+                        // the im2col of ggml_conv_1d_ph() is in the type of the weights, F16 on the CPU
+                        if (!direct && type != GGML_TYPE_F16) {
+                            continue;
+                        }
+
+                        kernel_bench_result res;
+                        bool ok = bench_conv_1d(params, kd, type, 80, n_state, 1, direct, res);
+                        report(kd, op, type, n_state, 3000, ok, res);
+
+                        ok = bench_conv_1d(params, kd, type, n_state, n_state, 2, direct, res);
+                        report(kd, op, type, n_state, 1500, ok, res);
+                    }
+                }
+
+                // the KV cache types of whisper_context_params.type_kv
+                if (has_op("flash_attn_ext") && (type == GGML_TYPE_F16 || type == GGML_TYPE_Q8_0 || type == GGML_TYPE_Q4_0)) {
+                    for (int n : params.n_tokens) {
+                        kernel_bench_result res;
+                        const bool ok = bench_flash_attn(params, kd, type, n_state, n, res);
+                        report(kd, "flash_attn_ext", type, n_state, n, ok, res);
+                    }
+                }
+            }
+
+            if (has_op("soft_max")) {
+                for (int n : params.n_tokens) {
+                    kernel_bench_result res;
+                    const bool ok = bench_soft_max(params, kd, n_state, n, res);
+                    report(kd, "soft_max", GGML_TYPE_F32, n_state, n, ok, res);
+                }
+            }
+        }
+    }
+
+    if (!params.fname_json.empty()) {
+        FILE * f = fopen(params.fname_json.c_str(), "w");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", params.fname_json.c_str());
+            return 1;
+        }
+
+        fprintf(f, "[\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto & r = results[i];
+            fprintf(f, "  { \"device\": \"%s\", \"op\": \"%s\", \"type\": \"%s\", \"n_state\": %d, \"n_tokens\": %d, \"shape\": \"%s\", "
+                    "\"n_runs\": %d, \"us_per_run\": %.3f, \"gflops\": %.3f, \"gbs\": %.3f }%s\n",
+                    r.device.c_str(), r.op.c_str(), r.type.c_str(), r.n_state, r.n_tokens, r.shape.c_str(),
+                    r.n_runs, r.t_us, r.gflops, r.gbs, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "]\n");
+        fclose(f);
+    }
+
+    for (auto & kd : devices) {
+        ggml_backend_free(kd.backend);
+    }
+
+    return 0;
+}
@@ -1,15 +1,19 @@
 #include "ggml.h"
 #include "ggml-backend.h"
+#include "ggml-cpp.h"
+#include "gguf.h"
 
 #include "common.h"
 #include "common-ggml.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <regex>
@@ -29,6 +33,99 @@ struct whisper_hparams {
     int32_t ftype         = 1;
 };
 
+// built-in recipes, see README.md
+struct whisper_quantize_preset {
+    const char * name;
+    const char * desc;
+    std::vector<ggml_quantize_rule> rules;
+};
+
+static const std::vector<whisper_quantize_preset> WHISPER_QUANTIZE_PRESETS = {
+    {
+        "accuracy", "Q8_0 token embedding, first encoder layer and attention, Q5_K MLP",
+        {
+            { "decoder\\.token_embedding\\.weight", GGML_TYPE_Q8_0 },
+            { "encoder\\.blocks\\.0\\..*",           GGML_TYPE_Q8_0 },
+            { ".*\\.mlp\\.[02]\\.weight",            GGML_TYPE_Q5_K },
+            { ".*",                                  GGML_TYPE_Q8_0 },
+        },
+    },
+    {
+        "speed", "Q8_0 token embedding, Q5_K first encoder layer, Q4_K for the rest",
+        {
+            { "decoder\\.token_embedding\\.weight", GGML_TYPE_Q8_0 },
+            { "encoder\\.blocks\\.0\\..*",           GGML_TYPE_Q5_K },
+            { ".*",                                  GGML_TYPE_Q4_K },
+        },
+    },
+};
+
+// F32, F16, BF16 or one of the quantization types of ggml_parse_ftype(), case insensitive
+static bool whisper_parse_tensor_type(std::string str, ggml_type & type) {
+    for (auto & c : str) {
+        c = tolower(c);
+    }
+
+    if (str == "f32") { type = GGML_TYPE_F32; return true; }
+    if (str == "f16") { type = GGML_TYPE_F16; return true; }
+
+    for (int i = 0; i < GGML_TYPE_COUNT; ++i) {
+        std::string name = ggml_type_name((ggml_type) i);
+        for (auto & c : name) {
+            c = tolower(c);
+        }
+        if (name == str && ggml_ftype_from_type((ggml_type) i) != GGML_FTYPE_UNKNOWN) {
+            type = (ggml_type) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// recipe file: one "<regex> <type>" rule per line, the first rule matching the tensor name gives its type
+// empty lines and lines starting with # are ignored
+static bool whisper_load_recipe(const std::string & fname, std::vector<ggml_quantize_rule> & rules) {
+    std::ifstream fin(fname);
+    if (!fin) {
+        fprintf(stderr, "%s: failed to open '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+
+    std::string line;
+    for (int n_line = 1; std::getline(fin, line); ++n_line) {
+        std::istringstream iss(line);
+
+        std::string pattern;
+        std::string type_str;
+        if (!(iss >> pattern) || pattern[0] == '#') {
+            continue;
+        }
+
+        ggml_type type;
+        if (!(iss >> type_str) || !whisper_parse_tensor_type(type_str, type)) {
+            fprintf(stderr, "%s: %s:%d: expected '<regex> <type>', got '%s'\n", __func__, fname.c_str(), n_line, line.c_str());
+            return false;
+        }
+
+        try {
+            std::regex re(pattern);
+        } catch (const std::regex_error & e) {
+            fprintf(stderr, "%s: %s:%d: invalid regex '%s': %s\n", __func__, fname.c_str(), n_line, pattern.c_str(), e.what());
+            return false;
+        }
+
+        rules.push_back({ pattern, type });
+    }
+
+    if (rules.empty()) {
+        fprintf(stderr, "%s: no rules in '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 struct whisper_filters {
     int32_t n_mel;
     int32_t n_fft;
@@ -36,24 +133,404 @@ struct whisper_filters {
     std::vector<float> data;
 };
 
-// quantize a model
-static bool whisper_model_quantize(const std::string & fname_inp, const std::string & fname_out, ggml_ftype ftype) {
-    gpt_vocab vocab;
+// write the quantized model as GGUF: the hparams, mel filters and vocab as metadata, then the tensors
+// - the tensor records are in the ggml format, as written by ggml_common_quantize_0()
+static bool whisper_model_write_gguf(
+        const std::string & fname_out,
+        const whisper_hparams & hparams,
+        int32_t ftype,
+        const whisper_filters & filters,
+        const std::vector<std::string> & words,
+        const std::string & tensors) {
+    gguf_context_ptr gguf(gguf_init_empty());
+
+    gguf_set_val_str(gguf.get(), "general.architecture", "whisper");
+    gguf_set_val_u32(gguf.get(), "general.file_type", ftype);
+
+    gguf_set_val_u32(gguf.get(), "whisper.vocab_size",                  hparams.n_vocab);
+    gguf_set_val_u32(gguf.get(), "whisper.audio.context_length",        hparams.n_audio_ctx);
+    gguf_set_val_u32(gguf.get(), "whisper.audio.embedding_length",      hparams.n_audio_state);
+    gguf_set_val_u32(gguf.get(), "whisper.audio.attention.head_count",  hparams.n_audio_head);
+    gguf_set_val_u32(gguf.get(), "whisper.audio.block_count",           hparams.n_audio_layer);
+    gguf_set_val_u32(gguf.get(), "whisper.text.context_length",         hparams.n_text_ctx);
+    gguf_set_val_u32(gguf.get(), "whisper.text.embedding_length",       hparams.n_text_state);
+    gguf_set_val_u32(gguf.get(), "whisper.text.attention.head_count",   hparams.n_text_head);
+    gguf_set_val_u32(gguf.get(), "whisper.text.block_count",            hparams.n_text_layer);
+    gguf_set_val_u32(gguf.get(), "whisper.n_mels",                      hparams.n_mels);
+
+    gguf_set_val_u32(gguf.get(), "whisper.mel_filters.n_mel", filters.n_mel);
+    gguf_set_val_u32(gguf.get(), "whisper.mel_filters.n_fft", filters.n_fft);
+    gguf_set_arr_data(gguf.get(), "whisper.mel_filters", GGUF_TYPE_FLOAT32, filters.data.data(), filters.data.size());
 
-    printf("%s: loading model from '%s'\n", __func__, fname_inp.c_str());
+    {
+        std::vector<const char *> data;
+        for (const auto & word : words) {
+            data.push_back(word.c_str());
+        }
+        gguf_set_arr_str(gguf.get(), "tokenizer.ggml.tokens", data.data(), data.size());
+    }
 
-    auto finp = std::ifstream(fname_inp, std::ios::binary);
-    if (!finp) {
-        fprintf(stderr, "%s: failed to open '%s' for reading\n", __func__, fname_inp.c_str());
+    struct tensor_record {
+        std::string name;
+        ggml_type   type;
+        int32_t     n_dims;
+        int64_t     ne[4];
+        size_t      offs;  // of the data in tensors
+    };
+
+    std::vector<tensor_record> records;
+
+    for (size_t offs = 0; offs < tensors.size(); ) {
+        tensor_record rec = {};
+
+        int32_t length;
+        int32_t ttype;
+
+        memcpy(&rec.n_dims, tensors.data() + offs, sizeof(int32_t)); offs += sizeof(int32_t);
+        memcpy(&length,     tensors.data() + offs, sizeof(int32_t)); offs += sizeof(int32_t);
+        memcpy(&ttype,      tensors.data() + offs, sizeof(int32_t)); offs += sizeof(int32_t);
+
+        rec.type = (ggml_type) ttype;
+
+        for (int i = 0; i < 4; ++i) {
+            int32_t ne = 1;
+            if (i < rec.n_dims) {
+                memcpy(&ne, tensors.data() + offs, sizeof(int32_t)); offs += sizeof(int32_t);
+            }
+            rec.ne[i] = ne;
+        }
+
+        rec.name.assign(tensors.data() + offs, length);
+        offs += length;
+
+        rec.offs = offs;
+        offs += (rec.ne[0]*rec.ne[1]*rec.ne[2]*rec.ne[3])*ggml_type_size(rec.type)/ggml_blck_size(rec.type);
+
+        records.push_back(rec);
+    }
+
+    // the tensor infos, the data is written below
+    {
+        ggml_init_params params = {
+            /*.mem_size   =*/ records.size()*ggml_tensor_overhead(),
+            /*.mem_buffer =*/ nullptr,
+            /*.no_alloc   =*/ true,
+        };
+
+        ggml_context_ptr ctx(ggml_init(params));
+
+        for (const auto & rec : records) {
+            ggml_tensor * t = ggml_new_tensor(ctx.get(), rec.type, rec.n_dims, rec.ne);
+            ggml_set_name(t, rec.name.c_str());
+
+            gguf_add_tensor(gguf.get(), t);
+        }
+    }
+
+    if (!gguf_write_to_file(gguf.get(), fname_out.c_str(), true)) {
+        fprintf(stderr, "%s: failed to write '%s'\n", __func__, fname_out.c_str());
         return false;
     }
 
-    auto fout = std::ofstream(fname_out, std::ios::binary);
+    auto fout = std::ofstream(fname_out, std::ios::binary | std::ios::app);
     if (!fout) {
         fprintf(stderr, "%s: failed to open '%s' for writing\n", __func__, fname_out.c_str());
         return false;
     }
 
+    const size_t alignment = gguf_get_alignment(gguf.get());
+
+    const std::vector<char> zeros(alignment, 0);
+
+    for (int64_t i = 0; i < gguf_get_n_tensors(gguf.get()); ++i) {
+        const size_t size = gguf_get_tensor_size(gguf.get(), i);
+
+        fout.write(tensors.data() + records[i].offs, size);
+        fout.write(zeros.data(), GGML_PAD(size, alignment) - size);
+    }
+
+    return fout.good();
+}
+
+// structured pruning of the encoder: the attention heads and MLP channels that matter least for the calibration
+// audio of the importance matrix are removed, the loader takes the smaller sizes from the tensor shapes
+struct whisper_prune_params {
+    float heads = 0.0f; // fraction of the attention heads of each encoder layer to remove
+    float ffn   = 0.0f; // fraction of the MLP channels of each encoder layer to remove
+
+    bool enabled() const { return heads > 0.0f || ffn > 0.0f; }
+};
+
+struct whisper_tensor_record {
+    std::string name;
+    ggml_type   type;
+    int32_t     n_dims;
+    int32_t     ne[4];
+
+    std::vector<char> data;
+};
+
+static bool whisper_read_tensor_records(std::istream & finp, std::vector<whisper_tensor_record> & records) {
+    while (true) {
+        whisper_tensor_record rec = {};
+
+        int32_t length;
+        int32_t ttype;
+
+        finp.read(reinterpret_cast<char *>(&rec.n_dims), sizeof(rec.n_dims));
+        finp.read(reinterpret_cast<char *>(&length),     sizeof(length));
+        finp.read(reinterpret_cast<char *>(&ttype),      sizeof(ttype));
+
+        if (finp.eof()) {
+            return true;
+        }
+
+        if (rec.n_dims < 1 || rec.n_dims > 4 || length <= 0 || ttype < 0 || ttype >= GGML_TYPE_COUNT) {
+            fprintf(stderr, "%s: invalid tensor record\n", __func__);
+            return false;
+        }
+
+        rec.type = (ggml_type) ttype;
+
+        int64_t nelements = 1;
+        for (int i = 0; i < 4; ++i) {
+            rec.ne[i] = 1;
+            if (i < rec.n_dims) {
+                finp.read(reinterpret_cast<char *>(&rec.ne[i]), sizeof(rec.ne[i]));
+            }
+            nelements *= rec.ne[i];
+        }
+
+        rec.name.resize(length);
+        finp.read(&rec.name[0], length);
+
+        rec.data.resize(ggml_row_size(rec.type, nelements));
+        finp.read(rec.data.data(), rec.data.size());
+
+        if (!finp) {
+            fprintf(stderr, "%s: truncated tensor '%s'\n", __func__, rec.name.c_str());
+            return false;
+        }
+
+        records.push_back(std::move(rec));
+    }
+}
+
+static void whisper_write_tensor_records(std::ostream & fout, const std::vector<whisper_tensor_record> & records) {
+    for (const auto & rec : records) {
+        const int32_t length = rec.name.size();
+        const int32_t ttype  = rec.type;
+
+        fout.write(reinterpret_cast<const char *>(&rec.n_dims), sizeof(rec.n_dims));
+        fout.write(reinterpret_cast<const char *>(&length),     sizeof(length));
+        fout.write(reinterpret_cast<const char *>(&ttype),      sizeof(ttype));
+        fout.write(reinterpret_cast<const char *>(rec.ne),      rec.n_dims*sizeof(rec.ne[0]));
+        fout.write(rec.name.data(), length);
+        fout.write(rec.data.data(), rec.data.size());
+    }
+}
+
+// keep the given rows (ne[1]) of a matrix, or elements (ne[0]) of each row - the latter only for unquantized types
+static bool whisper_tensor_keep(whisper_tensor_record & rec, const std::vector<int> & keep, bool rows) {
+    if (!rows && ggml_is_quantized(rec.type)) {
+        fprintf(stderr, "%s: cannot prune the columns of quantized tensor '%s', prune the F32/F16 model\n", __func__, rec.name.c_str());
+        return false;
+    }
+
+    const size_t row_size = ggml_row_size(rec.type, rec.ne[0]);
+    const size_t el_size  = ggml_type_size(rec.type);
+    const int64_t n_rows  = (int64_t) rec.ne[1]*rec.ne[2]*rec.ne[3];
+
+    std::vector<char> data;
+
+    if (rows) {
+        data.resize(keep.size()*row_size);
+        for (size_t i = 0; i < keep.size(); ++i) {
+            memcpy(data.data() + i*row_size, rec.data.data() + keep[i]*row_size, row_size);
+        }
+        rec.ne[1] = keep.size();
+    } else {
+        data.resize(n_rows*keep.size()*el_size);
+        for (int64_t r = 0; r < n_rows; ++r) {
+            for (size_t i = 0; i < keep.size(); ++i) {
+                memcpy(data.data() + (r*keep.size() + i)*el_size, rec.data.data() + r*row_size + keep[i]*el_size, el_size);
+            }
+        }
+        rec.ne[0] = keep.size();
+    }
+
+    rec.data = std::move(data);
+
+    return true;
+}
+
+// importance of each column of a matrix: the mean squared activation it multiplies times the squared norm of its
+// weights, an estimate of its contribution to the output
+static std::vector<double> whisper_column_importance(const whisper_tensor_record & rec, const std::vector<float> & imat) {
+    std::vector<double> importance(rec.ne[0], 0.0);
+
+    const auto * traits = ggml_get_type_traits(rec.type);
+    const size_t row_size = ggml_row_size(rec.type, rec.ne[0]);
+
+    std::vector<float> row(rec.ne[0]);
+    for (int64_t r = 0; r < rec.ne[1]; ++r) {
+        if (rec.type == GGML_TYPE_F32) {
+            memcpy(row.data(), rec.data.data() + r*row_size, row_size);
+        } else {
+            traits->to_float(rec.data.data() + r*row_size, row.data(), rec.ne[0]);
+        }
+        for (int64_t c = 0; c < rec.ne[0]; ++c) {
+            importance[c] += (double) row[c]*row[c];
+        }
+    }
+
+    for (int64_t c = 0; c < rec.ne[0]; ++c) {
+        importance[c] *= imat[c];
+    }
+
+    return importance;
+}
+
+// the n_keep groups of group_size columns with the largest importance, as sorted column indices
+static std::vector<int> whisper_prune_select(const std::vector<double> & importance, int group_size, int n_keep) {
+    const int n_group = importance.size()/group_size;
+
+    std::vector<std::pair<double, int>> groups(n_group);
+    for (int g = 0; g < n_group; ++g) {
+        groups[g] = { 0.0, g };
+        for (int c = 0; c < group_size; ++c) {
+            groups[g].first += importance[g*group_size + c];
+        }
+    }
+
+    std::sort(groups.begin(), groups.end(), [](const auto & a, const auto & b) { return a.first > b.first; });
+    groups.resize(n_keep);
+    std::sort(groups.begin(), groups.end(), [](const auto & a, const auto & b) { return a.second < b.second; });
+
+    std::vector<int> keep;
+    for (const auto & g : groups) {
+        for (int c = 0; c < group_size; ++c) {
+            keep.push_back(g.second*group_size + c);
+        }
+    }
+
+    return keep;
+}
+
+// prune the encoder layers of the tensors, and the entries of the importance matrix for their columns
+static bool whisper_prune_encoder(
+        const whisper_hparams & hparams,
+        const whisper_prune_params & prune,
+        std::vector<whisper_tensor_record> & records,
+        std::map<std::string, std::vector<float>> & imatrix) {
+    std::map<std::string, whisper_tensor_record *> by_name;
+    for (auto & rec : records) {
+        by_name[rec.name] = &rec;
+    }
+
+    const int n_state_head = hparams.n_audio_state/hparams.n_audio_head;
+
+    // MLP channels are kept in multiples of the quantization block, so the MLP projection can still be quantized
+    const int ffn_block = 32;
+
+    for (int il = 0; il < hparams.n_audio_layer; ++il) {
+        const std::string prefix = "encoder.blocks." + std::to_string(il) + ".";
+
+        auto get = [&](const char * name) -> whisper_tensor_record * {
+            const auto it = by_name.find(prefix + name);
+            if (it == by_name.end()) {
+                fprintf(stderr, "%s: missing tensor '%s'\n", __func__, (prefix + name).c_str());
+                return nullptr;
+            }
+            return it->second;
+        };
+
+        // columns of the matrix scored with the importance matrix, and the tensors whose rows or elements go with them
+        auto prune_group = [&](const char * name_proj, const std::vector<const char *> & names_in, int group_size, int n_keep) -> bool {
+            whisper_tensor_record * proj = get(name_proj);
+            if (!proj) {
+                return false;
+            }
+
+            const auto it = imatrix.find(proj->name);
+            if (it == imatrix.end() || (int64_t) it->second.size() != proj->ne[0]) {
+                fprintf(stderr, "%s: the importance matrix has no entry for '%s'\n", __func__, proj->name.c_str());
+                return false;
+            }
+
+            if (n_keep*group_size >= proj->ne[0]) {
+                return true;
+            }
+
+            const std::vector<int> keep = whisper_prune_select(whisper_column_importance(*proj, it->second), group_size, n_keep);
+
+            for (const char * name : names_in) {
+                whisper_tensor_record * rec = get(name);
+                if (!rec || !whisper_tensor_keep(*rec, keep, rec->n_dims > 1)) {
+                    return false;
+                }
+            }
+
+            if (!whisper_tensor_keep(*proj, keep, false)) {
+                return false;
+            }
+
+            std::vector<float> imat(keep.size());
+            for (size_t i = 0; i < keep.size(); ++i) {
+                imat[i] = it->second[keep[i]];
+            }
+            it->second = std::move(imat);
+
+            return true;
+        };
+
+        const whisper_tensor_record * q_w   = get("attn.query.weight");
+        const whisper_tensor_record * mlp_0 = get("mlp.0.weight");
+        if (!q_w || !mlp_0) {
+            return false;
+        }
+
+        const int n_head = q_w->ne[1]/n_state_head;
+        const int n_ff   = mlp_0->ne[1];
+
+        const int n_head_keep = std::max(1, n_head - (int) (n_head*prune.heads));
+        const int n_ff_keep   = std::min(n_ff, std::max(ffn_block, GGML_PAD(n_ff - (int) (n_ff*prune.ffn), ffn_block)));
+
+        if (!prune_group("attn.out.weight", { "attn.query.weight", "attn.query.bias", "attn.key.weight", "attn.value.weight", "attn.value.bias" },
+                    n_state_head, n_head_keep)) {
+            return false;
+        }
+
+        if (!prune_group("mlp.2.weight", { "mlp.0.weight", "mlp.0.bias" }, 1, n_ff_keep)) {
+            return false;
+        }
+
+        printf("%s: encoder layer %2d: %d -> %d heads, %d -> %d MLP channels\n", __func__, il, n_head, n_head_keep, n_ff, n_ff_keep);
+    }
+
+    return true;
+}
+
+// quantize a model with the rules of a recipe, the tensors are copied if there are none
+// if fname_out ends with ".gguf" the result is written as GGUF
+// imatrix, if not empty, weighs the quantization error of each column of the matrices it has an entry for
+// the encoder is pruned first if prune is enabled, with the importance of imatrix
+static bool whisper_model_quantize(
+        const std::string & fname_inp,
+        const std::string & fname_out,
+        const std::vector<ggml_quantize_rule> & rules,
+        std::map<std::string, std::vector<float>> imatrix,
+        const whisper_prune_params & prune) {
+    const bool is_gguf = fname_out.size() > 5 && fname_out.compare(fname_out.size() - 5, 5, ".gguf") == 0;
+
+    printf("%s: loading model from '%s'\n", __func__, fname_inp.c_str());
+
+    auto finp = std::ifstream(fname_inp, std::ios::binary);
+    if (!finp) {
+        fprintf(stderr, "%s: failed to open '%s' for reading\n", __func__, fname_inp.c_str());
+        return false;
+    }
+
     // verify magic
     {
         uint32_t magic;
@@ -62,12 +539,12 @@ static bool whisper_model_quantize(const std::string & fname_inp, const std::str
             fprintf(stderr, "%s: invalid model file '%s' (bad magic)\n", __func__, fname_inp.c_str());
             return false;
         }
-
-        fout.write((char *) &magic, sizeof(magic));
     }
 
     whisper_hparams hparams;
 
+    int32_t ftype_dst = 0;
+
     // load hparams
     {
         finp.read((char *) &hparams.n_vocab,       sizeof(hparams.n_vocab));
@@ -83,7 +560,8 @@ static bool whisper_model_quantize(const std::string & fname_inp, const std::str
         finp.read((char *) &hparams.ftype,         sizeof(hparams.ftype));
 
         const int32_t qntvr_src =    hparams.ftype / GGML_QNT_VERSION_FACTOR;
-        const int32_t ftype_dst = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ftype;
+
+        ftype_dst = hparams.ftype;
 
         fprintf(stderr, "%s: n_vocab       = %d\n", __func__, hparams.n_vocab);
         fprintf(stderr, "%s: n_audio_ctx   = %d\n", __func__, hparams.n_audio_ctx);
@@ -97,41 +575,23 @@ static bool whisper_model_quantize(const std::string & fname_inp, const std::str
         fprintf(stderr, "%s: n_mels        = %d\n", __func__, hparams.n_mels);
         fprintf(stderr, "%s: ftype (src)   = %d\n", __func__, hparams.ftype);
         fprintf(stderr, "%s: qntvr (src)   = %d\n", __func__, qntvr_src);
-        fprintf(stderr, "%s: ftype (dst)   = %d\n", __func__, ftype_dst);
-        fprintf(stderr, "%s: qntvr (dst)   = %d\n", __func__, GGML_QNT_VERSION);
-
-        fout.write((const char *) &hparams.n_vocab,       sizeof(hparams.n_vocab));
-        fout.write((const char *) &hparams.n_audio_ctx,   sizeof(hparams.n_audio_ctx));
-        fout.write((const char *) &hparams.n_audio_state, sizeof(hparams.n_audio_state));
-        fout.write((const char *) &hparams.n_audio_head,  sizeof(hparams.n_audio_head));
-        fout.write((const char *) &hparams.n_audio_layer, sizeof(hparams.n_audio_layer));
-        fout.write((const char *) &hparams.n_text_ctx,    sizeof(hparams.n_text_ctx));
-        fout.write((const char *) &hparams.n_text_state,  sizeof(hparams.n_text_state));
-        fout.write((const char *) &hparams.n_text_head,   sizeof(hparams.n_text_head));
-        fout.write((const char *) &hparams.n_text_layer,  sizeof(hparams.n_text_layer));
-        fout.write((const char *) &hparams.n_mels,        sizeof(hparams.n_mels));
-        fout.write((const char *) &ftype_dst,             sizeof(hparams.ftype));
     }
 
     // load mel filters
+    whisper_filters filters;
     {
-        whisper_filters filters;
-
-        finp.read ((char *) &filters.n_mel, sizeof(filters.n_mel));
-        fout.write((char *) &filters.n_mel, sizeof(filters.n_mel));
-        finp.read ((char *) &filters.n_fft, sizeof(filters.n_fft));
-        fout.write((char *) &filters.n_fft, sizeof(filters.n_fft));
+        finp.read((char *) &filters.n_mel, sizeof(filters.n_mel));
+        finp.read((char *) &filters.n_fft, sizeof(filters.n_fft));
 
         filters.data.resize(filters.n_mel * filters.n_fft);
-        finp.read ((char *) filters.data.data(), filters.data.size() * sizeof(float));
-        fout.write((char *) filters.data.data(), filters.data.size() * sizeof(float));
+        finp.read((char *) filters.data.data(), filters.data.size() * sizeof(float));
     }
 
     // load vocab
+    std::vector<std::string> words;
     {
         int32_t n_vocab = 0;
-        finp.read ((char *) &n_vocab, sizeof(n_vocab));
-        fout.write((char *) &n_vocab, sizeof(n_vocab));
+        finp.read((char *) &n_vocab, sizeof(n_vocab));
 
         //if (n_vocab != hparams.n_vocab) {
         //    fprintf(stderr, "%s: invalid model file '%s' (bad vocab size %d != %d)\n",
@@ -139,20 +599,14 @@ static bool whisper_model_quantize(const std::string & fname_inp, const std::str
         //    return false;
         //}
 
-        char word[129];
-
         for (int i = 0; i < n_vocab; i++) {
             uint32_t len;
-            finp.read ((char *) &len, sizeof(len));
-            fout.write((char *) &len, sizeof(len));
-
-            word[len] = '\0';
+            finp.read((char *) &len, sizeof(len));
 
-            finp.read ((char *) word, len);
-            fout.write((char *) word, len);
+            std::string word(len, 0);
+            finp.read(&word[0], len);
 
-            vocab.token_to_id[word] = i;
-            vocab.id_to_token[i] = word;
+            words.push_back(std::move(word));
         }
     }
 
@@ -165,23 +619,115 @@ static bool whisper_model_quantize(const std::string & fname_inp, const std::str
         "decoder.positional_embedding",
     };
 
-    if (!ggml_common_quantize_0(finp, fout, ftype, { ".*" }, to_skip)) {
-        fprintf(stderr, "%s: failed to quantize model '%s'\n", __func__, fname_inp.c_str());
-        return false;
+    // the tensors of the input, pruned
+    std::stringstream pruned;
+    if (prune.enabled()) {
+        std::vector<whisper_tensor_record> records;
+        if (!whisper_read_tensor_records(finp, records) || !whisper_prune_encoder(hparams, prune, records, imatrix)) {
+            fprintf(stderr, "%s: failed to prune model '%s'\n", __func__, fname_inp.c_str());
+            return false;
+        }
+        whisper_write_tensor_records(pruned, records);
+    }
+
+    std::istream & tensors_inp = prune.enabled() ? (std::istream &) pruned : finp;
+
+    // the tensors, in the ggml format
+    std::stringstream tensors;
+
+    if (rules.empty()) {
+        tensors << tensors_inp.rdbuf();
+    } else {
+        ggml_type type_main = GGML_TYPE_F16;
+        if (!ggml_common_quantize_rules(tensors_inp, tensors, rules, to_skip, &type_main, imatrix.empty() ? nullptr : &imatrix)) {
+            fprintf(stderr, "%s: failed to quantize model '%s'\n", __func__, fname_inp.c_str());
+            return false;
+        }
+
+        // the type most weights ended up with (rows that do not fit the blocks of a type fall back to another),
+        // the loader takes the type of the others from the file
+        ftype_dst = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ggml_ftype_from_type(type_main);
     }
 
+    fprintf(stderr, "%s: ftype (dst)   = %d\n", __func__, ftype_dst);
+    fprintf(stderr, "%s: qntvr (dst)   = %d\n", __func__, ftype_dst / GGML_QNT_VERSION_FACTOR);
+
     finp.close();
-    fout.close();
 
-    return true;
+    if (is_gguf) {
+        return whisper_model_write_gguf(fname_out, hparams, ftype_dst, filters, words, tensors.str());
+    }
+
+    auto fout = std::ofstream(fname_out, std::ios::binary);
+    if (!fout) {
+        fprintf(stderr, "%s: failed to open '%s' for writing\n", __func__, fname_out.c_str());
+        return false;
+    }
+
+    const uint32_t magic = GGML_FILE_MAGIC;
+    fout.write((const char *) &magic, sizeof(magic));
+
+    fout.write((const char *) &hparams.n_vocab,       sizeof(hparams.n_vocab));
+    fout.write((const char *) &hparams.n_audio_ctx,   sizeof(hparams.n_audio_ctx));
+    fout.write((const char *) &hparams.n_audio_state, sizeof(hparams.n_audio_state));
+    fout.write((const char *) &hparams.n_audio_head,  sizeof(hparams.n_audio_head));
+    fout.write((const char *) &hparams.n_audio_layer, sizeof(hparams.n_audio_layer));
+    fout.write((const char *) &hparams.n_text_ctx,    sizeof(hparams.n_text_ctx));
+    fout.write((const char *) &hparams.n_text_state,  sizeof(hparams.n_text_state));
+    fout.write((const char *) &hparams.n_text_head,   sizeof(hparams.n_text_head));
+    fout.write((const char *) &hparams.n_text_layer,  sizeof(hparams.n_text_layer));
+    fout.write((const char *) &hparams.n_mels,        sizeof(hparams.n_mels));
+    fout.write((const char *) &ftype_dst,             sizeof(ftype_dst));
+
+    fout.write((const char *) &filters.n_mel, sizeof(filters.n_mel));
+    fout.write((const char *) &filters.n_fft, sizeof(filters.n_fft));
+    fout.write((const char *) filters.data.data(), filters.data.size() * sizeof(float));
+
+    const int32_t n_vocab = words.size();
+    fout.write((const char *) &n_vocab, sizeof(n_vocab));
+
+    for (const auto & word : words) {
+        const uint32_t len = word.size();
+        fout.write((const char *) &len, sizeof(len));
+        fout.write(word.data(), len);
+    }
+
+    fout << tensors.rdbuf();
+
+    return fout.good();
 }
 
 int main(int argc, char ** argv) {
     ggml_backend_load_all();
 
+    // optional importance matrix from whisper-imatrix, and pruning of the encoder with it
+    std::string fname_imatrix;
+    whisper_prune_params prune;
+    while (argc > 2) {
+        if (strcmp(argv[1], "--imatrix") == 0) {
+            fname_imatrix = argv[2];
+        } else if (strcmp(argv[1], "--prune-heads") == 0) {
+            prune.heads = std::stof(argv[2]);
+        } else if (strcmp(argv[1], "--prune-ffn") == 0) {
+            prune.ffn = std::stof(argv[2]);
+        } else {
+            break;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+
     if (argc != 4) {
-        fprintf(stderr, "usage: %s model-f32.bin model-quant.bin type\n", argv[0]);
+        fprintf(stderr, "usage: %s [--imatrix FNAME] [--prune-heads F] [--prune-ffn F] model-f32.bin model-quant.bin type\n", argv[0]);
+        fprintf(stderr, "  --prune-heads, --prune-ffn: remove the fraction F of the attention heads / MLP channels of each\n");
+        fprintf(stderr, "    encoder layer that matter least according to the importance matrix\n");
+        fprintf(stderr, "  the output is written as GGUF if its name ends with .gguf\n");
         ggml_print_ftypes(stderr);
+        fprintf(stderr, "  type = \"none\" to only convert the model, without quantizing it\n");
+        fprintf(stderr, "  type = a recipe file with one \"<regex> <type>\" rule per line, or a built-in recipe:\n");
+        for (const auto & preset : WHISPER_QUANTIZE_PRESETS) {
+            fprintf(stderr, "    %-10s %s\n", preset.name, preset.desc);
+        }
         return 1;
     }
 
@@ -195,7 +741,48 @@ int main(int argc, char ** argv) {
     const std::string fname_inp = argv[1];
     const std::string fname_out = argv[2];
 
-    const ggml_ftype ftype = ggml_parse_ftype(argv[3]);
+    std::vector<ggml_quantize_rule> rules;
+
+    for (const auto & preset : WHISPER_QUANTIZE_PRESETS) {
+        if (strcmp(argv[3], preset.name) == 0) {
+            rules = preset.rules;
+        }
+    }
+
+    if (rules.empty() && strcmp(argv[3], "none") != 0) {
+        std::ifstream recipe(argv[3]);
+        if (recipe) {
+            if (!whisper_load_recipe(argv[3], rules)) {
+                return 1;
+            }
+        } else {
+            const ggml_ftype ftype = ggml_parse_ftype(argv[3]);
+            const ggml_type  qtype = ftype == GGML_FTYPE_UNKNOWN ? GGML_TYPE_COUNT : ggml_ftype_to_ggml_type(ftype);
+            // BF16 is no quantization, but keeps the range of F32 weights that F16 would clip
+            if (qtype == GGML_TYPE_COUNT || (!ggml_is_quantized(qtype) && qtype != GGML_TYPE_BF16)) {
+                fprintf(stderr, "%s: invalid type '%s'\n", __func__, argv[3]);
+                return 1;
+            }
+            rules.push_back({ ".*", qtype });
+        }
+    }
+
+    std::map<std::string, std::vector<float>> imatrix;
+    if (!fname_imatrix.empty()) {
+        if (!ggml_common_load_imatrix(fname_imatrix, imatrix)) {
+            return 1;
+        }
+        printf("%s: loaded the importance matrix of %zu tensors from '%s'\n", __func__, imatrix.size(), fname_imatrix.c_str());
+    }
+
+    if (prune.enabled() && imatrix.empty()) {
+        fprintf(stderr, "%s: pruning needs the importance matrix of calibration audio (--imatrix)\n", __func__);
+        return 1;
+    }
+    if (prune.heads < 0.0f || prune.heads >= 1.0f || prune.ffn < 0.0f || prune.ffn >= 1.0f) {
+        fprintf(stderr, "%s: the pruned fractions must be in [0, 1)\n", __func__);
+        return 1;
+    }
 
     const int64_t t_main_start_us = ggml_time_us();
 
@@ -205,7 +792,7 @@ int main(int argc, char ** argv) {
     {
         const int64_t t_start_us = ggml_time_us();
 
-        if (!whisper_model_quantize(fname_inp, fname_out, ggml_ftype(ftype))) {
+        if (!whisper_model_quantize(fname_inp, fname_out, rules, imatrix, prune)) {
             fprintf(stderr, "%s: failed to quantize model from '%s'\n", __func__, fname_inp.c_str());
             return 1;
         }
@@ -9,15 +9,22 @@
 #include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 #include <csignal>
 #include <atomic>
 #include <functional>
+#include <list>
+#include <unordered_map>
 #include <cstdlib>
 #if defined (_WIN32)
 #include <windows.h>
@@ -64,8 +71,20 @@ struct server_params
     int32_t port          = 8080;
     int32_t read_timeout  = 600;
     int32_t write_timeout = 600;
+    int32_t n_parallel    = 1;
+    int32_t n_queue       = 16;
+
+    std::vector<int> gpu_devices;          // one context with n_parallel states per GPU, empty for the default GPU
+    int32_t          decoder_device = -1;  // GPU of the decoder of each context, -1 for the context GPU
+
+    bool numa = false; // a copy of the CPU weights per NUMA node, the states spread over the nodes
+    bool hugepages = false; // CPU weights and buffers in huge pages
 
     bool ffmpeg_converter = false;
+
+    int32_t cache_size = 0; // results of /inference kept for identical uploads, 0 to disable
+
+    int32_t coalesce_ms = 0; // how long a short clip waits for others to share its encoder call, 0 to disable
 };
 
 struct whisper_params {
@@ -92,9 +111,11 @@ struct whisper_params {
     bool translate       = false;
     bool detect_language = false;
     bool diarize         = false;
+    bool speaker_labels  = false; // [EXPERIMENTAL] with diarize, mono input is labeled by speaker clustering
     bool tinydiarize     = false;
     bool split_on_word   = false;
     bool no_fallback     = false;
+    bool pipeline_encode = false;
     bool print_special   = false;
     bool print_colors    = false;
     bool print_realtime  = false;
@@ -105,6 +126,12 @@ struct whisper_params {
     bool suppress_nst    = false;
     bool no_context      = false;
     bool no_language_probabilities = false;
+    bool stream          = false;
+
+    // scheduling of the request: higher priorities get an idle state first, and a request that is not predicted
+    // to be done within deadline_ms (0 for none) is rejected instead of queued
+    int32_t priority    = 0;
+    int32_t deadline_ms = 0;
 
     std::string language        = "en";
     std::string prompt          = "";
@@ -153,9 +180,11 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  -lpt N,    --logprob-thold N   [%-7.2f] log probability threshold for decoder fail\n",   params.logprob_thold);
     fprintf(stderr, "  -debug,    --debug-mode        [%-7s] enable debug mode (eg. dump log_mel)\n",           params.debug_mode ? "true" : "false");
     fprintf(stderr, "  -tr,       --translate         [%-7s] translate from source language to english\n",      params.translate ? "true" : "false");
-    fprintf(stderr, "  -di,       --diarize           [%-7s] stereo audio diarization\n",                       params.diarize ? "true" : "false");
+    fprintf(stderr, "  -di,       --diarize           [%-7s] stereo audio diarization\n",               params.diarize ? "true" : "false");
+    fprintf(stderr, "  -spl,      --speaker-labels    [%-7s] [EXPERIMENTAL] with --diarize, speaker clustering on mono audio\n", params.speaker_labels ? "true" : "false");
     fprintf(stderr, "  -tdrz,     --tinydiarize       [%-7s] enable tinydiarize (requires a tdrz model)\n",     params.tinydiarize ? "true" : "false");
     fprintf(stderr, "  -nf,       --no-fallback       [%-7s] do not use temperature fallback while decoding\n", params.no_fallback ? "true" : "false");
+    fprintf(stderr, "  -pe,       --pipeline-encode   [%-7s] encode the next window while decoding the current one\n", params.pipeline_encode ? "true" : "false");
     fprintf(stderr, "  -ps,       --print-special     [%-7s] print special tokens\n",                           params.print_special ? "true" : "false");
     fprintf(stderr, "  -pc,       --print-colors      [%-7s] print colors\n",                                   params.print_colors ? "true" : "false");
     fprintf(stderr, "  -pr,       --print-realtime    [%-7s] print output in realtime\n",                       params.print_realtime ? "true" : "false");
@@ -173,7 +202,15 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  --public PATH,                 [%-7s] Path to the public folder\n", sparams.public_path.c_str());
     fprintf(stderr, "  --request-path PATH,           [%-7s] Request path for all requests\n", sparams.request_path.c_str());
     fprintf(stderr, "  --inference-path PATH,         [%-7s] Inference path for all requests\n", sparams.inference_path.c_str());
-    fprintf(stderr, "  --convert,                     [%-7s] Convert audio to WAV, requires ffmpeg on the server\n", sparams.ffmpeg_converter ? "true" : "false");
+    fprintf(stderr, "  --convert,                     [%-7s] Convert formats that cannot be decoded in memory with the ffmpeg executable\n", sparams.ffmpeg_converter ? "true" : "false");
+    fprintf(stderr, "  --parallel N,                  [%-7d] Number of requests processed at the same time\n", sparams.n_parallel);
+    fprintf(stderr, "  --queue N,                     [%-7d] Max number of requests waiting for a free slot\n", sparams.n_queue);
+    fprintf(stderr, "  --coalesce-ms N,               [%-7d] Encode short clips arriving within N ms of each other in one batch, 0 to disable\n", sparams.coalesce_ms);
+    fprintf(stderr, "  --cache-size N,                [%-7d] Results kept for repeated uploads of the same audio and params, 0 to disable\n", sparams.cache_size);
+    fprintf(stderr, "  --gpu-devices N,N,...          [%-7s] GPUs to serve requests with, --parallel states each\n", "");
+    fprintf(stderr, "  --decoder-device N,            [%-7d] GPU running the decoder of every context, -1 to use the context GPU\n", sparams.decoder_device);
+    fprintf(stderr, "  --numa,                        [%-7s] Copy the CPU weights to each NUMA node and spread the --parallel states over the nodes\n", sparams.numa ? "true" : "false");
+    fprintf(stderr, "  --hugepages,                   [%-7s] Allocate the CPU weights, KV caches and compute buffers in huge pages (Linux)\n", sparams.hugepages ? "true" : "false");
     fprintf(stderr, "  -sns,      --suppress-nst      [%-7s] suppress non-speech tokens\n", params.suppress_nst ? "true" : "false");
     fprintf(stderr, "  -nth N,    --no-speech-thold N [%-7.2f] no speech threshold\n",   params.no_speech_thold);
     fprintf(stderr, "  -nc,       --no-context        [%-7s] do not use previous audio context\n", params.no_context ? "true" : "false");
@@ -220,9 +257,11 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
         else if (arg == "-debug"|| arg == "--debug-mode")      { params.debug_mode      = true; }
         else if (arg == "-tr"   || arg == "--translate")       { params.translate       = true; }
         else if (arg == "-di"   || arg == "--diarize")         { params.diarize         = true; }
+        else if (arg == "-spl"  || arg == "--speaker-labels")  { params.speaker_labels  = true; }
         else if (arg == "-tdrz" || arg == "--tinydiarize")     { params.tinydiarize     = true; }
         else if (arg == "-sow"  || arg == "--split-on-word")   { params.split_on_word   = true; }
         else if (arg == "-nf"   || arg == "--no-fallback")     { params.no_fallback     = true; }
+        else if (arg == "-pe"   || arg == "--pipeline-encode") { params.pipeline_encode = true; }
         else if (arg == "-fp"   || arg == "--font-path")       { params.font_path       = argv[++i]; }
         else if (arg == "-ps"   || arg == "--print-special")   { params.print_special   = true; }
         else if (arg == "-pc"   || arg == "--print-colors")    { params.print_colors    = true; }
@@ -250,6 +289,20 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
         else if (                  arg == "--request-path")    { sparams.request_path = argv[++i]; }
         else if (                  arg == "--inference-path")  { sparams.inference_path = argv[++i]; }
         else if (                  arg == "--convert")         { sparams.ffmpeg_converter     = true; }
+        else if (                  arg == "--parallel")        { sparams.n_parallel  = std::stoi(argv[++i]); }
+        else if (                  arg == "--queue")           { sparams.n_queue     = std::stoi(argv[++i]); }
+        else if (                  arg == "--cache-size")      { sparams.cache_size  = std::stoi(argv[++i]); }
+        else if (                  arg == "--coalesce-ms")     { sparams.coalesce_ms = std::stoi(argv[++i]); }
+        else if (                  arg == "--gpu-devices")     {
+            std::stringstream ss(argv[++i]);
+            std::string dev;
+            while (std::getline(ss, dev, ',')) {
+                sparams.gpu_devices.push_back(std::stoi(dev));
+            }
+        }
+        else if (                  arg == "--decoder-device")  { sparams.decoder_device = std::stoi(argv[++i]); }
+        else if (                  arg == "--numa")            { sparams.numa           = true; }
+        else if (                  arg == "--hugepages")       { sparams.hugepages      = true; }
 
         // Voice Activity Detection (VAD)
         else if (                  arg == "--vad")                         { params.vad                         = true; }
@@ -367,6 +420,23 @@ std::string estimate_diarization_speaker(std::vector<std::vector<float>> pcmf32s
     return speaker;
 }
 
+// channel energy on stereo input, else the speaker clustered by whisper_full if speaker_labels is on
+std::string segment_speaker(struct whisper_state * state, const std::vector<std::vector<float>> & pcmf32s, int i_segment, bool id_only = false) {
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i_segment);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i_segment);
+
+    if (pcmf32s.size() == 2) {
+        return estimate_diarization_speaker(pcmf32s, t0, t1, id_only);
+    }
+
+    const int id = whisper_full_get_segment_speaker_from_state(state, i_segment);
+    if (id < 0) {
+        return id_only ? "?" : "";
+    }
+
+    return id_only ? std::to_string(id) : "(speaker " + std::to_string(id) + ")";
+}
+
 void whisper_print_progress_callback(struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, int progress, void * user_data) {
     int progress_step = ((whisper_print_user_data *) user_data)->params->progress_step;
     int * progress_prev  = &(((whisper_print_user_data *) user_data)->progress_prev);
@@ -376,11 +446,11 @@ void whisper_print_progress_callback(struct whisper_context * /*ctx*/, struct wh
     }
 }
 
-void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * /*state*/, int n_new, void * user_data) {
+void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
     const auto & params  = *((whisper_print_user_data *) user_data)->params;
     const auto & pcmf32s = *((whisper_print_user_data *) user_data)->pcmf32s;
 
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
 
     std::string speaker = "";
 
@@ -396,42 +466,42 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
 
     for (int i = s0; i < n_segments; i++) {
         if (!params.no_timestamps || params.diarize) {
-            t0 = whisper_full_get_segment_t0(ctx, i);
-            t1 = whisper_full_get_segment_t1(ctx, i);
+            t0 = whisper_full_get_segment_t0_from_state(state, i);
+            t1 = whisper_full_get_segment_t1_from_state(state, i);
         }
 
         if (!params.no_timestamps) {
             printf("[%s --> %s]  ", to_timestamp(t0).c_str(), to_timestamp(t1).c_str());
         }
 
-        if (params.diarize && pcmf32s.size() == 2) {
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+        if (params.diarize) {
+            speaker = segment_speaker(state, pcmf32s, i);
         }
 
         if (params.print_colors) {
-            for (int j = 0; j < whisper_full_n_tokens(ctx, i); ++j) {
+            for (int j = 0; j < whisper_full_n_tokens_from_state(state, i); ++j) {
                 if (params.print_special == false) {
-                    const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+                    const whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
                     if (id >= whisper_token_eot(ctx)) {
                         continue;
                     }
                 }
 
-                const char * text = whisper_full_get_token_text(ctx, i, j);
-                const float  p    = whisper_full_get_token_p   (ctx, i, j);
+                const char * text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+                const float  p    = whisper_full_get_token_p_from_state(state, i, j);
 
                 const int col = std::max(0, std::min((int) k_colors.size() - 1, (int) (std::pow(p, 3)*float(k_colors.size()))));
 
                 printf("%s%s%s%s", speaker.c_str(), k_colors[col].c_str(), text, "\033[0m");
             }
         } else {
-            const char * text = whisper_full_get_segment_text(ctx, i);
+            const char * text = whisper_full_get_segment_text_from_state(state, i);
 
             printf("%s%s", speaker.c_str(), text);
         }
 
         if (params.tinydiarize) {
-            if (whisper_full_get_segment_speaker_turn_next(ctx, i)) {
+            if (whisper_full_get_segment_speaker_turn_next_from_state(state, i)) {
                 printf("%s", params.tdrz_speaker_turn.c_str());
             }
         }
@@ -444,18 +514,16 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
     }
 }
 
-std::string output_str(struct whisper_context * ctx, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
+std::string output_str(struct whisper_state * state, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
     std::stringstream result;
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
     for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
+        const char * text = whisper_full_get_segment_text_from_state(state, i);
         std::string speaker = "";
 
-        if (params.diarize && pcmf32s.size() == 2)
+        if (params.diarize)
         {
-            const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-            const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+            speaker = segment_speaker(state, pcmf32s, i);
         }
 
         result << speaker << text << "\n";
@@ -463,6 +531,785 @@ std::string output_str(struct whisper_context * ctx, const whisper_params & para
     return result.str();
 }
 
+// a fixed set of whisper states over one shared context, so that several requests can be
+// transcribed at the same time while the model weights are loaded only once
+struct whisper_state_pool {
+    std::mutex              mutex;
+    std::condition_variable cv;
+
+    std::vector<whisper_state *>   states;
+    std::vector<whisper_context *> states_ctx; // the context of each state
+    std::vector<whisper_state *>   idle;
+
+    int n_queue = 0; // max number of requests waiting for an idle state
+
+    // a request waiting for an idle state
+    struct ticket {
+        int    priority = 0;
+        double t_run_s  = 0.0; // expected processing time
+        std::chrono::steady_clock::time_point t_arrive;
+
+        whisper_state * state = nullptr; // handed over by release()
+    };
+
+    std::vector<ticket *> waiting;
+
+    // expected end of the request on each busy state
+    std::map<whisper_state *, std::chrono::steady_clock::time_point> busy_until;
+
+    // processing time per second of audio, a moving average over the finished requests, 0 until the first
+    double rtf = 0.0;
+
+    // n_states states for each context, interleaved so that consecutive requests go to different devices
+    bool init(const std::vector<whisper_context *> & ctxs, int n_states, int n_queue_max) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < n_states; ++i) {
+            for (auto * ctx : ctxs) {
+                whisper_state * state = whisper_init_state(ctx);
+                if (state == nullptr) {
+                    return false;
+                }
+                if (whisper_numa_node_from_state(state) >= 0) {
+                    fprintf(stderr, "%s: state %zu on NUMA node %d\n", __func__, states.size(), whisper_numa_node_from_state(state));
+                }
+                states.push_back(state);
+                states_ctx.push_back(ctx);
+            }
+        }
+        idle.assign(states.rbegin(), states.rend());
+        n_queue = n_queue_max;
+        return true;
+    }
+
+    whisper_context * ctx_of(const whisper_state * state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (states[i] == state) {
+                return states_ctx[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // must only be called when no request is holding a state
+    void free_all() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto * state : states) {
+            whisper_free_state(state);
+        }
+        states.clear();
+        states_ctx.clear();
+        idle.clear();
+    }
+
+    // higher priority first, then shortest expected job first. the time waited counts against the expected
+    // processing time, so that long uploads are not starved by a steady flow of short ones
+    static bool runs_before(const ticket & a, const ticket & b, std::chrono::steady_clock::time_point t_now) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        const double wa = std::chrono::duration<double>(t_now - a.t_arrive).count();
+        const double wb = std::chrono::duration<double>(t_now - b.t_arrive).count();
+        return a.t_run_s - wa < b.t_run_s - wb;
+    }
+
+    // a state for a request of audio_s seconds of audio, waiting for one by priority and expected processing time
+    // returns nullptr if all states are busy and the wait queue is full, or - with *late set - if the request would
+    // not be done within deadline_s (0 for none) as predicted from the work ahead of it and the measured speed
+    whisper_state * acquire(double audio_s = 0.0, int priority = 0, double deadline_s = 0.0, bool * late = nullptr) {
+        using clock = std::chrono::steady_clock;
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (late) {
+            *late = false;
+        }
+
+        const auto t_now = clock::now();
+
+        ticket t;
+        t.priority = priority;
+        t.t_run_s  = audio_s*rtf;
+        t.t_arrive = t_now;
+
+        if (waiting.empty() && !idle.empty()) {
+            whisper_state * state = idle.back();
+            idle.pop_back();
+            busy_until[state] = t_now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(t.t_run_s));
+            return state;
+        }
+
+        if ((int) waiting.size() >= n_queue) {
+            return nullptr;
+        }
+
+        if (deadline_s > 0.0 && rtf > 0.0) {
+            // the rest of the running requests and the waiting ones served first, spread over the states
+            double t_ahead_s = 0.0;
+            for (const auto & it : busy_until) {
+                t_ahead_s += std::max(0.0, std::chrono::duration<double>(it.second - t_now).count());
+            }
+            for (const ticket * w : waiting) {
+                if (runs_before(*w, t, t_now)) {
+                    t_ahead_s += w->t_run_s;
+                }
+            }
+
+            if (t_ahead_s/states.size() + t.t_run_s > deadline_s) {
+                if (late) {
+                    *late = true;
+                }
+                return nullptr;
+            }
+        }
+
+        waiting.push_back(&t);
+
+        const auto t_give_up = t_now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(deadline_s - t.t_run_s));
+
+        if (deadline_s > 0.0) {
+            cv.wait_until(lock, t_give_up, [&] { return t.state != nullptr; });
+        } else {
+            cv.wait(lock, [&] { return t.state != nullptr; });
+        }
+
+        if (t.state == nullptr) {
+            // it could no longer finish in time
+            waiting.erase(std::find(waiting.begin(), waiting.end(), &t));
+            if (late) {
+                *late = true;
+            }
+        }
+
+        return t.state;
+    }
+
+    void release(whisper_state * state) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            busy_until.erase(state);
+
+            if (waiting.empty()) {
+                idle.push_back(state);
+                return;
+            }
+
+            const auto t_now = std::chrono::steady_clock::now();
+
+            auto best = waiting.begin();
+            for (auto it = waiting.begin() + 1; it != waiting.end(); ++it) {
+                if (runs_before(**it, **best, t_now)) {
+                    best = it;
+                }
+            }
+
+            (*best)->state = state;
+            busy_until[state] = t_now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((*best)->t_run_s));
+            waiting.erase(best);
+        }
+        cv.notify_all();
+    }
+
+    // a finished request, for the expected processing time of the next ones
+    void on_done(double audio_s, double t_s) {
+        if (audio_s <= 0.0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        rtf = rtf == 0.0 ? t_s/audio_s : 0.8*rtf + 0.2*(t_s/audio_s);
+    }
+
+    json status() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return json{
+            {"n_parallel", states.size()},
+            {"n_busy",     states.size() - idle.size()},
+            {"n_queued",   waiting.size()},
+        };
+    }
+
+    // counters of every state since the model was loaded, in the Prometheus text format
+    std::string metrics() {
+        std::vector<whisper_metrics> m;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            m.resize(states.size());
+            for (size_t i = 0; i < states.size(); ++i) {
+                whisper_get_metrics_with_state(states[i], &m[i]);
+            }
+        }
+
+        std::string out;
+        char buf[256];
+
+        auto add = [&](const char * name, const char * type, const char * help, auto get) {
+            out += std::string("# HELP whisper_") + name + " " + help + "\n";
+            out += std::string("# TYPE whisper_") + name + " " + type + "\n";
+            for (size_t i = 0; i < m.size(); ++i) {
+                snprintf(buf, sizeof(buf), "whisper_%s{state=\"%zu\"} %.9g\n", name, i, (double) get(m[i]));
+                out += buf;
+            }
+        };
+
+        add("mel_seconds_total",    "counter", "Time computing log mel spectrograms",         [](const whisper_metrics & x) { return 1e-6*x.t_mel_us; });
+        add("vad_seconds_total",    "counter", "Time detecting speech",                       [](const whisper_metrics & x) { return 1e-6*x.t_vad_us; });
+        add("sample_seconds_total", "counter", "Time sampling tokens",                        [](const whisper_metrics & x) { return 1e-6*x.t_sample_us; });
+        add("encode_seconds_total", "counter", "Time encoding audio",                         [](const whisper_metrics & x) { return 1e-6*x.t_encode_us; });
+        add("decode_seconds_total", "counter", "Time decoding single tokens",                 [](const whisper_metrics & x) { return 1e-6*x.t_decode_us; });
+        add("batchd_seconds_total", "counter", "Time decoding batches of tokens",             [](const whisper_metrics & x) { return 1e-6*x.t_batchd_us; });
+        add("prompt_seconds_total", "counter", "Time decoding prompts",                       [](const whisper_metrics & x) { return 1e-6*x.t_prompt_us; });
+        add("samples_total",        "counter", "Tokens sampled",                              [](const whisper_metrics & x) { return x.n_sample; });
+        add("encodes_total",        "counter", "Encoder calls",                               [](const whisper_metrics & x) { return x.n_encode; });
+        add("decodes_total",        "counter", "Single-token decoder calls",                  [](const whisper_metrics & x) { return x.n_decode; });
+        add("batchds_total",        "counter", "Batched decoder calls",                       [](const whisper_metrics & x) { return x.n_batchd; });
+        add("prompts_total",        "counter", "Prompt decoder calls",                        [](const whisper_metrics & x) { return x.n_prompt; });
+        add("fallbacks_logprob_total", "counter", "Temperature fallbacks on the logprob threshold", [](const whisper_metrics & x) { return x.n_fail_p; });
+        add("fallbacks_entropy_total", "counter", "Temperature fallbacks on the entropy threshold", [](const whisper_metrics & x) { return x.n_fail_h; });
+        add("h2d_bytes_total",      "counter", "Graph inputs copied to device memory",        [](const whisper_metrics & x) { return x.n_bytes_h2d; });
+        add("d2h_bytes_total",      "counter", "Graph outputs copied from device memory",     [](const whisper_metrics & x) { return x.n_bytes_d2h; });
+        add("compute_buffer_bytes", "gauge",   "Compute buffers of the graphs",               [](const whisper_metrics & x) { return x.mem_compute; });
+        add("kv_self_bytes",        "gauge",   "Self-attention KV cache",                     [](const whisper_metrics & x) { return x.mem_kv_self; });
+        add("kv_cross_bytes",       "gauge",   "Cross-attention KV cache",                    [](const whisper_metrics & x) { return x.mem_kv_cross; });
+
+        if (!m.empty()) {
+            snprintf(buf, sizeof(buf), "# HELP whisper_rss_peak_bytes Peak resident set size of the process\n"
+                                       "# TYPE whisper_rss_peak_bytes gauge\n"
+                                       "whisper_rss_peak_bytes %zu\n", m[0].rss_peak);
+            out += buf;
+        }
+
+        return out;
+    }
+};
+
+// distribution of a value over fixed buckets, in the Prometheus text format
+struct server_histogram {
+    std::vector<double>   bounds; // upper bounds of the buckets, +Inf is implied
+    std::vector<uint64_t> counts;
+    double   sum   = 0.0;
+    uint64_t count = 0;
+
+    explicit server_histogram(std::vector<double> bounds) : bounds(std::move(bounds)), counts(this->bounds.size() + 1, 0) {}
+
+    void observe(double v) {
+        size_t i = 0;
+        while (i < bounds.size() && v > bounds[i]) {
+            ++i;
+        }
+        counts[i]++;
+        sum += v;
+        count++;
+    }
+
+    void write(std::string & out, const char * name, const char * help) const {
+        char buf[256];
+
+        out += std::string("# HELP whisper_server_") + name + " " + help + "\n";
+        out += std::string("# TYPE whisper_server_") + name + " histogram\n";
+
+        uint64_t n = 0;
+        for (size_t i = 0; i < bounds.size(); ++i) {
+            n += counts[i];
+            snprintf(buf, sizeof(buf), "whisper_server_%s_bucket{le=\"%g\"} %llu\n", name, bounds[i], (unsigned long long) n);
+            out += buf;
+        }
+        snprintf(buf, sizeof(buf), "whisper_server_%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long) count);
+        out += buf;
+        snprintf(buf, sizeof(buf), "whisper_server_%s_sum %.9g\n", name, sum);
+        out += buf;
+        snprintf(buf, sizeof(buf), "whisper_server_%s_count %llu\n", name, (unsigned long long) count);
+        out += buf;
+    }
+};
+
+// requests served since the start, exported by /metrics next to the counters of the states
+struct server_metrics {
+    std::mutex mutex;
+
+    // (endpoint, status): ok, cached, busy, late, aborted, error
+    std::map<std::pair<std::string, std::string>, uint64_t> n_requests;
+
+    server_histogram queue_wait { { 0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 } };
+    server_histogram audio      { { 1, 2, 5, 10, 15, 30, 60, 120, 300, 600, 1800 } };
+    server_histogram processing { { 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300 } };
+    server_histogram rtf        { { 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5, 0.75, 1, 2 } };
+    server_histogram encode     { { 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 } };
+    server_histogram decode     { { 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 } };
+
+    double t_load_s = 0.0; // of the current model
+
+    void on_request(const std::string & endpoint, const std::string & status) {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_requests[{ endpoint, status }]++;
+    }
+
+    void on_wait(double t_wait_s) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue_wait.observe(t_wait_s);
+    }
+
+    // a whisper_full() of n_samples, with the state's counters before and after
+    void on_full(size_t n_samples, double t_s, const whisper_metrics & m0, const whisper_metrics & m1) {
+        const double audio_s = (double) n_samples/WHISPER_SAMPLE_RATE;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        audio     .observe(audio_s);
+        processing.observe(t_s);
+        if (audio_s > 0.0) {
+            rtf.observe(t_s/audio_s);
+        }
+        encode.observe(1e-6*(m1.t_encode_us - m0.t_encode_us));
+        decode.observe(1e-6*((m1.t_decode_us + m1.t_batchd_us + m1.t_prompt_us) - (m0.t_decode_us + m0.t_batchd_us + m0.t_prompt_us)));
+    }
+
+    std::string text() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::string out;
+        char buf[256];
+
+        out += "# HELP whisper_server_requests_total Requests by endpoint and outcome\n";
+        out += "# TYPE whisper_server_requests_total counter\n";
+        for (const auto & it : n_requests) {
+            snprintf(buf, sizeof(buf), "whisper_server_requests_total{endpoint=\"%s\",status=\"%s\"} %llu\n",
+                    it.first.first.c_str(), it.first.second.c_str(), (unsigned long long) it.second);
+            out += buf;
+        }
+
+        queue_wait.write(out, "queue_wait_seconds", "Time waiting for an idle state");
+        audio     .write(out, "audio_seconds",      "Audio duration of a transcription");
+        processing.write(out, "processing_seconds", "Time of a transcription");
+        rtf       .write(out, "rtf",                "Processing time over audio duration of a transcription");
+        encode    .write(out, "encode_seconds",     "Encoder time of a transcription");
+        decode    .write(out, "decode_seconds",     "Decoder time of a transcription");
+
+        snprintf(buf, sizeof(buf), "# HELP whisper_server_model_load_seconds Time to load the current model\n"
+                                   "# TYPE whisper_server_model_load_seconds gauge\n"
+                                   "whisper_server_model_load_seconds %.6f\n", t_load_s);
+        out += buf;
+
+        return out;
+    }
+};
+
+// responses of /inference by the audio and the params that shape them, least recently used first out
+struct server_result_cache {
+    struct entry {
+        std::string key;
+        std::string body;
+        std::string content_type;
+    };
+
+    std::mutex mutex;
+
+    size_t n_max = 0;
+
+    std::list<entry> lru; // most recently used first
+    std::unordered_map<std::string, std::list<entry>::iterator> index;
+
+    size_t   n_bytes  = 0;
+    uint64_t n_hits   = 0;
+    uint64_t n_misses = 0;
+
+    bool get(const std::string & key, std::string & body, std::string & content_type) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = index.find(key);
+        if (it == index.end()) {
+            n_misses++;
+            return false;
+        }
+        n_hits++;
+
+        lru.splice(lru.begin(), lru, it->second);
+        body         = it->second->body;
+        content_type = it->second->content_type;
+
+        return true;
+    }
+
+    void put(const std::string & key, const std::string & body, const std::string & content_type) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (n_max == 0 || index.count(key)) {
+            return;
+        }
+
+        lru.push_front({ key, body, content_type });
+        index[key] = lru.begin();
+        n_bytes += key.size() + body.size();
+
+        while (lru.size() > n_max) {
+            n_bytes -= lru.back().key.size() + lru.back().body.size();
+            index.erase(lru.back().key);
+            lru.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lru.clear();
+        index.clear();
+        n_bytes = 0;
+    }
+
+    std::string text() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        char buf[1024];
+        snprintf(buf, sizeof(buf),
+                "# HELP whisper_server_cache_entries Results in the /inference cache\n"
+                "# TYPE whisper_server_cache_entries gauge\n"
+                "whisper_server_cache_entries %zu\n"
+                "# HELP whisper_server_cache_bytes Size of the keys and results in the /inference cache\n"
+                "# TYPE whisper_server_cache_bytes gauge\n"
+                "whisper_server_cache_bytes %zu\n"
+                "# HELP whisper_server_cache_hits_total Requests answered from the /inference cache\n"
+                "# TYPE whisper_server_cache_hits_total counter\n"
+                "whisper_server_cache_hits_total %llu\n"
+                "# HELP whisper_server_cache_misses_total Requests not found in the /inference cache\n"
+                "# TYPE whisper_server_cache_misses_total counter\n"
+                "whisper_server_cache_misses_total %llu\n",
+                lru.size(), n_bytes, (unsigned long long) n_hits, (unsigned long long) n_misses);
+
+        return buf;
+    }
+};
+
+// 64-bit hash of the samples, over four independent lanes so that it runs at memory speed
+static uint64_t pcm_hash(const std::vector<float> & pcm, uint64_t seed) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+
+    uint64_t h[4] = { seed, seed + k, seed + 2*k, seed + 3*k };
+
+    const char * data = (const char *) pcm.data();
+    const size_t n_bytes = pcm.size()*sizeof(float);
+
+    size_t i = 0;
+    for (; i + 32 <= n_bytes; i += 32) {
+        for (int j = 0; j < 4; ++j) {
+            uint64_t v;
+            memcpy(&v, data + i + 8*j, sizeof(v));
+            h[j] = (h[j] ^ v)*k;
+            h[j] ^= h[j] >> 29;
+        }
+    }
+    for (; i < n_bytes; i += sizeof(float)) {
+        uint32_t v;
+        memcpy(&v, data + i, sizeof(v));
+        h[0] = (h[0] ^ v)*k;
+        h[0] ^= h[0] >> 29;
+    }
+
+    uint64_t r = n_bytes;
+    for (int j = 0; j < 4; ++j) {
+        r = (r ^ h[j])*k;
+        r ^= r >> 32;
+    }
+
+    return r;
+}
+
+// the model, the audio and every request param that changes the response
+static std::string result_cache_key(const std::string & model_path, const whisper_params & params,
+        const std::vector<float> & pcmf32, const std::vector<std::vector<float>> & pcmf32s) {
+    uint64_t h = pcm_hash(pcmf32, 0);
+    if (params.diarize) {
+        for (const auto & pcm : pcmf32s) {
+            h = pcm_hash(pcm, h);
+        }
+    }
+
+    std::ostringstream ss;
+    ss << std::hex << h << std::dec << ':' << pcmf32.size()
+       << '|' << model_path
+       << '|' << params.language << '|' << params.translate << params.detect_language
+       << '|' << params.prompt
+       << '|' << params.temperature << ',' << params.temperature_inc
+       << '|' << params.response_format
+       << '|' << params.offset_t_ms << ',' << params.offset_n << ',' << params.duration_ms
+       << '|' << params.max_context << ',' << params.max_len << ',' << params.best_of << ',' << params.beam_size << ',' << params.audio_ctx
+       << '|' << params.word_thold << ',' << params.entropy_thold << ',' << params.logprob_thold << ',' << params.no_speech_thold
+       << '|' << params.diarize << params.speaker_labels << params.tinydiarize << params.split_on_word << params.no_timestamps << params.no_fallback
+              << params.suppress_nst << params.no_context << params.no_language_probabilities << params.debug_mode
+       << '|' << params.vad << ',' << params.vad_threshold << ',' << params.vad_min_speech_duration_ms << ',' << params.vad_min_silence_duration_ms
+              << ',' << params.vad_max_speech_duration_s << ',' << params.vad_speech_pad_ms << ',' << params.vad_samples_overlap;
+
+    return ss.str();
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t_start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+}
+
+// short clips that arrive together share one batched encoder call: each request computes the mel of its clip
+// in its own state and joins the open batch of its context, the first one waits up to window_ms for the others,
+// encodes the batch and the whisper_full() of every request then starts from the encoded window
+struct server_encode_batcher {
+    struct batch {
+        whisper_context * ctx;
+        int audio_ctx;
+
+        std::vector<whisper_state *> states;
+
+        bool done = false;
+    };
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+
+    int window_ms = 0;
+    int n_max     = 1;
+
+    std::shared_ptr<batch> open;
+
+    uint64_t n_batches = 0; // of two or more clips
+    uint64_t n_clips   = 0; // encoded in those batches
+
+    // returns once the first window of the mel in state has been encoded with the others of its batch, or is
+    // left to whisper_full() if the clip ends up alone
+    void encode(whisper_context * ctx, whisper_state * state, int audio_ctx, int n_threads) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (open && open->ctx == ctx && open->audio_ctx == audio_ctx && (int) open->states.size() < n_max) {
+            auto b = open;
+            b->states.push_back(state);
+            if ((int) b->states.size() >= n_max) {
+                cv.notify_all();
+            }
+            cv.wait(lock, [&] { return b->done; });
+            return;
+        }
+
+        auto b = std::make_shared<batch>();
+        b->ctx       = ctx;
+        b->audio_ctx = audio_ctx;
+        b->states.push_back(state);
+
+        // a batch of another context or audio context is left to its leader
+        const bool leader = !open;
+        if (leader) {
+            open = b;
+            cv.wait_for(lock, std::chrono::milliseconds(window_ms), [&] { return (int) b->states.size() >= n_max; });
+            open.reset();
+        }
+
+        const int n = b->states.size();
+        if (n > 1) {
+            lock.unlock();
+            const int ret = whisper_encode_batch(ctx, b->states.data(), n, audio_ctx, n_threads);
+            lock.lock();
+
+            if (ret == 0) {
+                n_batches++;
+                n_clips += n;
+            } else {
+                fprintf(stderr, "%s: batched encode of %d clips failed, they are encoded one by one\n", __func__, n);
+            }
+        }
+
+        b->done = true;
+        cv.notify_all();
+    }
+
+    std::string text() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+                "# HELP whisper_server_coalesced_batches_total Batched encoder calls of clips that arrived together\n"
+                "# TYPE whisper_server_coalesced_batches_total counter\n"
+                "whisper_server_coalesced_batches_total %llu\n"
+                "# HELP whisper_server_coalesced_clips_total Clips encoded in a batch with others\n"
+                "# TYPE whisper_server_coalesced_clips_total counter\n"
+                "whisper_server_coalesced_clips_total %llu\n",
+                (unsigned long long) n_batches, (unsigned long long) n_clips);
+
+        return buf;
+    }
+};
+
+// returns the state to the pool when the request is done
+struct whisper_state_guard {
+    whisper_state_pool & pool;
+    whisper_state      * state;
+
+    ~whisper_state_guard() {
+        if (state) {
+            pool.release(state);
+        }
+    }
+};
+
+// a loaded model, one context per GPU, and the states serving requests with it. requests hold a reference,
+// so when /load swaps in a new model the old one is freed only after its last request is done
+struct whisper_server_model {
+    std::vector<whisper_context *> ctxs;
+    whisper_state_pool             pool;
+    server_encode_batcher          batcher;
+
+    std::string path;
+
+    double t_load_s = 0.0;
+
+    ~whisper_server_model() {
+        pool.free_all();
+        for (auto * ctx : ctxs) {
+            whisper_free(ctx);
+        }
+    }
+};
+
+// audio and server-sent events shared by the handler, the transcription thread and the chunked
+// response of a streaming request
+struct whisper_stream_job {
+    std::mutex              mutex;
+    std::condition_variable cv;
+
+    whisper_params     params;
+    std::vector<float> pcmf32;
+    bool               upload_done = false;
+
+    std::deque<std::string> events;
+    bool                    finished = false;
+    std::atomic<bool>       aborted{false};
+
+    int     n_segments = 0; // segments sent so far, used as ids
+    int64_t t_offset   = 0; // start of the window being transcribed, in centiseconds
+
+    // the initial prompt and the text of the windows so far, the prompt of the next window. each window
+    // runs on whichever state of the pool is idle, so the context is carried here instead of in a state
+    std::vector<whisper_token> prompt;
+
+    // reads the upload from the first call of the response, so that events go out while it arrives
+    std::function<void(DataSink & sink)> upload;
+
+    std::thread worker;
+
+    void push_event(const std::string & name, const json & data, bool last = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back("event: " + name + "\ndata: " + data.dump(-1, ' ', false, json::error_handler_t::replace) + "\n\n");
+            finished = finished || last;
+        }
+        cv.notify_all();
+    }
+
+    // writes the queued events without waiting for more, false if the client is gone
+    bool send_events(std::unique_lock<std::mutex> & lock, DataSink & sink) {
+        while (!events.empty()) {
+            const std::string event = std::move(events.front());
+            events.pop_front();
+
+            lock.unlock();
+            if (!sink.write(event.data(), event.size())) {
+                lock.lock();
+                return false;
+            }
+            lock.lock();
+        }
+        return true;
+    }
+
+    void add_audio(const float * data, size_t n, bool done) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pcmf32.insert(pcmf32.end(), data, data + n);
+            upload_done = done;
+        }
+        cv.notify_all();
+    }
+};
+
+void whisper_stream_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
+    auto * job = (whisper_stream_job *) user_data;
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = n_segments - n_new; i < n_segments; ++i) {
+        if (!job->params.no_context) {
+            const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+            for (int j = 0; j < n_tokens; ++j) {
+                const whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
+                if (id < whisper_token_eot(ctx)) {
+                    job->prompt.push_back(id);
+                }
+            }
+        }
+
+        json segment = json{
+            {"id",   job->n_segments++},
+            {"text", whisper_full_get_segment_text_from_state(state, i)},
+        };
+
+        if (!job->params.no_timestamps) {
+            segment["start"] = (job->t_offset + whisper_full_get_segment_t0_from_state(state, i)) * 0.01;
+            segment["end"]   = (job->t_offset + whisper_full_get_segment_t1_from_state(state, i)) * 0.01;
+        }
+
+        job->push_event("segment", segment);
+    }
+}
+
+// the whisper_full() params for a request, without the callbacks
+whisper_full_params whisper_full_params_from(const whisper_params & params) {
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+
+    wparams.print_realtime   = false;
+    wparams.print_progress   = params.print_progress;
+    wparams.print_timestamps = !params.no_timestamps;
+    wparams.print_special    = params.print_special;
+    wparams.translate        = params.translate;
+    wparams.language         = params.language.c_str();
+    wparams.detect_language  = params.detect_language;
+    wparams.n_threads        = params.n_threads;
+    wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
+    wparams.offset_ms        = params.offset_t_ms;
+    wparams.duration_ms      = params.duration_ms;
+
+    wparams.thold_pt         = params.word_thold;
+    wparams.max_len          = params.max_len == 0 ? 60 : params.max_len;
+    wparams.split_on_word    = params.split_on_word;
+    wparams.audio_ctx        = params.audio_ctx;
+    wparams.pipeline_encode  = params.pipeline_encode;
+
+    wparams.debug_mode       = params.debug_mode;
+
+    wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
+    wparams.speaker_labels   = params.diarize && params.speaker_labels; // used for mono input, stereo uses the channel energy
+
+    wparams.initial_prompt   = params.prompt.c_str();
+
+    wparams.greedy.best_of        = params.best_of;
+    wparams.beam_search.beam_size = params.beam_size;
+
+    wparams.temperature      = params.temperature;
+    wparams.no_speech_thold = params.no_speech_thold;
+    wparams.temperature_inc  = params.temperature_inc;
+    wparams.entropy_thold    = params.entropy_thold;
+    wparams.logprob_thold    = params.logprob_thold;
+
+    wparams.no_timestamps    = params.no_timestamps;
+    wparams.token_timestamps = !params.no_timestamps && params.response_format == vjson_format;
+    wparams.no_context       = params.no_context;
+
+    wparams.suppress_nst     = params.suppress_nst;
+
+    wparams.vad              = params.vad;
+    wparams.vad_model_path   = params.vad_model.c_str();
+
+    wparams.vad_params.threshold               = params.vad_threshold;
+    wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
+    wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
+    wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
+    wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
+    wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
+
+    return wparams;
+}
+
 bool parse_str_to_bool(const std::string & s) {
     if (s == "true" || s == "1" || s == "yes" || s == "y") {
         return true;
@@ -528,6 +1375,10 @@ void get_req_parameters(const Request & req, whisper_params & params)
     {
         params.diarize = parse_str_to_bool(req.get_file_value("diarize").content);
     }
+    if (req.has_file("speaker_labels"))
+    {
+        params.speaker_labels = parse_str_to_bool(req.get_file_value("speaker_labels").content);
+    }
     if (req.has_file("tinydiarize"))
     {
         params.tinydiarize = parse_str_to_bool(req.get_file_value("tinydiarize").content);
@@ -604,10 +1455,30 @@ void get_req_parameters(const Request & req, whisper_params & params)
     {
         params.vad_samples_overlap = std::stof(req.get_file_value("vad_samples_overlap").content);
     }
+    if (req.has_file("stream"))
+    {
+        params.stream = parse_str_to_bool(req.get_file_value("stream").content);
+    }
     if (req.has_file("no_language_probabilities"))
     {
         params.no_language_probabilities = parse_str_to_bool(req.get_file_value("no_language_probabilities").content);
     }
+    if (req.has_header("X-Priority"))
+    {
+        params.priority = std::stoi(req.get_header_value("X-Priority"));
+    }
+    if (req.has_file("priority"))
+    {
+        params.priority = std::stoi(req.get_file_value("priority").content);
+    }
+    if (req.has_header("X-Deadline-Ms"))
+    {
+        params.deadline_ms = std::stoi(req.get_header_value("X-Deadline-Ms"));
+    }
+    if (req.has_file("deadline_ms"))
+    {
+        params.deadline_ms = std::stoi(req.get_file_value("deadline_ms").content);
+    }
 }
 
 }  // namespace
@@ -618,7 +1489,11 @@ int main(int argc, char ** argv) {
     whisper_params params;
     server_params sparams;
 
-    std::mutex whisper_mutex;
+    // the model serving new requests, replaced by /load
+    std::shared_ptr<whisper_server_model> model;
+    std::mutex model_mutex;
+    // serializes /load requests
+    std::mutex load_mutex;
 
     if (whisper_params_parse(argc, argv, params, sparams) == false) {
         whisper_print_usage(argc, argv, params, sparams);
@@ -640,11 +1515,22 @@ int main(int argc, char ** argv) {
     if (sparams.ffmpeg_converter) {
         check_ffmpeg_availibility();
     }
+
+    if (sparams.n_parallel < 1) {
+        sparams.n_parallel = 1;
+    }
+
+    if (params.n_processors > 1) {
+        fprintf(stderr, "warning: --processors is not used by the server, use --parallel to process requests concurrently\n");
+        params.n_processors = 1;
+    }
     // whisper init
     struct whisper_context_params cparams = whisper_context_default_params();
 
     cparams.use_gpu    = params.use_gpu;
     cparams.flash_attn = params.flash_attn;
+    cparams.numa_replicate = sparams.numa;
+    cparams.use_hugepages  = sparams.hugepages;
 
     if (!params.dtw.empty()) {
         cparams.dtw_token_timestamps = true;
@@ -696,15 +1582,62 @@ int main(int argc, char ** argv) {
     std::unique_ptr<httplib::Server> svr = std::make_unique<httplib::Server>();
     std::atomic<server_state> state{SERVER_STATE_LOADING_MODEL};
 
-    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    server_metrics metrics;
+
+    server_result_cache cache;
+    cache.n_max = std::max(0, sparams.cache_size);
+
+    auto load_model = [&](const std::string & path) -> std::shared_ptr<whisper_server_model> {
+        const auto t_start = std::chrono::steady_clock::now();
+
+        auto result = std::make_shared<whisper_server_model>();
+
+        std::vector<int> devices = sparams.gpu_devices;
+        if (devices.empty()) {
+            devices.push_back(cparams.gpu_device);
+        }
+
+        for (int dev : devices) {
+            whisper_context_params cparams_dev = cparams;
+            cparams_dev.gpu_device         = dev;
+            cparams_dev.decoder_gpu_device = sparams.decoder_device;
+            // the contexts read the weights that stay on the host from the same file pages
+            cparams_dev.use_mmap           = cparams.use_mmap || devices.size() > 1;
+
+            whisper_context * ctx = whisper_init_from_file_with_params(path.c_str(), cparams_dev);
+            if (ctx == nullptr) {
+                fprintf(stderr, "error: failed to initialize whisper context on GPU %d\n", dev);
+                return nullptr;
+            }
+            result->ctxs.push_back(ctx);
+
+            // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
+            whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+        }
+
+        if (!result->pool.init(result->ctxs, sparams.n_parallel, sparams.n_queue)) {
+            fprintf(stderr, "error: failed to initialize %d whisper states per context\n", sparams.n_parallel);
+            return nullptr;
+        }
+
+        result->batcher.window_ms = std::max(0, sparams.coalesce_ms);
+        result->batcher.n_max     = sparams.n_parallel;
 
-    if (ctx == nullptr) {
-        fprintf(stderr, "error: failed to initialize whisper context\n");
+        result->path     = path;
+        result->t_load_s = seconds_since(t_start);
+
+        return result;
+    };
+
+    auto get_model = [&]() {
+        std::lock_guard<std::mutex> lock(model_mutex);
+        return model;
+    };
+
+    model = load_model(params.model);
+    if (model == nullptr) {
         return 3;
     }
-
-    // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
-    whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
     state.store(SERVER_STATE_READY);
 
 
@@ -795,9 +1728,129 @@ int main(int argc, char ** argv) {
     svr->Options(sparams.request_path + sparams.inference_path, [&](const Request &, Response &){
     });
 
+    // transcribes the audio of a streaming request one WHISPER_CHUNK_SIZE window at a time as it
+    // arrives, the segments are queued as events by whisper_stream_segment_callback. a state of the
+    // pool is taken for each window only, not while waiting for the rest of the upload
+    auto run_stream_job = [&](whisper_stream_job * job) {
+        const auto model = get_model();
+
+        const size_t n_chunk = WHISPER_CHUNK_SIZE*WHISPER_SAMPLE_RATE;
+
+        size_t n_done = 0;
+        std::vector<float> chunk;
+
+        if (!job->params.prompt.empty()) {
+            job->prompt.resize(whisper_n_text_ctx(model->ctxs[0]));
+            const int n = whisper_tokenize(model->ctxs[0], job->params.prompt.c_str(), job->prompt.data(), job->prompt.size());
+            job->prompt.resize(std::max(n, 0));
+        }
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> job_lock(job->mutex);
+                job->cv.wait(job_lock, [&] {
+                    return job->aborted || job->upload_done || job->pcmf32.size() - n_done >= n_chunk;
+                });
+                if (job->aborted || n_done == job->pcmf32.size()) {
+                    break;
+                }
+                const size_t n = std::min(n_chunk, job->pcmf32.size() - n_done);
+                chunk.assign(job->pcmf32.begin() + n_done, job->pcmf32.begin() + n_done + n);
+            }
+
+            const auto t_wait = std::chrono::steady_clock::now();
+
+            whisper_state_guard guard = { model->pool, model->pool.acquire(double(chunk.size())/WHISPER_SAMPLE_RATE) };
+            if (guard.state == nullptr) {
+                metrics.on_request("stream", "busy");
+                job->push_event("error", json{{"error", "server is busy"}}, true);
+                return;
+            }
+            metrics.on_wait(seconds_since(t_wait));
+
+            struct whisper_context * ctx = model->pool.ctx_of(guard.state);
+
+            const size_t n_prompt_max = whisper_n_text_ctx(ctx)/2;
+            if (job->prompt.size() > n_prompt_max) {
+                job->prompt.erase(job->prompt.begin(), job->prompt.end() - n_prompt_max);
+            }
+
+            // the segment callback appends to job->prompt while whisper_full runs
+            const std::vector<whisper_token> prompt = job->prompt;
+
+            whisper_full_params wparams = whisper_full_params_from(job->params);
+
+            wparams.print_progress  = false;
+            wparams.offset_ms       = 0;
+            wparams.duration_ms     = 0;
+            // the past text of the pooled state belongs to another request
+            wparams.no_context      = true;
+            wparams.initial_prompt  = nullptr;
+            // later windows are prompted with the text of the previous ones
+            wparams.prompt_tokens   = prompt.empty() ? nullptr : prompt.data();
+            wparams.prompt_n_tokens = prompt.size();
+
+            wparams.new_segment_callback           = whisper_stream_segment_callback;
+            wparams.new_segment_callback_user_data = job;
+
+            wparams.abort_callback = [](void * user_data) {
+                return ((whisper_stream_job *) user_data)->aborted.load();
+            };
+            wparams.abort_callback_user_data = job;
+
+            job->t_offset = (int64_t) (n_done*100/WHISPER_SAMPLE_RATE);
+
+            if (whisper_full_with_state(ctx, guard.state, wparams, chunk.data(), chunk.size()) != 0) {
+                if (!job->aborted) {
+                    fprintf(stderr, "%s: failed to process audio\n", argv[0]);
+                    job->push_event("error", json{{"error", "failed to process audio"}}, true);
+                }
+                metrics.on_request("stream", job->aborted ? "aborted" : "error");
+                return;
+            }
+
+            n_done += chunk.size();
+        }
+
+        metrics.on_request("stream", job->aborted ? "aborted" : "ok");
+
+        job->push_event("done", json{{"n_segments", job->n_segments}}, true);
+    };
+
+    // answers with server-sent events, sent as soon as the transcription thread queues them
+    auto send_stream_job = [&](Response & res, std::shared_ptr<whisper_stream_job> job) {
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream",
+            [job](size_t /*offset*/, DataSink & sink) {
+                if (job->upload) {
+                    const auto upload = std::move(job->upload);
+                    job->upload = nullptr;
+                    upload(sink);
+                }
+
+                std::unique_lock<std::mutex> lock(job->mutex);
+                job->cv.wait(lock, [&] { return !job->events.empty() || job->finished; });
+                if (!job->send_events(lock, sink)) {
+                    return false;
+                }
+                if (job->finished) {
+                    sink.done();
+                }
+                return true;
+            },
+            [job](bool /*success*/) {
+                // the client is gone or got everything, stop the transcription either way
+                job->aborted = true;
+                job->cv.notify_all();
+                if (job->worker.joinable()) {
+                    job->worker.join();
+                }
+            });
+    };
+
     svr->Post(sparams.request_path + sparams.inference_path, [&](const Request &req, Response &res){
-        // acquire whisper model mutex lock
-        std::lock_guard<std::mutex> lock(whisper_mutex);
+        // requests may run concurrently, so each one works on its own copy of the params
+        whisper_params params = default_params;
 
         // first check user requested fields of the request
         if (!req.has_file("file"))
@@ -819,8 +1872,17 @@ int main(int argc, char ** argv) {
         std::vector<float> pcmf32;               // mono-channel F32 PCM
         std::vector<std::vector<float>> pcmf32s; // stereo-channel F32 PCM
 
-        if (sparams.ffmpeg_converter) {
-            // if file is not wav, convert to wav
+        // decode the upload straight from the request buffer. miniaudio handles WAV, MP3, FLAC and
+        // Ogg Vorbis (and builds with WHISPER_FFMPEG handle any format ffmpeg knows) without temp files
+        if (!::read_audio_data_from_memory(audio_file.content, pcmf32, pcmf32s, params.diarize)) {
+            if (!sparams.ffmpeg_converter) {
+                fprintf(stderr, "error: failed to read audio data\n");
+                const std::string error_resp = "{\"error\":\"failed to read audio data\"}";
+                res.set_content(error_resp, "application/json");
+                return;
+            }
+
+            // other formats still go through the ffmpeg executable
             // write to temporary file
             const std::string temp_filename = generate_temp_filename("whisper-server", ".wav");
             std::ofstream temp_file{temp_filename, std::ios::binary};
@@ -845,17 +1907,63 @@ int main(int argc, char ** argv) {
             }
             // remove temp file
             std::remove(temp_filename.c_str());
-        } else {
-            if (!::read_audio_data(audio_file.content, pcmf32, pcmf32s, params.diarize))
-            {
-                fprintf(stderr, "error: failed to read audio data\n");
-                const std::string error_resp = "{\"error\":\"failed to read audio data\"}";
-                res.set_content(error_resp, "application/json");
+        }
+
+        printf("Successfully loaded %s\n", filename.c_str());
+
+        if (params.stream) {
+            auto job = std::make_shared<whisper_stream_job>();
+            job->params = params;
+            job->add_audio(pcmf32.data(), pcmf32.size(), true);
+            job->worker = std::thread(run_stream_job, job.get());
+
+            send_stream_job(res, job);
+            return;
+        }
+
+        // keep using this model even if /load swaps in another one, and wait for an idle state
+        const auto model = get_model();
+
+        // a repeated upload is answered without taking a state
+        std::string cache_key;
+        if (cache.n_max > 0) {
+            cache_key = result_cache_key(model->path, params, pcmf32, pcmf32s);
+
+            std::string body;
+            std::string content_type;
+            if (cache.get(cache_key, body, content_type)) {
+                metrics.on_request("inference", "cached");
+                res.set_content(body, content_type);
                 return;
             }
         }
 
-        printf("Successfully loaded %s\n", filename.c_str());
+        const auto t_wait = std::chrono::steady_clock::now();
+
+        const double audio_s = double(pcmf32.size())/WHISPER_SAMPLE_RATE;
+
+        bool late = false;
+        whisper_state_guard guard = { model->pool, model->pool.acquire(audio_s, params.priority, 1e-3*params.deadline_ms, &late) };
+        whisper_state * wstate = guard.state;
+        if (wstate == nullptr && late) {
+            metrics.on_request("inference", "late");
+            fprintf(stderr, "error: the request cannot be done within its deadline of %d ms\n", params.deadline_ms);
+            res.status = 429;
+            res.set_header("Retry-After", "1");
+            res.set_content("{\"error\":\"the request cannot be done within its deadline\"}", "application/json");
+            return;
+        }
+        if (wstate == nullptr) {
+            metrics.on_request("inference", "busy");
+            fprintf(stderr, "error: all %zu states are busy and the queue is full\n", model->pool.states.size());
+            res.status = 503;
+            res.set_header("Retry-After", "1");
+            res.set_content("{\"error\":\"server is busy\"}", "application/json");
+            return;
+        }
+        metrics.on_wait(seconds_since(t_wait));
+
+        struct whisper_context * ctx = model->pool.ctx_of(wstate);
 
         // print system information
         {
@@ -891,57 +1999,7 @@ int main(int argc, char ** argv) {
         // run the inference
         {
             printf("Running whisper.cpp inference on %s\n", filename.c_str());
-            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-
-            wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
-
-            wparams.print_realtime   = false;
-            wparams.print_progress   = params.print_progress;
-            wparams.print_timestamps = !params.no_timestamps;
-            wparams.print_special    = params.print_special;
-            wparams.translate        = params.translate;
-            wparams.language         = params.language.c_str();
-            wparams.detect_language  = params.detect_language;
-            wparams.n_threads        = params.n_threads;
-            wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
-            wparams.offset_ms        = params.offset_t_ms;
-            wparams.duration_ms      = params.duration_ms;
-
-            wparams.thold_pt         = params.word_thold;
-            wparams.max_len          = params.max_len == 0 ? 60 : params.max_len;
-            wparams.split_on_word    = params.split_on_word;
-            wparams.audio_ctx        = params.audio_ctx;
-
-            wparams.debug_mode       = params.debug_mode;
-
-            wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
-
-            wparams.initial_prompt   = params.prompt.c_str();
-
-            wparams.greedy.best_of        = params.best_of;
-            wparams.beam_search.beam_size = params.beam_size;
-
-            wparams.temperature      = params.temperature;
-            wparams.no_speech_thold = params.no_speech_thold;
-            wparams.temperature_inc  = params.temperature_inc;
-            wparams.entropy_thold    = params.entropy_thold;
-            wparams.logprob_thold    = params.logprob_thold;
-
-            wparams.no_timestamps    = params.no_timestamps;
-            wparams.token_timestamps = !params.no_timestamps && params.response_format == vjson_format;
-            wparams.no_context       = params.no_context;
-
-            wparams.suppress_nst     = params.suppress_nst;
-
-            wparams.vad              = params.vad;
-            wparams.vad_model_path   = params.vad_model.c_str();
-
-            wparams.vad_params.threshold               = params.vad_threshold;
-            wparams.vad_params.min_speech_duration_ms  = params.vad_min_speech_duration_ms;
-            wparams.vad_params.min_silence_duration_ms = params.vad_min_silence_duration_ms;
-            wparams.vad_params.max_speech_duration_s   = params.vad_max_speech_duration_s;
-            wparams.vad_params.speech_pad_ms           = params.vad_speech_pad_ms;
-            wparams.vad_params.samples_overlap         = params.vad_samples_overlap;
+            whisper_full_params wparams = whisper_full_params_from(params);
 
             whisper_print_user_data user_data = { &params, &pcmf32s, 0 };
 
@@ -964,42 +2022,67 @@ int main(int argc, char ** argv) {
             };
             wparams.abort_callback_user_data = (void*)&req;
 
-            if (whisper_full_parallel(ctx, wparams, pcmf32.data(), pcmf32.size(), params.n_processors) != 0) {
+            whisper_metrics m0;
+            whisper_get_metrics_with_state(wstate, &m0);
+
+            const auto t_full = std::chrono::steady_clock::now();
+
+            // a clip of a single window, without the passes that need the samples, can share its encoder call
+            // with the clips of the other requests that arrive at the same time
+            const bool coalesce = model->batcher.window_ms > 0 && model->batcher.n_max > 1 &&
+                pcmf32.size() <= (size_t) 30*WHISPER_SAMPLE_RATE && !wparams.vad && !wparams.token_timestamps &&
+                wparams.offset_ms == 0 && whisper_pcm_to_mel_with_state(ctx, wstate, pcmf32.data(), pcmf32.size(), params.n_threads) == 0;
+
+            if (coalesce) {
+                model->batcher.encode(ctx, wstate, wparams.audio_ctx, params.n_threads);
+            }
+
+            if (whisper_full_with_state(ctx, wstate, wparams, coalesce ? nullptr : pcmf32.data(), coalesce ? 0 : pcmf32.size()) != 0) {
                 // handle failure or early abort
                 if (req.is_connection_closed()) {
+                    metrics.on_request("inference", "aborted");
                     // log client disconnect
                     fprintf(stderr, "client disconnected, aborted processing\n");
                     res.status = 499; // Client Closed Request (nginx convention)
                     res.set_content("{\"error\":\"client disconnected\"}", "application/json");
                     return;
                 }
+                metrics.on_request("inference", "error");
                 fprintf(stderr, "%s: failed to process audio\n", argv[0]);
                 res.status = 500; // Internal Server Error
                 const std::string error_resp = "{\"error\":\"failed to process audio\"}";
                 res.set_content(error_resp, "application/json");
                 return;
             }
+
+            whisper_metrics m1;
+            whisper_get_metrics_with_state(wstate, &m1);
+
+            metrics.on_request("inference", "ok");
+            metrics.on_full(pcmf32.size(), seconds_since(t_full), m0, m1);
+
+            model->pool.on_done(audio_s, seconds_since(t_full));
         }
 
         // return results to user
         if (params.response_format == text_format)
         {
-            std::string results = output_str(ctx, params, pcmf32s);
+            std::string results = output_str(wstate, params, pcmf32s);
             res.set_content(results.c_str(), "text/html; charset=utf-8");
         }
         else if (params.response_format == srt_format)
         {
             std::stringstream ss;
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(wstate);
             for (int i = 0; i < n_segments; ++i) {
-                const char * text = whisper_full_get_segment_text(ctx, i);
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+                const char * text = whisper_full_get_segment_text_from_state(wstate, i);
+                const int64_t t0 = whisper_full_get_segment_t0_from_state(wstate, i);
+                const int64_t t1 = whisper_full_get_segment_t1_from_state(wstate, i);
                 std::string speaker = "";
 
-                if (params.diarize && pcmf32s.size() == 2)
+                if (params.diarize)
                 {
-                    speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+                    speaker = segment_speaker(wstate, pcmf32s, i);
                 }
 
                 ss << i + 1 + params.offset_n << "\n";
@@ -1012,16 +2095,16 @@ int main(int argc, char ** argv) {
 
             ss << "WEBVTT\n\n";
 
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(wstate);
             for (int i = 0; i < n_segments; ++i) {
-                const char * text = whisper_full_get_segment_text(ctx, i);
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+                const char * text = whisper_full_get_segment_text_from_state(wstate, i);
+                const int64_t t0 = whisper_full_get_segment_t0_from_state(wstate, i);
+                const int64_t t1 = whisper_full_get_segment_t1_from_state(wstate, i);
                 std::string speaker = "";
 
-                if (params.diarize && pcmf32s.size() == 2)
+                if (params.diarize)
                 {
-                    speaker = estimate_diarization_speaker(pcmf32s, t0, t1, true);
+                    speaker = segment_speaker(wstate, pcmf32s, i, true);
                     speaker.insert(0, "<v Speaker");
                     speaker.append(">");
                 }
@@ -1032,10 +2115,10 @@ int main(int argc, char ** argv) {
             res.set_content(ss.str(), "text/vtt");
         } else if (params.response_format == vjson_format) {
             /* try to match openai/whisper's Python format */
-            std::string results = output_str(ctx, params, pcmf32s); 
+            std::string results = output_str(wstate, params, pcmf32s); 
             json jres = json{
                 {"task", params.translate ? "translate" : "transcribe"},
-                {"language", whisper_lang_str_full(whisper_full_lang_id(ctx))},
+                {"language", whisper_lang_str_full(whisper_full_lang_id_from_state(wstate))},
                 {"duration", float(pcmf32.size())/WHISPER_SAMPLE_RATE},
                 {"text", results},
                 {"segments", json::array()}
@@ -1043,7 +2126,7 @@ int main(int argc, char ** argv) {
             // Only compute language probabilities if requested (expensive operation)
             if (!params.no_language_probabilities) {
                 std::vector<float> lang_probs(whisper_lang_max_id() + 1, 0.0f);
-                const auto detected_lang_id = whisper_lang_auto_detect(ctx, 0, params.n_threads, lang_probs.data());
+                const auto detected_lang_id = whisper_lang_auto_detect_with_state(ctx, wstate, 0, params.n_threads, lang_probs.data());
                 jres["detected_language"] = whisper_lang_str_full(detected_lang_id);
                 jres["detected_language_probability"] = lang_probs[detected_lang_id];
                 jres["language_probabilities"] = json::object();
@@ -1054,29 +2137,29 @@ int main(int argc, char ** argv) {
                     }
                 }
             }
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(wstate);
             for (int i = 0; i < n_segments; ++i)
             {
                 json segment = json{
                     {"id", i},
-                    {"text", whisper_full_get_segment_text(ctx, i)},
+                    {"text", whisper_full_get_segment_text_from_state(wstate, i)},
                 };
 
                 if (!params.no_timestamps) {
-                    segment["start"] = whisper_full_get_segment_t0(ctx, i) * 0.01;
-                    segment["end"] = whisper_full_get_segment_t1(ctx, i) * 0.01;
+                    segment["start"] = whisper_full_get_segment_t0_from_state(wstate, i) * 0.01;
+                    segment["end"] = whisper_full_get_segment_t1_from_state(wstate, i) * 0.01;
                 }
 
                 float total_logprob = 0;
-                const int n_tokens = whisper_full_n_tokens(ctx, i);
+                const int n_tokens = whisper_full_n_tokens_from_state(wstate, i);
                 for (int j = 0; j < n_tokens; ++j) {
-                    whisper_token_data token = whisper_full_get_token_data(ctx, i, j);
+                    whisper_token_data token = whisper_full_get_token_data_from_state(wstate, i, j);
                     if (token.id >= whisper_token_eot(ctx)) {
                         continue;
                     }
 
                     segment["tokens"].push_back(token.id);
-                    json word = json{{"word", whisper_full_get_token_text(ctx, i, j)}};
+                    json word = json{{"word", whisper_full_get_token_text_from_state(ctx, wstate, i, j)}};
                     if (!params.no_timestamps) {
                         word["start"] = token.t0 * 0.01;
                         word["end"] = token.t1 * 0.01;
@@ -1092,7 +2175,7 @@ int main(int argc, char ** argv) {
 
                 // TODO compression_ratio and no_speech_prob are not implemented yet
                 // segment["compression_ratio"] = 0;
-                segment["no_speech_prob"] = whisper_full_get_segment_no_speech_prob(ctx, i);
+                segment["no_speech_prob"] = whisper_full_get_segment_no_speech_prob_from_state(wstate, i);
 
                 jres["segments"].push_back(segment);
             }
@@ -1102,7 +2185,7 @@ int main(int argc, char ** argv) {
         // TODO add more output formats
         else
         {
-            std::string results = output_str(ctx, params, pcmf32s);
+            std::string results = output_str(wstate, params, pcmf32s);
             json jres = json{
                 {"text", results}
             };
@@ -1110,12 +2193,66 @@ int main(int argc, char ** argv) {
                             "application/json");
         }
 
-        // reset params to their defaults
-        params = default_params;
+        if (!cache_key.empty()) {
+            cache.put(cache_key, res.body, res.get_header_value("Content-Type"));
+        }
+    });
+    // raw 16 kHz mono s16le PCM in the request body, which may be sent with chunked transfer
+    // encoding: windows are transcribed while the rest of the upload is still arriving
+    svr->Post(sparams.request_path + "/stream", [&](const Request &req, Response &res, const ContentReader &content_reader){
+        auto job = std::make_shared<whisper_stream_job>();
+        job->params = default_params;
+        if (req.has_param("language")) {
+            job->params.language = req.get_param_value("language");
+        }
+        if (req.has_param("translate")) {
+            job->params.translate = parse_str_to_bool(req.get_param_value("translate"));
+        }
+        if (req.has_param("prompt")) {
+            job->params.prompt = req.get_param_value("prompt");
+        }
+        if (req.has_param("no_timestamps")) {
+            job->params.no_timestamps = parse_str_to_bool(req.get_param_value("no_timestamps"));
+        }
+        if (req.has_param("no_context")) {
+            job->params.no_context = parse_str_to_bool(req.get_param_value("no_context"));
+        }
+
+        // the body is read by the response, once the event stream has started: the segments of a window
+        // are sent with the next piece of the upload received after it is transcribed
+        whisper_stream_job * job_ptr = job.get();
+        job->upload = [job_ptr, content_reader](DataSink & sink) {
+            std::string pending; // bytes of an incomplete sample
+            std::vector<float> samples;
+            content_reader([&](const char * data, size_t data_length) {
+                pending.append(data, data_length);
+
+                const size_t n = pending.size()/sizeof(int16_t);
+                samples.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    int16_t v;
+                    memcpy(&v, pending.data() + i*sizeof(int16_t), sizeof(int16_t));
+                    samples[i] = float(v)/32768.0f;
+                }
+                pending.erase(0, n*sizeof(int16_t));
+
+                job_ptr->add_audio(samples.data(), n, false);
+
+                std::unique_lock<std::mutex> lock(job_ptr->mutex);
+                if (!job_ptr->send_events(lock, sink)) {
+                    job_ptr->aborted = true;
+                }
+                return !job_ptr->aborted;
+            });
+            job_ptr->add_audio(nullptr, 0, true);
+        };
+
+        job->worker = std::thread(run_stream_job, job_ptr);
+
+        send_stream_job(res, job);
     });
+
     svr->Post(sparams.request_path + "/load", [&](const Request &req, Response &res){
-        std::lock_guard<std::mutex> lock(whisper_mutex);
-        state.store(SERVER_STATE_LOADING_MODEL);
         if (!req.has_file("model"))
         {
             fprintf(stderr, "error: no 'model' field in the request\n");
@@ -1123,48 +2260,95 @@ int main(int argc, char ** argv) {
             res.set_content(error_resp, "application/json");
             return;
         }
-        std::string model = req.get_file_value("model").content;
-        if (!is_file_exist(model.c_str()))
+        std::string model_path = req.get_file_value("model").content;
+        if (!is_file_exist(model_path.c_str()))
         {
-            fprintf(stderr, "error: 'model': %s not found!\n", model.c_str());
+            fprintf(stderr, "error: 'model': %s not found!\n", model_path.c_str());
             const std::string error_resp = "{\"error\":\"model not found!\"}";
             res.set_content(error_resp, "application/json");
             return;
         }
 
-        // clean up
-        whisper_free(ctx);
+        std::lock_guard<std::mutex> lock(load_mutex);
 
-        // whisper init
-        ctx = whisper_init_from_file_with_params(model.c_str(), cparams);
+        // the current model keeps serving requests while the new one loads
+        auto new_model = load_model(model_path);
+        if (new_model == nullptr) {
+            fprintf(stderr, "error: model init failed, keeping the current model\n");
+            res.status = 500;
+            res.set_content("{\"error\":\"failed to load model\"}", "application/json");
+            return;
+        }
 
-        // TODO perhaps load prior model here instead of exit
-        if (ctx == nullptr) {
-            fprintf(stderr, "error: model init  failed, no model loaded must exit\n");
-            exit(1);
+        // new requests use the new model, the old one is freed when its last request is done
+        {
+            std::lock_guard<std::mutex> model_lock(model_mutex);
+            std::swap(model, new_model);
         }
+        new_model.reset();
 
-        // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
-        whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+        // the file may have changed since its results were cached
+        cache.clear();
 
-        state.store(SERVER_STATE_READY);
         const std::string success = "Load was successful!";
         res.set_content(success, "application/text");
-
-        // check if the model is in the file system
     });
 
     svr->Get(sparams.request_path + "/health", [&](const Request &, Response &res){
         server_state current_state = state.load();
         if (current_state == SERVER_STATE_READY) {
-            const std::string health_response = "{\"status\":\"ok\"}";
-            res.set_content(health_response, "application/json");
+            json health_response = get_model()->pool.status();
+            health_response["status"] = "ok";
+            res.set_content(health_response.dump(), "application/json");
         } else {
             res.set_content("{\"status\":\"loading model\"}", "application/json");
             res.status = 503;
         }
     });
 
+    svr->Get(sparams.request_path + "/metrics", [&](const Request &, Response &res){
+        if (state.load() != SERVER_STATE_READY) {
+            res.set_content("loading model\n", "text/plain");
+            res.status = 503;
+            return;
+        }
+        const auto model = get_model();
+        const json status = model->pool.status();
+
+        {
+            std::lock_guard<std::mutex> lock(metrics.mutex);
+            metrics.t_load_s = model->t_load_s;
+        }
+
+        std::string out = metrics.text();
+
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+                "# HELP whisper_server_states Decoding states of the model\n"
+                "# TYPE whisper_server_states gauge\n"
+                "whisper_server_states %d\n"
+                "# HELP whisper_server_states_busy States serving a request\n"
+                "# TYPE whisper_server_states_busy gauge\n"
+                "whisper_server_states_busy %d\n"
+                "# HELP whisper_server_requests_queued Requests waiting for an idle state\n"
+                "# TYPE whisper_server_requests_queued gauge\n"
+                "whisper_server_requests_queued %d\n",
+                status["n_parallel"].get<int>(), status["n_busy"].get<int>(), status["n_queued"].get<int>());
+        out += buf;
+
+        out += model->pool.metrics();
+
+        if (cache.n_max > 0) {
+            out += cache.text();
+        }
+
+        if (model->batcher.window_ms > 0) {
+            out += model->batcher.text();
+        }
+
+        res.set_content(out, "text/plain; version=0.0.4");
+    });
+
     svr->set_exception_handler([](const Request &, Response &res, std::exception_ptr ep) {
         const char fmt[] = "500 Internal Server Error\n%s";
         char buf[BUFSIZ];
@@ -1182,12 +2366,17 @@ int main(int argc, char ** argv) {
     svr->set_error_handler([](const Request &req, Response &res) {
         if (res.status == 400) {
             res.set_content("Invalid request", "text/plain");
-        } else if (res.status != 500) {
+        } else if (res.status != 429 && res.status != 500 && res.status != 503) {
             res.set_content("File Not Found (" + req.path + ")", "text/plain");
             res.status = 404;
         }
     });
 
+    // enough workers for the running and the queued requests, the rest wait in the listen backlog
+    svr->new_task_queue = [&sparams] {
+        return new ThreadPool(std::max<size_t>(CPPHTTPLIB_THREAD_POOL_COUNT, sparams.n_parallel + sparams.n_queue + 1));
+    };
+
     // set timeouts and change hostname and port
     svr->set_read_timeout(sparams.read_timeout);
     svr->set_write_timeout(sparams.write_timeout);
@@ -1228,8 +2417,10 @@ int main(int argc, char ** argv) {
 
     // clean up function, to be called before exit
     auto clean_up = [&]() {
-        whisper_print_timings(ctx);
-        whisper_free(ctx);
+        for (auto * ctx : model->ctxs) {
+            whisper_print_timings(ctx);
+        }
+        model.reset();
     };
 
     std::thread t([&] {
@@ -11,7 +11,7 @@
 #include <thread>
 #include <vector>
 
-constexpr int N_THREAD = 8;
+constexpr int N_THREAD = WHISPER_WASM_THREADS;
 
 std::vector<struct whisper_context *> g_contexts(4, nullptr);
 
@@ -132,7 +132,12 @@ EMSCRIPTEN_BINDINGS(stream) {
     emscripten::function("init", emscripten::optional_override([](const std::string & path_model, const std::string & lang) {
         for (size_t i = 0; i < g_contexts.size(); ++i) {
             if (g_contexts[i] == nullptr) {
-                g_contexts[i] = whisper_init_from_file_with_params(path_model.c_str(), whisper_context_default_params());
+                // keep the compute threads between graphs, without polling - spinning web workers compete with the page
+                struct whisper_context_params cparams = whisper_context_default_params();
+                cparams.cpu_threadpool = true;
+                cparams.cpu_poll       = 0;
+
+                g_contexts[i] = whisper_init_from_file_with_params(path_model.c_str(), cparams);
                 if (g_contexts[i] != nullptr) {
                     g_running = true;
                     if (g_worker.joinable()) {
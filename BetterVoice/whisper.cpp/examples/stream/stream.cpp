@@ -7,9 +7,13 @@
 #include "common-whisper.h"
 #include "whisper.h"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <cstdio>
 #include <fstream>
+#include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -37,10 +41,13 @@ struct whisper_params {
     bool save_audio    = false; // save audio to wav file
     bool use_gpu       = true;
     bool flash_attn    = true;
+    bool agree         = false; // commit the text that consecutive hypotheses agree on (LocalAgreement-2)
 
     std::string language  = "en";
     std::string model     = "models/ggml-base.en.bin";
     std::string fname_out;
+    std::string fname_play;  // play back this file in real time instead of capturing
+    std::string fname_align; // word alignments of fname_play, to measure the latency of the text
 };
 
 void whisper_print_usage(int argc, char ** argv, const whisper_params & params);
@@ -70,11 +77,14 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-l"    || arg == "--language")      { params.language      = argv[++i]; }
         else if (arg == "-m"    || arg == "--model")         { params.model         = argv[++i]; }
         else if (arg == "-f"    || arg == "--file")          { params.fname_out     = argv[++i]; }
+        else if (arg == "-pb"   || arg == "--playback")      { params.fname_play    = argv[++i]; }
+        else if (arg == "-ra"   || arg == "--ref-align")     { params.fname_align   = argv[++i]; }
         else if (arg == "-tdrz" || arg == "--tinydiarize")   { params.tinydiarize   = true; }
         else if (arg == "-sa"   || arg == "--save-audio")    { params.save_audio    = true; }
         else if (arg == "-ng"   || arg == "--no-gpu")        { params.use_gpu       = false; }
         else if (arg == "-fa"   || arg == "--flash-attn")    { params.flash_attn    = true; }
         else if (arg == "-nfa"  || arg == "--no-flash-attn") { params.flash_attn    = false; }
+        else if (arg == "-la"   || arg == "--local-agreement") { params.agree       = true; }
 
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
@@ -109,14 +119,233 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  -l LANG,  --language LANG [%-7s] spoken language\n",                                params.language.c_str());
     fprintf(stderr, "  -m FNAME, --model FNAME   [%-7s] model path\n",                                     params.model.c_str());
     fprintf(stderr, "  -f FNAME, --file FNAME    [%-7s] text output file name\n",                          params.fname_out.c_str());
+    fprintf(stderr, "  -pb FNAME, --playback FNAME [%-7s] play back an audio file in real time instead of capturing\n", params.fname_play.c_str());
+    fprintf(stderr, "  -ra FNAME, --ref-align FNAME [%-7s] word alignments of the played back file (start end word)\n", params.fname_align.c_str());
     fprintf(stderr, "  -tdrz,    --tinydiarize   [%-7s] enable tinydiarize (requires a tdrz model)\n",     params.tinydiarize ? "true" : "false");
     fprintf(stderr, "  -sa,      --save-audio    [%-7s] save the recorded audio to a file\n",              params.save_audio ? "true" : "false");
     fprintf(stderr, "  -ng,      --no-gpu        [%-7s] disable GPU inference\n",                          params.use_gpu ? "false" : "true");
     fprintf(stderr, "  -fa,      --flash-attn    [%-7s] enable flash attention during inference\n",        params.flash_attn ? "true" : "false");
     fprintf(stderr, "  -nfa,     --no-flash-attn [%-7s] disable flash attention during inference\n",       params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -la,      --local-agreement [%-5s] print only the text two consecutive steps agree on\n", params.agree ? "true" : "false");
     fprintf(stderr, "\n");
 }
 
+// a word of the reference alignment of the played back file and when its text was first output
+struct stream_word {
+    float t0;
+    float t1;
+
+    std::string word;
+
+    bool  emitted    = false;
+    float latency_ms = 0.0f;
+};
+
+static std::string stream_normalize(const std::string & s) {
+    std::string res;
+    for (unsigned char c : s) {
+        if (isalnum(c) || c >= 0x80) {
+            res += (char) tolower(c);
+        }
+    }
+    return res;
+}
+
+// "start end word" lines with the times in seconds, e.g. an Audacity label track
+static bool stream_load_align(const std::string & fname, std::vector<stream_word> & words) {
+    std::ifstream fin(fname);
+    if (!fin) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(fin, line)) {
+        std::istringstream ss(line);
+
+        stream_word w;
+        if (ss >> w.t0 >> w.t1 >> w.word) {
+            w.word = stream_normalize(w.word);
+            if (!w.word.empty()) {
+                words.push_back(w);
+            }
+        }
+    }
+
+    return !words.empty();
+}
+
+// the first output of each reference word that ends in the window [t0, t1] (seconds of the played back audio)
+static void stream_match_words(std::vector<stream_word> & words, const std::string & text, float t0, float t1, float t_emit) {
+    std::set<std::string> seen;
+    {
+        std::istringstream ss(text);
+        std::string w;
+        while (ss >> w) {
+            seen.insert(stream_normalize(w));
+        }
+    }
+
+    // the playback position is read with the resolution of its 64 ms blocks
+    const float tol = 0.064f;
+
+    for (auto & w : words) {
+        if (w.emitted || w.t1 > t1 + tol || w.t1 < t0 - tol || seen.count(w.word) == 0) {
+            continue;
+        }
+        w.emitted    = true;
+        w.latency_ms = 1000.0f*(t_emit - w.t1);
+    }
+}
+
+//
+// LocalAgreement-2 streaming (--local-agreement): the text that two consecutive hypotheses of the buffer agree on is
+// committed and printed once. The committed text still in the buffer is the decoder prefix of the next hypothesis,
+// so only the rest is decoded again, and once the buffer is longer than --length the audio of the committed segments
+// is dropped from it, their text becoming the prompt. The encoder then only sees the audio of the uncommitted text
+// and the segment being committed, with an audio context sized for it
+//
+
+// a committed segment, the times in centiseconds from the start of the buffer
+struct stream_agree_segment {
+    int64_t t0;
+    int64_t t1;
+
+    std::vector<whisper_token> tokens; // text tokens
+
+    bool closed = false; // later text is in another segment, t1 is final
+};
+
+// a text token of a hypothesis with the times of its segment
+struct stream_agree_token {
+    whisper_token id;
+
+    int64_t t0;
+    int64_t t1;
+};
+
+struct stream_agree {
+    std::vector<float> pcm; // audio of the buffer
+
+    std::vector<stream_agree_segment> committed;
+    std::vector<stream_agree_token>   hyp;     // previous hypothesis, after the committed text
+    std::vector<whisper_token>        context; // text of the segments dropped from the buffer
+    std::vector<whisper_token>        prefix;
+};
+
+static whisper_token stream_agree_ts(struct whisper_context * ctx, int64_t t) {
+    return whisper_token_beg(ctx) + std::min<int64_t>(std::max<int64_t>(t, 0)/2, 1500);
+}
+
+// the committed segments of the buffer as the decoder would have generated them, timestamps in pairs
+static const std::vector<whisper_token> & stream_agree_prefix(struct whisper_context * ctx, stream_agree & agree) {
+    agree.prefix.clear();
+    for (const auto & seg : agree.committed) {
+        agree.prefix.push_back(stream_agree_ts(ctx, seg.t0));
+        agree.prefix.insert(agree.prefix.end(), seg.tokens.begin(), seg.tokens.end());
+        if (seg.closed) {
+            agree.prefix.push_back(stream_agree_ts(ctx, seg.t1));
+        }
+    }
+
+    return agree.prefix;
+}
+
+// commit the longest common prefix of the last two hypotheses - all of the current one if final - and trim the buffer
+// returns the newly committed text
+static std::string stream_agree_update(struct whisper_context * ctx, stream_agree & agree, int n_samples_len, bool final) {
+    std::vector<stream_agree_token> hyp;
+    for (int i = 0; i < whisper_full_n_segments(ctx); ++i) {
+        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
+        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+
+        for (int j = 0; j < whisper_full_n_tokens(ctx, i); ++j) {
+            const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+            if (id < whisper_token_eot(ctx)) {
+                hyp.push_back({ id, t0, t1 });
+            }
+        }
+    }
+
+    const int64_t t_end = (int64_t) agree.pcm.size()*100/WHISPER_SAMPLE_RATE;
+
+    // the buffer can not grow past the 30 s window: commit all of it
+    final = final || t_end > 2800;
+
+    size_t n = 0;
+    if (final) {
+        n = hyp.size();
+    } else {
+        while (n < hyp.size() && n < agree.hyp.size() && hyp[n].id == agree.hyp[n].id) {
+            n++;
+        }
+    }
+
+    std::string text;
+
+    // a continuation of the last segment starts at its t0 (see whisper_full_params.prefix_tokens)
+    for (size_t i = 0; i < n; ++i) {
+        auto & committed = agree.committed;
+
+        if (committed.empty() || committed.back().closed || committed.back().t0 != hyp[i].t0) {
+            // a segment ends where the next one starts
+            if (!committed.empty() && !committed.back().closed) {
+                committed.back().closed = true;
+                committed.back().t1     = std::max(committed.back().t0, hyp[i].t0);
+            }
+            committed.push_back({ hyp[i].t0, hyp[i].t1, {}, false });
+        }
+
+        committed.back().tokens.push_back(hyp[i].id);
+        committed.back().t1 = hyp[i].t1;
+
+        text += whisper_token_to_str(ctx, hyp[i].id);
+    }
+
+    agree.hyp.assign(hyp.begin() + n, hyp.end());
+
+    if (final && !agree.committed.empty()) {
+        agree.committed.back().closed = true;
+        agree.committed.back().t1     = t_end;
+    }
+
+    // drop the audio of the closed segments once the buffer is longer than n_samples_len
+    if ((int) agree.pcm.size() > n_samples_len || final) {
+        size_t n_closed = 0;
+        while (n_closed < agree.committed.size() && agree.committed[n_closed].closed) {
+            n_closed++;
+        }
+
+        if (n_closed > 0) {
+            const int64_t t = agree.committed[n_closed - 1].t1 & ~1; // on a timestamp token
+
+            for (size_t i = 0; i < n_closed; ++i) {
+                agree.context.insert(agree.context.end(), agree.committed[i].tokens.begin(), agree.committed[i].tokens.end());
+            }
+            agree.committed.erase(agree.committed.begin(), agree.committed.begin() + n_closed);
+
+            for (auto & seg : agree.committed) {
+                seg.t0 -= t;
+                seg.t1 -= t;
+            }
+            for (auto & tok : agree.hyp) {
+                tok.t0 -= t;
+                tok.t1 -= t;
+            }
+
+            const size_t n_drop = std::min(agree.pcm.size(), (size_t) (t*WHISPER_SAMPLE_RATE/100));
+            agree.pcm.erase(agree.pcm.begin(), agree.pcm.begin() + n_drop);
+
+            // the decoder takes at most n_text_ctx/2 tokens of prompt
+            const size_t n_context_max = whisper_n_text_ctx(ctx)/2;
+            if (agree.context.size() > n_context_max) {
+                agree.context.erase(agree.context.begin(), agree.context.end() - n_context_max);
+            }
+        }
+    }
+
+    return text;
+}
+
 int main(int argc, char ** argv) {
     ggml_backend_load_all();
 
@@ -136,6 +365,11 @@ int main(int argc, char ** argv) {
 
     const bool use_vad = n_samples_step <= 0; // sliding window mode uses VAD
 
+    if (use_vad && params.agree) {
+        fprintf(stderr, "error: --local-agreement needs a --step > 0\n");
+        return 1;
+    }
+
     const int n_new_line = !use_vad ? std::max(1, params.length_ms / params.step_ms - 1) : 1; // number of steps to print new line
 
     params.no_timestamps  = !use_vad;
@@ -144,13 +378,31 @@ int main(int argc, char ** argv) {
 
     // init audio
 
+    const bool playback = !params.fname_play.empty();
+
     audio_async audio(params.length_ms);
-    if (!audio.init(params.capture_id, WHISPER_SAMPLE_RATE)) {
-        fprintf(stderr, "%s: audio.init() failed!\n", __func__);
-        return 1;
+    if (playback) {
+        std::vector<float> pcmf32_play;
+        std::vector<std::vector<float>> pcmf32s_play;
+        if (!read_audio_data(params.fname_play, pcmf32_play, pcmf32s_play, false) ||
+            !audio.init_playback(pcmf32_play, WHISPER_SAMPLE_RATE)) {
+            fprintf(stderr, "%s: failed to play back '%s'\n", __func__, params.fname_play.c_str());
+            return 1;
+        }
+    } else {
+        if (!audio.init(params.capture_id, WHISPER_SAMPLE_RATE)) {
+            fprintf(stderr, "%s: audio.init() failed!\n", __func__);
+            return 1;
+        }
+
+        audio.resume();
     }
 
-    audio.resume();
+    std::vector<stream_word> words;
+    if (!params.fname_align.empty() && !stream_load_align(params.fname_align, words)) {
+        fprintf(stderr, "%s: failed to read the word alignments from '%s'\n", __func__, params.fname_align.c_str());
+        return 1;
+    }
 
     // whisper init
     if (params.language != "auto" && whisper_lang_id(params.language.c_str()) == -1){
@@ -176,6 +428,8 @@ int main(int argc, char ** argv) {
 
     std::vector<whisper_token> prompt_tokens;
 
+    stream_agree agree;
+
     // print some info about the processing
     {
         fprintf(stderr, "\n");
@@ -230,9 +484,21 @@ int main(int argc, char ** argv) {
 
         wavWriter.open(filename, WHISPER_SAMPLE_RATE, 16, 1);
     }
+    // the playback starts once the model is loaded
+    if (playback) {
+        audio.resume();
+    }
+
     printf("[Start speaking]\n");
     fflush(stdout);
 
+    // statistics of the playback
+    std::vector<float> t_proc_ms;    // time of each inference
+    int   n_overrun = 0;             // inferences that took longer than the step
+    int   n_drop    = 0;             // steps dropped to catch up
+    float t_drop_ms = 0.0f;          // audio dropped
+    bool  last      = false;         // the played back audio has been consumed
+
     auto t_last  = std::chrono::high_resolution_clock::now();
     const auto t_start = t_last;
 
@@ -250,6 +516,8 @@ int main(int argc, char ** argv) {
 
         // process new audio
 
+        size_t pos_end = 0; // playback position at the end of the audio to transcribe
+
         if (!use_vad) {
             while (true) {
                 // handle Ctrl + C
@@ -257,10 +525,13 @@ int main(int argc, char ** argv) {
                 if (!is_running) {
                     break;
                 }
-                audio.get(params.step_ms, pcmf32_new);
+                // all the audio since the last step, so that a slow step is noticed and no audio is skipped
+                audio.get(params.length_ms, pcmf32_new);
 
                 if ((int) pcmf32_new.size() > 2*n_samples_step) {
                     fprintf(stderr, "\n\n%s: WARNING: cannot process audio fast enough, dropping audio ...\n\n", __func__);
+                    n_drop++;
+                    t_drop_ms += 1000.0f*pcmf32_new.size()/WHISPER_SAMPLE_RATE;
                     audio.clear();
                     continue;
                 }
@@ -270,41 +541,66 @@ int main(int argc, char ** argv) {
                     break;
                 }
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                // the rest of the played back audio
+                if (playback && audio.playback_done()) {
+                    audio.clear();
+                    last = true;
+                    break;
+                }
+
+                // sleep until the capture completes the step, waking up now and then to handle Ctrl + C
+                audio.wait_until(audio.pos_clear() + n_samples_step, 100);
             }
 
+            if (!is_running || (last && pcmf32_new.empty())) {
+                break;
+            }
+
+            pos_end = audio.playback_pos();
+
             const int n_samples_new = pcmf32_new.size();
 
-            // take up to params.length_ms audio from previous iteration
-            const int n_samples_take = std::min((int) pcmf32_old.size(), std::max(0, n_samples_keep + n_samples_len - n_samples_new));
+            if (params.agree) {
+                // the buffer only loses the audio of committed segments
+                agree.pcm.insert(agree.pcm.end(), pcmf32_new.begin(), pcmf32_new.end());
+            } else {
+                // take up to params.length_ms audio from previous iteration
+                const int n_samples_take = std::min((int) pcmf32_old.size(), std::max(0, n_samples_keep + n_samples_len - n_samples_new));
 
-            //printf("processing: take = %d, new = %d, old = %d\n", n_samples_take, n_samples_new, (int) pcmf32_old.size());
+                //printf("processing: take = %d, new = %d, old = %d\n", n_samples_take, n_samples_new, (int) pcmf32_old.size());
 
-            pcmf32.resize(n_samples_new + n_samples_take);
+                pcmf32.resize(n_samples_new + n_samples_take);
 
-            for (int i = 0; i < n_samples_take; i++) {
-                pcmf32[i] = pcmf32_old[pcmf32_old.size() - n_samples_take + i];
-            }
+                for (int i = 0; i < n_samples_take; i++) {
+                    pcmf32[i] = pcmf32_old[pcmf32_old.size() - n_samples_take + i];
+                }
 
-            memcpy(pcmf32.data() + n_samples_take, pcmf32_new.data(), n_samples_new*sizeof(float));
+                memcpy(pcmf32.data() + n_samples_take, pcmf32_new.data(), n_samples_new*sizeof(float));
 
-            pcmf32_old = pcmf32;
+                pcmf32_old = pcmf32;
+            }
         } else {
             const auto t_now  = std::chrono::high_resolution_clock::now();
             const auto t_diff = std::chrono::duration_cast<std::chrono::milliseconds>(t_now - t_last).count();
 
-            if (t_diff < 2000) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            last = playback && audio.playback_done();
+
+            if (t_diff < 2000 && !last) {
+                audio.wait_until(audio.pos_end() + ((2000 - t_diff)*WHISPER_SAMPLE_RATE)/1000, 100);
 
                 continue;
             }
 
             audio.get(2000, pcmf32_new);
 
-            if (::vad_simple(pcmf32_new, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, false)) {
+            // the end of the played back audio is transcribed as if followed by silence
+            if (last || ::vad_simple(pcmf32_new, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, false)) {
                 audio.get(params.length_ms, pcmf32);
+
+                pos_end = audio.playback_pos();
             } else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                // check the voice activity again after 100 ms of new audio
+                audio.wait_until(audio.pos_end() + WHISPER_SAMPLE_RATE/10, 200);
 
                 continue;
             }
@@ -338,11 +634,70 @@ int main(int argc, char ** argv) {
             wparams.prompt_tokens    = params.no_context ? nullptr : prompt_tokens.data();
             wparams.prompt_n_tokens  = params.no_context ? 0       : prompt_tokens.size();
 
-            if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+            if (params.agree) {
+                const auto & prefix = stream_agree_prefix(ctx, agree);
+
+                wparams.single_segment   = false;
+                wparams.no_timestamps    = false;
+                wparams.prefix_tokens    = prefix.data();
+                wparams.prefix_n_tokens  = prefix.size();
+                wparams.prompt_tokens    = params.no_context ? nullptr : agree.context.data();
+                wparams.prompt_n_tokens  = params.no_context ? 0       : agree.context.size();
+            }
+
+            const std::vector<float> & pcm = params.agree ? agree.pcm : pcmf32;
+
+            const auto t_proc_start = std::chrono::steady_clock::now();
+
+            if (whisper_full(ctx, wparams, pcm.data(), pcm.size()) != 0) {
                 fprintf(stderr, "%s: failed to process audio\n", argv[0]);
                 return 6;
             }
 
+            // only the text both hypotheses agree on is printed, once
+            std::string text_commit;
+            if (params.agree) {
+                text_commit = stream_agree_update(ctx, agree, n_samples_len, last);
+            }
+
+            if (playback) {
+                const auto t_emit = std::chrono::steady_clock::now();
+
+                t_proc_ms.push_back(std::chrono::duration<float, std::milli>(t_emit - t_proc_start).count());
+                if (!use_vad && t_proc_ms.back() > params.step_ms) {
+                    n_overrun++;
+                }
+
+                if (!words.empty()) {
+                    std::string text = text_commit;
+                    for (int i = 0; !params.agree && i < whisper_full_n_segments(ctx); ++i) {
+                        text += whisper_full_get_segment_text(ctx, i);
+                    }
+
+                    const float t1 = float(pos_end)/WHISPER_SAMPLE_RATE;
+                    const float t0 = t1 - float(pcm.size())/WHISPER_SAMPLE_RATE;
+
+                    stream_match_words(words, text, t0, t1, std::chrono::duration<float>(t_emit - audio.playback_start()).count());
+                }
+            }
+
+            if (params.agree) {
+                printf("%s", text_commit.c_str());
+                fflush(stdout);
+
+                if (params.fname_out.length() > 0) {
+                    fout << text_commit;
+                }
+
+                ++n_iter;
+
+                if (last) {
+                    break;
+                }
+
+                continue;
+            }
+
             // print result;
             {
                 if (!use_vad) {
@@ -426,6 +781,66 @@ int main(int argc, char ** argv) {
             }
             fflush(stdout);
         }
+
+        if (last) {
+            break;
+        }
+    }
+
+    // the last hypothesis has no successor to agree with
+    if (params.agree && !agree.hyp.empty()) {
+        std::string text;
+        for (const auto & tok : agree.hyp) {
+            text += whisper_token_to_str(ctx, tok.id);
+        }
+        agree.hyp.clear();
+
+        printf("%s\n", text.c_str());
+        fflush(stdout);
+
+        if (params.fname_out.length() > 0) {
+            fout << text;
+        }
+    }
+
+    if (playback && !t_proc_ms.empty()) {
+        auto percentile = [](std::vector<float> v, float p) {
+            std::sort(v.begin(), v.end());
+            return v[std::min(v.size() - 1, (size_t) (p/100.0f*v.size()))];
+        };
+
+        float t_sum = 0.0f;
+        for (float t : t_proc_ms) {
+            t_sum += t;
+        }
+
+        fprintf(stderr, "\n");
+        fprintf(stderr, "%s: playback: %d inferences, %.0f ms mean, %.0f ms p90, %.0f ms max", __func__, (int) t_proc_ms.size(),
+                t_sum/t_proc_ms.size(), percentile(t_proc_ms, 90), percentile(t_proc_ms, 100));
+        if (!use_vad) {
+            fprintf(stderr, ", %d over the %d ms step, %d drops (%.0f ms of audio)", n_overrun, params.step_ms, n_drop, t_drop_ms);
+        }
+        fprintf(stderr, "\n");
+
+        std::vector<float> latency;
+        for (const auto & w : words) {
+            if (w.emitted) {
+                latency.push_back(w.latency_ms);
+            }
+        }
+
+        if (!words.empty()) {
+            fprintf(stderr, "%s: latency from the end of a word to its text: %d / %d words", __func__, (int) latency.size(), (int) words.size());
+            if (!latency.empty()) {
+                float l_sum = 0.0f;
+                for (float l : latency) {
+                    l_sum += l;
+                }
+                fprintf(stderr, ", %.0f ms mean, %.0f ms p50, %.0f ms p90, %.0f ms max", l_sum/latency.size(),
+                        percentile(latency, 50), percentile(latency, 90), percentile(latency, 100));
+            }
+            fprintf(stderr, "\n");
+        }
     }
 
     audio.pause();
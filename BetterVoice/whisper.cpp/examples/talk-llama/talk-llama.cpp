@@ -7,7 +7,9 @@
 #include "whisper.h"
 #include "llama.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <regex>
@@ -77,6 +79,8 @@ struct whisper_params {
     bool verbose_prompt = false;
     bool use_gpu        = true;
     bool flash_attn     = true;
+    bool pipeline       = false;
+    bool shared_tp      = false;
 
     std::string person      = "Georgi";
     std::string bot_name    = "LLaMA";
@@ -123,6 +127,8 @@ static bool whisper_params_parse(int argc, char ** argv, whisper_params & params
         else if (arg == "-ng"  || arg == "--no-gpu")         { params.use_gpu        = false; }
         else if (arg == "-fa"  || arg == "--flash-attn")     { params.flash_attn     = true; }
         else if (arg == "-nfa" || arg == "--no-flash-attn")  { params.flash_attn     = false; }
+        else if (arg == "-pl"  || arg == "--pipeline")       { params.pipeline       = true; }
+        else if (arg == "-stp" || arg == "--shared-tp")      { params.shared_tp      = true; }
         else if (arg == "-p"   || arg == "--person")         { params.person         = argv[++i]; }
         else if (arg == "-bn"   || arg == "--bot-name")      { params.bot_name       = argv[++i]; }
         else if (arg == "--session")                         { params.path_session   = argv[++i]; }
@@ -178,6 +184,8 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  -ng,      --no-gpu         [%-7s] disable GPU\n",                                 params.use_gpu ? "false" : "true");
     fprintf(stderr, "  -fa,      --flash-attn     [%-7s] enable flash attention\n",                      params.flash_attn ? "true" : "false");
     fprintf(stderr, "  -nfa,     --no-flash-attn  [%-7s] disable flash attention\n",                     params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -pl,      --pipeline       [%-7s] feed the words heard to LLaMA while still listening\n", params.pipeline ? "true" : "false");
+    fprintf(stderr, "  -stp,     --shared-tp      [%-7s] run Whisper and LLaMA on one CPU threadpool, taking turns\n", params.shared_tp ? "true" : "false");
     fprintf(stderr, "  -p NAME,  --person NAME    [%-7s] person name (for prompt selection)\n",          params.person.c_str());
     fprintf(stderr, "  -bn NAME, --bot-name NAME  [%-7s] bot name (to display)\n",                       params.bot_name.c_str());
     fprintf(stderr, "  -w TEXT,  --wake-command T [%-7s] wake-up command to listen for\n",               params.wake_cmd.c_str());
@@ -272,6 +280,123 @@ static std::vector<std::string> get_words(const std::string &txt) {
     return words;
 }
 
+// the text heard, reduced to the characters the prompt uses
+static std::string clean_heard(std::string text) {
+    // remove text between brackets using regex
+    {
+        std::regex re("\\[.*?\\]");
+        text = std::regex_replace(text, re, "");
+    }
+
+    // remove text between brackets using regex
+    {
+        std::regex re("\\(.*?\\)");
+        text = std::regex_replace(text, re, "");
+    }
+
+    // remove all characters, except for letters, numbers, punctuation and ':', '\'', '-', ' '
+    text = std::regex_replace(text, std::regex("[^a-zA-Z0-9åäöÅÄÖ\\.,\\?!\\s\\:\\'\\-]"), "");
+
+    // take first line
+    text = text.substr(0, text.find_first_of('\n'));
+
+    // remove leading and trailing whitespace
+    text = std::regex_replace(text, std::regex("^\\s+"), "");
+    text = std::regex_replace(text, std::regex("\\s+$"), "");
+
+    return text;
+}
+
+// mean absolute amplitude of the last last_ms of audio
+static float energy_last(const std::vector<float> & pcmf32, int sample_rate, int last_ms) {
+    const int n_samples = std::min((int) pcmf32.size(), (sample_rate * last_ms) / 1000);
+    if (n_samples == 0) {
+        return 0.0f;
+    }
+
+    float energy = 0.0f;
+    for (int i = (int) pcmf32.size() - n_samples; i < (int) pcmf32.size(); i++) {
+        energy += fabsf(pcmf32[i]);
+    }
+
+    return energy / n_samples;
+}
+
+// pipelined mode (-pl): while the person is still speaking, the audio is transcribed every second, and the words
+// the last two transcriptions agree on are committed. Their tokens are decoded into the KV cache of LLaMA right
+// away, after n_past, so that only the tail of the text is left to process once the person stops speaking
+struct llama_prefill {
+    std::vector<llama_token> tokens;    // in the KV cache at [n_past, n_past + tokens.size())
+    std::vector<std::string> words;     // of the previous partial transcription
+    std::vector<std::string> committed; // agreed words
+
+    bool    in_speech = false;
+    int64_t t_last_ms = 0;              // time of the last partial transcription
+};
+
+// llama_decode() taking its turn on the threadpool shared with whisper (-stp) - and on the GPU
+static int32_t llama_decode_shared(struct llama_context * ctx, llama_batch & batch) {
+    whisper_shared_threadpool_lock();
+    const int32_t ret = llama_decode(ctx, batch);
+    whisper_shared_threadpool_unlock();
+
+    return ret;
+}
+
+// keep the longest prefix - of at most n_max tokens - that the committed tokens share with target, and drop the
+// rest from the KV cache. Returns the number of tokens kept
+static int llama_prefill_keep(struct llama_context * ctx, int n_past, llama_prefill & prefill, const std::vector<llama_token> & target, int n_max) {
+    int n_keep = 0;
+    while (n_keep < (int) prefill.tokens.size() && n_keep < (int) target.size() && n_keep < n_max && prefill.tokens[n_keep] == target[n_keep]) {
+        n_keep++;
+    }
+
+    if (n_keep < (int) prefill.tokens.size()) {
+        llama_memory_seq_rm(llama_get_memory(ctx), 0, n_past + n_keep, -1);
+        prefill.tokens.resize(n_keep);
+    }
+
+    return n_keep;
+}
+
+// make the committed tokens equal to the first n_target tokens of target, decoding the new ones without logits
+static bool llama_prefill_sync(struct llama_context * ctx, llama_batch & batch, int n_past, llama_prefill & prefill, const std::vector<llama_token> & target, int n_target) {
+    const int n_keep = llama_prefill_keep(ctx, n_past, prefill, target, n_target);
+    if (n_keep == n_target) {
+        return true;
+    }
+
+    batch.n_tokens = n_target - n_keep;
+
+    for (int i = 0; i < batch.n_tokens; i++) {
+        batch.token[i]     = target[n_keep + i];
+        batch.pos[i]       = n_past + n_keep + i;
+        batch.n_seq_id[i]  = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i]    = false;
+    }
+
+    if (llama_decode_shared(ctx, batch)) {
+        return false;
+    }
+
+    prefill.tokens.insert(prefill.tokens.end(), target.begin() + n_keep, target.begin() + n_target);
+
+    return true;
+}
+
+// drop the committed tokens from the KV cache, e.g. when the speech turns out not to be addressed to LLaMA
+static void llama_prefill_reset(struct llama_context * ctx, int n_past, llama_prefill & prefill) {
+    if (!prefill.tokens.empty()) {
+        llama_memory_seq_rm(llama_get_memory(ctx), 0, n_past, -1);
+    }
+
+    prefill.tokens.clear();
+    prefill.words.clear();
+    prefill.committed.clear();
+    prefill.in_speech = false;
+}
+
 const std::string k_prompt_whisper = R"(A conversation with a person called {1}.)";
 
 const std::string k_prompt_llama = R"(Text transcript of a never ending dialog, where {0} interacts with an AI assistant named {1}.
@@ -314,6 +439,15 @@ int main(int argc, char ** argv) {
     cparams.use_gpu    = params.use_gpu;
     cparams.flash_attn = params.flash_attn;
 
+    // one set of threads for both models, instead of two competing for the same cores
+    ggml_threadpool_t threadpool = nullptr;
+    if (params.shared_tp) {
+        struct ggml_threadpool_params tpp = ggml_threadpool_params_default(params.n_threads);
+        threadpool = ggml_threadpool_new(&tpp);
+    }
+
+    cparams.cpu_threadpool_shared = threadpool;
+
     struct whisper_context * ctx_wsp = whisper_init_from_file_with_params(params.model_wsp.c_str(), cparams);
     if (!ctx_wsp) {
         fprintf(stderr, "No whisper.cpp model specified. Please provide using -mw <modelfile>\n");
@@ -349,6 +483,10 @@ int main(int argc, char ** argv) {
 
     struct llama_context * ctx_llama = llama_init_from_model(model_llama, lcparams);
 
+    if (threadpool) {
+        llama_attach_threadpool(ctx_llama, threadpool, threadpool);
+    }
+
     // print some info about the processing
     {
         fprintf(stderr, "\n");
@@ -494,7 +632,7 @@ int main(int argc, char ** argv) {
         }
     }
 
-    if (llama_decode(ctx_llama, batch)) {
+    if (llama_decode_shared(ctx_llama, batch)) {
         fprintf(stderr, "%s : failed to decode\n", __func__);
         return 1;
     }
@@ -559,6 +697,8 @@ int main(int argc, char ** argv) {
 
     std::vector<llama_token> embd;
 
+    llama_prefill prefill;
+
     // reverse prompts for detecting when it's time to stop speaking
     std::vector<std::string> antiprompts = {
         params.person + chat_symb,
@@ -581,9 +721,59 @@ int main(int argc, char ** argv) {
         {
             audio.get(2000, pcmf32_cur);
 
+            const int64_t t_now_ms = ggml_time_ms();
+
+            // the end of the speech is detected by vad_simple - the start, by the energy of the last step rising
+            // above the energy of the whole 2 s
+            if (params.pipeline && t_now_ms - prefill.t_last_ms >= 1000 && n_session_consumed >= (int) session_tokens.size()) {
+                prefill.t_last_ms = t_now_ms;
+
+                if (!prefill.in_speech) {
+                    prefill.in_speech = energy_last(pcmf32_cur, WHISPER_SAMPLE_RATE, 500)*params.vad_thold > energy_last(pcmf32_cur, WHISPER_SAMPLE_RATE, 2000);
+                } else {
+                    std::vector<float> pcmf32_partial;
+                    audio.get(params.voice_ms, pcmf32_partial);
+
+                    int64_t t_partial_ms = 0;
+                    auto words = get_words(::trim(::transcribe(ctx_wsp, params, pcmf32_partial, prompt_whisper, prob0, t_partial_ms)));
+                    words.erase(words.begin(), words.begin() + std::min<int>(words.size(), wake_cmd_length));
+
+                    // commit the words the last two transcriptions agree on
+                    size_t n_agree = 0;
+                    while (n_agree < words.size() && n_agree < prefill.words.size() && words[n_agree] == prefill.words[n_agree]) {
+                        n_agree++;
+                    }
+
+                    if (n_agree > prefill.committed.size()) {
+                        prefill.committed.assign(words.begin(), words.begin() + n_agree);
+
+                        std::string text;
+                        for (const auto & word : prefill.committed) {
+                            text += word + " ";
+                        }
+
+                        const auto target = ::llama_tokenize(ctx_llama, " " + clean_heard(text), false);
+
+                        // the last token may still merge with the next word
+                        const int n_target = (int) target.size() - 1;
+
+                        if (n_target > 0 && n_past + n_target < n_ctx - n_prev) {
+                            if (!llama_prefill_sync(ctx_llama, batch, n_past, prefill, target, n_target)) {
+                                fprintf(stderr, "%s : failed to decode\n", __func__);
+                                return 1;
+                            }
+                        }
+                    }
+
+                    prefill.words = std::move(words);
+                }
+            }
+
             if (::vad_simple(pcmf32_cur, WHISPER_SAMPLE_RATE, 1250, params.vad_thold, params.freq_thold, params.print_energy) || force_speak) {
                 //fprintf(stdout, "%s: Speech detected! Processing ...\n", __func__);
 
+                int64_t t_end_ms = t_now_ms;
+
                 audio.get(params.voice_ms, pcmf32_cur);
 
                 std::string all_heard;
@@ -610,6 +800,7 @@ int main(int argc, char ** argv) {
                     const float sim = similarity(wake_cmd_heard, wake_cmd);
 
                     if ((sim < 0.7f) || (text_heard.empty())) {
+                        llama_prefill_reset(ctx_llama, n_past, prefill);
                         audio.clear();
                         continue;
                     }
@@ -620,32 +811,13 @@ int main(int argc, char ** argv) {
                     speak_with_file(params.speak, params.heard_ok, params.speak_file, voice_id);
                 }
 
-                // remove text between brackets using regex
-                {
-                    std::regex re("\\[.*?\\]");
-                    text_heard = std::regex_replace(text_heard, re, "");
-                }
-
-                // remove text between brackets using regex
-                {
-                    std::regex re("\\(.*?\\)");
-                    text_heard = std::regex_replace(text_heard, re, "");
-                }
-
-                // remove all characters, except for letters, numbers, punctuation and ':', '\'', '-', ' '
-                text_heard = std::regex_replace(text_heard, std::regex("[^a-zA-Z0-9åäöÅÄÖ\\.,\\?!\\s\\:\\'\\-]"), "");
-
-                // take first line
-                text_heard = text_heard.substr(0, text_heard.find_first_of('\n'));
-
-                // remove leading and trailing whitespace
-                text_heard = std::regex_replace(text_heard, std::regex("^\\s+"), "");
-                text_heard = std::regex_replace(text_heard, std::regex("\\s+$"), "");
+                text_heard = clean_heard(text_heard);
 
                 const std::vector<llama_token> tokens = llama_tokenize(ctx_llama, text_heard.c_str(), false);
 
                 if (text_heard.empty() || tokens.empty() || force_speak) {
                     //fprintf(stdout, "%s: Heard nothing, skipping ...\n", __func__);
+                    llama_prefill_reset(ctx_llama, n_past, prefill);
                     audio.clear();
 
                     continue;
@@ -665,6 +837,27 @@ int main(int argc, char ** argv) {
                     session_tokens.insert(session_tokens.end(), tokens.begin(), tokens.end());
                 }
 
+                // only the tokens after the prefilled prefix are left to decode - the last one is always decoded, for
+                // its logits
+                if (params.pipeline) {
+                    const int n_prefilled = n_past + (int) embd.size() > n_ctx ? 0 : llama_prefill_keep(ctx_llama, n_past, prefill, embd, embd.size() - 1);
+
+                    if (n_prefilled > 0 && !path_session.empty()) {
+                        session_tokens.insert(session_tokens.end(), embd.begin(), embd.begin() + n_prefilled);
+                        n_session_consumed = session_tokens.size();
+                    }
+
+                    embd_inp.insert(embd_inp.end(), embd.begin(), embd.begin() + n_prefilled);
+                    embd.erase(embd.begin(), embd.begin() + n_prefilled);
+
+                    llama_prefill_reset(ctx_llama, n_past + n_prefilled, prefill);
+                    n_past += n_prefilled;
+
+                    if (params.print_energy) {
+                        fprintf(stderr, "\n%s : %d of %d input tokens prefilled while listening\n", __func__, n_prefilled, n_prefilled + (int) embd.size());
+                    }
+                }
+
                 // text inference
                 bool done = false;
                 std::string text_to_speak;
@@ -728,7 +921,7 @@ int main(int argc, char ** argv) {
                             }
                         }
 
-                        if (llama_decode(ctx_llama, batch)) {
+                        if (llama_decode_shared(ctx_llama, batch)) {
                             fprintf(stderr, "%s : failed to decode\n", __func__);
                             return 1;
                         }
@@ -752,6 +945,11 @@ int main(int argc, char ** argv) {
 
                         const llama_token id = llama_sampler_sample(smpl, ctx_llama, -1);
 
+                        if (params.pipeline && params.print_energy && t_end_ms > 0) {
+                            fprintf(stderr, "\n%s : first token %d ms after the end of speech\n", __func__, (int) (ggml_time_ms() - t_end_ms));
+                            t_end_ms = 0;
+                        }
+
                         if (id != llama_vocab_eos(vocab_llama)) {
                             // add it to the context
                             embd.push_back(id);
@@ -807,6 +1005,10 @@ int main(int argc, char ** argv) {
     llama_batch_free(batch);
     llama_free(ctx_llama);
 
+    if (threadpool) {
+        ggml_threadpool_free(threadpool);
+    }
+
     llama_backend_free();
 
     return 0;
@@ -0,0 +1,454 @@
+// transcribes a WAV corpus with N states over one context, fed by N worker threads from a shared job queue, and
+// reports the aggregate throughput for each N - the scaling curve of a server or batch host that runs one worker
+// per state
+//
+//   states  - the numbers of states and workers to run, e.g. 1,2,4,8
+//   threads - compute threads per state, 0 to split the hardware threads between the workers
+//   jobs    - the clips are queued in a round robin over the corpus until there are this many
+//
+// for each N it prints the real-time factor of the whole run, the speedup over the first run, the fraction of the
+// time the workers spend in whisper_full_with_state() (the rest is waiting for the queue or for each other at the
+// end), the contention of the queue lock and the latency percentiles of the jobs
+
+#include "common-whisper.h"
+#include "whisper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+// command-line parameters
+struct throughput_bench_params {
+    int32_t n_threads = 0; // per state, 0 for hardware_concurrency/n_states
+    int32_t n_jobs    = 0; // 0 for max(clips, 4*max(states))
+    int32_t n_warmup  = 1; // untimed jobs per state before each run
+
+    std::vector<int> states = { 1, 2, 4 };
+
+    std::string model = "models/ggml-base.en.bin";
+    std::string language = "en";
+    std::string fname_json; // also write the results to this file
+
+    std::vector<std::string> inputs; // WAV files or directories
+
+    bool use_gpu    = true;
+    bool flash_attn = true;
+    int  beam_size  = 1;
+};
+
+static std::vector<std::string> split(const std::string & s, char sep) {
+    std::vector<std::string> res;
+    size_t pos = 0;
+    while (true) {
+        const size_t next = s.find(sep, pos);
+        res.push_back(s.substr(pos, next - pos));
+        if (next == std::string::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    return res;
+}
+
+static bool ends_with(const std::string & s, const std::string & suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static void throughput_bench_print_usage(char ** argv, const throughput_bench_params & params);
+
+static bool throughput_bench_params_parse(int argc, char ** argv, throughput_bench_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            throughput_bench_print_usage(argv, params);
+            exit(0);
+        }
+        else if (arg == "-m"  || arg == "--model")         { params.model      = argv[++i]; }
+        else if (arg == "-f"  || arg == "--file")          { params.inputs.push_back(argv[++i]); }
+        else if (arg == "-ns" || arg == "--states")        {
+            params.states.clear();
+            for (const auto & v : split(argv[++i], ',')) {
+                params.states.push_back(std::max(1, std::stoi(v)));
+            }
+        }
+        else if (arg == "-t"  || arg == "--threads")       { params.n_threads  = std::stoi(argv[++i]); }
+        else if (arg == "-j"  || arg == "--jobs")          { params.n_jobs     = std::stoi(argv[++i]); }
+        else if (arg == "-w"  || arg == "--warmup")        { params.n_warmup   = std::stoi(argv[++i]); }
+        else if (arg == "-bs" || arg == "--beam-size")     { params.beam_size  = std::stoi(argv[++i]); }
+        else if (arg == "-l"  || arg == "--language")      { params.language   = argv[++i]; }
+        else if (arg == "-oj" || arg == "--output-json")   { params.fname_json = argv[++i]; }
+        else if (arg == "-fa" || arg == "--flash-attn")    { params.flash_attn = true; }
+        else if (arg == "-nfa" || arg == "--no-flash-attn") { params.flash_attn = false; }
+        else if (arg == "-ng" || arg == "--no-gpu")        { params.use_gpu    = false; }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            throughput_bench_print_usage(argv, params);
+            return false;
+        }
+    }
+
+    if (params.inputs.empty()) {
+        fprintf(stderr, "error: no input files (-f)\n");
+        throughput_bench_print_usage(argv, params);
+        return false;
+    }
+
+    return true;
+}
+
+static void throughput_bench_print_usage(char ** argv, const throughput_bench_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s -f PATH [-f PATH ...] [options]\n", argv[0]);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,        --help           show this help message and exit\n");
+    fprintf(stderr, "  -f PATH,   --file PATH      WAV file, or directory searched for .wav files\n");
+    fprintf(stderr, "  -m FNAME,  --model FNAME    [%-7s] model path\n", params.model.c_str());
+    fprintf(stderr, "  -ns LIST,  --states LIST    [1,2,4  ] numbers of states and workers to run\n");
+    fprintf(stderr, "  -t N,      --threads N      [%-7d] threads per state, 0 to split the hardware threads\n", params.n_threads);
+    fprintf(stderr, "  -j N,      --jobs N         [%-7d] jobs per run, 0 for max(clips, 4 x states)\n", params.n_jobs);
+    fprintf(stderr, "  -w N,      --warmup N       [%-7d] untimed jobs per state before each run\n", params.n_warmup);
+    fprintf(stderr, "  -bs N,     --beam-size N    [%-7d] 1 for greedy, N > 1 for beam search with N beams\n", params.beam_size);
+    fprintf(stderr, "  -l LANG,   --language LANG  [%-7s] spoken language\n", params.language.c_str());
+    fprintf(stderr, "  -fa,       --flash-attn     [%-7s] enable flash attention\n", params.flash_attn ? "true" : "false");
+    fprintf(stderr, "  -nfa,      --no-flash-attn  [%-7s] disable flash attention\n", params.flash_attn ? "false" : "true");
+    fprintf(stderr, "  -ng,       --no-gpu         [%-7s] disable GPU\n", params.use_gpu ? "false" : "true");
+    fprintf(stderr, "  -oj FNAME, --output-json FNAME also write the results to a JSON file\n");
+    fprintf(stderr, "\n");
+}
+
+// the .wav files under a directory, recursively
+static void list_wavs(const std::string & path, std::vector<std::string> & result) {
+#ifdef _WIN32
+    struct _finddata_t fd;
+    intptr_t h = _findfirst((path + "\\*").c_str(), &fd);
+    if (h != -1) {
+        do {
+            const std::string name = fd.name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            if (fd.attrib & _A_SUBDIR) {
+                list_wavs(path + "\\" + name, result);
+            } else if (ends_with(name, ".wav") || ends_with(name, ".WAV")) {
+                result.push_back(path + "\\" + name);
+            }
+        } while (_findnext(h, &fd) == 0);
+        _findclose(h);
+    }
+#else
+    if (DIR * dir = opendir(path.c_str())) {
+        while (struct dirent * ent = readdir(dir)) {
+            const std::string name = ent->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            struct stat st;
+            if (stat((path + "/" + name).c_str(), &st) != 0) {
+                continue;
+            }
+            if (st.st_mode & S_IFDIR) {
+                list_wavs(path + "/" + name, result);
+            } else if (ends_with(name, ".wav") || ends_with(name, ".WAV")) {
+                result.push_back(path + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+#endif
+}
+
+// the queue of the workers: the index of the next job, behind a mutex like the request queue of a server
+struct throughput_bench_queue {
+    std::mutex mutex;
+    int next  = 0;
+    int n_end = 0;
+
+    // contention of the mutex, over all workers
+    std::atomic<int64_t> n_lock      { 0 };
+    std::atomic<int64_t> n_contended { 0 };
+    std::atomic<int64_t> t_wait_us   { 0 };
+
+    // the next job, -1 when the queue is empty
+    int pop() {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            const int64_t t_start_us = ggml_time_us();
+            lock.lock();
+            t_wait_us   += ggml_time_us() - t_start_us;
+            n_contended += 1;
+        }
+        n_lock += 1;
+
+        return next < n_end ? next++ : -1;
+    }
+};
+
+struct throughput_bench_result {
+    int n_states;
+    int n_threads;
+    int n_jobs;
+
+    double audio_s = 0.0;
+    double wall_s  = 0.0;
+    double busy_s  = 0.0; // in whisper_full_with_state(), over all workers
+
+    int64_t n_lock      = 0;
+    int64_t n_contended = 0;
+    double  wait_ms     = 0.0;
+
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double max_ms = 0.0;
+
+    int n_failed = 0;
+
+    double rtf()         const { return audio_s > 0.0 ? wall_s/audio_s : 0.0; }
+    double speed()       const { return wall_s > 0.0 ? audio_s/wall_s : 0.0; }
+    double utilization() const { return wall_s > 0.0 ? busy_s/(n_states*wall_s) : 0.0; }
+};
+
+static bool throughput_bench_run(
+        struct whisper_context * ctx,
+        const std::vector<struct whisper_state *> & states,
+        const throughput_bench_params & params,
+        const std::vector<std::vector<float>> & clips,
+        throughput_bench_result & res) {
+    whisper_full_params wparams = whisper_full_default_params(params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+
+    wparams.n_threads      = res.n_threads;
+    wparams.language       = params.language.c_str();
+    wparams.print_progress = false;
+    wparams.print_realtime = false;
+    wparams.print_special  = false;
+    if (params.beam_size > 1) {
+        wparams.beam_search.beam_size = params.beam_size;
+    }
+
+    const int n_states = res.n_states;
+
+    // untimed: the first graphs of a state are built and allocated on use
+    for (int w = 0; w < params.n_warmup; ++w) {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < n_states; ++i) {
+            workers.emplace_back([&, i]() {
+                const auto & pcm = clips[(w*n_states + i) % clips.size()];
+                whisper_full_with_state(ctx, states[i], wparams, pcm.data(), pcm.size());
+            });
+        }
+        for (auto & t : workers) {
+            t.join();
+        }
+    }
+
+    throughput_bench_queue queue;
+    queue.n_end = res.n_jobs;
+
+    std::vector<double> latency_ms(res.n_jobs, 0.0);
+    std::vector<double> busy_s(n_states, 0.0);
+    std::atomic<int> n_failed { 0 };
+
+    const int64_t t_start_us = ggml_time_us();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < n_states; ++i) {
+        workers.emplace_back([&, i]() {
+            for (int job = queue.pop(); job >= 0; job = queue.pop()) {
+                const auto & pcm = clips[job % clips.size()];
+
+                const int64_t t_job_us = ggml_time_us();
+
+                if (whisper_full_with_state(ctx, states[i], wparams, pcm.data(), pcm.size()) != 0) {
+                    n_failed++;
+                }
+
+                latency_ms[job] = (ggml_time_us() - t_job_us)/1e3;
+                busy_s[i]      += latency_ms[job]/1e3;
+            }
+        });
+    }
+    for (auto & t : workers) {
+        t.join();
+    }
+
+    res.wall_s = (ggml_time_us() - t_start_us)/1e6;
+
+    for (int job = 0; job < res.n_jobs; ++job) {
+        res.audio_s += (double) clips[job % clips.size()].size()/WHISPER_SAMPLE_RATE;
+    }
+    for (double b : busy_s) {
+        res.busy_s += b;
+    }
+
+    res.n_lock      = queue.n_lock;
+    res.n_contended = queue.n_contended;
+    res.wait_ms     = queue.t_wait_us/1e3;
+    res.n_failed    = n_failed;
+
+    std::sort(latency_ms.begin(), latency_ms.end());
+    if (!latency_ms.empty()) {
+        res.p50_ms = latency_ms[latency_ms.size()/2];
+        res.p95_ms = latency_ms[std::min(latency_ms.size() - 1, (size_t) (0.95*latency_ms.size()))];
+        res.max_ms = latency_ms.back();
+    }
+
+    return res.n_failed == 0;
+}
+
+int main(int argc, char ** argv) {
+    ggml_backend_load_all();
+
+    throughput_bench_params params;
+
+    if (throughput_bench_params_parse(argc, argv, params) == false) {
+        return 1;
+    }
+
+    std::vector<std::string> fnames;
+    for (const auto & input : params.inputs) {
+        struct stat st;
+        if (stat(input.c_str(), &st) == 0 && (st.st_mode & S_IFDIR)) {
+            list_wavs(input, fnames);
+        } else {
+            fnames.push_back(input);
+        }
+    }
+    std::sort(fnames.begin(), fnames.end());
+
+    // the clips are decoded once up front, the runs measure transcription only
+    std::vector<std::vector<float>> clips;
+    for (const auto & fname : fnames) {
+        std::vector<float> pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_audio_data(fname, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "warning: skipping '%s', failed to read it\n", fname.c_str());
+            continue;
+        }
+        clips.push_back(std::move(pcmf32));
+    }
+    if (clips.empty()) {
+        fprintf(stderr, "error: no audio to transcribe (-f)\n");
+        return 1;
+    }
+
+    const int n_states_max = *std::max_element(params.states.begin(), params.states.end());
+    const int n_hw         = std::max(1, (int) std::thread::hardware_concurrency());
+
+    whisper_log_set([](enum ggml_log_level level, const char * text, void *) {
+        if (level >= GGML_LOG_LEVEL_WARN) {
+            fputs(text, stderr);
+        }
+    }, nullptr);
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+
+    cparams.use_gpu    = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params_no_state(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: failed to load '%s'\n", params.model.c_str());
+        return 2;
+    }
+
+    // the states of the largest run, the smaller runs use the first ones
+    std::vector<struct whisper_state *> states;
+    for (int i = 0; i < n_states_max; ++i) {
+        struct whisper_state * state = whisper_init_state(ctx);
+        if (state == nullptr) {
+            fprintf(stderr, "error: failed to create state %d of %d\n", i + 1, n_states_max);
+            for (auto * s : states) {
+                whisper_free_state(s);
+            }
+            whisper_free(ctx);
+            return 3;
+        }
+        states.push_back(state);
+    }
+
+    fprintf(stderr, "%s: %zu clips, %d hardware threads\n", __func__, clips.size(), n_hw);
+
+    std::vector<throughput_bench_result> results;
+
+    for (int n_states : params.states) {
+        throughput_bench_result res;
+        res.n_states  = n_states;
+        res.n_threads = params.n_threads > 0 ? params.n_threads : std::max(1, n_hw/n_states);
+        res.n_jobs    = params.n_jobs > 0 ? params.n_jobs : std::max((int) clips.size(), 4*n_states_max);
+
+        fprintf(stderr, "%s: %d states x %d threads, %d jobs\n", __func__, res.n_states, res.n_threads, res.n_jobs);
+
+        if (!throughput_bench_run(ctx, states, params, clips, res)) {
+            fprintf(stderr, "error: %d of %d jobs failed with %d states\n", res.n_failed, res.n_jobs, n_states);
+            for (auto * s : states) {
+                whisper_free_state(s);
+            }
+            whisper_free(ctx);
+            return 4;
+        }
+
+        results.push_back(res);
+    }
+
+    for (auto * s : states) {
+        whisper_free_state(s);
+    }
+    whisper_free(ctx);
+
+    printf("\n");
+    printf("| %6s | %7s | %5s | %8s | %7s | %8s | %7s | %6s | %10s | %9s | %9s | %9s |\n",
+            "states", "threads", "jobs", "wall s", "RTF", "speed", "scaling", "util", "contended", "p50 ms", "p95 ms", "max ms");
+    printf("|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|\n", "--------", "---------", "-------", "----------", "---------",
+            "----------", "---------", "--------", "------------", "-----------", "-----------", "-----------");
+    for (const auto & r : results) {
+        printf("| %6d | %7d | %5d | %8.2f | %7.4f | %7.1fx | %6.2fx | %5.1f%% | %9.1f%% | %9.1f | %9.1f | %9.1f |\n",
+                r.n_states, r.n_threads, r.n_jobs, r.wall_s, r.rtf(), r.speed(),
+                results[0].speed() > 0.0 ? r.speed()/results[0].speed() : 0.0, 100.0*r.utilization(),
+                r.n_lock > 0 ? 100.0*r.n_contended/r.n_lock : 0.0, r.p50_ms, r.p95_ms, r.max_ms);
+    }
+    printf("\n");
+
+    if (!params.fname_json.empty()) {
+        FILE * f = fopen(params.fname_json.c_str(), "w");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", params.fname_json.c_str());
+            return 5;
+        }
+
+        fprintf(f, "{\n");
+        fprintf(f, "  \"model\": \"%s\",\n", params.model.c_str());
+        fprintf(f, "  \"system_info\": \"%s\",\n", whisper_print_system_info());
+        fprintf(f, "  \"use_gpu\": %d,\n", params.use_gpu);
+        fprintf(f, "  \"flash_attn\": %d,\n", params.flash_attn);
+        fprintf(f, "  \"beam_size\": %d,\n", params.beam_size);
+        fprintf(f, "  \"n_clips\": %zu,\n", clips.size());
+        fprintf(f, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto & r = results[i];
+            fprintf(f, "    { \"n_states\": %d, \"n_threads\": %d, \"n_jobs\": %d, \"audio_s\": %.3f, \"wall_s\": %.3f, "
+                    "\"busy_s\": %.3f, \"rtf\": %.5f, \"utilization\": %.4f, \"n_lock\": %lld, \"n_contended\": %lld, "
+                    "\"wait_ms\": %.3f, \"p50_ms\": %.1f, \"p95_ms\": %.1f, \"max_ms\": %.1f }%s\n",
+                    r.n_states, r.n_threads, r.n_jobs, r.audio_s, r.wall_s, r.busy_s, r.rtf(), r.utilization(),
+                    (long long) r.n_lock, (long long) r.n_contended, r.wait_ms, r.p50_ms, r.p95_ms, r.max_ms,
+                    i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n");
+        fprintf(f, "}\n");
+        fclose(f);
+    }
+
+    return 0;
+}
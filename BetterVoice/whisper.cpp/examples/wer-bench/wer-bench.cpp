@@ -0,0 +1,638 @@
+// transcribes a speech corpus with a matrix of configurations in one process and reports the word error rate next to
+// the real-time factor of each, for speed/quality trade-offs
+//
+//   models     - the model files, e.g. the quantizations of one or more models
+//   flash attn - on/off, one context per model and setting, loaded once
+//   strategies - greedy or beam search with N beams
+//   audio_ctx  - the encoder context, 0 for the full 1500 frames and -1 for the length of each clip
+//
+// the corpora are the LibriSpeech layout (*.trans.txt next to the .flac files), the Earnings-21 layout
+// (media/*.mp3 and transcripts/nlp_references/*.nlp, or a file-metadata.csv listing a subset) or a TSV file of
+// "audio path<TAB>reference" lines
+
+#include "common-whisper.h"
+#include "whisper.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+// command-line parameters
+struct wer_bench_params {
+    int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
+    int32_t n_max     = 0; // only the first N utterances, 0 for all
+
+    std::vector<std::string> models = { "models/ggml-base.en.bin" };
+    std::vector<int>         flash  = { 1 };
+    std::vector<int>         beams  = { 1 };  // 1 for greedy
+    std::vector<int>         actx   = { 0 };
+
+    std::string dataset;       // corpus directory, Earnings-21 metadata CSV or TSV manifest
+    std::string language = "en";
+    std::string fname_norm;    // english.json of the Python normalizer, to map British spellings
+    std::string fname_json;    // also write the results to this file
+    std::string dir_hyp;       // write the hypotheses of each configuration to this directory
+
+    bool use_gpu = true;
+};
+
+static std::vector<std::string> split(const std::string & s, char sep) {
+    std::vector<std::string> res;
+    size_t pos = 0;
+    while (true) {
+        const size_t next = s.find(sep, pos);
+        res.push_back(s.substr(pos, next - pos));
+        if (next == std::string::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    return res;
+}
+
+static bool ends_with(const std::string & s, const std::string & suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static void wer_bench_print_usage(char ** argv, const wer_bench_params & params);
+
+static bool wer_bench_params_parse(int argc, char ** argv, wer_bench_params & params) {
+    auto parse_ints = [](const std::string & s) {
+        std::vector<int> res;
+        for (const auto & v : split(s, ',')) {
+            res.push_back(std::stoi(v));
+        }
+        return res;
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            wer_bench_print_usage(argv, params);
+            exit(0);
+        }
+        else if (arg == "-t"  || arg == "--threads")     { params.n_threads  = std::stoi(argv[++i]); }
+        else if (arg == "-n"  || arg == "--max-utts")    { params.n_max      = std::stoi(argv[++i]); }
+        else if (arg == "-m"  || arg == "--models")      { params.models     = split(argv[++i], ','); }
+        else if (arg == "-fa" || arg == "--flash-attn")  { params.flash      = parse_ints(argv[++i]); }
+        else if (arg == "-bs" || arg == "--beam-size")   { params.beams      = parse_ints(argv[++i]); }
+        else if (arg == "-ac" || arg == "--audio-ctx")   { params.actx       = parse_ints(argv[++i]); }
+        else if (arg == "-ds" || arg == "--dataset")     { params.dataset    = argv[++i]; }
+        else if (arg == "-l"  || arg == "--language")    { params.language   = argv[++i]; }
+        else if (arg == "-nj" || arg == "--norm-json")   { params.fname_norm = argv[++i]; }
+        else if (arg == "-oj" || arg == "--output-json") { params.fname_json = argv[++i]; }
+        else if (arg == "-od" || arg == "--output-dir")  { params.dir_hyp    = argv[++i]; }
+        else if (arg == "-ng" || arg == "--no-gpu")      { params.use_gpu    = false; }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            wer_bench_print_usage(argv, params);
+            return false;
+        }
+    }
+
+    if (params.dataset.empty()) {
+        fprintf(stderr, "error: no dataset (-ds)\n");
+        wer_bench_print_usage(argv, params);
+        return false;
+    }
+
+    return true;
+}
+
+static void wer_bench_print_usage(char ** argv, const wer_bench_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s -ds PATH [options]\n", argv[0]);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,        --help           show this help message and exit\n");
+    fprintf(stderr, "  -ds PATH,  --dataset PATH   LibriSpeech or Earnings-21 directory, Earnings-21 metadata CSV or TSV manifest\n");
+    fprintf(stderr, "  -m LIST,   --models LIST    [%s] model files\n", params.models[0].c_str());
+    fprintf(stderr, "  -fa LIST,  --flash-attn LIST [1      ] flash attention off (0) and/or on (1)\n");
+    fprintf(stderr, "  -bs LIST,  --beam-size LIST [1      ] 1 for greedy, N > 1 for beam search with N beams\n");
+    fprintf(stderr, "  -ac LIST,  --audio-ctx LIST [0      ] encoder contexts, 0 for 1500 frames, -1 for the clip length\n");
+    fprintf(stderr, "  -t N,      --threads N      [%-7d] number of threads\n", params.n_threads);
+    fprintf(stderr, "  -n N,      --max-utts N     [%-7d] only the first N utterances, 0 for all\n", params.n_max);
+    fprintf(stderr, "  -l LANG,   --language LANG  [%-7s] spoken language\n", params.language.c_str());
+    fprintf(stderr, "  -nj FNAME, --norm-json FNAME spelling map of the normalizer (tests/*/normalizers/english.json)\n");
+    fprintf(stderr, "  -od DIR,   --output-dir DIR write the hypotheses of each configuration to DIR/<config>.tsv\n");
+    fprintf(stderr, "  -oj FNAME, --output-json FNAME also write the results to a JSON file\n");
+    fprintf(stderr, "  -ng,       --no-gpu         [%-7s] disable GPU\n", params.use_gpu ? "false" : "true");
+    fprintf(stderr, "\n");
+}
+
+//
+// corpus
+//
+
+struct wer_bench_utt {
+    std::string id;
+    std::string fname;
+    std::string ref;
+};
+
+// the files under a directory whose name ends with suffix, recursively
+static void list_files(const std::string & path, const std::string & suffix, std::vector<std::string> & result) {
+#ifdef _WIN32
+    struct _finddata_t fd;
+    intptr_t h = _findfirst((path + "\\*").c_str(), &fd);
+    if (h != -1) {
+        do {
+            const std::string name = fd.name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            if (fd.attrib & _A_SUBDIR) {
+                list_files(path + "\\" + name, suffix, result);
+            } else if (ends_with(name, suffix)) {
+                result.push_back(path + "\\" + name);
+            }
+        } while (_findnext(h, &fd) == 0);
+        _findclose(h);
+    }
+#else
+    if (DIR * dir = opendir(path.c_str())) {
+        while (struct dirent * ent = readdir(dir)) {
+            const std::string name = ent->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            struct stat st;
+            if (stat((path + "/" + name).c_str(), &st) != 0) {
+                continue;
+            }
+            if (st.st_mode & S_IFDIR) {
+                list_files(path + "/" + name, suffix, result);
+            } else if (ends_with(name, suffix)) {
+                result.push_back(path + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+#endif
+}
+
+static std::string dir_name(const std::string & path) {
+    const size_t pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? "." : path.substr(0, pos);
+}
+
+static std::string base_name(const std::string & path) {
+    const size_t pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+// LibriSpeech: each chapter directory has a <speaker>-<chapter>.trans.txt of "<utterance id> <text>" lines
+static void load_librispeech(const std::string & root, std::vector<wer_bench_utt> & utts) {
+    std::vector<std::string> fnames;
+    list_files(root, ".trans.txt", fnames);
+
+    for (const auto & fname : fnames) {
+        std::ifstream fin(fname);
+        std::string line;
+        while (std::getline(fin, line)) {
+            const size_t pos = line.find(' ');
+            if (pos == std::string::npos) {
+                continue;
+            }
+            wer_bench_utt utt;
+            utt.id    = line.substr(0, pos);
+            utt.fname = dir_name(fname) + "/" + utt.id + ".flac";
+            utt.ref   = line.substr(pos + 1);
+            utts.push_back(std::move(utt));
+        }
+    }
+}
+
+// Earnings-21: media/<code>.mp3 and transcripts/nlp_references/<code>.nlp, a header and then one "token|..." line
+// per word; codes lists the files of a subset, all of them if empty
+static void load_earnings21(const std::string & root, const std::vector<std::string> & codes, std::vector<wer_bench_utt> & utts) {
+    std::vector<std::string> fnames;
+    if (codes.empty()) {
+        list_files(root + "/transcripts/nlp_references", ".nlp", fnames);
+    } else {
+        for (const auto & code : codes) {
+            fnames.push_back(root + "/transcripts/nlp_references/" + code + ".nlp");
+        }
+    }
+
+    for (const auto & fname : fnames) {
+        std::ifstream fin(fname);
+        if (!fin) {
+            fprintf(stderr, "warning: skipping '%s', failed to open it\n", fname.c_str());
+            continue;
+        }
+
+        wer_bench_utt utt;
+        utt.id    = base_name(fname).substr(0, base_name(fname).size() - 4);
+        utt.fname = root + "/media/" + utt.id + ".mp3";
+
+        std::string line;
+        std::getline(fin, line);
+        while (std::getline(fin, line)) {
+            if (!utt.ref.empty()) {
+                utt.ref += ' ';
+            }
+            utt.ref += line.substr(0, line.find('|'));
+        }
+        utts.push_back(std::move(utt));
+    }
+}
+
+static bool load_dataset(const std::string & path, std::vector<wer_bench_utt> & utts) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        fprintf(stderr, "error: '%s' does not exist\n", path.c_str());
+        return false;
+    }
+
+    if (st.st_mode & S_IFDIR) {
+        struct stat st_nlp;
+        if (stat((path + "/transcripts/nlp_references").c_str(), &st_nlp) == 0) {
+            load_earnings21(path, {}, utts);
+        } else {
+            load_librispeech(path, utts);
+        }
+    } else if (ends_with(path, ".csv")) {
+        // the file-metadata.csv of Earnings-21 next to media/ and transcripts/, the code in the first column
+        std::ifstream fin(path);
+        std::vector<std::string> codes;
+        std::string line;
+        std::getline(fin, line);
+        while (std::getline(fin, line)) {
+            if (!line.empty()) {
+                codes.push_back(line.substr(0, line.find(',')));
+            }
+        }
+        load_earnings21(dir_name(path), codes, utts);
+    } else {
+        std::ifstream fin(path);
+        std::string line;
+        while (std::getline(fin, line)) {
+            const size_t pos = line.find('\t');
+            if (pos == std::string::npos) {
+                continue;
+            }
+            wer_bench_utt utt;
+            utt.fname = line.substr(0, pos);
+            utt.id    = utt.fname;
+            utt.ref   = line.substr(pos + 1);
+            utts.push_back(std::move(utt));
+        }
+    }
+
+    std::sort(utts.begin(), utts.end(), [](const wer_bench_utt & a, const wer_bench_utt & b) { return a.id < b.id; });
+
+    return !utts.empty();
+}
+
+//
+// word error rate
+//
+
+// the "key": "value" pairs of a flat JSON object, such as the British to American spelling map of the normalizer
+static std::map<std::string, std::string> load_spelling(const std::string & fname) {
+    std::map<std::string, std::string> res;
+
+    std::ifstream fin(fname);
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    const std::string s = ss.str();
+
+    std::vector<std::string> strs;
+    for (size_t pos = s.find('"'); pos != std::string::npos; pos = s.find('"', pos)) {
+        const size_t end = s.find('"', pos + 1);
+        if (end == std::string::npos) {
+            break;
+        }
+        strs.push_back(s.substr(pos + 1, end - pos - 1));
+        pos = end + 1;
+    }
+    for (size_t i = 0; i + 1 < strs.size(); i += 2) {
+        res[strs[i]] = strs[i + 1];
+    }
+
+    return res;
+}
+
+// a subset of the EnglishTextNormalizer of tests/*/normalizers: lowercase, drop [bracketed] and (parenthesized)
+// text, split at anything but letters, digits and apostrophes, drop apostrophes and map the spellings; numbers and
+// contractions are not standardized, so the scores are close to, not the same as, those of eval.py
+static std::vector<std::string> normalize(const std::string & text, const std::map<std::string, std::string> & spelling) {
+    std::vector<std::string> words;
+    std::string word;
+
+    auto flush = [&]() {
+        if (word.empty()) {
+            return;
+        }
+        const auto it = spelling.find(word);
+        words.push_back(it == spelling.end() ? word : it->second);
+        word.clear();
+    };
+
+    int depth = 0;
+    for (unsigned char c : text) {
+        if (c == '[' || c == '(') {
+            flush();
+            depth++;
+        } else if (c == ']' || c == ')') {
+            depth = std::max(0, depth - 1);
+        } else if (depth > 0) {
+            continue;
+        } else if (isalnum(c) || c >= 0x80) {
+            word += (char) tolower(c);
+        } else if (c != '\'') {
+            flush();
+        }
+    }
+    flush();
+
+    return words;
+}
+
+// word-level Levenshtein distance of the hypothesis to the reference
+static int edit_distance(const std::vector<std::string> & ref, const std::vector<std::string> & hyp) {
+    std::vector<int> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        cur[0] = i;
+        for (size_t j = 1; j <= hyp.size(); ++j) {
+            cur[j] = std::min({ prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1) });
+        }
+        std::swap(prev, cur);
+    }
+    return prev[hyp.size()];
+}
+
+//
+// matrix
+//
+
+struct wer_bench_result {
+    std::string model;
+
+    int flash_attn;
+    int beam_size;
+    int audio_ctx;
+
+    int64_t n_words  = 0;
+    int64_t n_errors = 0;
+
+    double audio_s  = 0.0;
+    double total_s  = 0.0;
+    double encode_s = 0.0;
+    double decode_s = 0.0; // decode and sample
+
+    int n_fallback = 0;
+
+    double wer() const { return n_words > 0 ? 100.0*n_errors/n_words : 0.0; }
+    double rtf() const { return audio_s > 0.0 ? total_s/audio_s : 0.0; }
+};
+
+static std::string json_escape(const std::string & s) {
+    std::string res;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+static std::string config_name(const wer_bench_result & r) {
+    std::string name = base_name(r.model);
+    if (ends_with(name, ".bin")) {
+        name = name.substr(0, name.size() - 4);
+    }
+    return name + "-fa" + std::to_string(r.flash_attn) + "-bs" + std::to_string(r.beam_size) + "-ac" + std::to_string(r.audio_ctx);
+}
+
+static bool wer_bench_run(
+        struct whisper_context * ctx,
+        const wer_bench_params & params,
+        const std::vector<wer_bench_utt> & utts,
+        const std::vector<std::vector<std::string>> & refs,
+        const std::map<std::string, std::string> & spelling,
+        wer_bench_result & res) {
+    whisper_full_params wparams = whisper_full_default_params(res.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+
+    wparams.n_threads      = params.n_threads;
+    wparams.language       = params.language.c_str();
+    wparams.audio_ctx      = res.audio_ctx;
+    wparams.print_progress = false;
+    wparams.print_realtime = false;
+    wparams.print_special  = false;
+    if (res.beam_size > 1) {
+        wparams.beam_search.beam_size = res.beam_size;
+    }
+
+    FILE * fhyp = nullptr;
+    if (!params.dir_hyp.empty()) {
+        const std::string fname = params.dir_hyp + "/" + config_name(res) + ".tsv";
+        fhyp = fopen(fname.c_str(), "w");
+        if (fhyp == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", fname.c_str());
+            return false;
+        }
+    }
+
+    // the state keeps the cross-attention KV of its last encode and skips encoding the same window again, the
+    // previous configuration may have ended on the clip this one starts with
+    const std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+    if (whisper_pcm_to_mel(ctx, silence.data(), silence.size(), params.n_threads) != 0 ||
+        whisper_encode(ctx, 0, params.n_threads) != 0) {
+        fprintf(stderr, "error: failed to encode\n");
+        return false;
+    }
+
+    for (size_t u = 0; u < utts.size(); ++u) {
+        // the clips are read again for each configuration, a corpus does not fit in memory
+        std::vector<float> pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_audio_data(utts[u].fname, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "warning: skipping '%s', failed to read it\n", utts[u].fname.c_str());
+            continue;
+        }
+
+        whisper_reset_timings(ctx);
+
+        const int64_t t_start_us = ggml_time_us();
+
+        if (int ret = whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size())) {
+            fprintf(stderr, "error: failed to process '%s': %d\n", utts[u].fname.c_str(), ret);
+            if (fhyp) {
+                fclose(fhyp);
+            }
+            return false;
+        }
+
+        res.total_s += (ggml_time_us() - t_start_us)/1e6;
+        res.audio_s += (double) pcmf32.size()/WHISPER_SAMPLE_RATE;
+
+        whisper_timings * timings = whisper_get_timings(ctx);
+        res.encode_s   += timings->encode_total_ms/1000.0;
+        res.decode_s   += (timings->decode_total_ms + timings->sample_total_ms)/1000.0;
+        res.n_fallback += timings->n_fallback;
+        delete timings;
+
+        std::string hyp;
+        for (int i = 0; i < whisper_full_n_segments(ctx); ++i) {
+            hyp += whisper_full_get_segment_text(ctx, i);
+        }
+
+        res.n_words  += refs[u].size();
+        res.n_errors += edit_distance(refs[u], normalize(hyp, spelling));
+
+        if (fhyp) {
+            fprintf(fhyp, "%s\t%s\n", utts[u].id.c_str(), hyp.c_str());
+        }
+
+        fprintf(stderr, "\r%s: %zu / %zu, WER %.2f%%   ", config_name(res).c_str(), u + 1, utts.size(), res.wer());
+    }
+    fprintf(stderr, "\n");
+
+    if (fhyp) {
+        fclose(fhyp);
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv) {
+    ggml_backend_load_all();
+
+    wer_bench_params params;
+
+    if (wer_bench_params_parse(argc, argv, params) == false) {
+        return 1;
+    }
+
+    std::vector<wer_bench_utt> utts;
+    if (!load_dataset(params.dataset, utts)) {
+        fprintf(stderr, "error: no utterances in '%s' (-ds)\n", params.dataset.c_str());
+        return 1;
+    }
+    if (params.n_max > 0 && (size_t) params.n_max < utts.size()) {
+        utts.resize(params.n_max);
+    }
+
+    std::map<std::string, std::string> spelling;
+    if (!params.fname_norm.empty()) {
+        spelling = load_spelling(params.fname_norm);
+        if (spelling.empty()) {
+            fprintf(stderr, "error: no spellings in '%s' (-nj)\n", params.fname_norm.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<std::vector<std::string>> refs;
+    for (const auto & utt : utts) {
+        refs.push_back(normalize(utt.ref, spelling));
+    }
+
+    fprintf(stderr, "%s: %zu utterances, %zu configurations\n", __func__, utts.size(),
+            params.models.size()*params.flash.size()*params.beams.size()*params.actx.size());
+
+    whisper_log_set([](enum ggml_log_level level, const char * text, void *) {
+        if (level >= GGML_LOG_LEVEL_WARN) {
+            fputs(text, stderr);
+        }
+    }, nullptr);
+
+    std::vector<wer_bench_result> results;
+
+    for (const auto & model : params.models) {
+        for (int fa : params.flash) {
+            struct whisper_context_params cparams = whisper_context_default_params();
+
+            cparams.use_gpu    = params.use_gpu;
+            cparams.flash_attn = fa != 0;
+
+            // one context per model and flash attention setting, shared by the strategies and encoder contexts
+            struct whisper_context * ctx = whisper_init_from_file_with_params(model.c_str(), cparams);
+            if (ctx == nullptr) {
+                fprintf(stderr, "error: failed to load '%s'\n", model.c_str());
+                return 2;
+            }
+
+            for (int bs : params.beams) {
+                for (int ac : params.actx) {
+                    wer_bench_result res;
+                    res.model      = model;
+                    res.flash_attn = fa != 0;
+                    res.beam_size  = std::max(1, bs);
+                    res.audio_ctx  = ac;
+
+                    if (!wer_bench_run(ctx, params, utts, refs, spelling, res)) {
+                        whisper_free(ctx);
+                        return 4;
+                    }
+
+                    results.push_back(res);
+                }
+            }
+
+            whisper_free(ctx);
+        }
+    }
+
+    printf("\n");
+    printf("| %-32s | %2s | %2s | %5s | %7s | %7s | %8s | %9s | %9s | %9s |\n",
+            "model", "fa", "bs", "actx", "WER %", "RTF", "speed", "encode s", "decode s", "fallbacks");
+    printf("|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|\n", "----------------------------------", "----", "----", "-------",
+            "---------", "---------", "----------", "-----------", "-----------", "-----------");
+    for (const auto & r : results) {
+        printf("| %-32s | %2d | %2d | %5d | %7.2f | %7.4f | %7.1fx | %9.2f | %9.2f | %9d |\n",
+                base_name(r.model).c_str(), r.flash_attn, r.beam_size, r.audio_ctx, r.wer(), r.rtf(),
+                r.total_s > 0.0 ? r.audio_s/r.total_s : 0.0, r.encode_s, r.decode_s, r.n_fallback);
+    }
+    printf("\n");
+
+    if (!params.fname_json.empty()) {
+        FILE * f = fopen(params.fname_json.c_str(), "w");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open '%s' for writing\n", params.fname_json.c_str());
+            return 5;
+        }
+
+        fprintf(f, "{\n");
+        fprintf(f, "  \"dataset\": \"%s\",\n", json_escape(params.dataset).c_str());
+        fprintf(f, "  \"system_info\": \"%s\",\n", whisper_print_system_info());
+        fprintf(f, "  \"n_threads\": %d,\n", params.n_threads);
+        fprintf(f, "  \"n_utts\": %zu,\n", utts.size());
+        fprintf(f, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto & r = results[i];
+            fprintf(f, "    { \"model\": \"%s\", \"flash_attn\": %d, \"beam_size\": %d, \"audio_ctx\": %d, "
+                    "\"wer\": %.4f, \"n_words\": %lld, \"n_errors\": %lld, \"audio_s\": %.3f, \"total_s\": %.3f, "
+                    "\"rtf\": %.5f, \"encode_s\": %.3f, \"decode_s\": %.3f, \"n_fallback\": %d }%s\n",
+                    json_escape(r.model).c_str(), r.flash_attn, r.beam_size, r.audio_ctx,
+                    r.wer(), (long long) r.n_words, (long long) r.n_errors, r.audio_s, r.total_s,
+                    r.rtf(), r.encode_s, r.decode_s, r.n_fallback, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n");
+        fprintf(f, "}\n");
+        fclose(f);
+    }
+
+    return 0;
+}
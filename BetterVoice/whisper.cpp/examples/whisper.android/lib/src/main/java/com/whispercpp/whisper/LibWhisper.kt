@@ -6,6 +6,9 @@ import android.util.Log
 import kotlinx.coroutines.*
 import java.io.File
 import java.io.InputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
 import java.util.concurrent.Executors
 
 private const val LOG_TAG = "LibWhisper"
@@ -35,6 +38,26 @@ class WhisperContext private constructor(private var ptr: Long) {
         }
     }
 
+    // Transcribes the remaining floats of a direct buffer with the default state, without copying them
+    suspend fun transcribeBuffer(buffer: FloatBuffer, printTimestamp: Boolean = true): String = withContext(scope.coroutineContext) {
+        require(ptr != 0L)
+        transcribeDirect(ptr, 0L, buffer, printTimestamp)
+    }
+
+    suspend fun transcribeBuffer(buffer: ByteBuffer, printTimestamp: Boolean = true): String =
+        transcribeBuffer(buffer.asSamples(), printTimestamp)
+
+    // A state with its own decoding buffers, for running transcriptions next to the ones of this context.
+    // Release the states before the context.
+    fun createState(): WhisperState {
+        require(ptr != 0L)
+        val statePtr = WhisperLib.initState(ptr)
+        if (statePtr == 0L) {
+            throw java.lang.RuntimeException("Couldn't create state")
+        }
+        return WhisperState(ptr, statePtr)
+    }
+
     suspend fun benchMemory(nthreads: Int): String = withContext(scope.coroutineContext) {
         return@withContext WhisperLib.benchMemcpy(nthreads)
     }
@@ -89,12 +112,79 @@ class WhisperContext private constructor(private var ptr: Long) {
     }
 }
 
+class WhisperState internal constructor(private val contextPtr: Long, private var ptr: Long) {
+    // Each state runs on its own thread, so different states of a context can transcribe concurrently
+    private val scope: CoroutineScope = CoroutineScope(
+        Executors.newSingleThreadExecutor().asCoroutineDispatcher()
+    )
+
+    suspend fun transcribeData(data: FloatArray, printTimestamp: Boolean = true): String = withContext(scope.coroutineContext) {
+        require(ptr != 0L)
+        val numThreads = WhisperCpuConfig.preferredThreadCount
+        if (WhisperLib.fullTranscribeWithState(contextPtr, ptr, numThreads, data) != 0) {
+            throw java.lang.RuntimeException("Couldn't transcribe audio")
+        }
+        readSegments(contextPtr, ptr, printTimestamp)
+    }
+
+    suspend fun transcribeBuffer(buffer: FloatBuffer, printTimestamp: Boolean = true): String = withContext(scope.coroutineContext) {
+        require(ptr != 0L)
+        transcribeDirect(contextPtr, ptr, buffer, printTimestamp)
+    }
+
+    suspend fun transcribeBuffer(buffer: ByteBuffer, printTimestamp: Boolean = true): String =
+        transcribeBuffer(buffer.asSamples(), printTimestamp)
+
+    suspend fun release() = withContext(scope.coroutineContext) {
+        if (ptr != 0L) {
+            WhisperLib.freeState(ptr)
+            ptr = 0
+        }
+    }
+
+    protected fun finalize() {
+        runBlocking {
+            release()
+        }
+    }
+}
+
+private fun ByteBuffer.asSamples(): FloatBuffer {
+    require(isDirect) { "Audio buffer must be direct" }
+    require(order() == ByteOrder.nativeOrder()) { "Audio buffer must be in native byte order" }
+    return asFloatBuffer()
+}
+
+private fun transcribeDirect(contextPtr: Long, statePtr: Long, buffer: FloatBuffer, printTimestamp: Boolean): String {
+    require(buffer.isDirect) { "Audio buffer must be direct" }
+    val numThreads = WhisperCpuConfig.preferredThreadCount
+    Log.d(LOG_TAG, "Selecting $numThreads threads")
+    if (WhisperLib.fullTranscribeBuffer(contextPtr, statePtr, numThreads, buffer, buffer.position(), buffer.remaining()) != 0) {
+        throw java.lang.RuntimeException("Couldn't transcribe audio")
+    }
+    return readSegments(contextPtr, statePtr, printTimestamp)
+}
+
+private fun readSegments(contextPtr: Long, statePtr: Long, printTimestamp: Boolean): String {
+    val textCount = WhisperLib.getStateSegmentCount(contextPtr, statePtr)
+    return buildString {
+        for (i in 0 until textCount) {
+            if (printTimestamp) {
+                val textTimestamp = "[${toTimestamp(WhisperLib.getStateSegmentT0(contextPtr, statePtr, i))} --> ${toTimestamp(WhisperLib.getStateSegmentT1(contextPtr, statePtr, i))}]"
+                val textSegment = WhisperLib.getStateSegment(contextPtr, statePtr, i)
+                append("$textTimestamp: $textSegment\n")
+            } else {
+                append(WhisperLib.getStateSegment(contextPtr, statePtr, i))
+            }
+        }
+    }
+}
+
 private class WhisperLib {
     companion object {
         init {
             Log.d(LOG_TAG, "Primary ABI: ${Build.SUPPORTED_ABIS[0]}")
             var loadVfpv4 = false
-            var loadV8fp16 = false
             if (isArmEabiV7a()) {
                 // armeabi-v7a needs runtime detection support
                 val cpuInfo = cpuInfo()
@@ -105,31 +195,21 @@ private class WhisperLib {
                         loadVfpv4 = true
                     }
                 }
-            } else if (isArmEabiV8a()) {
-                // ARMv8.2a needs runtime detection support
-                val cpuInfo = cpuInfo()
-                cpuInfo?.let {
-                    Log.d(LOG_TAG, "CPU info: $cpuInfo")
-                    if (cpuInfo.contains("fphp")) {
-                        Log.d(LOG_TAG, "CPU supports fp16 arithmetic")
-                        loadV8fp16 = true
-                    }
-                }
             }
 
             if (loadVfpv4) {
                 Log.d(LOG_TAG, "Loading libwhisper_vfpv4.so")
                 System.loadLibrary("whisper_vfpv4")
-            } else if (loadV8fp16) {
-                Log.d(LOG_TAG, "Loading libwhisper_v8fp16_va.so")
-                System.loadLibrary("whisper_v8fp16_va")
             } else {
+                // On arm64 the CPU backend for the features of the device (dotprod, fp16, i8mm) is picked by ggml
                 Log.d(LOG_TAG, "Loading libwhisper.so")
                 System.loadLibrary("whisper")
             }
+            loadBackends()
         }
 
         // JNI methods
+        external fun loadBackends()
         external fun initContextFromInputStream(inputStream: InputStream): Long
         external fun initContextFromAsset(assetManager: AssetManager, assetPath: String): Long
         external fun initContext(modelPath: String): Long
@@ -139,6 +219,14 @@ private class WhisperLib {
         external fun getTextSegment(contextPtr: Long, index: Int): String
         external fun getTextSegmentT0(contextPtr: Long, index: Int): Long
         external fun getTextSegmentT1(contextPtr: Long, index: Int): Long
+        external fun initState(contextPtr: Long): Long
+        external fun freeState(statePtr: Long)
+        external fun fullTranscribeWithState(contextPtr: Long, statePtr: Long, numThreads: Int, audioData: FloatArray): Int
+        external fun fullTranscribeBuffer(contextPtr: Long, statePtr: Long, numThreads: Int, audioData: FloatBuffer, offset: Int, numSamples: Int): Int
+        external fun getStateSegmentCount(contextPtr: Long, statePtr: Long): Int
+        external fun getStateSegment(contextPtr: Long, statePtr: Long, index: Int): String
+        external fun getStateSegmentT0(contextPtr: Long, statePtr: Long, index: Int): Long
+        external fun getStateSegmentT1(contextPtr: Long, statePtr: Long, index: Int): Long
         external fun getSystemInfo(): String
         external fun benchMemcpy(nthread: Int): String
         external fun benchGgmlMulMat(nthread: Int): String
@@ -164,10 +252,6 @@ private fun isArmEabiV7a(): Boolean {
     return Build.SUPPORTED_ABIS[0].equals("armeabi-v7a")
 }
 
-private fun isArmEabiV8a(): Boolean {
-    return Build.SUPPORTED_ABIS[0].equals("arm64-v8a")
-}
-
 private fun cpuInfo(): String? {
     return try {
         File("/proc/cpuinfo").inputStream().bufferedReader().use {
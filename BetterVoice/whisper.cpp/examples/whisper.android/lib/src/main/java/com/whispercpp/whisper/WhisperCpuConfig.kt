@@ -12,12 +12,24 @@ object WhisperCpuConfig {
 
 private class CpuInfo(private val lines: List<String>) {
     private fun getHighPerfCpuCount(): Int = try {
-        getHighPerfCpuCountByFrequencies()
+        getHighPerfCpuCountByCapacities()
     } catch (e: Exception) {
-        Log.d(LOG_TAG, "Couldn't read CPU frequencies", e)
-        getHighPerfCpuCountByVariant()
+        Log.d(LOG_TAG, "Couldn't read CPU capacities", e)
+        try {
+            getHighPerfCpuCountByFrequencies()
+        } catch (e: Exception) {
+            Log.d(LOG_TAG, "Couldn't read CPU frequencies", e)
+            getHighPerfCpuCountByVariant()
+        }
     }
 
+    // The scheduler's capacity accounts for the core type as well as the frequency, so a little cluster
+    // clocked like the big one is still told apart
+    private fun getHighPerfCpuCountByCapacities(): Int =
+        getCpuValues(property = "processor") { getCpuCapacity(it.toInt()) }
+            .also { Log.d(LOG_TAG, "Binned cpu capacities (capacity, count): ${it.binnedValues()}") }
+            .countDroppingMin()
+
     private fun getHighPerfCpuCountByFrequencies(): Int =
         getCpuValues(property = "processor") { getMaxCpuFrequency(it.toInt()) }
             .also { Log.d(LOG_TAG, "Binned cpu frequencies (frequency, count): ${it.binnedValues()}") }
@@ -64,6 +76,12 @@ private class CpuInfo(private val lines: List<String>) {
                 .useLines { it.toList() }
         )
 
+        private fun getCpuCapacity(cpuIndex: Int): Int {
+            val path = "/sys/devices/system/cpu/cpu${cpuIndex}/cpu_capacity"
+            val capacity = BufferedReader(FileReader(path)).use { it.readLine() }
+            return capacity.toInt()
+        }
+
         private fun getMaxCpuFrequency(cpuIndex: Int): Int {
             val path = "/sys/devices/system/cpu/cpu${cpuIndex}/cpufreq/cpuinfo_max_freq"
             val maxFreq = BufferedReader(FileReader(path)).use { it.readLine() }
@@ -2,11 +2,16 @@
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
+#include <dlfcn.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/sysinfo.h>
 #include <string.h>
 #include "whisper.h"
 #include "ggml.h"
+#include "ggml-backend.h"
 
 #define UNUSED(x) (void)(x)
 #define TAG "JNI"
@@ -141,6 +146,39 @@ Java_com_whispercpp_whisper_WhisperLib_00024Companion_initContextFromAsset(
     return (jlong) context;
 }
 
+#ifdef GGML_BACKEND_DL
+static pthread_once_t backends_once = PTHREAD_ONCE_INIT;
+
+// The CPU backend is built once per Android feature level (dotprod, fp16, i8mm) next to this library;
+// ggml scores them against the device and loads the best one
+static void load_backends(void) {
+    Dl_info info;
+    if (!dladdr((void *) &load_backends, &info) || !info.dli_fname) {
+        LOGW("Couldn't locate libwhisper.so, loading backends from the default paths\n");
+        ggml_backend_load_all();
+        return;
+    }
+    char *path = strdup(info.dli_fname);
+    const char *dir = dirname(path);
+    LOGI("Loading backends from '%s'\n", dir);
+    ggml_backend_load_all_from_path(dir);
+    free(path);
+    if (ggml_backend_dev_count() == 0) {
+        LOGW("No backend found in '%s', are the native libraries extracted?\n", dir);
+    }
+}
+#endif
+
+JNIEXPORT void JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_loadBackends(
+        JNIEnv *env, jobject thiz) {
+    UNUSED(env);
+    UNUSED(thiz);
+#ifdef GGML_BACKEND_DL
+    pthread_once(&backends_once, load_backends);
+#endif
+}
+
 JNIEXPORT jlong JNICALL
 Java_com_whispercpp_whisper_WhisperLib_00024Companion_initContext(
         JNIEnv *env, jobject thiz, jstring model_path_str) {
@@ -161,14 +199,7 @@ Java_com_whispercpp_whisper_WhisperLib_00024Companion_freeContext(
     whisper_free(context);
 }
 
-JNIEXPORT void JNICALL
-Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribe(
-        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads, jfloatArray audio_data) {
-    UNUSED(thiz);
-    struct whisper_context *context = (struct whisper_context *) context_ptr;
-    jfloat *audio_data_arr = (*env)->GetFloatArrayElements(env, audio_data, NULL);
-    const jsize audio_data_length = (*env)->GetArrayLength(env, audio_data);
-
+static struct whisper_full_params transcribe_params(int num_threads) {
     // The below adapted from the Objective-C iOS sample
     struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     params.print_realtime = true;
@@ -181,6 +212,18 @@ Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribe(
     params.offset_ms = 0;
     params.no_context = true;
     params.single_segment = false;
+    return params;
+}
+
+JNIEXPORT void JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribe(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads, jfloatArray audio_data) {
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    jfloat *audio_data_arr = (*env)->GetFloatArrayElements(env, audio_data, NULL);
+    const jsize audio_data_length = (*env)->GetArrayLength(env, audio_data);
+
+    struct whisper_full_params params = transcribe_params(num_threads);
 
     whisper_reset_timings(context);
 
@@ -193,6 +236,110 @@ Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribe(
     (*env)->ReleaseFloatArrayElements(env, audio_data, audio_data_arr, JNI_ABORT);
 }
 
+JNIEXPORT jlong JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_initState(
+        JNIEnv *env, jobject thiz, jlong context_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    return (jlong) whisper_init_state(context);
+}
+
+JNIEXPORT void JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_freeState(
+        JNIEnv *env, jobject thiz, jlong state_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    whisper_free_state((struct whisper_state *) state_ptr);
+}
+
+// A state_ptr of 0 selects the default state of the context
+static struct whisper_state *state_or_default(struct whisper_context *context, jlong state_ptr) {
+    return state_ptr != 0 ? (struct whisper_state *) state_ptr : whisper_get_state(context);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribeWithState(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr, jint num_threads, jfloatArray audio_data) {
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    struct whisper_state *state = state_or_default(context, state_ptr);
+    jfloat *audio_data_arr = (*env)->GetFloatArrayElements(env, audio_data, NULL);
+    const jsize audio_data_length = (*env)->GetArrayLength(env, audio_data);
+
+    const int ret = whisper_full_with_state(context, state, transcribe_params(num_threads), audio_data_arr, audio_data_length);
+    if (ret != 0) {
+        LOGW("Failed to run the model: %d\n", ret);
+    }
+    (*env)->ReleaseFloatArrayElements(env, audio_data, audio_data_arr, JNI_ABORT);
+    return ret;
+}
+
+// Transcribes n_samples floats starting at float index offset of a direct buffer, without copying them
+JNIEXPORT jint JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_fullTranscribeBuffer(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr, jint num_threads,
+        jobject audio_buffer, jint offset, jint n_samples) {
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    struct whisper_state *state = state_or_default(context, state_ptr);
+
+    const float *samples = (const float *) (*env)->GetDirectBufferAddress(env, audio_buffer);
+    const jlong capacity = (*env)->GetDirectBufferCapacity(env, audio_buffer);
+    if (samples == NULL || capacity < 0) {
+        jclass cls = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
+        (*env)->ThrowNew(env, cls, "audio buffer is not a direct buffer");
+        return -1;
+    }
+    if (offset < 0 || n_samples < 0 || (jlong) offset + n_samples > capacity || ((uintptr_t) samples) % sizeof(float) != 0) {
+        jclass cls = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
+        (*env)->ThrowNew(env, cls, "audio buffer range is out of bounds or misaligned");
+        return -1;
+    }
+
+    const int ret = whisper_full_with_state(context, state, transcribe_params(num_threads), samples + offset, n_samples);
+    if (ret != 0) {
+        LOGW("Failed to run the model: %d\n", ret);
+    }
+    return ret;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_getStateSegmentCount(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    return whisper_full_n_segments_from_state(state_or_default(context, state_ptr));
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_getStateSegment(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr, jint index) {
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    const char *text = whisper_full_get_segment_text_from_state(state_or_default(context, state_ptr), index);
+    return (*env)->NewStringUTF(env, text);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_getStateSegmentT0(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr, jint index) {
+    UNUSED(env);
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    return whisper_full_get_segment_t0_from_state(state_or_default(context, state_ptr), index);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_whispercpp_whisper_WhisperLib_00024Companion_getStateSegmentT1(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jlong state_ptr, jint index) {
+    UNUSED(env);
+    UNUSED(thiz);
+    struct whisper_context *context = (struct whisper_context *) context_ptr;
+    return whisper_full_get_segment_t1_from_state(state_or_default(context, state_ptr), index);
+}
+
 JNIEXPORT jint JNICALL
 Java_com_whispercpp_whisper_WhisperLib_00024Companion_getTextSegmentCount(
         JNIEnv *env, jobject thiz, jlong context_ptr) {
@@ -24,7 +24,12 @@ EMSCRIPTEN_BINDINGS(whisper) {
 
         for (size_t i = 0; i < g_contexts.size(); ++i) {
             if (g_contexts[i] == nullptr) {
-                g_contexts[i] = whisper_init_from_file_with_params(path_model.c_str(), whisper_context_default_params());
+                // keep the compute threads between graphs, without polling - spinning web workers compete with the page
+                struct whisper_context_params cparams = whisper_context_default_params();
+                cparams.cpu_threadpool = true;
+                cparams.cpu_poll       = 0;
+
+                g_contexts[i] = whisper_init_from_file_with_params(path_model.c_str(), cparams);
                 if (g_contexts[i] != nullptr) {
                     return i + 1;
                 } else {
@@ -73,7 +78,7 @@ EMSCRIPTEN_BINDINGS(whisper) {
         params.print_special    = false;
         params.translate        = translate;
         params.language         = is_multilingual ? strdup(lang.c_str()) : "en";
-        params.n_threads        = std::min(nthreads, std::min(16, mpow2(std::thread::hardware_concurrency())));
+        params.n_threads        = std::min(nthreads, std::min(WHISPER_WASM_THREADS, mpow2(std::thread::hardware_concurrency())));
         params.offset_ms        = 0;
 
         std::vector<float> pcmf32;
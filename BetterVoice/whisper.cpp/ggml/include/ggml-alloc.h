@@ -66,6 +66,11 @@ GGML_API bool ggml_gallocr_alloc_graph(ggml_gallocr_t galloc, struct ggml_cgraph
 
 GGML_API size_t ggml_gallocr_get_buffer_size(ggml_gallocr_t galloc, int buffer_id);
 
+// pre-allocate a buffer of at least size bytes without a measure graph, e.g. with a size measured in an earlier run
+// graphs that fit are allocated in it without reallocation; sizes above the max size of the buffer type are ignored
+// returns false if the buffer allocation failed
+GGML_API bool ggml_gallocr_reserve_size(ggml_gallocr_t galloc, int buffer_id, size_t size);
+
 // Utils
 // Create a buffer and allocate all the tensors in a ggml_context
 GGML_API struct ggml_backend_buffer * ggml_backend_alloc_ctx_tensors_from_buft(struct ggml_context * ctx, ggml_backend_buffer_type_t buft);
@@ -17,6 +17,11 @@ GGML_BACKEND_API bool ggml_backend_is_blas(ggml_backend_t backend);
 // for openblas and blis, this will also set the number of threads used for blas operations
 GGML_BACKEND_API void ggml_backend_blas_set_n_threads(ggml_backend_t backend_blas, int n_threads);
 
+// keep F32 copies of up to size bytes of the non-F32 weights (buffers with GGML_BACKEND_BUFFER_USAGE_WEIGHTS),
+// converted on first use instead of in every matrix multiplication. The weights must not change while the backend
+// uses them. 0 (the default) disables the cache
+GGML_BACKEND_API void ggml_backend_blas_set_weight_cache(ggml_backend_t backend_blas, size_t size);
+
 GGML_BACKEND_API ggml_backend_reg_t ggml_backend_blas_reg(void);
 
 
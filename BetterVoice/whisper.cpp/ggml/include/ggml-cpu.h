@@ -88,6 +88,7 @@ extern "C" {
     GGML_BACKEND_API int ggml_cpu_has_avx512_vnni(void);
     GGML_BACKEND_API int ggml_cpu_has_avx512_bf16(void);
     GGML_BACKEND_API int ggml_cpu_has_amx_int8   (void);
+    GGML_BACKEND_API int ggml_cpu_has_amx_bf16   (void);
     // ARM
     GGML_BACKEND_API int ggml_cpu_has_neon       (void);
     GGML_BACKEND_API int ggml_cpu_has_arm_fma    (void);
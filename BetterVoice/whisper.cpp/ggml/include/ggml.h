@@ -461,6 +461,7 @@ extern "C" {
         GGML_OP_ADD,
         GGML_OP_ADD_ID,
         GGML_OP_ADD1,
+        GGML_OP_ADD_GELU,
         GGML_OP_ACC,
         GGML_OP_SUB,
         GGML_OP_MUL,
@@ -480,6 +481,7 @@ extern "C" {
         GGML_OP_CONCAT,
         GGML_OP_SILU_BACK,
         GGML_OP_NORM, // normalize
+        GGML_OP_NORM_AFFINE,
         GGML_OP_RMS_NORM,
         GGML_OP_RMS_NORM_BACK,
         GGML_OP_GROUP_NORM,
@@ -512,6 +514,7 @@ extern "C" {
         GGML_OP_IM2COL,
         GGML_OP_IM2COL_BACK,
         GGML_OP_IM2COL_3D,
+        GGML_OP_CONV_1D,
         GGML_OP_CONV_2D,
         GGML_OP_CONV_3D,
         GGML_OP_CONV_2D_DW,
@@ -1107,6 +1110,12 @@ extern "C" {
             struct ggml_context * ctx,
             struct ggml_tensor  * a);
 
+    // change the precision of a ggml_gelu (or a ggml_add_gelu with GGML_UNARY_OP_GELU)
+    // set to GGML_PREC_F32 to have the CPU compute it in F32 with SIMD instead of the F16 lookup table
+    GGML_API void ggml_gelu_set_prec(
+            struct ggml_tensor * a,
+            enum ggml_prec       prec);
+
     GGML_API struct ggml_tensor * ggml_gelu_quick(
             struct ggml_context * ctx,
             struct ggml_tensor  * a);
@@ -1115,6 +1124,15 @@ extern "C" {
             struct ggml_context * ctx,
             struct ggml_tensor  * a);
 
+    // op(ggml_add(a, b)) in a single op, e.g. the bias and the activation after the mul_mat of an MLP
+    // b is a vector of a->ne[0] elements added to every row of a
+    // op is GGML_UNARY_OP_GELU, GGML_UNARY_OP_GELU_ERF or GGML_UNARY_OP_GELU_QUICK, see ggml_gelu_set_prec()
+    GGML_API struct ggml_tensor * ggml_add_gelu(
+            struct ggml_context * ctx,
+            struct ggml_tensor  * a,
+            struct ggml_tensor  * b,
+            enum ggml_unary_op    op);
+
     GGML_API struct ggml_tensor * ggml_silu(
             struct ggml_context * ctx,
             struct ggml_tensor  * a);
@@ -1249,6 +1267,26 @@ extern "C" {
             struct ggml_tensor  * a,
             float                 eps);
 
+    // ggml_add(ggml_mul(ggml_norm(a, eps), w), b) in a single op
+    // w and b are vectors of a->ne[0] elements, b can be NULL
+    GGML_API struct ggml_tensor * ggml_norm_affine(
+            struct ggml_context * ctx,
+            struct ggml_tensor  * a,
+            struct ggml_tensor  * w,
+            struct ggml_tensor  * b,
+            float                 eps);
+
+    // ggml_norm_affine(ggml_add(a, r), w, b, eps) with the sum computed in the op, e.g. the norm after a residual
+    // connection - the norm then does not wait for the residual sum, which the graph may still compute for its
+    // other users. r has the shape of a
+    GGML_API struct ggml_tensor * ggml_add_norm_affine(
+            struct ggml_context * ctx,
+            struct ggml_tensor  * a,
+            struct ggml_tensor  * r,
+            struct ggml_tensor  * w,
+            struct ggml_tensor  * b,
+            float                 eps);
+
     GGML_API struct ggml_tensor * ggml_rms_norm(
             struct ggml_context * ctx,
             struct ggml_tensor  * a,
@@ -1857,6 +1895,21 @@ extern "C" {
             int                   s0,  // stride
             int                   d0); // dilation
 
+    // direct conv_1d without the im2col tensor, optionally followed by the bias and a GELU activation
+    // a:    [K, IC, OC] (F16 or F32)
+    // b:    [L, IC, N]  (F32)
+    // bias: OC elements (F32), or NULL
+    // res:  [OL, OC, N]
+    GGML_API struct ggml_tensor * ggml_conv_1d_direct(
+            struct ggml_context * ctx,
+            struct ggml_tensor  * a,     // convolution kernel
+            struct ggml_tensor  * b,     // data
+            struct ggml_tensor  * bias,  // added to each output channel
+            int                   s0,    // stride
+            int                   p0,    // padding
+            int                   d0,    // dilation
+            bool                  gelu); // apply ggml_gelu to the result
+
     GGML_API struct ggml_tensor * ggml_conv_transpose_1d(
             struct ggml_context * ctx,
             struct ggml_tensor  * a,   // convolution kernel
@@ -31,6 +31,7 @@ bool ggml_op_can_inplace(enum ggml_op op) {
         case GGML_OP_ADD:
         case GGML_OP_ADD_ID:
         case GGML_OP_ADD1:
+        case GGML_OP_ADD_GELU:
         case GGML_OP_SUB:
         case GGML_OP_MUL:
         case GGML_OP_DIV:
@@ -503,6 +504,10 @@ struct ggml_gallocr {
 
     struct leaf_alloc * leaf_allocs; // [n_leafs]
     int n_leafs;
+
+    // fingerprint of the last graph allocated with the current assignments
+    uint64_t graph_hash;
+    bool graph_hash_valid;
 };
 
 ggml_gallocr_t ggml_gallocr_new_n(ggml_backend_buffer_type_t * bufts, int n_bufs) {
@@ -798,6 +803,8 @@ static void ggml_gallocr_alloc_graph_impl(ggml_gallocr_t galloc, struct ggml_cgr
 }
 
 bool ggml_gallocr_reserve_n(ggml_gallocr_t galloc, struct ggml_cgraph * graph, const int * node_buffer_ids, const int * leaf_buffer_ids) {
+    galloc->graph_hash_valid = false;
+
     size_t min_hash_size = graph->n_nodes + graph->n_leafs;
     // add 25% margin to avoid hash collisions
     min_hash_size += min_hash_size / 4;
@@ -889,7 +896,9 @@ bool ggml_gallocr_reserve_n(ggml_gallocr_t galloc, struct ggml_cgraph * graph, c
         size_t new_size = ggml_dyn_tallocr_max_size(galloc->buf_tallocs[i]);
 
         // even if there are no tensors allocated in this buffer, we still need to allocate it to initialize views
-        if (new_size > cur_size || galloc->buffers[i] == NULL) {
+        // a buffer pre-allocated with ggml_gallocr_reserve_size has a single chunk
+        if (new_size > cur_size || galloc->buffers[i] == NULL ||
+            ggml_vbuffer_n_chunks(galloc->buffers[i]) < galloc->buf_tallocs[i]->n_chunks) {
 #ifndef NDEBUG
             GGML_LOG_DEBUG("%s: reallocating %s buffer from size %.02f MiB to %.02f MiB\n", __func__, ggml_backend_buft_name(galloc->bufts[i]), cur_size / 1024.0 / 1024.0, new_size / 1024.0 / 1024.0);
 #endif
@@ -992,8 +1001,50 @@ static bool ggml_gallocr_needs_realloc(ggml_gallocr_t galloc, struct ggml_cgraph
     return false;
 }
 
+// FNV-1a over everything ggml_gallocr_needs_realloc looks at: the ops, which tensors need an allocation and their
+// shapes. Graphs rebuilt for every token (e.g. the decoder of whisper) usually hash the same as the previous one
+static uint64_t ggml_gallocr_hash_combine(uint64_t h, uint64_t v) {
+    return (h ^ v) * 0x100000001b3ULL;
+}
+
+static uint64_t ggml_gallocr_hash_tensor(uint64_t h, const struct ggml_tensor * t) {
+    if (t == NULL) {
+        return ggml_gallocr_hash_combine(h, 0);
+    }
+    if (t->data || t->view_src) {
+        return ggml_gallocr_hash_combine(h, 1);
+    }
+    h = ggml_gallocr_hash_combine(h, 2 + (uint64_t) t->type);
+    for (int i = 0; i < GGML_MAX_DIMS; i++) {
+        h = ggml_gallocr_hash_combine(h, (uint64_t) t->ne[i]);
+    }
+    return h;
+}
+
+static uint64_t ggml_gallocr_graph_hash(const struct ggml_cgraph * graph) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = ggml_gallocr_hash_combine(h, (uint64_t) graph->n_nodes);
+    h = ggml_gallocr_hash_combine(h, (uint64_t) graph->n_leafs);
+    for (int i = 0; i < graph->n_leafs; i++) {
+        h = ggml_gallocr_hash_tensor(h, graph->leafs[i]);
+    }
+    for (int i = 0; i < graph->n_nodes; i++) {
+        const struct ggml_tensor * node = graph->nodes[i];
+        h = ggml_gallocr_hash_combine(h, (uint64_t) node->op);
+        h = ggml_gallocr_hash_tensor(h, node);
+        for (int j = 0; j < GGML_MAX_SRC; j++) {
+            h = ggml_gallocr_hash_tensor(h, node->src[j]);
+        }
+    }
+    return h;
+}
+
 bool ggml_gallocr_alloc_graph(ggml_gallocr_t galloc, struct ggml_cgraph * graph) {
-    if (ggml_gallocr_needs_realloc(galloc, graph)) {
+    // a graph with the same fingerprint as the last one fits the current assignments, skip checking every tensor
+    const uint64_t graph_hash = ggml_gallocr_graph_hash(graph);
+    const bool same_graph = galloc->graph_hash_valid && galloc->graph_hash == graph_hash;
+
+    if (!same_graph && ggml_gallocr_needs_realloc(galloc, graph)) {
         if (galloc->n_buffers == 1) {
 #ifndef NDEBUG
             GGML_LOG_DEBUG("%s: reallocating buffers automatically\n", __func__);
@@ -1037,6 +1088,9 @@ bool ggml_gallocr_alloc_graph(ggml_gallocr_t galloc, struct ggml_cgraph * graph)
         ggml_gallocr_init_tensor(galloc, node, &node_alloc->dst);
     }
 
+    galloc->graph_hash = graph_hash;
+    galloc->graph_hash_valid = true;
+
     return true;
 }
 
@@ -1058,6 +1112,47 @@ size_t ggml_gallocr_get_buffer_size(ggml_gallocr_t galloc, int buffer_id) {
     return ggml_vbuffer_size(galloc->buffers[buffer_id]);
 }
 
+bool ggml_gallocr_reserve_size(ggml_gallocr_t galloc, int buffer_id, size_t size) {
+    GGML_ASSERT(buffer_id >= 0 && buffer_id < galloc->n_buffers);
+
+    // the buffer is shared with a previous buffer id of the same type
+    for (int i = 0; i < buffer_id; i++) {
+        if (galloc->buf_tallocs[i] == galloc->buf_tallocs[buffer_id]) {
+            return true;
+        }
+    }
+
+    if (size == 0 || size > ggml_backend_buft_get_max_size(galloc->bufts[buffer_id])) {
+        return true;
+    }
+
+    if (galloc->buffers[buffer_id] != NULL && ggml_vbuffer_size(galloc->buffers[buffer_id]) >= size) {
+        return true;
+    }
+
+    struct vbuffer * buf = (struct vbuffer *)calloc(1, sizeof(struct vbuffer));
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf->chunks[0] = ggml_backend_buft_alloc_buffer(galloc->bufts[buffer_id], size);
+    if (buf->chunks[0] == NULL) {
+        GGML_LOG_ERROR("%s: failed to allocate %s buffer of size %zu\n", __func__, ggml_backend_buft_name(galloc->bufts[buffer_id]), size);
+        free(buf);
+        return false;
+    }
+    ggml_backend_buffer_set_usage(buf->chunks[0], GGML_BACKEND_BUFFER_USAGE_COMPUTE);
+
+    ggml_vbuffer_free(galloc->buffers[buffer_id]);
+    galloc->buffers[buffer_id] = buf;
+
+    // the node allocations refer to the previous buffer
+    galloc->n_nodes = 0;
+    galloc->n_leafs = 0;
+
+    return true;
+}
+
 // utils
 
 static void free_buffers(ggml_backend_buffer_t ** buffers, const size_t * n_buffers) {
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 #ifdef __APPLE__
@@ -722,6 +723,9 @@ struct ggml_backend_sched {
 
     bool op_offload;
 
+    // rewrite op chains into fused ops before splitting the graph (GGML_SCHED_NO_FUSION=1 disables it)
+    bool graph_fusion;
+
     int debug;
 };
 
@@ -908,8 +912,202 @@ static void ggml_backend_sched_set_if_supported(ggml_backend_sched_t sched, stru
     }
 }
 
+// rewrite op chains of the graph into fused ops supported by the highest priority backend
+// only intermediate results that no other node reads are fused away, the tensors the user reads keep their values
+//
+// patterns:
+//   add(mul(norm(x), w), b)  -> norm_affine(x, w, b)
+//   norm_affine(add(a, r))   -> add_norm_affine(a, r), the add is kept if other nodes read it (e.g. a residual)
+//   gelu(add(x, b))          -> add_gelu(x, b), for the gelu, gelu_erf and gelu_quick unary ops
+//
+static void ggml_backend_sched_fuse_graph(ggml_backend_sched_t sched, struct ggml_cgraph * graph) {
+    // the eval callback observes every node, and the backward pass needs the intermediate results
+    if (!sched->graph_fusion || sched->callback_eval != NULL || graph->grads != NULL) {
+        return;
+    }
+
+    // number of nodes reading each tensor
+    std::unordered_map<const ggml_tensor *, int> n_uses;
+    for (int i = 0; i < graph->n_nodes; i++) {
+        for (int j = 0; j < GGML_MAX_SRC; j++) {
+            if (graph->nodes[i]->src[j]) {
+                n_uses[graph->nodes[i]->src[j]]++;
+            }
+        }
+    }
+
+    const auto is_intermediate = [&](const ggml_tensor * t) {
+        return n_uses[t] == 1 && t->view_src == NULL && !(t->flags & GGML_TENSOR_FLAG_OUTPUT);
+    };
+
+    // a vector applied to every row of t
+    const auto is_row_vector = [](const ggml_tensor * v, const ggml_tensor * t) {
+        return v->type == GGML_TYPE_F32 && ggml_is_contiguous(v) && ggml_nelements(v) == t->ne[0];
+    };
+
+    std::vector<bool> removed(graph->n_nodes, false);
+
+    int n_fused = 0;
+
+    for (int i = 0; i < graph->n_nodes; i++) {
+        ggml_tensor * node = graph->nodes[i];
+
+        if (node->op != GGML_OP_ADD || node->view_src != NULL || node->type != GGML_TYPE_F32) {
+            continue;
+        }
+
+        ggml_tensor * mul  = node->src[0];
+        ggml_tensor * bias = node->src[1];
+        if (mul->op != GGML_OP_MUL || !is_intermediate(mul) || !is_row_vector(bias, node)) {
+            continue;
+        }
+
+        ggml_tensor * norm   = mul->src[0];
+        ggml_tensor * weight = mul->src[1];
+        if (norm->op != GGML_OP_NORM || !is_intermediate(norm) || !is_row_vector(weight, node)) {
+            continue;
+        }
+
+        if (!ggml_are_same_shape(norm, node) || norm->src[0]->type != GGML_TYPE_F32) {
+            continue;
+        }
+
+        // turn the add into the fused op, keeping it if the backend does not support it
+        const ggml_tensor saved = *node;
+
+        memcpy(node->op_params, norm->op_params, sizeof(node->op_params));
+
+        node->op     = GGML_OP_NORM_AFFINE;
+        node->src[0] = norm->src[0];
+        node->src[1] = weight;
+        node->src[2] = bias;
+
+        if (!ggml_backend_supports_op(sched->backends[0], node)) {
+            *node = saved;
+            continue;
+        }
+
+        for (int j = 0; j < i; j++) {
+            if (graph->nodes[j] == norm || graph->nodes[j] == mul) {
+                removed[j] = true;
+            }
+        }
+
+        n_fused++;
+    }
+
+    // the sum feeding a norm_affine, computed again in the norm while the add stays for its other readers
+    for (int i = 0; i < graph->n_nodes; i++) {
+        ggml_tensor * node = graph->nodes[i];
+
+        if (removed[i] || node->op != GGML_OP_NORM_AFFINE || node->src[3] != NULL) {
+            continue;
+        }
+
+        ggml_tensor * add = node->src[0];
+        if (add->op != GGML_OP_ADD || add->view_src != NULL || add->type != GGML_TYPE_F32) {
+            continue;
+        }
+
+        ggml_tensor * a = add->src[0];
+        ggml_tensor * r = add->src[1];
+        if (a->type != GGML_TYPE_F32 || r->type != GGML_TYPE_F32 ||
+            !ggml_are_same_shape(a, add) || !ggml_are_same_shape(r, add) ||
+            a->nb[0] != sizeof(float) || r->nb[0] != sizeof(float)) {
+            continue;
+        }
+
+        const bool drop = is_intermediate(add);
+
+        node->src[0] = a;
+        node->src[3] = r;
+
+        if (!ggml_backend_supports_op(sched->backends[0], node)) {
+            node->src[0] = add;
+            node->src[3] = NULL;
+            continue;
+        }
+
+        n_uses[a]++;
+        n_uses[r]++;
+        n_uses[add]--;
+
+        if (drop) {
+            for (int j = 0; j < i; j++) {
+                if (graph->nodes[j] == add) {
+                    removed[j] = true;
+                }
+            }
+        }
+
+        n_fused++;
+    }
+
+    for (int i = 0; i < graph->n_nodes; i++) {
+        ggml_tensor * node = graph->nodes[i];
+
+        if (removed[i] || node->op != GGML_OP_UNARY || node->type != GGML_TYPE_F32) {
+            continue;
+        }
+
+        const ggml_unary_op op = ggml_get_unary_op(node);
+        if (op != GGML_UNARY_OP_GELU && op != GGML_UNARY_OP_GELU_ERF && op != GGML_UNARY_OP_GELU_QUICK) {
+            continue;
+        }
+
+        ggml_tensor * add = node->src[0];
+        if (add->op != GGML_OP_ADD || !is_intermediate(add) || add->type != GGML_TYPE_F32) {
+            continue;
+        }
+
+        ggml_tensor * x    = add->src[0];
+        ggml_tensor * bias = add->src[1];
+        if (x->type != GGML_TYPE_F32 || !ggml_are_same_shape(x, node) || !is_row_vector(bias, node)) {
+            continue;
+        }
+
+        // the op_params of the unary op (op and precision) are those of add_gelu
+        node->op     = GGML_OP_ADD_GELU;
+        node->src[0] = x;
+        node->src[1] = bias;
+
+        if (!ggml_backend_supports_op(sched->backends[0], node)) {
+            node->op     = GGML_OP_UNARY;
+            node->src[0] = add;
+            node->src[1] = NULL;
+            continue;
+        }
+
+        for (int j = 0; j < i; j++) {
+            if (graph->nodes[j] == add) {
+                removed[j] = true;
+            }
+        }
+
+        n_fused++;
+    }
+
+    if (n_fused == 0) {
+        return;
+    }
+
+    int n_nodes = 0;
+    for (int i = 0; i < graph->n_nodes; i++) {
+        if (!removed[i]) {
+            graph->nodes[n_nodes++] = graph->nodes[i];
+        }
+    }
+    graph->n_nodes = n_nodes;
+
+    if (sched->debug > 1) {
+        GGML_LOG_DEBUG("%s: fused %d op chains\n", __func__, n_fused);
+    }
+}
+
 // assigns backends to ops and splits the graph into subgraphs that can be computed on the same backend
 void ggml_backend_sched_split_graph(ggml_backend_sched_t sched, struct ggml_cgraph * graph) {
+    ggml_backend_sched_fuse_graph(sched, graph);
+
     // reset splits
     sched->n_splits = 0;
     sched->n_graph_inputs = 0;
@@ -1614,6 +1812,7 @@ ggml_backend_sched_t ggml_backend_sched_new(
 
     const char * GGML_SCHED_DEBUG = getenv("GGML_SCHED_DEBUG");
     sched->debug = GGML_SCHED_DEBUG ? atoi(GGML_SCHED_DEBUG) : 0;
+    sched->graph_fusion = getenv("GGML_SCHED_NO_FUSION") == nullptr;
     sched->n_backends = n_backends;
     sched->n_copies = parallel ? GGML_SCHED_MAX_COPIES : 1;
 
@@ -1809,6 +2008,15 @@ size_t ggml_backend_sched_get_buffer_size(ggml_backend_sched_t sched, ggml_backe
     return ggml_gallocr_get_buffer_size(sched->galloc, backend_index);
 }
 
+bool ggml_backend_sched_reserve_size(ggml_backend_sched_t sched, ggml_backend_t backend, size_t size) {
+    GGML_ASSERT(sched);
+    int backend_index = ggml_backend_sched_backend_id(sched, backend);
+    GGML_ASSERT(backend_index >= 0 && backend_index < sched->n_backends);
+    GGML_ASSERT(sched->n_copies == 1 && "pre-allocation is not supported with parallel copies");
+
+    return ggml_gallocr_reserve_size(sched->galloc, backend_index, size);
+}
+
 void ggml_backend_sched_set_tensor_backend(ggml_backend_sched_t sched, struct ggml_tensor * node, ggml_backend_t backend) {
     GGML_ASSERT(sched);
     int backend_index = ggml_backend_sched_backend_id(sched, backend);
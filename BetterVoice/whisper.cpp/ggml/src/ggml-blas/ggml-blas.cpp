@@ -3,6 +3,7 @@
 #include "ggml-backend-impl.h"
 
 #include <future>
+#include <unordered_map>
 #include <vector>
 #include <cstring>
 
@@ -18,6 +19,13 @@
 #   include <cblas.h>
 #endif
 
+// F32 copy of a weight matrix, in the layout of the work buffer of ggml_backend_blas_mul_mat
+struct ggml_backend_blas_weight {
+    enum ggml_type type;
+    size_t nbytes;
+    std::vector<float> data;
+};
+
 struct ggml_backend_blas_context {
     int n_threads = GGML_DEFAULT_N_THREADS;
     std::unique_ptr<char[]> work_data;
@@ -25,8 +33,103 @@ struct ggml_backend_blas_context {
 #ifndef GGML_USE_OPENMP
     std::vector<std::future<void>> tasks;
 #endif
+
+    // F32 copies of the weights by their data, up to weights_max bytes, see ggml_backend_blas_set_weight_cache
+    std::unordered_map<const void *, ggml_backend_blas_weight> weights;
+    size_t weights_size = 0;
+    size_t weights_max = 0;
 };
 
+// convert src0 to float, plane (i02, i03) at wdata + (i03*ne02 + i02)*ne01*ne00
+static void ggml_backend_blas_to_float(ggml_backend_blas_context * ctx, const struct ggml_tensor * src0, float * wdata) {
+    GGML_TENSOR_LOCALS(int64_t, ne0, src0, ne)
+    GGML_TENSOR_LOCALS(size_t,  nb0, src0, nb)
+
+    const int64_t ne_plane = ne01*ne00;
+
+    const auto * type_traits = ggml_get_type_traits(src0->type);
+    ggml_to_float_t const to_float = type_traits->to_float;
+
+    for (int64_t i03 = 0; i03 < ne03; i03++) {
+        for (int64_t i02 = 0; i02 < ne02; i02++) {
+            const void  *       x      = (char *)  src0->data + i02*nb02          + i03*nb03;
+                  float * const wplane = (float *) wdata      + i02*ne_plane      + i03*ne02*ne_plane;
+
+            const int min_cols_per_thread = 4096;
+            const int min_rows_per_thread = std::max((int)(min_cols_per_thread/ne00), 1);
+            const int n_threads = std::max(std::min(ctx->n_threads, (int)(ne01/min_rows_per_thread)), 1);
+
+#ifdef GGML_USE_OPENMP
+            #pragma omp parallel for num_threads(n_threads)
+            for (int64_t i01 = 0; i01 < ne01; i01++) {
+                to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
+            }
+#else
+            for (int i = 1; i < n_threads; i++) {
+                const int64_t start =       i*ne01/n_threads;
+                const int64_t end   = (i + 1)*ne01/n_threads;
+                if (start < end) {
+                    ctx->tasks.push_back(std::async(std::launch::async, [=]() {
+                        for (int64_t i01 = start; i01 < end; i01++) {
+                            to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
+                        }
+                    }));
+                }
+            }
+            {
+                // reuse the current thread for the first task
+                const int64_t start = 0;
+                const int64_t end   = ne01/n_threads;
+                for (int64_t i01 = start; i01 < end; i01++) {
+                    to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
+                }
+            }
+#endif
+        }
+    }
+
+#ifndef GGML_USE_OPENMP
+    // wait for all tasks to finish
+    for (auto & task : ctx->tasks) {
+        task.get();
+    }
+    ctx->tasks.clear();
+#endif
+}
+
+// the cached F32 copy of a weight matrix, converted on first use - NULL if src0 is not a weight or over the budget
+static const float * ggml_backend_blas_get_weight(ggml_backend_blas_context * ctx, const struct ggml_tensor * src0) {
+    if (ctx->weights_max == 0 || src0->buffer == NULL ||
+        ggml_backend_buffer_get_usage(src0->buffer) != GGML_BACKEND_BUFFER_USAGE_WEIGHTS) {
+        return NULL;
+    }
+
+    auto it = ctx->weights.find(src0->data);
+    if (it != ctx->weights.end()) {
+        if (it->second.type == src0->type && it->second.nbytes == ggml_nbytes(src0)) {
+            return it->second.data.data();
+        }
+        // another tensor at the same address, e.g. the weights were reloaded
+        ctx->weights_size -= it->second.data.size()*sizeof(float);
+        ctx->weights.erase(it);
+    }
+
+    const size_t size = ggml_nelements(src0)*sizeof(float);
+    if (ctx->weights_size + size > ctx->weights_max) {
+        return NULL;
+    }
+
+    ggml_backend_blas_weight & weight = ctx->weights[src0->data];
+    weight.type   = src0->type;
+    weight.nbytes = ggml_nbytes(src0);
+    weight.data.resize(ggml_nelements(src0));
+
+    ggml_backend_blas_to_float(ctx, src0, weight.data.data());
+    ctx->weights_size += size;
+
+    return weight.data.data();
+}
+
 static void ggml_backend_blas_mul_mat(ggml_backend_blas_context * ctx, struct ggml_tensor * dst) {
     const struct ggml_tensor * src0 = dst->src[0];
     const struct ggml_tensor * src1 = dst->src[1];
@@ -54,65 +157,24 @@ static void ggml_backend_blas_mul_mat(ggml_backend_blas_context * ctx, struct gg
     const int64_t r2 = ne12/ne02;
     const int64_t r3 = ne13/ne03;
 
-    const int64_t ne_plane      = ne01*ne00;
-    const size_t  desired_wsize = type == GGML_TYPE_F32 ? 0 : ne03*ne02*ne_plane*sizeof(float);
+    const int64_t ne_plane = ne01*ne00;
 
-    if (ctx->work_size < desired_wsize) {
-        ctx->work_data.reset(new char[desired_wsize]);
-        ctx->work_size = desired_wsize;
-    }
-    void * wdata = ctx->work_data.get();
+    const float * wdata = NULL;
 
-    // convert src0 to float
     if (type != GGML_TYPE_F32) {
-        const auto * type_traits = ggml_get_type_traits(type);
-        ggml_to_float_t const to_float = type_traits->to_float;
-
-        for (int64_t i03 = 0; i03 < ne03; i03++) {
-            for (int64_t i02 = 0; i02 < ne02; i02++) {
-                const void  *       x      = (char *)  src0->data + i02*nb02          + i03*nb03;
-                      float * const wplane = (float *) wdata      + i02*ne_plane      + i03*ne02*ne_plane;
+        wdata = ggml_backend_blas_get_weight(ctx, src0);
+    }
 
-                const int min_cols_per_thread = 4096;
-                const int min_rows_per_thread = std::max((int)(min_cols_per_thread/ne00), 1);
-                const int n_threads = std::max(std::min(ctx->n_threads, (int)(ne01/min_rows_per_thread)), 1);
+    if (type != GGML_TYPE_F32 && wdata == NULL) {
+        const size_t desired_wsize = ne03*ne02*ne_plane*sizeof(float);
 
-#ifdef GGML_USE_OPENMP
-                #pragma omp parallel for num_threads(n_threads)
-                for (int64_t i01 = 0; i01 < ne01; i01++) {
-                    to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
-                }
-#else
-                for (int i = 1; i < n_threads; i++) {
-                    const int64_t start =       i*ne01/n_threads;
-                    const int64_t end   = (i + 1)*ne01/n_threads;
-                    if (start < end) {
-                        ctx->tasks.push_back(std::async(std::launch::async, [=]() {
-                            for (int64_t i01 = start; i01 < end; i01++) {
-                                to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
-                            }
-                        }));
-                    }
-                }
-                {
-                    // reuse the current thread for the first task
-                    const int64_t start = 0;
-                    const int64_t end   = ne01/n_threads;
-                    for (int64_t i01 = start; i01 < end; i01++) {
-                        to_float((const char *) x + i01*nb01, wplane + i01*ne00, ne00);
-                    }
-                }
-#endif
-            }
+        if (ctx->work_size < desired_wsize) {
+            ctx->work_data.reset(new char[desired_wsize]);
+            ctx->work_size = desired_wsize;
         }
 
-#ifndef GGML_USE_OPENMP
-        // wait for all tasks to finish
-        for (auto & task : ctx->tasks) {
-            task.get();
-        }
-        ctx->tasks.clear();
-#endif
+        ggml_backend_blas_to_float(ctx, src0, (float *) ctx->work_data.get());
+        wdata = (const float *) ctx->work_data.get();
     }
 
 #if defined(OPENBLAS_VERSION)
@@ -137,7 +199,7 @@ static void ggml_backend_blas_mul_mat(ggml_backend_blas_context * ctx, struct gg
                   float * d = (float *) ((char *)  dst->data + i12*nb2  + i13*nb3);
 
             if (type != GGML_TYPE_F32) {
-                x = (float *) wdata + i02*ne_plane + i03*ne02*ne_plane;
+                x = wdata + i02*ne_plane + i03*ne02*ne_plane;
             }
 
             cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
@@ -312,6 +374,18 @@ void ggml_backend_blas_set_n_threads(ggml_backend_t backend_blas, int n_threads)
     ctx->n_threads = n_threads;
 }
 
+void ggml_backend_blas_set_weight_cache(ggml_backend_t backend_blas, size_t size) {
+    GGML_ASSERT(ggml_backend_is_blas(backend_blas));
+
+    ggml_backend_blas_context * ctx = (ggml_backend_blas_context *)backend_blas->context;
+    ctx->weights_max = size;
+
+    if (ctx->weights_size > size) {
+        ctx->weights.clear();
+        ctx->weights_size = 0;
+    }
+}
+
 // device interface
 
 static const char * ggml_backend_blas_device_get_name(ggml_backend_dev_t dev) {
@@ -492,6 +566,9 @@ static void * ggml_backend_blas_get_proc_address(ggml_backend_reg_t reg, const c
     if (std::strcmp(name, "ggml_backend_set_n_threads") == 0) {
         return (void *)ggml_backend_blas_set_n_threads;
     }
+    if (std::strcmp(name, "ggml_backend_blas_set_weight_cache") == 0) {
+        return (void *)ggml_backend_blas_set_weight_cache;
+    }
     return NULL;
 
     GGML_UNUSED(reg);
@@ -66,7 +66,7 @@ static void ggml_backend_amx_buffer_memset_tensor(ggml_backend_buffer_t buffer,
 
 static void ggml_backend_amx_buffer_set_tensor(ggml_backend_buffer_t buffer, struct ggml_tensor * tensor,
                                                const void * data, size_t offset, size_t size) {
-    if (qtype_has_amx_kernels(tensor->type)) {
+    if (qtype_has_amx_kernels(tensor->type) || ftype_has_amx_kernels(tensor->type)) {
         GGML_LOG_DEBUG("%s: amx repack tensor %s of type %s\n", __func__, tensor->name, ggml_type_name(tensor->type));
         ggml_backend_amx_convert_weight(tensor, data, offset, size);
     } else {
@@ -150,7 +150,9 @@ class extra_buffer_type : ggml::cpu::extra_buffer_type {
             is_contiguous_2d(op->src[1]) &&                               // src1 must be contiguous
             op->src[0]->buffer && op->src[0]->buffer->buft == ggml_backend_amx_buffer_type() &&
             op->ne[0] % (TILE_N * 2) == 0 &&                              // out_features is 32x
-            (qtype_has_amx_kernels(op->src[0]->type) || (op->src[0]->type == GGML_TYPE_F16))) {
+            op->src[0]->ne[0] % TILE_K == 0 &&                            // in_features is 32x
+            (qtype_has_amx_kernels(op->src[0]->type) || ftype_has_amx_kernels(op->src[0]->type) ||
+             (op->src[0]->type == GGML_TYPE_F16))) {
             // src1 must be host buffer
             if (op->src[1]->buffer && !ggml_backend_buft_is_host(op->src[1]->buffer->buft)) {
                 return false;
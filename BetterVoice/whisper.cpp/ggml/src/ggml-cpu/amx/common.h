@@ -89,3 +89,14 @@ inline bool qtype_has_amx_kernels(const enum ggml_type type) {
         (type == GGML_TYPE_Q6_K) ||
         (type == GGML_TYPE_IQ4_XS);
 }
+
+// floating types that have AMX support, packed to BF16 for the AMX-BF16 tiles
+inline bool ftype_has_amx_kernels(const enum ggml_type type) {
+#if defined(__AMX_BF16__) && defined(__AVX512BF16__)
+    return (type == GGML_TYPE_F16) ||
+        (type == GGML_TYPE_BF16);
+#else
+    GGML_UNUSED(type);
+    return false;
+#endif
+}
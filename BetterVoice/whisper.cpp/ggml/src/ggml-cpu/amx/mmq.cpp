@@ -2297,6 +2297,132 @@ void tinygemm_kernel_amx(int M, int N, int KB, const void * RESTRICT _A, const v
     return;
 }
 
+#if defined(__AMX_BF16__) && defined(__AVX512BF16__)
+
+// Notes: bf16 gemm with amx
+//
+// F16 and BF16 weights are converted to BF16 when they are loaded, and the F32 input is converted to BF16 before
+// the gemm. The tile config above is kept: a tile of A holds TILE_K bytes of each row, i.e. 16 BF16 values of K,
+// and a tile of B the matching 8 rows of BF16 pairs (vnni_blk is 2 for _tile_dpbf16ps):
+//    packed_B: from {n, k} to {n/TILE_N, k/TILE_K_BF16, TILE_K_BF16/2, TILE_N, 2}
+//
+constexpr int TILE_K_BF16    = TILE_K / sizeof(ggml_bf16_t);
+constexpr int TILE_SIZE_BF16 = TILE_N * TILE_K_BF16;
+
+inline ggml_bf16_t to_bf16(ggml_fp16_t x) { return GGML_FP32_TO_BF16(GGML_CPU_FP16_TO_FP32(x)); }
+inline ggml_bf16_t to_bf16(ggml_bf16_t x) { return x; }
+
+template <typename TB>
+void convert_B_packed_bf16(ggml_bf16_t * RESTRICT packed_B, const TB * RESTRICT B, int N, int K) {
+    const int KB = K / TILE_K_BF16;
+
+    for (int n = 0; n < N; ++n) {
+        const int nb = n / TILE_N;
+        for (int k = 0; k < K; ++k) {
+            const int kb = k / TILE_K_BF16;
+            const int k2 = (k % TILE_K_BF16) / 2;
+            packed_B[PACKED_INDEX(nb, kb, KB, TILE_SIZE_BF16) + (k2 * TILE_N + n % TILE_N) * 2 + k % 2] = to_bf16(B[n * K + k]);
+        }
+    }
+}
+
+inline void from_float_bf16(const float * RESTRICT x, ggml_bf16_t * RESTRICT y, int K) {
+    for (int k = 0; k < K; k += TILE_K_BF16) {
+        const __m256bh vy = _mm512_cvtneps_pbh(_mm512_loadu_ps(x + k));
+        _mm256_storeu_si256((__m256i *)(y + k), (__m256i)vy);
+    }
+}
+
+// C {M, 2 * TILE_N} = A {M, K} * B, the 2-2-4 tile pattern of the quantized types; A has 2 * TILE_M readable rows
+void tinygemm_kernel_amx_bf16(int M, int KB, const ggml_bf16_t * RESTRICT A, int lda, const ggml_bf16_t * RESTRICT B, float * RESTRICT C, int ldc) {
+    GGML_ASSERT(M <= 2 * TILE_M);
+
+    const int m0 = std::min(M, TILE_M);
+    const int m1 = std::max(M - TILE_M, 0);
+
+    static thread_local float Tile4[TILE_M * TILE_N];
+    static thread_local float Tile5[TILE_M * TILE_N];
+    static thread_local float Tile6[TILE_M * TILE_N];
+    static thread_local float Tile7[TILE_M * TILE_N];
+
+    _tile_zero(TMM4);
+    _tile_zero(TMM5);
+    _tile_zero(TMM6);
+    _tile_zero(TMM7);
+
+    for (int i = 0; i < KB; ++i) {
+        _tile_loadd(TMM0, B + PACKED_INDEX(0, i, KB, TILE_SIZE_BF16), TILE_N * 2 * sizeof(ggml_bf16_t));
+        _tile_loadd(TMM1, B + PACKED_INDEX(1, i, KB, TILE_SIZE_BF16), TILE_N * 2 * sizeof(ggml_bf16_t));
+
+        _tile_loadd(TMM2, A + i * TILE_K_BF16, lda * sizeof(ggml_bf16_t));
+        _tile_dpbf16ps(TMM4, TMM2, TMM0);
+        _tile_dpbf16ps(TMM6, TMM2, TMM1);
+
+        if (m1 != 0) {
+            _tile_loadd(TMM3, A + TILE_M * lda + i * TILE_K_BF16, lda * sizeof(ggml_bf16_t));
+            _tile_dpbf16ps(TMM5, TMM3, TMM0);
+            _tile_dpbf16ps(TMM7, TMM3, TMM1);
+        }
+    }
+
+    auto store_C = [&](const float * RESTRICT tile, float * RESTRICT c, int nr) {
+        for (int m = 0; m < nr; ++m) {
+            _mm512_storeu_ps(c + m * ldc, _mm512_loadu_ps(tile + m * TILE_N));
+        }
+    };
+
+    _tile_stored(TMM4, Tile4, TILE_N * sizeof(float));
+    _tile_stored(TMM6, Tile6, TILE_N * sizeof(float));
+    store_C(Tile4, C, m0);
+    store_C(Tile6, C + TILE_N, m0);
+
+    if (m1 != 0) {
+        _tile_stored(TMM5, Tile5, TILE_N * sizeof(float));
+        _tile_stored(TMM7, Tile7, TILE_N * sizeof(float));
+        store_C(Tile5, C + TILE_M * ldc, m1);
+        store_C(Tile7, C + TILE_M * ldc + TILE_N, m1);
+    }
+}
+
+// C {1, BLOCK_N} = A {1, K} * B for a single row, with avx512-bf16 on the packed B
+template <int BLOCK_N>
+void tinygemv_kernel_bf16(int KB, const ggml_bf16_t * RESTRICT A, const ggml_bf16_t * RESTRICT B, float * RESTRICT C) {
+    constexpr int COLS = BLOCK_N / TILE_N;
+
+    __m512 vc[COLS];
+
+    auto loadc = [&](auto col) {
+        vc[col] = _mm512_setzero_ps();
+    };
+    Unroll<COLS>{}(loadc);
+
+    for (int i = 0; i < KB; ++i) {
+        for (int k = 0; k < TILE_K_BF16 / 2; ++k) {
+            int32_t a;
+            memcpy(&a, A + i * TILE_K_BF16 + 2 * k, sizeof(a));
+            const __m512bh va = (__m512bh)_mm512_set1_epi32(a);
+
+            auto compute = [&](auto col) {
+                const __m512bh vb = (__m512bh)_mm512_loadu_si512(B + PACKED_INDEX(col, i, KB, TILE_SIZE_BF16) + k * TILE_N * 2);
+                vc[col] = _mm512_dpbf16_ps(vc[col], va, vb);
+            };
+            Unroll<COLS>{}(compute);
+        }
+    }
+
+    auto storec = [&](auto col) {
+        _mm512_storeu_ps(C + col * TILE_N, vc[col]);
+    };
+    Unroll<COLS>{}(storec);
+}
+
+#define LAUNCH_TINYGEMV_KERNEL_BF16(NB_SIZE)                                         \
+    tinygemv_kernel_bf16<NB_SIZE>(                                                  \
+        KB, A, B + PACKED_INDEX(nb_start / TILE_N, 0, KB, TILE_SIZE_BF16),           \
+        (float *) dst->data + nb_start);
+
+#endif // defined(__AMX_BF16__) && defined(__AVX512BF16__)
+
 } // anonymous namespace
 
 // get the packed tensor size for quantized weights
@@ -2317,7 +2443,7 @@ size_t ggml_backend_amx_get_alloc_size(const struct ggml_tensor * tensor) {
     if (qtype_has_amx_kernels(TYPE)) {
         return get_tensor_size();
     } else {
-        // for f16, bf16 we don't do packing
+        // f16, bf16 are either not packed or packed to bf16, of the same size
         return ggml_nbytes(tensor);
     }
 }
@@ -2331,6 +2457,16 @@ void ggml_backend_amx_convert_weight(struct ggml_tensor * tensor, const void * d
     const int K = tensor->ne[0]; // ne0: in_features
     const int N = tensor->ne[1]; // ne1: out_features
 
+#if defined(__AMX_BF16__) && defined(__AVX512BF16__)
+    if (ftype_has_amx_kernels(TYPE)) {
+        GGML_DISPATCH_FLOATING_TYPES(TYPE, [&] {
+            GGML_UNUSED(blck_size);
+            convert_B_packed_bf16<type>((ggml_bf16_t *)tensor->data, (const type *)data, N, K);
+        });
+        return;
+    }
+#endif
+
     GGML_DISPATCH_QTYPES(TYPE, [&] {
         convert_B_packed_format<type, blck_size>((void *)((char *)tensor->data + offset), (const type *)data, N, K);
     });
@@ -2341,14 +2477,19 @@ size_t ggml_backend_amx_desired_wsize(const struct ggml_tensor * dst) {
 
     const enum ggml_type TYPE = src0->type;
 
+    const int M = dst->ne[1];
+    const int K = src0->ne[0];
+
+    if (ftype_has_amx_kernels(TYPE)) {
+        // A converted to bf16, in whole 2 * TILE_M row blocks for the tile loads
+        return GGML_PAD(M, 2 * TILE_M) * K * sizeof(ggml_bf16_t);
+    }
+
     const bool is_floating_type = TYPE == GGML_TYPE_F16;
     if (is_floating_type) {
         return 0;
     }
 
-    const int M = dst->ne[1];
-    const int K = src0->ne[0];
-
     size_t desired_wsize = 0;
 
     GGML_DISPATCH_QTYPES(TYPE, [&] {
@@ -2382,6 +2523,71 @@ void ggml_backend_amx_mul_mat(const ggml_compute_params * params, struct ggml_te
     const int K = src0->ne[0];
     const int ldc = dst->nb[1] / dst->nb[0];
 
+#if defined(__AMX_BF16__) && defined(__AVX512BF16__)
+    if (ftype_has_amx_kernels(TYPE)) {
+        GGML_ASSERT(params->wsize >= ggml_backend_amx_desired_wsize(dst));
+
+        const int KB = K / TILE_K_BF16;
+        const int lda = K;
+        ggml_bf16_t * A = static_cast<ggml_bf16_t *>(params->wdata);
+        const ggml_bf16_t * B = static_cast<const ggml_bf16_t *>(src0->data);
+
+        // convert A to bf16, the rows shared by the threads
+        parallel_for_ggml(params, M, [&](int begin, int end) {
+            for (int m = begin; m < end; ++m) {
+                from_float_bf16((const float *)src1->data + m * K, A + m * lda, K);
+            }
+        });
+
+        ggml_barrier(params->threadpool);
+
+        if (M == 1) {
+            constexpr int kTilesN = 4;
+            constexpr int BLOCK_N = TILE_N * kTilesN;
+            const int NB = div_up(N, BLOCK_N);
+
+            parallel_for_ggml(params, NB, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    int nb_start = i * BLOCK_N;
+                    int nb_size = std::min(BLOCK_N, N - nb_start); // 32, 64
+
+                    switch (nb_size) {
+                        case 64: LAUNCH_TINYGEMV_KERNEL_BF16(64); break;
+                        case 32: LAUNCH_TINYGEMV_KERNEL_BF16(32); break;
+                        default: fprintf(stderr, "Unexpected n block size!\n");
+                    }
+                }
+            });
+            return;
+        }
+
+        constexpr int BLOCK_M = TILE_M * 2;
+        constexpr int BLOCK_N = TILE_N * 2;
+        const int MB = div_up(M, BLOCK_M);
+        const int NB = div_up(N, BLOCK_N);
+
+        parallel_for_ggml(params, MB * NB, [&](int begin, int end) {
+            // init tile config for each thread
+            ggml_tile_config_init();
+
+            for (int i = begin; i < end; ++i) {
+                int mb = i / NB;
+                int nb = i % NB;
+
+                int mb_start = mb * BLOCK_M;
+                int mb_size = std::min(BLOCK_M, M - mb_start);
+                int nb_start = nb * BLOCK_N;
+
+                tinygemm_kernel_amx_bf16(
+                    mb_size, KB, A + mb_start * lda, lda,
+                    B + PACKED_INDEX(nb * 2, 0, KB, TILE_SIZE_BF16),
+                    (float *) dst->data + mb_start * ldc + nb_start, ldc);
+            }
+        });
+        return;
+    }
+#endif
+
     if (is_floating_type) {
         constexpr int BLOCK_M = 4;
         constexpr int BLOCK_N = 6;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ggml.h"
+#include "ggml-cpu.h"
 #include "traits.h"
 #include "ggml-cpu-impl.h"
 #include "ggml-impl.h"
@@ -8,6 +9,8 @@
 
 #ifdef __cplusplus
 
+#include <cstring>
+#include <type_traits>
 #include <utility>
 
 // convenience functions/macros for use in template calls
@@ -68,6 +71,27 @@ struct type_conversion_table<int32_t> {
     static constexpr int32_t (*from_f32)(float) = f32_to_i32;
 };
 
+// converts n contiguous elements, with the vectorized converters of ggml-cpu.c (F16C / AVX-512 on x86, NEON on
+// ARM) between F32 and F16 or BF16, element by element through type_conversion_table otherwise
+template <typename src_t, typename dst_t>
+static inline void convert_row(const src_t * x, dst_t * y, int64_t n) {
+    if constexpr (std::is_same_v<src_t, dst_t>) {
+        memcpy(y, x, n*sizeof(dst_t));
+    } else if constexpr (std::is_same_v<src_t, ggml_fp16_t> && std::is_same_v<dst_t, float>) {
+        ggml_cpu_fp16_to_fp32(x, y, n);
+    } else if constexpr (std::is_same_v<src_t, float> && std::is_same_v<dst_t, ggml_fp16_t>) {
+        ggml_cpu_fp32_to_fp16(x, y, n);
+    } else if constexpr (std::is_same_v<src_t, ggml_bf16_t> && std::is_same_v<dst_t, float>) {
+        ggml_cpu_bf16_to_fp32(x, y, n);
+    } else if constexpr (std::is_same_v<src_t, float> && std::is_same_v<dst_t, ggml_bf16_t>) {
+        ggml_cpu_fp32_to_bf16(x, y, n);
+    } else {
+        for (int64_t i = 0; i < n; ++i) {
+            y[i] = type_conversion_table<dst_t>::from_f32(type_conversion_table<src_t>::to_f32(x[i]));
+        }
+    }
+}
+
 static std::pair<int64_t, int64_t> get_thread_range(const struct ggml_compute_params * params, const struct ggml_tensor * src0) {
     const int64_t ith = params->ith;
     const int64_t nth = params->nth;
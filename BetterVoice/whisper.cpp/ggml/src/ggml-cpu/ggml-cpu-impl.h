@@ -519,6 +519,9 @@ void ggml_barrier(struct ggml_threadpool * tp);
 void ggml_threadpool_chunk_set(struct ggml_threadpool * tp, int value);
 int  ggml_threadpool_chunk_add(struct ggml_threadpool * tp, int value);
 
+// true if the cores differ in performance (P- and E-cores), see GGML_CPU_HYBRID
+bool ggml_cpu_is_hybrid(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -190,6 +190,7 @@ typedef pthread_t ggml_thread_t;
 #if defined(__APPLE__)
 #include <unistd.h>
 #include <mach/mach.h>
+#include <sys/sysctl.h>
 #include <TargetConditionals.h>
 #endif
 
@@ -525,6 +526,7 @@ struct ggml_numa_nodes {
 
 struct ggml_state {
     struct ggml_numa_nodes numa;
+    bool hybrid; // cores of different performance, e.g. P- and E-cores
 };
 
 static struct ggml_state g_state = {0};
@@ -682,6 +684,49 @@ bool ggml_is_numa(void) {
     return g_state.numa.n_nodes > 1;
 }
 
+// GGML_CPU_HYBRID=0/1 overrides the detection
+static bool ggml_cpu_detect_hybrid(void) {
+    const char * env = getenv("GGML_CPU_HYBRID");
+    if (env) {
+        return atoi(env) != 0;
+    }
+
+#if defined(__APPLE__)
+    // Apple silicon: one perf level per core class
+    int32_t n_levels = 0;
+    size_t  len      = sizeof(n_levels);
+    if (sysctlbyname("hw.nperflevels", &n_levels, &len, NULL, 0) == 0) {
+        return n_levels > 1;
+    }
+    return false;
+#elif defined(__gnu_linux__)
+    // the scheduler capacity of each CPU (arm64 big.LITTLE / DynamIQ, x86 hybrid with recent kernels)
+    long cap_min = LONG_MAX;
+    long cap_max = 0;
+    for (uint32_t c = 0; c < GGML_NUMA_MAX_CPUS; ++c) {
+        char path[256];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity", c);
+        FILE * f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        long cap = 0;
+        if (fscanf(f, "%ld", &cap) == 1) {
+            cap_min = MIN(cap_min, cap);
+            cap_max = MAX(cap_max, cap);
+        }
+        fclose(f);
+    }
+    return cap_max > 0 && cap_min < cap_max;
+#else
+    return false;
+#endif
+}
+
+bool ggml_cpu_is_hybrid(void) {
+    return g_state.hybrid;
+}
+
 #if defined(__ARM_ARCH)
 
 #if defined(__linux__) && defined(__aarch64__)
@@ -1359,6 +1404,16 @@ UseGgmlGemm2:;
         // distribute the thread work across the inner or outer loop based on which one is larger
         nchunk0 = nr0 > nr1 ? nth : 1; // parallelize by src0 rows
         nchunk1 = nr0 > nr1 ? 1 : nth; // parallelize by src1 rows
+
+        // With cores of different speed, an equal share per thread has the barrier wait for the slowest core.
+        // Use smaller chunks instead (down to 8 rows), so that the faster cores take more of them
+        if (ggml_cpu_is_hybrid() && !ggml_is_numa()) {
+            const int64_t nr = MAX(nr0, nr1);
+            const int64_t nchunk = MAX(nth, MIN(nth * 4, nr / 8));
+
+            nchunk0 = nr0 > nr1 ? nchunk : 1;
+            nchunk1 = nr0 > nr1 ? 1 : nchunk;
+        }
     }
 
     // The number of elements in each chunk
@@ -1687,6 +1742,10 @@ static void ggml_compute_forward(struct ggml_compute_params * params, struct ggm
             {
                 ggml_compute_forward_add1(params, tensor);
             } break;
+        case GGML_OP_ADD_GELU:
+            {
+                ggml_compute_forward_add_gelu(params, tensor);
+            } break;
         case GGML_OP_ACC:
             {
                 ggml_compute_forward_acc(params, tensor);
@@ -1763,6 +1822,10 @@ static void ggml_compute_forward(struct ggml_compute_params * params, struct ggm
             {
                 ggml_compute_forward_norm(params, tensor);
             } break;
+        case GGML_OP_NORM_AFFINE:
+            {
+                ggml_compute_forward_norm_affine(params, tensor);
+            } break;
         case GGML_OP_RMS_NORM:
             {
                 ggml_compute_forward_rms_norm(params, tensor);
@@ -1883,6 +1946,10 @@ static void ggml_compute_forward(struct ggml_compute_params * params, struct ggm
             {
                 ggml_compute_forward_im2col_3d(params, tensor);
             } break;
+        case GGML_OP_CONV_1D:
+            {
+                ggml_compute_forward_conv_1d(params, tensor);
+            } break;
         case GGML_OP_CONV_2D:
             {
                 ggml_compute_forward_conv_2d(params, tensor);
@@ -2139,6 +2206,7 @@ static int ggml_get_n_tasks(struct ggml_tensor * node, int n_threads) {
         case GGML_OP_ADD:
         case GGML_OP_ADD_ID:
         case GGML_OP_ADD1:
+        case GGML_OP_ADD_GELU:
         case GGML_OP_ACC:
             {
                 n_tasks = n_threads;
@@ -2213,6 +2281,7 @@ static int ggml_get_n_tasks(struct ggml_tensor * node, int n_threads) {
         case GGML_OP_MUL:
         case GGML_OP_DIV:
         case GGML_OP_NORM:
+        case GGML_OP_NORM_AFFINE:
         case GGML_OP_RMS_NORM:
         case GGML_OP_RMS_NORM_BACK:
         case GGML_OP_L2_NORM:
@@ -2263,6 +2332,7 @@ static int ggml_get_n_tasks(struct ggml_tensor * node, int n_threads) {
         case GGML_OP_IM2COL:
         case GGML_OP_IM2COL_BACK:
         case GGML_OP_IM2COL_3D:
+        case GGML_OP_CONV_1D:
         case GGML_OP_CONV_2D:
         case GGML_OP_CONV_3D:
         case GGML_OP_CONV_2D_DW:
@@ -2467,22 +2537,33 @@ static bool ggml_thread_apply_affinity(const bool * mask) {
 }
 
 static bool ggml_thread_apply_priority(int32_t prio) {
-    struct sched_param p;
-    int32_t policy = SCHED_OTHER;
+    // The QoS class decides which cores a thread runs on: UTILITY and below prefer the E-cores,
+    // USER_INITIATED and USER_INTERACTIVE the P-cores. Setting a scheduling policy opts the thread out of QoS
+    qos_class_t qos = QOS_CLASS_UNSPECIFIED;
     switch (prio) {
-        // TODO: there seems to be no way to set lower prio on Apple platforms
-        case GGML_SCHED_PRIO_LOW:      policy = SCHED_OTHER; p.sched_priority = 0;  break;
-        case GGML_SCHED_PRIO_NORMAL:   policy = SCHED_OTHER; p.sched_priority = 0;  break;
-        case GGML_SCHED_PRIO_MEDIUM:   policy = SCHED_FIFO;  p.sched_priority = 40; break;
-        case GGML_SCHED_PRIO_HIGH:     policy = SCHED_FIFO;  p.sched_priority = 80; break;
-        case GGML_SCHED_PRIO_REALTIME: policy = SCHED_FIFO;  p.sched_priority = 90; break;
+        case GGML_SCHED_PRIO_LOW:    qos = QOS_CLASS_UTILITY;          break;
+        case GGML_SCHED_PRIO_MEDIUM: qos = QOS_CLASS_USER_INITIATED;   break;
+        case GGML_SCHED_PRIO_HIGH:   qos = QOS_CLASS_USER_INTERACTIVE; break;
     }
 
-    if (prio == GGML_SCHED_PRIO_NORMAL) {
+    if (qos != QOS_CLASS_UNSPECIFIED) {
+        int32_t err = pthread_set_qos_class_self_np(qos, 0);
+        if (err != 0) {
+            fprintf(stderr, "warn: failed to set thread QoS class for priority %d : %s (%d)\n", prio, strerror(err), err);
+            return false;
+        }
+        return true;
+    }
+
+    if (prio != GGML_SCHED_PRIO_REALTIME) {
         // Keep inherited policy/priority
         return true;
     }
 
+    struct sched_param p;
+    int32_t policy = SCHED_FIFO;
+    p.sched_priority = 90;
+
     int32_t err = pthread_setschedparam(pthread_self(), policy, &p);
     if (err != 0) {
         fprintf(stderr, "warn: failed to set thread priority %d : %s (%d)\n", prio, strerror(err), err);
@@ -2788,6 +2869,7 @@ struct ggml_cplan ggml_graph_plan(
                             GGML_ABORT("fatal error");
                         }
                     } break;
+                case GGML_OP_CONV_1D:
                 case GGML_OP_CONV_2D:
                 case GGML_OP_CONV_3D:
                     {
@@ -2812,7 +2894,8 @@ struct ggml_cplan ggml_graph_plan(
                         const int64_t ne10 = node->src[1]->ne[0]; // DK
                         const int64_t ne20 = node->src[2]->ne[0]; // DV
 
-                        cur = sizeof(float)*(1*ne10 + 2*ne20)*n_tasks; // 1x head size K + 2x head size V (per thread)
+                        // 1x head size K + 2x head size V (per thread), or the tiles of the tiled variant
+                        cur = sizeof(float)*MAX(1*ne10 + 2*ne20, GGML_FA_TILE_WORK_F32(ne10, ne20))*n_tasks;
                     } break;
                 case GGML_OP_FLASH_ATTN_BACK:
                     {
@@ -2866,7 +2949,10 @@ static thread_ret_t ggml_graph_compute_thread(void * data) {
     const struct ggml_cgraph * cgraph = tp->cgraph;
     const struct ggml_cplan  * cplan  = tp->cplan;
 
-    set_numa_thread_affinity(state->ith);
+    // the cpumask of the threadpool takes precedence over the NUMA strategy
+    if (!ggml_thread_cpumask_is_valid(state->cpumask)) {
+        set_numa_thread_affinity(state->ith);
+    }
 
     struct ggml_compute_params params = {
         /*.ith       =*/ state->ith,
@@ -3188,7 +3274,9 @@ enum ggml_status ggml_graph_compute(struct ggml_cgraph * cgraph, struct ggml_cpl
 #endif
 
     // don't leave affinity set on the main thread
-    clear_numa_thread_affinity();
+    if (!ggml_thread_cpumask_is_valid(threadpool->workers[0].cpumask)) {
+        clear_numa_thread_affinity();
+    }
 
     enum ggml_status ret = threadpool->ec;
 
@@ -3238,6 +3326,15 @@ void ggml_cpu_fp32_to_fp16(const float * x, ggml_fp16_t * y, int64_t n) {
         vfloat16m1_t vy = __riscv_vfncvt_f_f_w_f16m1(vx, vl);
         __riscv_vse16_v_f16m1((_Float16 *)&y[i], vy, vl);
     }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 7 < n; i += 8) {
+        const float16x4_t y0 = vcvt_f16_f32(vld1q_f32(x + i));
+        const float16x4_t y1 = vcvt_f16_f32(vld1q_f32(x + i + 4));
+        vst1q_f16((__fp16 *)(y + i), vcombine_f16(y0, y1));
+    }
+    for (; i + 3 < n; i += 4) {
+        vst1_f16((__fp16 *)(y + i), vcvt_f16_f32(vld1q_f32(x + i)));
+    }
 #endif
     for (; i < n; ++i) {
         y[i] = GGML_CPU_FP32_TO_FP16(x[i]);
@@ -3264,6 +3361,15 @@ void ggml_cpu_fp16_to_fp32(const ggml_fp16_t * x, float * y, int64_t n) {
         __m128 y_vec = _mm_cvtph_ps(x_vec);
         _mm_storeu_ps(y + i, y_vec);
     }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 7 < n; i += 8) {
+        const float16x8_t x_vec = vld1q_f16((const __fp16 *)(x + i));
+        vst1q_f32(y + i,     vcvt_f32_f16(vget_low_f16(x_vec)));
+        vst1q_f32(y + i + 4, vcvt_high_f32_f16(x_vec));
+    }
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(y + i, vcvt_f32_f16(vld1_f16((const __fp16 *)(x + i))));
+    }
 #endif
 
     for (; i < n; ++i) {
@@ -3308,6 +3414,12 @@ void ggml_cpu_bf16_to_fp32(const ggml_bf16_t * x, float * y, int64_t n) {
                                         (const __m128i *)(x + i))),
                                 16)));
     }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 7 < n; i += 8) {
+        const uint16x8_t x_vec = vld1q_u16((const uint16_t *)(x + i));
+        vst1q_f32(y + i,     vreinterpretq_f32_u32(vshll_n_u16(vget_low_u16(x_vec), 16)));
+        vst1q_f32(y + i + 4, vreinterpretq_f32_u32(vshll_high_n_u16(x_vec, 16)));
+    }
 #endif
     for (; i < n; i++) {
         y[i] = GGML_BF16_TO_FP32(x[i]);
@@ -3378,6 +3490,14 @@ int ggml_cpu_has_amx_int8(void) {
 #endif
 }
 
+int ggml_cpu_has_amx_bf16(void) {
+#if defined(__AMX_BF16__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 int ggml_cpu_has_bmi2(void) {
 #if defined(__BMI2__)
     return 1;
@@ -3572,6 +3692,8 @@ void ggml_cpu_init(void) {
         ggml_init_arm_arch_features();
 #endif
 
+        g_state.hybrid = ggml_cpu_detect_hybrid();
+
         is_first_call = false;
     }
 
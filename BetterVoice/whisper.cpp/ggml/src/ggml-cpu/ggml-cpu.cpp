@@ -5,6 +5,7 @@
 #include "traits.h"
 #include "ggml-impl.h"
 #include "amx/amx.h"
+#include "hugepage.h"
 
 #include <cctype>
 #include <string>
@@ -449,6 +450,12 @@ static bool ggml_backend_cpu_device_supports_op(ggml_backend_dev_t dev, const st
         }
         case GGML_OP_IM2COL_BACK:
             return src0->type == GGML_TYPE_F32 && src1->type == GGML_TYPE_F32;
+        case GGML_OP_ADD_GELU:
+            return src0->type == GGML_TYPE_F32 && src0->nb[0] == sizeof(float) && src1->type == GGML_TYPE_F32;
+        case GGML_OP_NORM_AFFINE:
+            return op->src[3] == NULL || (op->src[3]->type == GGML_TYPE_F32 && op->src[3]->nb[0] == sizeof(float));
+        case GGML_OP_CONV_1D:
+            return src0->type == GGML_TYPE_F32 || src0->type == GGML_TYPE_F16;
         case GGML_OP_GET_ROWS_BACK:
             return src0->type == GGML_TYPE_F32 || src0->type == GGML_TYPE_F16;
         case GGML_OP_OUT_PROD:
@@ -555,6 +562,9 @@ static ggml_backend_feature * ggml_backend_cpu_get_features(ggml_backend_reg_t r
         if (ggml_cpu_has_amx_int8()) {
             features.push_back({ "AMX_INT8", "1" });
         }
+        if (ggml_cpu_has_amx_bf16()) {
+            features.push_back({ "AMX_BF16", "1" });
+        }
         if (ggml_cpu_has_neon()) {
             features.push_back({ "NEON", "1" });
         }
@@ -642,6 +652,9 @@ static void * ggml_backend_cpu_get_proc_address(ggml_backend_reg_t reg, const ch
     if (strcmp(name, "ggml_backend_cpu_is_numa") == 0) {
         return (void *)ggml_is_numa;
     }
+    if (strcmp(name, "ggml_backend_cpu_hugepage_buffer_type") == 0) {
+        return (void *)ggml_backend_cpu_hugepage_buffer_type;
+    }
 
     // threadpool - TODO:  move to ggml-base
     if (strcmp(name, "ggml_threadpool_new") == 0) {
@@ -650,6 +663,12 @@ static void * ggml_backend_cpu_get_proc_address(ggml_backend_reg_t reg, const ch
     if (strcmp(name, "ggml_threadpool_free") == 0) {
         return (void *)ggml_threadpool_free;
     }
+    if (strcmp(name, "ggml_threadpool_pause") == 0) {
+        return (void *)ggml_threadpool_pause;
+    }
+    if (strcmp(name, "ggml_threadpool_resume") == 0) {
+        return (void *)ggml_threadpool_resume;
+    }
     if (strcmp(name, "ggml_backend_cpu_set_threadpool") == 0) {
         return (void *)ggml_backend_cpu_set_threadpool;
     }
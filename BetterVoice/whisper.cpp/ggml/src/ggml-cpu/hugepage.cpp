@@ -0,0 +1,105 @@
+#include "ggml-backend.h"
+#include "ggml-backend-impl.h"
+#include "ggml-cpu.h"
+#include "ggml-impl.h"
+
+#include "hugepage.h"
+
+// buffer type huge pages
+// for the weights and the large compute buffers that every graph streams through, which otherwise take a TLB miss
+// every 4 KiB. The buffers are taken from the reserved huge pages (vm.nr_hugepages) with MAP_HUGETLB, and when there
+// are not enough of them, mapped at a huge page boundary and advised to transparent huge pages
+
+#if defined(__linux__)
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+
+static constexpr size_t GGML_HUGEPAGE_SIZE = 2*1024*1024;
+
+static const char * ggml_backend_cpu_hugepage_buffer_type_get_name(ggml_backend_buffer_type_t buft) {
+    return "CPU_Huge";
+
+    GGML_UNUSED(buft);
+}
+
+static void ggml_backend_cpu_hugepage_buffer_free_buffer(ggml_backend_buffer_t buffer) {
+    munmap(buffer->context, GGML_PAD(buffer->size, GGML_HUGEPAGE_SIZE));
+}
+
+static ggml_backend_buffer_t ggml_backend_cpu_hugepage_buffer_type_alloc_buffer(ggml_backend_buffer_type_t buft,
+                                                                                size_t                     size) {
+    // the mapping covers whole huge pages, and the free function finds its size from the size of the buffer
+    size = std::max<size_t>(size, 1);
+    const size_t size_map = GGML_PAD(size, GGML_HUGEPAGE_SIZE);
+
+    void * ptr = mmap(nullptr, size_map, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr == MAP_FAILED) {
+        // one more huge page to align the start, the rest is unmapped again
+        char * raw = (char *) mmap(nullptr, size_map + GGML_HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            GGML_LOG_ERROR("%s: failed to allocate a buffer of size %zu\n", __func__, size);
+            return nullptr;
+        }
+
+        char * base = (char *) GGML_PAD((uintptr_t) raw, GGML_HUGEPAGE_SIZE);
+        if (base > raw) {
+            munmap(raw, base - raw);
+        }
+        if (raw + GGML_HUGEPAGE_SIZE > base) {
+            munmap(base + size_map, raw + GGML_HUGEPAGE_SIZE - base);
+        }
+
+        if (madvise(base, size_map, MADV_HUGEPAGE) != 0) {
+            GGML_LOG_DEBUG("%s: transparent huge pages are not available\n", __func__);
+        }
+
+        ptr = base;
+    }
+
+    ggml_backend_buffer_t buffer = ggml_backend_cpu_buffer_from_ptr(ptr, size);
+    buffer->buft                 = buft;
+    buffer->iface.free_buffer    = ggml_backend_cpu_hugepage_buffer_free_buffer;
+
+    return buffer;
+}
+
+static size_t ggml_backend_cpu_hugepage_buffer_type_get_alignment(ggml_backend_buffer_type_t buft) {
+    return TENSOR_ALIGNMENT;
+
+    GGML_UNUSED(buft);
+}
+
+static bool ggml_backend_cpu_hugepage_buffer_type_is_host(ggml_backend_buffer_type_t buft) {
+    return true;
+
+    GGML_UNUSED(buft);
+}
+
+ggml_backend_buffer_type_t ggml_backend_cpu_hugepage_buffer_type(void) {
+    static struct ggml_backend_buffer_type ggml_backend_cpu_buffer_type_hugepage = {
+        /* .iface    = */ {
+                           /* .get_name         = */ ggml_backend_cpu_hugepage_buffer_type_get_name,
+                           /* .alloc_buffer     = */ ggml_backend_cpu_hugepage_buffer_type_alloc_buffer,
+                           /* .get_alignment    = */ ggml_backend_cpu_hugepage_buffer_type_get_alignment,
+                           /* .get_max_size     = */ nullptr,  // defaults to SIZE_MAX
+                           /* .get_alloc_size   = */ nullptr,  // defaults to ggml_nbytes
+                           /* .is_host          = */ ggml_backend_cpu_hugepage_buffer_type_is_host,
+                           },
+        /* .device   = */ ggml_backend_reg_dev_get(ggml_backend_cpu_reg(), 0),
+        /* .context  = */ nullptr,
+    };
+
+    return &ggml_backend_cpu_buffer_type_hugepage;
+}
+
+#else
+
+ggml_backend_buffer_type_t ggml_backend_cpu_hugepage_buffer_type(void) {
+    return ggml_backend_cpu_buffer_type();
+}
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ggml-backend.h"
+#include "ggml.h"
+
+// GGML CPU internal header
+
+// host memory in huge pages (CPU_Huge), the default CPU buffer type where they are not supported
+ggml_backend_buffer_type_t ggml_backend_cpu_hugepage_buffer_type(void);
@@ -457,11 +457,12 @@ ggml_kleidiai_kernels * ggml_kleidiai_select_kernels(cpu_feature cpu_features, c
     return kernel;
 }
 
-ggml_kleidiai_kernels * ggml_kleidiai_select_kernels_q4_0(cpu_feature features) {
+static ggml_kleidiai_kernels * ggml_kleidiai_select_kernels_rhs(cpu_feature features, ggml_type rhs_type) {
     ggml_kleidiai_kernels * kernels = nullptr;
 
     for (size_t i = 0; i < NELEMS(gemm_gemv_kernels); ++i) {
-        if ((features & gemm_gemv_kernels[i].required_cpu) == gemm_gemv_kernels[i].required_cpu) {
+        if ((features & gemm_gemv_kernels[i].required_cpu) == gemm_gemv_kernels[i].required_cpu &&
+            gemm_gemv_kernels[i].rhs_type == rhs_type) {
             kernels = &gemm_gemv_kernels[i];
             break;
         }
@@ -469,3 +470,11 @@ ggml_kleidiai_kernels * ggml_kleidiai_select_kernels_q4_0(cpu_feature features)
 
     return kernels;
 }
+
+ggml_kleidiai_kernels * ggml_kleidiai_select_kernels_q4_0(cpu_feature features) {
+    return ggml_kleidiai_select_kernels_rhs(features, GGML_TYPE_Q4_0);
+}
+
+ggml_kleidiai_kernels * ggml_kleidiai_select_kernels_f16(cpu_feature features) {
+    return ggml_kleidiai_select_kernels_rhs(features, GGML_TYPE_F16);
+}
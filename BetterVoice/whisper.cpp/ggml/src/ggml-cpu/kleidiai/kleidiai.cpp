@@ -6,6 +6,7 @@
 #include <atomic>
 #include <cfloat>
 #include <stdexcept>
+#include <vector>
 #include <stdint.h>
 #include <string.h>
 #if defined(__linux__)
@@ -37,8 +38,9 @@
 
 struct ggml_kleidiai_context {
     cpu_feature features;
-    ggml_kleidiai_kernels * kernels;
-} static ctx = { CPU_FEATURE_NONE, NULL };
+    ggml_kleidiai_kernels * kernels;     // Q4_0 weights
+    ggml_kleidiai_kernels * kernels_f16; // F16 weights
+} static ctx = { CPU_FEATURE_NONE, NULL, NULL };
 
 static const char* cpu_feature_to_string(cpu_feature f) {
     switch (f) {
@@ -58,6 +60,8 @@ static void init_kleidiai_context(void) {
 
     if (!initialized) {
         initialized = true;
+        // the SME kernels (Apple M4, Armv9.2 cores) are opt-in with GGML_KLEIDIAI_SME=1 until they have been built and
+        // benchmarked on arm64. The F16 kernel is an SME one, so F16 weights stay in CPU buffers without it
         const char *env_var = getenv("GGML_KLEIDIAI_SME");
         int sme_enabled = 0;
 
@@ -72,11 +76,15 @@ static void init_kleidiai_context(void) {
         if (sme_enabled != 0) {
             ctx.features |= ggml_cpu_has_sme() ? CPU_FEATURE_SME : CPU_FEATURE_NONE;
         }
-        ctx.kernels = ggml_kleidiai_select_kernels_q4_0(ctx.features);
+        ctx.kernels     = ggml_kleidiai_select_kernels_q4_0(ctx.features);
+        ctx.kernels_f16 = ggml_kleidiai_select_kernels_f16(ctx.features);
 #ifndef NDEBUG
         if (ctx.kernels) {
             GGML_LOG_DEBUG("kleidiai: using kernel with CPU feature %s\n", cpu_feature_to_string(ctx.kernels->required_cpu));
         }
+        if (ctx.kernels_f16) {
+            GGML_LOG_DEBUG("kleidiai: using F16 kernel with CPU feature %s\n", cpu_feature_to_string(ctx.kernels_f16->required_cpu));
+        }
 #endif
     }
     ggml_critical_section_end();
@@ -123,6 +131,10 @@ static inline Ret variant_call(Variant && var, Args&&... args) {
 
 namespace ggml::cpu::kleidiai {
 
+static bool is_prepacked(const ggml_tensor * tensor) {
+    return tensor->buffer && tensor->buffer->buft == ggml_backend_cpu_kleidiai_buffer_type();
+}
+
 static size_t round_down(size_t x, size_t y) {
     return y == 0 ? x : x - (x % y);
 }
@@ -164,9 +176,11 @@ class tensor_traits : public ggml::cpu::tensor_traits {
             const int64_t lhs_batch_size0 = op->src[1]->ne[2];
             const int64_t rhs_batch_size0 = op->src[0]->ne[2];
             const int64_t r = lhs_batch_size0 / rhs_batch_size0;
-            size = variant_call<size_t>(lhs_info->packed_size, m * r, k, mr, kr, sr) +
-                   variant_call<size_t>(kernels->rhs_info.packed_size, n, k) +
-                   k * n * sizeof(float) + n * sizeof(float);
+            size = variant_call<size_t>(lhs_info->packed_size, m * r, k, mr, kr, sr);
+            if (!is_prepacked(op->src[0])) {
+                size += variant_call<size_t>(kernels->rhs_info.packed_size, n, k) +
+                        k * n * sizeof(float) + n * sizeof(float);
+            }
         } else {
             GGML_ASSERT(false);
         }
@@ -228,10 +242,13 @@ class tensor_traits : public ggml::cpu::tensor_traits {
         const int64_t kr = (int64_t) kernel->get_kr();
         const int64_t sr = (int64_t) kernel->get_sr();
 
+        // weights in a KleidiAI buffer were packed when they were loaded
+        const bool rhs_prepacked = is_prepacked(src0);
+
         const size_t lhs_packed_size = variant_call<size_t>(lhs_info->packed_size, (size_t)m, (size_t)k, (size_t)mr, (size_t)kr, (size_t)sr);
-        const size_t rhs_packed_size = variant_call<size_t>(kernels->rhs_info.packed_size, (size_t)n, (size_t)k);
-        const size_t kxn_size        = (size_t)k * (size_t)n * sizeof(float);
-        const size_t bias_size       = (size_t)n * sizeof(float);
+        const size_t rhs_packed_size = rhs_prepacked ? 0 : variant_call<size_t>(kernels->rhs_info.packed_size, (size_t)n, (size_t)k);
+        const size_t kxn_size        = rhs_prepacked ? 0 : (size_t)k * (size_t)n * sizeof(float);
+        const size_t bias_size       = rhs_prepacked ? 0 : (size_t)n * sizeof(float);
 
         const size_t wsize_required = lhs_packed_size + rhs_packed_size + kxn_size + bias_size;
         GGML_ASSERT(wsize_required <= params->wsize);
@@ -289,7 +306,7 @@ class tensor_traits : public ggml::cpu::tensor_traits {
             }
 
             // RHS packing (single thread), then synchronize
-            if (ith == 0) {
+            if (ith == 0 && !rhs_prepacked) {
                 memset(bias, 0, (size_t)n * sizeof(float));
                 transpose_f32kxn_f16nxk((size_t)n, (size_t)k,
                                         reinterpret_cast<float *>(rhs_kxn),
@@ -326,7 +343,7 @@ class tensor_traits : public ggml::cpu::tensor_traits {
                     const size_t dst_offset        = kernel->get_dst_offset((size_t)0, (size_t)n_start, dst_stride);
 
                     const void * lhs_ptr = lhs_packed + lhs_packed_offset0;
-                    const void * rhs_ptr = rhs_packed + rhs_packed_offset;
+                    const void * rhs_ptr = (rhs_prepacked ? static_cast<const uint8_t *>(src0->data) : rhs_packed) + rhs_packed_offset;
                     float * dst_ptr      = reinterpret_cast<float *>(dst_batch_base + dst_offset);
 
                     variant_call<void>(kernel->run_kernel,
@@ -469,6 +486,10 @@ class tensor_traits : public ggml::cpu::tensor_traits {
 
 public:
     int repack(struct ggml_tensor * tensor, const void * data, size_t data_size) {
+        if (tensor->type == GGML_TYPE_F16) {
+            return repack_f16(tensor, data);
+        }
+
         GGML_ASSERT(tensor->type == GGML_TYPE_Q4_0);
         GGML_ASSERT(ctx.kernels);
         const size_t n = tensor->ne[1];
@@ -485,6 +506,28 @@ public:
         return 0;
         GGML_UNUSED(data_size);
     }
+
+    // packs the F16 weights once at load time, as compute_forward_fp16 would for every matmul
+    int repack_f16(struct ggml_tensor * tensor, const void * data) {
+        GGML_ASSERT(ctx.kernels_f16);
+        const size_t n  = tensor->ne[1];
+        const size_t k  = tensor->ne[0];
+        const size_t nr = ctx.kernels_f16->gemm.get_nr();
+        const size_t kr = ctx.kernels_f16->gemm.get_kr();
+        const size_t sr = ctx.kernels_f16->gemm.get_sr();
+
+        std::vector<float> rhs_kxn(k * n);
+        std::vector<float> bias(n, 0.0f);
+
+        transpose_f32kxn_f16nxk(n, k, rhs_kxn.data(), static_cast<const uint16_t *>(data), tensor->nb[1]);
+
+        variant_call<void>(ctx.kernels_f16->rhs_info.pack_func,
+                           /*num_groups*/ 1, n, k, nr, kr, sr,
+                           /*rhs_stride (bytes)*/ n * sizeof(float),
+                           rhs_kxn.data(), bias.data(), nullptr, tensor->data, /*extra_bytes*/ 0, /*params*/ nullptr);
+
+        return 0;
+    }
 };
 
 static ggml::cpu::tensor_traits * get_tensor_traits(ggml_backend_buffer_t, struct ggml_tensor *) {
@@ -540,6 +583,11 @@ static size_t ggml_backend_cpu_kleidiai_buffer_type_get_alignment(ggml_backend_b
 }
 
 static size_t ggml_backend_cpu_kleidiai_buffer_type_get_alloc_size(ggml_backend_buffer_type_t buft, const struct ggml_tensor * tensor) {
+    if (tensor->type == GGML_TYPE_F16) {
+        GGML_ASSERT(ctx.kernels_f16);
+        return variant_call<size_t>(ctx.kernels_f16->rhs_info.packed_size, (size_t) tensor->ne[1], (size_t) tensor->ne[0]);
+    }
+
     GGML_ASSERT(tensor->type == GGML_TYPE_Q4_0);
     GGML_ASSERT(ctx.kernels);
 
@@ -556,11 +604,16 @@ static size_t ggml_backend_cpu_kleidiai_buffer_type_get_alloc_size(ggml_backend_
 namespace ggml::cpu::kleidiai {
 class extra_buffer_type : ggml::cpu::extra_buffer_type {
     bool supports_op(ggml_backend_dev_t, const struct ggml_tensor * op) override {
+        // F16 weights are packed for the matmul kernels only, there is no GET_ROWS of them
+        const bool packed_type =
+            (op->src[0]->type == GGML_TYPE_Q4_0 && ctx.kernels) ||
+            (op->src[0]->type == GGML_TYPE_F16  && ctx.kernels_f16 && op->op == GGML_OP_MUL_MAT);
+
         if ((op->op == GGML_OP_MUL_MAT || op->op == GGML_OP_GET_ROWS) &&
-            op->src[0]->type == GGML_TYPE_Q4_0 &&
+            packed_type &&
             op->src[0]->buffer &&
             (ggml_n_dims(op->src[0]) == 2) &&
-            op->src[0]->buffer->buft == ggml_backend_cpu_kleidiai_buffer_type() && ctx.kernels) {
+            op->src[0]->buffer->buft == ggml_backend_cpu_kleidiai_buffer_type()) {
             if (op->src[1]->buffer && !ggml_backend_buft_is_host(op->src[1]->buffer->buft)) {
                 return false;
             }
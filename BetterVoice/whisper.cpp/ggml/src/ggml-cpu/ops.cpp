@@ -104,7 +104,7 @@ static void ggml_compute_forward_dup_flt(
                     }
                 }
             } else {
-                // casting between non-quantized types
+                // casting between non-quantized types, row by row
                 size_t id = 0;
                 dst_t * dst_ptr = (dst_t *) dst->data;
 
@@ -113,11 +113,8 @@ static void ggml_compute_forward_dup_flt(
                         id += ne00 * ir0;
                         for (int i01 = ir0; i01 < ir1; i01++) {
                             const src_t * src0_ptr = (src_t *) ((char *) src0->data + i01*nb01 + i02*nb02 + i03*nb03);
-                            for (int i00 = 0; i00 < ne00; i00++) {
-                                float tmp = type_conversion_table<src_t>::to_f32(src0_ptr[i00]);
-                                dst_ptr[id] = type_conversion_table<dst_t>::from_f32(tmp);
-                                id++;
-                            }
+                            convert_row(src0_ptr, dst_ptr + id, ne00);
+                            id += ne00;
                         }
                         id += ne00 * (ne01 - ir1);
                     }
@@ -148,6 +145,21 @@ static void ggml_compute_forward_dup_flt(
         return;
     }
 
+    // case: same shape, contiguous rows - e.g. a copy into a view of a KV cache
+    if (ggml_are_same_shape(src0, dst) && nb00 == sizeof(src_t) && nb0 == sizeof(dst_t)) {
+        for (int64_t i03 = 0; i03 < ne03; i03++) {
+            for (int64_t i02 = 0; i02 < ne02; i02++) {
+                for (int64_t i01 = ir0; i01 < ir1; i01++) {
+                    convert_row(
+                        (const src_t *) ((const char *) src0->data + i01*nb01 + i02*nb02 + i03*nb03),
+                        (dst_t *) ((char *) dst->data + i01*nb1 + i02*nb2 + i03*nb3),
+                        ne00);
+                }
+            }
+        }
+        return;
+    }
+
     // dst counters
     int64_t i10 = 0;
     int64_t i11 = 0;
@@ -1143,6 +1155,94 @@ void ggml_compute_forward_add1(
     }
 }
 
+// ggml_compute_forward_add_gelu
+
+static void ggml_compute_forward_add_gelu_f32(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * src0 = dst->src[0];
+    const ggml_tensor * src1 = dst->src[1];
+
+    GGML_ASSERT(ggml_are_same_shape(src0, dst));
+    GGML_ASSERT(src0->nb[0] == sizeof(float) && dst->nb[0] == sizeof(float));
+    GGML_ASSERT(ggml_is_contiguous(src1) && ggml_nelements(src1) == src0->ne[0]);
+
+    const int ith = params->ith;
+    const int nth = params->nth;
+
+    GGML_TENSOR_UNARY_OP_LOCALS
+
+    const ggml_unary_op op = (ggml_unary_op) ggml_get_op_params_i32(dst, 0);
+
+    // see ggml_gelu_set_prec()
+    const bool prec_f32 = ggml_get_op_params_i32(dst, 1) == GGML_PREC_F32;
+
+    const float * b = (const float *) src1->data;
+
+    const int nr = ggml_nrows(src0);
+
+    // rows per thread
+    const int dr = (nr + nth - 1)/nth;
+
+    // row range for this thread
+    const int ir0 = dr*ith;
+    const int ir1 = MIN(ir0 + dr, nr);
+
+    for (int ir = ir0; ir < ir1; ++ir) {
+        const int64_t i03 = ir/(ne02*ne01);
+        const int64_t i02 = (ir - i03*ne02*ne01)/ne01;
+        const int64_t i01 = (ir - i03*ne02*ne01 - i02*ne01);
+
+        const float * x = (float *) ((char *) src0->data + i01*nb01 + i02*nb02 + i03*nb03);
+              float * y = (float *) ((char *)  dst->data + i01*nb1  + i02*nb2  + i03*nb3);
+
+        // the activation reads the biased row while it is still in the cache, with the kernels of the unary op
+        ggml_vec_add_f32(ne00, y, x, b);
+
+        switch (op) {
+            case GGML_UNARY_OP_GELU:
+                {
+                    if (prec_f32) {
+                        ggml_vec_gelu_exp_f32(ne00, y, y);
+                    } else {
+                        ggml_vec_gelu_f32(ne00, y, y);
+                    }
+                } break;
+            case GGML_UNARY_OP_GELU_ERF:
+                {
+                    ggml_vec_gelu_erf_f32(ne00, y, y);
+                } break;
+            case GGML_UNARY_OP_GELU_QUICK:
+                {
+                    ggml_vec_gelu_quick_f32(ne00, y, y);
+                } break;
+            default:
+                {
+                    GGML_ABORT("fatal error");
+                }
+        }
+    }
+}
+
+void ggml_compute_forward_add_gelu(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * src0 = dst->src[0];
+
+    switch (src0->type) {
+        case GGML_TYPE_F32:
+            {
+                ggml_compute_forward_add_gelu_f32(params, dst);
+            } break;
+        default:
+            {
+                GGML_ABORT("fatal error");
+            }
+    }
+}
+
 // ggml_compute_forward_acc
 
 static void ggml_compute_forward_acc_f32(
@@ -2055,6 +2155,9 @@ static void ggml_compute_forward_gelu_f32(
     const int nc = src0->ne[0];
     const int nr = ggml_nrows(src0);
 
+    // see ggml_gelu_set_prec()
+    const bool prec_f32 = ggml_get_op_params_i32(dst, 1) == GGML_PREC_F32;
+
     // rows per thread
     const int dr = (nr + nth - 1)/nth;
 
@@ -2063,9 +2166,15 @@ static void ggml_compute_forward_gelu_f32(
     const int ir1 = MIN(ir0 + dr, nr);
 
     for (int i1 = ir0; i1 < ir1; i1++) {
-        ggml_vec_gelu_f32(nc,
-                (float *) ((char *) dst->data  + i1*( dst->nb[1])),
-                (float *) ((char *) src0->data + i1*(src0->nb[1])));
+        if (prec_f32) {
+            ggml_vec_gelu_exp_f32(nc,
+                    (float *) ((char *) dst->data  + i1*( dst->nb[1])),
+                    (float *) ((char *) src0->data + i1*(src0->nb[1])));
+        } else {
+            ggml_vec_gelu_f32(nc,
+                    (float *) ((char *) dst->data  + i1*( dst->nb[1])),
+                    (float *) ((char *) src0->data + i1*(src0->nb[1])));
+        }
 
 #ifndef NDEBUG
         for (int k = 0; k < nc; k++) {
@@ -3516,6 +3625,109 @@ void ggml_compute_forward_norm(
     }
 }
 
+// ggml_compute_forward_norm_affine
+
+static void ggml_compute_forward_norm_affine_f32(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * src0 = dst->src[0];
+    const ggml_tensor * src1 = dst->src[1];
+    const ggml_tensor * src2 = dst->src[2];
+    const ggml_tensor * src3 = dst->src[3]; // residual of ggml_add_norm_affine, or NULL
+
+    GGML_ASSERT(ggml_are_same_shape(src0, dst));
+
+    GGML_ASSERT(src0->nb[0] == sizeof(float));
+    GGML_ASSERT(src3 == nullptr || (ggml_are_same_shape(src3, dst) && src3->nb[0] == sizeof(float)));
+
+    const int ith = params->ith;
+    const int nth = params->nth;
+
+    GGML_TENSOR_UNARY_OP_LOCALS
+
+    float eps;
+    memcpy(&eps, dst->op_params, sizeof(float));
+
+    GGML_ASSERT(eps >= 0.0f);
+
+    const float * w = (const float *) src1->data;
+    const float * b = src2 ? (const float *) src2->data : nullptr;
+
+#ifdef GGML_SIMD
+    const int64_t pkg_size  = GGML_F32_EPR;
+    const int64_t i00_pkg_end = (ne00 / pkg_size) * pkg_size;
+#else
+    const int64_t i00_pkg_end = 0;
+#endif
+
+    for (int64_t i03 = 0; i03 < ne03; i03++) {
+        for (int64_t i02 = 0; i02 < ne02; i02++) {
+            for (int64_t i01 = ith; i01 < ne01; i01 += nth) {
+                const float * x = (float *) ((char *) src0->data + i01*nb01 + i02*nb02 + i03*nb03);
+
+                float * y = (float *) ((char *) dst->data + i01*nb1 + i02*nb2 + i03*nb3);
+
+                // the residual sum goes to the output row, which is then normalized in place
+                if (src3) {
+                    const float * r = (float *) ((char *) src3->data + i01*src3->nb[1] + i02*src3->nb[2] + i03*src3->nb[3]);
+                    ggml_vec_add_f32(ne00, y, x, r);
+                    x = y;
+                }
+
+                ggml_float sum = 0.0;
+                ggml_vec_sum_f32_ggf(ne00, &sum, x);
+
+                const float mean = sum/ne00;
+
+                ggml_float sum2 = 0.0;
+                for (int64_t i00 = 0; i00 < ne00; i00++) {
+                    const float v = x[i00] - mean;
+                    sum2 += (ggml_float)(v*v);
+                }
+
+                const float variance = sum2/ne00;
+                const float scale = 1.0f/sqrtf(variance + eps);
+
+                // y = (x - mean)*scale*w + b, in one pass
+#ifdef GGML_SIMD
+                const GGML_F32_VEC vmean  = GGML_F32_VEC_SET1(-mean);
+                const GGML_F32_VEC vscale = GGML_F32_VEC_SET1(scale);
+
+                for (int64_t i00 = 0; i00 < i00_pkg_end; i00 += pkg_size) {
+                    GGML_F32_VEC v = GGML_F32_VEC_ADD(GGML_F32_VEC_LOAD(x + i00), vmean);
+                    v = GGML_F32_VEC_MUL(v, vscale);
+
+                    GGML_F32_VEC vb = b ? GGML_F32_VEC_LOAD(b + i00) : GGML_F32_VEC_ZERO;
+                    GGML_F32_VEC_STORE(y + i00, GGML_F32_VEC_FMA(vb, v, GGML_F32_VEC_LOAD(w + i00)));
+                }
+#endif
+                for (int64_t i00 = i00_pkg_end; i00 < ne00; i00++) {
+                    y[i00] = (x[i00] - mean)*scale*w[i00] + (b ? b[i00] : 0.0f);
+                }
+            }
+        }
+    }
+}
+
+void ggml_compute_forward_norm_affine(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * src0 = dst->src[0];
+
+    switch (src0->type) {
+        case GGML_TYPE_F32:
+            {
+                ggml_compute_forward_norm_affine_f32(params, dst);
+            } break;
+        default:
+            {
+                GGML_ABORT("fatal error");
+            }
+    }
+}
+
 // ggml_compute_forward_group_rms_norm
 
 static void ggml_compute_forward_rms_norm_f32(
@@ -6664,6 +6876,142 @@ static void ggml_call_mul_mat(ggml_type type, const ggml_compute_params * params
     ggml_compute_forward_mul_mat(params, &dst);
 }
 
+// ggml_compute_forward_conv_1d
+
+// the im2col rows of a block of output positions are built in wdata and multiplied with the kernel, as in conv_2d
+// the bias and the GELU are applied to the rows of the GEMM output before they are written to dst
+static void ggml_compute_forward_conv_1d_impl(const ggml_compute_params * params,
+                                              const ggml_tensor *         kernel,  // [K, IC, OC]
+                                              const ggml_tensor *         src,     // [L, IC, N]
+                                              const ggml_tensor *         bias,    // [OC] or NULL
+                                              ggml_tensor *               dst,     // [OL, OC, N]
+                                              ggml_type                   kernel_type) {
+
+    GGML_ASSERT(ggml_is_contiguous(kernel));
+    GGML_ASSERT(kernel_type == GGML_TYPE_F16 || kernel_type == GGML_TYPE_F32);
+    GGML_ASSERT(kernel->type == kernel_type);
+
+    const ggml_type_traits * traits = ggml_get_type_traits(kernel_type);
+
+    const int32_t stride   = dst->op_params[0];
+    const int32_t pad      = dst->op_params[1];
+    const int32_t dilation = dst->op_params[2];
+    const bool    gelu     = dst->op_params[3] != 0;
+
+    const int64_t c_in  = src->ne[1];
+    const int64_t c_out = kernel->ne[2];
+    GGML_ASSERT(c_in == kernel->ne[1]);
+
+    const int64_t src_w = src->ne[0];
+    const int64_t knl_w = kernel->ne[0];
+    const int64_t dst_w = dst->ne[0];
+
+    const float * src_data  = (const float *) src->data;
+    const float * bias_data = bias ? (const float *) bias->data : nullptr;
+    void  * knl_data        = kernel->data;
+    float * dst_data        = (float *) dst->data;
+
+    const int64_t knl_n       = knl_w * c_in;
+    const int64_t patch_total = dst->ne[2] * dst_w;
+
+    const int64_t space_per_patch   = knl_n * traits->type_size + c_out * sizeof(float);
+    const int64_t batch_size        = params->wsize / space_per_patch;
+    const int64_t patches_per_batch = batch_size > 8 ? (batch_size / 8) * 8 : batch_size;
+    const int64_t batch_n           = (patch_total + patches_per_batch - 1) / patches_per_batch;
+
+    GGML_ASSERT(patches_per_batch > 0 && batch_size >= 1);
+
+    void * tmp = params->wdata;
+
+    for (int64_t batch_i = 0; batch_i < batch_n; ++batch_i) {
+
+        const int64_t patch_start_batch = batch_i * patches_per_batch;
+        const int64_t patch_end_batch   = std::min(patch_start_batch + patches_per_batch,
+                                              patch_total);
+        const int64_t patch_n           = patch_end_batch - patch_start_batch;
+
+        const int64_t patch_per_thread  = (patch_n + params->nth - 1) / params->nth;
+        const int64_t patch_start       = patch_start_batch + params->ith * patch_per_thread;
+        const int64_t patch_end         = std::min(patch_start + patch_per_thread, patch_end_batch);
+
+        //im2col for a patch
+        for (int64_t p = patch_start; p < patch_end; ++p) {
+            const int64_t batch_n = p / dst_w;
+            const int64_t dst_x   = p % dst_w;
+
+            const float * src_base = (const float *)((const char *)src_data + batch_n * src->nb[2]);
+            char *        dst_row  = (char *) tmp + (p % patches_per_batch) * knl_n * traits->type_size;
+
+            for (int64_t ic = 0; ic < c_in; ++ic) {
+                for (int64_t kx = 0; kx < knl_w; ++kx) {
+                    const int64_t sx = dst_x * stride + kx * dilation - pad;
+
+                    float src_val;
+                    if (sx < 0 || sx >= src_w) {
+                        src_val = 0.0f;
+                    } else {
+                        src_val = *(const float *)((const char *)src_base + sx * src->nb[0] + ic * src->nb[1]);
+                    }
+
+                    char * element_ptr = dst_row + (ic * knl_w + kx) * traits->type_size;
+                    if (kernel_type == GGML_TYPE_F32) {
+                        *(float *) element_ptr = src_val;
+                    } else if (kernel_type == GGML_TYPE_F16) {
+                        *(ggml_fp16_t *) element_ptr = GGML_CPU_FP32_TO_FP16(src_val);
+                    }
+                }
+            }
+        }   // patches handled by this thread
+
+        ggml_barrier(params->threadpool);
+
+        float * gemm_output = (float *) ((char *) tmp + patches_per_batch * knl_n * traits->type_size);
+
+        GGML_ASSERT(gemm_output + patch_n * c_out <= (float*)tmp + params->wsize);
+
+        // GEMM: patches[patch_n, knl_n] × kernel[knl_n, c_out] = output[patch_n, c_out]
+        ggml_call_mul_mat(kernel_type, params, patch_n, c_out, knl_n, tmp, knl_data, gemm_output);
+
+        ggml_barrier(params->threadpool);
+
+        // bias + gelu, then permute back [N, OL, OC] to [N, OC, OL]
+        const int64_t permute_per_thread = (patch_n + params->nth - 1) / params->nth;
+        const int64_t permute_start = params->ith * permute_per_thread;
+        const int64_t permute_end = std::min(permute_start + permute_per_thread, patch_n);
+
+        for (int64_t i = permute_start; i < permute_end; ++i) {
+            const int64_t p       = patch_start_batch + i;
+            const int64_t batch_n = p / dst_w;
+            const int64_t dst_x   = p % dst_w;
+
+            float * row = gemm_output + i * c_out;
+
+            if (bias_data) {
+                ggml_vec_add_f32(c_out, row, row, bias_data);
+            }
+            if (gelu) {
+                ggml_vec_gelu_f32(c_out, row, row);
+            }
+
+            for (int64_t oc = 0; oc < c_out; ++oc) {
+                float * dst_ptr = (float *)((char *)dst_data + dst_x * dst->nb[0] + oc * dst->nb[1] + batch_n * dst->nb[2]);
+                *dst_ptr = row[oc];
+            }
+        }
+    }
+}
+
+void ggml_compute_forward_conv_1d(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * src0 = dst->src[0];
+    const ggml_tensor * src1 = dst->src[1];
+    const ggml_tensor * src2 = dst->src[2];
+
+    ggml_compute_forward_conv_1d_impl(params, src0, src1, src2, dst, src0->type);
+}
+
 // ggml_compute_forward_conv_2d
 
 static void ggml_compute_forward_conv_2d_impl(const ggml_compute_params * params,
@@ -8151,15 +8499,434 @@ static void ggml_compute_forward_flash_attn_ext_f16(
     }
 }
 
+// the vectors of the microkernels below are kept in arrays, which the scalable vectors of SVE and RVV can't be
+#if defined(GGML_SIMD) && !defined(__ARM_FEATURE_SVE) && !defined(__riscv_v_intrinsic)
+#define GGML_FA_TILE_SIMD
+#endif
+
+// the microkernels and the tiled variant below are instantiated for a head size D known at compile time, the size of
+// the heads of whisper (64) and of many LLMs (128), whose loops are unrolled; D = 0 is the generic one, of any size
+
+#if defined(GGML_FA_TILE_SIMD)
+// the vectors of a row accumulated at a time by ggml_fa_tile_vkq()
+static constexpr int ggml_fa_tile_vkq_vecs(int D) {
+    return D > 0 && D % GGML_F32_EPR == 0 && D/GGML_F32_EPR <= 8 ? D/GGML_F32_EPR : 4;
+}
+
+// the rows computed together by a microkernel of n_vec accumulators per row, so that 8 accumulators are in flight and
+// each vector of K or V loaded serves all of them
+static constexpr int ggml_fa_tile_rows(int n_vec) {
+    return n_vec >= 8 ? 1 : 8/n_vec;
+}
+
+#define GGML_FA_TILE_KQ_ROWS     ggml_fa_tile_rows(GGML_FA_TILE_KV/GGML_F32_EPR)
+#define GGML_FA_TILE_VKQ_ROWS(D) ggml_fa_tile_rows(ggml_fa_tile_vkq_vecs(D))
+#else
+#define GGML_FA_TILE_KQ_ROWS     1
+#define GGML_FA_TILE_VKQ_ROWS(D) 1
+#endif
+
+// s[r][0..GGML_FA_TILE_KV) = q[r]*KT for R query rows q (DK apart) and a tile KT of DK x GGML_FA_TILE_KV keys stored by
+// column, s rows GGML_FA_TILE_KV apart: the KQ rows of the tile are accumulated in registers, broadcasting one
+// element of each q row at a time
+template <int D, int R>
+static void ggml_fa_tile_kq(int64_t DK, float * GGML_RESTRICT s, const float * GGML_RESTRICT KT, const float * GGML_RESTRICT q) {
+    if (D > 0) {
+        DK = D;
+    }
+#if defined(GGML_FA_TILE_SIMD)
+    constexpr int n = GGML_FA_TILE_KV/GGML_F32_EPR;
+
+    GGML_F32_VEC acc[R][n];
+    for (int r = 0; r < R; ++r) {
+        for (int j = 0; j < n; ++j) {
+            acc[r][j] = GGML_F32_VEC_ZERO;
+        }
+    }
+    for (int64_t c = 0; c < DK; ++c) {
+        GGML_F32_VEC qc[R];
+        for (int r = 0; r < R; ++r) {
+            qc[r] = GGML_F32_VEC_SET1(q[r*DK + c]);
+        }
+        const float * kt = KT + c*GGML_FA_TILE_KV;
+        for (int j = 0; j < n; ++j) {
+            const GGML_F32_VEC kj = GGML_F32_VEC_LOAD(kt + j*GGML_F32_EPR);
+            for (int r = 0; r < R; ++r) {
+                acc[r][j] = GGML_F32_VEC_FMA(acc[r][j], kj, qc[r]);
+            }
+        }
+    }
+    for (int r = 0; r < R; ++r) {
+        for (int j = 0; j < n; ++j) {
+            GGML_F32_VEC_STORE(s + r*GGML_FA_TILE_KV + j*GGML_F32_EPR, acc[r][j]);
+        }
+    }
+#else
+    for (int r = 0; r < R; ++r) {
+        memset(s + r*GGML_FA_TILE_KV, 0, GGML_FA_TILE_KV*sizeof(float));
+        for (int64_t c = 0; c < DK; ++c) {
+            ggml_vec_mad_f32(GGML_FA_TILE_KV, s + r*GGML_FA_TILE_KV, KT + c*GGML_FA_TILE_KV, q[r*DK + c]);
+        }
+    }
+#endif
+}
+
+// o[r][0..DV) += s[r]*V for R rows o (DV apart) and s (GGML_FA_TILE_KV apart) and a tile V of nkv x DV values stored
+// by row: o is accumulated in registers, a few vectors at a time, or all of a row of D values if they fit in 8 vectors
+template <int D, int R>
+static void ggml_fa_tile_vkq(int64_t DV, const int64_t nkv, float * GGML_RESTRICT o, const float * GGML_RESTRICT V, const float * GGML_RESTRICT s) {
+    if (D > 0) {
+        DV = D;
+    }
+    int64_t d = 0;
+#if defined(GGML_FA_TILE_SIMD)
+    constexpr int n = ggml_fa_tile_vkq_vecs(D);
+
+    for (; d + n*GGML_F32_EPR <= DV; d += n*GGML_F32_EPR) {
+        GGML_F32_VEC acc[R][n];
+        for (int r = 0; r < R; ++r) {
+            for (int k = 0; k < n; ++k) {
+                acc[r][k] = GGML_F32_VEC_LOAD(o + r*DV + d + k*GGML_F32_EPR);
+            }
+        }
+        for (int64_t j = 0; j < nkv; ++j) {
+            bool zero = true;
+            GGML_F32_VEC sj[R];
+            for (int r = 0; r < R; ++r) {
+                zero = zero && s[r*GGML_FA_TILE_KV + j] == 0.0f;
+                sj[r] = GGML_F32_VEC_SET1(s[r*GGML_FA_TILE_KV + j]);
+            }
+            if (zero) {
+                continue;
+            }
+            const float * vj = V + j*DV + d;
+            for (int k = 0; k < n; ++k) {
+                const GGML_F32_VEC vk = GGML_F32_VEC_LOAD(vj + k*GGML_F32_EPR);
+                for (int r = 0; r < R; ++r) {
+                    acc[r][k] = GGML_F32_VEC_FMA(acc[r][k], vk, sj[r]);
+                }
+            }
+        }
+        for (int r = 0; r < R; ++r) {
+            for (int k = 0; k < n; ++k) {
+                GGML_F32_VEC_STORE(o + r*DV + d + k*GGML_F32_EPR, acc[r][k]);
+            }
+        }
+    }
+#endif
+    if (d < DV) {
+        for (int r = 0; r < R; ++r) {
+            for (int64_t j = 0; j < nkv; ++j) {
+                const float sj = s[r*GGML_FA_TILE_KV + j];
+                if (sj != 0.0f) {
+                    ggml_vec_mad_f32(DV - d, o + r*DV + d, V + j*DV + d, sj);
+                }
+            }
+        }
+    }
+}
+
+// tiled variant for long query sequences, such as the encoder self-attention: a tile of GGML_FA_TILE_Q query rows
+// of one head runs against tiles of GGML_FA_TILE_KV keys/values converted to F32 once per tile, so K/V are read from
+// memory once per query tile instead of once per query row, and Q, K, V, KQ and the accumulators stay in cache
+template <int D>
+static void ggml_compute_forward_flash_attn_ext_tiled(
+        const ggml_compute_params * params,
+        ggml_tensor * dst) {
+
+    const ggml_tensor * q     = dst->src[0];
+    const ggml_tensor * k     = dst->src[1];
+    const ggml_tensor * v     = dst->src[2];
+    const ggml_tensor * mask  = dst->src[3];
+    const ggml_tensor * sinks = dst->src[4];
+
+    GGML_TENSOR_LOCALS(int64_t, neq, q,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbq, q,   nb)
+    GGML_TENSOR_LOCALS(int64_t, nek, k,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbk, k,   nb)
+    GGML_TENSOR_LOCALS(int64_t, nev, v,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbv, v,   nb)
+    GGML_TENSOR_LOCALS(int64_t, ne,  dst, ne)
+    GGML_TENSOR_LOCALS(size_t,  nb,  dst, nb)
+
+    const int ith = params->ith;
+    const int nth = params->nth;
+
+    const int64_t DK = D > 0 ? D : nek0;
+    const int64_t DV = D > 0 ? D : nev0;
+    const int64_t N  = neq1;
+
+    GGML_ASSERT(ne0 == DV);
+    GGML_ASSERT(ne2 == N);
+
+    // input tensor rows must be contiguous
+    GGML_ASSERT(nbq0 == ggml_type_size(q->type));
+    GGML_ASSERT(nbk0 == ggml_type_size(k->type));
+    GGML_ASSERT(nbv0 == ggml_type_size(v->type));
+
+    GGML_ASSERT(neq0 == DK);
+    GGML_ASSERT(nek0 == DK);
+    GGML_ASSERT(nev0 == DV);
+
+    // dst cannot be transposed or permuted
+    GGML_ASSERT(nb0 == sizeof(float));
+    GGML_ASSERT(nb0 <= nb1);
+    GGML_ASSERT(nb1 <= nb2);
+    GGML_ASSERT(nb2 <= nb3);
+
+    // broadcast factors
+    const int64_t rk2 = neq2/nek2;
+    const int64_t rk3 = neq3/nek3;
+
+    const int64_t rv2 = neq2/nev2;
+    const int64_t rv3 = neq3/nev3;
+
+    const int64_t TQ  = GGML_FA_TILE_Q;
+    const int64_t TKV = GGML_FA_TILE_KV;
+
+    // parallelize by query tiles of one head
+    const int64_t ntq = (N + TQ - 1)/TQ;
+    const int64_t nr  = ntq*neq2*neq3;
+
+    // tiles per thread
+    const int64_t dr = (nr + nth - 1)/nth;
+
+    // tile range for this thread
+    const int64_t ir0 = dr*ith;
+    const int64_t ir1 = MIN(ir0 + dr, nr);
+
+    float scale         = 1.0f;
+    float max_bias      = 0.0f;
+    float logit_softcap = 0.0f;
+
+    memcpy(&scale,         (float *) dst->op_params + 0, sizeof(float));
+    memcpy(&max_bias,      (float *) dst->op_params + 1, sizeof(float));
+    memcpy(&logit_softcap, (float *) dst->op_params + 2, sizeof(float));
+
+    if (logit_softcap != 0) {
+        scale /= logit_softcap;
+    }
+
+    const uint32_t n_head      = neq2;
+    const uint32_t n_head_log2 = 1u << (uint32_t) floor(log2(n_head));
+
+    const float m0 = powf(2.0f, -(max_bias       ) / n_head_log2);
+    const float m1 = powf(2.0f, -(max_bias / 2.0f) / n_head_log2);
+
+    // the SIMD conversion of the CPU backend for F16
+    ggml_to_float_t const k_to_float = k->type == GGML_TYPE_F16 ? (ggml_to_float_t) ggml_cpu_fp16_to_fp32 : ggml_get_type_traits(k->type)->to_float;
+    ggml_to_float_t const v_to_float = v->type == GGML_TYPE_F16 ? (ggml_to_float_t) ggml_cpu_fp16_to_fp32 : ggml_get_type_traits(v->type)->to_float;
+
+    float * Q32 = (float *) params->wdata + ith*(GGML_FA_TILE_WORK_F32(DK, DV) + CACHE_LINE_SIZE_F32); // TQ x DK, scaled Q
+    float * KT  = Q32 + TQ*DK;  // DK x TKV, K stored by column
+    float * V32 = KT  + DK*TKV; // TKV x DV
+    float * O32 = V32 + TKV*DV; // TQ x DV, VKQ accumulators
+    float * S32 = O32 + TQ*DV;  // TQ x TKV, KQ values of the current tiles
+    float * M   = S32 + TQ*TKV; // TQ, maximum KQ value of each row
+    float * L   = M   + TQ;     // TQ, sum of each row
+    float * K32 = L   + TQ;     // DK, K row being converted
+
+    for (int64_t ir = ir0; ir < ir1; ++ir) {
+        // q indices
+        const int64_t iq3 = ir/(neq2*ntq);
+        const int64_t iq2 = (ir - iq3*neq2*ntq)/ntq;
+        const int64_t iq1 = (ir - iq3*neq2*ntq - iq2*ntq)*TQ;
+
+        const int64_t nq = MIN(TQ, N - iq1);
+
+        const uint32_t h = iq2; // head index
+        const float slope = (max_bias > 0.0f) ? h < n_head_log2 ? powf(m0, h + 1) : powf(m1, 2*(h - n_head_log2) + 1) : 1.0f;
+
+        // k indices
+        const int64_t ik3 = iq3 / rk3;
+        const int64_t ik2 = iq2 / rk2;
+
+        // v indices
+        const int64_t iv3 = iq3 / rv3;
+        const int64_t iv2 = iq2 / rv2;
+
+        for (int64_t i = 0; i < nq; ++i) {
+            const float * pq = (const float *) ((char *) q->data + ((iq1 + i)*nbq1 + iq2*nbq2 + iq3*nbq3));
+            ggml_vec_scale_f32(DK, (float *) memcpy(Q32 + i*DK, pq, DK*sizeof(float)), scale);
+            M[i] = -INFINITY;
+            L[i] = 0.0f;
+        }
+        memset(O32, 0, nq*DV*sizeof(float));
+
+        const ggml_fp16_t * mp = mask ? (ggml_fp16_t *)((char *) mask->data + iq1*mask->nb[1] + (iq2%mask->ne[2])*mask->nb[2] + (iq3%mask->ne[3])*mask->nb[3]) : NULL;
+
+        // online softmax over the K/V tiles
+        // ref: https://arxiv.org/pdf/2112.05682.pdf
+        for (int64_t ic0 = 0; ic0 < nek1; ic0 += TKV) {
+            const int64_t nkv = MIN(TKV, nek1 - ic0);
+
+            // skip the tiles masked out for all the query rows, such as the padding of K/V
+            if (mp) {
+                bool any = false;
+                for (int64_t i = 0; i < nq && !any; ++i) {
+                    const ggml_fp16_t * mr = (const ggml_fp16_t *) ((const char *) mp + i*mask->nb[1]) + ic0;
+                    for (int64_t j = 0; j < nkv; ++j) {
+                        if (GGML_CPU_FP16_TO_FP32(mr[j]) != -INFINITY) {
+                            any = true;
+                            break;
+                        }
+                    }
+                }
+                if (!any) {
+                    continue;
+                }
+            }
+
+            for (int64_t j = 0; j < nkv; ++j) {
+                const char * k_data = (const char *) k->data + ((ic0 + j)*nbk1 + ik2*nbk2 + ik3*nbk3);
+                const char * v_data = (const char *) v->data + ((ic0 + j)*nbv1 + iv2*nbv2 + iv3*nbv3);
+                const float * kj = (const float *) k_data;
+                if (k_to_float) {
+                    k_to_float(k_data, K32, DK);
+                    kj = K32;
+                }
+                for (int64_t c = 0; c < DK; ++c) {
+                    KT[c*TKV + j] = kj[c];
+                }
+                if (v_to_float) {
+                    v_to_float(v_data, V32 + j*DV, DV);
+                } else {
+                    memcpy(V32 + j*DV, v_data, DV*sizeof(float));
+                }
+            }
+
+            // KQ rows of the tile, the columns past nkv of a partial tile are unused
+            {
+                constexpr int R = GGML_FA_TILE_KQ_ROWS;
+
+                int64_t i = 0;
+                for (; i + R <= nq; i += R) {
+                    ggml_fa_tile_kq<D, R>(DK, S32 + i*TKV, KT, Q32 + i*DK);
+                }
+                for (; i < nq; ++i) {
+                    ggml_fa_tile_kq<D, 1>(DK, S32 + i*TKV, KT, Q32 + i*DK);
+                }
+            }
+
+            for (int64_t i = 0; i < nq; ++i) {
+                const ggml_fp16_t * mr = mp ? (const ggml_fp16_t *) ((const char *) mp + i*mask->nb[1]) + ic0 : NULL;
+
+                float * s = S32 + i*TKV;
+                float smax = -INFINITY;
+
+                for (int64_t j = 0; j < nkv; ++j) {
+                    const float mv = mr ? slope*GGML_CPU_FP16_TO_FP32(mr[j]) : 0.0f;
+                    if (mv == -INFINITY) {
+                        s[j] = -INFINITY;
+                        continue;
+                    }
+
+                    if (logit_softcap != 0.0f) {
+                        s[j] = logit_softcap*tanhf(s[j]);
+                    }
+
+                    s[j] += mv; // apply mask
+
+                    smax = MAX(smax, s[j]);
+                }
+
+                // no value of the row in the tile
+                if (smax == -INFINITY) {
+                    memset(s, 0, nkv*sizeof(float));
+                    continue;
+                }
+
+                // upon new higher max val, scale VKQ and KQ sum of the row
+                const float Mold = M[i];
+                M[i] = MAX(Mold, smax);
+
+                const float ms = expf(Mold - M[i]);
+                if (ms != 1.0f) {
+                    ggml_vec_scale_f32(DV, O32 + i*DV, ms);
+                }
+
+                // s = expf(s - M)
+                const ggml_float sum = ggml_vec_soft_max_f32(nkv, s, s, M[i]);
+                L[i] = L[i]*ms + (float) sum;
+            }
+
+            // VKQ += V*s
+            {
+                constexpr int R = GGML_FA_TILE_VKQ_ROWS(D);
+
+                int64_t i = 0;
+                for (; i + R <= nq; i += R) {
+                    ggml_fa_tile_vkq<D, R>(DV, nkv, O32 + i*DV, V32, S32 + i*TKV);
+                }
+                for (; i < nq; ++i) {
+                    ggml_fa_tile_vkq<D, 1>(DV, nkv, O32 + i*DV, V32, S32 + i*TKV);
+                }
+            }
+        }
+
+        for (int64_t i = 0; i < nq; ++i) {
+            float * VKQ32 = O32 + i*DV;
+
+            // sinks
+            if (sinks) {
+                const float s = ((float *)((char *) sinks->data))[h];
+
+                float ms = 1.0f;
+                float vs = 1.0f;
+
+                if (s > M[i]) {
+                    ms = expf(M[i] - s);
+                    ggml_vec_scale_f32(DV, VKQ32, ms);
+                } else {
+                    vs = expf(s - M[i]);
+                }
+
+                L[i] = L[i]*ms + vs;
+            }
+
+            // V /= S
+            const float S_inv = 1.0f/L[i];
+            ggml_vec_scale_f32(DV, VKQ32, S_inv);
+
+            // dst indices
+            const int64_t i1 = iq1 + i;
+            const int64_t i2 = iq2;
+            const int64_t i3 = iq3;
+
+            // permute(0, 2, 1, 3)
+            memcpy((char *) dst->data + (i3*ne2*ne1 + i2 + i1*ne1)*nb1, VKQ32, nb1);
+        }
+    }
+}
+
 void ggml_compute_forward_flash_attn_ext(
         const ggml_compute_params * params,
         ggml_tensor * dst) {
+    const ggml_tensor * q = dst->src[0];
+    const ggml_tensor * k = dst->src[1];
+    const ggml_tensor * v = dst->src[2];
+
+    // the tiles only pay off with enough query rows to reuse them, the decoder processes few tokens at a time
+    const bool use_tiles =
+        q->type == GGML_TYPE_F32 && q->ne[1] >= GGML_FA_TILE_Q &&
+        (k->type == GGML_TYPE_F32 || ggml_get_type_traits(k->type)->to_float) &&
+        (v->type == GGML_TYPE_F32 || ggml_get_type_traits(v->type)->to_float);
+
     switch (dst->op_params[3]) {
         case GGML_PREC_DEFAULT:
         case GGML_PREC_F32:
             {
                 // uses F32 accumulators
-                ggml_compute_forward_flash_attn_ext_f16(params, dst);
+                if (use_tiles) {
+                    const int64_t D = k->ne[0] == v->ne[0] ? k->ne[0] : 0;
+                    switch (D) {
+                        case 64:  ggml_compute_forward_flash_attn_ext_tiled<64>(params, dst);  break;
+                        case 128: ggml_compute_forward_flash_attn_ext_tiled<128>(params, dst); break;
+                        default:  ggml_compute_forward_flash_attn_ext_tiled<0>(params, dst);   break;
+                    }
+                } else {
+                    ggml_compute_forward_flash_attn_ext_f16(params, dst);
+                }
             } break;
         default:
             {
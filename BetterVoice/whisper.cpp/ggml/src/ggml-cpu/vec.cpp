@@ -360,12 +360,79 @@ void ggml_vec_silu_f32(const int n, float * y, const float * x) {
     for (; i + 3 < n; i += 4) {
         vst1q_f32(y + i, ggml_v_silu(vld1q_f32(x + i)));
     }
+#elif defined(__wasm_simd128__)
+    for (; i + 3 < n; i += 4) {
+        wasm_v128_store(y + i, ggml_v_silu(wasm_v128_load(x + i)));
+    }
 #endif
     for (; i < n; ++i) {
         y[i] = ggml_silu_f32(x[i]);
     }
 }
 
+// the tanh form of GELU computed in F32 as x*sigmoid(2u) = x/(1 + exp(-2u)), u = sqrt(2/pi)*(x + 0.044715*x^3)
+// ggml_v_expf is accurate to ~1.5 ULP, so the result stays within 1e-6 relative of ggml_gelu_f32 (tanhf)
+// unlike the F16 table of ggml_vec_gelu_f32, whose error comes from rounding x to F16 (up to ~4e-3 absolute near |x| = 10)
+void ggml_vec_gelu_exp_f32(const int n, float * y, const float * x) {
+    const float c1 = 2.0f*SQRT_2_OVER_PI;
+    const float c2 = 2.0f*SQRT_2_OVER_PI*GELU_COEF_A;
+
+    int i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+    const __m512 one = _mm512_set1_ps(1.0f);
+    for (; i + 15 < n; i += 16) {
+        const __m512 xi = _mm512_loadu_ps(x + i);
+        const __m512 u  = _mm512_mul_ps(xi, _mm512_fmadd_ps(_mm512_mul_ps(xi, xi), _mm512_set1_ps(c2), _mm512_set1_ps(c1)));
+        const __m512 e  = ggml_v_expf(_mm512_sub_ps(_mm512_setzero_ps(), u));
+        _mm512_storeu_ps(y + i, _mm512_div_ps(xi, _mm512_add_ps(one, e)));
+    }
+#elif defined(__AVX2__) && defined(__FMA__)
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (; i + 7 < n; i += 8) {
+        const __m256 xi = _mm256_loadu_ps(x + i);
+        const __m256 u  = _mm256_mul_ps(xi, _mm256_fmadd_ps(_mm256_mul_ps(xi, xi), _mm256_set1_ps(c2), _mm256_set1_ps(c1)));
+        const __m256 e  = ggml_v_expf(_mm256_sub_ps(_mm256_setzero_ps(), u));
+        _mm256_storeu_ps(y + i, _mm256_div_ps(xi, _mm256_add_ps(one, e)));
+    }
+#elif defined(__SSE2__)
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 3 < n; i += 4) {
+        const __m128 xi = _mm_loadu_ps(x + i);
+        const __m128 u  = _mm_mul_ps(xi, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(xi, xi), _mm_set1_ps(c2)), _mm_set1_ps(c1)));
+        const __m128 e  = ggml_v_expf(_mm_sub_ps(_mm_setzero_ps(), u));
+        _mm_storeu_ps(y + i, _mm_div_ps(xi, _mm_add_ps(one, e)));
+    }
+#elif defined(__ARM_FEATURE_SVE) && defined(__aarch64__)
+    const int vlen = svcntw();
+    for (; i < n; i += vlen) {
+        const svbool_t pg = svwhilelt_b32_s32(i, n);
+        const svfloat32_t xi = svld1_f32(pg, x + i);
+        const svfloat32_t u  = svmul_f32_x(pg, xi, svmla_n_f32_x(pg, svdup_n_f32(c1), svmul_f32_x(pg, xi, xi), c2));
+        const svfloat32_t e  = ggml_v_expf(pg, svneg_f32_x(pg, u));
+        svst1_f32(pg, y + i, svdiv_f32_x(pg, xi, svadd_n_f32_x(pg, e, 1.0f)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; i + 3 < n; i += 4) {
+        const float32x4_t xi = vld1q_f32(x + i);
+        const float32x4_t u  = vmulq_f32(xi, vfmaq_n_f32(vdupq_n_f32(c1), vmulq_f32(xi, xi), c2));
+        const float32x4_t e  = ggml_v_expf(vnegq_f32(u));
+        vst1q_f32(y + i, vdivq_f32(xi, vaddq_f32(one, e)));
+    }
+#elif defined(__wasm_simd128__)
+    const v128_t one = wasm_f32x4_splat(1.0f);
+    for (; i + 3 < n; i += 4) {
+        const v128_t xi = wasm_v128_load(x + i);
+        const v128_t u  = wasm_f32x4_mul(xi, wasm_f32x4_add(wasm_f32x4_mul(wasm_f32x4_mul(xi, xi), wasm_f32x4_splat(c2)), wasm_f32x4_splat(c1)));
+        const v128_t e  = ggml_v_expf(wasm_f32x4_neg(u));
+        wasm_v128_store(y + i, wasm_f32x4_div(xi, wasm_f32x4_add(one, e)));
+    }
+#endif
+    for (; i < n; ++i) {
+        y[i] = ggml_gelu_f32(x[i]);
+    }
+}
+
 void ggml_vec_swiglu_f32(const int n, float * y, const float * x, const float * g) {
     int i = 0;
 #if defined(__AVX512F__) && defined(__AVX512DQ__)
@@ -457,6 +524,14 @@ ggml_float ggml_vec_soft_max_f32(const int n, float * y, const float * x, float
         vst1q_f32(y + i, val);
         sum += (ggml_float)vaddvq_f32(val);
     }
+#elif defined(__wasm_simd128__)
+    for (; i + 3 < n; i += 4) {
+        const v128_t val = ggml_v_expf(wasm_f32x4_sub(wasm_v128_load(x + i),
+                                                      wasm_f32x4_splat(max)));
+        wasm_v128_store(y + i, val);
+        sum += (ggml_float)(wasm_f32x4_extract_lane(val, 0) + wasm_f32x4_extract_lane(val, 1) +
+                            wasm_f32x4_extract_lane(val, 2) + wasm_f32x4_extract_lane(val, 3));
+    }
 #elif defined(__riscv_v_intrinsic)
     vfloat64m1_t vsum = __riscv_vfmv_v_f_f64m1(0, 1);
     for (int avl; i < n; i += avl) {
@@ -44,6 +44,7 @@ void ggml_vec_dot_bf16(int n, float * GGML_RESTRICT s, size_t bs, ggml_bf16_t *
 void ggml_vec_dot_f16(int n, float * GGML_RESTRICT s, size_t bs, ggml_fp16_t * GGML_RESTRICT x, size_t bx, ggml_fp16_t * GGML_RESTRICT y, size_t by, int nrc);
 
 void ggml_vec_silu_f32(const int n, float * y, const float * x);
+void ggml_vec_gelu_exp_f32(const int n, float * y, const float * x);
 ggml_float ggml_vec_soft_max_f32(const int n, float * y, const float * x, float max);
 ggml_float ggml_vec_log_soft_max_f32(const int n, float * y, const float * x, float max);
 
@@ -1277,7 +1278,47 @@ inline static vfloat32m2_t ggml_v_silu_m2(vfloat32m2_t x, int vl) {
     return __riscv_vfdiv_vv_f32m2(x, one_plus_exp_neg_x, vl);
 }
 
-#endif // __ARM_NEON / __AVX2__ / __SSE2__ / __riscv_v_intrinsic
+#elif defined(__wasm_simd128__)
+
+// the NEON routine above with the FMAs split into a multiply and an add, SIMD128 has no FMA
+// the maximum error is 1.45358 plus 0.5 ulps
+// numbers above 88.38 will flush to infinity
+// numbers beneath -103.97 will flush to zero
+inline static v128_t ggml_v_expf(v128_t x) {
+    const v128_t r = wasm_f32x4_splat(0x1.8p23f);
+    const v128_t z = wasm_f32x4_add(wasm_f32x4_mul(x, wasm_f32x4_splat(0x1.715476p+0f)), r);
+    const v128_t n = wasm_f32x4_sub(z, r);
+    const v128_t b = wasm_f32x4_sub(wasm_f32x4_sub(x, wasm_f32x4_mul(n, wasm_f32x4_splat(0x1.62e4p-1f))),
+                                    wasm_f32x4_mul(n, wasm_f32x4_splat(0x1.7f7d1cp-20f)));
+    const v128_t e = wasm_i32x4_shl(z, 23);
+    const v128_t k = wasm_i32x4_add(e, wasm_f32x4_splat(1.0f));
+    const v128_t c = wasm_f32x4_gt(wasm_f32x4_abs(n), wasm_f32x4_splat(126.0f));
+    const v128_t u = wasm_f32x4_mul(b, b);
+    const v128_t j = wasm_f32x4_add(
+        wasm_f32x4_mul(wasm_f32x4_splat(0x1.ffffecp-1f), b),
+        wasm_f32x4_mul(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_splat(0x1.fffdb6p-2f), wasm_f32x4_mul(wasm_f32x4_splat(0x1.555e66p-3f), b)),
+                                      wasm_f32x4_mul(wasm_f32x4_add(wasm_f32x4_splat(0x1.573e2ep-5f), wasm_f32x4_mul(wasm_f32x4_splat(0x1.0e4020p-7f), b)), u)),
+                       u));
+    if (!wasm_v128_any_true(c))
+        return wasm_f32x4_add(k, wasm_f32x4_mul(j, k));
+    const v128_t d = wasm_v128_and(wasm_f32x4_le(n, wasm_f32x4_splat(0.0f)), wasm_i32x4_splat(0x82000000));
+    const v128_t s1 = wasm_i32x4_add(d, wasm_i32x4_splat(0x7f000000));
+    const v128_t s2 = wasm_i32x4_sub(e, d);
+    return wasm_v128_bitselect(wasm_f32x4_mul(s1, s1),
+                               wasm_v128_bitselect(wasm_f32x4_mul(wasm_f32x4_add(s2, wasm_f32x4_mul(s2, j)), s1),
+                                                   wasm_f32x4_add(k, wasm_f32x4_mul(k, j)), c),
+                               wasm_f32x4_gt(wasm_f32x4_abs(n), wasm_f32x4_splat(192.0f)));
+}
+
+// computes silu x/(1+exp(-x)) in single precision vector
+inline static v128_t ggml_v_silu(v128_t x) {
+    const v128_t one = wasm_f32x4_splat(1.0f);
+    const v128_t exp_neg_x = ggml_v_expf(wasm_f32x4_neg(x));
+    const v128_t one_plus_exp_neg_x = wasm_f32x4_add(one, exp_neg_x);
+    return wasm_f32x4_div(x, one_plus_exp_neg_x);
+}
+
+#endif // __ARM_NEON / __AVX2__ / __SSE2__ / __riscv_v_intrinsic / __wasm_simd128__
 
 inline static void ggml_vec_silu_f16(const int n, ggml_fp16_t * y, const ggml_fp16_t * x) {
     for (int i = 0; i < n; ++i) {
@@ -23,6 +23,19 @@ struct ggml_metal_command_buffer {
     id<MTLCommandBuffer> obj;
 };
 
+// max number of graphs recorded for replay
+#define GGML_METAL_MAX_GRAPH_RECS 8
+
+// a graph recorded into an indirect command buffer
+struct ggml_metal_graph_rec {
+    bool     used;
+    uint64_t key;    // see ggml_metal_graph_key()
+    uint64_t epoch;  // ggml_metal_buffer_epoch() when recorded
+    uint64_t t_used; // compute counter of the last use
+
+    ggml_metal_icb_t icb; // NULL if the graph could not be recorded
+};
+
 struct ggml_metal {
     id<MTLDevice>       device;
     id<MTLCommandQueue> queue; // currently a pointer to the device queue, but might become separate queue [TAG_QUEUE_PER_BACKEND]
@@ -75,6 +88,16 @@ struct ggml_metal {
     // abort ggml_metal_graph_compute if callback returns true
     ggml_abort_callback abort_callback;
     void *              abort_callback_data;
+
+    // graph replay: a graph computed twice in a row is recorded into an indirect command buffer and the later
+    // computes of the same graph - same nodes, shapes and tensor addresses, as the repeated decoder steps of whisper -
+    // execute the recorded commands instead of encoding the nodes again
+    bool use_graph_replay;
+
+    uint64_t graph_key_last;
+    uint64_t n_computes;
+
+    struct ggml_metal_graph_rec graph_recs[GGML_METAL_MAX_GRAPH_RECS];
 };
 
 ggml_metal_t ggml_metal_init(ggml_metal_device_t dev) {
@@ -168,6 +191,12 @@ ggml_metal_t ggml_metal_init(ggml_metal_device_t dev) {
 
     res->pipelines_ext = ggml_metal_pipelines_init();
 
+    res->use_graph_replay = props_dev->use_graph_replay;
+    res->graph_key_last   = 0;
+    res->n_computes       = 0;
+
+    GGML_LOG_INFO("%s: use graph replay   = %s\n", __func__, res->use_graph_replay ? "true" : "false");
+
     return res;
 }
 
@@ -194,6 +223,10 @@ void ggml_metal_free(ggml_metal_t ctx) {
         ctx->pipelines_ext = nil;
     }
 
+    for (int i = 0; i < GGML_METAL_MAX_GRAPH_RECS; ++i) {
+        ggml_metal_icb_free(ctx->graph_recs[i].icb);
+    }
+
     if (ctx->debug_fusion > 0) {
         GGML_LOG_DEBUG("%s: fusion stats:\n", __func__);
         for (int i = 0; i < GGML_OP_COUNT; i++) {
@@ -356,6 +389,166 @@ void ggml_metal_get_tensor_async(ggml_metal_t ctx, const struct ggml_tensor * te
     }
 }
 
+static uint64_t ggml_metal_hash_words(uint64_t hash, const void * data, size_t size) {
+    const uint64_t * w = (const uint64_t *) data;
+
+    for (size_t i = 0; i < size/sizeof(uint64_t); ++i) {
+        hash ^= w[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// everything the encoded commands depend on: the ops, their shapes and parameters, and the tensor addresses
+static uint64_t ggml_metal_graph_key(const struct ggml_cgraph * gf) {
+    uint64_t hash = 1469598103934665603ull ^ (uint64_t) gf->n_nodes;
+
+    for (int i = 0; i < gf->n_nodes; ++i) {
+        const struct ggml_tensor * node = gf->nodes[i];
+
+        const uint64_t info[4] = { (uint64_t) node->op, (uint64_t) node->type, (uint64_t) node->flags, (uint64_t) (uintptr_t) node->data };
+
+        hash = ggml_metal_hash_words(hash, info,            sizeof(info));
+        hash = ggml_metal_hash_words(hash, node->ne,        sizeof(node->ne));
+        hash = ggml_metal_hash_words(hash, node->nb,        sizeof(node->nb));
+        hash = ggml_metal_hash_words(hash, node->op_params, sizeof(node->op_params));
+
+        for (int j = 0; j < GGML_MAX_SRC; ++j) {
+            const struct ggml_tensor * src = node->src[j];
+            if (src == NULL) {
+                continue;
+            }
+
+            const uint64_t src_info[3] = { (uint64_t) j, (uint64_t) src->type, (uint64_t) (uintptr_t) src->data };
+
+            hash = ggml_metal_hash_words(hash, src_info, sizeof(src_info));
+            hash = ggml_metal_hash_words(hash, src->ne,  sizeof(src->ne));
+            hash = ggml_metal_hash_words(hash, src->nb,  sizeof(src->nb));
+        }
+    }
+
+    return hash;
+}
+
+// encode all the nodes of the graph into an indirect command buffer, NULL if it does not fit
+static ggml_metal_icb_t ggml_metal_graph_record(ggml_metal_t ctx, struct ggml_cgraph * gf) {
+    // some ops dispatch more than one kernel
+    ggml_metal_icb_t icb = ggml_metal_icb_init(ctx->dev, 2*gf->n_nodes + 16);
+    if (icb == NULL) {
+        return NULL;
+    }
+
+    ggml_metal_encoder_t enc = ggml_metal_encoder_init_icb(icb, ctx->use_concurrency);
+
+    ggml_metal_op_t ctx_op = ggml_metal_op_init_enc(
+        ctx->dev,
+        enc,
+        gf,
+        0,
+        gf->n_nodes,
+        ctx->use_fusion,
+        ctx->use_concurrency,
+        false,
+        ctx->debug_graph,
+        ctx->debug_fusion);
+
+    bool ok = true;
+
+    for (int idx = 0; idx < ggml_metal_op_n_nodes(ctx_op); ++idx) {
+        const int res = ggml_metal_op_encode(ctx_op, idx);
+        if (res == 0) {
+            ok = false;
+            break;
+        }
+
+        idx += res - 1;
+    }
+
+    ggml_metal_op_free(ctx_op);
+    ggml_metal_encoder_free(enc);
+
+    if (!ok || !ggml_metal_icb_ok(icb)) {
+        ggml_metal_icb_free(icb);
+        return NULL;
+    }
+
+    return icb;
+}
+
+// execute the recorded commands of the graph, recording it first if it was also the previous graph
+// returns false if the graph has to be encoded
+static bool ggml_metal_graph_replay(ggml_metal_t ctx, struct ggml_cgraph * gf) {
+    const uint64_t key   = ggml_metal_graph_key(gf);
+    const uint64_t epoch = ggml_metal_buffer_epoch();
+
+    const bool repeated = key == ctx->graph_key_last;
+
+    ctx->graph_key_last = key;
+    ctx->n_computes++;
+
+    struct ggml_metal_graph_rec * rec = NULL;
+
+    for (int i = 0; i < GGML_METAL_MAX_GRAPH_RECS; ++i) {
+        struct ggml_metal_graph_rec * cur = &ctx->graph_recs[i];
+
+        // a freed buffer might have been replaced by another one at the same address
+        if (cur->used && cur->epoch != epoch) {
+            ggml_metal_icb_free(cur->icb);
+            memset(cur, 0, sizeof(*cur));
+        }
+
+        if (cur->used && cur->key == key) {
+            rec = cur;
+        }
+    }
+
+    if (rec == NULL) {
+        if (!repeated) {
+            return false;
+        }
+
+        // the least recently used slot
+        rec = &ctx->graph_recs[0];
+        for (int i = 1; i < GGML_METAL_MAX_GRAPH_RECS; ++i) {
+            if (!ctx->graph_recs[i].used || (rec->used && ctx->graph_recs[i].t_used < rec->t_used)) {
+                rec = &ctx->graph_recs[i];
+            }
+        }
+
+        ggml_metal_icb_free(rec->icb);
+
+        rec->used  = true;
+        rec->key   = key;
+        rec->epoch = epoch;
+        rec->icb   = ggml_metal_graph_record(ctx, gf);
+    }
+
+    rec->t_used = ctx->n_computes;
+
+    if (rec->icb == NULL) {
+        return false;
+    }
+
+    const int n_cb = ctx->n_cb;
+
+    id<MTLCommandBuffer> cmd_buf = [ctx->queue commandBufferWithUnretainedReferences];
+    [cmd_buf retain];
+
+    if (ctx->cmd_bufs[n_cb].obj) {
+        [ctx->cmd_bufs[n_cb].obj release];
+    }
+    ctx->cmd_bufs[n_cb].obj = cmd_buf;
+
+    ggml_metal_icb_execute(rec->icb, cmd_buf);
+
+    [cmd_buf commit];
+
+    ctx->cmd_buf_last = cmd_buf;
+
+    return true;
+}
+
 enum ggml_status ggml_metal_graph_compute(ggml_metal_t ctx, struct ggml_cgraph * gf) {
     // number of nodes encoded by the main thread (empirically determined)
     const int n_main = 64;
@@ -379,6 +572,13 @@ enum ggml_status ggml_metal_graph_compute(ggml_metal_t ctx, struct ggml_cgraph *
         ctx->n_nodes_per_cb = (ctx->n_nodes_1 + ctx->n_cb - 1) / ctx->n_cb;
 
         const bool use_capture = ctx->capture_next_compute;
+
+        if (ctx->use_graph_replay && !use_capture && !ctx->capture_started && gf->n_nodes > 0) {
+            if (ggml_metal_graph_replay(ctx, gf)) {
+                return GGML_STATUS_SUCCESS;
+            }
+        }
+
         if (use_capture) {
             ctx->capture_next_compute = false;
 
@@ -450,6 +650,9 @@ enum ggml_status ggml_metal_graph_compute(ggml_metal_t ctx, struct ggml_cgraph *
 
         dispatch_apply(n_cb, ctx->d_queue, ctx->encode_async);
 
+        // the first graphs of a run compile the pipelines missing from the cache, write them out once encoded
+        ggml_metal_library_save_archive(ctx->lib);
+
         // for debugging: block until graph is computed
         //[ctx->cmd_buf_last waitUntilCompleted];
 
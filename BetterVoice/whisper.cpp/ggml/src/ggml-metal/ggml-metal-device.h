@@ -89,6 +89,27 @@ void ggml_metal_encoder_memory_barrier(ggml_metal_encoder_t encoder);
 
 void ggml_metal_encoder_end_encoding(ggml_metal_encoder_t encoder);
 
+//
+// MTLIndirectCommandBuffer wrapper
+//
+// the compute commands of a graph, recorded once and executed again by later computes of the same graph
+// (see ggml_metal_graph_compute)
+//
+
+typedef struct ggml_metal_icb * ggml_metal_icb_t;
+
+ggml_metal_icb_t ggml_metal_icb_init(ggml_metal_device_t dev, int n_cmd_max);
+void ggml_metal_icb_free(ggml_metal_icb_t icb);
+
+// an encoder that records the commands into icb instead of encoding them
+ggml_metal_encoder_t ggml_metal_encoder_init_icb(ggml_metal_icb_t icb, bool concurrent);
+
+// false if the recording did not fit into the command buffer
+bool ggml_metal_icb_ok(ggml_metal_icb_t icb);
+
+// encode the execution of the recorded commands
+void ggml_metal_icb_execute(ggml_metal_icb_t icb, ggml_metal_cmd_buf_t cmd_buf_raw);
+
 //
 // MTLLibrary wrapper
 //
@@ -98,6 +119,9 @@ typedef struct ggml_metal_library * ggml_metal_library_t;
 ggml_metal_library_t ggml_metal_library_init(ggml_metal_device_t dev);
 void ggml_metal_library_free(ggml_metal_library_t lib);
 
+// write the pipeline cache (GGML_METAL_PIPELINE_CACHE) if pipelines were added to it since the last call
+void ggml_metal_library_save_archive(ggml_metal_library_t lib);
+
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline    (ggml_metal_library_t lib, const char * name);
 ggml_metal_pipeline_t ggml_metal_library_compile_pipeline(ggml_metal_library_t lib, const char * base, const char * name, ggml_metal_cv_t cv);
 
@@ -128,6 +152,7 @@ ggml_metal_pipeline_t ggml_metal_library_get_pipeline_group_norm        (ggml_me
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_norm              (ggml_metal_library_t lib, const struct ggml_tensor * op, int32_t n_fuse);
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_rope              (ggml_metal_library_t lib, const struct ggml_tensor * op);
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_im2col            (ggml_metal_library_t lib, const struct ggml_tensor * op);
+ggml_metal_pipeline_t ggml_metal_library_get_pipeline_conv_1d           (ggml_metal_library_t lib, const struct ggml_tensor * op);
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_conv_transpose_1d (ggml_metal_library_t lib, const struct ggml_tensor * op);
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_upscale           (ggml_metal_library_t lib, const struct ggml_tensor * op);
 ggml_metal_pipeline_t ggml_metal_library_get_pipeline_pad               (ggml_metal_library_t lib, const struct ggml_tensor * op);
@@ -177,6 +202,8 @@ struct ggml_metal_device_props {
     bool has_bfloat;
     bool use_residency_sets;
     bool use_shared_buffers;
+    bool use_graph_replay; // record repeated graphs into indirect command buffers
+    bool use_conv_1d;      // direct conv_1d kernel, opt-in with GGML_METAL_CONV_1D
 
     bool supports_gpu_family_apple7;
 };
@@ -215,6 +242,9 @@ void   ggml_metal_buffer_set_tensor   (ggml_metal_buffer_t buf, struct ggml_tens
 void   ggml_metal_buffer_get_tensor   (ggml_metal_buffer_t buf, const struct ggml_tensor * tensor, void * data, size_t offset, size_t size);
 void   ggml_metal_buffer_clear        (ggml_metal_buffer_t buf, uint8_t value);
 
+// incremented when a buffer is freed - the recorded graphs referencing older buffers are not valid anymore
+uint64_t ggml_metal_buffer_epoch(void);
+
 // finds the Metal buffer that contains the tensor data on the GPU device
 // the assumption is that there is 1-to-1 mapping between the host and device memory buffers, so we can find the
 // Metal buffer based on the host memory pointer
@@ -7,6 +7,8 @@
 
 #include <Metal/Metal.h>
 
+#include <stdatomic.h>
+
 #ifndef TARGET_OS_VISION
 #define TARGET_OS_VISION 0
 #endif
@@ -139,9 +141,82 @@ struct ggml_metal_library {
     id<MTLLibrary> obj;
     id<MTLDevice> device;
 
+    bool use_graph_replay; // pipelines usable in indirect command buffers
+
     ggml_metal_pipelines_t pipelines; // cache of compiled pipelines
+
+    // persistent cache of the compiled pipelines (MTLBinaryArchive at GGML_METAL_PIPELINE_CACHE), nil if not used
+    // pipelines missing from it are added and the file is rewritten by ggml_metal_library_save_archive()
+    id archive;
+    NSURL * archive_url;
+    bool archive_dirty;
 };
 
+static void ggml_metal_library_init_archive(ggml_metal_library_t lib) {
+    lib->archive = nil;
+    lib->archive_url = nil;
+    lib->archive_dirty = false;
+
+    const char * path = getenv("GGML_METAL_PIPELINE_CACHE");
+    if (path == NULL || path[0] == '\0') {
+        return;
+    }
+
+    if (@available(macOS 11.0, iOS 14.0, *)) {
+        NSError * error = nil;
+
+        NSURL * url = [NSURL fileURLWithPath:[NSString stringWithUTF8String:path]];
+
+        MTLBinaryArchiveDescriptor * desc = [MTLBinaryArchiveDescriptor new];
+        if ([[NSFileManager defaultManager] isReadableFileAtPath:url.path]) {
+            desc.url = url;
+        }
+
+        id<MTLBinaryArchive> archive = [lib->device newBinaryArchiveWithDescriptor:desc error:&error];
+        if (archive == nil && desc.url != nil) {
+            // written by another GPU or OS version, start over
+            GGML_LOG_WARN("%s: discarding the pipeline cache '%s': %s\n", __func__, path, [[error description] UTF8String]);
+
+            desc.url = nil;
+            error = nil;
+            archive = [lib->device newBinaryArchiveWithDescriptor:desc error:&error];
+        }
+
+        [desc release];
+
+        if (archive == nil) {
+            GGML_LOG_ERROR("%s: failed to create the pipeline cache: %s\n", __func__, [[error description] UTF8String]);
+            return;
+        }
+
+        GGML_LOG_INFO("%s: using the pipeline cache '%s'\n", __func__, path);
+
+        lib->archive = archive;
+        lib->archive_url = [url retain];
+    }
+}
+
+void ggml_metal_library_save_archive(ggml_metal_library_t lib) {
+    if (!lib || !lib->archive_dirty) {
+        return;
+    }
+
+    ggml_critical_section_start();
+
+    if (lib->archive_dirty) {
+        lib->archive_dirty = false;
+
+        if (@available(macOS 11.0, iOS 14.0, *)) {
+            NSError * error = nil;
+            if (![(id<MTLBinaryArchive>) lib->archive serializeToURL:lib->archive_url error:&error]) {
+                GGML_LOG_ERROR("%s: failed to write the pipeline cache: %s\n", __func__, [[error description] UTF8String]);
+            }
+        }
+    }
+
+    ggml_critical_section_end();
+}
+
 ggml_metal_library_t ggml_metal_library_init(ggml_metal_device_t dev) {
     id<MTLLibrary> library = nil;
     id<MTLDevice> device = ggml_metal_device_get_obj(dev);
@@ -161,12 +236,26 @@ ggml_metal_library_t ggml_metal_library_init(ggml_metal_device_t dev) {
         NSString * src = nil;
 
 #if GGML_METAL_EMBED_LIBRARY
-        GGML_LOG_INFO("%s: using embedded metal library\n", __func__);
-
         extern const char ggml_metallib_start[];
         extern const char ggml_metallib_end[];
 
+#if GGML_METAL_EMBED_METALLIB
+        GGML_LOG_INFO("%s: using embedded precompiled metal library\n", __func__);
+
+        // the data is static, nothing to release
+        dispatch_data_t data = dispatch_data_create(ggml_metallib_start, ggml_metallib_end - ggml_metallib_start, nil, ^{});
+
+        library = [device newLibraryWithData:data error:&error];
+        dispatch_release(data);
+        if (error) {
+            GGML_LOG_ERROR("%s: error: %s\n", __func__, [[error description] UTF8String]);
+            return nil;
+        }
+#else
+        GGML_LOG_INFO("%s: using embedded metal library\n", __func__);
+
         src = [[NSString alloc] initWithBytes:ggml_metallib_start length:(ggml_metallib_end-ggml_metallib_start) encoding:NSUTF8StringEncoding];
+#endif
 #else
 
 #ifdef SWIFT_PACKAGE
@@ -277,7 +366,7 @@ ggml_metal_library_t ggml_metal_library_init(ggml_metal_device_t dev) {
             }
         }
 
-#if GGML_METAL_EMBED_LIBRARY
+#if GGML_METAL_EMBED_LIBRARY && !GGML_METAL_EMBED_METALLIB
         [src release];
 #endif // GGML_METAL_EMBED_LIBRARY
 
@@ -287,9 +376,12 @@ ggml_metal_library_t ggml_metal_library_init(ggml_metal_device_t dev) {
     ggml_metal_library_t res = calloc(1, sizeof(struct ggml_metal_library));
 
     res->obj = library;
+    res->use_graph_replay = ggml_metal_device_get_props(dev)->use_graph_replay;
     res->device = device;
     res->pipelines = ggml_metal_pipelines_init();
 
+    ggml_metal_library_init_archive(res);
+
     return res;
 }
 
@@ -304,6 +396,13 @@ void ggml_metal_library_free(ggml_metal_library_t lib) {
 
     ggml_metal_pipelines_free(lib->pipelines);
 
+    ggml_metal_library_save_archive(lib);
+
+    if (lib->archive) {
+        [lib->archive release];
+        [lib->archive_url release];
+    }
+
     free(lib);
 }
 
@@ -348,7 +447,39 @@ ggml_metal_pipeline_t ggml_metal_library_compile_pipeline(ggml_metal_library_t l
             return nil;
         }
 
-        res->obj = [lib->device newComputePipelineStateWithFunction:mtl_function error:&error];
+        if (lib->use_graph_replay || lib->archive) {
+            MTLComputePipelineDescriptor * desc = [[MTLComputePipelineDescriptor alloc] init];
+
+            desc.computeFunction = mtl_function;
+            desc.supportIndirectCommandBuffers = lib->use_graph_replay;
+
+            res->obj = nil;
+
+            if (@available(macOS 11.0, iOS 14.0, *)) {
+                if (lib->archive) {
+                    // take the compiled pipeline from the cache, or compile it and add it for the next run
+                    desc.binaryArchives = @[lib->archive];
+
+                    res->obj = [lib->device newComputePipelineStateWithDescriptor:desc options:MTLPipelineOptionFailOnBinaryArchiveMiss reflection:nil error:nil];
+                    if (res->obj == nil) {
+                        if (![(id<MTLBinaryArchive>) lib->archive addComputePipelineFunctionsWithDescriptor:desc error:&error]) {
+                            GGML_LOG_WARN("%s: failed to add '%s' to the pipeline cache: %s\n", __func__, name, [[error description] UTF8String]);
+                            error = nil;
+                        } else {
+                            lib->archive_dirty = true;
+                        }
+                    }
+                }
+            }
+
+            if (res->obj == nil) {
+                res->obj = [lib->device newComputePipelineStateWithDescriptor:desc options:MTLPipelineOptionNone reflection:nil error:&error];
+            }
+
+            [desc release];
+        } else {
+            res->obj = [lib->device newComputePipelineStateWithFunction:mtl_function error:&error];
+        }
 
         ggml_metal_pipelines_add(lib->pipelines, name, res);
 
@@ -368,8 +499,44 @@ ggml_metal_pipeline_t ggml_metal_library_compile_pipeline(ggml_metal_library_t l
 // MTLComputeCommandEncoder wrapper
 //
 
+// bindings of the recorded commands
+#define GGML_METAL_ICB_MAX_BUFFERS 16
+#define GGML_METAL_ICB_MAX_SMEM    4
+
+// offset alignment of the kernel arguments in the argument buffer (constant address space)
+#define GGML_METAL_ICB_ARGS_ALIGN  256
+
+struct ggml_metal_icb {
+    id<MTLIndirectCommandBuffer> obj;
+
+    // the kernel arguments given with ggml_metal_encoder_set_bytes()
+    id<MTLBuffer> args;
+    size_t args_size;
+    size_t args_used;
+
+    // the buffers the commands use, made resident when they are executed
+    NSMutableArray * resources;
+
+    int n_cmd;
+    int n_cmd_max;
+
+    bool ok;
+};
+
 struct ggml_metal_encoder {
     id<MTLComputeCommandEncoder> obj;
+
+    // recording into an indirect command buffer (obj is nil) - the state is applied to each recorded command
+    ggml_metal_icb_t icb;
+
+    bool concurrent;
+    bool barrier; // the next command waits for the previous ones
+
+    id<MTLComputePipelineState> pipeline;
+
+    id<MTLBuffer> buffers[GGML_METAL_ICB_MAX_BUFFERS];
+    size_t        offs   [GGML_METAL_ICB_MAX_BUFFERS];
+    size_t        smem   [GGML_METAL_ICB_MAX_SMEM];
 };
 
 ggml_metal_encoder_t ggml_metal_encoder_init(ggml_metal_cmd_buf_t cmd_buf_raw, bool concurrent) {
@@ -388,47 +555,240 @@ ggml_metal_encoder_t ggml_metal_encoder_init(ggml_metal_cmd_buf_t cmd_buf_raw, b
     return res;
 }
 
+ggml_metal_encoder_t ggml_metal_encoder_init_icb(ggml_metal_icb_t icb, bool concurrent) {
+    ggml_metal_encoder_t res = calloc(1, sizeof(struct ggml_metal_encoder));
+
+    res->obj        = nil;
+    res->icb        = icb;
+    res->concurrent = concurrent;
+    res->barrier    = false;
+    res->pipeline   = nil;
+
+    return res;
+}
+
 void ggml_metal_encoder_free(ggml_metal_encoder_t encoder) {
-    [encoder->obj release];
+    if (encoder->obj) {
+        [encoder->obj release];
+    }
     free(encoder);
 }
 
 void ggml_metal_encoder_debug_group_push(ggml_metal_encoder_t encoder, const char * name) {
+    if (encoder->icb) {
+        return;
+    }
+
     [encoder->obj pushDebugGroup:[NSString stringWithCString:name encoding:NSUTF8StringEncoding]];
 }
 
 void ggml_metal_encoder_debug_group_pop (ggml_metal_encoder_t encoder) {
+    if (encoder->icb) {
+        return;
+    }
+
     [encoder->obj popDebugGroup];
 }
 
 void ggml_metal_encoder_set_pipeline(ggml_metal_encoder_t encoder, ggml_metal_pipeline_t pipeline) {
+    if (encoder->icb) {
+        encoder->pipeline = pipeline->obj;
+        return;
+    }
+
     [encoder->obj setComputePipelineState:pipeline->obj];
 }
 
 void ggml_metal_encoder_set_bytes(ggml_metal_encoder_t encoder, void * data, size_t size, int idx) {
+    if (encoder->icb) {
+        ggml_metal_icb_t icb = encoder->icb;
+
+        // indirect commands cannot take inline bytes, the arguments are copied into the argument buffer
+        const size_t offs = GGML_PAD(icb->args_used, GGML_METAL_ICB_ARGS_ALIGN);
+
+        if (idx >= GGML_METAL_ICB_MAX_BUFFERS || offs + size > icb->args_size) {
+            icb->ok = false;
+            return;
+        }
+
+        memcpy((char *) icb->args.contents + offs, data, size);
+        icb->args_used = offs + size;
+
+        encoder->buffers[idx] = icb->args;
+        encoder->offs   [idx] = offs;
+        return;
+    }
+
     [encoder->obj setBytes:data length:size atIndex:idx];
 }
 
 void ggml_metal_encoder_set_buffer(ggml_metal_encoder_t encoder, struct ggml_metal_buffer_id buffer, int idx) {
+    if (encoder->icb) {
+        ggml_metal_icb_t icb = encoder->icb;
+
+        if (idx >= GGML_METAL_ICB_MAX_BUFFERS) {
+            icb->ok = false;
+            return;
+        }
+
+        encoder->buffers[idx] = buffer.metal;
+        encoder->offs   [idx] = buffer.offs;
+
+        if (buffer.metal && ![icb->resources containsObject:buffer.metal]) {
+            [icb->resources addObject:buffer.metal];
+        }
+        return;
+    }
+
     [encoder->obj setBuffer:buffer.metal offset:buffer.offs atIndex:idx];
 }
 
 void ggml_metal_encoder_set_threadgroup_memory_size(ggml_metal_encoder_t encoder, size_t size, int idx) {
+    if (encoder->icb) {
+        if (idx >= GGML_METAL_ICB_MAX_SMEM) {
+            encoder->icb->ok = false;
+            return;
+        }
+
+        encoder->smem[idx] = size;
+        return;
+    }
+
     [encoder->obj setThreadgroupMemoryLength:size atIndex:idx];
 }
 
 void ggml_metal_encoder_dispatch_threadgroups(ggml_metal_encoder_t encoder, int tg0, int tg1, int tg2, int tptg0, int tptg1, int tptg2) {
+    if (encoder->icb) {
+        ggml_metal_icb_t icb = encoder->icb;
+
+        if (!icb->ok || icb->n_cmd >= icb->n_cmd_max || encoder->pipeline == nil) {
+            icb->ok = false;
+            return;
+        }
+
+        if (@available(macOS 11.0, iOS 14.0, *)) {
+            id<MTLIndirectComputeCommand> cmd = [icb->obj indirectComputeCommandAtIndex:icb->n_cmd++];
+
+            [cmd setComputePipelineState:encoder->pipeline];
+
+            for (int i = 0; i < GGML_METAL_ICB_MAX_BUFFERS; ++i) {
+                if (encoder->buffers[i]) {
+                    [cmd setKernelBuffer:encoder->buffers[i] offset:encoder->offs[i] atIndex:i];
+                }
+            }
+
+            for (int i = 0; i < GGML_METAL_ICB_MAX_SMEM; ++i) {
+                if (encoder->smem[i] > 0) {
+                    [cmd setThreadgroupMemoryLength:encoder->smem[i] atIndex:i];
+                }
+            }
+
+            // a serial encoder orders every dispatch after the previous one
+            if (encoder->barrier || !encoder->concurrent) {
+                [cmd setBarrier];
+            }
+
+            [cmd concurrentDispatchThreadgroups:MTLSizeMake(tg0, tg1, tg2) threadsPerThreadgroup:MTLSizeMake(tptg0, tptg1, tptg2)];
+        } else {
+            icb->ok = false;
+        }
+
+        encoder->barrier = false;
+        return;
+    }
+
     [encoder->obj dispatchThreadgroups:MTLSizeMake(tg0, tg1, tg2) threadsPerThreadgroup:MTLSizeMake(tptg0, tptg1, tptg2)];
 }
 
 void ggml_metal_encoder_memory_barrier(ggml_metal_encoder_t encoder) {
+    if (encoder->icb) {
+        encoder->barrier = true;
+        return;
+    }
+
     [encoder->obj memoryBarrierWithScope:MTLBarrierScopeBuffers];
 }
 
 void ggml_metal_encoder_end_encoding(ggml_metal_encoder_t encoder) {
+    if (encoder->icb) {
+        return;
+    }
+
     [encoder->obj endEncoding];
 }
 
+ggml_metal_icb_t ggml_metal_icb_init(ggml_metal_device_t dev, int n_cmd_max) {
+    id<MTLDevice> device = ggml_metal_device_get_obj(dev);
+
+    MTLIndirectCommandBufferDescriptor * desc = [[MTLIndirectCommandBufferDescriptor alloc] init];
+
+    desc.commandTypes             = MTLIndirectCommandTypeConcurrentDispatch;
+    desc.inheritPipelineState     = NO;
+    desc.inheritBuffers           = NO;
+    desc.maxKernelBufferBindCount = GGML_METAL_ICB_MAX_BUFFERS;
+
+    if (@available(macOS 14.0, iOS 17.0, *)) {
+        desc.maxKernelThreadgroupMemoryBindCount = GGML_METAL_ICB_MAX_SMEM;
+    }
+
+    id<MTLIndirectCommandBuffer> obj = [device newIndirectCommandBufferWithDescriptor:desc maxCommandCount:n_cmd_max options:0];
+
+    [desc release];
+
+    if (obj == nil) {
+        return NULL;
+    }
+
+    ggml_metal_icb_t res = calloc(1, sizeof(struct ggml_metal_icb));
+
+    // a few argument structs per command
+    res->args_size = (size_t) n_cmd_max*4*GGML_METAL_ICB_ARGS_ALIGN;
+    res->args      = [device newBufferWithLength:res->args_size options:MTLResourceStorageModeShared];
+
+    res->obj       = obj;
+    res->resources = [[NSMutableArray alloc] init];
+    res->args_used = 0;
+    res->n_cmd     = 0;
+    res->n_cmd_max = n_cmd_max;
+    res->ok        = res->args != nil;
+
+    if (res->args) {
+        [res->resources addObject:res->args];
+    }
+
+    return res;
+}
+
+void ggml_metal_icb_free(ggml_metal_icb_t icb) {
+    if (icb == NULL) {
+        return;
+    }
+
+    [icb->obj release];
+    [icb->args release];
+    [icb->resources release];
+
+    free(icb);
+}
+
+bool ggml_metal_icb_ok(ggml_metal_icb_t icb) {
+    return icb->ok;
+}
+
+void ggml_metal_icb_execute(ggml_metal_icb_t icb, ggml_metal_cmd_buf_t cmd_buf_raw) {
+    id<MTLCommandBuffer> cmd_buf = (id<MTLCommandBuffer>) cmd_buf_raw;
+
+    id<MTLComputeCommandEncoder> encoder = [cmd_buf computeCommandEncoderWithDispatchType:MTLDispatchTypeConcurrent];
+
+    // the buffers referenced only by indirect commands have to be made resident explicitly
+    for (id<MTLBuffer> buf in icb->resources) {
+        [encoder useResource:buf usage:MTLResourceUsageRead | MTLResourceUsageWrite];
+    }
+
+    [encoder executeCommandsInBuffer:icb->obj withRange:NSMakeRange(0, icb->n_cmd)];
+    [encoder endEncoding];
+}
+
 struct ggml_metal_device {
     id<MTLDevice> mtl_device;
 
@@ -464,6 +824,10 @@ ggml_metal_device_t ggml_metal_device_init(void) {
 
             dev->props.has_bfloat  = [dev->mtl_device supportsFamily:MTLGPUFamilyMetal3_GGML];
             dev->props.has_bfloat |= [dev->mtl_device supportsFamily:MTLGPUFamilyApple6];
+#if GGML_METAL_EMBED_METALLIB
+            // the library is compiled offline for every device, without the bfloat kernels
+            dev->props.has_bfloat = false;
+#endif
 
             dev->props.use_residency_sets = true;
 #if defined(GGML_METAL_HAS_RESIDENCY_SETS)
@@ -478,6 +842,19 @@ ggml_metal_device_t ggml_metal_device_init(void) {
 
             dev->props.supports_gpu_family_apple7 = [dev->mtl_device supportsFamily:MTLGPUFamilyApple7];
 
+            // indirect compute commands with barriers
+            // opt-in with GGML_METAL_GRAPH_REPLAY until it has been validated against the direct encoding
+            dev->props.use_graph_replay = false;
+            if (getenv("GGML_METAL_GRAPH_REPLAY") != NULL) {
+                if (@available(macOS 11.0, iOS 14.0, *)) {
+                    dev->props.use_graph_replay = [dev->mtl_device supportsFamily:MTLGPUFamilyApple3] ||
+                                                  [dev->mtl_device supportsFamily:MTLGPUFamilyMac2];
+                }
+            }
+
+            // not reported by supports_op until the kernel has been validated, so whisper keeps the im2col conv stem
+            dev->props.use_conv_1d = getenv("GGML_METAL_CONV_1D") != NULL;
+
             dev->props.max_buffer_size            = dev->mtl_device.maxBufferLength;
             dev->props.max_working_set_size       = dev->mtl_device.recommendedMaxWorkingSetSize;
             dev->props.max_theadgroup_memory_size = dev->mtl_device.maxThreadgroupMemoryLength;
@@ -526,6 +903,7 @@ ggml_metal_device_t ggml_metal_device_init(void) {
             GGML_LOG_INFO("%s: has bfloat            = %s\n", __func__, dev->props.has_bfloat              ? "true" : "false");
             GGML_LOG_INFO("%s: use residency sets    = %s\n", __func__, dev->props.use_residency_sets      ? "true" : "false");
             GGML_LOG_INFO("%s: use shared buffers    = %s\n", __func__, dev->props.use_shared_buffers      ? "true" : "false");
+            GGML_LOG_INFO("%s: use graph replay      = %s\n", __func__, dev->props.use_graph_replay        ? "true" : "false");
 
 #if TARGET_OS_OSX || (TARGET_OS_IOS && __clang_major__ >= 15)
             if (@available(macOS 10.12, iOS 16.0, *)) {
@@ -648,6 +1026,10 @@ bool ggml_metal_device_supports_op(ggml_metal_device_t dev, const struct ggml_te
         case GGML_OP_SCALE:
         case GGML_OP_CONV_TRANSPOSE_1D:
             return true;
+        case GGML_OP_CONV_1D:
+            return dev->props.use_conv_1d &&
+                   (op->src[0]->type == GGML_TYPE_F16 || op->src[0]->type == GGML_TYPE_F32) &&
+                   op->src[1]->type == GGML_TYPE_F32 && op->src[1]->nb[0] == sizeof(float);
         case GGML_OP_CLAMP:
             return op->src[0]->type == GGML_TYPE_F32;
         case GGML_OP_SQR:
@@ -665,6 +1047,12 @@ bool ggml_metal_device_supports_op(ggml_metal_device_t dev, const struct ggml_te
             return has_simdgroup_reduction && (op->ne[0] % 4 == 0 && ggml_is_contiguous_1(op->src[0]));
         case GGML_OP_ARGMAX:
             return has_simdgroup_reduction;
+        case GGML_OP_NORM_AFFINE:
+            // no kernel for the residual variant (ggml_add_norm_affine) yet
+            if (op->src[3] != NULL) {
+                return false;
+            }
+            return has_simdgroup_reduction && (ggml_is_contiguous_rows(op->src[0]));
         case GGML_OP_NORM:
         case GGML_OP_RMS_NORM:
             return has_simdgroup_reduction && (ggml_is_contiguous_rows(op->src[0]));
@@ -1108,7 +1496,15 @@ ggml_metal_buffer_t ggml_metal_buffer_map(ggml_metal_device_t dev, void * ptr, s
     return res;
 }
 
+static atomic_uint_fast64_t g_buffer_epoch = 0;
+
+uint64_t ggml_metal_buffer_epoch(void) {
+    return atomic_load(&g_buffer_epoch);
+}
+
 void ggml_metal_buffer_free(ggml_metal_buffer_t buf) {
+    atomic_fetch_add(&g_buffer_epoch, 1);
+
     for (int i = 0; i < buf->n_buffers; i++) {
         [buf->buffers[i].metal release];
     }
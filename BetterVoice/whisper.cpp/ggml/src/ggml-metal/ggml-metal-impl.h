@@ -68,6 +68,9 @@
 #define N_R0_IQ4_XS 2
 #define N_SG_IQ4_XS 2
 
+// number of output channels accumulated by each thread of kernel_conv_1d
+#define N_OC_CONV_1D 8
+
 // function constants offsets
 #define FC_FLASH_ATTN_EXT              100
 #define FC_FLASH_ATTN_EXT_VEC          200
@@ -472,6 +475,27 @@ typedef struct {
     uint64_t nb1;
 } ggml_metal_kargs_conv_transpose_1d;
 
+typedef struct {
+    int32_t  IC;
+    int32_t  IL;
+    int32_t  K;
+    int32_t  OL;
+    int32_t  OC;
+    int32_t  s0;
+    int32_t  p0;
+    int32_t  d0;
+    int32_t  bias;
+    int32_t  gelu;
+    uint64_t nb00;
+    uint64_t nb01;
+    uint64_t nb02;
+    uint64_t nb11;
+    uint64_t nb12;
+    uint64_t nb0;
+    uint64_t nb1;
+    uint64_t nb2;
+} ggml_metal_kargs_conv_1d;
+
 typedef struct {
     uint64_t  ofs0;
     uint64_t  ofs1;
@@ -26,7 +26,8 @@ static ggml_metal_buffer_id ggml_metal_get_buffer_id(const ggml_tensor * t) {
 struct ggml_metal_op {
     ggml_metal_op(
         ggml_metal_device_t dev,
-        ggml_metal_cmd_buf_t cmd_buf,
+        ggml_metal_encoder_t enc,
+        bool own_enc,
         ggml_cgraph * gf,
         int  idx_start,
         int  idx_end,
@@ -37,7 +38,8 @@ struct ggml_metal_op {
         int  debug_fusion) {
         this->dev             = dev;
         this->lib             = ggml_metal_device_get_library(dev);
-        this->enc             = ggml_metal_encoder_init(cmd_buf, use_concurrency);
+        this->enc             = enc;
+        this->own_enc         = own_enc;
         this->mem_ranges      = ggml_mem_ranges_init(debug_graph);
         this->idx_start       = idx_start;
         this->idx_end         = idx_end;
@@ -61,8 +63,10 @@ struct ggml_metal_op {
     }
 
     ~ggml_metal_op() {
-        ggml_metal_encoder_end_encoding(this->enc);
-        ggml_metal_encoder_free(this->enc);
+        if (own_enc) {
+            ggml_metal_encoder_end_encoding(this->enc);
+            ggml_metal_encoder_free(this->enc);
+        }
         ggml_mem_ranges_free(this->mem_ranges);
     }
 
@@ -91,6 +95,8 @@ struct ggml_metal_op {
     ggml_metal_encoder_t enc;
     ggml_mem_ranges_t    mem_ranges;
 
+    bool own_enc;
+
     bool use_fusion;
     bool use_concurrency;
     bool use_capture;
@@ -121,7 +127,35 @@ ggml_metal_op_t ggml_metal_op_init(
         int debug_fusion) {
     ggml_metal_op_t res = new ggml_metal_op(
         dev,
-        cmd_buf,
+        ggml_metal_encoder_init(cmd_buf, use_concurrency),
+        true,
+        gf,
+        idx_start,
+        idx_end,
+        use_fusion,
+        use_concurrency,
+        use_capture,
+        debug_graph,
+        debug_fusion);
+
+    return res;
+}
+
+ggml_metal_op_t ggml_metal_op_init_enc(
+        ggml_metal_device_t dev,
+        ggml_metal_encoder_t enc,
+        ggml_cgraph * gf,
+        int idx_start,
+        int idx_end,
+        bool use_fusion,
+        bool use_concurrency,
+        bool use_capture,
+        int debug_graph,
+        int debug_fusion) {
+    ggml_metal_op_t res = new ggml_metal_op(
+        dev,
+        enc,
+        false,
         gf,
         idx_start,
         idx_end,
@@ -336,6 +370,7 @@ static int ggml_metal_op_encode_impl(ggml_metal_op_t ctx, int idx) {
                 n_fuse = ggml_metal_op_group_norm(ctx, idx);
             } break;
         case GGML_OP_NORM:
+        case GGML_OP_NORM_AFFINE:
         case GGML_OP_RMS_NORM:
             {
                 n_fuse = ggml_metal_op_norm(ctx, idx);
@@ -348,6 +383,10 @@ static int ggml_metal_op_encode_impl(ggml_metal_op_t ctx, int idx) {
             {
                 n_fuse = ggml_metal_op_im2col(ctx, idx);
             } break;
+        case GGML_OP_CONV_1D:
+            {
+                n_fuse = ggml_metal_op_conv_1d(ctx, idx);
+            } break;
         case GGML_OP_CONV_TRANSPOSE_1D:
             {
                 n_fuse = ggml_metal_op_conv_transpose_1d(ctx, idx);
@@ -2517,10 +2556,32 @@ int ggml_metal_op_norm(ggml_metal_op_t ctx, int idx) {
 
     ggml_metal_buffer_id bid_fuse[2] = { bid_src0, bid_src0 };
 
+    // kernel variant: 1 = norm, 2 = norm + mul, 3 = norm + mul + add
+    int n_kern = 1;
+
+    // norm_affine(a, b, c) is norm(a) + mul(b) + add(c) with the weight and bias as sources of the op
+    if (op->op == GGML_OP_NORM_AFFINE) {
+        for (int i = 0; i < 2 && op->src[1 + i]; ++i) {
+            const ggml_tensor * f = op->src[1 + i];
+
+            bid_fuse[i] = ggml_metal_get_buffer_id(f);
+
+            args.nef1[i + 1] = 1;
+            args.nef2[i + 1] = 1;
+            args.nef3[i + 1] = 1;
+
+            args.nbf1[i + 1] = f->nb[1];
+            args.nbf2[i + 1] = f->nb[2];
+            args.nbf3[i + 1] = f->nb[3];
+
+            n_kern++;
+        }
+    }
+
     // d[0] = norm(a)
     // d[1] = mul(d[0], b)
     // d[2] = add(d[1], c)
-    if (use_fusion) {
+    if (use_fusion && op->op != GGML_OP_NORM_AFFINE) {
         fops[0] = op->op;
         fops[1] = GGML_OP_MUL;
         fops[2] = GGML_OP_ADD;
@@ -2564,6 +2625,8 @@ int ggml_metal_op_norm(ggml_metal_op_t ctx, int idx) {
 
         ++n_fuse;
 
+        n_kern = n_fuse;
+
         if (debug_fusion > 1 && n_fuse > 1) {
             if (n_fuse == 2) {
                 GGML_LOG_DEBUG("%s: fuse: %s + MUL\n", __func__, ggml_op_name(op->op));
@@ -2586,7 +2649,7 @@ int ggml_metal_op_norm(ggml_metal_op_t ctx, int idx) {
         }
     }
 
-    ggml_metal_pipeline_t pipeline = ggml_metal_library_get_pipeline_norm(lib, op, n_fuse);
+    ggml_metal_pipeline_t pipeline = ggml_metal_library_get_pipeline_norm(lib, op, n_kern);
 
     int nth = 32; // SIMD width
 
@@ -2778,6 +2841,61 @@ int ggml_metal_op_im2col(ggml_metal_op_t ctx, int idx) {
     return 1;
 }
 
+int ggml_metal_op_conv_1d(ggml_metal_op_t ctx, int idx) {
+    ggml_tensor * op = ctx->node(idx);
+
+    ggml_metal_library_t lib = ctx->lib;
+    ggml_metal_encoder_t enc = ctx->enc;
+
+    GGML_TENSOR_LOCALS( int32_t, ne0, op->src[0], ne);
+    GGML_TENSOR_LOCALS(uint64_t, nb0, op->src[0], nb);
+    GGML_TENSOR_LOCALS( int32_t, ne1, op->src[1], ne);
+    GGML_TENSOR_LOCALS(uint64_t, nb1, op->src[1], nb);
+    GGML_TENSOR_LOCALS( int32_t, ne,  op,         ne);
+    GGML_TENSOR_LOCALS(uint64_t, nb,  op,         nb);
+
+    const int32_t * params = (const int32_t *)(op->op_params);
+
+    const bool has_bias = op->src[2] != nullptr;
+
+    ggml_metal_kargs_conv_1d args = {
+        /*.IC   =*/ ne11,
+        /*.IL   =*/ ne10,
+        /*.K    =*/ ne00,
+        /*.OL   =*/ ne0,
+        /*.OC   =*/ ne1,
+        /*.s0   =*/ params[0],
+        /*.p0   =*/ params[1],
+        /*.d0   =*/ params[2],
+        /*.bias =*/ has_bias ? 1 : 0,
+        /*.gelu =*/ params[3],
+        /*.nb00 =*/ nb00,
+        /*.nb01 =*/ nb01,
+        /*.nb02 =*/ nb02,
+        /*.nb11 =*/ nb11,
+        /*.nb12 =*/ nb12,
+        /*.nb0  =*/ nb0,
+        /*.nb1  =*/ nb1,
+        /*.nb2  =*/ nb2,
+    };
+
+    ggml_metal_pipeline_t pipeline = ggml_metal_library_get_pipeline_conv_1d(lib, op);
+
+    // one output position per thread, N_OC_CONV_1D output channels per thread
+    const int nth = std::min(64, ggml_metal_pipeline_max_theads_per_threadgroup(pipeline));
+
+    ggml_metal_encoder_set_pipeline(enc, pipeline);
+    ggml_metal_encoder_set_bytes   (enc, &args, sizeof(args), 0);
+    ggml_metal_encoder_set_buffer  (enc, ggml_metal_get_buffer_id(op->src[0]), 1);
+    ggml_metal_encoder_set_buffer  (enc, ggml_metal_get_buffer_id(op->src[1]), 2);
+    ggml_metal_encoder_set_buffer  (enc, ggml_metal_get_buffer_id(has_bias ? op->src[2] : op), 3);
+    ggml_metal_encoder_set_buffer  (enc, ggml_metal_get_buffer_id(op),         4);
+
+    ggml_metal_encoder_dispatch_threadgroups(enc, (ne0 + nth - 1)/nth, (ne1 + N_OC_CONV_1D - 1)/N_OC_CONV_1D, ne2, nth, 1, 1);
+
+    return 1;
+}
+
 int ggml_metal_op_conv_transpose_1d(ggml_metal_op_t ctx, int idx) {
     ggml_tensor * op = ctx->node(idx);
 
@@ -20,6 +20,20 @@ ggml_metal_op_t ggml_metal_op_init(
         int  debug_graph,
         int  debug_fusion);
 
+// encode with an encoder owned by the caller, e.g. one recording into an indirect command buffer
+// the encoder is not ended nor freed by ggml_metal_op_free()
+ggml_metal_op_t ggml_metal_op_init_enc(
+        ggml_metal_device_t dev,
+        ggml_metal_encoder_t enc,
+        struct ggml_cgraph * gf,
+        int  idx_start,
+        int  idx_end,
+        bool use_fusion,
+        bool use_concurrency,
+        bool use_capture,
+        int  debug_graph,
+        int  debug_fusion);
+
 void ggml_metal_op_free(ggml_metal_op_t ctx);
 
 int ggml_metal_op_n_nodes(ggml_metal_op_t ctx);
@@ -67,6 +81,7 @@ int ggml_metal_op_group_norm        (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_norm              (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_rope              (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_im2col            (ggml_metal_op_t ctx, int idx);
+int ggml_metal_op_conv_1d           (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_conv_transpose_1d (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_upscale           (ggml_metal_op_t ctx, int idx);
 int ggml_metal_op_pad               (ggml_metal_op_t ctx, int idx);
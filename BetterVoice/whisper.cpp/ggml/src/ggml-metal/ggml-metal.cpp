@@ -362,6 +362,56 @@ static ggml_backend_buffer_type_t ggml_backend_metal_buffer_type_mapped(void) {
     return &ggml_backend_buffer_type_mapped_metal;
 }
 
+// host buffer type
+// shared memory that the CPU reads and writes in place, so a scheduler that puts the CPU tensors in it needs no
+// copies for the tensors used on both sides, e.g. the graph inputs. only offered with unified memory
+
+static const char * ggml_backend_metal_buffer_type_host_get_name(ggml_backend_buffer_type_t buft) {
+    return "Metal_Host";
+
+    GGML_UNUSED(buft);
+}
+
+static ggml_backend_buffer_t ggml_backend_metal_buffer_type_host_alloc_buffer(ggml_backend_buffer_type_t buft, size_t size) {
+    return ggml_backend_metal_buffer_type_alloc_buffer(buft, size, true);
+}
+
+static size_t ggml_backend_metal_buffer_type_host_get_alignment(ggml_backend_buffer_type_t buft) {
+    return 32;
+
+    GGML_UNUSED(buft);
+}
+
+static size_t ggml_backend_metal_buffer_type_host_get_max_size(ggml_backend_buffer_type_t buft) {
+    ggml_metal_device_t ctx_dev = (ggml_metal_device_t)buft->device->context;
+
+    return ggml_metal_device_get_props(ctx_dev)->max_buffer_size;
+}
+
+static bool ggml_backend_metal_buffer_type_host_is_host(ggml_backend_buffer_type_t buft) {
+    return true;
+
+    GGML_UNUSED(buft);
+}
+
+static ggml_backend_buffer_type_t ggml_backend_metal_buffer_type_host(void) {
+    // no .get_alloc_size - the CPU backend computes into these buffers, so the tensors need no Metal extras
+    static ggml_backend_buffer_type ggml_backend_buffer_type_host_metal = {
+        /* .iface = */ {
+            /* .get_name         = */ ggml_backend_metal_buffer_type_host_get_name,
+            /* .alloc_buffer     = */ ggml_backend_metal_buffer_type_host_alloc_buffer,
+            /* .get_alignment    = */ ggml_backend_metal_buffer_type_host_get_alignment,
+            /* .get_max_size     = */ ggml_backend_metal_buffer_type_host_get_max_size,
+            /* .get_alloc_size   = */ NULL,
+            /* .is_host          = */ ggml_backend_metal_buffer_type_host_is_host,
+        },
+        /* .device  = */ &g_ggml_metal_device,
+        /* .context = */ NULL,
+    };
+
+    return &ggml_backend_buffer_type_host_metal;
+}
+
 // backend
 
 static const char * ggml_backend_metal_name(ggml_backend_t backend) {
@@ -581,6 +631,12 @@ static ggml_backend_buffer_type_t ggml_backend_metal_device_get_buffer_type(ggml
     return props_dev->use_shared_buffers ? ggml_backend_metal_buffer_type_shared() : ggml_backend_metal_buffer_type_private();
 }
 
+static ggml_backend_buffer_type_t ggml_backend_metal_device_get_host_buffer_type(ggml_backend_dev_t dev) {
+    ggml_metal_device_t ctx_dev = (ggml_metal_device_t)dev->context;
+
+    return ggml_metal_device_get_props(ctx_dev)->use_shared_buffers ? ggml_backend_metal_buffer_type_host() : NULL;
+}
+
 static ggml_backend_buffer_t ggml_backend_metal_device_buffer_mapped(ggml_backend_dev_t dev, void * ptr, size_t size, size_t max_tensor_size) {
     ggml_metal_device_t ctx_dev = (ggml_metal_device_t)dev->context;
 
@@ -599,7 +655,8 @@ static bool ggml_backend_metal_device_supports_buft(ggml_backend_dev_t dev, ggml
     return
         buft->iface.get_name == ggml_backend_metal_buffer_type_shared_get_name ||
         buft->iface.get_name == ggml_backend_metal_buffer_type_private_get_name ||
-        buft->iface.get_name == ggml_backend_metal_buffer_type_mapped_get_name;
+        buft->iface.get_name == ggml_backend_metal_buffer_type_mapped_get_name ||
+        buft->iface.get_name == ggml_backend_metal_buffer_type_host_get_name;
 
     GGML_UNUSED(dev);
 }
@@ -634,7 +691,7 @@ static ggml_backend_device_i ggml_backend_metal_device_i = {
     /* .get_props            = */ ggml_backend_metal_device_get_props,
     /* .init_backend         = */ ggml_backend_metal_device_init,
     /* .get_buffer_type      = */ ggml_backend_metal_device_get_buffer_type,
-    /* .get_host_buffer_type = */ NULL,
+    /* .get_host_buffer_type = */ ggml_backend_metal_device_get_host_buffer_type,
     /* .buffer_from_host_ptr = */ ggml_backend_metal_device_buffer_mapped,
     /* .supports_op          = */ ggml_backend_metal_device_supports_op,
     /* .supports_buft        = */ ggml_backend_metal_device_supports_buft,
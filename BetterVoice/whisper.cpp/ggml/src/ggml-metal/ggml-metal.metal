@@ -4178,6 +4178,73 @@ template [[host_name("kernel_im2col_f16")]] kernel im2col_t kernel_im2col<half>;
 //template [[host_name("kernel_im2col_ext_f32")]] kernel im2col_ext_t kernel_im2col_ext<float>;
 //template [[host_name("kernel_im2col_ext_f16")]] kernel im2col_ext_t kernel_im2col_ext<half>;
 
+// each thread computes one output position for N_OC_CONV_1D output channels, reading the input directly (no im2col)
+// the bias and the GELU are applied before the result is written
+template <typename T>
+kernel void kernel_conv_1d(
+        constant ggml_metal_kargs_conv_1d & args,
+        device const char * src0,
+        device const char * src1,
+        device const char * src2,
+        device       char * dst,
+        uint3  tgpig[[threadgroup_position_in_grid]],
+        ushort tpitg[[thread_index_in_threadgroup]],
+        ushort   ntg[[threads_per_threadgroup]]) {
+    const int32_t ol  = tgpig.x*ntg + tpitg;
+    const int32_t oc0 = tgpig.y*N_OC_CONV_1D;
+    const int32_t i2  = tgpig.z;
+
+    if (ol >= args.OL) {
+        return;
+    }
+
+    float acc[N_OC_CONV_1D] = { 0.0f };
+
+    // rows past OC read the last channel and are not written
+    device const char * w[N_OC_CONV_1D];
+    for (short j = 0; j < N_OC_CONV_1D; ++j) {
+        w[j] = src0 + min(oc0 + j, args.OC - 1)*args.nb02;
+    }
+
+    device const char * x = src1 + i2*args.nb12;
+
+    for (int32_t ic = 0; ic < args.IC; ++ic) {
+        device const float * xr = (device const float *) (x + ic*args.nb11);
+
+        for (int32_t k = 0; k < args.K; ++k) {
+            const int32_t ix = ol*args.s0 + k*args.d0 - args.p0;
+            if (ix < 0 || ix >= args.IL) {
+                continue;
+            }
+
+            const float v = xr[ix];
+
+            for (short j = 0; j < N_OC_CONV_1D; ++j) {
+                acc[j] += (float) *((device const T *) (w[j] + ic*args.nb01 + k*args.nb00)) * v;
+            }
+        }
+    }
+
+    for (short j = 0; j < N_OC_CONV_1D && oc0 + j < args.OC; ++j) {
+        float v = acc[j];
+
+        if (args.bias) {
+            v += ((device const float *) src2)[oc0 + j];
+        }
+
+        if (args.gelu) {
+            v = 0.5f*v*(1.0f + precise::tanh(SQRT_2_OVER_PI*v*(1.0f + GELU_COEF_A*v*v)));
+        }
+
+        *((device float *) (dst + ol*args.nb0 + (oc0 + j)*args.nb1 + i2*args.nb2)) = v;
+    }
+}
+
+typedef decltype(kernel_conv_1d<float>) kernel_conv_1d_t;
+
+template [[host_name("kernel_conv_1d_f32_f32")]] kernel kernel_conv_1d_t kernel_conv_1d<float>;
+template [[host_name("kernel_conv_1d_f16_f32")]] kernel kernel_conv_1d_t kernel_conv_1d<half>;
+
 typedef void (conv_transpose_1d_t)(
         constant ggml_metal_kargs_conv_transpose_1d & args,
         device const float * src0,
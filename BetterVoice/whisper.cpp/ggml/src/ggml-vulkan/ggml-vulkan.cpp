@@ -227,6 +227,9 @@ class vk_perf_logger;
 static void ggml_vk_destroy_buffer(vk_buffer& buf);
 
 static constexpr uint32_t mul_mat_vec_max_cols = 8;
+
+// output channels per invocation of the conv_1d shader
+static constexpr uint32_t conv1d_num_oc = 8;
 static constexpr uint32_t p021_max_gqa_ratio = 8;
 
 enum vk_device_architecture {
@@ -572,6 +575,7 @@ struct vk_device_struct {
     vk_pipeline pipeline_im2col_3d_f32, pipeline_im2col_3d_f32_f16;
     vk_pipeline pipeline_timestep_embedding_f32;
     vk_pipeline pipeline_conv_transpose_1d_f32;
+    vk_pipeline pipeline_conv1d_f32, pipeline_conv1d_f16_f32;
     vk_pipeline pipeline_pool2d_f32;
     vk_pipeline pipeline_rwkv_wkv6_f32;
     vk_pipeline pipeline_rwkv_wkv7_f32;
@@ -1056,6 +1060,29 @@ struct vk_op_conv_transpose_1d_push_constants {
     int32_t s0;
 };
 
+struct vk_op_conv1d_push_constants {
+    uint32_t IC;
+    uint32_t IL;
+    uint32_t K;
+    uint32_t OL;
+    uint32_t OC;
+
+    int32_t s0;
+    int32_t p0;
+    int32_t d0;
+
+    uint32_t bias;
+    uint32_t gelu;
+
+    uint32_t nb00;
+    uint32_t nb01;
+    uint32_t nb02;
+    uint32_t nb11;
+    uint32_t nb12;
+    uint32_t nb1;
+    uint32_t nb2;
+};
+
 struct vk_op_pool2d_push_constants {
     uint32_t IW; uint32_t IH;
     uint32_t OW; uint32_t OH;
@@ -3571,6 +3598,12 @@ static void ggml_vk_load_shaders(vk_device& device) {
 
     ggml_vk_create_pipeline(device, device->pipeline_conv_transpose_1d_f32, "conv_transpose_1d_f32", conv_transpose_1d_f32_len, conv_transpose_1d_f32_data, "main", 3, sizeof(vk_op_conv_transpose_1d_push_constants), {1, 1, 1}, {}, 1);
 
+#if defined(GGML_VULKAN_CONV_1D)
+    // 64 output positions x conv1d_num_oc output channels per workgroup
+    ggml_vk_create_pipeline(device, device->pipeline_conv1d_f32,     "conv1d_f32",     conv1d_f32_len,     conv1d_f32_data,     "main", 4, sizeof(vk_op_conv1d_push_constants), {64, conv1d_num_oc, 1}, {64, conv1d_num_oc}, 1);
+    ggml_vk_create_pipeline(device, device->pipeline_conv1d_f16_f32, "conv1d_f16_f32", conv1d_f16_f32_len, conv1d_f16_f32_data, "main", 4, sizeof(vk_op_conv1d_push_constants), {64, conv1d_num_oc, 1}, {64, conv1d_num_oc}, 1);
+#endif
+
     ggml_vk_create_pipeline(device, device->pipeline_pool2d_f32, "pool2d_f32", pool2d_f32_len, pool2d_f32_data, "main", 2, sizeof(vk_op_pool2d_push_constants), {512, 1, 1}, {}, 1);
 
     ggml_vk_create_pipeline(device, device->pipeline_rwkv_wkv6_f32, "rwkv_wkv6_f32", rwkv_wkv6_f32_len, rwkv_wkv6_f32_data, "main", 7, sizeof(vk_op_rwkv_wkv6_push_constants), {1, 1, 1}, {device->subgroup_size}, 1);
@@ -8057,6 +8090,16 @@ static vk_pipeline ggml_vk_op_get_pipeline(ggml_backend_vk_context * ctx, const
             return ctx->device->pipeline_conv_transpose_1d_f32;
         }
         return nullptr;
+    case GGML_OP_CONV_1D:
+        if (src1->type == GGML_TYPE_F32 && dst->type == GGML_TYPE_F32) {
+            if (src0->type == GGML_TYPE_F32) {
+                return ctx->device->pipeline_conv1d_f32;
+            }
+            if (src0->type == GGML_TYPE_F16) {
+                return ctx->device->pipeline_conv1d_f16_f32;
+            }
+        }
+        return nullptr;
     case GGML_OP_POOL_2D:
         if (src0->type == GGML_TYPE_F32 && dst->type == GGML_TYPE_F32) {
             return ctx->device->pipeline_pool2d_f32;
@@ -8172,6 +8215,7 @@ static bool ggml_vk_op_supports_incontiguous(ggml_op op) {
     case GGML_OP_ROPE:
     case GGML_OP_RMS_NORM:
     case GGML_OP_CONV_2D_DW:
+    case GGML_OP_CONV_1D:
     case GGML_OP_IM2COL:
     case GGML_OP_IM2COL_3D:
     case GGML_OP_SET_ROWS:
@@ -8512,6 +8556,10 @@ static void ggml_vk_op_f32(ggml_backend_vk_context * ctx, vk_context& subctx, co
         {
             elements = {uint32_t(src0->ne[1]), 1, 1}; // parallelize in {Cout, 1, 1}
         } break;
+    case GGML_OP_CONV_1D:
+        {
+            elements = { (uint32_t)ned0, (uint32_t)ned1, (uint32_t)ned2 }; // {OL, OC, N}
+        } break;
     case GGML_OP_POOL_2D:
         {
             const uint32_t N = dst->ne[3];
@@ -8652,6 +8700,16 @@ static void ggml_vk_op_f32(ggml_backend_vk_context * ctx, vk_context& subctx, co
         }
 
         ggml_vk_dispatch_pipeline(ctx, subctx, pipeline, { vk_subbuffer{ d_X, x_buf_offset, x_sz }, subbuf_y, subbuf_z, vk_subbuffer{ d_D, d_buf_offset, d_sz } }, pc, elements);
+    } else if (op == GGML_OP_CONV_1D) {
+        // Empty src2 (no bias) is possible in conv_1d, but the shader needs a buffer
+        vk_subbuffer subbuf_z;
+        if (use_src2) {
+            subbuf_z = { d_Z, z_buf_offset, z_sz };
+        } else {
+            subbuf_z = { d_X, 0, x_sz };
+        }
+
+        ggml_vk_dispatch_pipeline(ctx, subctx, pipeline, { vk_subbuffer{ d_X, x_buf_offset, x_sz }, vk_subbuffer{ d_Y, y_buf_offset, y_sz }, subbuf_z, vk_subbuffer{ d_D, d_buf_offset, d_sz } }, pc, elements);
     } else if (op == GGML_OP_ROPE || op == GGML_OP_ROPE_BACK) {
         // Empty src2 is possible in rope, but the shader needs a buffer
         vk_subbuffer subbuf_z;
@@ -9640,6 +9698,45 @@ static void ggml_vk_conv_transpose_1d(ggml_backend_vk_context * ctx, vk_context&
     ggml_vk_op_f32(ctx, subctx, src0, src1, nullptr, dst, GGML_OP_CONV_TRANSPOSE_1D, std::move(p), dryrun);
 }
 
+static void ggml_vk_conv_1d(ggml_backend_vk_context * ctx, vk_context& subctx, const ggml_tensor * src0, const ggml_tensor * src1, const ggml_tensor * src2, ggml_tensor * dst, bool dryrun = false) {
+    // src0: (K, IC, OC, 1) -- kernel
+    // src1: (IL, IC, N, 1) -- input
+    // src2: (OC) -- bias, or NULL
+    // dst: (OL, OC, N, 1)
+
+    GGML_ASSERT(src0->type == GGML_TYPE_F32 || src0->type == GGML_TYPE_F16);
+    GGML_ASSERT(src1->type == GGML_TYPE_F32);
+    GGML_ASSERT( dst->type == GGML_TYPE_F32);
+
+    GGML_TENSOR_BINARY_OP_LOCALS
+
+    GGML_ASSERT(nb10 == sizeof(float));
+    GGML_ASSERT(nb0  == sizeof(float));
+
+    const int32_t * params = (const int32_t *) dst->op_params;
+
+    vk_op_conv1d_push_constants p{};
+    p.IC   = static_cast<uint32_t>(ne11);
+    p.IL   = static_cast<uint32_t>(ne10);
+    p.K    = static_cast<uint32_t>(ne00);
+    p.OL   = static_cast<uint32_t>(ne0);
+    p.OC   = static_cast<uint32_t>(ne1);
+    p.s0   = params[0];
+    p.p0   = params[1];
+    p.d0   = params[2];
+    p.bias = src2 != nullptr ? 1 : 0;
+    p.gelu = params[3] != 0 ? 1 : 0;
+    p.nb00 = static_cast<uint32_t>(nb00 / ggml_type_size(src0->type));
+    p.nb01 = static_cast<uint32_t>(nb01 / ggml_type_size(src0->type));
+    p.nb02 = static_cast<uint32_t>(nb02 / ggml_type_size(src0->type));
+    p.nb11 = static_cast<uint32_t>(nb11 / nb10);
+    p.nb12 = static_cast<uint32_t>(nb12 / nb10);
+    p.nb1  = static_cast<uint32_t>(nb1 / nb0);
+    p.nb2  = static_cast<uint32_t>(nb2 / nb0);
+
+    ggml_vk_op_f32(ctx, subctx, src0, src1, src2, dst, GGML_OP_CONV_1D, std::move(p), dryrun);
+}
+
 static void ggml_vk_pool_2d(ggml_backend_vk_context * ctx, vk_context& subctx, const ggml_tensor * src0, ggml_tensor * dst, bool dryrun = false) {
     uint32_t op = static_cast<uint32_t>(dst->op_params[0]);
     const int32_t k1 = dst->op_params[1];
@@ -10856,6 +10953,7 @@ static bool ggml_vk_build_graph(ggml_backend_vk_context * ctx, ggml_cgraph * cgr
     case GGML_OP_IM2COL_3D:
     case GGML_OP_TIMESTEP_EMBEDDING:
     case GGML_OP_CONV_TRANSPOSE_1D:
+    case GGML_OP_CONV_1D:
     case GGML_OP_POOL_2D:
     case GGML_OP_CONV_2D:
     case GGML_OP_CONV_TRANSPOSE_2D:
@@ -10928,6 +11026,7 @@ static bool ggml_vk_build_graph(ggml_backend_vk_context * ctx, ggml_cgraph * cgr
         case GGML_OP_IM2COL_3D:
         case GGML_OP_TIMESTEP_EMBEDDING:
         case GGML_OP_CONV_TRANSPOSE_1D:
+        case GGML_OP_CONV_1D:
         case GGML_OP_POOL_2D:
         case GGML_OP_CONV_2D:
         case GGML_OP_CONV_TRANSPOSE_2D:
@@ -11234,6 +11333,10 @@ static bool ggml_vk_build_graph(ggml_backend_vk_context * ctx, ggml_cgraph * cgr
     case GGML_OP_CONV_TRANSPOSE_1D:
         ggml_vk_conv_transpose_1d(ctx, compute_ctx, src0, src1, node, dryrun);
 
+        break;
+    case GGML_OP_CONV_1D:
+        ggml_vk_conv_1d(ctx, compute_ctx, src0, src1, src2, node, dryrun);
+
         break;
     case GGML_OP_POOL_2D:
         ggml_vk_pool_2d(ctx, compute_ctx, src0, node, dryrun);
@@ -11384,6 +11487,7 @@ static bool ggml_vk_compute_forward(ggml_backend_vk_context * ctx, ggml_cgraph *
     case GGML_OP_IM2COL_3D:
     case GGML_OP_TIMESTEP_EMBEDDING:
     case GGML_OP_CONV_TRANSPOSE_1D:
+    case GGML_OP_CONV_1D:
     case GGML_OP_POOL_2D:
     case GGML_OP_CONV_2D:
     case GGML_OP_CONV_TRANSPOSE_2D:
@@ -12872,6 +12976,18 @@ static bool ggml_backend_vk_device_supports_op(ggml_backend_dev_t dev, const ggm
             return true;
         case GGML_OP_CONV_TRANSPOSE_1D:
             return op->src[0]->type == GGML_TYPE_F32 && op->src[1]->type == GGML_TYPE_F32;
+        case GGML_OP_CONV_1D:
+            // the shader is only built with GGML_VULKAN_CONV_1D until it has been validated with test-backend-ops,
+            // without it whisper keeps the im2col conv stem
+#if defined(GGML_VULKAN_CONV_1D)
+            return (op->src[0]->type == GGML_TYPE_F32 || op->src[0]->type == GGML_TYPE_F16) &&
+                op->src[1]->type == GGML_TYPE_F32 &&
+                op->type == GGML_TYPE_F32 &&
+                ggml_is_contiguous_rows(op->src[1]) &&
+                ggml_is_contiguous(op);
+#else
+            return false;
+#endif
         case GGML_OP_CONV_2D:
         case GGML_OP_CONV_TRANSPOSE_2D:
             {
@@ -13488,6 +13604,12 @@ static void ggml_vk_check_results_0(ggml_backend_vk_context * ctx, ggml_cgraph *
         const int32_t p0 = tensor->op_params[1];
         const int32_t d0 = tensor->op_params[2];
         tensor_clone = ggml_conv_transpose_1d(ggml_ctx, src_clone[0], src_clone[1], s0, p0, d0);
+    } else if (tensor->op == GGML_OP_CONV_1D) {
+        const int32_t s0 = tensor->op_params[0];
+        const int32_t p0 = tensor->op_params[1];
+        const int32_t d0 = tensor->op_params[2];
+        const bool gelu  = tensor->op_params[3] != 0;
+        tensor_clone = ggml_conv_1d_direct(ggml_ctx, src_clone[0], src_clone[1], src_clone[2], s0, p0, d0, gelu);
     } else if (tensor->op == GGML_OP_POOL_2D) {
         enum ggml_op_pool op = static_cast<ggml_op_pool>(tensor->op_params[0]);
         const int32_t k0 = tensor->op_params[1];
@@ -789,6 +789,11 @@ void process_shaders() {
 
     string_to_spv("conv_transpose_1d_f32", "conv_transpose_1d.comp", {{"A_TYPE", "float"},  {"B_TYPE", "float"}, {"D_TYPE", "float"}});
 
+#if defined(GGML_VULKAN_CONV_1D)
+    string_to_spv("conv1d_f32",     "conv1d.comp", {{"A_TYPE", "float"},     {"B_TYPE", "float"}, {"D_TYPE", "float"}});
+    string_to_spv("conv1d_f16_f32", "conv1d.comp", {{"A_TYPE", "float16_t"}, {"B_TYPE", "float"}, {"D_TYPE", "float"}});
+#endif
+
     string_to_spv("pool2d_f32", "pool2d.comp", merge_maps(base_dict, {{"A_TYPE", "float"}, {"D_TYPE", "float"}}));
 
     string_to_spv("rwkv_wkv6_f32", "wkv6.comp", merge_maps(base_dict, {{"A_TYPE", "float"}}));
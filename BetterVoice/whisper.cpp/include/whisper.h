@@ -113,6 +113,33 @@ extern "C" {
         const whisper_ahead * heads;
     } whisper_aheads;
 
+    // called for each node of the graphs computed by the states of a context, same as ggml_backend_sched_eval_callback:
+    // with ask == true, return whether the node should be observed; with ask == false its data is computed,
+    // return false to stop the computation. The weight tensors are named as in the model file
+    typedef bool (*whisper_eval_callback)(struct ggml_tensor * t, bool ask, void * user_data);
+
+    // compute units the Core ML encoder may run on (WHISPER_COREML builds)
+    enum whisper_coreml_units {
+        WHISPER_COREML_UNITS_ALL,
+        WHISPER_COREML_UNITS_CPU_ONLY,
+        WHISPER_COREML_UNITS_CPU_AND_GPU,
+        WHISPER_COREML_UNITS_CPU_AND_NE, // macOS 13 / iOS 16, ALL before
+    };
+
+    // where the text decoder runs when a GPU is used
+    enum whisper_decoder_placement {
+        WHISPER_DECODER_PLACEMENT_GPU, // with the encoder
+        WHISPER_DECODER_PLACEMENT_CPU, // on the CPU, the cross-attention K/V projection stays on the GPU
+    };
+
+    // GELU of the encoder and decoder MLPs on the CPU
+    enum whisper_gelu_type {
+        WHISPER_GELU_TABLE, // tanh approximation, F16 lookup table (max abs error ~4e-3)
+        WHISPER_GELU_FAST,  // tanh approximation, F32 SIMD via exp (max rel error ~1e-6)
+        WHISPER_GELU_ERF,   // exact erf GELU, F32 (slowest)
+    };
+
+    // new fields go at the end: the Java bindings (WhisperContextParams.java) pass this struct by value
     struct whisper_context_params {
         bool  use_gpu;
         bool  flash_attn;
@@ -126,6 +153,151 @@ extern "C" {
         struct whisper_aheads dtw_aheads;
 
         size_t dtw_mem_size; // TODO: remove
+
+        // [EXPERIMENTAL] type of the self- and cross-attention KV caches: GGML_TYPE_F16, or GGML_TYPE_Q8_0 / GGML_TYPE_Q4_0
+        // to reduce the memory of each state. The quantized types require flash_attn
+        enum ggml_type type_kv;
+
+        // [EXPERIMENTAL] map the model file instead of reading it, for whisper_init_from_file_with_params*()
+        // The weights used on the CPU, or on a GPU that shares host memory (Metal), stay in the file pages,
+        // which are read on first use and shared with other processes mapping the same file.
+        // Tensors that are not aligned in the file for their backend are read as before
+        bool use_mmap;
+
+        // place the encoder and decoder matrices that stay on the CPU in the extra CPU buffer types, which repack
+        // Q4_0, Q4_K, Q2_K and IQ4_NL weights into the interleaved layouts of the CPU matrix multiplication kernels
+        // (AVX2/AVX512 on x86, NEON dotprod/i8mm and SVE on ARM) or use AMX. The repacked weights are not mapped
+        bool use_extra_bufts;
+
+        // [EXPERIMENTAL] (Linux) allocate the weights, the KV caches and the compute buffers that are on the CPU in 2 MiB
+        // huge pages, taken from the reserved ones (vm.nr_hugepages) or else transparent, so that the encoder streaming
+        // the weights misses the TLB less. With use_mmap, the mapped model file is advised to transparent huge pages,
+        // which the kernel only applies to file pages if it supports them. The buffers round up to 2 MiB
+        bool use_hugepages;
+
+        // GELU used by the MLPs on the CPU, see whisper_gelu_type. GPU backends compute GELU in F32 either way
+        enum whisper_gelu_type gelu_type;
+
+        // [EXPERIMENTAL] with WHISPER_DECODER_PLACEMENT_CPU the encoder runs on the GPU and the decoder on the CPU, for
+        // GPUs whose dispatch overhead costs more than the small decoder batches. The decoder weights and KV caches
+        // are allocated in CPU memory; the GPU writes the cross-attention KV cache in place if it can map host
+        // memory (Metal, CUDA), otherwise the cache is copied to the CPU once per encode
+        enum whisper_decoder_placement decoder_placement;
+
+        // [EXPERIMENTAL] GPU of the text decoder with WHISPER_DECODER_PLACEMENT_GPU, -1 for gpu_device. With another GPU,
+        // the encoder runs on gpu_device and the decoder, the cross-attention K/V projection and the KV caches on this
+        // one; the encoder output is copied over once per encode
+        int decoder_gpu_device;
+
+        // [EXPERIMENTAL] on a GPU, the generation steps of the decoder view all the cells of the self-attention cache
+        // instead of a view that grows with the tokens, so that their graphs keep the same shape from one token to
+        // the next and the CUDA backend replays its captured graph instead of capturing a new one. Not validated on
+        // CUDA yet
+        bool decoder_graph_fixed;
+
+        // [EXPERIMENTAL] "host:port" of a ggml-rpc server (GGML_RPC builds) that runs the conv and encoder graphs, nullptr
+        // to encode locally. The encoder weights are uploaded once per context; the decoder and the cross-attention K/V
+        // projection stay on the local devices, so only the mel and the encoder output (as F16) cross the network.
+        // decoder_gpu_device is ignored
+        const char * rpc_encoder;
+
+        // Core ML encoder (WHISPER_COREML builds), see whisper_coreml_units
+        enum whisper_coreml_units coreml_units;
+
+        // [EXPERIMENTAL] after each Core ML encode, encode the window that follows it in the background while the
+        // decoder runs. The result is used if the next encode is of that window - consecutive 30 s windows, as with
+        // no_timestamps or single_segment - and dropped otherwise, so it only pays off for such transcriptions
+        bool coreml_async;
+
+        // [EXPERIMENTAL] run the text decoder with the stateful Core ML decoder <model>-decoder.mlmodelc (macOS 15 /
+        // iOS 18, see models/generate-coreml-model.sh) on coreml_units. It is used for the temperature attempts of
+        // whisper_full() with a single decoder - greedy sampling - and an F16 cross-attention cache, without
+        // dtw_token_timestamps; the draft model, device sampling and decoder early exit are not used with it
+        bool coreml_decoder;
+
+        // [EXPERIMENTAL] the same as coreml_async for the OpenVINO encoder (WHISPER_OPENVINO builds,
+        // whisper_ctx_init_openvino_encoder): the window that follows is encoded with an async infer request
+        bool openvino_async;
+
+        // [EXPERIMENTAL] file caching the compute buffer sizes whisper_init_state() measures by building and allocating
+        // the worst-case graphs. Later states and processes with the same model and configuration allocate the buffers
+        // from the cached sizes and build the graphs on first use instead. NULL to always measure
+        const char * path_sched_cache;
+
+        // [EXPERIMENTAL] give each state a persistent CPU threadpool instead of starting the threads for every graph.
+        // After a graph the threads poll for the next one for a while (cpu_poll), then sleep until the next graph.
+        // whisper_threadpool_pause() parks them, e.g. between dictations
+        bool                     cpu_threadpool;
+        uint32_t                 cpu_poll; // polling level, 0 - no polling, 100 - aggressive polling
+        enum ggml_sched_priority cpu_prio;
+        uint64_t                 cpu_mask; // CPUs the threads may run on, bit i - CPU i, 0 for any
+
+        // [EXPERIMENTAL] caller-owned CPU threadpool used by every state instead of its own (cpu_threadpool and the
+        // cpu_* settings are then ignored), e.g. the one attached to a llama_context with llama_attach_threadpool(),
+        // so the two models do not run two sets of threads competing for the same cores. The encode and decode
+        // passes of the contexts sharing it take turns, see whisper_shared_threadpool_lock(). The n_threads of the
+        // passes should not exceed its size, ggml clamps them. NULL for none
+        ggml_threadpool_t        cpu_threadpool_shared;
+
+        // [EXPERIMENTAL] memory budget in bytes of the model and each state, 0 for no limit. While the estimate of
+        // whisper_memory_estimate() exceeds it, the context enables flash_attn (unless dtw_token_timestamps is set)
+        // and then quantizes the KV caches to Q8_0 and Q4_0; it fails to load if that is not enough. whisper_full()
+        // lowers beam_size and best_of to the number of decoders whose self-attention KV cache fits
+        size_t max_memory;
+
+        // [EXPERIMENTAL] keep the output of the encoder conv stem in each state and, when the next window comes from the
+        // incremental mel cache (whisper_pcm_to_mel_append_with_state) and overlaps the last one, only recompute the
+        // frames of the new audio. A frame is reused only if the mel frames it depends on are unchanged, so the output
+        // is the same as without the cache; the mel normalization follows the loudest frame of the window, and a new
+        // maximum recomputes the whole window. Not used with an external (Core ML, OpenVINO) encoder
+        bool encoder_conv_cache;
+
+        // [EXPERIMENTAL] encoder self-attention for models fine-tuned for streaming: 0 - full attention, N > 0 - each
+        // frame (20 ms) attends to the frames of its block of N frames and of the blocks before it, 1 - causal.
+        // The original Whisper models need full attention
+        int encoder_attn_chunk;
+
+        // [EXPERIMENTAL] bytes of F32 copies of the F16 and quantized weights that each state keeps for the BLAS backend
+        // (GGML_BLAS builds, Accelerate on macOS), which otherwise converts them for every large matrix multiplication.
+        // Only the encoder and the prompt pass (batches of 32 and more) run on BLAS, and only without a GPU. 0 for none
+        size_t blas_weight_cache;
+
+        // [EXPERIMENTAL] on a machine with several NUMA nodes (Linux), copy the weights that stay on the CPU to the memory
+        // of each node and bind the states to the nodes in turn, in the order they are created. A state computes with
+        // the copy of its node, allocates its KV caches and compute buffers there, and runs its CPU threads - a
+        // persistent threadpool, as with cpu_threadpool, in place of cpu_mask - and the thread calling it on the CPUs
+        // of the node. Costs one copy of the CPU weights per node other than the one the model was loaded on. No-op on
+        // a single node, see whisper_numa_node_from_state()
+        bool numa_replicate;
+
+        // [EXPERIMENTAL] keep only two encoder layers of weights in memory: the weights of each layer are read from the
+        // model file (or its mapping) into one of two rotating buffers of its device, the next layer while the current
+        // one computes. The conv stem, the decoder and the other weights stay resident. Saves the memory of all but
+        // two encoder layers for the time of reading them at every encode; the encoders of the states of the context
+        // take turns. Only for models loaded from a file, not with numa_replicate or blas_weight_cache
+        bool encoder_stream_weights;
+
+        // [EXPERIMENTAL] compute the log-mel spectrogram in the conv graph of the encoder, on its backend: the windowed
+        // STFT as a matrix multiplication with a DFT basis, the power, the mel filterbank, log10, clamp and normalize.
+        // whisper_pcm_to_mel_with_state() then only keeps the padded audio and each encode uploads the samples of its
+        // window instead of the mel. The clamp follows the loudest frame of the window instead of the whole audio, the
+        // same for up to 30 s of audio. The features that read the mel on the CPU (external encoders, encoder_conv_cache,
+        // language detection, pipelining, ...) compute it there on first use
+        bool encoder_mel_gpu;
+
+        // keep the alignment heads QKs of each decoding step and align the tokens of a window from them, so that the
+        // timestamps are ready for the new_segment_callback without decoding the window again. Used when the window
+        // is decoded by a single decoder without draft model or early exit, else the tokens are decoded again
+        bool dtw_incremental;
+
+        // [EXPERIMENTAL] observe the computation, e.g. to collect activation statistics (examples/imatrix)
+        whisper_eval_callback cb_eval;
+        void * cb_eval_user_data;
+
+        // [EXPERIMENTAL] time every node of the conv, encoder, cross and decoder graphs of each state, see
+        // whisper_print_profile(). The graphs are computed node by node without op fusion, so the run is slower
+        // and the times include a dispatch and synchronization per node: compare shares, not totals
+        bool profile;
     };
 
     typedef struct whisper_token_data {
@@ -196,12 +368,19 @@ extern "C" {
         float max_speech_duration_s;   // Max duration of a speech segment before forcing a new segment.
         int   speech_pad_ms;           // Padding added before and after speech segments.
         float samples_overlap;         // Overlap in seconds when copying audio samples from speech segment.
+
+        // [EXPERIMENTAL] Energy pre-gate, 0 = off. Audio with less than min_speech_duration_ms of 20 ms frames
+        // above this RMS level (with a zero-crossing rate of speech rather than hiss) is taken as silence before
+        // the VAD model runs - and whisper_full() returns no segments for it without running the encoder,
+        // also with vad off.
+        float energy_thold;
     } whisper_vad_params;
 
     WHISPER_API const char * whisper_version(void);
 
     // Various functions for loading a ggml whisper model.
     // Allocate (almost) all memory needed for the model.
+    // The file functions also accept GGUF models (see examples/quantize), the buffer and loader ones do not.
     // Return NULL on failure
     WHISPER_API struct whisper_context * whisper_init_from_file_with_params  (const char * path_model,              struct whisper_context_params params);
     WHISPER_API struct whisper_context * whisper_init_from_buffer_with_params(void * buffer, size_t buffer_size,    struct whisper_context_params params);
@@ -240,16 +419,23 @@ extern "C" {
 
     WHISPER_API struct whisper_state * whisper_init_state(struct whisper_context * ctx);
 
+    // The default state of the context, i.e. the one of the functions without a state argument
+    // NULL for a context created with the _no_state variants
+    WHISPER_API struct whisper_state * whisper_get_state(struct whisper_context * ctx);
+
     // Given a context, enable use of OpenVINO for encode inference.
     // model_path: Optional path to OpenVINO encoder IR model. If set to nullptr,
     //                      the path will be generated from the ggml model path that was passed
     //                      in to whisper_init_from_file. For example, if 'path_model' was
     //                      "/path/to/ggml-base.en.bin", then OpenVINO IR model path will be
     //                      assumed to be "/path/to/ggml-base.en-encoder-openvino.xml".
-    // device: OpenVINO device to run inference on ("CPU", "GPU", etc.)
+    // device: OpenVINO device to run inference on ("CPU", "GPU", "NPU", etc.)
     // cache_dir: Optional cache directory that can speed up init time, especially for
-    //                     GPU, by caching compiled 'blobs' there.
-    //                     Set to nullptr if not used.
+    //                     GPU and NPU, by caching compiled 'blobs' there. If set to nullptr, the
+    //                     directory next to the model, "/path/to/ggml-base.en-encoder-openvino-cache",
+    //                     is used. It is created and populated on the first run on a device.
+    // The states initialized with the same model_path, device and cache_dir share the compiled model,
+    // each with its own infer request.
     // Returns 0 on success. If OpenVINO is not enabled in build, this simply returns 1.
     WHISPER_API int whisper_ctx_init_openvino_encoder_with_state(
         struct whisper_context * ctx,
@@ -264,6 +450,32 @@ extern "C" {
                     const char * device,
                     const char * cache_dir);
 
+    // LoRA adapters of the decoder: low-rank updates of the self-attention, cross-attention query/output and MLP
+    // weights, e.g. fine-tuned on domain vocabulary instead of passing it in every initial_prompt.
+    // The base weights are left as they are: the updates are extra matrix products of the decoder graph, so each
+    // state can decode with its own adapter while sharing the model. See models/convert-lora-to-ggml.py
+    // Returns NULL if the file cannot be read, was made for a model with other dimensions or updates other weights
+    // (the cross-attention key/value are computed once per window from the encoder output and cannot be adapted)
+    struct whisper_lora_adapter;
+
+    WHISPER_API struct whisper_lora_adapter * whisper_lora_adapter_init(struct whisper_context * ctx, const char * path_lora);
+    WHISPER_API void whisper_lora_adapter_free(struct whisper_lora_adapter * adapter);
+
+    // Decode with adapter on the state from the next call on, its updates multiplied by scale (1.0 as trained)
+    // NULL or a scale of 0 removes the adapter. The adapter must outlive its use by the state
+    // whisper_decode_multi() runs states with different adapters one after the other
+    // Returns 0 on success
+    WHISPER_API int whisper_set_lora_adapter_with_state(
+            struct whisper_context * ctx,
+              struct whisper_state * state,
+       struct whisper_lora_adapter * adapter,
+                             float   scale);
+
+    WHISPER_API int whisper_set_lora_adapter(
+            struct whisper_context * ctx,
+       struct whisper_lora_adapter * adapter,
+                             float   scale);
+
     // Frees all allocated memory
     WHISPER_API void whisper_free      (struct whisper_context * ctx);
     WHISPER_API void whisper_free_state(struct whisper_state * state);
@@ -289,6 +501,7 @@ extern "C" {
     // This can be used to set a custom log mel spectrogram inside the default state of the provided whisper context.
     // Use this instead of whisper_pcm_to_mel() if you want to provide your own log mel spectrogram.
     // n_mel must be 80
+    // With data == NULL, the spectrogram is built from the incremental mel cache (see below)
     // Returns 0 on success
     WHISPER_API int whisper_set_mel(
             struct whisper_context * ctx,
@@ -303,6 +516,75 @@ extern "C" {
                                int   n_len,
                                int   n_mel);
 
+    // Incremental log mel spectrogram for push-style streaming.
+    // Appends n_samples of RAW PCM audio to a cache of log mel frames kept inside the state and computes
+    // only the frames completed by the new samples. The cache holds at most the last 30 seconds of frames.
+    // Call whisper_set_mel_with_state() with data == NULL to turn the cached window into the state's
+    // spectrogram, then whisper_full_with_state() with samples == NULL and n_samples == 0 to decode it.
+    // Returns 0 on success
+    WHISPER_API int whisper_pcm_to_mel_append_with_state(
+            struct whisper_context * ctx,
+              struct whisper_state * state,
+                       const float * samples,
+                               int   n_samples,
+                               int   n_threads);
+
+    // Drop cached frames so that the window covers only the last n_samples_keep samples.
+    // n_samples_keep <= 0 clears the cache and starts a new stream.
+    WHISPER_API void whisper_mel_cache_keep_with_state(struct whisper_state * state, int n_samples_keep);
+
+    // Number of samples covered by the current window of the mel cache
+    WHISPER_API int whisper_mel_cache_n_samples_with_state(struct whisper_state * state);
+
+    // Copy the mel cache of src to dst with the window covering the last n_samples_keep samples, or as many of them
+    // as are still cached, wherever the window of src starts. The frames are not recomputed, so another model with the
+    // same number of mel bands can decode the audio of a stream without its own log-mel pass.
+    // Returns 0 on success
+    WHISPER_API int whisper_mel_cache_copy_with_state(struct whisper_state * src, struct whisper_state * dst, int n_samples_keep);
+
+    // Sample encodings of the audio given to whisper_resampler
+    enum whisper_sample_format {
+        WHISPER_SAMPLE_FORMAT_F32 = 0, // float, full scale 1.0
+        WHISPER_SAMPLE_FORMAT_S16 = 1, // int16, full scale 32768
+    };
+
+    // Streaming conversion of captured audio to the WHISPER_SAMPLE_RATE mono F32 samples taken by the functions above:
+    // the interleaved channels are averaged and the result goes through a windowed-sinc polyphase FIR filter, flat up
+    // to 7.2 kHz and down by ~70 dB from 8 kHz for rates above 16 kHz. The filter keeps its history between calls, so
+    // audio converted block by block as it is captured gives the same samples as one call on the whole of it
+    struct whisper_resampler;
+
+    // Returns NULL for an unsupported sample rate: the ratio to 16 kHz must reduce to at most 1024/M
+    // (8, 11.025, 22.05, 24, 32, 44.1, 48, 88.2 and 96 kHz all do)
+    WHISPER_API struct whisper_resampler * whisper_resampler_init(
+                                       int   sample_rate,
+                                       int   n_channels,
+            enum whisper_sample_format   format);
+
+    WHISPER_API void whisper_resampler_free(struct whisper_resampler * rs);
+
+    // Upper bound of the number of samples written for n_frames more frames, by whisper_resample_to_16k() or by it
+    // and whisper_resampler_flush() together
+    WHISPER_API int whisper_resampler_n_out(struct whisper_resampler * rs, int n_frames);
+
+    // Convert n_frames frames and write the output samples they complete to out, which holds n_out_max samples
+    // The filter delay keeps the last few output samples until more input or whisper_resampler_flush()
+    // Returns the number of samples written, -1 if out is too small (the frames are then written by the next call)
+    WHISPER_API int whisper_resample_to_16k(
+            struct whisper_resampler * rs,
+                          const void * frames,
+                                 int   n_frames,
+                               float * out,
+                                 int   n_out_max);
+
+    // End of the stream: write the samples held back by the filter, as if the input continued with silence, and
+    // start a new stream
+    // Returns the number of samples written, -1 if out is too small
+    WHISPER_API int whisper_resampler_flush(
+            struct whisper_resampler * rs,
+                               float * out,
+                                 int   n_out_max);
+
     // Run the Whisper encoder on the log mel spectrogram stored inside the default state in the provided whisper context.
     // Make sure to call whisper_pcm_to_mel() or whisper_set_mel() first.
     // offset can be used to specify the offset of the first frame in the spectrogram.
@@ -318,6 +600,20 @@ extern "C" {
                                int   offset,
                                int   n_threads);
 
+    // Encode the first window of the mel spectrograms of several states with a single batched graph.
+    // The cross-attention KV of each clip is written into its own state, and the next
+    // whisper_full_with_state() of that state with n_samples == 0 skips encoding the first window.
+    // All clips use the same audio context (audio_ctx as in whisper_full_params, -1 sizes it for the longest clip).
+    // The graphs run on the compute buffers of states[0], which grow with the number of states.
+    // Not supported with Core ML / OpenVINO encoders.
+    // Returns 0 on success
+    WHISPER_API int whisper_encode_batch(
+            struct whisper_context * ctx,
+             struct whisper_state ** states,
+                               int   n_states,
+                               int   audio_ctx,
+                               int   n_threads);
+
     // Run the Whisper decoder to obtain the logits and probabilities for the next token.
     // Make sure to call whisper_encode() first.
     // tokens + n_tokens is the provided context for the decoder.
@@ -339,6 +635,23 @@ extern "C" {
                                int   n_past,
                                int   n_threads);
 
+    // Run the decoder for several independent states (sessions) in a single forward pass.
+    // tokens[i], n_tokens[i] and n_past[i] are the arguments of whisper_decode_with_state() for states[i],
+    // whose audio must have been encoded before. The logits are stored in each state.
+    // The dense layers run once for the tokens of all states, which raises the throughput when several
+    // sessions share one context. The graph runs on the compute buffers of states[0].
+    // A state may appear only once. If the KV cache of a state has no room for its tokens, none of the caches
+    // keeps the new tokens.
+    // Returns 0 on success
+    WHISPER_API int whisper_decode_multi(
+            struct whisper_context * ctx,
+             struct whisper_state ** states,
+            const whisper_token ** tokens,
+                         const int * n_tokens,
+                         const int * n_past,
+                               int   n_states,
+                               int   n_threads);
+
     // Convert the provided text into tokens.
     // The tokens pointer must be large enough to hold the resulting tokens.
     // Returns the number of tokens on success, no more than n_max_tokens
@@ -434,17 +747,151 @@ extern "C" {
     WHISPER_API whisper_token whisper_token_translate (struct whisper_context * ctx);
     WHISPER_API whisper_token whisper_token_transcribe(struct whisper_context * ctx);
 
-    // Performance information from the default state.
+    // Performance information from the default state (or a given state with the _from_state variants).
+    // The *_ms fields are per run, the *_total_ms fields and the counts are totals since the last reset
     struct whisper_timings {
         float sample_ms;
         float encode_ms;
         float decode_ms;
         float batchd_ms;
         float prompt_ms;
+
+        float mel_total_ms;
+        float vad_total_ms;    // whisper_full_params.vad
+        float denoise_total_ms; // whisper_full_params.denoise
+        float sample_total_ms;
+        float encode_total_ms;
+        float decode_total_ms; // single-token, batched and prompt decodes
+
+        int32_t n_encode;
+        int32_t n_decode;      // single-token, batched and prompt decodes
+        int32_t n_fallback;    // temperature fallbacks (logprob and entropy threshold failures)
+    };
+    // Counters and buffer sizes of a state, see whisper_get_metrics_with_state()
+    struct whisper_metrics {
+        int64_t t_mel_us;
+        int64_t t_vad_us;     // whisper_full_params.vad
+        int64_t t_denoise_us; // whisper_full_params.denoise
+        int64_t t_sample_us;
+        int64_t t_encode_us;
+        int64_t t_decode_us;  // decoder calls with a single token
+        int64_t t_batchd_us;  // decoder calls with a few tokens, one per decoder
+        int64_t t_prompt_us;  // decoder calls with the prompt
+
+        int32_t n_sample;
+        int32_t n_encode;
+        int32_t n_decode;
+        int32_t n_batchd;
+        int32_t n_prompt;
+        int32_t n_fail_p;     // logprob threshold failures
+        int32_t n_fail_h;     // entropy threshold failures
+
+        int64_t n_bytes_h2d;  // graph inputs written to buffers outside host memory (mel, tokens, masks)
+        int64_t n_bytes_d2h;  // graph outputs read back from buffers outside host memory (logits)
+
+        size_t mem_compute;   // compute buffers of the graphs
+        size_t mem_kv_self;
+        size_t mem_kv_cross;
+        size_t mem_kv_pad;
+
+        size_t rss_peak;      // peak resident set size of the process, 0 if unknown
     };
+
+    // Snapshot of the counters of the default state (or of a given state), cleared by whisper_reset_timings*().
+    // Can be called from any thread while the state computes: each counter is read atomically, the snapshot as
+    // a whole is not. The counters of the states of whisper_full_parallel() are added to the default state when
+    // it returns
+    WHISPER_API void whisper_get_metrics           (struct whisper_context * ctx,   struct whisper_metrics * metrics);
+    WHISPER_API void whisper_get_metrics_with_state(struct whisper_state   * state, struct whisper_metrics * metrics);
+
+    // Memory of the model and one state in bytes, as allocated with the given context parameters and grown by
+    // whisper_full() for n_decoders decoders (the larger of beam_size and best_of)
+    struct whisper_memory_budget {
+        size_t model;     // weights
+        size_t kv_self;
+        size_t kv_cross;
+        size_t kv_pad;
+        size_t compute;   // compute buffers of the conv, encoder, cross-attention and decoder graphs
+        size_t host;      // logits and sampling buffers of the decoders
+        size_t total;
+    };
+
+    // Predict the memory of whisper_init_from_file_with_params() before loading the model: only the hyperparameters
+    // are read, the weights are counted with their size in the file and the compute buffers with a model of the
+    // worst-case graphs, within a few MB of what the CPU and Metal backends allocate. The buffers are sized for the
+    // full audio context of the model whatever audio_ctx whisper_full() uses later. The Core ML and OpenVINO
+    // encoders and the DTW masks are not counted. Returns false if the file cannot be read
+    WHISPER_API bool whisper_memory_estimate(
+            const char * path_model,
+            struct whisper_context_params params,
+            int n_decoders,
+            struct whisper_memory_budget * budget);
+
     WHISPER_API struct whisper_timings * whisper_get_timings(struct whisper_context * ctx);
+    WHISPER_API struct whisper_timings * whisper_get_timings_from_state(struct whisper_state * state);
     WHISPER_API void whisper_print_timings(struct whisper_context * ctx);
     WHISPER_API void whisper_reset_timings(struct whisper_context * ctx);
+    WHISPER_API void whisper_reset_timings_from_state(struct whisper_state * state);
+
+    // Per-node profile of the default state (or a given state with the _from_state variants), collected with
+    // whisper_context_params.profile. whisper_print_profile() logs the time per backend and op and per layer
+    // (encoder.3, decoder.3, decoder.3.cross, ...); whisper_save_profile_trace() writes every node as an event
+    // of a Chrome trace (chrome://tracing, Perfetto). No-op without a profile
+    WHISPER_API void whisper_print_profile                 (struct whisper_context * ctx);
+    WHISPER_API void whisper_print_profile_from_state      (struct whisper_state   * state);
+    WHISPER_API bool whisper_save_profile_trace            (struct whisper_context * ctx,   const char * fname);
+    WHISPER_API bool whisper_save_profile_trace_from_state (struct whisper_state   * state, const char * fname);
+    WHISPER_API void whisper_reset_profile                 (struct whisper_context * ctx);
+    WHISPER_API void whisper_reset_profile_from_state      (struct whisper_state   * state);
+
+    // Phases of whisper_full() reported to external profilers. The spans nest: the language detection contains the
+    // ENCODE of its window and a FALLBACK contains the PROMPT, DECODE and LOGITS spans of its attempt
+    enum whisper_trace_phase {
+        WHISPER_TRACE_MEL,
+        WHISPER_TRACE_VAD,
+        WHISPER_TRACE_LANG_DETECT,
+        WHISPER_TRACE_ENCODE,
+        WHISPER_TRACE_PROMPT,   // the decode of the prompt of a window
+        WHISPER_TRACE_DECODE,   // the decode of the next token of the decoders
+        WHISPER_TRACE_LOGITS,   // the logit filters and probabilities of one decoder, on the worker threads
+        WHISPER_TRACE_FALLBACK, // a window decoded again at a higher temperature
+        WHISPER_TRACE_SEGMENT,  // the segments of a window, with the new_segment_callback calls
+        WHISPER_TRACE_COUNT,
+    };
+
+    typedef void (*whisper_trace_callback)(enum whisper_trace_phase phase, struct whisper_state * state, void * user_data);
+
+    struct whisper_trace_callbacks {
+        whisper_trace_callback begin;
+        whisper_trace_callback end;
+        void * user_data;
+    };
+
+    // Begin/end hooks around the phases of whisper_full(), for all contexts. The callbacks run on the thread of the
+    // phase, LOGITS on several threads at once, and must not call back into the library. Set them while nothing
+    // transcribes, NULL to remove them. On Apple platforms the phases are also os_signpost intervals of the
+    // "org.ggml.whisper" subsystem, shown in the Points of Interest track of Instruments.
+    // The hooks exist in builds with WHISPER_TRACE only and compile out otherwise: whisper_trace_set() then
+    // returns false
+    WHISPER_API bool         whisper_trace_set       (const struct whisper_trace_callbacks * callbacks);
+    WHISPER_API const char * whisper_trace_phase_name(enum whisper_trace_phase phase);
+
+    // Park or wake the threads of the CPU threadpool of the default state (or a given state with the _from_state
+    // variants), see whisper_context_params.cpu_threadpool. A computation on a paused threadpool resumes it.
+    // No-op without a threadpool, or with a shared one (cpu_threadpool_shared), which is left to its owner
+    WHISPER_API void whisper_threadpool_pause            (struct whisper_context * ctx);
+    WHISPER_API void whisper_threadpool_pause_from_state (struct whisper_state   * state);
+    WHISPER_API void whisper_threadpool_resume           (struct whisper_context * ctx);
+    WHISPER_API void whisper_threadpool_resume_from_state(struct whisper_state   * state);
+
+    // NUMA node the state is bound to (whisper_context_params.numa_replicate), -1 if it is not bound
+    WHISPER_API int whisper_numa_node_from_state(struct whisper_state * state);
+
+    // Cooperative scheduling on a threadpool shared with other models (whisper_context_params.cpu_threadpool_shared):
+    // the whisper contexts hold this lock for each encode or decode pass, other users of the threadpool - and of the
+    // GPU - hold it around their own computations, e.g. llama_decode(). Not recursive
+    WHISPER_API void whisper_shared_threadpool_lock  (void);
+    WHISPER_API void whisper_shared_threadpool_unlock(void);
 
     // Print system information
     WHISPER_API const char * whisper_print_system_info(void);
@@ -484,6 +931,7 @@ extern "C" {
     // Parameters for the whisper_full() function
     // If you change the order or add new parameters, make sure to update the default values in whisper.cpp:
     // whisper_full_default_params()
+    // new fields go at the end: the Java bindings (WhisperFullParams.java) pass this struct by value
     struct whisper_full_params {
         enum whisper_sampling_strategy strategy;
 
@@ -512,7 +960,7 @@ extern "C" {
         // [EXPERIMENTAL] speed-up techniques
         // note: these can significantly reduce the quality of the output
         bool debug_mode;        // enable debug_mode provides extra info (eg. Dump log_mel)
-        int  audio_ctx;         // overwrite the audio context size (0 = use default)
+        int  audio_ctx;         // overwrite the audio context size (0 = use default, -1 = size each window from its audio length)
 
         // [EXPERIMENTAL] [TDRZ] tinydiarize
         bool tdrz_enable;       // enable tinydiarize speaker turn detection
@@ -554,7 +1002,9 @@ extern "C" {
         struct {
             int beam_size;  // ref: https://github.com/openai/whisper/blob/f82bc59f5ea234d4b97fb2860842ed38519f7e65/whisper/transcribe.py#L265
 
-            float patience; // TODO: not implemented, ref: https://arxiv.org/pdf/2204.05424.pdf
+            // the window stops once round(beam_size*patience) beams have finished, the unfinished ones are dropped.
+            // <= 0 or >= 1 waits for all beams, ref: https://arxiv.org/pdf/2204.05424.pdf
+            float patience;
         } beam_search;
 
         // called for every newly generated text segment
@@ -587,6 +1037,115 @@ extern "C" {
         const char * vad_model_path;              // Path to VAD model
 
         whisper_vad_params vad_params;
+
+        // [EXPERIMENTAL] speed-up techniques
+        bool pipeline_encode;   // encode the next window in a helper state while the current one is decoded
+                                // the next window is assumed to start where the current one ends and is encoded
+                                // again when the decoded timestamps move it; the helper state costs extra memory
+        bool sample_on_device;  // greedy decoding with a single decoder at temperature 0: pick the next token in the decoder
+                                // graph and read back only the sampled token instead of the full logits row
+                                // not used with a logits filter callback or a grammar
+
+        // [EXPERIMENTAL] speculative decoding, used with greedy decoding at temperature 0
+        // the draft model proposes up to n_draft tokens that are verified by ctx in a single batched decode
+        // the draft model has to share the vocabulary and the number of mel bins of ctx, and must outlive the
+        // states it is used with
+        struct whisper_context * draft_ctx; // nullptr to disable
+        int n_draft;                        // max tokens proposed by the draft model per decode of ctx
+
+        // [EXPERIMENTAL] decoder early exit, used with greedy decoding at temperature 0
+        // each token is first decoded with the first decoder_exit_layer text layers only, the remaining layers
+        // just get the keys and values of the exit layer output. When the logprobs of the two best tokens
+        // differ by less than decoder_exit_thold, the token is decoded again with all layers
+        int   decoder_exit_layer; // 0 to disable, otherwise less than the number of text layers
+        float decoder_exit_thold; // min logprob margin of the best token to keep an early exit
+
+        // [EXPERIMENTAL] speaker labels without a diarization model, see whisper_full_get_segment_speaker()
+        // a segment gets the speaker whose long-term spectrum (mean log-mel of the loud frames of the ASR mel, level
+        // removed) is within speaker_thold dB RMS of its own, else a new speaker, up to speaker_max. The speakers
+        // of the previous calls on the state are kept unless no_context is set
+        bool  speaker_labels;
+        int   speaker_max;
+        float speaker_thold;
+
+        // [EXPERIMENTAL] tokens the transcription of the first window continues from, e.g. the committed text of a
+        // streaming hypothesis: they follow the task tokens in the decoder prompt and are not part of the result.
+        // With timestamps they start with a timestamp token and keep them in pairs, as whisper_full_get_token_id()
+        // returns them. Not used by the draft model, sample_on_device, DTW capture and the Core ML decoder
+        const whisper_token * prefix_tokens;
+        int prefix_n_tokens;
+
+        // fast language detection: encode only the first lang_detect_ms of audio (leading silence skipped) with a
+        // reduced audio context, doubling the window until the top language reaches lang_detect_thold or the full
+        // 30 s window is used. 0 = a single full window. The encoder output is reused by the transcription when the
+        // first window ends up the same, e.g. short clips with audio_ctx = -1
+        int   lang_detect_ms;
+        float lang_detect_thold;
+
+        // [EXPERIMENTAL] online fallback checks - a decoder that fails them ends before the end of the window, so a
+        // looping hallucination does not run up to n_text_ctx/2 tokens before the next temperature starts. They are off
+        // at the last temperature (and with temperature_inc = 0), which has no fallback and keeps the whole window
+        int   repeat_thold;     // fail when the text ends with an n-gram (up to 16 tokens) repeated this many times
+                                // in a row, over 16 tokens or more, 0 = off
+        float logprob_floor;    // fail when the average logprob of the sampled tokens drops below this, after 32
+                                // tokens and only while a fallback temperature remains, 0 = off
+
+        // [EXPERIMENTAL] skip a window without decoding it when the no_speech_prob of the prompt step is above this
+        // (and above no_speech_thold) - silence then costs one decoder pass. A window decoded to the end is dropped
+        // as silence only when its avg_logprobs is also below logprob_thold, so this is best set well above
+        // no_speech_thold, e.g. 0.8. 0 = off
+        float no_speech_exit_thold;
+
+        // [EXPERIMENTAL] decode consecutive fallback temperatures at the same time, as separate sequences of one
+        // batch, and keep the first temperature that passes the thresholds. Used with greedy decoding, up to 16
+        // decoders run together - this trades extra compute and a larger self-attention KV cache for fewer
+        // passes on audio that needs fallbacks
+        bool parallel_fallback;
+
+        // [EXPERIMENTAL] onset-aware seek: a window that would start with 1 s or more of silence starts 200 ms before
+        // the first speech instead, and the silence at the end of the audio is not encoded at all. A 10 ms frame is
+        // speech when its mean log-mel level is within this many dB of the loudest frame, speech starts with 50 ms
+        // of such frames. Sparse audio then needs fewer windows. Not needed with vad, e.g. 40. 0 = off
+        float onset_thold;
+
+        // [EXPERIMENTAL] chunked long-form: instead of the seek loop, the audio is cut into 30 s chunks that overlap
+        // by 3 s and end in a pause where there is one, the first windows of this many chunks are encoded in one
+        // batch and decoded at the same time, and the chunks are stitched where their overlaps have the same text.
+        // Each chunk is decoded without the text of the previous one. The extra states are those of
+        // whisper_full_parallel(), the batched encode is not available with Core ML / OpenVINO. 0 = off
+        int chunk_batch;
+
+        // [EXPERIMENTAL] vocabulary shortlist: the decoder computes the logits only of these text tokens and of the
+        // special and timestamp tokens, which are always kept, with the rows of the token embedding gathered once
+        // into a smaller output projection. The other tokens get -INFINITY, e.g. the ids of the tokens that an
+        // English-only or grammar-constrained decode can emit. sample_on_device is ignored with it. NULL = off
+        const whisper_token * vocab_shortlist;
+        int                   vocab_shortlist_n;
+
+        // [EXPERIMENTAL] continue the transcription of the state instead of starting over, e.g. after
+        // whisper_state_load(): the results and the past prompt of the state are kept, and decoding starts at the
+        // window after the last one finished, if that is past offset_ms. Needs the same audio and params as the
+        // calls so far. Not used with chunk_batch
+        bool resume;
+
+        // [EXPERIMENTAL] adaptive beam width: while the best beam leads the others by more than beam_adaptive_margin
+        // (in logprob) and its next token leads the second best by as much, the other beams are dropped and only
+        // the best one is decoded. The beam widens again from it, as at the first token, once the logprob gap of
+        // its next token falls under the margin. Only at temperature 0. 0.0f = off
+        float beam_adaptive_margin;
+
+        // contextual biasing: the logits of the tokens that start or continue one of the phrases are raised by
+        // its weight (bias_weights[i], or bias_weight when bias_weights is NULL) - cheaper than listing the
+        // phrases in initial_prompt and not limited by n_max_text_ctx
+        const char * const * bias_phrases;
+        const float        * bias_weights;
+        int                  n_bias_phrases;
+        float                bias_weight;
+
+        // [EXPERIMENTAL] noise suppression of the audio before the VAD and the mel spectrogram, see whisper_denoise_*
+        // fewer windows of noisy recordings fail logprob_thold/entropy_thold and fall back to higher temperatures
+        bool         denoise;
+        const char * denoise_model_path;          // Path to denoise model, unless attached with whisper_ctx_set_denoise()
     };
 
     // NOTE: this function allocates memory, and it is the responsibility of the caller to free the pointer - see whisper_free_context_params & whisper_free_params()
@@ -596,6 +1155,15 @@ extern "C" {
     WHISPER_API struct whisper_full_params * whisper_full_default_params_by_ref(enum whisper_sampling_strategy strategy);
     WHISPER_API struct whisper_full_params   whisper_full_default_params       (enum whisper_sampling_strategy strategy);
 
+    // sizeof() of the params structs, for the bindings that mirror their layout (e.g. JNA) to check it
+    WHISPER_API size_t whisper_context_params_sizeof(void);
+    WHISPER_API size_t whisper_full_params_sizeof   (void);
+
+    // Preset for dictation of n_samples of audio, up to 30 s: greedy decoding without timestamps into a single
+    // segment, the audio context sized from the audio (audio_ctx = -1) and max_tokens capped from its duration,
+    // so that fewer tokens are decoded and the timestamp rules are skipped for every token
+    WHISPER_API struct whisper_full_params   whisper_full_dictation_params     (int n_samples);
+
     // Run the entire model: PCM -> log mel spectrogram -> encoder -> decoder -> text
     // Not thread safe for same context
     // Uses the specified decoding strategy to obtain the text.
@@ -605,6 +1173,8 @@ extern "C" {
                            const float * samples,
                                    int   n_samples);
 
+    // Same as whisper_full() but uses the given state, including the VAD pass when params.vad is set.
+    // Different states of the same context can run concurrently on different threads.
     WHISPER_API int whisper_full_with_state(
                 struct whisper_context * ctx,
                   struct whisper_state * state,
@@ -612,8 +1182,53 @@ extern "C" {
                            const float * samples,
                                    int   n_samples);
 
+    // A piece of input audio for whisper_full_with_state_spans(): n_samples samples at data, or n_samples of
+    // silence when data is NULL
+    typedef struct whisper_pcm_span {
+        const float * data;
+        int           n_samples;
+    } whisper_pcm_span;
+
+    // Same as whisper_full_with_state() on the concatenation of the spans, without building it first - the mel
+    // spectrogram is computed from the span buffers directly. Timestamps are relative to the concatenation.
+    // This is how the VAD pass feeds the detected speech segments. With params.vad set, the spans are gathered
+    WHISPER_API int whisper_full_with_state_spans(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params,
+         const struct whisper_pcm_span * spans,
+                                   int   n_spans);
+
+    // Pull-based audio input for whisper_full_from_source(): read() writes up to n_samples of 16 kHz mono PCM
+    // into dst and returns the number written - 0 at the end of the audio, < 0 on error
+    typedef struct whisper_audio_source {
+        int (*read)(void * user_data, float * dst, int n_samples);
+
+        void * user_data;
+    } whisper_audio_source;
+
+    // [EXPERIMENTAL] Same as whisper_full() on all the audio of the source, with memory bounded by a
+    // chunk of a few 30 s windows instead of the audio length - for multi-hour recordings.
+    // Each chunk is pulled from the source and transcribed. The segments that end before the last part of
+    // the chunk are kept, and the next chunk starts where they end, with their text as the prompt. Timestamps
+    // are relative to the start of the source, and the new segment callback is called for the kept segments.
+    // params.vad, offset_ms and duration_ms are not supported
+    WHISPER_API int whisper_full_from_source(
+                struct whisper_context * ctx,
+            struct whisper_full_params   params,
+           struct whisper_audio_source   source);
+
+    WHISPER_API int whisper_full_with_state_from_source(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params,
+           struct whisper_audio_source   source);
+
     // Split the input audio in chunks and process each chunk separately using whisper_full_with_state()
     // Result is stored in the default state of the context
+    // With params.vad set, the chunks are groups of speech segments split in the silence between them, and the
+    // states take them from a shared queue until all are done (params.offset_ms and duration_ms do not apply)
+    // The states of the other chunks are kept by the context for the next call, and freed by whisper_free().
     // Not thread safe if executed in parallel on the same context.
     // It seems this approach can offer some speedup in some cases.
     // However, the transcription accuracy can be worse at the beginning and end of each chunk.
@@ -624,6 +1239,69 @@ extern "C" {
                                    int   n_samples,
                                    int   n_processors);
 
+    // [EXPERIMENTAL] Run several decoding tasks on the same audio with a single encoder pass per window, e.g. a
+    // transcription and an English translation (params[i].translate). Task i writes its segments to states[i], the
+    // states must be distinct states of ctx. The mel spectrogram is computed once. A language of "auto" (or none) is
+    // detected once for all tasks, and its probabilities are written to lang_probs (whisper_lang_max_id() + 1 floats)
+    // unless it is NULL.
+    // Task 0 leads: it encodes and decodes each window as whisper_full_with_state() does, and decides where the next
+    // window starts. The other tasks decode each window from a copy of its cross-attention KV cache on their own threads,
+    // the leader moving on to the next window meanwhile, and drop the segments that start after the end of the window
+    // in the leader. The window schedule (offset_ms, duration_ms, audio_ctx, onset_thold) follows params[0].
+    // With params.vad or chunk_batch set the tasks run one after another with whisper_full_with_state()
+    // Returns 0 on success, the first error of the tasks otherwise
+    WHISPER_API int whisper_full_tasks(
+                struct whisper_context * ctx,
+                 struct whisper_state ** states,
+      const struct whisper_full_params * params,
+                                   int   n_tasks,
+                           const float * samples,
+                                   int   n_samples,
+                                 float * lang_probs);
+
+    // [EXPERIMENTAL] Transcribe each channel of a multichannel recording on its own, e.g. the two parties of a call:
+    // channels[i] holds the n_samples samples of channel i. The channels are decoded at the same time, on state and
+    // on the states of whisper_full_parallel(), and the windows that they start together are encoded with one
+    // batched graph (whisper_encode_batch()). The segments of all channels end up in state in order of start time,
+    // with the channel as their speaker (whisper_full_get_segment_speaker()). Each channel detects its own language.
+    // With params.vad or chunk_batch set the channels are transcribed one after another
+    // Returns 0 on success
+    WHISPER_API int whisper_full_channels(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params,
+                          const float ** channels,
+                                   int   n_channels,
+                                   int   n_samples);
+
+    // Score a fixed set of token sequences (e.g. the commands of a keyword spotter) against a short clip,
+    // without generating any text. logprobs[i] receives the sum of the log-probabilities of the tokens of
+    // seqs[i], given the audio and the prompt [prompt_tokens] + sot + [language + task] + no_timestamps.
+    // The clip is encoded once (with params.audio_ctx, -1 sizes it for the clip) and, after the prompt, the
+    // sequences are decoded together in a single batch, each one as its own KV cache sequence sharing the prompt.
+    // Uses params.n_threads, audio_ctx, language ("auto" detects it), translate and prompt_tokens.
+    // Returns 0 on success
+    WHISPER_API int whisper_full_score(
+                struct whisper_context * ctx,
+            struct whisper_full_params   params,
+                           const float * samples,
+                                   int   n_samples,
+                  const whisper_token ** seqs,
+                             const int * seq_n_tokens,
+                                   int   n_seqs,
+                                 float * logprobs);
+
+    WHISPER_API int whisper_full_score_with_state(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params,
+                           const float * samples,
+                                   int   n_samples,
+                  const whisper_token ** seqs,
+                             const int * seq_n_tokens,
+                                   int   n_seqs,
+                                 float * logprobs);
+
     // Number of generated text segments
     // A segment can be a few words, a sentence, or even a paragraph.
     WHISPER_API int whisper_full_n_segments           (struct whisper_context * ctx);
@@ -646,6 +1324,11 @@ extern "C" {
     WHISPER_API bool whisper_full_get_segment_speaker_turn_next(struct whisper_context * ctx, int i_segment);
     WHISPER_API bool whisper_full_get_segment_speaker_turn_next_from_state(struct whisper_state * state, int i_segment);
 
+    // Get the speaker of the specified segment (whisper_full_params.speaker_labels), numbered from 0 in order of
+    // appearance - or its channel with whisper_full_channels() - -1 if not computed or the segment is too short
+    WHISPER_API int whisper_full_get_segment_speaker           (struct whisper_context * ctx, int i_segment);
+    WHISPER_API int whisper_full_get_segment_speaker_from_state(struct whisper_state * state, int i_segment);
+
     // Get the text of the specified segment
     WHISPER_API const char * whisper_full_get_segment_text           (struct whisper_context * ctx, int i_segment);
     WHISPER_API const char * whisper_full_get_segment_text_from_state(struct whisper_state * state, int i_segment);
@@ -682,6 +1365,10 @@ extern "C" {
         int   n_threads;  // The number of threads to use for processing.
         bool  use_gpu;
         int   gpu_device; // CUDA device
+
+        // [EXPERIMENTAL] evaluate the model with dedicated CPU kernels instead of ggml graphs
+        // (cheaper for a model this small, ignores n_threads and use_gpu)
+        bool  cpu_fast_path;
     };
 
     WHISPER_API struct whisper_vad_context_params whisper_vad_default_context_params(void);
@@ -689,6 +1376,16 @@ extern "C" {
     WHISPER_API struct whisper_vad_context * whisper_vad_init_from_file_with_params(const char * path_model,              struct whisper_vad_context_params params);
     WHISPER_API struct whisper_vad_context * whisper_vad_init_with_params          (struct whisper_model_loader * loader, struct whisper_vad_context_params params);
 
+    // A new VAD context using the model weights of vctx, with its own LSTM state and compute buffers.
+    // The weights are freed with the last context using them, so vctx may be freed first.
+    WHISPER_API struct whisper_vad_context * whisper_vad_init_from_context(struct whisper_vad_context * vctx);
+
+    // Use the model of vctx for the VAD pass of whisper_full() and whisper_full_with_state(), instead of loading
+    // params.vad_model_path. Every state gets its own context on the shared weights (the model file is otherwise
+    // loaded once per whisper_context as well). vctx is not kept and may be freed afterwards; NULL detaches.
+    // Returns 0 on success
+    WHISPER_API int whisper_ctx_set_vad(struct whisper_context * ctx, struct whisper_vad_context * vctx);
+
     WHISPER_API bool whisper_vad_detect_speech(
             struct whisper_vad_context * vctx,
                            const float * samples,
@@ -697,6 +1394,21 @@ extern "C" {
     WHISPER_API int     whisper_vad_n_probs(struct whisper_vad_context * vctx);
     WHISPER_API float * whisper_vad_probs  (struct whisper_vad_context * vctx);
 
+    // Streaming VAD: feed the audio as it is captured. The LSTM state and the samples of the last incomplete
+    // window are kept between pushes, and the probability of each completed window is appended to
+    // whisper_vad_probs(), so whisper_vad_segments_from_probs() covers the stream so far.
+    // whisper_vad_detect_speech() starts over, as does whisper_vad_stream_reset().
+    // push and flush return the number of new probabilities, or -1 on failure
+    WHISPER_API void whisper_vad_stream_reset(struct whisper_vad_context * vctx);
+
+    WHISPER_API int whisper_vad_stream_push(
+            struct whisper_vad_context * vctx,
+                           const float * samples,
+                                   int   n_samples);
+
+    // evaluate the incomplete window, zero-padded, at the end of the stream
+    WHISPER_API int whisper_vad_stream_flush(struct whisper_vad_context * vctx);
+
     struct whisper_vad_segments;
 
     WHISPER_API struct whisper_vad_segments * whisper_vad_segments_from_probs(
@@ -717,6 +1429,59 @@ extern "C" {
     WHISPER_API void whisper_vad_free_segments(struct whisper_vad_segments * segments);
     WHISPER_API void whisper_vad_free         (struct whisper_vad_context  * ctx);
 
+    //
+    // Noise suppression
+    //
+
+    // [EXPERIMENTAL] RNNoise-class denoiser evaluated with ggml. For each 10 ms hop, the log energies of n_bands
+    // mel-spaced bands of the 20 ms frame go through a dense layer, a GRU and a dense layer with one gain per band.
+    // The gains, interpolated over the bins and clamped to min_gain, scale the spectrum before it is transformed
+    // back and overlap-added. See models/convert-denoise-to-ggml.py for the model file
+    struct whisper_denoise_context;
+
+    struct whisper_denoise_context_params {
+        int   n_threads;
+        float min_gain;   // lower bound of the gains: keeps some of the noise rather than distorting the speech
+    };
+
+    WHISPER_API struct whisper_denoise_context_params whisper_denoise_default_context_params(void);
+
+    WHISPER_API struct whisper_denoise_context * whisper_denoise_init_from_file_with_params(const char * path_model, struct whisper_denoise_context_params params);
+
+    // A new denoise context using the model weights of dctx, with its own GRU state and compute buffers.
+    // The weights are freed with the last context using them
+    WHISPER_API struct whisper_denoise_context * whisper_denoise_init_from_context(struct whisper_denoise_context * dctx);
+
+    // Use the model of dctx for whisper_full_params.denoise instead of loading params.denoise_model_path, like
+    // whisper_ctx_set_vad(). dctx is not kept and may be freed afterwards; NULL detaches. Returns 0 on success
+    WHISPER_API int whisper_ctx_set_denoise(struct whisper_context * ctx, struct whisper_denoise_context * dctx);
+
+    // Denoise n_samples into out, starting from a silent state. out may be samples. Returns false on failure
+    WHISPER_API bool whisper_denoise(
+            struct whisper_denoise_context * dctx,
+                               const float * samples,
+                                       int   n_samples,
+                                     float * out);
+
+    // Streaming: the GRU state and the overlap of the last frame are kept between pushes, and the denoised samples
+    // are written to out as soon as no later frame overlaps them (one hop behind the input). out needs room for
+    // n_samples + 160 samples; flush writes the rest (at most 320) and starts over. Both return the number of
+    // samples written, or -1 on failure. whisper_denoise() starts over, as does whisper_denoise_stream_reset()
+    WHISPER_API void whisper_denoise_stream_reset(struct whisper_denoise_context * dctx);
+
+    WHISPER_API int whisper_denoise_stream_push(
+            struct whisper_denoise_context * dctx,
+                               const float * samples,
+                                       int   n_samples,
+                                     float * out);
+
+    WHISPER_API int whisper_denoise_stream_flush(struct whisper_denoise_context * dctx, float * out);
+
+    // Time spent denoising by dctx since it was created
+    WHISPER_API int64_t whisper_denoise_t_us(struct whisper_denoise_context * dctx);
+
+    WHISPER_API void whisper_denoise_free(struct whisper_denoise_context * dctx);
+
     ////////////////////////////////////////////////////////////////////////////
 
     // Temporary helpers needed for exposing ggml interface
@@ -725,14 +1490,165 @@ extern "C" {
     WHISPER_API const char * whisper_bench_memcpy_str      (int n_threads);
     WHISPER_API int          whisper_bench_ggml_mul_mat    (int n_threads);
     WHISPER_API const char * whisper_bench_ggml_mul_mat_str(int n_threads);
+    WHISPER_API int          whisper_bench_ggml_gelu       (int n_threads);
+    WHISPER_API const char * whisper_bench_ggml_gelu_str   (int n_threads);
 
     // Control logging output; default behavior is to print to stderr
 
     WHISPER_API void whisper_log_set(ggml_log_callback log_callback, void * user_data);
 
+    // Drop the log messages of whisper below level before they are formatted, e.g. GGML_LOG_LEVEL_WARN in release
+    // builds - GGML_LOG_LEVEL_NONE (default) passes them all to the callback. Build with -DWHISPER_LOG_LEVEL_MIN=N
+    // to compile out the messages below level N instead
+    WHISPER_API void whisper_log_set_level(enum ggml_log_level level);
+
     // Get the no_speech probability for the specified segment
     WHISPER_API float whisper_full_get_segment_no_speech_prob           (struct whisper_context * ctx, int i_segment);
     WHISPER_API float whisper_full_get_segment_no_speech_prob_from_state(struct whisper_state * state, int i_segment);
+
+    //
+    // Binary transcripts
+    //
+    // The segments and tokens of a whisper_full() result with their timestamps, probabilities and speakers, in a
+    // file that whisper_transcript_open() maps as is, so a transcript can be re-processed or re-rendered without the
+    // model and without parsing JSON. The layout, native byte order, 8-byte aligned sections:
+    //
+    //   whisper_transcript_header
+    //   whisper_transcript_segment[n_segments]
+    //   whisper_transcript_token  [n_tokens]   - in segment order, each segment at its token_off
+    //   char                      [n_text]     - the NUL-terminated segment and token texts
+    //
+
+    #define WHISPER_TRANSCRIPT_MAGIC   0x77747363 // "wtsc"
+    #define WHISPER_TRANSCRIPT_VERSION 1
+
+    // whisper_transcript_token.flags
+    #define WHISPER_TRANSCRIPT_TOKEN_SPECIAL    1 // >= whisper_token_eot(): not part of the text
+    #define WHISPER_TRANSCRIPT_TOKEN_WORD_BEGIN 2 // first text token of a word: starts with a space or a segment
+
+    typedef struct whisper_transcript_header {
+        uint32_t magic;
+        uint32_t version;
+
+        int32_t  lang_id;    // whisper_full_lang_id()
+        int32_t  n_segments;
+        int32_t  n_tokens;
+        uint32_t n_text;     // bytes
+    } whisper_transcript_header;
+
+    typedef struct whisper_transcript_segment {
+        int64_t  t0;        // centiseconds, as whisper_full_get_segment_t0()
+        int64_t  t1;
+
+        uint32_t text_off;  // in the texts
+        uint32_t token_off; // in the tokens
+        int32_t  n_tokens;
+
+        int32_t  speaker;   // whisper_full_get_segment_speaker(), -1 for none
+        float    no_speech_prob;
+        uint32_t speaker_turn_next;
+    } whisper_transcript_segment;
+
+    typedef struct whisper_transcript_token {
+        int64_t  t0;       // whisper_token_data.t0, t1 and t_dtw
+        int64_t  t1;
+        int64_t  t_dtw;
+
+        int32_t  id;
+        int32_t  tid;
+
+        float    p;
+        float    plog;
+        float    pt;
+        float    ptsum;
+        float    vlen;
+
+        uint32_t text_off; // the text of the token in the vocabulary, in the texts
+        uint32_t flags;    // WHISPER_TRANSCRIPT_TOKEN_*
+        uint32_t padding;
+    } whisper_transcript_token;
+
+    // Write the result of the default state (or of state) to fname. Returns false on failure
+    WHISPER_API bool whisper_full_save_transcript           (struct whisper_context * ctx, const char * fname);
+    WHISPER_API bool whisper_full_save_transcript_from_state(struct whisper_context * ctx, struct whisper_state * state, const char * fname);
+
+    struct whisper_transcript;
+
+    // Map a transcript written by whisper_full_save_transcript() (read into memory where mmap is not supported).
+    // Returns NULL if the file cannot be read or is not a transcript of this version
+    WHISPER_API struct whisper_transcript * whisper_transcript_open (const char * fname);
+    WHISPER_API void                        whisper_transcript_close(struct whisper_transcript * transcript);
+
+    WHISPER_API const whisper_transcript_header * whisper_transcript_get_header(const struct whisper_transcript * transcript);
+
+    // The arrays of the file - a segment's tokens are whisper_transcript_get_tokens() + token_off
+    WHISPER_API const whisper_transcript_segment * whisper_transcript_get_segments(const struct whisper_transcript * transcript);
+    WHISPER_API const whisper_transcript_token   * whisper_transcript_get_tokens  (const struct whisper_transcript * transcript);
+
+    // The text at text_off of a segment or a token
+    WHISPER_API const char * whisper_transcript_get_text(const struct whisper_transcript * transcript, uint32_t text_off);
+
+    //
+    // State snapshots
+    //
+    // The decoding state of a transcription: the mel spectrogram, the cross-attention KV of the last encoded window,
+    // the self-attention KV cache, the past prompt, the results so far, the language and the position after the last
+    // finished window. whisper_full() does not encode a window again when the cross-attention KV already holds it,
+    // so a restored or cloned state can decode the same audio again, e.g. with another prompt, without the encoder.
+    // A snapshot taken between two windows (from the progress_callback, or after whisper_full() returns) continues
+    // with whisper_full_params.resume. Snapshots are native byte order and only valid for the same model and the
+    // same context params (KV cache types, flash attention). None of these may run while state computes.
+    //
+
+    // Write state to fname. Returns false on failure
+    WHISPER_API bool whisper_state_save(struct whisper_context * ctx, struct whisper_state * state, const char * fname);
+
+    // Restore a snapshot written by whisper_state_save() into state, a state of ctx. The file is mapped where mmap is
+    // supported, the KV caches are copied from the mapping. Returns false, with state unchanged, if the file cannot
+    // be read or was written for another model or context params
+    WHISPER_API bool whisper_state_load(struct whisper_context * ctx, struct whisper_state * state, const char * fname);
+
+    // A new state of ctx with a copy of the decoding state of state, freed with whisper_free_state()
+    // The KV caches are copied on their backend. Returns NULL on failure
+    WHISPER_API struct whisper_state * whisper_state_clone(struct whisper_context * ctx, struct whisper_state * state);
+
+    //
+    // Model quantization
+    //
+    // The quantization of examples/quantize as a library call, e.g. to make the variant of a model that suits the
+    // machine from an F16 model after it is downloaded.
+    //
+
+    // Called with the fraction of the input converted so far, from the quantization threads one at a time.
+    // Return false to cancel
+    typedef bool (*whisper_model_quantize_progress_callback)(float progress, void * user_data);
+
+    struct whisper_model_quantize_params {
+        int n_threads; // the tensors are converted in chunks of rows, in parallel
+
+        // the type of the weight matrices, unless recipe is set
+        enum ggml_type type;
+
+        // "<regex> <type>" rules, one per line or separated by ';' - the recipe files of examples/quantize. A
+        // weight matrix takes the type of the first rule matching its name, or keeps its type
+        const char * recipe;
+
+        whisper_model_quantize_progress_callback progress_callback;
+        void * progress_callback_user_data;
+    };
+
+    WHISPER_API struct whisper_model_quantize_params whisper_model_quantize_default_params(void);
+
+    // Write the model file path_inp, in the ggml format with F32, F16 or BF16 weights, to path_out with the 2D weight
+    // matrices converted as params says (NULL for the defaults: Q8_0). The rows that do not fit the blocks of a type
+    // fall back to one with smaller blocks, the biases, the positional embeddings and the other tensors keep their
+    // type. Returns 0 on success, 1 if cancelled by the progress callback and -1 on failure; path_out is removed if
+    // it is not complete
+    WHISPER_API int whisper_model_quantize(
+                                   const char * path_inp,
+                                   const char * path_out,
+            const struct whisper_model_quantize_params * params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,91 @@
+# Convert a PyTorch denoiser checkpoint to the model format of whisper_denoise_init_from_file_with_params()
+#
+# Usage:
+#
+#   python3 models/convert-denoise-to-ggml.py path/to/denoise.pt [output.bin] [--f16]
+#
+# The checkpoint is the state_dict of a module with:
+#
+#   input  = torch.nn.Linear(n_bands, n_dense)               # followed by tanh
+#   gru    = torch.nn.GRU(n_dense, n_gru, batch_first=True)  # one layer
+#   output = torch.nn.Linear(n_gru, n_bands)                 # followed by sigmoid: the gain of each band
+#
+# trained on the features computed as in whisper.cpp: 16 kHz audio, a 320-sample frame every 160 samples under a
+# square-root periodic Hann window, and ln(max(E_b, 1e-10)) of the band energies E_b = sum_k w[k][b]*|X_k|^2 with
+# the triangular weights of band_weights() below. The denoised spectrum is X_k*sum_b w[k][b]*g_b, overlap-added
+# under the same window. The weight matrices can be converted to F16, the biases stay F32.
+
+import sys
+import math
+import struct
+
+import torch
+
+def band_weights(n_bands, n_bins=161, sample_rate=16000):
+    mel = lambda f: 2595.0*math.log10(1.0 + f/700.0)
+    m_max = mel(0.5*sample_rate)
+    w = [[0.0]*n_bands for _ in range(n_bins)]
+    for k in range(n_bins):
+        p = mel(k*0.5*sample_rate/(n_bins - 1))/m_max*(n_bands - 1)
+        b0 = min(int(p), n_bands - 2)
+        w[k][b0]     = 1.0 - (p - b0)
+        w[k][b0 + 1] = p - b0
+    return w
+
+if len(sys.argv) < 2:
+    print("Usage: convert-denoise-to-ggml.py denoise.pt [output.bin] [--f16]\n")
+    sys.exit(1)
+
+fname_inp = sys.argv[1]
+args      = [a for a in sys.argv[2:] if not a.startswith("--")]
+use_f16   = "--f16" in sys.argv[2:]
+fname_out = args[0] if args else fname_inp.rsplit(".", 1)[0] + ".bin"
+
+state_dict = torch.load(fname_inp, map_location="cpu")
+if "state_dict" in state_dict:
+    state_dict = state_dict["state_dict"]
+
+# checkpoint names -> whisper.cpp tensor names
+names = {
+    "input.weight":      "denoise.input.weight",
+    "input.bias":        "denoise.input.bias",
+    "gru.weight_ih_l0":  "denoise.gru.weight_ih",
+    "gru.weight_hh_l0":  "denoise.gru.weight_hh",
+    "gru.bias_ih_l0":    "denoise.gru.bias_ih",
+    "gru.bias_hh_l0":    "denoise.gru.bias_hh",
+    "output.weight":     "denoise.output.weight",
+    "output.bias":       "denoise.output.bias",
+}
+
+for name in names:
+    if name not in state_dict:
+        print(f"error: {name} missing from {fname_inp}")
+        sys.exit(1)
+
+n_dense, n_bands = state_dict["input.weight"].shape
+n_gru            = state_dict["gru.weight_hh_l0"].shape[1]
+
+print(f"n_bands = {n_bands}, n_dense = {n_dense}, n_gru = {n_gru}")
+
+with open(fname_out, "wb") as fout:
+    fout.write(struct.pack("I", 0x6767646e)) # magic: ggdn in hex
+    fout.write(struct.pack("i", n_bands))
+    fout.write(struct.pack("i", n_dense))
+    fout.write(struct.pack("i", n_gru))
+
+    for name, name_ggml in names.items():
+        data = state_dict[name].detach()
+
+        # Linear and GRU weights [n_out, n_in] in PyTorch are [n_in, n_out] in ggml
+        ftype = 1 if use_f16 and data.dim() == 2 else 0
+        data  = data.to(torch.float16 if ftype == 1 else torch.float32).numpy()
+
+        name_ggml = name_ggml.encode("utf-8")
+        fout.write(struct.pack("iii", data.ndim, len(name_ggml), ftype))
+        for i in range(data.ndim):
+            fout.write(struct.pack("i", data.shape[data.ndim - 1 - i]))
+        fout.write(name_ggml)
+
+        data.tofile(fout)
+
+print("Done. Output file: " + fname_out)
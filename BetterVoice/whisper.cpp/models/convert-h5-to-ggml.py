@@ -8,6 +8,9 @@
 #
 #   python3 ./whisper.cpp/models/convert-h5-to-ggml.py ./whisper-medium/ ./whisper .
 #
+# Pass "bf16" as the 4th argument to store the weight matrices as bfloat16 instead of float16: the weights keep the
+# range of float32, and checkpoints trained in bfloat16 convert without loss
+#
 # This script is similar to "convert-pt-to-ggml.py"
 #
 # For more info:
@@ -72,8 +75,14 @@ def bytes_to_unicode():
     cs = [chr(n) for n in cs]
     return dict(zip(bs, cs))
 
+# float32 -> bfloat16 with round to nearest even, as ggml_fp32_to_bf16()
+def to_bf16(data):
+    bits = np.ascontiguousarray(data, dtype=np.float32).view(np.uint32).astype(np.uint64)
+    bits = (bits + 0x7fff + ((bits >> 16) & 1)) >> 16
+    return bits.astype(np.uint16)
+
 if len(sys.argv) < 4:
-    print("Usage: convert-h5-to-ggml.py dir_model path-to-whisper-repo dir-output [use-f32]\n")
+    print("Usage: convert-h5-to-ggml.py dir_model path-to-whisper-repo dir-output [use-f32|bf16]\n")
     sys.exit(1)
 
 dir_model   = Path(sys.argv[1])
@@ -109,10 +118,15 @@ fname_out = dir_out / "ggml-model.bin"
 tokens = json.load(open(dir_tokenizer / "vocab.json", "r", encoding="utf8"))
 
 # use 16-bit or 32-bit floats
-use_f16 = True
+use_f16  = True
+use_bf16 = False
 if len(sys.argv) > 4:
-    use_f16 = False
-    fname_out = dir_out / "ggml-model-f32.bin"
+    if sys.argv[4] == "bf16":
+        use_bf16 = True
+        fname_out = dir_out / "ggml-model-bf16.bin"
+    else:
+        use_f16 = False
+        fname_out = dir_out / "ggml-model-f32.bin"
 
 fout = open(fname_out, "wb")
 
@@ -127,7 +141,8 @@ fout.write(struct.pack("i", hparams["d_model"]))
 fout.write(struct.pack("i", hparams["decoder_attention_heads"]))
 fout.write(struct.pack("i", hparams["decoder_layers"]))
 fout.write(struct.pack("i", hparams["num_mel_bins"]))
-fout.write(struct.pack("i", use_f16))
+# ftype of the model: 0 = all float32, 1 = mostly float16, 24 = mostly bfloat16 (GGML_FTYPE_MOSTLY_BF16)
+fout.write(struct.pack("i", 24 if use_bf16 else int(use_f16)))
 
 fout.write(struct.pack("i", filters.shape[0]))
 fout.write(struct.pack("i", filters.shape[1]))
@@ -174,8 +189,9 @@ for name in list_vars.keys():
         name = conv_map[name] if name in conv_map else name
 
     print(src, ' -> ', name)
-    data = list_vars[src].squeeze().numpy()
-    data = data.astype(np.float16)
+    data = list_vars[src].squeeze().float().numpy()
+    if not use_bf16:
+        data = data.astype(np.float16)
 
     # reshape conv bias from [n] to [n, 1]
     if name in ["encoder.conv1.bias", "encoder.conv2.bias"]:
@@ -187,9 +203,23 @@ for name in list_vars.keys():
 
     # looks like the whisper models are in f16 by default
     # so we need to convert the small tensors to f32 until we fully support f16 in ggml
-    # ftype == 0 -> float32, ftype == 1 -> float16
+    # ftype == 0 -> float32, ftype == 1 -> float16, ftype == 30 -> bfloat16 (GGML_TYPE_BF16)
     ftype = 1
-    if use_f16:
+    if use_bf16:
+        if n_dims == 2 and \
+                name != "encoder.conv1.bias"   and \
+                name != "encoder.conv2.bias"   and \
+                name != "encoder.positional_embedding" and \
+                name != "decoder.positional_embedding":
+            data = to_bf16(data)
+            ftype = 30
+        elif n_dims == 3:
+            # the convolutions run in float16 (im2col)
+            data = data.astype(np.float16)
+        else:
+            data = data.astype(np.float32)
+            ftype = 0
+    elif use_f16:
         if n_dims < 2 or \
                 name == "encoder.conv1.bias"   or \
                 name == "encoder.conv2.bias"   or \
@@ -0,0 +1,123 @@
+# Convert a PEFT LoRA adapter of a Hugging Face Whisper model to the adapter format of whisper_lora_adapter_init()
+#
+# Usage:
+#
+#   python3 models/convert-lora-to-ggml.py path/to/adapter-dir n_text_layer [output.bin] [--f16]
+#
+# adapter-dir holds the adapter_config.json and adapter_model.safetensors (or adapter_model.bin) written by
+# model.save_pretrained() of a peft model. n_text_layer is the number of decoder layers of the base model, e.g. 4
+# for tiny and 32 for large-v3 - the adapter does not have to update all of them.
+#
+# Only the decoder weights that whisper.cpp can update are supported: the self-attention q/k/v/out, the cross-attention
+# q/out and the MLP fc1/fc2 projections. The conversion fails if the adapter updates any other module (encoder,
+# cross-attention k/v), as the encoder output and the cross-attention k/v computed from it are shared by all the
+# adapters - dropping these updates would silently give a different model than the one that was trained.
+
+import os
+import sys
+import json
+import struct
+
+import torch
+
+# Hugging Face module names of a decoder layer -> whisper.cpp tensor names
+hf_to_ggml = {
+    "self_attn.q_proj":      "attn.query",
+    "self_attn.k_proj":      "attn.key",
+    "self_attn.v_proj":      "attn.value",
+    "self_attn.out_proj":    "attn.out",
+    "encoder_attn.q_proj":   "cross_attn.query",
+    "encoder_attn.out_proj": "cross_attn.out",
+    "fc1":                   "mlp.0",
+    "fc2":                   "mlp.2",
+}
+
+if len(sys.argv) < 3:
+    print("Usage: convert-lora-to-ggml.py adapter-dir n_text_layer [output.bin] [--f16]\n")
+    sys.exit(1)
+
+dir_adapter  = sys.argv[1]
+n_text_layer = int(sys.argv[2])
+args         = [a for a in sys.argv[3:] if not a.startswith("--")]
+use_f16      = "--f16" in sys.argv[3:]
+fname_out    = args[0] if args else os.path.join(dir_adapter, "ggml-adapter.bin")
+
+with open(os.path.join(dir_adapter, "adapter_config.json"), "r") as f:
+    config = json.load(f)
+
+rank  = int(config["r"])
+alpha = float(config.get("lora_alpha", rank))
+
+if config.get("use_rslora", False):
+    # rank-stabilized LoRA scales by alpha/sqrt(r), whisper.cpp by alpha/r
+    alpha = alpha*rank**0.5
+
+fname_st = os.path.join(dir_adapter, "adapter_model.safetensors")
+if os.path.exists(fname_st):
+    from safetensors.torch import load_file
+    state_dict = load_file(fname_st)
+else:
+    state_dict = torch.load(os.path.join(dir_adapter, "adapter_model.bin"), map_location="cpu")
+
+# base_model.model.model.decoder.layers.3.self_attn.q_proj.lora_A.weight -> (3, "attn.query", "a")
+tensors = {}
+for name, data in state_dict.items():
+    parts = name.split(".")
+    if "lora_A" not in parts and "lora_B" not in parts:
+        print(f"warning: skipping {name}")
+        continue
+
+    ab = "a" if "lora_A" in parts else "b"
+    module = ".".join(parts[:parts.index("lora_A" if ab == "a" else "lora_B")])
+
+    if ".decoder.layers." not in module:
+        print(f"error: {name} is not a decoder layer, whisper.cpp cannot apply it")
+        sys.exit(1)
+
+    layer  = module.split(".decoder.layers.")[1]
+    il     = int(layer.split(".")[0])
+    target = layer.split(".", 1)[1]
+
+    if target not in hf_to_ggml:
+        print(f"error: {name} is not supported by whisper.cpp (e.g. cross-attention k/v), retrain the adapter")
+        print(f"       with target_modules limited to: {', '.join(hf_to_ggml.keys())}")
+        sys.exit(1)
+
+    if il >= n_text_layer:
+        print(f"error: {name} is for layer {il}, the model has {n_text_layer}")
+        sys.exit(1)
+
+    tensors[(il, hf_to_ggml[target], ab)] = data
+
+n_text_state = None
+for (il, target, ab), data in tensors.items():
+    if target == "attn.query" and ab == "a":
+        n_text_state = data.shape[1]
+if n_text_state is None:
+    # any input of the attention or fc1 is the hidden state
+    n_text_state = next(d.shape[1] for (il, t, ab), d in tensors.items() if ab == "a" and t != "mlp.2")
+
+print(f"rank = {rank}, alpha = {alpha}, n_text_state = {n_text_state}, n_text_layer = {n_text_layer}")
+print(f"writing {len(tensors)} tensors to {fname_out}")
+
+with open(fname_out, "wb") as fout:
+    fout.write(struct.pack("I", 0x67676c61)) # magic: ggla in hex
+    fout.write(struct.pack("i", n_text_state))
+    fout.write(struct.pack("i", n_text_layer))
+    fout.write(struct.pack("i", rank))
+    fout.write(struct.pack("f", alpha))
+
+    for (il, target, ab) in sorted(tensors.keys()):
+        # lora_A [r, n_in] and lora_B [n_out, r] in PyTorch are [n_in, r] and [r, n_out] in ggml
+        data = tensors[(il, target, ab)].to(torch.float16 if use_f16 else torch.float32).numpy()
+
+        name  = f"decoder.blocks.{il}.{target}.weight.lora_{ab}".encode("utf-8")
+        ftype = 1 if use_f16 else 0
+
+        fout.write(struct.pack("iii", 2, len(name), ftype))
+        fout.write(struct.pack("ii", data.shape[1], data.shape[0]))
+        fout.write(name)
+
+        data.tofile(fout)
+
+print("Done. Output file: " + fname_out)
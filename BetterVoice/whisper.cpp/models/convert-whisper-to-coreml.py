@@ -1,4 +1,5 @@
 import argparse
+import numpy as np
 import torch
 import torch.nn.functional as F
 import coremltools as ct
@@ -245,6 +246,74 @@ class WhisperANE(Whisper):
         self.decoder.apply(install_hooks)
         return cache, hooks
 
+class TextDecoderStateful(nn.Module):
+    """
+    Text decoder for whisper.cpp with the self-attention KV cache kept in the Core ML model state (macOS 15 / iOS 18).
+    The cross-attention keys and values are inputs computed by whisper.cpp once per window, the keys scaled by
+    n_state_head^-0.25 as in its kv_cross. The cache positions from offset on are overwritten and the later ones
+    are masked, so the decoding can restart from any position
+    """
+    def __init__(self, decoder: TextDecoder, n_layer: int, n_ctx: int, n_state: int, n_head: int):
+        super().__init__()
+        self.decoder = decoder
+        self.n_head = n_head
+
+        self.register_buffer("k_cache", torch.zeros(n_layer, n_ctx, n_state, dtype=torch.float16))
+        self.register_buffer("v_cache", torch.zeros(n_layer, n_ctx, n_state, dtype=torch.float16))
+
+    def attention(self, q: Tensor, k: Tensor, v: Tensor, mask: Tensor, q_scale: float):
+        n_q, n_state = q.shape
+        d_head = n_state // self.n_head
+
+        q = q.view(n_q, self.n_head, d_head).transpose(0, 1) * q_scale
+        k = k.view(-1, self.n_head, d_head).permute(1, 2, 0)
+        v = v.view(-1, self.n_head, d_head).transpose(0, 1)
+
+        w = torch.softmax(q @ k + mask, dim=-1)
+
+        return (w @ v).transpose(0, 1).reshape(n_q, n_state)
+
+    def forward(self, token_data: Tensor, offset: Tensor, cross_k: Tensor, cross_v: Tensor, cross_mask: Tensor):
+        d = self.decoder
+
+        n_ctx = self.k_cache.shape[1]
+        d_head = self.k_cache.shape[2] // self.n_head
+
+        pos = offset + torch.arange(token_data.shape[1], dtype=torch.int32)
+
+        x = d.token_embedding(token_data[0]) + d.positional_embedding[pos]
+
+        # one-hot rows of the written cache positions, and the causal mask over the cache
+        ctx_pos = torch.arange(n_ctx, dtype=torch.int32)
+        write = (ctx_pos[:, None] == pos[None, :]).float()
+        keep  = 1.0 - write.sum(dim=1, keepdim=True)
+        mask  = torch.where(ctx_pos[None, :] <= pos[:, None], 0.0, -1e4)
+
+        for il, block in enumerate(d.blocks):
+            h = block.attn_ln(x)
+
+            q = block.attn.query(h)
+            k = block.attn.key(h)
+            v = block.attn.value(h)
+
+            self.k_cache[il] = (self.k_cache[il].float()*keep + write @ k).half()
+            self.v_cache[il] = (self.v_cache[il].float()*keep + write @ v).half()
+
+            x = x + block.attn.out(self.attention(q, self.k_cache[il].float(), self.v_cache[il].float(), mask, d_head ** -0.5))
+
+            h = block.cross_attn_ln(x)
+            q = block.cross_attn.query(h)
+
+            x = x + block.cross_attn.out(self.attention(q, cross_k[il].float(), cross_v[il].float(), cross_mask.float(), d_head ** -0.25))
+
+            x = x + block.mlp(block.mlp_ln(x))
+
+        x = d.ln(x)
+
+        logits = x @ d.token_embedding.weight.T
+
+        return logits[None, :, :]
+
 def convert_encoder(hparams, model, quantize=False):
     model.eval()
 
@@ -290,6 +359,44 @@ def convert_decoder(hparams, model, quantize=False):
 
     return model
 
+def convert_decoder_stateful(hparams, decoder, quantize=False):
+    model = TextDecoderStateful(decoder, hparams.n_text_layer, hparams.n_text_ctx, hparams.n_text_state, hparams.n_text_head).eval()
+
+    cache_shape = (hparams.n_text_layer, hparams.n_text_ctx,  hparams.n_text_state)
+    cross_shape = (hparams.n_text_layer, hparams.n_audio_ctx, hparams.n_text_state)
+
+    token_data = torch.zeros((1, 4), dtype=torch.int32)
+    offset     = torch.zeros((1,),   dtype=torch.int32)
+    cross_k    = torch.zeros(cross_shape, dtype=torch.float16)
+    cross_v    = torch.zeros(cross_shape, dtype=torch.float16)
+    cross_mask = torch.zeros((1, hparams.n_audio_ctx), dtype=torch.float16)
+
+    traced_model = torch.jit.trace(model, (token_data, offset, cross_k, cross_v, cross_mask))
+
+    model = ct.convert(
+        traced_model,
+        convert_to="mlprogram",
+        inputs=[
+            ct.TensorType(name="token_data", shape=(1, ct.RangeDim(1, hparams.n_text_ctx, default=1)), dtype=np.int32),
+            ct.TensorType(name="offset",     shape=(1,), dtype=np.int32),
+            ct.TensorType(name="cross_k",    shape=cross_shape, dtype=np.float16),
+            ct.TensorType(name="cross_v",    shape=cross_shape, dtype=np.float16),
+            ct.TensorType(name="cross_mask", shape=(1, hparams.n_audio_ctx), dtype=np.float16),
+        ],
+        outputs=[ct.TensorType(name="logits", dtype=np.float32)],
+        states=[
+            ct.StateType(wrapped_type=ct.TensorType(shape=cache_shape, dtype=np.float16), name="k_cache"),
+            ct.StateType(wrapped_type=ct.TensorType(shape=cache_shape, dtype=np.float16), name="v_cache"),
+        ],
+        minimum_deployment_target=ct.target.macOS15,
+        compute_units=ct.ComputeUnit.ALL,
+    )
+
+    if quantize:
+        model = quantize_weights(model, nbits=16)
+
+    return model
+
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
@@ -297,6 +404,7 @@ if __name__ == "__main__":
     parser.add_argument("--encoder-only", type=bool, help="only convert encoder", default=False)
     parser.add_argument("--quantize",     type=bool, help="quantize weights to F16", default=False)
     parser.add_argument("--optimize-ane", type=bool, help="optimize for ANE execution (currently broken)", default=False)
+    parser.add_argument("--decoder-stateful", type=bool, help="also convert the stateful decoder used by whisper.cpp (macOS 15)", default=False)
     args = parser.parse_args()
 
     if args.model not in ["tiny", "tiny.en", "base", "base.en", "small", "small.en", "small.en-tdrz", "medium", "medium.en", "large-v1", "large-v2", "large-v3", "large-v3-turbo"]:
@@ -325,4 +433,8 @@ if __name__ == "__main__":
         decoder = convert_decoder(hparams, decoder, quantize=args.quantize)
         decoder.save(f"models/coreml-decoder-{args.model}.mlpackage")
 
+    if args.decoder_stateful:
+        decoder = convert_decoder_stateful(hparams, whisper.decoder, quantize=args.quantize)
+        decoder.save(f"models/coreml-decoder-stateful-{args.model}.mlpackage")
+
     print("done converting")
@@ -25,14 +25,16 @@ if [ "$mname" = "-h5" ]; then
   echo "$mpath"
   python3 models/convert-h5-to-coreml.py --model-name "$mname" --model-path "$mpath" --encoder-only True
 else
-  python3 models/convert-whisper-to-coreml.py --model "$mname" --encoder-only True --optimize-ane True
+  python3 models/convert-whisper-to-coreml.py --model "$mname" --encoder-only True --optimize-ane True ${WHISPER_COREML_DECODER:+--decoder-stateful True}
 fi
 
 xcrun coremlc compile models/coreml-encoder-"${mname}".mlpackage models/
 rm -rf models/ggml-"${mname}"-encoder.mlmodelc
 mv -v models/coreml-encoder-"${mname}".mlmodelc models/ggml-"${mname}"-encoder.mlmodelc
 
-# TODO: decoder (sometime in the future maybe)
-#xcrun coremlc compile models/whisper-decoder-${mname}.mlpackage models/
-#rm -rf models/ggml-${mname}-decoder.mlmodelc
-#mv -v models/coreml_decoder_${mname}.mlmodelc models/ggml-${mname}-decoder.mlmodelc
+# stateful decoder for whisper_context_params.coreml_decoder, with WHISPER_COREML_DECODER=1 (macOS 15)
+if [ -n "$WHISPER_COREML_DECODER" ] && [ "$1" != "-h5" ]; then
+  xcrun coremlc compile models/coreml-decoder-stateful-"${mname}".mlpackage models/
+  rm -rf models/ggml-"${mname}"-decoder.mlmodelc
+  mv -v models/coreml-decoder-stateful-"${mname}".mlmodelc models/ggml-"${mname}"-decoder.mlmodelc
+fi
@@ -0,0 +1,42 @@
+// Wrapper of the stateful Core ML Whisper Decoder model (models/convert-whisper-to-coreml.py --decoder-stateful)
+//
+// The self-attention KV cache is the model state, the cross-attention keys and values are inputs that are set
+// once per window. Needs macOS 15 / iOS 18
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+struct whisper_coreml_decoder_context;
+
+// compute_units is one of enum whisper_coreml_units (whisper.h)
+// returns NULL if the model cannot be loaded or the system has no stateful Core ML models
+struct whisper_coreml_decoder_context * whisper_coreml_decoder_init(const char * path_model, int compute_units);
+void whisper_coreml_decoder_free(struct whisper_coreml_decoder_context * ctx);
+
+// cross-attention keys (scaled by n_state_head^-0.25) and values of the encoded window, F16 [n_layer][n_ctx][n_state]
+// the positions past n_ctx up to the audio context of the model are masked
+bool whisper_coreml_decoder_set_cross(
+        struct whisper_coreml_decoder_context * ctx,
+                              const uint16_t * k,
+                              const uint16_t * v,
+                                     int64_t   n_layer,
+                                     int64_t   n_ctx,
+                                     int64_t   n_state);
+
+// decode n_tokens consecutive tokens from position n_past, the cached positions from n_past on are overwritten
+// logits receives n_tokens rows of n_vocab
+bool whisper_coreml_decoder_decode(
+        struct whisper_coreml_decoder_context * ctx,
+                               const int32_t * tokens,
+                                     int32_t   n_tokens,
+                                     int32_t   n_past,
+                                     int32_t   n_vocab,
+                                       float * logits);
+
+#if __cplusplus
+}
+#endif
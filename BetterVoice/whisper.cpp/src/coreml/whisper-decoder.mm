@@ -0,0 +1,185 @@
+#if !__has_feature(objc_arc)
+#error This file must be compiled with automatic reference counting enabled (-fobjc-arc)
+#endif
+
+#import "whisper-decoder.h"
+
+#import <Accelerate/Accelerate.h>
+#import <CoreML/CoreML.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+// values of enum whisper_coreml_units in whisper.h
+enum {
+    COREML_UNITS_ALL,
+    COREML_UNITS_CPU_ONLY,
+    COREML_UNITS_CPU_AND_GPU,
+    COREML_UNITS_CPU_AND_NE,
+};
+
+// -10000.0 in F16, the additive mask of the unused cross-attention positions
+static const uint16_t WHISPER_COREML_FP16_MASKED = 0xF0E2;
+
+struct whisper_coreml_decoder_context {
+    MLModel * model;
+
+    id state; // MLState holding the self-attention KV cache
+
+    int64_t n_layer     = 0;
+    int64_t n_audio_ctx = 0;
+    int64_t n_state     = 0;
+
+    // inputs reused by every prediction
+    MLMultiArray * cross_k    = nil;
+    MLMultiArray * cross_v    = nil;
+    MLMultiArray * cross_mask = nil;
+    MLMultiArray * offset     = nil;
+};
+
+struct whisper_coreml_decoder_context * whisper_coreml_decoder_init(const char * path_model, int compute_units) {
+    if (@available(macOS 15.0, iOS 18.0, *)) {
+        NSURL * url_model = [NSURL fileURLWithPath: [[NSString alloc] initWithUTF8String:path_model]];
+
+        MLModelConfiguration * config = [[MLModelConfiguration alloc] init];
+        switch (compute_units) {
+            case COREML_UNITS_CPU_ONLY:    config.computeUnits = MLComputeUnitsCPUOnly;            break;
+            case COREML_UNITS_CPU_AND_GPU: config.computeUnits = MLComputeUnitsCPUAndGPU;          break;
+            case COREML_UNITS_CPU_AND_NE:  config.computeUnits = MLComputeUnitsCPUAndNeuralEngine; break;
+            default:                       config.computeUnits = MLComputeUnitsAll;                break;
+        }
+
+        MLModel * model = [MLModel modelWithContentsOfURL:url_model configuration:config error:nil];
+        if (model == nil) {
+            return NULL;
+        }
+
+        MLModelDescription * desc = model.modelDescription;
+
+        MLMultiArrayConstraint * c_cross = desc.inputDescriptionsByName[@"cross_k"].multiArrayConstraint;
+        if (c_cross == nil || c_cross.shape.count != 3 || desc.stateDescriptionsByName.count == 0) {
+            return NULL;
+        }
+
+        whisper_coreml_decoder_context * ctx = new whisper_coreml_decoder_context;
+
+        ctx->model = model;
+        ctx->state = [model newState];
+
+        ctx->n_layer     = c_cross.shape[0].longLongValue;
+        ctx->n_audio_ctx = c_cross.shape[1].longLongValue;
+        ctx->n_state     = c_cross.shape[2].longLongValue;
+
+        ctx->cross_k    = [[MLMultiArray alloc] initWithShape:c_cross.shape dataType:MLMultiArrayDataTypeFloat16 error:nil];
+        ctx->cross_v    = [[MLMultiArray alloc] initWithShape:c_cross.shape dataType:MLMultiArrayDataTypeFloat16 error:nil];
+        ctx->cross_mask = [[MLMultiArray alloc] initWithShape:@[@1, @(ctx->n_audio_ctx)] dataType:MLMultiArrayDataTypeFloat16 error:nil];
+        ctx->offset     = [[MLMultiArray alloc] initWithShape:@[@1] dataType:MLMultiArrayDataTypeInt32 error:nil];
+
+        if (ctx->cross_k == nil || ctx->cross_v == nil || ctx->cross_mask == nil || ctx->offset == nil) {
+            delete ctx;
+            return NULL;
+        }
+
+        return ctx;
+    }
+
+    return NULL;
+}
+
+void whisper_coreml_decoder_free(struct whisper_coreml_decoder_context * ctx) {
+    delete ctx;
+}
+
+bool whisper_coreml_decoder_set_cross(
+        struct whisper_coreml_decoder_context * ctx,
+                              const uint16_t * k,
+                              const uint16_t * v,
+                                     int64_t   n_layer,
+                                     int64_t   n_ctx,
+                                     int64_t   n_state) {
+    if (n_layer != ctx->n_layer || n_state != ctx->n_state || n_ctx > ctx->n_audio_ctx) {
+        return false;
+    }
+
+    uint16_t * dst_k = (uint16_t *) ctx->cross_k.dataPointer;
+    uint16_t * dst_v = (uint16_t *) ctx->cross_v.dataPointer;
+
+    memset(dst_k, 0, n_layer*ctx->n_audio_ctx*n_state*sizeof(uint16_t));
+    memset(dst_v, 0, n_layer*ctx->n_audio_ctx*n_state*sizeof(uint16_t));
+
+    for (int64_t il = 0; il < n_layer; ++il) {
+        memcpy(dst_k + il*ctx->n_audio_ctx*n_state, k + il*n_ctx*n_state, n_ctx*n_state*sizeof(uint16_t));
+        memcpy(dst_v + il*ctx->n_audio_ctx*n_state, v + il*n_ctx*n_state, n_ctx*n_state*sizeof(uint16_t));
+    }
+
+    uint16_t * mask = (uint16_t *) ctx->cross_mask.dataPointer;
+    for (int64_t i = 0; i < ctx->n_audio_ctx; ++i) {
+        mask[i] = i < n_ctx ? 0 : WHISPER_COREML_FP16_MASKED;
+    }
+
+    return true;
+}
+
+bool whisper_coreml_decoder_decode(
+        struct whisper_coreml_decoder_context * ctx,
+                               const int32_t * tokens,
+                                     int32_t   n_tokens,
+                                     int32_t   n_past,
+                                     int32_t   n_vocab,
+                                       float * logits) {
+    if (@available(macOS 15.0, iOS 18.0, *)) {
+        @autoreleasepool {
+            MLMultiArray * token_data = [[MLMultiArray alloc] initWithShape:@[@1, @(n_tokens)] dataType:MLMultiArrayDataTypeInt32 error:nil];
+            if (token_data == nil) {
+                return false;
+            }
+
+            memcpy(token_data.dataPointer, tokens, n_tokens*sizeof(int32_t));
+            ((int32_t *) ctx->offset.dataPointer)[0] = n_past;
+
+            MLDictionaryFeatureProvider * input = [[MLDictionaryFeatureProvider alloc] initWithDictionary:@{
+                @"token_data" : token_data,
+                @"offset"     : ctx->offset,
+                @"cross_k"    : ctx->cross_k,
+                @"cross_v"    : ctx->cross_v,
+                @"cross_mask" : ctx->cross_mask,
+            } error:nil];
+
+            id<MLFeatureProvider> output = [ctx->model predictionFromFeatures:input usingState:(MLState *) ctx->state error:nil];
+            if (output == nil) {
+                return false;
+            }
+
+            MLMultiArray * res = [output featureValueForName:@"logits"].multiArrayValue;
+            if (res == nil || res.shape.lastObject.intValue != n_vocab || res.count != (NSInteger) n_tokens*n_vocab) {
+                return false;
+            }
+
+            const int64_t stride = res.strides.count >= 2 ? res.strides[res.strides.count - 2].longLongValue : n_vocab;
+
+            if (res.dataType == MLMultiArrayDataTypeFloat32) {
+                for (int32_t i = 0; i < n_tokens; ++i) {
+                    memcpy(logits + i*n_vocab, (const float *) res.dataPointer + i*stride, n_vocab*sizeof(float));
+                }
+            } else if (res.dataType == MLMultiArrayDataTypeFloat16) {
+                vImage_Buffer src = { res.dataPointer, (vImagePixelCount) n_tokens, (vImagePixelCount) n_vocab, (size_t) stride*sizeof(uint16_t) };
+                vImage_Buffer dst = { logits,          (vImagePixelCount) n_tokens, (vImagePixelCount) n_vocab, (size_t) n_vocab*sizeof(float) };
+                vImageConvert_Planar16FtoPlanarF(&src, &dst, kvImageNoFlags);
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+#if __cplusplus
+}
+#endif
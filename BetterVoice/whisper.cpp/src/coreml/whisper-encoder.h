@@ -3,6 +3,7 @@
 // Code is derived from the work of Github user @wangchou
 // ref: https://github.com/wangchou/callCoreMLFromCpp
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #if __cplusplus
@@ -11,15 +12,33 @@ extern "C" {
 
 struct whisper_coreml_context;
 
-struct whisper_coreml_context * whisper_coreml_init(const char * path_model);
+// compute_units is one of enum whisper_coreml_units (whisper.h)
+struct whisper_coreml_context * whisper_coreml_init(const char * path_model, int compute_units);
 void whisper_coreml_free(struct whisper_coreml_context * ctx);
 
-void whisper_coreml_encode(
-        const whisper_coreml_context * ctx,
-                             int64_t   n_ctx,
-                             int64_t   n_mel,
-                               float * mel,
-                               float * out);
+// the input and output buffers are allocated once and reused while n_ctx does not change
+// on macOS 12.3 / iOS 15.4 and later, Float16 model inputs and outputs are backed by IOSurfaces
+// returns false if the prediction failed
+bool whisper_coreml_encode(
+        struct whisper_coreml_context * ctx,
+                              int64_t   n_ctx,
+                              int64_t   n_mel,
+                          const float * mel,
+                                float * out);
+
+// start encoding mel in the background, waiting for the previous background encode first
+// mel is copied before returning
+bool whisper_coreml_encode_async(
+        struct whisper_coreml_context * ctx,
+                              int64_t   n_ctx,
+                              int64_t   n_mel,
+                          const float * mel);
+
+// wait for the background encode and copy its output to out, unless out is NULL
+// returns false if it failed, or if none was started
+bool whisper_coreml_encode_wait(
+        struct whisper_coreml_context * ctx,
+                                float * out);
 
 #if __cplusplus
 }
@@ -5,67 +5,277 @@
 #import "whisper-encoder.h"
 #import "whisper-encoder-impl.h"
 
+#import <Accelerate/Accelerate.h>
 #import <CoreML/CoreML.h>
+#import <CoreVideo/CoreVideo.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #if __cplusplus
 extern "C" {
 #endif
 
+// values of enum whisper_coreml_units in whisper.h
+enum {
+    COREML_UNITS_ALL,
+    COREML_UNITS_CPU_ONLY,
+    COREML_UNITS_CPU_AND_GPU,
+    COREML_UNITS_CPU_AND_NE,
+};
+
 struct whisper_coreml_context {
-    const void * data;
+    whisper_encoder_impl * model;
+
+    // reused while the shape of the input does not change
+    int64_t n_ctx = 0;
+    int64_t n_mel = 0;
+
+    MLMultiArray * input  = nil;
+    MLMultiArray * output = nil; // output backing, nil if Core ML allocates the output
+
+    MLPredictionOptions * options = nil;
+
+    // output of the last prediction
+    MLMultiArray * result = nil;
+
+    // background encodes, one at a time
+    dispatch_queue_t queue;
+    dispatch_group_t group;
+
+    bool pending = false;
+    bool ok      = false;
 };
 
-struct whisper_coreml_context * whisper_coreml_init(const char * path_model) {
+// an array for a model feature, backed by an IOSurface when the feature is Float16 so that the Neural Engine
+// can read and write it in place
+static MLMultiArray * whisper_coreml_array(NSArray<NSNumber *> * shape, MLMultiArrayDataType type) {
+    if (type != MLMultiArrayDataTypeFloat32 && shape.count >= 2) {
+        if (@available(macOS 12.3, iOS 15.4, *)) {
+            if (type == MLMultiArrayDataTypeFloat16) {
+                size_t height = 1;
+                for (NSUInteger i = 0; i + 1 < shape.count; ++i) {
+                    height *= shape[i].unsignedLongValue;
+                }
+                const size_t width = shape.lastObject.unsignedLongValue;
+
+                NSDictionary * attrs = @{ (NSString *) kCVPixelBufferIOSurfacePropertiesKey: @{} };
+
+                CVPixelBufferRef pb = NULL;
+                if (CVPixelBufferCreate(kCFAllocatorDefault, width, height, kCVPixelFormatType_OneComponent16Half,
+                            (__bridge CFDictionaryRef) attrs, &pb) == kCVReturnSuccess) {
+                    MLMultiArray * array = [[MLMultiArray alloc] initWithPixelBuffer:pb shape:shape];
+                    CVPixelBufferRelease(pb);
+
+                    return array;
+                }
+            }
+        }
+    }
+
+    return [[MLMultiArray alloc] initWithShape:shape dataType:MLMultiArrayDataTypeFloat32 error:nil];
+}
+
+// call fn with the data of an array, seen as rows of its last dimension (stride in elements)
+static void whisper_coreml_rows(MLMultiArray * array, void (^fn)(void * data, int64_t n_rows, int64_t n_cols, int64_t stride)) {
+    const int64_t n_cols = array.shape.lastObject.longLongValue;
+    const int64_t n_rows = array.count / n_cols;
+
+    if (@available(macOS 12.3, iOS 15.4, *)) {
+        // locks the pixel buffer of IOSurface-backed arrays
+        [array getMutableBytesWithHandler:^(void * bytes, NSInteger size, NSArray<NSNumber *> * strides) {
+            (void) size;
+            fn(bytes, n_rows, n_cols, strides.count >= 2 ? strides[strides.count - 2].longLongValue : n_cols);
+        }];
+    } else {
+        NSArray<NSNumber *> * strides = array.strides;
+        fn(array.dataPointer, n_rows, n_cols, strides.count >= 2 ? strides[strides.count - 2].longLongValue : n_cols);
+    }
+}
+
+static void whisper_coreml_copy_in(MLMultiArray * array, const float * src) {
+    const bool is_f32 = array.dataType == MLMultiArrayDataTypeFloat32;
+
+    whisper_coreml_rows(array, ^(void * data, int64_t n_rows, int64_t n_cols, int64_t stride) {
+        if (is_f32) {
+            for (int64_t r = 0; r < n_rows; ++r) {
+                memcpy((float *) data + r*stride, src + r*n_cols, n_cols*sizeof(float));
+            }
+        } else {
+            vImage_Buffer vsrc = { (void *) src, (vImagePixelCount) n_rows, (vImagePixelCount) n_cols, (size_t) n_cols*sizeof(float) };
+            vImage_Buffer vdst = { data,         (vImagePixelCount) n_rows, (vImagePixelCount) n_cols, (size_t) stride*sizeof(uint16_t) };
+            vImageConvert_PlanarFtoPlanar16F(&vsrc, &vdst, kvImageNoFlags);
+        }
+    });
+}
+
+static void whisper_coreml_copy_out(MLMultiArray * array, float * dst) {
+    const bool is_f32 = array.dataType == MLMultiArrayDataTypeFloat32;
+
+    whisper_coreml_rows(array, ^(void * data, int64_t n_rows, int64_t n_cols, int64_t stride) {
+        if (is_f32) {
+            for (int64_t r = 0; r < n_rows; ++r) {
+                memcpy(dst + r*n_cols, (const float *) data + r*stride, n_cols*sizeof(float));
+            }
+        } else {
+            vImage_Buffer vsrc = { data,        (vImagePixelCount) n_rows, (vImagePixelCount) n_cols, (size_t) stride*sizeof(uint16_t) };
+            vImage_Buffer vdst = { (void *) dst, (vImagePixelCount) n_rows, (vImagePixelCount) n_cols, (size_t) n_cols*sizeof(float) };
+            vImageConvert_Planar16FtoPlanarF(&vsrc, &vdst, kvImageNoFlags);
+        }
+    });
+}
+
+// (re)create the input and output buffers for a new input shape
+static void whisper_coreml_prepare(whisper_coreml_context * ctx, int64_t n_ctx, int64_t n_mel) {
+    if (ctx->input != nil && ctx->n_ctx == n_ctx && ctx->n_mel == n_mel) {
+        return;
+    }
+
+    MLModelDescription * desc = ctx->model.model.modelDescription;
+
+    MLMultiArrayConstraint * c_inp = desc.inputDescriptionsByName [@"logmel_data"].multiArrayConstraint;
+    MLMultiArrayConstraint * c_out = desc.outputDescriptionsByName[@"output"].multiArrayConstraint;
+
+    ctx->input   = whisper_coreml_array(@[@1, @(n_mel), @(n_ctx)], c_inp ? c_inp.dataType : MLMultiArrayDataTypeFloat32);
+    ctx->output  = nil;
+    ctx->options = [[MLPredictionOptions alloc] init];
+
+    // the output can only be preallocated for models with a fixed output shape
+    if (@available(macOS 12.3, iOS 15.4, *)) {
+        if (c_out && c_out.shapeConstraint.type == MLMultiArrayShapeConstraintTypeUnspecified && c_out.shape.count > 0) {
+            ctx->output = whisper_coreml_array(c_out.shape, c_out.dataType);
+            ctx->options.outputBackings = @{ @"output": ctx->output };
+        }
+    }
+
+    ctx->n_ctx = n_ctx;
+    ctx->n_mel = n_mel;
+}
+
+static bool whisper_coreml_predict(whisper_coreml_context * ctx) {
+    @autoreleasepool {
+        whisper_encoder_implInput * input = [[whisper_encoder_implInput alloc] initWithLogmel_data:ctx->input];
+
+        whisper_encoder_implOutput * outCoreML = [ctx->model predictionFromFeatures:input options:ctx->options error:nil];
+        if (outCoreML == nil) {
+            ctx->result = nil;
+            return false;
+        }
+
+        ctx->result = ctx->output != nil ? ctx->output : outCoreML.output;
+    }
+
+    return true;
+}
+
+struct whisper_coreml_context * whisper_coreml_init(const char * path_model, int compute_units) {
     NSString * path_model_str = [[NSString alloc] initWithUTF8String:path_model];
 
     NSURL * url_model = [NSURL fileURLWithPath: path_model_str];
 
     // select which device to run the Core ML model on
     MLModelConfiguration *config = [[MLModelConfiguration alloc] init];
-    // config.computeUnits = MLComputeUnitsCPUAndGPU;
-    //config.computeUnits = MLComputeUnitsCPUAndNeuralEngine;
-    config.computeUnits = MLComputeUnitsAll;
+    switch (compute_units) {
+        case COREML_UNITS_CPU_ONLY:
+            config.computeUnits = MLComputeUnitsCPUOnly;
+            break;
+        case COREML_UNITS_CPU_AND_GPU:
+            config.computeUnits = MLComputeUnitsCPUAndGPU;
+            break;
+        case COREML_UNITS_CPU_AND_NE:
+            if (@available(macOS 13.0, iOS 16.0, *)) {
+                config.computeUnits = MLComputeUnitsCPUAndNeuralEngine;
+            } else {
+                config.computeUnits = MLComputeUnitsAll;
+            }
+            break;
+        default:
+            config.computeUnits = MLComputeUnitsAll;
+            break;
+    }
 
-    const void * data = CFBridgingRetain([[whisper_encoder_impl alloc] initWithContentsOfURL:url_model configuration:config error:nil]);
+    whisper_encoder_impl * model = [[whisper_encoder_impl alloc] initWithContentsOfURL:url_model configuration:config error:nil];
 
-    if (data == NULL) {
+    if (model == nil) {
         return NULL;
     }
 
     whisper_coreml_context * ctx = new whisper_coreml_context;
 
-    ctx->data = data;
+    ctx->model = model;
+    ctx->queue = dispatch_queue_create("whisper.coreml.encode", DISPATCH_QUEUE_SERIAL);
+    ctx->group = dispatch_group_create();
 
     return ctx;
 }
 
 void whisper_coreml_free(struct whisper_coreml_context * ctx) {
-    CFRelease(ctx->data);
+    whisper_coreml_encode_wait(ctx, NULL);
+
     delete ctx;
 }
 
-void whisper_coreml_encode(
-        const whisper_coreml_context * ctx,
-                             int64_t   n_ctx,
-                             int64_t   n_mel,
-                               float * mel,
-                               float * out) {
-    MLMultiArray * inMultiArray = [
-        [MLMultiArray alloc] initWithDataPointer: mel
-                                           shape: @[@1, @(n_mel), @(n_ctx)]
-                                        dataType: MLMultiArrayDataTypeFloat32
-                                         strides: @[@(n_ctx*n_mel), @(n_ctx), @1]
-                                     deallocator: nil
-                                           error: nil
-    ];
+bool whisper_coreml_encode(
+        struct whisper_coreml_context * ctx,
+                              int64_t   n_ctx,
+                              int64_t   n_mel,
+                          const float * mel,
+                                float * out) {
+    // the buffers are shared with the background encode
+    whisper_coreml_encode_wait(ctx, NULL);
 
-    @autoreleasepool {
-        whisper_encoder_implOutput * outCoreML = [(__bridge id) ctx->data predictionFromLogmel_data:inMultiArray error:nil];
+    whisper_coreml_prepare(ctx, n_ctx, n_mel);
+    whisper_coreml_copy_in(ctx->input, mel);
 
-        memcpy(out, outCoreML.output.dataPointer, outCoreML.output.count * sizeof(float));
+    if (!whisper_coreml_predict(ctx)) {
+        return false;
     }
+
+    whisper_coreml_copy_out(ctx->result, out);
+
+    return true;
+}
+
+bool whisper_coreml_encode_async(
+        struct whisper_coreml_context * ctx,
+                              int64_t   n_ctx,
+                              int64_t   n_mel,
+                          const float * mel) {
+    whisper_coreml_encode_wait(ctx, NULL);
+
+    whisper_coreml_prepare(ctx, n_ctx, n_mel);
+    whisper_coreml_copy_in(ctx->input, mel);
+
+    ctx->pending = true;
+    ctx->ok      = false;
+
+    dispatch_group_async(ctx->group, ctx->queue, ^{
+        ctx->ok = whisper_coreml_predict(ctx);
+    });
+
+    return true;
+}
+
+bool whisper_coreml_encode_wait(
+        struct whisper_coreml_context * ctx,
+                                float * out) {
+    if (!ctx->pending) {
+        return false;
+    }
+
+    dispatch_group_wait(ctx->group, DISPATCH_TIME_FOREVER);
+
+    ctx->pending = false;
+
+    if (!ctx->ok) {
+        return false;
+    }
+
+    if (out != NULL) {
+        whisper_coreml_copy_out(ctx->result, out);
+    }
+
+    return true;
 }
 
 #if __cplusplus
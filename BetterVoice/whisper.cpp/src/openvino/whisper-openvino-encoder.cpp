@@ -1,12 +1,101 @@
 #include "openvino/whisper-openvino-encoder.h"
-#include "ggml.h"
 #include <openvino/openvino.hpp>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// a compiled encoder, shared by the contexts of the same model, device and cache dir
+struct whisper_openvino_model {
+    ov::CompiledModel compiledModel;
+
+    // idle infer requests, handed out by whisper_openvino_init() and returned by whisper_openvino_free()
+    std::mutex mutex;
+    std::vector<ov::InferRequest> requests;
+};
 
 struct whisper_openvino_context {
+    std::shared_ptr<whisper_openvino_model> model;
+
     ov::InferRequest inferRequest;
+
+    // shape of the encoder output, {1, n_ctx, n_state}
+    ov::Shape output_shape;
+
+    // input and output of the background encode (whisper_openvino_encode_async), owned by the context
+    // so that they outlive the caller's buffers
+    std::vector<float> async_mel;
+    std::vector<float> async_out;
+    bool async_pending = false;
 };
 
+static std::mutex g_openvino_mutex;
+
+// compiled models by "<path_model>|<device>|<cache_dir>", released with their last context
+static std::map<std::string, std::weak_ptr<whisper_openvino_model>> g_openvino_models;
+
+static ov::Core & whisper_openvino_core() {
+    static ov::Core core;
+    return core;
+}
+
+static std::shared_ptr<whisper_openvino_model> whisper_openvino_get_model(const char * path_model,
+    const char * device,
+    const char * cache_dir)
+{
+    const std::string key = std::string(path_model) + "|" + device + "|" + (cache_dir ? cache_dir : "");
+
+    // compilations are serialized, so that the contexts created at the same time share one
+    std::lock_guard<std::mutex> lock(g_openvino_mutex);
+
+    for (auto it = g_openvino_models.begin(); it != g_openvino_models.end(); ) {
+        if (it->second.expired()) {
+            it = g_openvino_models.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto it = g_openvino_models.find(key);
+    if (it != g_openvino_models.end()) {
+        // null if its last context was freed in the meantime
+        if (auto shared = it->second.lock()) {
+            fprintf(stderr, "%s: reusing the compiled model\n", __func__);
+            return shared;
+        }
+    }
+
+    ov::Core & core = whisper_openvino_core();
+
+    ov::AnyMap config;
+    if (cache_dir) {
+        // enables caching of device-specific 'blobs' during core.compile_model
+        // routine. This speeds up calls to compile_model for successive runs.
+        // OpenVINO creates the directory and fills it on the first compilation for a device
+        struct stat st;
+        if (stat(cache_dir, &st) != 0) {
+            fprintf(stderr, "%s: populating the cache dir '%s' (first run on this device)\n", __func__, cache_dir);
+        }
+        config.emplace(ov::cache_dir(cache_dir));
+    }
+
+    //Read the OpenVINO encoder IR (.xml/.bin) from disk, producing an ov::Model object.
+    std::shared_ptr<ov::Model> model = core.read_model(path_model);
+
+    // Produce a compiled-model object, given the device ("CPU", "GPU", "NPU", etc.)
+    auto result = std::make_shared<whisper_openvino_model>();
+    result->compiledModel = core.compile_model(model, device, config);
+
+    g_openvino_models[key] = result;
+
+    return result;
+}
+
 struct whisper_openvino_context * whisper_openvino_init(const char* path_model,
     const char* device,
     const char* cache_dir)
@@ -19,25 +108,23 @@ struct whisper_openvino_context * whisper_openvino_init(const char* path_model,
     fprintf(stderr, "%s: path_model = %s, device = %s, cache_dir = %s\n",
         __func__, path_model, device, cache_dir ? cache_dir : "(not set)");
 
-	whisper_openvino_context *context = new whisper_openvino_context;
+    whisper_openvino_context *context = new whisper_openvino_context;
     try {
-        ov::Core core;
-
-        if (cache_dir) {
-            // enables caching of device-specific 'blobs' during core.compile_model
-            // routine. This speeds up calls to compile_model for successive runs.
-            core.set_property(ov::cache_dir(cache_dir));
-        }
-
-        //Read the OpenVINO encoder IR (.xml/.bin) from disk, producing an ov::Model object.
-        std::shared_ptr<ov::Model> model = core.read_model(path_model);
+        context->model = whisper_openvino_get_model(path_model, device, cache_dir);
 
-        // Produce a compiled-model object, given the device ("CPU", "GPU", etc.)
-        auto compiledModel = core.compile_model(model, device);
+        context->output_shape = context->model->compiledModel.output().get_shape();
 
-        // From the compiled model object, create an infer request. This is the thing that we
+        // From the compiled model object, take an idle infer request or create one. This is the thing that we
         //  we will use later on to trigger inference execution.
-        context->inferRequest = compiledModel.create_infer_request();
+        std::lock_guard<std::mutex> lock(context->model->mutex);
+
+        auto & requests = context->model->requests;
+        if (!requests.empty()) {
+            context->inferRequest = std::move(requests.back());
+            requests.pop_back();
+        } else {
+            context->inferRequest = context->model->compiledModel.create_infer_request();
+        }
     }
     catch (const std::exception& error) {
         std::cout << "in openvino encoder compile routine: exception: " << error.what() << std::endl;
@@ -49,60 +136,134 @@ struct whisper_openvino_context * whisper_openvino_init(const char* path_model,
 }
 
 void whisper_openvino_free(struct whisper_openvino_context * ctx) {
-    if( ctx ) {
-        delete ctx;
+    if (!ctx) {
+        return;
+    }
+
+    if (ctx->model) {
+        bool idle = true;
+
+        if (ctx->async_pending) {
+            try {
+                ctx->inferRequest.wait();
+            }
+            catch (const std::exception& error) {
+                std::cout << "in openvino encoder free routine: exception: " << error.what() << std::endl;
+                idle = false;
+            }
+        }
+
+        if (idle) {
+            std::lock_guard<std::mutex> lock(ctx->model->mutex);
+            ctx->model->requests.push_back(std::move(ctx->inferRequest));
+        }
     }
+
+    delete ctx;
+}
+
+// wraps the caller's mel and out as the input and output tensors of the infer request
+static void whisper_openvino_set_tensors(
+    whisper_openvino_context* ctx,
+    int64_t n_ctx,
+    int64_t n_mel,
+    const float* mel,
+    float* out) {
+    // note, we populate shape & stride dimensions in opposite order from how they are listed in ggml's ne / nb arrays
+    ov::Shape input_shape = { 1, (size_t) n_mel, (size_t) n_ctx };
+    ov::Tensor input_tensor(ov::element::f32, input_shape, const_cast<float *>(mel));
+    ctx->inferRequest.set_input_tensor(input_tensor);
+
+    ov::Tensor out_tensor(ov::element::f32, ctx->output_shape, out);
+    ctx->inferRequest.set_output_tensor(out_tensor);
 }
 
 int whisper_openvino_encode(
     whisper_openvino_context* ctx,
-    ggml_tensor* mel,
-    ggml_tensor* out) {
+    int64_t n_ctx,
+    int64_t n_mel,
+    const float* mel,
+    float* out) {
 
     if (!ctx || !mel || !out) {
         fprintf(stderr, "%s: Error! ctx / mel / out is null\n", __func__);
         return 0;
     }
 
-    if (ggml_n_dims(mel) != 2) {
-        fprintf(stderr, "%s: Error! mel ggml_tensor expected to have n_dims=2, but it has n_dims=%d\n",
-            __func__, ggml_n_dims(mel));
+    try {
+        // the request is shared with the background encode, which is dropped
+        if (ctx->async_pending) {
+            ctx->async_pending = false;
+            ctx->inferRequest.wait();
+        }
+
+        whisper_openvino_set_tensors(ctx, n_ctx, n_mel, mel, out);
+
+        //run inference
+        ctx->inferRequest.infer();
+    }
+    catch (const std::exception& error) {
+        std::cout << "in openvino encode inference execution routine: exception: " << error.what() << std::endl;
         return 0;
     }
 
-    if (ggml_n_dims(out) != 2) {
-        fprintf(stderr, "%s: Error! out ggml_tensor expected to have n_dims=2, but it has n_dims=%d\n",
-            __func__, ggml_n_dims(out));
+    return 1;
+}
+
+int whisper_openvino_encode_async(
+    whisper_openvino_context* ctx,
+    int64_t n_ctx,
+    int64_t n_mel,
+    const float* mel) {
+
+    if (!ctx || !mel) {
+        fprintf(stderr, "%s: Error! ctx / mel is null\n", __func__);
         return 0;
     }
 
     try {
-
-        //wrap the passed-in mel ggml_tensor as an OpenVINO Tensor object, and set as input tensor to infer request
-        {
-            // note, we populate shape & stride dimensions in opposite order from how they are listed in ne / nb arrays
-            ov::Shape input_shape = { 1, (unsigned long long)mel->ne[1], (unsigned long long)mel->ne[0] };
-            ov::Strides input_strides = { mel->nb[2], mel->nb[1], mel->nb[0] };
-            ov::Tensor input_tensor(ov::element::f32, input_shape, mel->data, input_strides);
-            ctx->inferRequest.set_input_tensor(input_tensor);
+        if (ctx->async_pending) {
+            ctx->async_pending = false;
+            ctx->inferRequest.wait();
         }
 
-        //wrap the passed-in out ggml_tensor as an OpenVINO Tensor object, and set as output tensor to infer request
-        {
-            // note, we populate shape & stride dimensions in opposite order from how they are listed in ne / nb arrays
-            ov::Shape output_shape = { 1, (unsigned long long)out->ne[1], (unsigned long long)out->ne[0] };
-            ov::Strides output_strides = { out->nb[2], out->nb[1], out->nb[0] };
-            ov::Tensor out_tensor(ov::element::f32, output_shape, out->data, output_strides);
-            ctx->inferRequest.set_output_tensor(out_tensor);
-        }
+        ctx->async_mel.assign(mel, mel + n_ctx*n_mel);
+        ctx->async_out.resize(ov::shape_size(ctx->output_shape));
 
-        //run inference
-        ctx->inferRequest.infer();
+        whisper_openvino_set_tensors(ctx, n_ctx, n_mel, ctx->async_mel.data(), ctx->async_out.data());
+
+        ctx->inferRequest.start_async();
+        ctx->async_pending = true;
     }
     catch (const std::exception& error) {
-        std::cout << "in openvino encode inference execution routine: exception: " << error.what() << std::endl;
+        std::cout << "in openvino encode async routine: exception: " << error.what() << std::endl;
+        return 0;
+    }
+
+    return 1;
+}
+
+int whisper_openvino_encode_wait(
+    whisper_openvino_context* ctx,
+    float* out) {
+
+    if (!ctx || !ctx->async_pending) {
+        return 0;
+    }
+
+    ctx->async_pending = false;
+
+    try {
+        ctx->inferRequest.wait();
+    }
+    catch (const std::exception& error) {
+        std::cout << "in openvino encode wait routine: exception: " << error.what() << std::endl;
         return 0;
     }
 
+    if (out) {
+        memcpy(out, ctx->async_out.data(), ctx->async_out.size()*sizeof(float));
+    }
+
     return 1;
 }
@@ -1,30 +1,54 @@
 // Wrapper of the OpenVINO Whisper Encoder model
 //
 
+#include <stdint.h>
+
 #if __cplusplus
 extern "C" {
 #endif
 
 struct whisper_openvino_context;
 
-// initialize openvino encoder, given path to model xml, device ("CPU", "GPU", etc.), and
+// initialize openvino encoder, given path to model xml, device ("CPU", "GPU", "NPU", etc.), and
 // path to cache_dir. Returns null upon failure.
+// The model is compiled once per (path_model, device, cache_dir) and shared by the contexts that use it,
+// each context takes its own infer request from a pool of the compiled model. cache_dir is created if
+// it does not exist; the first compilation on a device populates it.
 struct whisper_openvino_context * whisper_openvino_init(const char * path_model,
                                                         const char * device,
                                                         const char * cache_dir);
 
 // clean up a ctx previously returned from whisper_openvino_init()
+// its infer request goes back to the pool, the compiled model is released with its last context
 void whisper_openvino_free(struct whisper_openvino_context * ctx);
 
-struct ggml_tensor;
-
 // Perform encode using OpenVINO.
+// mel:  n_mel x n_ctx F32 frames, row-major by mel bin
+// out:  the F32 output of the encoder
 // Returns 1 on success
 // Returns 0 on failure
 int whisper_openvino_encode(
-    whisper_openvino_context* ctx,
-    ggml_tensor* mel,
-    ggml_tensor* out);
+    struct whisper_openvino_context * ctx,
+                            int64_t   n_ctx,
+                            int64_t   n_mel,
+                        const float * mel,
+                              float * out);
+
+// start encoding mel in the background, waiting for the previous background encode first
+// mel is copied before returning
+// Returns 1 on success
+// Returns 0 on failure
+int whisper_openvino_encode_async(
+    struct whisper_openvino_context * ctx,
+                            int64_t   n_ctx,
+                            int64_t   n_mel,
+                        const float * mel);
+
+// wait for the background encode and copy its output to out, unless out is NULL
+// Returns 0 if it failed, or if none was started
+int whisper_openvino_encode_wait(
+    struct whisper_openvino_context * ctx,
+                              float * out);
 
 #if __cplusplus
 }
@@ -6,6 +6,11 @@ WHISPER_MODEL = tiny
 WHISPER_CLI = $(WHISPER_PREFIX)build/bin/whisper-cli
 WHISPER_FLAGS = --no-prints --language en --output-txt
 
+# `make matrix` runs every combination of these in one process
+WHISPER_WER_BENCH = $(WHISPER_PREFIX)build/bin/whisper-wer-bench
+WHISPER_MATRIX_MODELS = $(WHISPER_PREFIX)models/ggml-$(WHISPER_MODEL).bin
+WHISPER_MATRIX_FLAGS = --flash-attn 0,1 --beam-size 1,5 --audio-ctx 0
+
 # You can create eval.conf to override the WHISPER_* variables
 # defined above.
 -include eval.conf
@@ -48,6 +53,11 @@ $(DONE): $(TRANS_TXTS)
 	$(WHISPER_CLI) $(WHISPER_FLAGS) --model $(WHISPER_PREFIX)models/ggml-$(WHISPER_MODEL).bin --file $^ --output-file $^.tmp
 	mv $^.tmp.txt $^.txt
 
+# The WER of whisper-wer-bench uses a subset of the normalizer of
+# eval.py, compare configurations with it and report eval.py scores.
+matrix:
+	$(WHISPER_WER_BENCH) $(WHISPER_MATRIX_FLAGS) --models $(WHISPER_MATRIX_MODELS) --dataset $(METADATA_CSV) --norm-json normalizers/english.json --output-json matrix.json
+
 archive:
 	tar -czf $(WHISPER_MODEL).tar.gz --exclude="*.mp3" speech-datasets/earnings21/media $(DONE)
 
@@ -55,4 +65,4 @@ clean:
 	@rm -f $(TRANS_TXTS)
 	@rm -f $(DONE)
 
-.PHONY: all archive clean
+.PHONY: all archive matrix clean